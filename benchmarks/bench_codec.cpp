@@ -1,6 +1,12 @@
 #include <benchmark/benchmark.h>
+#include "mcp/base64.hpp"
 #include "mcp/codec.hpp"
 #include "mcp/json_rpc.hpp"
+#include "mcp/json_writer.hpp"
+#include "mcp/schema.hpp"
+#include "mcp/tool_args.hpp"
+#include "mcp/types.hpp"
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -41,6 +47,23 @@ static std::string make_large_response(int n) {
 
 static const std::string kLargeResponse = make_large_response(100);
 
+// tools/call request whose arguments carry ~n KB of nested data
+static std::string make_large_tool_call(int n) {
+    nlohmann::json rows = nlohmann::json::array();
+    for (int i = 0; i < n * 16; ++i) {
+        rows.push_back({{"id", i}, {"label", "row-" + std::to_string(i)}, {"score", i * 0.5}});
+    }
+    nlohmann::json req = {
+        {"jsonrpc", "2.0"},
+        {"id", 7},
+        {"method", "tools/call"},
+        {"params", {{"name", "ingest"}, {"arguments", {{"rows", rows}}}}}
+    };
+    return req.dump();
+}
+
+static const std::string kLargeToolCall = make_large_tool_call(64);
+
 // ---- Parse benchmarks ----
 
 static void BM_ParseSmallMessage(benchmark::State& state) {
@@ -70,6 +93,56 @@ static void BM_ParseLargeMessage(benchmark::State& state) {
 }
 BENCHMARK(BM_ParseLargeMessage)->MinTime(1.0);
 
+// ---- Lazy envelope vs full-DOM parse ----
+
+static void BM_ParseDomSmallMessage(benchmark::State& state) {
+    for (auto _ : state) {
+        auto msg = Codec::parse_dom(kSmallRequest);
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetBytesProcessed(state.iterations() * kSmallRequest.size());
+}
+BENCHMARK(BM_ParseDomSmallMessage)->MinTime(1.0);
+
+static void BM_ParseDomToolCallRequest(benchmark::State& state) {
+    for (auto _ : state) {
+        auto msg = Codec::parse_dom(kToolCallRequest);
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetBytesProcessed(state.iterations() * kToolCallRequest.size());
+}
+BENCHMARK(BM_ParseDomToolCallRequest)->MinTime(1.0);
+
+static void BM_ParseLargeToolCall(benchmark::State& state) {
+    for (auto _ : state) {
+        auto msg = Codec::parse(kLargeToolCall);
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetBytesProcessed(state.iterations() * kLargeToolCall.size());
+}
+BENCHMARK(BM_ParseLargeToolCall)->MinTime(1.0);
+
+static void BM_ParseDomLargeToolCall(benchmark::State& state) {
+    for (auto _ : state) {
+        auto msg = Codec::parse_dom(kLargeToolCall);
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetBytesProcessed(state.iterations() * kLargeToolCall.size());
+}
+BENCHMARK(BM_ParseDomLargeToolCall)->MinTime(1.0);
+
+// Lazy parse followed by a handler reading params: the worst case for
+// the lazy path, since the payload is scanned twice.
+static void BM_ParseLargeToolCallThenAccess(benchmark::State& state) {
+    for (auto _ : state) {
+        auto msg = Codec::parse(kLargeToolCall);
+        const auto& req = std::get<JsonRpcRequest>(msg);
+        benchmark::DoNotOptimize(req.params->at("name"));
+    }
+    state.SetBytesProcessed(state.iterations() * kLargeToolCall.size());
+}
+BENCHMARK(BM_ParseLargeToolCallThenAccess)->MinTime(1.0);
+
 static void BM_ParseBatch(benchmark::State& state) {
     // Build a batch of 50 ping requests
     nlohmann::json batch = nlohmann::json::array();
@@ -124,6 +197,52 @@ static void BM_SerializeLargeMessage(benchmark::State& state) {
 }
 BENCHMARK(BM_SerializeLargeMessage)->MinTime(1.0);
 
+static void BM_SerializeLargeMessageReusedBuffer(benchmark::State& state) {
+    // Materialized payload, written into one buffer like the stdio framer
+    auto msg = Codec::parse(kLargeResponse);
+    std::get<JsonRpcResponse>(msg).result.value();
+    std::string frame;
+
+    for (auto _ : state) {
+        frame.clear();
+        Codec::serialize_to(frame, msg);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kLargeResponse.size());
+}
+BENCHMARK(BM_SerializeLargeMessageReusedBuffer)->MinTime(1.0);
+
+static CallToolResult make_tool_result() {
+    CallToolResult r;
+    for (int i = 0; i < 32; ++i) {
+        r.content.push_back(TextContent{"line " + std::to_string(i) + " of tool output", std::nullopt});
+    }
+    return r;
+}
+
+static void BM_ToolResultViaDom(benchmark::State& state) {
+    auto r = make_tool_result();
+    for (auto _ : state) {
+        nlohmann::json j;
+        to_json(j, r);
+        auto s = j.dump();
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(BM_ToolResultViaDom)->MinTime(1.0);
+
+static void BM_ToolResultStreamed(benchmark::State& state) {
+    auto r = make_tool_result();
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        JsonWriter w(out);
+        write_json(w, r);
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_ToolResultStreamed)->MinTime(1.0);
+
 static void BM_RoundTrip(benchmark::State& state) {
     for (auto _ : state) {
         auto msg = Codec::parse(kToolCallRequest);
@@ -132,3 +251,100 @@ static void BM_RoundTrip(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_RoundTrip)->MinTime(1.0);
+
+// 1 MiB screenshot-sized payload
+static const std::string kImageBytes(1 << 20, '\x5a');
+
+static void BM_Base64Encode(benchmark::State& state) {
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        base64::encode_to(out, kImageBytes);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kImageBytes.size()));
+    state.SetLabel(std::string(base64::implementation()));
+}
+BENCHMARK(BM_Base64Encode)->MinTime(1.0);
+
+static void BM_Base64Decode(benchmark::State& state) {
+    const std::string text = base64::encode(kImageBytes);
+    for (auto _ : state) {
+        auto bytes = base64::decode(text);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kImageBytes.size()));
+    state.SetLabel(std::string(base64::implementation()));
+}
+BENCHMARK(BM_Base64Decode)->MinTime(1.0);
+
+// Image given as raw bytes: encoded straight into the response buffer
+static void BM_ImageResultFromBytes(benchmark::State& state) {
+    CallToolResult r;
+    r.content.push_back(ImageContent::from_bytes(kImageBytes, "image/png"));
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        JsonWriter w(out);
+        write_json(w, r);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kImageBytes.size()));
+}
+BENCHMARK(BM_ImageResultFromBytes)->MinTime(1.0);
+
+// ---------- Tool argument binding ----------
+
+namespace {
+struct WeatherArgs {
+    std::string location;
+    std::optional<std::string> units;
+    std::vector<std::string> fields;
+    int days = 0;
+};
+MCPXX_ARGS(WeatherArgs, location, units, fields, days)
+} // namespace
+
+static const std::string kWeatherArgs =
+    R"({"location":"Warsaw","units":"celsius","fields":["temp","wind","rain"],"days":7})";
+
+static void BM_BindArgsViaDom(benchmark::State& state) {
+    for (auto _ : state) {
+        auto j = nlohmann::json::parse(kWeatherArgs);
+        WeatherArgs a;
+        a.location = j.at("location").get<std::string>();
+        if (j.contains("units")) a.units = j.at("units").get<std::string>();
+        a.fields = j.at("fields").get<std::vector<std::string>>();
+        a.days = j.at("days").get<int>();
+        benchmark::DoNotOptimize(a);
+    }
+}
+BENCHMARK(BM_BindArgsViaDom)->MinTime(1.0);
+
+static void BM_BindArgsTyped(benchmark::State& state) {
+    for (auto _ : state) {
+        auto a = parse_args<WeatherArgs>(kWeatherArgs);
+        benchmark::DoNotOptimize(a);
+    }
+}
+BENCHMARK(BM_BindArgsTyped)->MinTime(1.0);
+
+// Checking tool arguments against the schema parse_args generates
+static void BM_SchemaValidate(benchmark::State& state) {
+    SchemaValidator validator(args_schema<WeatherArgs>());
+    auto args = nlohmann::json::parse(kWeatherArgs);
+    for (auto _ : state) {
+        auto violation = validator.validate(args);
+        benchmark::DoNotOptimize(violation);
+    }
+}
+BENCHMARK(BM_SchemaValidate)->MinTime(1.0);
+
+static void BM_SchemaValidateText(benchmark::State& state) {
+    SchemaValidator validator(args_schema<WeatherArgs>());
+    for (auto _ : state) {
+        auto violation = validator.validate_text(kWeatherArgs);
+        benchmark::DoNotOptimize(violation);
+    }
+}
+BENCHMARK(BM_SchemaValidateText)->MinTime(1.0);
@@ -0,0 +1,95 @@
+// Counting operator new and I/O call wrappers for the benchmarks; see
+// bench_counters.hpp. The wrappers are found ahead of libc's by the
+// dynamic linker and forward to the real call through dlsym(RTLD_NEXT),
+// so they see the library's calls whether mcpxx is linked statically or
+// as a shared object.
+#include "bench_counters.hpp"
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_alloc_bytes{0};
+std::atomic<uint64_t> g_syscalls{0};
+
+void* counted_alloc(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* counted_alloc(std::size_t n, std::align_val_t align) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    auto a = static_cast<std::size_t>(align);
+    // aligned_alloc wants a nonzero multiple of the alignment
+    std::size_t size = n ? (n + a - 1) / a * a : a;
+    if (void* p = std::aligned_alloc(a, size)) return p;
+    throw std::bad_alloc();
+}
+
+template<typename Fn>
+Fn real(const char* name) {
+    return reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+}
+
+} // namespace
+
+namespace mcp::bench {
+
+CounterSnapshot counters_now() {
+    return {g_allocs.load(std::memory_order_relaxed),
+            g_alloc_bytes.load(std::memory_order_relaxed),
+            g_syscalls.load(std::memory_order_relaxed)};
+}
+
+} // namespace mcp::bench
+
+void* operator new(std::size_t n) { return counted_alloc(n); }
+void* operator new[](std::size_t n) { return counted_alloc(n); }
+void* operator new(std::size_t n, std::align_val_t a) { return counted_alloc(n, a); }
+void* operator new[](std::size_t n, std::align_val_t a) { return counted_alloc(n, a); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// One wrapper per call the transports make
+#define MCPXX_COUNT_CALL(ret, name, params, args)                              \
+    extern "C" ret name params {                                               \
+        static auto fn = real<ret(*) params>(#name);                           \
+        g_syscalls.fetch_add(1, std::memory_order_relaxed);                    \
+        return fn args;                                                        \
+    }
+
+MCPXX_COUNT_CALL(ssize_t, read, (int fd, void* buf, size_t n), (fd, buf, n))
+MCPXX_COUNT_CALL(ssize_t, write, (int fd, const void* buf, size_t n), (fd, buf, n))
+MCPXX_COUNT_CALL(ssize_t, readv, (int fd, const struct iovec* iov, int n), (fd, iov, n))
+MCPXX_COUNT_CALL(ssize_t, writev, (int fd, const struct iovec* iov, int n), (fd, iov, n))
+MCPXX_COUNT_CALL(ssize_t, send, (int fd, const void* buf, size_t n, int flags), (fd, buf, n, flags))
+MCPXX_COUNT_CALL(ssize_t, recv, (int fd, void* buf, size_t n, int flags), (fd, buf, n, flags))
+MCPXX_COUNT_CALL(ssize_t, sendmsg, (int fd, const struct msghdr* msg, int flags), (fd, msg, flags))
+MCPXX_COUNT_CALL(ssize_t, recvmsg, (int fd, struct msghdr* msg, int flags), (fd, msg, flags))
+MCPXX_COUNT_CALL(int, poll, (struct pollfd* fds, nfds_t n, int timeout), (fds, n, timeout))
+MCPXX_COUNT_CALL(int, epoll_wait, (int fd, struct epoll_event* events, int n, int timeout),
+                 (fd, events, n, timeout))
+MCPXX_COUNT_CALL(int, epoll_ctl, (int fd, int op, int target, struct epoll_event* event),
+                 (fd, op, target, event))
+MCPXX_COUNT_CALL(int, accept4, (int fd, struct sockaddr* addr, socklen_t* len, int flags),
+                 (fd, addr, len, flags))
+
+#undef MCPXX_COUNT_CALL
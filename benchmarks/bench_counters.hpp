@@ -0,0 +1,63 @@
+#pragma once
+// Allocations and syscalls per benchmark iteration, as user counters.
+// bench_counters.cpp replaces the global operator new and wraps the libc
+// I/O calls the library makes (read, write, send, poll, epoll_wait, ...);
+// it is linked into every bench_* target when MCPXX_BENCH_COUNTERS is ON.
+// The counts are process-wide, so a round trip's server thread is counted
+// along with the client. Futex waits inside std::mutex and friends aren't
+// seen: they don't go through a libc wrapper.
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+namespace mcp::bench {
+
+struct CounterSnapshot {
+    uint64_t allocs = 0;
+    uint64_t alloc_bytes = 0;
+    uint64_t syscalls = 0;
+};
+
+#ifdef MCPXX_BENCH_COUNTERS
+
+CounterSnapshot counters_now();
+
+/// Counts from construction to destruction and reports allocs_per_op,
+/// alloc_bytes_per_op and syscalls_per_op, averaged over every thread's
+/// iterations. Declare it right before the benchmark loop (after any
+/// fixture, so teardown isn't counted). In a threaded benchmark only
+/// thread 0 reports, since the counts already cover all threads.
+class OpCounters {
+public:
+    explicit OpCounters(benchmark::State& state) : state_(state), start_(counters_now()) {}
+
+    ~OpCounters() {
+        if (state_.thread_index() != 0) return;
+        auto end = counters_now();
+        auto per_op = [](uint64_t n) {
+            return benchmark::Counter(static_cast<double>(n), benchmark::Counter::kAvgIterations);
+        };
+        state_.counters["allocs_per_op"] = per_op(end.allocs - start_.allocs);
+        state_.counters["alloc_bytes_per_op"] = per_op(end.alloc_bytes - start_.alloc_bytes);
+        state_.counters["syscalls_per_op"] = per_op(end.syscalls - start_.syscalls);
+    }
+
+    OpCounters(const OpCounters&) = delete;
+    OpCounters& operator=(const OpCounters&) = delete;
+
+private:
+    benchmark::State& state_;
+    CounterSnapshot start_;
+};
+
+#else
+
+inline CounterSnapshot counters_now() { return {}; }
+
+class OpCounters {
+public:
+    explicit OpCounters(benchmark::State&) {}
+};
+
+#endif
+
+} // namespace mcp::bench
@@ -1,5 +1,7 @@
 #include <benchmark/benchmark.h>
 #include "mcp/router.hpp"
+#include "mcp/codec.hpp"
+#include "mcp/metrics.hpp"
 #include "mcp/types.hpp"
 #include <memory>
 #include <string>
@@ -76,6 +78,46 @@ static void BM_DispatchWithCapCheck(benchmark::State& state) {
 }
 BENCHMARK(BM_DispatchWithCapCheck)->MinTime(1.0);
 
+// Requests as they arrive off the wire, with the method interned by the codec
+static void BM_DispatchParsedPing(benchmark::State& state) {
+    auto router = make_router(100);
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"ping"})");
+
+    for (auto _ : state) {
+        auto resp = router->dispatch(msg);
+        benchmark::DoNotOptimize(resp);
+    }
+}
+BENCHMARK(BM_DispatchParsedPing)->MinTime(1.0);
+
+static void BM_DispatchParsedToolsCall(benchmark::State& state) {
+    auto router = make_router(100);
+    router->on_request("tools/call", [](const nlohmann::json&) -> HandlerResult {
+        return nlohmann::json{{"content", nlohmann::json::array()}};
+    });
+    router->require_capability("tools/call", "tools");
+    ServerCapabilities caps;
+    caps.tools = nlohmann::json{{"listChanged", true}};
+    router->set_capabilities(caps, ClientCapabilities{});
+    auto msg = Codec::parse(
+        R"({"jsonrpc":"2.0","id":1,"method":"tools/call","params":{"name":"echo","arguments":{}}})");
+
+    for (auto _ : state) {
+        auto resp = router->dispatch(msg);
+        benchmark::DoNotOptimize(resp);
+    }
+}
+BENCHMARK(BM_DispatchParsedToolsCall)->MinTime(1.0);
+
+static void BM_InternMethod(benchmark::State& state) {
+    const std::vector<std::string> names = {"ping", "tools/call", "resources/read", "custom/method"};
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(intern_method(names[i++ % names.size()]));
+    }
+}
+BENCHMARK(BM_InternMethod);
+
 static void BM_Dispatch100Methods(benchmark::State& state) {
     auto router = make_router(100);
 
@@ -109,3 +151,21 @@ static void BM_DispatchNotification(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_DispatchNotification)->MinTime(1.0);
+
+// Cost of aggregating the per-thread metrics, e.g. for one Prometheus scrape
+static void BM_MetricsSnapshot(benchmark::State& state) {
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult {
+        return nlohmann::json::object();
+    });
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "ping";
+    benchmark::DoNotOptimize(router.dispatch(req));
+
+    for (auto _ : state) {
+        auto snapshot = metrics::snapshot();
+        benchmark::DoNotOptimize(snapshot);
+    }
+}
+BENCHMARK(BM_MetricsSnapshot);
@@ -2,21 +2,24 @@
 #include "mcp/server.hpp"
 #include "mcp/client.hpp"
 #include "mcp/transport/stdio_transport.hpp"
+#include "mcp/transport/shm_transport.hpp"
 #include "mcp/codec.hpp"
+#include "bench_counters.hpp"
+#include <sys/socket.h>
 #include <unistd.h>
 #include <thread>
 #include <chrono>
 
 using namespace mcp;
 
-// Set up a server+client pair over pipes for E2E benchmarking
+// Set up a server+client pair over pipes (or shared memory) for E2E benchmarking
 struct E2EFixture {
     int c2s[2], s2c[2];  // client->server and server->client pipes
     std::unique_ptr<McpServer> server;
     std::unique_ptr<McpClient> client;
     std::thread server_thread;
 
-    E2EFixture() {
+    explicit E2EFixture(bool shm = false) {
         pipe(c2s);
         pipe(s2c);
 
@@ -35,7 +38,16 @@ struct E2EFixture {
             return r;
         });
 
-        auto server_transport = std::make_unique<StdioTransport>(c2s[0], s2c[1]);
+        std::unique_ptr<ITransport> server_transport, client_transport;
+        if (shm) {
+            int sv[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+            client_transport = std::make_unique<ShmTransport>(sv[0], ShmTransport::Role::Create);
+            server_transport = std::make_unique<ShmTransport>(sv[1], ShmTransport::Role::Attach);
+        } else {
+            server_transport = std::make_unique<StdioTransport>(c2s[0], s2c[1]);
+            client_transport = std::make_unique<StdioTransport>(s2c[0], c2s[1]);
+        }
         server_thread = std::thread([this, t = std::move(server_transport)]() mutable {
             server->serve(std::move(t));
         });
@@ -44,8 +56,6 @@ struct E2EFixture {
         copts.client_info = {"bench-client", std::nullopt, "1.0"};
         copts.request_timeout = std::chrono::milliseconds(5000);
         client = std::make_unique<McpClient>(copts);
-
-        auto client_transport = std::make_unique<StdioTransport>(s2c[0], c2s[1]);
         client->connect(std::move(client_transport));
 
         // Initialize
@@ -64,6 +74,7 @@ struct E2EFixture {
 static void BM_ToolCallStdio(benchmark::State& state) {
     E2EFixture fixture;
 
+    bench::OpCounters counters(state);
     for (auto _ : state) {
         auto result = fixture.client->call_tool("echo", {{"text", "hello benchmark"}});
         benchmark::DoNotOptimize(result);
@@ -73,6 +84,19 @@ static void BM_ToolCallStdio(benchmark::State& state) {
 }
 BENCHMARK(BM_ToolCallStdio)->MinTime(2.0)->UseRealTime();
 
+static void BM_ToolCallShm(benchmark::State& state) {
+    E2EFixture fixture(true);
+
+    bench::OpCounters counters(state);
+    for (auto _ : state) {
+        auto result = fixture.client->call_tool("echo", {{"text", "hello benchmark"}});
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetLabel("shared-memory tool/call roundtrip");
+}
+BENCHMARK(BM_ToolCallShm)->MinTime(2.0)->UseRealTime();
+
 static void BM_ListToolsStdio(benchmark::State& state) {
     E2EFixture fixture;
     // Add 100 tools
@@ -83,6 +107,7 @@ static void BM_ListToolsStdio(benchmark::State& state) {
         fixture.server->add_tool(def, [](const nlohmann::json&) -> CallToolResult { return {}; });
     }
 
+    bench::OpCounters counters(state);
     for (auto _ : state) {
         auto result = fixture.client->list_tools();
         benchmark::DoNotOptimize(result);
@@ -94,9 +119,21 @@ BENCHMARK(BM_ListToolsStdio)->MinTime(2.0)->UseRealTime();
 static void BM_PingStdio(benchmark::State& state) {
     E2EFixture fixture;
 
+    bench::OpCounters counters(state);
     for (auto _ : state) {
         fixture.client->ping();
     }
     state.SetLabel("ping roundtrip");
 }
 BENCHMARK(BM_PingStdio)->MinTime(2.0)->UseRealTime();
+
+static void BM_PingShm(benchmark::State& state) {
+    E2EFixture fixture(true);
+
+    bench::OpCounters counters(state);
+    for (auto _ : state) {
+        fixture.client->ping();
+    }
+    state.SetLabel("shared-memory ping roundtrip");
+}
+BENCHMARK(BM_PingShm)->MinTime(2.0)->UseRealTime();
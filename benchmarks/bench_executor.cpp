@@ -0,0 +1,149 @@
+#include <benchmark/benchmark.h>
+#include "mcp/executor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+// The single mutex + condvar queue McpServer used before the work-stealing
+// executor, kept here as the contention baseline.
+class SingleQueueExecutor : public IExecutor {
+public:
+    explicit SingleQueueExecutor(size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            threads_.emplace_back([this] {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cv_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+                        if (stopping_ && queue_.empty()) return;
+                        task = std::move(queue_.front());
+                        queue_.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+    ~SingleQueueExecutor() override { shutdown(); }
+
+    void post(Task task) override {
+        auto shared = std::make_shared<Task>(std::move(task));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push([shared] { (*shared)(); });
+        }
+        cv_.notify_one();
+    }
+
+    void shutdown() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    size_t concurrency() const override { return threads_.size(); }
+
+private:
+    std::vector<std::thread> threads_;
+    std::queue<std::function<void()>> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+};
+
+static size_t worker_count() {
+    return std::max(2u, std::thread::hardware_concurrency());
+}
+
+static IExecutor& single_queue() {
+    static SingleQueueExecutor exec(worker_count());
+    return exec;
+}
+
+static IExecutor& work_stealing() {
+    static WorkStealingExecutor exec(WorkStealingExecutor::Options{worker_count(), false});
+    return exec;
+}
+
+// Simulates request dispatch: every benchmark thread is a producer (like
+// concurrent connections) posting short handlers and waiting for them.
+static void run_contention(benchmark::State& state, IExecutor& exec) {
+    constexpr int kBatch = 256;
+    for (auto _ : state) {
+        std::atomic<int> done{0};
+        for (int i = 0; i < kBatch; ++i) {
+            exec.post([&done] {
+                benchmark::DoNotOptimize(done.load(std::memory_order_relaxed));
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (done.load(std::memory_order_acquire) < kBatch) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+}
+
+static void BM_SingleQueueContention(benchmark::State& state) {
+    run_contention(state, single_queue());
+}
+BENCHMARK(BM_SingleQueueContention)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_WorkStealingContention(benchmark::State& state) {
+    run_contention(state, work_stealing());
+}
+BENCHMARK(BM_WorkStealingContention)->ThreadRange(1, 16)->UseRealTime();
+
+// Fan-out from inside a task: stays on the local deque and gets stolen.
+static void BM_WorkStealingNestedFanOut(benchmark::State& state) {
+    auto& exec = work_stealing();
+    constexpr int kChildren = 64;
+    for (auto _ : state) {
+        std::atomic<int> done{0};
+        exec.post([&exec, &done] {
+            for (int i = 0; i < kChildren; ++i) {
+                exec.post([&done] { done.fetch_add(1, std::memory_order_release); });
+            }
+        });
+        while (done.load(std::memory_order_acquire) < kChildren) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kChildren);
+}
+BENCHMARK(BM_WorkStealingNestedFanOut)->UseRealTime();
+
+static void BM_TaskConstructInline(benchmark::State& state) {
+    int x = 0;
+    for (auto _ : state) {
+        Task t([&x] { ++x; });
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_TaskConstructInline);
+
+static void BM_StdFunctionConstruct(benchmark::State& state) {
+    int x = 0;
+    void* p1 = &x;
+    void* p2 = &x;
+    void* p3 = &x;
+    for (auto _ : state) {
+        // Three extra pointers push the capture past libstdc++'s 16-byte SBO
+        std::function<void()> f([&x, p1, p2, p3] { ++x; benchmark::DoNotOptimize(p1); benchmark::DoNotOptimize(p2); benchmark::DoNotOptimize(p3); });
+        benchmark::DoNotOptimize(f);
+    }
+}
+BENCHMARK(BM_StdFunctionConstruct);
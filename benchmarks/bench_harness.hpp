@@ -0,0 +1,217 @@
+#pragma once
+// Load-generation pieces shared by the concurrency, HTTP, payload and
+// open-loop benchmarks. Latencies (and, with MCPXX_BENCH_COUNTERS, the
+// allocations and syscalls per op) are reported as benchmark counters, so
+// --benchmark_format=json (or --benchmark_out=FILE) carries them along
+// with the timings.
+#include <benchmark/benchmark.h>
+#include "bench_counters.hpp"
+#include "mcp/server.hpp"
+#include "mcp/client.hpp"
+#include "mcp/metrics.hpp"
+#include "mcp/transport/http_transport.hpp"
+#include "mcp/transport/stdio_transport.hpp"
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace mcp::bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline uint64_t ns_since(Clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+// LatencyHistogram behind a mutex, for completions on several threads
+class LatencyRecorder {
+public:
+    void record(uint64_t ns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hist_.record(ns);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hist_.merge(other);
+    }
+
+    // p50_us, p99_us, p999_us and mean_us. Percentiles are bucket upper
+    // bounds, within 12.5%.
+    void report(benchmark::State& state) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (hist_.count() == 0) return;
+        auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+        state.counters["p50_us"] = us(hist_.percentile(0.50));
+        state.counters["p99_us"] = us(hist_.percentile(0.99));
+        state.counters["p999_us"] = us(hist_.percentile(0.999));
+        state.counters["mean_us"] = us(hist_.sum_ns() / hist_.count());
+    }
+
+private:
+    mutable std::mutex mutex_;
+    LatencyHistogram hist_;
+};
+
+inline McpServer::Options server_options(int workers) {
+    McpServer::Options opts;
+    opts.server_info = {"bench-server", std::nullopt, "1.0"};
+    opts.thread_pool_size = workers;
+    return opts;
+}
+
+inline McpClient::Options client_options() {
+    McpClient::Options opts;
+    opts.client_info = {"bench-client", std::nullopt, "1.0"};
+    opts.request_timeout = std::chrono::milliseconds(60000);
+    return opts;
+}
+
+// "echo" returns its "text" argument; "feed" is a resource to subscribe to
+inline void add_bench_handlers(McpServer& server) {
+    ToolDefinition echo;
+    echo.name = "echo";
+    echo.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool(echo, [](const nlohmann::json& args) -> CallToolResult {
+        CallToolResult r;
+        r.content.push_back(TextContent{args.value("text", ""), std::nullopt});
+        return r;
+    });
+
+    ResourceDefinition feed;
+    feed.uri = "bench://feed";
+    feed.name = "feed";
+    server.add_resource(feed, [](const std::string& uri) -> std::vector<ResourceContent> {
+        return {ResourceContent{uri, std::nullopt, std::string("tick"), std::nullopt}};
+    });
+}
+
+// A server with `workers` request threads and one client, over pipes
+struct StdioPair {
+    int c2s[2], s2c[2];
+    McpServer server;
+    McpClient client{client_options()};
+    std::thread thread;
+
+    explicit StdioPair(int workers) : server(server_options(workers)) {
+        if (pipe(c2s) != 0 || pipe(s2c) != 0) throw std::runtime_error("pipe failed");
+        add_bench_handlers(server);
+        thread = std::thread([this, t = std::make_unique<StdioTransport>(c2s[0], s2c[1])]() mutable {
+            server.serve(std::move(t));
+        });
+        client.connect(std::make_unique<StdioTransport>(s2c[0], c2s[1]));
+        (void)client.initialize();
+    }
+
+    ~StdioPair() {
+        client.disconnect();
+        server.shutdown();
+        if (thread.joinable()) thread.join();
+        close(c2s[0]); close(c2s[1]);
+        close(s2c[0]); close(s2c[1]);
+    }
+};
+
+// A server on the native HTTP backend, on a port the system picks;
+// connect() opens one more session
+struct HttpServerFixture {
+    McpServer server;
+    HttpServerTransport* http = nullptr;
+    std::thread thread;
+    std::string url;
+
+    explicit HttpServerFixture(int workers) : server(server_options(workers)) {
+        add_bench_handlers(server);
+        HttpServerTransport::Options hopts;
+        hopts.port = 0;
+        hopts.backend = HttpBackend::Native;  // idle SSE streams cost no thread
+        hopts.max_connections = 256;
+        hopts.max_body_bytes = size_t{512} << 20;  // the 100 MB payloads, escaped
+        hopts.compression = {};  // measure the transport, not zstd
+        auto t = std::make_unique<HttpServerTransport>(hopts);
+        http = t.get();
+        thread = std::thread([this, t = std::move(t)]() mutable { server.serve(std::move(t)); });
+        while (http->port() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        url = "http://127.0.0.1:" + std::to_string(http->port()) + "/mcp";
+    }
+
+    std::unique_ptr<McpClient> connect() const {
+        auto client = std::make_unique<McpClient>(client_options());
+        client->connect_http(url);
+        (void)client->initialize();
+        return client;
+    }
+
+    ~HttpServerFixture() {
+        server.shutdown();
+        if (thread.joinable()) thread.join();
+    }
+};
+
+namespace detail {
+
+// Counts completions so open_loop() can wait for the stragglers
+struct Completions {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t done = 0;
+    uint64_t errors = 0;
+
+    void finish(bool ok) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++done;
+        if (!ok) ++errors;
+        cv.notify_all();
+    }
+};
+
+template<typename T>
+CoTask<void> record_when_done(Async<T> call, Clock::time_point scheduled, LatencyRecorder& latency,
+                              Completions& completions) {
+    bool ok = true;
+    try {
+        (void)co_await call;
+    } catch (...) {
+        ok = false;
+    }
+    latency.record(ns_since(scheduled));
+    completions.finish(ok);
+}
+
+} // namespace detail
+
+/// Open-loop load: starts `issue()` (returning an Async) `rate` times per
+/// second for `duration`, on schedule whatever the responses do, and
+/// records each latency from the moment the request was due. A server
+/// that falls behind therefore shows up in the percentiles as queueing
+/// delay, where a closed loop would just send less (coordinated omission).
+/// Every request finishes, if only by timing out, before this returns.
+/// Returns the requests issued; `errors` gets the failed ones.
+template<typename Issue>
+uint64_t open_loop(double rate, std::chrono::milliseconds duration, LatencyRecorder& latency,
+                   uint64_t& errors, Issue issue) {
+    detail::Completions completions;
+    const auto interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate));
+    const auto start = Clock::now();
+    const auto end = start + duration;
+    uint64_t sent = 0;
+    for (auto due = start; due < end; due += interval, ++sent) {
+        std::this_thread::sleep_until(due);
+        spawn(detail::record_when_done(issue(), due, latency, completions),
+              [] {}, [](std::exception_ptr) {});
+    }
+    std::unique_lock<std::mutex> lock(completions.mutex);
+    completions.cv.wait(lock, [&] { return completions.done == sent; });
+    errors += completions.errors;
+    return sent;
+}
+
+} // namespace mcp::bench
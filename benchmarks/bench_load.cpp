@@ -0,0 +1,157 @@
+#include "bench_harness.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+using namespace mcp::bench;
+
+// Shared by the threads of one BM_ToolCallThreads run, set up by thread 0
+static std::unique_ptr<StdioPair> g_pair;
+static std::unique_ptr<LatencyRecorder> g_latency;
+
+// tools/call from several threads over one connection to a 4-worker server
+static void BM_ToolCallThreads(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_pair = std::make_unique<StdioPair>(4);
+        g_latency = std::make_unique<LatencyRecorder>();
+    }
+    {
+        OpCounters counters(state);
+        for (auto _ : state) {
+            auto start = Clock::now();
+            auto result = g_pair->client.call_tool("echo", {{"text", "hello benchmark"}});
+            g_latency->record(ns_since(start));
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    // The loop starts and ends on a barrier, so the others are done with both
+    if (state.thread_index() == 0) {
+        g_latency->report(state);
+        g_pair.reset();
+    }
+}
+BENCHMARK(BM_ToolCallThreads)->ThreadRange(1, 16)->UseRealTime();
+
+// tools/call from many HTTP sessions at once, one thread each
+static void BM_HttpSessions(benchmark::State& state) {
+    constexpr int kCallsPerSession = 20;
+    const auto sessions = static_cast<size_t>(state.range(0));
+    HttpServerFixture fixture(4);
+    std::vector<std::unique_ptr<McpClient>> clients;
+    for (size_t i = 0; i < sessions; ++i) clients.push_back(fixture.connect());
+
+    LatencyRecorder latency;
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (auto& client : clients) {
+            threads.emplace_back([&latency, c = client.get()] {
+                LatencyHistogram hist;
+                for (int i = 0; i < kCallsPerSession; ++i) {
+                    auto start = Clock::now();
+                    (void)c->call_tool("echo", {{"text", "hello benchmark"}});
+                    hist.record(ns_since(start));
+                }
+                latency.merge(hist);
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+    for (auto& client : clients) client->disconnect();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(sessions) * kCallsPerSession);
+    latency.report(state);
+}
+BENCHMARK(BM_HttpSessions)->Arg(1)->Arg(8)->Arg(64)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// resources/updated fan-out to SSE subscribers: a burst of updates, timed
+// until every subscriber has every one
+static void BM_HttpResourceUpdateFanout(benchmark::State& state) {
+    constexpr int kBurst = 100;
+    const auto subscribers = static_cast<size_t>(state.range(0));
+    HttpServerFixture fixture(4);
+    std::atomic<int64_t> received{0};
+    std::vector<std::unique_ptr<McpClient>> clients;
+    for (size_t i = 0; i < subscribers; ++i) {
+        auto client = fixture.connect();
+        client->on_resource_updated([&received](const std::string&) { ++received; });
+        client->subscribe_resource("bench://feed");
+        clients.push_back(std::move(client));
+    }
+    // Wait for every GET stream to be open
+    while (received.load() < static_cast<int64_t>(subscribers)) {
+        fixture.server.notify_resource_updated("bench://feed");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int64_t dropped = 0;
+    for (auto _ : state) {
+        received = 0;
+        for (int i = 0; i < kBurst; ++i) fixture.server.notify_resource_updated("bench://feed");
+        const auto want = static_cast<int64_t>(subscribers) * kBurst;
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (received.load() < want && Clock::now() < deadline) std::this_thread::yield();
+        dropped += want - received.load();
+    }
+    for (auto& client : clients) client->disconnect();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(subscribers) * kBurst);
+    state.counters["lost"] = static_cast<double>(dropped);
+}
+BENCHMARK(BM_HttpResourceUpdateFanout)->Arg(1)->Arg(16)->Arg(64)->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Log notification storm to every session: delivery latency of each
+// message, from server log() to the client's callback
+static void BM_HttpLogStorm(benchmark::State& state) {
+    constexpr int kBurst = 1000;
+    const auto sessions = static_cast<size_t>(state.range(0));
+    HttpServerFixture fixture(4);
+    LatencyRecorder latency;
+    std::atomic<int64_t> received{0};
+    const auto epoch = Clock::now();
+    std::vector<std::unique_ptr<McpClient>> clients;
+    auto warm = std::make_unique<std::atomic<bool>[]>(sessions);
+    for (size_t i = 0; i < sessions; ++i) {
+        auto client = fixture.connect();
+        client->on_log_message([&, i](const LogMessage& msg) {
+            if (msg.data.is_string()) {
+                warm[i] = true;
+                return;
+            }
+            auto sent = epoch + std::chrono::nanoseconds(msg.data.get<int64_t>());
+            latency.record(ns_since(sent));
+            ++received;
+        });
+        clients.push_back(std::move(client));
+    }
+    // Wait for every GET stream to be open
+    auto all_warm = [&] {
+        for (size_t i = 0; i < sessions; ++i) {
+            if (!warm[i]) return false;
+        }
+        return true;
+    };
+    while (!all_warm()) {
+        fixture.server.log(LogLevel::Warning, "bench", "warm-up");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int64_t lost = 0;
+    for (auto _ : state) {
+        received = 0;
+        for (int i = 0; i < kBurst; ++i) {
+            auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+            fixture.server.log(LogLevel::Warning, "bench", nlohmann::json(static_cast<int64_t>(now)));
+        }
+        const auto want = static_cast<int64_t>(sessions) * kBurst;
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (received.load() < want && Clock::now() < deadline) std::this_thread::yield();
+        lost += want - received.load();
+    }
+    for (auto& client : clients) client->disconnect();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(sessions) * kBurst);
+    state.counters["lost"] = static_cast<double>(lost);
+    latency.report(state);
+}
+BENCHMARK(BM_HttpLogStorm)->Arg(1)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,42 @@
+#include "bench_harness.hpp"
+#include <chrono>
+#include <memory>
+
+using namespace mcp;
+using namespace mcp::bench;
+
+// tools/call at a fixed arrival rate of range(0) per second against a
+// 4-worker server. Latency is measured from each request's due time, so
+// a server that can't keep up shows it in p99/p999.
+constexpr auto kWindow = std::chrono::milliseconds(1000);
+
+static void run_open_loop(benchmark::State& state, McpClient& client) {
+    const double rate = static_cast<double>(state.range(0));
+    const nlohmann::json args{{"text", "hello benchmark"}};
+    LatencyRecorder latency;
+    uint64_t sent = 0, errors = 0;
+    for (auto _ : state) {
+        sent += open_loop(rate, kWindow, latency, errors,
+                          [&] { return client.call_tool_async("echo", args); });
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(sent));
+    state.counters["errors"] = static_cast<double>(errors);
+    state.counters["target_rps"] = rate;
+    latency.report(state);
+}
+
+static void BM_OpenLoopStdio(benchmark::State& state) {
+    StdioPair pair(4);
+    run_open_loop(state, pair.client);
+}
+BENCHMARK(BM_OpenLoopStdio)->Arg(1000)->Arg(10000)->Arg(50000)
+    ->Iterations(3)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_OpenLoopHttp(benchmark::State& state) {
+    HttpServerFixture fixture(4);
+    auto client = fixture.connect();
+    run_open_loop(state, *client);
+    client->disconnect();
+}
+BENCHMARK(BM_OpenLoopHttp)->Arg(1000)->Arg(5000)->Arg(20000)
+    ->Iterations(3)->UseRealTime()->Unit(benchmark::kMillisecond);
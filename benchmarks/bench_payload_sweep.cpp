@@ -0,0 +1,40 @@
+#include "bench_harness.hpp"
+#include <memory>
+#include <string>
+
+using namespace mcp;
+using namespace mcp::bench;
+
+// tools/call echoing a payload of range(0) bytes; the bytes counter is
+// the payload each way
+template<typename Call>
+static void echo_sweep(benchmark::State& state, Call call) {
+    const std::string payload(static_cast<size_t>(state.range(0)), 'x');
+    const nlohmann::json args{{"text", payload}};
+    LatencyRecorder latency;
+    OpCounters counters(state);
+    for (auto _ : state) {
+        auto start = Clock::now();
+        auto result = call(args);
+        latency.record(ns_since(start));
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 2);
+    latency.report(state);
+}
+
+static void BM_EchoPayloadStdio(benchmark::State& state) {
+    StdioPair pair(1);
+    echo_sweep(state, [&](const nlohmann::json& args) { return pair.client.call_tool("echo", args); });
+}
+BENCHMARK(BM_EchoPayloadStdio)->RangeMultiplier(10)->Range(100, 100'000'000)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+static void BM_EchoPayloadHttp(benchmark::State& state) {
+    HttpServerFixture fixture(1);
+    auto client = fixture.connect();
+    echo_sweep(state, [&](const nlohmann::json& args) { return client->call_tool("echo", args); });
+    client->disconnect();
+}
+BENCHMARK(BM_EchoPayloadHttp)->RangeMultiplier(10)->Range(100, 100'000'000)
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
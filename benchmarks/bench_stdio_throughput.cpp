@@ -6,6 +6,7 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <memory>
 #include <string>
 
 using namespace mcp;
@@ -84,6 +85,100 @@ static void BM_StdioThroughput(benchmark::State& state) {
 // run in bench_e2e_tool_call.cpp
 BENCHMARK(BM_StdioThroughput)->Arg(100)->MinTime(2.0);
 
+// Notification burst through one transport: measures the writer alone.
+// Arg 0 = messages per iteration, arg 1 = flush latency in microseconds.
+static void BM_StdioNotificationBurst(benchmark::State& state) {
+    const int N = static_cast<int>(state.range(0));
+
+    int input[2], output[2];
+    pipe(input);
+    pipe(output);
+
+    StdioTransport::Options opts;
+    opts.flush_latency = std::chrono::microseconds(state.range(1));
+    auto transport = std::make_unique<StdioTransport>(input[0], output[1], opts);
+    std::thread io([&]() { transport->start([](JsonRpcMessage) {}); });
+    while (!transport->is_connected()) std::this_thread::yield();
+
+    // Drain the pipe so the writer never blocks on a full buffer
+    std::thread sink([&]() {
+        char buf[65536];
+        while (::read(output[0], buf, sizeof(buf)) > 0) {}
+    });
+
+    JsonRpcNotification note;
+    note.method = "notifications/progress";
+    note.params = nlohmann::json{{"progressToken", "t"}, {"progress", 1}, {"total", 100}};
+
+    uint64_t sent = 0;
+    auto before = transport->stats();
+    for (auto _ : state) {
+        for (int i = 0; i < N; ++i) transport->send(note);
+        sent += static_cast<uint64_t>(N);
+        while (transport->stats().messages_written - before.messages_written < sent) {
+            std::this_thread::yield();
+        }
+    }
+    auto after = transport->stats();
+
+    state.SetItemsProcessed(static_cast<int64_t>(sent));
+    state.counters["msgs_per_sec"] = benchmark::Counter(
+        static_cast<double>(sent), benchmark::Counter::kIsRate);
+    state.counters["syscalls_per_msg"] = sent == 0 ? 0.0 :
+        static_cast<double>(after.write_calls - before.write_calls) / static_cast<double>(sent);
+
+    transport->shutdown();
+    io.join();
+    transport.reset();  // closes input[0] and output[1]; the sink sees EOF
+    sink.join();
+    ::close(input[1]);
+    ::close(output[0]);
+}
+BENCHMARK(BM_StdioNotificationBurst)
+    ->Args({1000, 0})
+    ->Args({1000, 50})
+    ->MinTime(1.0)
+    ->UseRealTime();
+
+// One multi-MB line per iteration through the reader: framing must stay linear
+// in the message size however many reads it spans. Arg 0 = payload bytes.
+static void BM_StdioReadLargeMessage(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    std::string frame = R"({"jsonrpc":"2.0","method":"notifications/blob","params":{"data":")"
+                        + std::string(size, 'x') + "\"}}\n";
+
+    int input[2], output[2];
+    pipe(input);
+    pipe(output);
+
+    std::atomic<int> received{0};
+    auto transport = std::make_unique<StdioTransport>(input[0], output[1]);
+    std::thread io([&]() { transport->start([&](JsonRpcMessage) { ++received; }); });
+    while (!transport->is_connected()) std::this_thread::yield();
+
+    int expected = 0;
+    for (auto _ : state) {
+        ++expected;
+        const char* p = frame.data();
+        size_t left = frame.size();
+        while (left > 0) {
+            ssize_t n = ::write(input[1], p, left);
+            if (n <= 0) break;
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        while (received.load() < expected) std::this_thread::yield();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame.size()));
+
+    transport->shutdown();
+    io.join();
+    transport.reset();
+    ::close(input[1]);
+    ::close(output[0]);
+}
+BENCHMARK(BM_StdioReadLargeMessage)->Arg(64 << 10)->Arg(4 << 20)->UseRealTime();
+
 static void BM_ParseAndSerialize1K(benchmark::State& state) {
     // Measure pure parse+serialize throughput (no transport)
     std::vector<std::string> messages;
@@ -129,7 +129,7 @@ int main(int argc, char* argv[]) {
 
     // Resource template for file:///{path}
     mcp::ResourceTemplate file_tmpl;
-    file_tmpl.uri_template = "file:///{path}";
+    file_tmpl.uri_template = "file:///{+path}";
     file_tmpl.name = "File";
     file_tmpl.description = "A file from the filesystem";
     server.add_resource_template(file_tmpl, [root](const std::string& uri) -> std::vector<mcp::ResourceContent> {
@@ -65,7 +65,7 @@ def main():
             return {"content": [{"type": "text", "text": str(e)}], "isError": True}
 
     @server.resource(
-        uri_template="file:///{path}",
+        uri_template="file:///{+path}",
         name="File",
         description="A file from the filesystem"
     )
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace mcp {
+
+/// Per-thread monotonic memory for request-scoped temporaries, such as the
+/// padded copy the codec parses from.
+///
+/// Allocation bumps a pointer through blocks that the thread keeps between
+/// requests, and deallocation is a no-op; memory is handed back all at once
+/// when the enclosing Scope ends. Scopes nest. In steady state, parsing and
+/// dispatching a request costs no global heap traffic for these buffers.
+/// Never let memory from the arena outlive the Scope it came from.
+class ScratchArena final : public std::pmr::memory_resource {
+public:
+    /// Bytes of block memory kept once the outermost scope ends.
+    static constexpr size_t kRetainBytes = 1 << 20;
+    static constexpr size_t kBlockBytes = 16 * 1024;
+
+    /// Rewinds the arena to where it was when constructed.
+    class Scope {
+    public:
+        explicit Scope(ScratchArena& arena = ScratchArena::local()) noexcept;
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        [[nodiscard]] ScratchArena& arena() const noexcept { return arena_; }
+
+    private:
+        ScratchArena& arena_;
+        size_t block_;
+        size_t offset_;
+    };
+
+    ScratchArena() = default;
+    ~ScratchArena() override;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /// The calling thread's arena.
+    [[nodiscard]] static ScratchArena& local();
+
+    /// Uninitialized bytes aligned to max_align_t.
+    [[nodiscard]] char* allocate_bytes(size_t n) {
+        return static_cast<char*>(allocate(n, alignof(std::max_align_t)));
+    }
+
+    /// Block memory currently held, in bytes.
+    [[nodiscard]] size_t capacity() const noexcept;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    void rewind(size_t block, size_t offset) noexcept;
+
+    std::vector<Block> blocks_;
+    size_t block_ = 0;   // index of the block being filled
+    size_t offset_ = 0;  // bytes used in that block
+    size_t depth_ = 0;   // open scopes
+};
+
+} // namespace mcp
@@ -0,0 +1,438 @@
+#pragma once
+#include "executor.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace mcp {
+
+template<typename T> class Async;
+template<typename T> class AsyncPromise;
+
+/// Cancellation signal for a request being handled; copies share it.
+/// Handlers poll is_cancelled() or register on_cancel(). The server cancels
+/// it when the client sends notifications/cancelled for the request, and
+/// requests the handler made through McpClient or McpServer meanwhile are
+/// cancelled with it.
+class CancellationToken {
+public:
+    CancellationToken() : state_(std::make_shared<State>()) {}
+
+    /// A token that is never cancelled; allocates nothing.
+    [[nodiscard]] static CancellationToken none() noexcept { return CancellationToken(nullptr); }
+
+    /// Check whether cancellation has been requested.
+    [[nodiscard]] bool is_cancelled() const noexcept {
+        return state_ && state_->cancelled.load(std::memory_order_acquire);
+    }
+
+    /// False for none(), which current() returns outside a request.
+    [[nodiscard]] bool cancellable() const noexcept { return state_ != nullptr; }
+
+    /// Request cancellation (called internally by the server). The
+    /// callbacks run once, on this thread; exceptions they throw are dropped.
+    void cancel() noexcept {
+        if (!state_) return;
+        std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->cancelled.exchange(true, std::memory_order_acq_rel)) return;
+            callbacks.swap(state_->callbacks);
+        }
+        for (auto& [id, fn] : callbacks) {
+            try { fn(); } catch (...) {}
+        }
+    }
+
+    /// Run `fn` on cancellation, or now if it already happened. Returns an
+    /// id for remove_on_cancel(), or 0 if `fn` has run or never will.
+    uint64_t on_cancel(std::function<void()> fn) const {
+        if (!state_) return 0;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->cancelled.load(std::memory_order_relaxed)) {
+                uint64_t id = ++state_->next_id;
+                state_->callbacks.emplace_back(id, std::move(fn));
+                return id;
+            }
+        }
+        fn();
+        return 0;
+    }
+
+    /// Drop a callback that hasn't run. It may already be running.
+    void remove_on_cancel(uint64_t id) const noexcept {
+        if (!state_ || id == 0) return;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        auto& cbs = state_->callbacks;
+        for (auto it = cbs.begin(); it != cbs.end(); ++it) {
+            if (it->first == id) {
+                cbs.erase(it);
+                return;
+            }
+        }
+    }
+
+    /// The token of the request whose handler is running on this thread,
+    /// including a coroutine handler resumed after co_await on an Async.
+    /// Outside a handler, one that is never cancelled.
+    [[nodiscard]] static CancellationToken current() noexcept;
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{false};
+        std::mutex mutex;
+        uint64_t next_id = 0;
+        std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+    };
+
+    explicit CancellationToken(std::nullptr_t) noexcept {}
+
+    std::shared_ptr<State> state_;
+};
+
+namespace detail {
+
+inline thread_local const CancellationToken* current_cancellation = nullptr;
+
+// Makes `token` CancellationToken::current() on this thread while in scope.
+class CancellationScope {
+public:
+    explicit CancellationScope(CancellationToken token) noexcept
+        : token_(std::move(token)), prev_(std::exchange(current_cancellation, &token_)) {}
+    ~CancellationScope() { current_cancellation = prev_; }
+
+    CancellationScope(const CancellationScope&) = delete;
+    CancellationScope& operator=(const CancellationScope&) = delete;
+
+private:
+    CancellationToken token_;
+    const CancellationToken* prev_;
+};
+
+} // namespace detail
+
+inline CancellationToken CancellationToken::current() noexcept {
+    if (const auto* t = detail::current_cancellation) return *t;
+    return none();
+}
+
+namespace detail {
+
+template<typename T>
+using AsyncStorage = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template<typename T>
+struct AsyncState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::optional<AsyncStorage<T>> value;
+    std::exception_ptr error;
+    bool ready = false;
+    std::coroutine_handle<> waiter;
+    std::shared_ptr<IExecutor> executor;
+    std::function<void()> canceller;  // dropped once ready
+    // CancellationToken::current() where the waiter suspended
+    CancellationToken waiter_cancellation = CancellationToken::none();
+
+    template<typename... Args>
+    void finish(std::exception_ptr err, Args&&... args) {
+        std::coroutine_handle<> h;
+        std::function<void()> drop;
+        CancellationToken token = CancellationToken::none();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ready) return;
+            if (err) error = std::move(err);
+            else value.emplace(std::forward<Args>(args)...);
+            ready = true;
+            h = std::exchange(waiter, nullptr);
+            drop = std::move(canceller);
+            token = std::move(waiter_cancellation);
+            cv.notify_all();
+        }
+        if (!h) return;
+        // The coroutine carries on within the request it was serving
+        if (executor) {
+            executor->post([h, token = std::move(token)]() mutable {
+                CancellationScope scope(std::move(token));
+                h.resume();
+            });
+        } else {
+            CancellationScope scope(std::move(token));
+            h.resume();
+        }
+    }
+};
+
+} // namespace detail
+
+/// Result of an outbound request that is already in flight.
+///
+/// Behaves like a std::future (get(), wait_for()) and can also be
+/// co_await-ed from a CoTask, in which case the awaiting coroutine is
+/// suspended instead of blocking its thread. The coroutine resumes on the
+/// executor the operation was created with, or on the thread that delivered
+/// the result if there is none. Only one consumer may await or get().
+template<typename T>
+class Async {
+public:
+    Async() = default;
+
+    [[nodiscard]] bool valid() const noexcept { return state_ != nullptr; }
+
+    [[nodiscard]] bool is_ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->ready;
+    }
+
+    void wait() const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->cv.wait(lock, [this] { return state_->ready; });
+    }
+
+    template<typename Rep, typename Period>
+    std::future_status wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        return state_->cv.wait_for(lock, timeout, [this] { return state_->ready; })
+            ? std::future_status::ready : std::future_status::timeout;
+    }
+
+    /// Block until the result is available; rethrows a failed request.
+    T get() {
+        wait();
+        return take();
+    }
+
+    // Awaitable interface
+    bool await_ready() const { return is_ready(); }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->ready) return false;
+        state_->waiter = h;
+        state_->waiter_cancellation = CancellationToken::current();
+        return true;
+    }
+
+    T await_resume() { return take(); }
+
+    /// Ask the producer to abandon the operation, if it hasn't finished and
+    /// supports that: an McpClient request is then sent
+    /// notifications/cancelled and fails with error::RequestCancelled.
+    /// Returns false if there was nothing to cancel.
+    bool cancel() const {
+        std::function<void()> fn;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->ready) return false;
+            fn = std::move(state_->canceller);
+        }
+        if (!fn) return false;
+        fn();
+        return true;
+    }
+
+private:
+    friend class AsyncPromise<T>;
+    explicit Async(std::shared_ptr<detail::AsyncState<T>> s) : state_(std::move(s)) {}
+
+    T take() {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->error) std::rethrow_exception(state_->error);
+        if constexpr (!std::is_void_v<T>) return std::move(*state_->value);
+    }
+
+    std::shared_ptr<detail::AsyncState<T>> state_;
+};
+
+/// Producer side of an Async<T>. Copyable; the first completion wins.
+template<typename T>
+class AsyncPromise {
+public:
+    /// `resume_on` receives the awaiting coroutine's continuation.
+    explicit AsyncPromise(std::shared_ptr<IExecutor> resume_on = nullptr)
+        : state_(std::make_shared<detail::AsyncState<T>>()) {
+        state_->executor = std::move(resume_on);
+    }
+
+    [[nodiscard]] Async<T> get_async() const { return Async<T>(state_); }
+
+    template<typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+    void set_value(U value) const {
+        state_->finish(nullptr, std::move(value));
+    }
+
+    template<typename U = T, typename = std::enable_if_t<std::is_void_v<U>>>
+    void set_value() const {
+        state_->finish(nullptr);
+    }
+
+    void set_exception(std::exception_ptr e) const {
+        state_->finish(std::move(e));
+    }
+
+    /// What Async::cancel() runs, at most once, unless the result is
+    /// already set. It should complete the promise.
+    void on_cancel(std::function<void()> fn) const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->ready) state_->canceller = std::move(fn);
+    }
+
+private:
+    std::shared_ptr<detail::AsyncState<T>> state_;
+};
+
+// ---------- CoTask ----------
+
+namespace detail {
+
+struct CoPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            if (auto c = h.promise().continuation) return c;
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template<typename T>
+struct CoPromise : CoPromiseBase {
+    std::optional<T> value;
+
+    template<typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template<>
+struct CoPromise<void> : CoPromiseBase {
+    void return_void() noexcept {}
+    void take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+/// Lazily-started coroutine returning T. Starts when co_await-ed (or passed
+/// to spawn()) and resumes its awaiter by symmetric transfer on completion,
+/// so chains of CoTasks do not grow the stack.
+///
+/// Coroutine parameters are stored by value in the frame; take arguments by
+/// value rather than by reference, since the frame outlives the call.
+template<typename T = void>
+class CoTask {
+public:
+    struct promise_type : detail::CoPromise<T> {
+        CoTask get_return_object() {
+            return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    CoTask() noexcept = default;
+    CoTask(CoTask&& o) noexcept : handle_(std::exchange(o.handle_, nullptr)) {}
+    CoTask& operator=(CoTask&& o) noexcept {
+        if (this != &o) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(o.handle_, nullptr);
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    explicit CoTask(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+// Self-destroying coroutine used to drive a CoTask from plain code.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template<typename T, typename OnValue, typename OnError>
+Detached run_detached(CoTask<T> task, OnValue on_value, OnError on_error) {
+    std::exception_ptr err;
+    std::optional<AsyncStorage<T>> value;
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            value.emplace();
+        } else {
+            value.emplace(co_await task);
+        }
+    } catch (...) {
+        err = std::current_exception();
+    }
+    try {
+        if (err) {
+            on_error(err);
+        } else if constexpr (std::is_void_v<T>) {
+            on_value();
+        } else {
+            on_value(std::move(*value));
+        }
+    } catch (...) {
+        // Completion callbacks must not escape into whichever thread resumed us
+    }
+}
+
+} // namespace detail
+
+/// Start `task` without awaiting it. `on_value(T)` (or `on_value()` for
+/// void) or `on_error(std::exception_ptr)` runs once, on whichever thread
+/// the task finishes on.
+template<typename T, typename OnValue, typename OnError>
+void spawn(CoTask<T> task, OnValue&& on_value, OnError&& on_error) {
+    detail::run_detached(std::move(task),
+                         std::forward<OnValue>(on_value),
+                         std::forward<OnError>(on_error));
+}
+
+} // namespace mcp
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace mcp::base64 {
+
+// Bulk encoding and decoding use AVX2 (picked at run time on x86-64) or
+// NEON (AArch64) unless built with MCPXX_NO_SIMD.
+
+/// Length of the padded encoding of `n` bytes.
+[[nodiscard]] constexpr size_t encoded_size(size_t n) noexcept { return (n + 2) / 3 * 4; }
+
+/// Append the padded standard (RFC 4648) encoding of `bytes` to `out`.
+void encode_to(std::string& out, std::string_view bytes);
+
+[[nodiscard]] std::string encode(std::string_view bytes);
+
+/// Decode padded standard base64. Throws std::invalid_argument on a bad
+/// character or length.
+[[nodiscard]] std::string decode(std::string_view text);
+
+/// Kernel in use: "avx2", "neon" or "scalar".
+[[nodiscard]] std::string_view implementation();
+
+/// Incremental encoder for input that arrives in pieces of any size. The
+/// output is the same as encode() of the concatenated input; at most two
+/// bytes are held back between calls.
+class Encoder {
+public:
+    /// Append the encoding of every complete 3-byte group so far.
+    void update(std::string& out, std::string_view bytes);
+
+    /// Append the held-back bytes with padding. The encoder is then reset.
+    void finish(std::string& out);
+
+private:
+    unsigned char pending_[2]{};
+    size_t pending_size_ = 0;
+};
+
+} // namespace mcp::base64
@@ -0,0 +1,59 @@
+#pragma once
+#include "json_rpc.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mcp {
+
+/// How a connection encodes the messages it sends. JSON is the protocol's
+/// own; the binary formats are an mcpxx extension that both ends agree on
+/// during initialize (the "mcpxx/framing" experimental capability).
+enum class WireFormat : uint8_t {
+    Json,
+    MessagePack,
+    Cbor,
+};
+
+/// Experimental capability through which the formats are agreed on. The
+/// client offers {"formats": [...]} and the server answers with the
+/// {"format": ...} that both ends then send.
+inline constexpr const char* kWireFormatCapability = "mcpxx/framing";
+
+/// "json", "msgpack" or "cbor", as named in the capability.
+[[nodiscard]] std::string_view to_string(WireFormat format) noexcept;
+[[nodiscard]] std::optional<WireFormat> parse_wire_format(std::string_view name) noexcept;
+
+/// Length-prefixed binary frames for the stream transports.
+///
+/// A frame is a zero byte, a byte naming the format ('M' or 'C'), the
+/// payload length as a 32-bit big-endian integer, and the payload: one
+/// message, or an array of them for a batch. No JSON line can start with a
+/// zero byte, so readers accept frames and lines interleaved, and only the
+/// sending side has to know which format was agreed on.
+class BinaryCodec {
+public:
+    static constexpr char kFrameMarker = '\0';
+    static constexpr size_t kFrameHeaderSize = 6;
+
+    /// Appends a frame holding `msg` to `out`. `format` must not be Json.
+    static void encode_frame(std::string& out, const JsonRpcMessage& msg, WireFormat format);
+    static void encode_batch_frame(std::string& out, const std::vector<JsonRpcMessage>& msgs,
+                                   WireFormat format);
+
+    /// Format and payload length of the frame header at `header`
+    /// (kFrameHeaderSize bytes, starting with kFrameMarker). Throws
+    /// McpParseError for an unknown format.
+    static std::pair<WireFormat, size_t> read_header(const char* header);
+
+    /// The messages in a frame's payload. Throws McpParseError if it
+    /// doesn't decode or isn't a message.
+    [[nodiscard]] static std::vector<JsonRpcMessage> decode(std::string_view payload,
+                                                            WireFormat format);
+};
+
+} // namespace mcp
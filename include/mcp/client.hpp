@@ -1,6 +1,8 @@
 #pragma once
 #include "types.hpp"
 #include "json_rpc.hpp"
+#include "async.hpp"
+#include "event_loop.hpp"
 #include "transport/transport.hpp"
 #include <functional>
 #include <memory>
@@ -17,6 +19,36 @@ public:
         Implementation client_info;
         ClientCapabilities capabilities;
         std::chrono::milliseconds request_timeout{30000};
+        // Resume coroutines awaiting *_async results on this executor;
+        // if null they resume on the transport's reader thread.
+        std::shared_ptr<IExecutor> executor;
+        // Opt-in request batching: requests issued within `batch_window` of
+        // the first (or until `max_batch_size` are waiting) go out as one
+        // JSON-RPC batch, i.e. one stdio line or one HTTP POST. Zero sends
+        // every request on its own.
+        std::chrono::microseconds batch_window{0};
+        size_t max_batch_size = 32;
+        // If set, connect_stdio() runs the connection on this shared loop
+        // instead of reader and writer threads of its own, and transports
+        // that support it (see ITransport::start_detached) need no thread
+        // to drive them, so many clients cost a few threads in total.
+        std::shared_ptr<EventLoop> event_loop;
+        // Offer this binary encoding in initialize (an mcpxx extension,
+        // see binary_codec.hpp). If the server accepts it, both ends send
+        // it from then on. Only stdio, shared-memory and event-loop
+        // transports can; with others the offer isn't made.
+        WireFormat wire_format = WireFormat::Json;
+        // Opt-in response cache. Pages of tools, resources and prompts are
+        // served locally while the server has promised list_changed
+        // notifications for that list, until one arrives; read_resource()
+        // results likewise for URIs subscribed to (exactly or by prefix),
+        // until resources/updated. Reads are bounded by `cache_max_bytes`.
+        bool cache_responses = false;
+        size_t cache_max_bytes = 4 << 20;
+        // How long disconnect() waits for a connect_stdio()/connect_shm()
+        // child to exit once its input is closed, and again after SIGTERM,
+        // before it sends SIGKILL. The child is always reaped.
+        std::chrono::milliseconds child_exit_timeout{2000};
     };
 
     explicit McpClient(Options opts);
@@ -29,33 +61,64 @@ public:
     void connect_stdio(const std::string& command,
                        const std::vector<std::string>& args = {});
     void connect_http(const std::string& url);
+    /// Like connect_stdio(), but talks to the child over shared memory
+    /// (ShmTransport); the child must call McpServer::serve_shm().
+    void connect_shm(const std::string& command,
+                     const std::vector<std::string>& args = {});
     void connect(std::unique_ptr<ITransport> transport);
+    /// Also ends and reaps a connect_stdio()/connect_shm() child.
     void disconnect();
 
     // ---- Initialization ----
     [[nodiscard]] InitializeResult initialize();
 
+    // The *_async variants send the request and return at once, so one
+    // thread can keep many requests in flight on a connection. co_await or
+    // get() the result. Requests of either kind that outlive
+    // request_timeout fail with McpTimeoutError, and the server is sent
+    // notifications/cancelled.
+
     // ---- Tools ----
     [[nodiscard]] PaginatedResult<ToolDefinition> list_tools(std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] Async<PaginatedResult<ToolDefinition>> list_tools_async(
+        std::optional<std::string> cursor = std::nullopt);
+    /// Every page of tools/list, in order; page by page from the cache if
+    /// cache_responses is on.
+    [[nodiscard]] std::vector<ToolDefinition> list_all_tools();
     [[nodiscard]] CallToolResult call_tool(const std::string& name,
                               const nlohmann::json& arguments = nlohmann::json::object());
+    [[nodiscard]] Async<CallToolResult> call_tool_async(const std::string& name,
+                              const nlohmann::json& arguments = nlohmann::json::object());
 
     // ---- Resources ----
     [[nodiscard]] PaginatedResult<ResourceDefinition> list_resources(std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] Async<PaginatedResult<ResourceDefinition>> list_resources_async(
+        std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] std::vector<ResourceDefinition> list_all_resources();
     [[nodiscard]] std::vector<ResourceContent> read_resource(const std::string& uri);
+    [[nodiscard]] Async<std::vector<ResourceContent>> read_resource_async(const std::string& uri);
     [[nodiscard]] PaginatedResult<ResourceTemplate> list_resource_templates(
         std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] Async<PaginatedResult<ResourceTemplate>> list_resource_templates_async(
+        std::optional<std::string> cursor = std::nullopt);
     void subscribe_resource(const std::string& uri);
     void unsubscribe_resource(const std::string& uri);
 
     // ---- Prompts ----
     [[nodiscard]] PaginatedResult<PromptDefinition> list_prompts(std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] Async<PaginatedResult<PromptDefinition>> list_prompts_async(
+        std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] std::vector<PromptDefinition> list_all_prompts();
     [[nodiscard]] GetPromptResult get_prompt(const std::string& name,
                                 const nlohmann::json& arguments = nlohmann::json::object());
+    [[nodiscard]] Async<GetPromptResult> get_prompt_async(const std::string& name,
+                                const nlohmann::json& arguments = nlohmann::json::object());
 
     // ---- Completion ----
     [[nodiscard]] CompletionResult complete(const CompletionRef& ref, const std::string& arg_name,
                               const std::string& arg_value);
+    [[nodiscard]] Async<CompletionResult> complete_async(const CompletionRef& ref,
+                              const std::string& arg_name, const std::string& arg_value);
 
     // ---- Logging ----
     void set_log_level(LogLevel level);
@@ -73,6 +136,7 @@ public:
 
     // ---- Ping ----
     void ping();
+    [[nodiscard]] Async<void> ping_async();
 
     // ---- Callbacks for server->client requests ----
     void on_sampling_request(std::function<SamplingResult(const SamplingRequest&)> handler);
@@ -0,0 +1,135 @@
+#pragma once
+#include "client.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mcp {
+
+/// Several identical stdio server processes behind one client, for servers
+/// that handle one request at a time: each request goes to the process
+/// with the fewest requests in flight.
+///
+/// A supervisor thread keeps `size` processes serving and `warm_spares`
+/// more launched and initialized. When a process exits, a spare takes its
+/// place at once and a new spare is launched in the background, backing
+/// off while launches keep failing. Requests in flight on a process that
+/// exits fail (they may not be safe to repeat); later ones go elsewhere.
+///
+/// With `adaptive_limit`, each process also admits only as many requests as
+/// its latency says it can take (AIMD), and a request waits for room rather
+/// than queueing behind a slow process. With `hedge_idempotent`, a call to
+/// a tool annotated idempotentHint or readOnlyHint that is slower than
+/// usual is sent to a second process as well; the first answer wins and
+/// the other request is cancelled.
+///
+/// Only stateless requests are pooled. Subscriptions, notifications and
+/// server->client requests belong to one process and aren't offered here.
+class McpClientPool {
+public:
+    struct Options {
+        /// Used for every process's client.
+        McpClient::Options client;
+        /// Processes serving requests.
+        size_t size = 4;
+        /// Initialized processes kept ready to replace one that exits.
+        size_t warm_spares = 1;
+        /// Wait before relaunching after a failed launch, doubling with
+        /// each further failure up to `max_respawn_backoff`.
+        std::chrono::milliseconds respawn_backoff{100};
+        std::chrono::milliseconds max_respawn_backoff{5000};
+        /// How often the supervisor looks for processes that have exited,
+        /// besides whenever a request fails.
+        std::chrono::milliseconds health_check_interval{100};
+
+        /// Adaptive concurrency: a process starts at `initial_limit`
+        /// requests in flight. An answer within `latency_tolerance` times
+        /// the fastest it has given lately raises the limit by 1/limit; a
+        /// slower one or a timeout multiplies it by `backoff_ratio`.
+        bool adaptive_limit = false;
+        size_t initial_limit = 4;
+        size_t max_limit = 64;
+        double latency_tolerance = 2.0;
+        double backoff_ratio = 0.9;
+
+        /// Hedged tool calls: once a call has been waiting longer than
+        /// `hedge_percentile` of recent call_tool latencies (and at least
+        /// `min_hedge_delay`), it is also sent to another process. No call
+        /// is hedged before `hedge_min_samples` latencies have been seen.
+        bool hedge_idempotent = false;
+        double hedge_percentile = 0.95;
+        std::chrono::milliseconds min_hedge_delay{1};
+        size_t hedge_min_samples = 20;
+    };
+
+    struct Stats {
+        size_t active = 0;         // processes serving requests
+        size_t spares = 0;         // initialized and waiting
+        size_t in_flight = 0;      // requests outstanding across the pool
+        uint64_t launched = 0;     // processes started, including by start()
+        uint64_t respawned = 0;    // launched by the supervisor, after start()
+        uint64_t failed_launches = 0;
+        size_t concurrency_limit = 0;  // summed over serving processes; 0 unless adaptive
+        uint64_t hedges = 0;       // second requests sent
+        uint64_t hedge_wins = 0;   // ...that answered first
+    };
+
+    McpClientPool(std::string command, std::vector<std::string> args, Options opts);
+    ~McpClientPool();
+
+    McpClientPool(const McpClientPool&) = delete;
+    McpClientPool& operator=(const McpClientPool&) = delete;
+
+    /// Launches and initializes the processes, in parallel. Throws the
+    /// first failure if none of them came up; the supervisor retries any
+    /// that didn't.
+    InitializeResult start();
+    /// Ends every process; requests in flight fail. Also run by the
+    /// destructor.
+    void stop();
+
+    // Blocking calls wait up to client.request_timeout for a process if
+    // none is serving (all are being replaced), then throw
+    // McpTransportError. See McpClient for the rest.
+
+    // ---- Tools ----
+    [[nodiscard]] PaginatedResult<ToolDefinition> list_tools(std::optional<std::string> cursor = std::nullopt);
+    /// Hedged if hedge_idempotent is set and the tool allows it.
+    [[nodiscard]] CallToolResult call_tool(const std::string& name,
+                              const nlohmann::json& arguments = nlohmann::json::object());
+    [[nodiscard]] Async<CallToolResult> call_tool_async(const std::string& name,
+                              const nlohmann::json& arguments = nlohmann::json::object());
+
+    // ---- Resources ----
+    [[nodiscard]] PaginatedResult<ResourceDefinition> list_resources(std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] std::vector<ResourceContent> read_resource(const std::string& uri);
+    [[nodiscard]] Async<std::vector<ResourceContent>> read_resource_async(const std::string& uri);
+    [[nodiscard]] PaginatedResult<ResourceTemplate> list_resource_templates(
+        std::optional<std::string> cursor = std::nullopt);
+
+    // ---- Prompts ----
+    [[nodiscard]] PaginatedResult<PromptDefinition> list_prompts(std::optional<std::string> cursor = std::nullopt);
+    [[nodiscard]] GetPromptResult get_prompt(const std::string& name,
+                                const nlohmann::json& arguments = nlohmann::json::object());
+    [[nodiscard]] Async<GetPromptResult> get_prompt_async(const std::string& name,
+                                const nlohmann::json& arguments = nlohmann::json::object());
+
+    // ---- Completion ----
+    [[nodiscard]] CompletionResult complete(const CompletionRef& ref, const std::string& arg_name,
+                              const std::string& arg_value);
+
+    // ---- Ping ----
+    /// Pings one process, the least busy.
+    void ping();
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace mcp
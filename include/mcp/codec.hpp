@@ -1,6 +1,8 @@
 #pragma once
 #include "json_rpc.hpp"
 #include "error.hpp"
+#include <initializer_list>
+#include <optional>
 #include <string_view>
 #include <vector>
 
@@ -9,20 +11,66 @@ namespace mcp {
 class Codec {
 public:
     /// Parse raw JSON bytes into a message.
+    /// Envelope fields are read straight from simdjson; `params` and
+    /// `result` are kept as raw text (see LazyJson) and only become a DOM
+    /// when accessed, so malformed payloads surface on first access.
     /// Throws McpParseError on invalid JSON or missing required fields.
     [[nodiscard]] static JsonRpcMessage parse(std::string_view raw);
 
+    /// Bytes that must be readable past the end of the input to parse_padded.
+    static constexpr size_t kParsePadding = 64;
+
+    /// Same as parse, but reads `raw` in place instead of copying it into a
+    /// padded buffer. The caller guarantees kParsePadding allocated bytes
+    /// after `raw.end()`; their contents are ignored.
+    [[nodiscard]] static JsonRpcMessage parse_padded(std::string_view raw);
+
+    /// Parse by converting the whole document to nlohmann::json first.
+    /// Fully validates the payload up front; kept as a reference path.
+    [[nodiscard]] static JsonRpcMessage parse_dom(std::string_view raw);
+
+    /// Build a message from a DOM parsed some other way (e.g. decoded from
+    /// a binary frame, see BinaryCodec), with the same checks as parse_dom.
+    /// Payloads are moved out of `j`.
+    [[nodiscard]] static JsonRpcMessage from_dom(nlohmann::json j);
+
+    /// Parse a single JSON value into a DOM.
+    [[nodiscard]] static nlohmann::json parse_value(std::string_view raw);
+
+    /// Locate member `key` of the JSON object `object` without building a
+    /// DOM. The result views `object`; nullopt if absent. Throws
+    /// McpParseError if `object` is not an object.
+    [[nodiscard]] static std::optional<std::string_view> find_raw_member(std::string_view object,
+                                                                         std::string_view key);
+
+    /// Same as find_raw_member for several keys in one pass.
+    [[nodiscard]] static std::vector<std::optional<std::string_view>> find_raw_members(
+        std::string_view object, std::initializer_list<std::string_view> keys);
+
     /// Parse a batch of messages (JSON array).
     [[nodiscard]] static std::vector<JsonRpcMessage> parse_batch(std::string_view raw);
 
-    /// Serialize a message to JSON string.
+    /// Serialize a message to JSON string. Payloads still held as raw
+    /// text (LazyJson::raw()) are copied through without re-encoding.
     [[nodiscard]] static std::string serialize(const JsonRpcMessage& msg);
 
+    /// Append the serialized message to `out`, which transports reuse as a
+    /// frame buffer to avoid a temporary string per message.
+    static void serialize_to(std::string& out, const JsonRpcMessage& msg);
+
+    /// Append the opening of a response with id `id`, up to its result:
+    /// the result text and a closing '}' complete it. For writing a
+    /// streamed result (JsonRpcResponse::result_stream) as it is produced.
+    static void serialize_result_head(std::string& out, const RequestId& id);
+
     /// Serialize a batch.
     [[nodiscard]] static std::string serialize_batch(const std::vector<JsonRpcMessage>& msgs);
 
+    /// Append a serialized batch to `out`.
+    static void serialize_batch_to(std::string& out, const std::vector<JsonRpcMessage>& msgs);
+
 private:
-    static JsonRpcMessage parse_object(const nlohmann::json& j);
+    static JsonRpcMessage parse_object(nlohmann::json j);
 };
 
 } // namespace mcp
@@ -37,7 +37,11 @@ namespace error {
     constexpr int MethodNotFound   = -32601;
     constexpr int InvalidParams    = -32602;
     constexpr int InternalError    = -32603;
+    constexpr int RequestTimeout   = -32001;
     constexpr int ResourceNotFound = -32002;
+    // The request was cancelled: by Async::cancel(), by the request it was
+    // made for being cancelled, or, from a server, before it started
+    constexpr int RequestCancelled = -32800;
 } // namespace error
 
 } // namespace mcp
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mcp {
+
+/// A small set of epoll threads that many connections share, so a process
+/// holding hundreds of transports doesn't need threads per connection.
+/// Each thread (a Poller) owns its own epoll set; connections are spread
+/// across them round-robin and then stay on one, so a connection's
+/// handlers never run concurrently.
+class EventLoop {
+public:
+    struct Options {
+        size_t num_threads = 1;  ///< at least 1
+    };
+
+    /// A readiness handler, called on the poller thread with the epoll
+    /// events that fired (EPOLLIN, EPOLLOUT, EPOLLHUP, ...).
+    using Handler = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+
+    class Poller {
+    public:
+        /// Starts calling `handler` whenever `fd` is ready for `events`.
+        /// The fd is level-triggered and should be non-blocking. Throws
+        /// McpTransportError if epoll refuses it.
+        void watch(int fd, uint32_t events, Handler handler);
+        /// Replaces the events watched for on `fd`.
+        void modify(int fd, uint32_t events);
+        /// Stops watching `fd`. Once it returns, the fd's handler is not
+        /// running and won't be called again (unless called from inside
+        /// that handler, which is also allowed).
+        void unwatch(int fd);
+        /// Runs `task` on the poller thread after the current batch of events.
+        void post(Task task);
+        /// Whether the calling thread is this poller's thread.
+        [[nodiscard]] bool on_thread() const noexcept;
+
+        Poller(const Poller&) = delete;
+        Poller& operator=(const Poller&) = delete;
+        ~Poller();
+
+    private:
+        friend class EventLoop;
+        Poller();
+        void stop();
+
+        // Shared with the thread, which may outlive the loop when the loop
+        // is destroyed from one of its own handlers
+        struct Impl;
+        std::shared_ptr<Impl> impl_;
+    };
+
+    EventLoop();
+    explicit EventLoop(Options opts);
+    /// Stops and joins the threads. Handlers still registered are dropped.
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /// The poller a new connection should go to (round-robin).
+    [[nodiscard]] Poller& next();
+    [[nodiscard]] size_t size() const noexcept { return pollers_.size(); }
+
+private:
+    std::vector<std::unique_ptr<Poller>> pollers_;
+    std::atomic<size_t> next_{0};
+};
+
+} // namespace mcp
@@ -0,0 +1,186 @@
+#pragma once
+#include "metrics.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mcp {
+
+/// Move-only type-erased `void()` callable with inline storage.
+/// Callables up to kInlineSize bytes (e.g. a lambda capturing a few
+/// pointers and a message) are stored in place, so posting a short
+/// handler does not heap-allocate the way std::function does.
+class Task {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    Task() noexcept = default;
+
+    template<typename F,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {  // NOLINT(google-explicit-constructor)
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= kInlineSize
+                      && alignof(Fn) <= alignof(std::max_align_t)
+                      && std::is_nothrow_move_constructible_v<Fn>) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            vtable_ = &inline_vtable<Fn>;
+        } else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            vtable_ = &heap_vtable<Fn>;
+        }
+    }
+
+    Task(Task&& o) noexcept : vtable_(o.vtable_) {
+        if (vtable_) {
+            vtable_->move(storage_, o.storage_);
+            o.vtable_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) {
+            reset();
+            vtable_ = o.vtable_;
+            if (vtable_) {
+                vtable_->move(storage_, o.storage_);
+                o.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    void operator()() { vtable_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    /// True if the callable lives in the inline buffer.
+    [[nodiscard]] bool is_inline() const noexcept {
+        return vtable_ && vtable_->is_inline;
+    }
+
+private:
+    struct VTable {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* self) noexcept;
+        bool is_inline;
+    };
+
+    template<typename Fn>
+    static constexpr VTable inline_vtable{
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+        true
+    };
+
+    template<typename Fn>
+    static constexpr VTable heap_vtable{
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* self) noexcept { delete *static_cast<Fn**>(self); },
+        false
+    };
+
+    void reset() noexcept {
+        if (vtable_) {
+            vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const VTable* vtable_{nullptr};
+};
+
+/// Abstract executor used by McpServer to run request handlers.
+class IExecutor {
+public:
+    virtual ~IExecutor() = default;
+
+    /// Schedule a task. Must be safe to call from any thread, including
+    /// from inside a running task.
+    virtual void post(Task task) = 0;
+
+    /// Stop accepting work, run everything already queued, join workers.
+    virtual void shutdown() = 0;
+
+    /// Number of worker threads.
+    [[nodiscard]] virtual size_t concurrency() const = 0;
+};
+
+/// Work-stealing thread pool.
+///
+/// Each worker owns a deque guarded by its own lock. Tasks posted from a
+/// worker go to the back of that worker's deque and are popped LIFO for
+/// cache locality; tasks posted from other threads are spread round-robin.
+/// Idle workers steal from the front of their peers' deques before
+/// sleeping, so there is no single queue lock for producers and consumers
+/// to fight over.
+class WorkStealingExecutor : public IExecutor {
+public:
+    struct Options {
+        size_t num_threads = 0;    // 0 = std::thread::hardware_concurrency()
+        bool pin_threads = false;  // pin worker i to CPU (i % ncpu); Linux only
+    };
+
+    WorkStealingExecutor();
+    explicit WorkStealingExecutor(Options opts);
+    ~WorkStealingExecutor() override;
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    /// After shutdown(), post() runs the task on the calling thread.
+    void post(Task task) override;
+    void shutdown() override;
+    [[nodiscard]] size_t concurrency() const override { return workers_.size(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(size_t index);
+    bool try_pop(size_t index, Task& out);
+    bool try_steal(size_t index, Task& out);
+
+    Options opts_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<size_t> queued_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> stopped_{false};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> sleepers_{0};
+
+    metrics::Gauge queued_gauge_{"mcpxx_executor_queued_tasks", [this] {
+        return static_cast<int64_t>(queued_.load(std::memory_order_relaxed));
+    }};
+};
+
+} // namespace mcp
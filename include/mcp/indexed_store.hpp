@@ -0,0 +1,236 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace mcp {
+
+namespace detail {
+
+/// Immutable ordered map (a treap). Updates copy only the O(log n) nodes on
+/// the path they touch and share the rest, so copying the map is O(1) and an
+/// old copy is unaffected by later updates.
+template<typename K, typename V>
+class PersistentTreap {
+public:
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+
+    [[nodiscard]] const V* find(const K& key) const {
+        const Node* n = root_.get();
+        while (n) {
+            if (key < n->key) n = n->left.get();
+            else if (n->key < key) n = n->right.get();
+            else return &n->value;
+        }
+        return nullptr;
+    }
+
+    void insert_or_assign(K key, V value) {
+        if (find(key)) {
+            root_ = assign(root_, key, std::move(value));
+            return;
+        }
+        uint64_t prio = priority(key);
+        root_ = insert(root_, make(std::move(key), std::move(value), prio, nullptr, nullptr));
+        ++size_;
+    }
+
+    bool erase(const K& key) {
+        if (!find(key)) return false;
+        root_ = erase(root_, key);
+        --size_;
+        return true;
+    }
+
+    /// Visit entries in key order, starting after `after` if given, while
+    /// `f(key, value)` returns true.
+    template<typename F>
+    void for_each(const K* after, F&& f) const {
+        bool go = true;
+        visit(root_.get(), after, f, go);
+    }
+
+private:
+    struct Node;
+    using Ptr = std::shared_ptr<const Node>;
+
+    struct Node {
+        K key;
+        V value;
+        uint64_t priority;
+        Ptr left, right;
+    };
+
+    // Derived from the key, so the shape doesn't depend on insertion order
+    static uint64_t priority(const K& key) {
+        uint64_t x = static_cast<uint64_t>(std::hash<K>{}(key)) + 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    static Ptr make(K key, V value, uint64_t prio, Ptr left, Ptr right) {
+        return std::make_shared<const Node>(
+            Node{std::move(key), std::move(value), prio, std::move(left), std::move(right)});
+    }
+    static Ptr with_children(const Node& n, Ptr left, Ptr right) {
+        return make(n.key, n.value, n.priority, std::move(left), std::move(right));
+    }
+
+    static Ptr assign(const Ptr& t, const K& key, V value) {
+        if (key < t->key) return with_children(*t, assign(t->left, key, std::move(value)), t->right);
+        if (t->key < key) return with_children(*t, t->left, assign(t->right, key, std::move(value)));
+        return make(t->key, std::move(value), t->priority, t->left, t->right);
+    }
+
+    // Keys below `key` and keys above it; `key` itself is absent
+    static std::pair<Ptr, Ptr> split(const Ptr& t, const K& key) {
+        if (!t) return {nullptr, nullptr};
+        if (t->key < key) {
+            auto [l, r] = split(t->right, key);
+            return {with_children(*t, t->left, std::move(l)), std::move(r)};
+        }
+        auto [l, r] = split(t->left, key);
+        return {std::move(l), with_children(*t, std::move(r), t->right)};
+    }
+
+    // Every key in `a` is below every key in `b`
+    static Ptr merge(const Ptr& a, const Ptr& b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->priority > b->priority) return with_children(*a, a->left, merge(a->right, b));
+        return with_children(*b, merge(a, b->left), b->right);
+    }
+
+    static Ptr insert(const Ptr& t, Ptr node) {
+        if (!t) return node;
+        if (node->priority > t->priority) {
+            auto [l, r] = split(t, node->key);
+            return with_children(*node, std::move(l), std::move(r));
+        }
+        if (node->key < t->key) return with_children(*t, insert(t->left, std::move(node)), t->right);
+        return with_children(*t, t->left, insert(t->right, std::move(node)));
+    }
+
+    static Ptr erase(const Ptr& t, const K& key) {
+        if (key < t->key) return with_children(*t, erase(t->left, key), t->right);
+        if (t->key < key) return with_children(*t, t->left, erase(t->right, key));
+        return merge(t->left, t->right);
+    }
+
+    template<typename F>
+    static void visit(const Node* n, const K* after, F& f, bool& go) {
+        if (!n) return;
+        if (!after || *after < n->key) {
+            visit(n->left.get(), after, f, go);
+            if (!go) return;
+            go = f(n->key, n->value);
+            if (!go) return;
+        }
+        visit(n->right.get(), after, f, go);
+    }
+
+    Ptr root_;
+    size_t size_ = 0;
+};
+
+} // namespace detail
+
+/// Named definitions with their handlers, listed in registration order.
+///
+/// Upsert, remove and lookup are O(log n). Each entry gets a sequence
+/// number when first added, kept if it is replaced, so a cursor naming the
+/// last entry of a page still resumes at the right place after other entries
+/// come and go. Copies share structure and cost O(1), which suits holding
+/// the store in a CowSnapshot.
+template<typename T, typename Handler>
+class IndexedStore {
+public:
+    [[nodiscard]] size_t size() const noexcept { return by_key_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    /// Add `def` under `key`, replacing (in place) any entry with that key.
+    void put(std::string key, T def, Handler handler) {
+        auto shared_def = std::make_shared<const T>(std::move(def));
+        const Entry* existing = by_key_.find(key);
+        uint64_t seq = existing ? existing->seq : next_seq_++;
+        by_seq_.insert_or_assign(seq, std::move(shared_def));
+        by_key_.insert_or_assign(std::move(key),
+            Entry{seq, std::make_shared<const Handler>(std::move(handler))});
+    }
+
+    bool erase(const std::string& key) {
+        const Entry* e = by_key_.find(key);
+        if (!e) return false;
+        by_seq_.erase(e->seq);
+        by_key_.erase(key);
+        return true;
+    }
+
+    [[nodiscard]] std::shared_ptr<const Handler> find(const std::string& key) const {
+        const Entry* e = by_key_.find(key);
+        return e ? e->handler : nullptr;
+    }
+
+    [[nodiscard]] std::shared_ptr<const T> find_def(const std::string& key) const {
+        const Entry* e = by_key_.find(key);
+        if (!e) return nullptr;
+        const auto* def = by_seq_.find(e->seq);
+        return def ? *def : nullptr;
+    }
+
+    /// Replace the handler under `key`, keeping its definition and place.
+    /// Returns false if there is no such entry.
+    bool replace_handler(const std::string& key, Handler handler) {
+        const Entry* e = by_key_.find(key);
+        if (!e) return false;
+        uint64_t seq = e->seq;
+        by_key_.insert_or_assign(key, Entry{seq, std::make_shared<const Handler>(std::move(handler))});
+        return true;
+    }
+
+    /// Visit `(key, handler)` pairs in key order while `f` returns true.
+    template<typename F>
+    void for_each_handler(F&& f) const {
+        by_key_.for_each(nullptr, [&](const std::string& key, const Entry& e) {
+            return f(key, e.handler);
+        });
+    }
+
+    /// Call `f(def)` for up to `limit` definitions in registration order,
+    /// starting after the entry `cursor` names (from the start if none).
+    /// Returns the cursor for the next page, if anything is left.
+    template<typename F>
+    std::optional<uint64_t> page(std::optional<uint64_t> cursor, size_t limit, F&& f) const {
+        size_t n = 0;
+        std::optional<uint64_t> last, next;
+        by_seq_.for_each(cursor ? &*cursor : nullptr,
+            [&](uint64_t seq, const std::shared_ptr<const T>& def) {
+                if (n == limit) {
+                    next = last;
+                    return false;
+                }
+                f(*def);
+                last = seq;
+                ++n;
+                return true;
+            });
+        return next;
+    }
+
+private:
+    struct Entry {
+        uint64_t seq;
+        std::shared_ptr<const Handler> handler;
+    };
+
+    detail::PersistentTreap<std::string, Entry> by_key_;
+    detail::PersistentTreap<uint64_t, std::shared_ptr<const T>> by_seq_;
+    uint64_t next_seq_ = 1;
+};
+
+} // namespace mcp
@@ -1,8 +1,12 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <optional>
 #include <nlohmann/json.hpp>
+#include "method.hpp"
 
 namespace mcp {
 
@@ -44,12 +48,99 @@ inline void from_json(const nlohmann::json& j, JsonRpcError& e) {
     if (j.contains("data")) e.data = j.at("data");
 }
 
+/// Optional JSON value that may still be held as unparsed text.
+///
+/// The codec stores `params` and `result` this way, so a message can be
+/// routed on its envelope without building a DOM for the payload. The tree
+/// is built on first access through `*`, `->` or value(); until then, and
+/// as long as it is only read, raw() returns the original text. Like the
+/// rest of a message, concurrent first access is not synchronized.
+class LazyJson {
+public:
+    LazyJson() = default;
+    LazyJson(std::nullopt_t) noexcept {}  // NOLINT(google-explicit-constructor)
+    LazyJson(nlohmann::json j) : value_(std::move(j)) {}  // NOLINT(google-explicit-constructor)
+    LazyJson(std::optional<nlohmann::json> j) : value_(std::move(j)) {}  // NOLINT(google-explicit-constructor)
+
+    /// Wrap raw JSON text; it is parsed on first access.
+    [[nodiscard]] static LazyJson from_raw(std::string raw);
+    /// Wrap raw JSON text shared with another owner, without copying it.
+    [[nodiscard]] static LazyJson from_raw(std::shared_ptr<const std::string> raw);
+
+    [[nodiscard]] bool has_value() const noexcept { return value_ || raw_text(); }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    const nlohmann::json& operator*() const { return value(); }
+    nlohmann::json& operator*() { return value(); }
+    const nlohmann::json* operator->() const { return &value(); }
+    nlohmann::json* operator->() { return &value(); }
+
+    /// Throws std::bad_optional_access if empty, McpParseError if the raw
+    /// text is malformed. Mutable access discards the raw text.
+    const nlohmann::json& value() const;
+    nlohmann::json& value();
+    [[nodiscard]] nlohmann::json value_or(nlohmann::json fallback) const;
+
+    /// True while the value has not been parsed yet.
+    [[nodiscard]] bool is_raw() const noexcept { return raw_text() && !value_; }
+
+    /// Original wire text, if any and not modified since.
+    [[nodiscard]] std::optional<std::string_view> raw() const noexcept {
+        if (auto* text = raw_text()) return std::string_view(*text);
+        return std::nullopt;
+    }
+
+    void reset() noexcept {
+        value_.reset();
+        raw_.reset();
+        shared_raw_.reset();
+    }
+
+    bool operator==(const LazyJson& o) const;
+
+private:
+    [[nodiscard]] const std::string* raw_text() const noexcept {
+        return raw_ ? &*raw_ : shared_raw_.get();
+    }
+
+    mutable std::optional<nlohmann::json> value_;
+    std::optional<std::string> raw_;
+    std::shared_ptr<const std::string> shared_raw_;  // instead of raw_, when shared
+};
+
+/// Pre-serialized JSON text, spliced into outgoing messages verbatim.
+/// The producer is responsible for it being a single valid JSON value.
+struct RawJson {
+    std::string text;
+};
+
+/// Pre-serialized JSON text shared with another owner, such as a cache,
+/// and spliced into outgoing messages without being copied.
+struct SharedJson {
+    std::shared_ptr<const std::string> text;
+};
+
+/// Produces JSON text in pieces: appends the next piece to `out` and
+/// returns false once it has appended the last one. Single pass: of several
+/// copies, only one may be drained.
+using JsonStream = std::function<bool(std::string& out)>;
+
+/// A result produced piecewise, for results too large to hold whole (see
+/// McpServer::add_resource_stream). Transports that can write it as it is
+/// produced do; the others collect it first.
+struct StreamedJson {
+    JsonStream next;
+};
+
 struct JsonRpcRequest {
     RequestId id;
     std::string method;
-    std::optional<nlohmann::json> params;
+    LazyJson params;
     // _meta field for progress tokens and other metadata
     std::optional<nlohmann::json> meta;
+    // `method` interned by the codec; Unknown for custom methods and for
+    // messages built in process, which dispatch interns on the fly
+    Method method_id = Method::Unknown;
 
     bool operator==(const JsonRpcRequest& o) const {
         return id == o.id && method == o.method && params == o.params && meta == o.meta;
@@ -58,17 +149,21 @@ struct JsonRpcRequest {
 
 struct JsonRpcResponse {
     RequestId id;
-    std::optional<nlohmann::json> result;
+    LazyJson result;
     std::optional<JsonRpcError> error;
+    // Set instead of `result` for a StreamedJson result; serializing drains it
+    JsonStream result_stream;
 
     bool operator==(const JsonRpcResponse& o) const {
-        return id == o.id && result == o.result && error == o.error;
+        return id == o.id && result == o.result && error == o.error
+            && static_cast<bool>(result_stream) == static_cast<bool>(o.result_stream);
     }
 };
 
 struct JsonRpcNotification {
     std::string method;
-    std::optional<nlohmann::json> params;
+    LazyJson params;
+    Method method_id = Method::Unknown;  // as in JsonRpcRequest
 
     bool operator==(const JsonRpcNotification& o) const {
         return method == o.method && params == o.params;
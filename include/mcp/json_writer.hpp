@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+
+namespace mcp {
+
+/// Streaming JSON emitter that appends to a caller-owned buffer.
+///
+/// Nothing is built in between: values are escaped and formatted straight
+/// into `out`, so a transport can reuse one buffer (with its framing bytes
+/// around the message) and serialize without allocating once the buffer has
+/// grown to its working size. Commas are inserted automatically; the caller
+/// is responsible for balanced begin/end calls and for emitting a key before
+/// every value inside an object. Strings are copied through as UTF-8 without
+/// validation.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) noexcept : out_(out) {}
+
+    JsonWriter& begin_object() { prefix(); out_ += '{'; comma_ = false; return *this; }
+    JsonWriter& end_object() { out_ += '}'; comma_ = true; return *this; }
+    JsonWriter& begin_array() { prefix(); out_ += '['; comma_ = false; return *this; }
+    JsonWriter& end_array() { out_ += ']'; comma_ = true; return *this; }
+
+    JsonWriter& key(std::string_view k) {
+        prefix();
+        write_string(k);
+        out_ += ':';
+        comma_ = false;
+        return *this;
+    }
+
+    JsonWriter& value(std::string_view s) { prefix(); write_string(s); comma_ = true; return *this; }
+    JsonWriter& value(const std::string& s) { return value(std::string_view(s)); }
+    JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+    JsonWriter& value(bool b) { prefix(); out_ += b ? "true" : "false"; comma_ = true; return *this; }
+    JsonWriter& value(double d);
+    JsonWriter& value(std::nullptr_t) { return null(); }
+    JsonWriter& value(const nlohmann::json& j);
+
+    template<typename T,
+             typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    JsonWriter& value(T i) {
+        if constexpr (std::is_signed_v<T>) return write_int(static_cast<int64_t>(i));
+        else return write_uint(static_cast<uint64_t>(i));
+    }
+
+    JsonWriter& null() { prefix(); out_ += "null"; comma_ = true; return *this; }
+
+    /// Splice pre-serialized JSON text as the next value.
+    JsonWriter& raw(std::string_view json) { prefix(); out_ += json; comma_ = true; return *this; }
+
+    /// String value whose characters need no escaping (e.g. base64),
+    /// appended straight to the buffer by `fill(std::string&)`.
+    template<typename F>
+    JsonWriter& string_with(F&& fill) {
+        prefix();
+        out_ += '"';
+        fill(out_);
+        out_ += '"';
+        comma_ = true;
+        return *this;
+    }
+
+        /// key(k).value(v)
+    template<typename T>
+    JsonWriter& field(std::string_view k, const T& v) { key(k); return value(v); }
+
+    [[nodiscard]] std::string& buffer() noexcept { return out_; }
+
+    /// Append `s` escaped as the inside of a JSON string, without quotes,
+    /// for string values written in pieces.
+    static void escape(std::string& out, std::string_view s);
+
+private:
+    void prefix() {
+        if (comma_) out_ += ',';
+    }
+    void write_string(std::string_view s);
+    JsonWriter& write_int(int64_t i);
+    JsonWriter& write_uint(uint64_t u);
+
+    std::string& out_;
+    bool comma_ = false;  // a value was just completed at the current level
+};
+
+} // namespace mcp
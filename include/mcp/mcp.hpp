@@ -9,8 +9,14 @@
 #include "codec.hpp"
 #include "session.hpp"
 #include "router.hpp"
+#include "executor.hpp"
+#include "async.hpp"
+#include "metrics.hpp"
+#include "event_loop.hpp"
 #include "server.hpp"
 #include "client.hpp"
+#include "client_pool.hpp"
 #include "transport/transport.hpp"
 #include "transport/stdio_transport.hpp"
+#include "transport/event_loop_transport.hpp"
 #include "transport/http_transport.hpp"
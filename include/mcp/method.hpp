@@ -0,0 +1,118 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace mcp {
+
+/// The standard MCP methods, interned so dispatch can index tables instead
+/// of hashing strings. Anything else is Method::Unknown and goes through the
+/// string-keyed fallback.
+enum class Method : uint8_t {
+    Unknown,
+    Initialize,
+    Ping,
+    ToolsList,
+    ToolsCall,
+    ResourcesList,
+    ResourcesRead,
+    ResourcesTemplatesList,
+    ResourcesSubscribe,
+    ResourcesUnsubscribe,
+    PromptsList,
+    PromptsGet,
+    CompletionComplete,
+    LoggingSetLevel,
+    SamplingCreateMessage,
+    ElicitationCreate,
+    RootsList,
+    NotificationsInitialized,
+    NotificationsCancelled,
+    NotificationsProgress,
+    NotificationsMessage,
+    NotificationsToolsListChanged,
+    NotificationsResourcesListChanged,
+    NotificationsResourcesUpdated,
+    NotificationsPromptsListChanged,
+    NotificationsRootsListChanged,
+};
+
+inline constexpr size_t kMethodCount =
+    static_cast<size_t>(Method::NotificationsRootsListChanged) + 1;
+
+namespace detail {
+
+inline constexpr std::array<std::string_view, kMethodCount> kMethodNames = {
+    "",
+    "initialize",
+    "ping",
+    "tools/list",
+    "tools/call",
+    "resources/list",
+    "resources/read",
+    "resources/templates/list",
+    "resources/subscribe",
+    "resources/unsubscribe",
+    "prompts/list",
+    "prompts/get",
+    "completion/complete",
+    "logging/setLevel",
+    "sampling/createMessage",
+    "elicitation/create",
+    "roots/list",
+    "notifications/initialized",
+    "notifications/cancelled",
+    "notifications/progress",
+    "notifications/message",
+    "notifications/tools/list_changed",
+    "notifications/resources/list_changed",
+    "notifications/resources/updated",
+    "notifications/prompts/list_changed",
+    "notifications/roots/list_changed",
+};
+
+// FNV-1a with a seed chosen so every standard name lands in its own slot
+// (checked below; pick a new seed if a method is added and it fires).
+inline constexpr uint32_t kMethodHashSeed = 163;
+inline constexpr unsigned kMethodSlotBits = 6;
+
+constexpr size_t method_slot(std::string_view s) noexcept {
+    uint32_t h = kMethodHashSeed;
+    for (char c : s) h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    return h >> (32 - kMethodSlotBits);
+}
+
+constexpr std::array<Method, size_t{1} << kMethodSlotBits> build_method_table() {
+    std::array<Method, size_t{1} << kMethodSlotBits> table{};
+    for (size_t i = 1; i < kMethodCount; ++i) {
+        table[method_slot(kMethodNames[i])] = static_cast<Method>(i);
+    }
+    return table;
+}
+
+inline constexpr auto kMethodTable = build_method_table();
+
+constexpr bool method_table_is_perfect() {
+    for (size_t i = 1; i < kMethodCount; ++i) {
+        if (kMethodTable[method_slot(kMethodNames[i])] != static_cast<Method>(i)) return false;
+    }
+    return true;
+}
+static_assert(method_table_is_perfect(), "method hash collides; change kMethodHashSeed");
+
+} // namespace detail
+
+/// Interned id of `name`, or Method::Unknown for non-standard methods.
+/// One hash and one comparison.
+constexpr Method intern_method(std::string_view name) noexcept {
+    Method m = detail::kMethodTable[detail::method_slot(name)];
+    return detail::kMethodNames[static_cast<size_t>(m)] == name && m != Method::Unknown
+        ? m : Method::Unknown;
+}
+
+constexpr std::string_view method_name(Method m) noexcept {
+    return detail::kMethodNames[static_cast<size_t>(m)];
+}
+
+} // namespace mcp
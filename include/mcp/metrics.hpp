@@ -0,0 +1,171 @@
+#pragma once
+#include "json_rpc.hpp"
+#include "method.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mcp {
+
+/// Latency distribution in nanoseconds with log-linear buckets, as in
+/// HdrHistogram: each power of two is split into 8 sub-buckets, so a
+/// reported value is within 12.5% of the true one. Values of 2^36 ns
+/// (about 69 s) and up share the top bucket.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr unsigned kMaxBits = 36;
+    static constexpr size_t kBuckets = ((kMaxBits - kSubBucketBits) + 1) << kSubBucketBits;
+
+    static constexpr size_t bucket_of(uint64_t ns) noexcept {
+        constexpr uint64_t kSub = uint64_t{1} << kSubBucketBits;
+        if (ns >= (uint64_t{1} << kMaxBits)) return kBuckets - 1;
+        if (ns < kSub) return static_cast<size_t>(ns);
+        unsigned shift = static_cast<unsigned>(std::bit_width(ns)) - (kSubBucketBits + 1);
+        return static_cast<size_t>(((shift + 1) << kSubBucketBits) + (ns >> shift) - kSub);
+    }
+
+    /// Smallest value that lands past bucket `i`.
+    static constexpr uint64_t bucket_limit(size_t i) noexcept {
+        constexpr uint64_t kSub = uint64_t{1} << kSubBucketBits;
+        if (i < kSub) return i + 1;
+        unsigned shift = static_cast<unsigned>(i >> kSubBucketBits) - 1;
+        return (kSub + (i & (kSub - 1)) + 1) << shift;
+    }
+
+    void record(uint64_t ns) noexcept { add(bucket_of(ns), 1, ns); }
+    /// Adds `n` values summing to `sum_ns` to bucket `i`.
+    void add(size_t bucket, uint64_t n, uint64_t sum_ns) noexcept;
+    void merge(const LatencyHistogram& other) noexcept;
+
+    [[nodiscard]] uint64_t count() const noexcept { return count_; }
+    [[nodiscard]] uint64_t sum_ns() const noexcept { return sum_ns_; }
+    [[nodiscard]] uint64_t bucket_count(size_t i) const noexcept { return counts_[i]; }
+    /// Values below `ns`, exact when `ns` is a power of two.
+    [[nodiscard]] uint64_t count_below(uint64_t ns) const noexcept;
+    /// Highest value in the bucket holding quantile `q` (0..1); 0 if empty.
+    [[nodiscard]] uint64_t percentile(double q) const noexcept;
+
+private:
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ns_ = 0;
+};
+
+/// Dispatch counts for one method. Latency runs from dispatch to the
+/// response being ready (requests) or the handler returning (notifications).
+struct MethodStats {
+    std::string method;  // "other" for all custom methods together
+    uint64_t calls = 0;
+    uint64_t errors = 0;  // error responses, or notification handlers that threw
+    LatencyHistogram latency;  // the sampled calls only; see set_latency_sampling()
+};
+
+struct MetricsSnapshot {
+    std::vector<MethodStats> methods;  // methods dispatched at least once
+    uint64_t messages_parsed = 0;
+    uint64_t bytes_parsed = 0;
+    uint64_t parse_errors = 0;
+    uint64_t messages_serialized = 0;
+    uint64_t bytes_serialized = 0;
+    /// Queue depths and other levels, sampled when the snapshot was taken
+    /// and summed over instances of the same name.
+    std::vector<std::pair<std::string, int64_t>> gauges;
+
+    [[nodiscard]] const MethodStats* find(std::string_view method) const;
+    /// Prometheus text exposition format, version 0.0.4.
+    [[nodiscard]] std::string to_prometheus() const;
+};
+
+/// Tracing hooks around every dispatch, e.g. to start and end
+/// OpenTelemetry spans named after the method.
+class ISpanHooks {
+public:
+    virtual ~ISpanHooks() = default;
+
+    /// Called on the dispatching thread as a message starts dispatch; `id`
+    /// is null for notifications. The result is handed to end_span().
+    virtual void* start_span(std::string_view method, const RequestId* id) = 0;
+
+    /// Called once per start_span(), possibly on another thread, with the
+    /// response's error code (0 on success).
+    virtual void end_span(void* span, int error_code) noexcept = 0;
+};
+
+/// Process-wide instrumentation of dispatch, the codec and transport queues.
+/// Hot paths write counters owned by the calling thread, so recording is a
+/// few plain stores; snapshot() adds the threads' counters up. Building with
+/// MCPXX_METRICS=OFF compiles recording out entirely; snapshots then hold
+/// gauges only.
+namespace metrics {
+
+#ifdef MCPXX_NO_METRICS
+inline constexpr bool kEnabled = false;
+#else
+inline constexpr bool kEnabled = true;
+#endif
+
+[[nodiscard]] MetricsSnapshot snapshot();
+
+/// Times one dispatch in `every` on each thread (default 8; 1 times all).
+/// Reading the clock is most of what recording costs, and a uniform sample
+/// keeps percentiles accurate. Counts are always exact.
+void set_latency_sampling(uint32_t every) noexcept;
+
+/// Installs tracing hooks (null removes them). `hooks` must outlive every
+/// dispatch that starts while it is installed.
+void set_span_hooks(ISpanHooks* hooks) noexcept;
+
+/// A named level sampled by snapshot() for as long as the object lives.
+/// `sample` runs on the thread taking the snapshot.
+class Gauge {
+public:
+    Gauge() noexcept = default;
+    Gauge(std::string name, std::function<int64_t()> sample);
+    ~Gauge();
+
+    Gauge(Gauge&& other) noexcept;
+    Gauge& operator=(Gauge&& other) noexcept;
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(const Gauge&) = delete;
+
+private:
+    uint64_t id_ = 0;
+};
+
+} // namespace metrics
+
+namespace detail {
+
+// Recording entry points for the library's hot paths.
+#ifndef MCPXX_NO_METRICS
+struct DispatchMark {
+    uint64_t start_ns;  // 0: not sampled
+    Method method;
+    ISpanHooks* hooks;
+    void* span;
+};
+
+DispatchMark begin_dispatch(Method id, std::string_view method, const RequestId* request) noexcept;
+void end_dispatch(const DispatchMark& mark, int error_code) noexcept;
+void count_parsed(size_t bytes, size_t messages) noexcept;
+void count_parse_error() noexcept;
+void count_serialized(size_t bytes, size_t messages) noexcept;
+#else
+struct DispatchMark {};
+
+inline DispatchMark begin_dispatch(Method, std::string_view, const RequestId*) noexcept { return {}; }
+inline void end_dispatch(const DispatchMark&, int) noexcept {}
+inline void count_parsed(size_t, size_t) noexcept {}
+inline void count_parse_error() noexcept {}
+inline void count_serialized(size_t, size_t) noexcept {}
+#endif
+
+} // namespace detail
+
+} // namespace mcp
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace mcp {
+
+/// Unbounded multi-producer, single-consumer queue.
+///
+/// push() is a single CAS on the head of an intrusive list, so producers
+/// never block each other or the consumer. The consumer takes everything
+/// queued so far with one exchange and restores FIFO order, which suits
+/// writers that flush whatever has accumulated in one batch.
+template<typename T>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    ~MpscQueue() {
+        Node* n = head_.load(std::memory_order_acquire);
+        while (n) delete std::exchange(n, n->next);
+    }
+
+    /// Enqueue `value`. Returns true if the queue was empty, i.e. the
+    /// consumer may be idle and needs waking.
+    bool push(T value) {
+        Node* node = new Node{std::move(value), head_.load(std::memory_order_relaxed)};
+        while (!head_.compare_exchange_weak(node->next, node,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+        return node->next == nullptr;
+    }
+
+    /// Consumer only: append every queued item to `out` (a vector or
+    /// deque) in push order. Returns the number of items taken.
+    template<typename Container>
+    size_t drain_into(Container& out) {
+        Node* n = head_.exchange(nullptr, std::memory_order_acquire);
+        // The list is newest-first; reverse it in place
+        Node* fifo = nullptr;
+        size_t count = 0;
+        while (n) {
+            Node* next = n->next;
+            n->next = fifo;
+            fifo = n;
+            n = next;
+            ++count;
+        }
+        if constexpr (requires { out.reserve(count); }) out.reserve(out.size() + count);
+        while (fifo) {
+            out.push_back(std::move(fifo->value));
+            delete std::exchange(fifo, fifo->next);
+        }
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> head_{nullptr};
+};
+
+} // namespace mcp
@@ -0,0 +1,160 @@
+#pragma once
+#include "json_rpc.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mcp {
+
+/// Open-addressing hash table keyed on RequestId, for in-flight requests.
+///
+/// Slots are one flat array probed linearly and erased by backward shift, so
+/// there are no tombstones and no per-entry nodes: once the table has grown
+/// to the peak number of requests in flight, integer-keyed inserts and
+/// erases allocate nothing. Not thread-safe; callers hold their own lock.
+template<typename V>
+class RequestTable {
+public:
+    explicit RequestTable(size_t capacity = 0) { reserve(capacity); }
+
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    /// Make room for `n` entries without rehashing.
+    void reserve(size_t n) {
+        size_t want = 16;
+        while (want / 2 < n) want *= 2;  // keep the load factor at most 1/2
+        if (want > slots_.size()) rehash(want);
+    }
+
+    /// Insert or replace the entry for `id`.
+    V& insert(RequestId id, V value) {
+        if ((size_ + 1) * 2 > slots_.size()) rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        size_t i = probe(id);
+        Slot& s = slots_[i];
+        if (s.value) {
+            *s.value = std::move(value);
+        } else {
+            s.key = std::move(id);
+            s.value.emplace(std::move(value));
+            ++size_;
+        }
+        return *s.value;
+    }
+
+    [[nodiscard]] V* find(const RequestId& id) {
+        if (slots_.empty()) return nullptr;
+        Slot& s = slots_[probe(id)];
+        return s.value ? &*s.value : nullptr;
+    }
+
+    [[nodiscard]] bool contains(const RequestId& id) const {
+        return !slots_.empty() && slots_[probe(id)].value.has_value();
+    }
+
+    /// Remove the entry for `id` and return its value, if there was one.
+    std::optional<V> take(const RequestId& id) {
+        if (slots_.empty()) return std::nullopt;
+        size_t i = probe(id);
+        if (!slots_[i].value) return std::nullopt;
+        std::optional<V> out = std::move(slots_[i].value);
+        erase_at(i);
+        return out;
+    }
+
+    bool erase(const RequestId& id) { return take(id).has_value(); }
+
+    /// Remove every entry for which `pred(id, value)` holds.
+    template<typename Pred>
+    void erase_if(Pred pred) {
+        for (size_t i = 0; i < slots_.size(); ) {
+            Slot& s = slots_[i];
+            // erase_at() may shift a later entry into slot i; look again
+            if (s.value && pred(std::as_const(s.key), *s.value)) erase_at(i);
+            else ++i;
+        }
+    }
+
+    template<typename F>
+    void for_each(F f) {
+        for (auto& s : slots_) {
+            if (s.value) f(std::as_const(s.key), *s.value);
+        }
+    }
+
+    /// Remove and return every value, leaving the capacity in place.
+    std::vector<V> take_all() {
+        std::vector<V> out;
+        out.reserve(size_);
+        for (auto& s : slots_) {
+            if (s.value) {
+                out.push_back(std::move(*s.value));
+                s.value.reset();
+            }
+        }
+        size_ = 0;
+        return out;
+    }
+
+private:
+    struct Slot {
+        RequestId key;
+        std::optional<V> value;  // empty slot if unset
+    };
+
+    static size_t hash(const RequestId& id) {
+        if (auto* i = std::get_if<int64_t>(&id)) {
+            // Ids are usually sequential; mix them so they spread (splitmix64)
+            uint64_t x = static_cast<uint64_t>(*i) + 0x9e3779b97f4a7c15ull;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return static_cast<size_t>(x ^ (x >> 31));
+        }
+        return std::hash<std::string>{}(std::get<std::string>(id));
+    }
+
+    size_t mask() const { return slots_.size() - 1; }
+
+    // Slot holding `id`, or the empty slot where it would go
+    size_t probe(const RequestId& id) const {
+        size_t i = hash(id) & mask();
+        while (slots_[i].value && slots_[i].key != id) i = (i + 1) & mask();
+        return i;
+    }
+
+    void erase_at(size_t hole) {
+        slots_[hole].value.reset();
+        --size_;
+        // Shift back later entries of the probe run that may move into the hole
+        for (size_t j = (hole + 1) & mask(); slots_[j].value; j = (j + 1) & mask()) {
+            size_t home = hash(slots_[j].key) & mask();
+            // Movable unless its home lies cyclically in (hole, j]
+            bool stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (stays) continue;
+            slots_[hole].key = std::move(slots_[j].key);
+            slots_[hole].value = std::move(slots_[j].value);
+            slots_[j].value.reset();
+            hole = j;
+        }
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(slots_);
+        for (auto& s : old) {
+            if (!s.value) continue;
+            Slot& dst = slots_[probe(s.key)];
+            dst.key = std::move(s.key);
+            dst.value = std::move(s.value);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+} // namespace mcp
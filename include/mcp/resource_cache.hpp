@@ -0,0 +1,89 @@
+#pragma once
+#include "mcp/types.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mcp {
+
+/// Bytes a cached value is charged against the budget.
+[[nodiscard]] size_t cache_cost(const std::string& text);
+[[nodiscard]] size_t cache_cost(const std::vector<ResourceContent>& contents);
+
+/// resources/read results by URI, bounded by total bytes and evicted least
+/// recently used first. Entries may also expire after a TTL. Values are
+/// shared, never copied, by get().
+///
+/// A read that misses takes a stamp() before running the handler and passes
+/// it to put(); if the URI (or the whole cache) was invalidated meanwhile
+/// the result is dropped instead of caching content that is already stale.
+/// Thread-safe.
+template<typename T>
+class BasicResourceCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        // Budget for cached values plus keys; 0 disables the cache.
+        size_t max_bytes = 0;
+        // Lifetime of an entry; 0 keeps it until invalidated or evicted.
+        std::chrono::milliseconds ttl{0};
+    };
+
+    explicit BasicResourceCache(Options opts) : opts_(opts) {}
+
+    [[nodiscard]] bool enabled() const noexcept { return opts_.max_bytes > 0; }
+
+    /// Cached value for `uri`, or null on a miss or an expired entry.
+    [[nodiscard]] std::shared_ptr<const T> get(const std::string& uri,
+                                               Clock::time_point now = Clock::now());
+
+    /// Token to pass to put() for a read starting now.
+    [[nodiscard]] uint64_t stamp() const;
+
+    /// Cache `value` for `uri` unless it was invalidated since `stamp` or is
+    /// larger than the whole budget.
+    void put(const std::string& uri, std::shared_ptr<const T> value, uint64_t stamp,
+             Clock::time_point now = Clock::now());
+
+    void invalidate(const std::string& uri);
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] size_t bytes() const;
+
+private:
+    struct Entry {
+        std::string uri;
+        std::shared_ptr<const T> value;
+        size_t cost;                // uri plus cache_cost(*value)
+        Clock::time_point expires;  // max() if the entry doesn't expire
+    };
+    using List = std::list<Entry>;
+
+    void erase(typename List::iterator it);
+
+    const Options opts_;
+    mutable std::mutex mutex_;
+    List lru_;  // most recently used first
+    std::unordered_map<std::string, typename List::iterator> index_;
+    size_t bytes_ = 0;
+    // Bumped by every invalidation; a put() with an older stamp is dropped
+    uint64_t epoch_ = 0;
+};
+
+extern template class BasicResourceCache<std::string>;
+extern template class BasicResourceCache<std::vector<ResourceContent>>;
+
+/// Serialized results, as the server answers from them.
+using ResourceCache = BasicResourceCache<std::string>;
+/// Parsed results, as the client returns them.
+using ResourceContentCache = BasicResourceCache<std::vector<ResourceContent>>;
+
+} // namespace mcp
@@ -1,32 +1,110 @@
 #pragma once
 #include "types.hpp"
 #include "json_rpc.hpp"
+#include "async.hpp"
+#include "method.hpp"
+#include "snapshot.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <unordered_map>
 #include <string>
-#include <mutex>
+#include <string_view>
 
 namespace mcp {
 
 // Forward declaration
 class Session;
 
-using HandlerResult = std::variant<nlohmann::json, JsonRpcError>;
+using HandlerResult =
+    std::variant<nlohmann::json, JsonRpcError, RawJson, SharedJson, StreamedJson>;
 using RequestHandler = std::function<HandlerResult(const nlohmann::json& params)>;
 using NotificationHandler = std::function<void(const nlohmann::json& params)>;
 
+/// One-shot completion handle for asynchronous request handlers.
+/// Copies share state and may be invoked from any thread; the first call
+/// wins and later calls are ignored. If every copy is destroyed without
+/// responding, the request fails with InternalError so the peer is never
+/// left waiting forever.
+class Responder {
+public:
+    using Callback = std::function<void(HandlerResult)>;
+
+    explicit Responder(Callback cb);
+
+    void operator()(HandlerResult result) const;
+
+    /// True once a result has been delivered.
+    [[nodiscard]] bool done() const noexcept;
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+using AsyncRequestHandler = std::function<void(const nlohmann::json& params, Responder respond)>;
+using ReplyCallback = std::function<void(JsonRpcMessage response)>;
+/// Passthrough handler: receives the params text as it arrived and returns
+/// pre-serialized result JSON, so neither side is built as a DOM. Throw
+/// McpProtocolError to fail the request.
+using RawRequestHandler = std::function<RawJson(std::string_view params)>;
+/// Completion-based handler that sees params before they are parsed;
+/// use params.raw() for the wire text or *params for a DOM. Takes params by
+/// value so a dispatched rvalue message moves them in.
+using RawAsyncRequestHandler = std::function<void(LazyJson params, Responder respond)>;
+/// Coroutine request handler. Takes params by value: the frame outlives dispatch.
+using CoRequestHandler = std::function<CoTask<HandlerResult>(nlohmann::json params)>;
+
 class Router {
 public:
     /// Register a request handler for a method.
     void on_request(const std::string& method, RequestHandler handler);
 
+    /// Register a completion-based request handler. The handler may return
+    /// before responding and complete the request later from any thread.
+    void on_request_async(const std::string& method, AsyncRequestHandler handler);
+
+    /// Register a passthrough handler (see RawRequestHandler). Named
+    /// separately from on_request because a generic lambda would match both.
+    void on_request_raw(const std::string& method, RawRequestHandler handler);
+    void on_request_raw(const std::string& method, RawAsyncRequestHandler handler);
+
+    /// Register a coroutine request handler; it may co_await outbound calls
+    /// without holding a thread. Exceptions become error responses.
+    void on_request_co(const std::string& method, CoRequestHandler handler);
+
     /// Register a notification handler.
     void on_notification(const std::string& method, NotificationHandler handler);
 
     /// Dispatch an incoming message. Returns response if applicable.
+    /// Blocks until asynchronous handlers complete.
+    ///
+    /// Passing the message as an rvalue moves its params into handlers that
+    /// take ownership (coroutine and raw async handlers); a const message is
+    /// copied for those. Handlers that read params by reference never copy.
+    ///
+    /// `session` is the peer the message came from, if the caller keeps
+    /// state per peer; handlers find it with current_session().
     [[nodiscard]] std::optional<JsonRpcMessage> dispatch(const JsonRpcMessage& msg,
-                                            const Session* session = nullptr);
+                                            Session* session = nullptr);
+    [[nodiscard]] std::optional<JsonRpcMessage> dispatch(JsonRpcMessage&& msg,
+                                            Session* session = nullptr);
+
+    /// Dispatch without waiting: `reply` is called exactly once for each
+    /// request, possibly later and on another thread, and never for
+    /// notifications or responses.
+    void dispatch(const JsonRpcMessage& msg, ReplyCallback reply,
+                  Session* session = nullptr);
+    void dispatch(JsonRpcMessage&& msg, ReplyCallback reply,
+                  Session* session = nullptr);
+
+    /// The session passed to the dispatch whose handler is running on this
+    /// thread, or null. Set only while the handler itself runs: an
+    /// asynchronous handler that needs it later must keep it.
+    [[nodiscard]] static Session* current_session() noexcept;
 
     /// Set required capability for a method (enforced during dispatch).
     void require_capability(const std::string& method, const std::string& capability);
@@ -38,14 +116,56 @@ public:
     [[nodiscard]] bool has_handler(const std::string& method) const;
 
 private:
-    bool check_capability(const std::string& method) const;
-
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, RequestHandler> request_handlers_;
-    std::unordered_map<std::string, NotificationHandler> notification_handlers_;
-    std::unordered_map<std::string, std::string> capability_requirements_;
-    ServerCapabilities server_caps_;
-    ClientCapabilities client_caps_;
+    struct RequestEntry {
+        RequestHandler sync;
+        AsyncRequestHandler async;
+        RawRequestHandler raw;
+        RawAsyncRequestHandler raw_async;
+        // Shared so a suspended coroutine keeps its handler alive
+        std::shared_ptr<const CoRequestHandler> co;
+
+        [[nodiscard]] bool empty() const noexcept {
+            return !sync && !async && !raw && !raw_async && !co;
+        }
+    };
+
+    // Handler tables, replaced wholesale on registration so dispatch reads
+    // them without a lock. Standard methods are indexed by their interned
+    // id; the maps hold custom methods only.
+    struct Tables {
+        std::array<RequestEntry, kMethodCount> standard_requests;
+        std::array<NotificationHandler, kMethodCount> standard_notifications;
+        std::unordered_map<std::string, RequestEntry> request_handlers;
+        std::unordered_map<std::string, NotificationHandler> notification_handlers;
+        // Capability bits a method needs (0: none)
+        std::array<uint32_t, kMethodCount> standard_requirements{};
+        std::unordered_map<std::string, uint32_t> capability_requirements;
+
+        // Entry for `method`: a table slot for standard methods, else a map node.
+        RequestEntry& request_slot(const std::string& method);
+    };
+
+    void set_request(const std::string& method, RequestEntry entry);
+    bool check_capability(const Tables& tables, Method id, const std::string& method) const;
+    // Looks up the handler in `tables`; returns an error response if the
+    // request can't run. `out` points into `tables`.
+    std::optional<JsonRpcResponse> resolve(const Tables& tables, const JsonRpcRequest& req,
+                                           const RequestEntry*& out) const;
+    static JsonRpcResponse invoke(const RequestHandler& handler, const RequestId& id,
+                                  const nlohmann::json& params);
+    // Runs whichever handler `entry` holds; `reply` gets the response.
+    // Params are moved into owning handlers when `Request` is an rvalue.
+    template<typename Request>
+    static void invoke(const RequestEntry& entry, Request&& req, ReplyCallback reply);
+
+    // Bodies of the dispatch overloads; `Message` carries the value category.
+    template<typename Message>
+    std::optional<JsonRpcMessage> dispatch_and_wait(Message&& msg, Session* session);
+    template<typename Message>
+    void dispatch_with(Message&& msg, ReplyCallback reply, Session* session);
+
+    CowSnapshot<Tables> tables_;
+    std::atomic<uint32_t> granted_capabilities_{0};
 };
 
 } // namespace mcp
@@ -0,0 +1,40 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mcp {
+
+/// JSON Schema compiled once into a flat program of nodes, so checking a
+/// value is a walk over it with no keyword lookups or schema traversal.
+///
+/// Covers the vocabulary tool schemas use: type, enum, const, properties,
+/// required, additionalProperties, min/maxProperties, items, prefixItems,
+/// min/maxItems, uniqueItems, minimum, maximum, exclusiveMinimum/Maximum,
+/// multipleOf, min/maxLength, pattern, allOf, anyOf, oneOf, not, and $ref to
+/// a JSON pointer within the same schema ("#/$defs/..."). Other keywords
+/// are annotations and ignored; "format" is not asserted. Copies share the
+/// program and may be used from any thread.
+class SchemaValidator {
+public:
+    /// Throws std::invalid_argument for a malformed schema, an invalid
+    /// pattern, or a $ref that doesn't resolve.
+    explicit SchemaValidator(const nlohmann::json& schema);
+
+    /// The first violation as "<json pointer>: <reason>" (just the reason
+    /// at the root), or nullopt if `value` conforms.
+    [[nodiscard]] std::optional<std::string> validate(const nlohmann::json& value) const;
+
+    /// As validate(), reading JSON text in one pass without building a DOM.
+    /// Only subvalues checked by enum, const, uniqueItems, allOf, anyOf,
+    /// oneOf or not are parsed. Malformed text is a violation.
+    [[nodiscard]] std::optional<std::string> validate_text(std::string_view json) const;
+
+private:
+    struct Program;
+    std::shared_ptr<const Program> program_;
+};
+
+} // namespace mcp
@@ -1,39 +1,50 @@
 #pragma once
 #include "types.hpp"
 #include "json_rpc.hpp"
+#include "async.hpp"
+#include "executor.hpp"
+#include "router.hpp"
+#include "schema.hpp"
+#include "json_writer.hpp"
+#include "tool_args.hpp"
+#include "uri_template.hpp"
 #include "transport/transport.hpp"
 #include <atomic>
 #include <functional>
 #include <future>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <optional>
+#include <span>
 #include <chrono>
 
 namespace mcp {
 
-/// Token that tool handlers can check to detect cancellation.
-/// Passed by shared_ptr so the server can signal cancellation after dispatch.
-class CancellationToken {
-public:
-    CancellationToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
-
-    /// Check whether cancellation has been requested.
-    [[nodiscard]] bool is_cancelled() const noexcept { return cancelled_->load(); }
-
-    /// Request cancellation (called internally by the server).
-    void cancel() noexcept { cancelled_->store(true); }
-
-private:
-    std::shared_ptr<std::atomic<bool>> cancelled_;
-};
-
 /// Callback types
 using ToolHandler = std::function<CallToolResult(const nlohmann::json& arguments)>;
+/// Gets the call's CancellationToken::current(); other handlers can ask for it.
 using CancellableToolHandler = std::function<CallToolResult(const nlohmann::json& arguments,
                                                              CancellationToken token)>;
 using ResourceReadHandler = std::function<std::vector<ResourceContent>(const std::string& uri)>;
+/// Template read handler; also gets the variables the URI matched.
+using ResourceTemplateHandler = std::function<std::vector<ResourceContent>(
+    const std::string& uri, const UriTemplateVars& vars)>;
+
+/// Content of a streamed resource read, pulled in chunks while the response
+/// is being written.
+struct ResourceStream {
+    std::optional<std::string> mime_type;
+    // Sent base64-encoded as "blob"; otherwise as UTF-8 "text"
+    bool binary = true;
+    // Fills up to `size` bytes of `buf` and returns how many; 0 at the end.
+    // Called from the transport's writer after the handler has returned.
+    std::function<size_t(char* buf, size_t size)> read;
+};
+using ResourceStreamHandler = std::function<ResourceStream(const std::string& uri)>;
+
 using PromptGetHandler = std::function<GetPromptResult(const std::string& name,
                                                         const nlohmann::json& arguments)>;
 using CompletionHandler = std::function<CompletionResult(const CompletionRef& ref,
@@ -41,14 +52,87 @@ using CompletionHandler = std::function<CompletionResult(const CompletionRef& re
                                                           const std::string& arg_value)>;
 using AsyncToolHandler = std::function<std::future<CallToolResult>(const nlohmann::json& arguments)>;
 
+/// Completion handle for callback-style asynchronous tools. Copyable and
+/// callable from any thread; the first completion wins. Dropping every copy
+/// without completing fails the call.
+class ToolResponder {
+public:
+    /// With `output_schema`, a result whose structured content doesn't
+    /// conform fails the call instead.
+    explicit ToolResponder(Responder respond,
+                           std::shared_ptr<const SchemaValidator> output_schema = nullptr)
+        : respond_(std::move(respond)), output_schema_(std::move(output_schema)) {}
+
+    /// Complete the call with a result.
+    void operator()(const CallToolResult& result) const;
+
+    /// Complete the call with an is_error result carrying `message`.
+    void fail(const std::string& message) const;
+
+    [[nodiscard]] bool done() const noexcept { return respond_.done(); }
+
+private:
+    Responder respond_;
+    std::shared_ptr<const SchemaValidator> output_schema_;
+};
+
+/// Tool handler that returns immediately and completes through `respond`,
+/// e.g. from a downstream RPC callback, without holding a thread.
+using CallbackToolHandler = std::function<void(const nlohmann::json& arguments,
+                                               ToolResponder respond)>;
+
+/// Coroutine tool handler: may co_await outbound requests (e.g.
+/// McpClient::call_tool_async) without holding a thread. Arguments are taken
+/// by value because the coroutine frame outlives the dispatch call.
+using CoroutineToolHandler = std::function<CoTask<CallToolResult>(nlohmann::json arguments)>;
+
+/// Passthrough tool: receives the `arguments` JSON text exactly as it
+/// arrived and returns a serialized CallToolResult, for tools that forward
+/// payloads verbatim. Neither side is parsed into a DOM by the server.
+using RawToolHandler = std::function<RawJson(std::string_view arguments)>;
+
 class McpServer {
 public:
     struct Options {
         Implementation server_info;
         std::optional<std::string> instructions;
+        // Worker threads for request dispatch. Requests run concurrently and
+        // responses go out as they complete; 0 dispatches on the transport's
+        // reader thread.
         int thread_pool_size = 4;
+        // Pin internal pool workers to CPUs.
+        bool pin_worker_threads = false;
+        // Run requests on this executor instead of an internal pool. It may
+        // be shared between servers; the server never shuts it down.
+        std::shared_ptr<IExecutor> executor;
         std::chrono::milliseconds request_timeout{30000};
         size_t page_size = 50;
+        // Most progress notifications per second for one token; 0 is
+        // unlimited. Updates in between are coalesced: the newest is sent
+        // when the interval ends, or just before the tool's result.
+        double max_progress_rate = 0;
+        // Most log notifications per second per logger; 0 is unlimited.
+        // The excess is dropped before any JSON is built.
+        double max_log_rate = 0;
+        // Keep serialized resources/read results by URI, up to this many
+        // bytes in all (0: no cache), least recently used evicted first.
+        // notify_resource_updated() drops a URI's entry, as does adding or
+        // removing that resource; resource_cache_ttl (0: none) caps its age.
+        size_t resource_cache_bytes = 0;
+        std::chrono::milliseconds resource_cache_ttl{0};
+        // Hold resources/updated notifications this long (0: send at once)
+        // and send each URI updated meanwhile once per subscriber, however
+        // many times it changed.
+        std::chrono::milliseconds resource_update_window{0};
+        // Check tools/call arguments against each tool's input_schema, and
+        // non-error results against its output_schema, with validators
+        // compiled when the tool is added. set_tool_validation() overrides
+        // this per tool.
+        bool validate_tool_schemas = false;
+        // Agree to a binary encoding a client offers in initialize (see
+        // McpClient::Options::wire_format) if the transport can send it.
+        // Transports shared by several sessions always send JSON.
+        bool accept_wire_formats = true;
     };
 
     explicit McpServer(Options opts);
@@ -61,13 +145,43 @@ public:
     // ---- Tool registration ----
     void add_tool(ToolDefinition def, ToolHandler handler);
     void add_tool(ToolDefinition def, CancellableToolHandler handler);
+    void add_tool_raw(ToolDefinition def, RawToolHandler handler);
+    /// Register a tool whose arguments bind straight from the wire text to
+    /// `Args` (a struct reflected with MCPXX_ARGS, see tool_args.hpp), with
+    /// no DOM in between. Binding checks member types and required members;
+    /// a failure is reported as an is_error result naming the member. If
+    /// def.input_schema is empty it is generated from `Args`.
+    template<typename Args, typename F>
+    void add_tool(ToolDefinition def, F handler);
+    // Blocks a worker on the returned future; prefer the callback overload.
     void add_tool_async(ToolDefinition def, AsyncToolHandler handler);
+    void add_tool_async(ToolDefinition def, CallbackToolHandler handler);
+    void add_tool_async(ToolDefinition def, CoroutineToolHandler handler);
     void remove_tool(const std::string& name);
+    /// Turn schema validation on or off for one tool, now if it is
+    /// registered and whenever it is added again. Throws
+    /// std::invalid_argument if enabling it and a schema doesn't compile.
+    void set_tool_validation(const std::string& name, bool enabled);
 
     // ---- Resource registration ----
     void add_resource(ResourceDefinition def, ResourceReadHandler handler);
+    /// Serve reads of def.uri from a stream, for resources too large to hold
+    /// in memory. Stdio and SSE responses write each chunk as it is read
+    /// (base64-encoded for binary content); a plain JSON response over HTTP
+    /// collects it first. Streamed reads are never cached. If `read` throws
+    /// part way, the response is abandoned.
+    void add_resource_stream(ResourceDefinition def, ResourceStreamHandler handler);
+    /// Serve reads of URIs matching tmpl.uri_template (RFC 6570, levels 1
+    /// and 2: {var}, {+var}, {#var}). When several templates match, literal
+    /// text beats a variable. Throws std::invalid_argument for a malformed
+    /// template.
     void add_resource_template(ResourceTemplate tmpl, ResourceReadHandler handler);
+    void add_resource_template(ResourceTemplate tmpl, ResourceTemplateHandler handler);
     void notify_resource_updated(const std::string& uri);
+    /// Tell the subscribers of each URI that it changed, matching them all
+    /// in one pass. A subscription whose URI ends in '*' (an mcpxx
+    /// extension) covers every URI starting with what precedes it.
+    void notify_resources_updated(std::span<const std::string> uris);
     void remove_resource(const std::string& uri);
 
     // ---- Prompt registration ----
@@ -80,6 +194,15 @@ public:
     // ---- Logging ----
     void log(LogLevel level, const std::string& logger, const nlohmann::json& data);
 
+    /// Like log(), but `make_data` is only called if the message will be sent.
+    template<typename F, typename = std::enable_if_t<std::is_invocable_r_v<nlohmann::json, F&>>>
+    void log(LogLevel level, const std::string& logger, F&& make_data) {
+        if (admit_log(level, logger)) send_log(level, logger, make_data());
+    }
+
+    /// True if messages at `level` would currently reach the client.
+    [[nodiscard]] bool log_enabled(LogLevel level) const noexcept;
+
     // ---- Progress ----
     void send_progress(const std::variant<int64_t, std::string>& token,
                        double progress, std::optional<double> total = std::nullopt,
@@ -87,25 +210,53 @@ public:
 
     // ---- Sampling (server->client) ----
     [[nodiscard]] SamplingResult request_sampling(const SamplingRequest& req);
-    [[nodiscard]] std::future<SamplingResult> request_sampling_async(const SamplingRequest& req);
+    // The *_async variants return without blocking; co_await the result from
+    // a CoTask or call get(). Either kind fails with McpTimeoutError after
+    // request_timeout.
+    [[nodiscard]] Async<SamplingResult> request_sampling_async(const SamplingRequest& req);
 
     // ---- Elicitation (server->client) ----
     [[nodiscard]] ElicitationResult request_elicitation(const ElicitationRequest& req);
+    [[nodiscard]] Async<ElicitationResult> request_elicitation_async(const ElicitationRequest& req);
 
     // ---- Roots (server->client) ----
     [[nodiscard]] std::vector<Root> request_roots();
+    [[nodiscard]] Async<std::vector<Root>> request_roots_async();
 
     // ---- Transport ----
     void serve_stdio();
     void serve_http(const std::string& host, uint16_t port);
+    /// Serve the client that launched this process with
+    /// McpClient::connect_shm(), over shared memory. Throws
+    /// McpTransportError if it wasn't launched that way.
+    void serve_shm();
     void serve(std::unique_ptr<ITransport> transport);
     void shutdown();
 
     [[nodiscard]] bool is_running() const noexcept;
 
 private:
+    // Level and rate checks for log(); consumes a rate slot when true.
+    bool admit_log(LogLevel level, const std::string& logger);
+    void send_log(LogLevel level, const std::string& logger, const nlohmann::json& data);
+
     struct Impl;
     std::unique_ptr<Impl> impl_;
 };
 
+template<typename Args, typename F>
+void McpServer::add_tool(ToolDefinition def, F handler) {
+    static_assert(std::is_invocable_r_v<CallToolResult, F&, Args&&>,
+                  "handler must be callable as CallToolResult(Args)");
+    if (def.input_schema.is_null() || def.input_schema.empty()) {
+        def.input_schema = args_schema<Args>();
+    }
+    add_tool_raw(std::move(def), [handler = std::move(handler)](std::string_view arguments) mutable {
+        RawJson out;
+        JsonWriter w(out.text);
+        write_json(w, static_cast<CallToolResult>(handler(parse_args<Args>(arguments))));
+        return out;
+    });
+}
+
 } // namespace mcp
@@ -1,11 +1,15 @@
 #pragma once
 #include "types.hpp"
 #include "json_rpc.hpp"
+#include "request_table.hpp"
 #include <map>
 #include <optional>
 #include <chrono>
 #include <functional>
 #include <mutex>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace mcp {
 
@@ -63,15 +67,27 @@ public:
 
     [[nodiscard]] bool has_pending_request(const RequestId& id) const;
 
+    /// Resource URIs the peer has subscribed to. subscribe() and
+    /// unsubscribe() return false if nothing changed.
+    bool subscribe(const std::string& uri);
+    bool unsubscribe(const std::string& uri);
+    [[nodiscard]] bool is_subscribed(const std::string& uri) const;
+    [[nodiscard]] std::vector<std::string> subscriptions() const;
+
+    /// Least severe log level the peer wants (logging/setLevel).
+    [[nodiscard]] LogLevel log_level() const;
+    void set_log_level(LogLevel level);
+
 private:
     mutable std::mutex mutex_;
     SessionState state_{SessionState::Uninitialized};
-    std::map<std::string, PendingRequest> pending_requests_str_;
-    std::map<int64_t, PendingRequest> pending_requests_int_;
+    RequestTable<PendingRequest> pending_requests_;
     ServerCapabilities server_caps_;
     ClientCapabilities client_caps_;
     std::string protocol_version_;
     std::optional<std::string> session_id_;
+    std::set<std::string> subscriptions_;
+    LogLevel log_level_{LogLevel::Info};
     int64_t next_id_{1};
     std::chrono::milliseconds request_timeout_{30000};
 };
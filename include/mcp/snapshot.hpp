@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace mcp {
+
+/// Copy-on-write holder for read-mostly state such as handler registries.
+///
+/// Readers load() an immutable snapshot with one atomic shared_ptr load and
+/// never touch the writers' mutex; the snapshot stays valid for as long as
+/// they hold it, even if a newer version is published meanwhile. Writers
+/// serialize on a mutex, copy the current version, change the copy and
+/// publish it, so keep T cheap to copy (e.g. maps of shared_ptr).
+template<typename T>
+class CowSnapshot {
+public:
+    CowSnapshot() : current_(std::make_shared<const T>()) {}
+
+    CowSnapshot(const CowSnapshot&) = delete;
+    CowSnapshot& operator=(const CowSnapshot&) = delete;
+
+    [[nodiscard]] std::shared_ptr<const T> load() const noexcept {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    /// Publish `mutate` applied to a copy of the current version. Returns
+    /// whatever `mutate` returns.
+    template<typename F>
+    decltype(auto) update(F&& mutate) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto next = std::make_shared<T>(*current_.load(std::memory_order_relaxed));
+        if constexpr (std::is_void_v<decltype(mutate(*next))>) {
+            std::forward<F>(mutate)(*next);
+            current_.store(std::move(next), std::memory_order_release);
+        } else {
+            auto result = std::forward<F>(mutate)(*next);
+            current_.store(std::move(next), std::memory_order_release);
+            return result;
+        }
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>> current_;
+    std::mutex write_mutex_;
+};
+
+} // namespace mcp
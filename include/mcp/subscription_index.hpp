@@ -0,0 +1,57 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mcp {
+
+/// Which subscribers want to hear about a resource URI.
+///
+/// A pattern is either an exact URI or, if it ends in '*', a prefix: a
+/// subscription to "file:///logs/*" matches every URI under that path, and
+/// "*" alone matches them all. Prefixes live in a trie keyed by character,
+/// so a lookup costs the length of the URI however many patterns there are.
+/// Not synchronized: the owner's lock guards it.
+class SubscriptionIndex {
+public:
+    SubscriptionIndex();
+    ~SubscriptionIndex();
+    SubscriptionIndex(SubscriptionIndex&&) noexcept;
+    SubscriptionIndex& operator=(SubscriptionIndex&&) noexcept;
+
+    /// False if `subscriber` already had `pattern`.
+    bool add(std::string_view pattern, const std::string& subscriber);
+    /// False if `subscriber` didn't have `pattern`.
+    bool remove(std::string_view pattern, const std::string& subscriber);
+
+    /// Appends the subscribers of every pattern matching `uri` to `out`.
+    /// One subscribed both exactly and by prefix appears more than once.
+    /// The pointers stay valid until the index is next changed.
+    void collect(std::string_view uri, std::vector<const std::string*>& out) const;
+
+    /// The subscribers matching `uri`, sorted and without repeats.
+    [[nodiscard]] std::vector<std::string> match(std::string_view uri) const;
+
+    [[nodiscard]] bool empty() const noexcept;
+    void clear();
+
+private:
+    struct Node {
+        std::map<char, std::unique_ptr<Node>> children;
+        std::set<std::string> subscribers;
+    };
+
+    static bool is_prefix(std::string_view pattern) {
+        return !pattern.empty() && pattern.back() == '*';
+    }
+
+    std::unordered_map<std::string, std::set<std::string>> exact_;
+    std::unique_ptr<Node> root_;  // prefix patterns, '*' stripped
+    size_t prefixes_ = 0;         // patterns held in the trie
+};
+
+} // namespace mcp
@@ -0,0 +1,88 @@
+#pragma once
+#include "executor.hpp"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcp {
+
+/// Hierarchical timer wheel for request deadlines.
+///
+/// Four levels of 64 slots each; a timer sits in the coarsest level that
+/// still tells it apart from its neighbours and is cascaded down as its
+/// deadline approaches. Scheduling and cancelling are O(1), and a tick
+/// touches one slot, however many timers are pending. Timers are pooled
+/// nodes, so steady-state scheduling does not allocate.
+///
+/// start() drives the wheel from its own thread; alternatively an event
+/// loop can call advance() itself. Callbacks run on the driving thread,
+/// outside the wheel's lock, so they may schedule or cancel timers.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    /// Opaque handle; 0 is never a valid timer.
+    using TimerId = uint64_t;
+
+    explicit TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(10));
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /// Run `fn` once `delay` has passed (rounded up to the resolution).
+    TimerId schedule(std::chrono::milliseconds delay, Task fn);
+
+    /// Stop a pending timer. False if it already fired or was cancelled.
+    bool cancel(TimerId id);
+
+    /// Fire every timer due by `now`. Returns the number fired.
+    size_t advance(Clock::time_point now = Clock::now());
+
+    /// Start / stop the driver thread. Unfired timers stay scheduled.
+    void start();
+    void stop();
+
+    [[nodiscard]] size_t pending() const;
+
+private:
+    static constexpr unsigned kLevelBits = 6;
+    static constexpr uint32_t kSlots = 1u << kLevelBits;
+    static constexpr unsigned kLevels = 4;
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Node {
+        Task fn;
+        uint64_t expiry = 0;      // in ticks
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t generation = 0;  // bumped on release, so stale ids miss
+        uint32_t* slot = nullptr; // list head while scheduled
+    };
+
+    uint64_t ticks_since_epoch(Clock::time_point t) const;
+    void place(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    // Advances one tick and moves the timers due on it into `due`
+    void step(std::vector<Task>& due);
+    void run();
+
+    const std::chrono::milliseconds resolution_;
+    const Clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t now_ = 0;  // last tick processed
+    std::array<std::array<uint32_t, kSlots>, kLevels> wheel_;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    size_t pending_ = 0;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace mcp
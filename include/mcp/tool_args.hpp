@@ -0,0 +1,318 @@
+#pragma once
+#include "error.hpp"
+#include <nlohmann/json.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace mcp {
+
+/// One value of a JSON document being pulled from its text (simdjson
+/// on-demand underneath), so nothing is built in between. A JsonValue is
+/// valid only inside the callback it was passed to, and each one may be
+/// read once. Reading the wrong type throws
+/// McpProtocolError(InvalidParams, "expected <type>"); malformed text
+/// throws McpParseError.
+class JsonValue {
+public:
+    enum class Type { Object, Array, Number, String, Bool, Null };
+
+    [[nodiscard]] Type type() const;
+    [[nodiscard]] bool get_bool() const;
+    [[nodiscard]] int64_t get_int64() const;
+    [[nodiscard]] uint64_t get_uint64() const;
+    [[nodiscard]] double get_double() const;
+    /// Unescaped text; valid until the next read from the document.
+    [[nodiscard]] std::string_view get_string() const;
+    /// The value's text as it appears in the document.
+    [[nodiscard]] std::string_view raw_json() const;
+
+    /// Call f(std::string_view key, JsonValue value) for each member.
+    template<typename F>
+    void for_each_member(F&& f) const {
+        visit_members([](void* ctx, std::string_view key, JsonValue v) {
+            (*static_cast<std::remove_reference_t<F>*>(ctx))(key, v);
+        }, context(f));
+    }
+
+    /// Call f(JsonValue element) for each element.
+    template<typename F>
+    void for_each_element(F&& f) const {
+        visit_elements([](void* ctx, JsonValue v) {
+            (*static_cast<std::remove_reference_t<F>*>(ctx))(v);
+        }, context(f));
+    }
+
+    /// Parse `json` and call f(JsonValue root). The root must be an object
+    /// or array.
+    template<typename F>
+    static void read(std::string_view json, F&& f) {
+        visit_document(json, [](void* ctx, JsonValue v) {
+            (*static_cast<std::remove_reference_t<F>*>(ctx))(v);
+        }, context(f));
+    }
+
+private:
+    using MemberFn = void (*)(void* ctx, std::string_view key, JsonValue value);
+    using ElementFn = void (*)(void* ctx, JsonValue value);
+
+    explicit JsonValue(void* impl) noexcept : impl_(impl) {}
+
+    template<typename F>
+    static void* context(F& f) noexcept {
+        return const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+    }
+
+    void visit_members(MemberFn fn, void* ctx) const;
+    void visit_elements(ElementFn fn, void* ctx) const;
+    static void visit_document(std::string_view json, ElementFn fn, void* ctx);
+
+    void* impl_;  // simdjson::ondemand::value
+};
+
+/// How a C++ type is read from tool arguments and described in the
+/// generated input schema. Specialize for your own types; structs are
+/// covered by MCPXX_ARGS.
+template<typename T, typename = void>
+struct ArgTraits;
+
+namespace detail {
+
+// A reflected member: its JSON name and pointer
+template<typename T, typename M>
+struct ArgField {
+    std::string_view name;
+    M T::*member;
+};
+
+// Raised while binding, with the path of the offending member
+struct ArgBindError {
+    std::string path;
+    std::string message;
+};
+
+template<typename T>
+struct IsOptional : std::false_type {};
+template<typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template<typename T>
+using ArgFieldsOf = decltype(mcpxx_arg_fields(static_cast<const T*>(nullptr)));
+
+template<typename T, typename = void>
+struct HasArgFields : std::false_type {};
+template<typename T>
+struct HasArgFields<T, std::void_t<ArgFieldsOf<T>>> : std::true_type {};
+
+template<typename T>
+T read_integer(JsonValue v) {
+    if constexpr (std::is_signed_v<T>) {
+        int64_t i = v.get_int64();
+        if (i < std::numeric_limits<T>::min() || i > std::numeric_limits<T>::max()) {
+            throw McpProtocolError(error::InvalidParams, "out of range");
+        }
+        return static_cast<T>(i);
+    } else {
+        uint64_t u = v.get_uint64();
+        if (u > std::numeric_limits<T>::max()) {
+            throw McpProtocolError(error::InvalidParams, "out of range");
+        }
+        return static_cast<T>(u);
+    }
+}
+
+} // namespace detail
+
+template<>
+struct ArgTraits<bool> {
+    static void read(JsonValue v, bool& out) { out = v.get_bool(); }
+    static nlohmann::json schema() { return {{"type", "boolean"}}; }
+};
+
+template<typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    static void read(JsonValue v, T& out) { out = detail::read_integer<T>(v); }
+    static nlohmann::json schema() { return {{"type", "integer"}}; }
+};
+
+template<typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static void read(JsonValue v, T& out) { out = static_cast<T>(v.get_double()); }
+    static nlohmann::json schema() { return {{"type", "number"}}; }
+};
+
+template<>
+struct ArgTraits<std::string> {
+    static void read(JsonValue v, std::string& out) { out = v.get_string(); }
+    static nlohmann::json schema() { return {{"type", "string"}}; }
+};
+
+/// Any JSON at all, parsed into a DOM.
+template<>
+struct ArgTraits<nlohmann::json> {
+    static void read(JsonValue v, nlohmann::json& out) { out = nlohmann::json::parse(v.raw_json()); }
+    static nlohmann::json schema() { return nlohmann::json::object(); }
+};
+
+/// Not required; null reads as empty.
+template<typename T>
+struct ArgTraits<std::optional<T>> {
+    static void read(JsonValue v, std::optional<T>& out) {
+        if (v.type() == JsonValue::Type::Null) {
+            out.reset();
+            return;
+        }
+        ArgTraits<T>::read(v, out.emplace());
+    }
+    static nlohmann::json schema() { return ArgTraits<T>::schema(); }
+};
+
+template<typename T>
+struct ArgTraits<std::vector<T>> {
+    static void read(JsonValue v, std::vector<T>& out) {
+        out.clear();
+        v.for_each_element([&out](JsonValue element) {
+            try {
+                ArgTraits<T>::read(element, out.emplace_back());
+            } catch (const McpProtocolError& e) {
+                throw detail::ArgBindError{"[" + std::to_string(out.size() - 1) + "]", e.what()};
+            } catch (detail::ArgBindError& e) {
+                e.path = "[" + std::to_string(out.size() - 1) + "]" + (e.path[0] == '[' ? "" : ".") + e.path;
+                throw;
+            }
+        });
+    }
+    static nlohmann::json schema() { return {{"type", "array"}, {"items", ArgTraits<T>::schema()}}; }
+};
+
+/// Structs reflected with MCPXX_ARGS. Members that aren't std::optional are
+/// required; unknown keys are ignored.
+template<typename T>
+struct ArgTraits<T, std::enable_if_t<detail::HasArgFields<T>::value>> {
+    static void read(JsonValue v, T& out) {
+        constexpr auto fields = mcpxx_arg_fields(static_cast<const T*>(nullptr));
+        constexpr size_t count = std::tuple_size_v<std::remove_const_t<decltype(fields)>>;
+        static_assert(count <= 64, "MCPXX_ARGS supports up to 64 members");
+
+        uint64_t seen = 0;
+        v.for_each_member([&](std::string_view key, JsonValue value) {
+            std::apply([&](const auto&... field) {
+                size_t index = 0;
+                (void)((field.name == key ? (read_field(field, value, out), seen |= uint64_t{1} << index, true)
+                                          : (++index, false)) || ...);
+            }, fields);
+        });
+
+        std::apply([&](const auto&... field) {
+            size_t index = 0;
+            (check_present(field, seen, index++), ...);
+        }, fields);
+    }
+
+    static nlohmann::json schema() {
+        constexpr auto fields = mcpxx_arg_fields(static_cast<const T*>(nullptr));
+        nlohmann::json properties = nlohmann::json::object();
+        nlohmann::json required = nlohmann::json::array();
+        std::apply([&](const auto&... field) {
+            ((properties[std::string(field.name)] = ArgTraits<member_type<decltype(field)>>::schema(),
+              is_required<decltype(field)>() ? required.push_back(std::string(field.name)) : void()), ...);
+        }, fields);
+        nlohmann::json s = {{"type", "object"}, {"properties", std::move(properties)}};
+        if (!required.empty()) s["required"] = std::move(required);
+        return s;
+    }
+
+private:
+    template<typename Field>
+    using member_type = std::remove_cv_t<std::remove_reference_t<
+        decltype(std::declval<T&>().*(std::declval<Field>().member))>>;
+
+    template<typename Field>
+    static constexpr bool is_required() { return !detail::IsOptional<member_type<Field>>::value; }
+
+    template<typename Field>
+    static void read_field(const Field& field, JsonValue value, T& out) {
+        try {
+            ArgTraits<member_type<Field>>::read(value, out.*(field.member));
+        } catch (const McpProtocolError& e) {
+            throw detail::ArgBindError{std::string(field.name), e.what()};
+        } catch (detail::ArgBindError& e) {
+            e.path = std::string(field.name) + (e.path[0] == '[' ? "" : ".") + e.path;
+            throw;
+        }
+    }
+
+    template<typename Field>
+    static void check_present(const Field& field, uint64_t seen, size_t index) {
+        if (is_required<Field>() && !(seen & (uint64_t{1} << index))) {
+            throw detail::ArgBindError{std::string(field.name), "required"};
+        }
+    }
+};
+
+/// Bind tool arguments, given as JSON text, to T without building a DOM.
+/// Throws McpProtocolError(InvalidParams) naming the offending member, or
+/// McpParseError for malformed text.
+template<typename T>
+[[nodiscard]] T parse_args(std::string_view json) {
+    T out{};
+    try {
+        JsonValue::read(json, [&out](JsonValue root) { ArgTraits<T>::read(root, out); });
+    } catch (const detail::ArgBindError& e) {
+        throw McpProtocolError(error::InvalidParams,
+                               "Invalid argument '" + e.path + "': " + e.message);
+    }
+    return out;
+}
+
+/// JSON Schema of T as generated for ToolDefinition::input_schema.
+template<typename T>
+[[nodiscard]] nlohmann::json args_schema() {
+    return ArgTraits<T>::schema();
+}
+
+} // namespace mcp
+
+// ---- Member reflection ----
+
+#define MCPXX_DETAIL_EXPAND(x) x
+#define MCPXX_DETAIL_FIELD(T, m) ::mcp::detail::ArgField<T, decltype(T::m)>{#m, &T::m}
+#define MCPXX_DETAIL_F1(T, m) MCPXX_DETAIL_FIELD(T, m)
+#define MCPXX_DETAIL_F2(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F1(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F3(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F2(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F4(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F3(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F5(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F4(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F6(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F5(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F7(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F6(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F8(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F7(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F9(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F8(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F10(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F9(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F11(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F10(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F12(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F11(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F13(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F12(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F14(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F13(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F15(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F14(T, __VA_ARGS__))
+#define MCPXX_DETAIL_F16(T, m, ...) MCPXX_DETAIL_FIELD(T, m), MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_F15(T, __VA_ARGS__))
+#define MCPXX_DETAIL_PICK(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, NAME, ...) NAME
+#define MCPXX_DETAIL_FIELDS(T, ...)                                                              \
+    MCPXX_DETAIL_EXPAND(MCPXX_DETAIL_PICK(__VA_ARGS__, MCPXX_DETAIL_F16, MCPXX_DETAIL_F15,      \
+        MCPXX_DETAIL_F14, MCPXX_DETAIL_F13, MCPXX_DETAIL_F12, MCPXX_DETAIL_F11, MCPXX_DETAIL_F10, \
+        MCPXX_DETAIL_F9, MCPXX_DETAIL_F8, MCPXX_DETAIL_F7, MCPXX_DETAIL_F6, MCPXX_DETAIL_F5,      \
+        MCPXX_DETAIL_F4, MCPXX_DETAIL_F3, MCPXX_DETAIL_F2, MCPXX_DETAIL_F1)(T, __VA_ARGS__))
+
+/// Make a struct's members (up to 16) bindable as tool arguments, keyed by
+/// member name. Use at namespace scope, in the struct's own namespace:
+///
+///     struct SearchArgs { std::string query; std::optional<int> limit; };
+///     MCPXX_ARGS(SearchArgs, query, limit)
+#define MCPXX_ARGS(Type, ...)                                                  \
+    [[maybe_unused]] constexpr auto mcpxx_arg_fields(const Type*) {            \
+        return std::make_tuple(MCPXX_DETAIL_FIELDS(Type, __VA_ARGS__));        \
+    }
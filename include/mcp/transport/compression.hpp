@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mcp {
+
+/// HTTP content codings the transports can apply to bodies and SSE
+/// streams. Gzip needs zlib and zstd needs libzstd when mcpxx is built
+/// (MCPXX_COMPRESSION); codings the build lacks are never offered.
+enum class ContentCoding : uint8_t {
+    Identity,
+    Gzip,
+    Zstd,
+};
+
+/// The Content-Encoding token: "identity", "gzip" or "zstd".
+[[nodiscard]] std::string_view to_string(ContentCoding coding) noexcept;
+/// Parses one Content-Encoding token, case-insensitively ("x-gzip" is gzip).
+[[nodiscard]] std::optional<ContentCoding> parse_content_coding(std::string_view token) noexcept;
+/// Whether this build can encode and decode `coding`.
+[[nodiscard]] bool coding_available(ContentCoding coding) noexcept;
+
+/// The first of `preferred` that this build has and that an
+/// Accept-Encoding header value accepts (listed, or "*", without q=0).
+/// Identity if there is none.
+[[nodiscard]] ContentCoding negotiate_coding(std::string_view accept_encoding,
+                                             const std::vector<ContentCoding>& preferred);
+/// An Accept-Encoding value naming the available codings of `codings`, in
+/// order, e.g. "zstd, gzip"; empty if none is available.
+[[nodiscard]] std::string accept_encoding_value(const std::vector<ContentCoding>& codings);
+
+/// Compresses a body whole. Identity returns it as is.
+[[nodiscard]] std::string compress(std::string_view data, ContentCoding coding);
+/// Decompresses a body whole; nullopt if it would come to more than
+/// `max_bytes`. Throws McpParseError if the data isn't valid in `coding`.
+[[nodiscard]] std::optional<std::string> decompress(std::string_view data, ContentCoding coding,
+                                                    size_t max_bytes);
+
+/// Compresses a stream a piece at a time. Every write() is flushed, so the
+/// peer can decode everything up to the end of it at once: an SSE event is
+/// readable as soon as its bytes arrive, at the price of a few bytes per
+/// flush. Not synchronized.
+class StreamCompressor {
+public:
+    /// Throws std::invalid_argument if the build lacks `coding`.
+    explicit StreamCompressor(ContentCoding coding);
+    ~StreamCompressor();
+
+    StreamCompressor(const StreamCompressor&) = delete;
+    StreamCompressor& operator=(const StreamCompressor&) = delete;
+
+    /// Appends `data`, compressed and flushed, to `out`.
+    void write(std::string_view data, std::string& out);
+    /// Appends the end of the stream to `out`; nothing may be written after.
+    void finish(std::string& out);
+
+    [[nodiscard]] ContentCoding coding() const noexcept { return coding_; }
+
+private:
+    struct Impl;
+    ContentCoding coding_;
+    std::unique_ptr<Impl> impl_;
+};
+
+/// Undoes a StreamCompressor's stream, or a whole body, as it arrives.
+class StreamDecompressor {
+public:
+    /// Throws std::invalid_argument if the build lacks `coding`.
+    explicit StreamDecompressor(ContentCoding coding);
+    ~StreamDecompressor();
+
+    StreamDecompressor(const StreamDecompressor&) = delete;
+    StreamDecompressor& operator=(const StreamDecompressor&) = delete;
+
+    /// Appends what `data` decodes to, to `out`, stopping once `out` holds
+    /// more than `max_bytes` (returning false). Throws McpParseError if the
+    /// data is corrupt.
+    bool write(std::string_view data, std::string& out, size_t max_bytes = SIZE_MAX);
+
+private:
+    struct Impl;
+    ContentCoding coding_;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace mcp
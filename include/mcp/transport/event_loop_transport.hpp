@@ -0,0 +1,71 @@
+#pragma once
+#include "transport.hpp"
+#include "outbound.hpp"
+#include "../event_loop.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mcp {
+
+/// Newline-delimited JSON over a pair of file descriptors (pipes or one
+/// socket), driven by a shared EventLoop instead of threads of its own, so
+/// hundreds of connections can run on a handful of threads. Same framing as
+/// StdioTransport.
+///
+/// Messages are delivered on the connection's poller thread. send() writes
+/// straight to the fd while it accepts data and queues the rest for the
+/// poller to flush when it is writable, so it never blocks on a slow peer
+/// (except under OverflowPolicy::Block, and never on a poller thread). A
+/// streamed result is drained into its frame when sent.
+class EventLoopTransport : public ITransport {
+public:
+    struct Options {
+        /// Bytes requested per read().
+        size_t read_chunk_size = 64 * 1024;
+        /// Bounds on frames sent but not yet written. Unlimited by default.
+        OutboundLimits outbound_limits;
+    };
+
+    struct Stats {
+        uint64_t messages_written = 0;
+        uint64_t write_calls = 0;  // write()/writev() system calls issued
+        uint64_t bytes_written = 0;
+        size_t queued_messages = 0;  // sent, not yet written
+        size_t queued_bytes = 0;
+        uint64_t dropped_messages = 0;
+        uint64_t coalesced_messages = 0;
+    };
+
+    /// Takes ownership of both fds (which may be the same socket) and makes
+    /// them non-blocking.
+    EventLoopTransport(std::shared_ptr<EventLoop> loop, int read_fd, int write_fd);
+    EventLoopTransport(std::shared_ptr<EventLoop> loop, int read_fd, int write_fd, Options opts);
+    ~EventLoopTransport() override;
+
+    EventLoopTransport(const EventLoopTransport&) = delete;
+    EventLoopTransport& operator=(const EventLoopTransport&) = delete;
+
+    /// Blocks until input ends or shutdown().
+    void start(MessageCallback on_message, ErrorCallback on_error = nullptr) override;
+    bool start_detached(MessageCallback on_message, ErrorCallback on_error,
+                        std::function<void()> on_closed) override;
+    void send(const JsonRpcMessage& msg) override;
+    /// Writes the batch as one line, or one binary frame.
+    void send_batch(const std::vector<JsonRpcMessage>& msgs) override;
+    /// Binary formats included; a streamed result is still sent as JSON.
+    bool supports_wire_format(WireFormat format) const override;
+    bool set_wire_format(WireFormat format) override;
+    /// Writes whatever of the queue the fd takes without blocking, then
+    /// closes both fds.
+    void shutdown() override;
+    bool is_connected() const override;
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+} // namespace mcp
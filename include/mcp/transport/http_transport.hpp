@@ -1,16 +1,29 @@
 #pragma once
 #include "transport.hpp"
 #include "../codec.hpp"
+#include "../metrics.hpp"
+#include "compression.hpp"
+#include "outbound.hpp"
+#include "replay_buffer.hpp"
+#include "../timer_wheel.hpp"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <array>
+#include <deque>
 #include <map>
+#include <optional>
 #include <set>
 #include <thread>
 #include <functional>
+#include <list>
+#include <unordered_map>
 #include <vector>
+#include <chrono>
 
 // Forward declarations to avoid including heavy httplib header
 namespace httplib {
@@ -21,12 +34,60 @@ namespace httplib {
 
 namespace mcp {
 
+struct HttpSession;
+
+/// The sessions of one shard with no POST or GET stream, least recently
+/// used first, so max_sessions eviction looks only at the fronts.
+struct HttpSessionLru {
+    std::mutex mutex;  // taken after a session's mutex, never before
+    std::list<HttpSession*> idle;
+};
+
 /// Session data for HTTP transport
 struct HttpSession {
     std::string id;
     std::mutex mutex;
-    // SSE sink for server-initiated messages (if GET SSE stream is open)
-    std::function<bool(const std::string& data)> sse_sender;
+    std::condition_variable cv;
+    // SSE events waiting for the session's GET stream, oldest first. Senders
+    // only enqueue; the stream writes them out on its own worker thread.
+    std::deque<OutboundFrame> outbox;
+    size_t outbox_bytes = 0;
+    uint64_t dropped = 0;    // discarded by the overflow policy
+    uint64_t coalesced = 0;  // superseded progress discarded
+    int blocked = 0;      // senders waiting for room (Block policy)
+    int streams = 0;      // open GET streams; events are queued only if > 0
+    bool closed = false;  // deleted or transport shut down
+    // Events carry ids once the session has opened a GET stream, and the
+    // latest are kept for a stream that resumes with Last-Event-ID; while
+    // no stream is open they go only to the replay buffer.
+    bool resumable = false;
+    uint64_t last_event_id = 0;
+    ReplayBuffer replay;
+    // For idle and LRU eviction: when it was last used (steady clock, ns)
+    // and the POSTs running for it. A session in use is never idle.
+    std::atomic<int64_t> last_active_ns{0};
+    int posts = 0;
+    // Its shard's idle list and, while idle, its place there (guarded by
+    // the list's mutex)
+    HttpSessionLru* lru = nullptr;
+    std::list<HttpSession*>::iterator lru_pos;
+    bool in_lru = false;
+    std::set<std::string> subscriptions;  // guarded by the transport's subscriptions mutex
+    // Native backend: run (under the mutex) whenever the outbox or state
+    // changes, one per GET stream, keyed by connection
+    std::map<uint64_t, std::function<void()>> wakers;
+};
+
+/// Which HTTP server implementation HttpServerTransport runs on.
+enum class HttpBackend {
+    /// cpp-httplib: every open connection, idle SSE streams included,
+    /// occupies one of `max_connections` worker threads.
+    Httplib,
+    /// Built-in HTTP/1.1 server on an epoll EventLoop: sockets are
+    /// non-blocking with per-connection write buffers, so an idle SSE
+    /// stream costs memory but no thread. Only POSTs take a worker, while
+    /// they wait for their responses.
+    Native,
 };
 
 /// HTTP server transport implementing Streamable HTTP MCP spec.
@@ -37,64 +98,301 @@ public:
         uint16_t port = 8080;
         std::string mcp_path = "/mcp";
         std::vector<std::string> allowed_origins;
-        int max_connections = 100;
+        int max_connections = 100;  // also the number of HTTP worker threads
+        /// How long a POST waits for the responses to its requests before
+        /// answering the missing ones with an error.
+        std::chrono::milliseconds response_timeout{std::chrono::minutes(5)};
+        /// Per-session bounds on SSE events waiting for a slow GET stream.
+        OutboundLimits outbound_limits{1024, 0, OverflowPolicy::DropOldest};
+        /// Per-session bounds on the SSE events kept for a GET stream that
+        /// reconnects with Last-Event-ID. Zero `replay_events` turns event
+        /// ids and replay off.
+        size_t replay_events = 128;
+        size_t replay_bytes = 256 * 1024;
+        /// If set, GET on this path serves metrics::snapshot() in the
+        /// Prometheus text format.
+        std::string metrics_path;
+        HttpBackend backend = HttpBackend::Httplib;
+        /// How often an idle GET stream writes a keep-alive comment, which
+        /// is also how a vanished client is noticed.
+        std::chrono::seconds sse_keepalive{30};
+        /// Native only: event-loop threads serving the sockets.
+        size_t io_threads = 1;
+        /// Larger request bodies are refused with 413: as sent with the
+        /// native backend, and once decompressed with either.
+        size_t max_body_bytes = 16 * 1024 * 1024;
+        /// Sessions with no POST or GET stream for this long are removed as
+        /// if DELETEd. Zero keeps them until DELETE.
+        std::chrono::seconds session_idle_timeout{std::chrono::minutes(30)};
+        /// Most sessions at once; creating one more evicts the least
+        /// recently used, preferring those not in use. Zero: no cap.
+        size_t max_sessions = 0;
+        /// Codings for POST response bodies and SSE streams, most preferred
+        /// first, used where the client's Accept-Encoding allows. Request
+        /// bodies are accepted in them too, as advertised in Accept-Encoding
+        /// on every POST response. Codings the build lacks are skipped;
+        /// empty turns compression off.
+        std::vector<ContentCoding> compression{ContentCoding::Zstd, ContentCoding::Gzip};
+        /// Smaller response bodies are sent as they are. A stream is
+        /// compressed from its first event.
+        size_t compression_min_bytes = 1024;
+    };
+
+    /// Totals over all sessions.
+    struct Stats {
+        size_t sessions = 0;
+        size_t queued_events = 0;  // waiting for a GET stream
+        size_t queued_bytes = 0;
+        uint64_t dropped_events = 0;
+        uint64_t coalesced_events = 0;
+        size_t memory_bytes = 0;  // SessionInfo::memory_bytes over all sessions
+        uint64_t evicted_sessions = 0;  // idle or over the cap, since construction
+    };
+
+    /// One session's footprint.
+    struct SessionInfo {
+        std::string id;
+        /// Estimate of what it holds: its state, queued and replay events
+        /// and subscriptions.
+        size_t memory_bytes = 0;
+        size_t queued_events = 0;
+        size_t replay_events = 0;
+        size_t subscriptions = 0;
+        int streams = 0;
+        std::chrono::milliseconds idle{0};  // since last use; zero while in use
     };
 
     explicit HttpServerTransport(Options opts);
     ~HttpServerTransport() override;
 
     void start(MessageCallback on_message, ErrorCallback on_error = nullptr) override;
+    /// Messages come with their Mcp-Session-Id; a session ends on DELETE,
+    /// eviction or shutdown.
+    void start_sessions(SessionMessageCallback on_message, ErrorCallback on_error,
+                        SessionClosedCallback on_session_closed) override;
     void send(const JsonRpcMessage& msg) override;
     void shutdown() override;
     bool is_connected() const override;
 
     /// Send a message to a specific session (for server-initiated messages).
-    void send_to_session(const std::string& session_id, const JsonRpcMessage& msg);
+    void send_to_session(const std::string& session_id, const JsonRpcMessage& msg) override;
+
+    /// The listening port; with the native backend and port 0, the one the
+    /// system picked, once start() is listening.
+    uint16_t port() const {
+        uint16_t bound = bound_port_.load(std::memory_order_acquire);
+        return bound ? bound : opts_.port;
+    }
 
-    uint16_t port() const { return opts_.port; }
+    [[nodiscard]] Stats stats();
+    [[nodiscard]] std::optional<SessionInfo> session_info(const std::string& session_id);
+    /// Every session, in no particular order.
+    [[nodiscard]] std::vector<SessionInfo> sessions();
 
 private:
     std::string generate_session_id();
     bool validate_origin(const std::string& origin) const;
     void setup_routes();
 
+    // The coding to stream a response in for an Accept-Encoding value.
+    ContentCoding response_coding(const std::string& accept_encoding) const;
+    // Compresses a response body in place if it is big enough and the
+    // client accepts it; returns the coding used.
+    ContentCoding encode_body(std::string& body, const std::string& accept_encoding) const;
+    // Undoes a request body's Content-Encoding into `decoded`, left unset
+    // for an identity body. Returns the status to refuse the body with, or 0.
+    int decode_body(const std::string& content_encoding, const std::string& body,
+                    std::optional<std::string>& decoded) const;
+
+    // Sessions are spread over shards by id hash, so connections for
+    // different sessions rarely touch the same lock.
+    static constexpr size_t kSessionShards = 32;
+    struct SessionShard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<HttpSession>> sessions;
+        HttpSessionLru lru;
+    };
+    SessionShard& shard_for(const std::string& session_id);
+    // Null when the table is full of sessions in use (answered with 503)
+    std::shared_ptr<HttpSession> create_session();
+    std::shared_ptr<HttpSession> find_session(const std::string& session_id);
+    // With `if_idle`, leaves a session that has a POST or GET stream
+    bool remove_session(const std::string& session_id, bool if_idle = false);
+    SessionInfo describe(HttpSession& session);
+    // Removes the session if it has been idle for the timeout, or checks
+    // again when it could next be. Runs on the idle timer.
+    void check_idle(const std::string& session_id);
+    void schedule_idle_check(const std::string& session_id, std::chrono::milliseconds delay);
+    // Makes room under max_sessions by removing the least recently used
+    // idle session; false if every session is in use.
+    bool evict_for_new_session();
+    // Queues an SSE event on the session's GET stream, if one is open,
+    // and keeps it for replay.
+    void enqueue(HttpSession& session, OutboundFrame frame);
+    // Attaches a GET stream to the session; called with its mutex held.
+    // Returns the events after `last_event_id` (the Last-Event-ID header,
+    // if any) to write ahead of the outbox.
+    std::string attach_stream(HttpSession& session, const std::string& last_event_id);
+    void broadcast(const OutboundFrame& frame);
+    // Sends a notification only to the sessions it concerns; false if it
+    // has no particular owner.
+    bool route_notification(const JsonRpcNotification& notif);
+
     Options opts_;
     std::unique_ptr<httplib::Server> server_;
     std::atomic<bool> running_{false};
+    // Request body codings this backend accepts, and their Accept-Encoding
+    std::vector<ContentCoding> request_codings_;
+    std::string request_codings_value_;
 
-    std::mutex sessions_mutex_;
-    std::map<std::string, std::shared_ptr<HttpSession>> sessions_;
+    std::array<SessionShard, kSessionShards> shards_;
+    std::atomic<size_t> session_count_{0};
+    std::atomic<uint64_t> evicted_sessions_{0};
+    // Fires idle checks for sessions, whole seconds apart
+    TimerWheel idle_timers_{std::chrono::seconds(1)};
 
-    MessageCallback message_callback_;
+    // resources/subscribe requests seen per URI, so resources/updated
+    // reaches only the sessions that asked for it
+    std::mutex subscriptions_mutex_;
+    std::unordered_map<std::string, std::set<std::string>> subscribers_;
+
+    SessionMessageCallback message_callback_;
     ErrorCallback error_callback_;
+    SessionClosedCallback session_closed_callback_;
+
+    // Responses are routed back to the POST that carried the request.
+    // Request ids are only unique per session, so each incoming request is
+    // given a transport-wide id for the trip through the server and its
+    // original id is restored when the response is delivered.
+    struct PendingPost;
+    struct InflightRequest {
+        std::shared_ptr<PendingPost> post;
+        size_t slot;            // index into the POST's responses
+        RequestId original_id;
+        std::string session_id;
+        std::optional<nlohmann::json> progress_token;  // the peer's, replaced by the wire id
+    };
+
+    // Registers the requests in `msgs` (rewriting their ids and progress
+    // tokens) for `session_id`.
+    std::shared_ptr<PendingPost> admit(const std::string& session_id,
+                                       std::vector<JsonRpcMessage>& msgs, bool streaming);
+    // Hands a response to its waiting POST; false if none is waiting.
+    bool deliver(const JsonRpcMessage& msg);
+    // Drops registrations for requests the POST stopped waiting for.
+    void release(PendingPost& post);
+    // Gets each serialized message; if `rest` is set, the message is only
+    // its head and `rest` must be drained after it, then closed with '}'.
+    using ResponseCallback = std::function<void(std::string text, const JsonStream& rest)>;
+    // Runs `msgs` through the server and waits for every response, passing
+    // each to `on_response` as it arrives. Unanswered requests time out.
+    // Progress for its requests is streamed on the POST too if `streaming`,
+    // as are streamed results.
+    void run_post(const std::string& session_id, std::vector<JsonRpcMessage> msgs,
+                  bool streaming, const ResponseCallback& on_response);
+
+    // POST handling shared by both backends. Throws McpParseError.
+    static std::vector<JsonRpcMessage> parse_post_body(const std::string& body, bool& is_batch);
+    static std::string parse_error_body(const std::string& message);
+    // Writes the POST's SSE response through `write`; false once it fails.
+    bool stream_post(const std::string& session_id, std::vector<JsonRpcMessage> msgs,
+                     const std::function<bool(std::string_view)>& write);
+    // The POST's JSON response body, an array for a batch.
+    std::string collect_post(const std::string& session_id, std::vector<JsonRpcMessage> msgs,
+                             bool is_batch);
+
+    std::mutex inflight_mutex_;
+    std::unordered_map<int64_t, InflightRequest> inflight_;
+    int64_t next_request_id_ = 1;  // guarded by inflight_mutex_
 
-    // For broadcasting to all connected SSE clients
-    std::mutex broadcast_mutex_;
+    std::atomic<uint16_t> bound_port_{0};
+    // Declared after everything it uses, so it is torn down first
+    class NativeServer;
+    std::unique_ptr<NativeServer> native_;
 
-    // Synchronous POST response capture (thread-local per-request)
-    std::mutex response_capture_mutex_;
-    std::vector<nlohmann::json>* response_capture_{nullptr};
+    // Last, so they are unregistered before the sessions they read
+    metrics::Gauge sessions_gauge_{"mcpxx_http_sessions", [this] {
+        return static_cast<int64_t>(stats().sessions);
+    }};
+    metrics::Gauge queued_events_gauge_{"mcpxx_sse_queued_events", [this] {
+        return static_cast<int64_t>(stats().queued_events);
+    }};
+    metrics::Gauge queued_bytes_gauge_{"mcpxx_sse_queued_bytes", [this] {
+        return static_cast<int64_t>(stats().queued_bytes);
+    }};
+    metrics::Gauge session_bytes_gauge_{"mcpxx_http_session_bytes", [this] {
+        return static_cast<int64_t>(stats().memory_bytes);
+    }};
 };
 
 /// HTTP client transport for connecting to an MCP server.
+/// Each send() is a POST on a pooled keep-alive connection, so calls from
+/// several threads are in flight at once instead of queueing on one socket.
 class HttpClientTransport : public ITransport {
 public:
+    struct Options {
+        /// Most POSTs in flight at once; further sends wait for a connection.
+        size_t max_connections = 8;
+        bool keep_alive = true;
+        std::chrono::seconds connect_timeout{10};
+        std::chrono::seconds read_timeout{60};
+        /// Wait before reopening a dropped GET stream, which resumes from the
+        /// last event id seen.
+        std::chrono::milliseconds sse_retry{1000};
+        /// Codings asked for on responses and the GET stream, most preferred
+        /// first. Request bodies are sent in the first of them the server
+        /// says it accepts. Empty turns compression off.
+        std::vector<ContentCoding> compression{ContentCoding::Zstd, ContentCoding::Gzip};
+        /// Smaller request bodies are sent as they are.
+        size_t compression_min_bytes = 1024;
+        /// A compressed reply that decompresses to more than this fails the
+        /// send with McpTransportError.
+        size_t max_body_bytes = 16 * 1024 * 1024;
+    };
+
     explicit HttpClientTransport(const std::string& base_url);
+    HttpClientTransport(const std::string& base_url, Options opts);
     ~HttpClientTransport() override;
 
     void start(MessageCallback on_message, ErrorCallback on_error = nullptr) override;
     void send(const JsonRpcMessage& msg) override;
+    /// POSTs the batch as one JSON array; the responses come back as one too.
+    void send_batch(const std::vector<JsonRpcMessage>& msgs) override;
     void shutdown() override;
     bool is_connected() const override;
 
 private:
     std::string extract_path() const;
+    // Waits for start(); throws if not connected.
+    void wait_connected();
+    // POSTs serialized JSON-RPC and hands every message in the reply on.
+    void post(const std::string& body);
+    // Reads server-initiated messages from the session's GET stream,
+    // reconnecting until shutdown or the session ends.
+    void sse_loop(std::string session_id);
+    std::unique_ptr<httplib::Client> make_connection() const;
+    // Takes an idle connection or opens one; null once shut down.
+    std::unique_ptr<httplib::Client> acquire_connection();
+    // Returns a connection to the pool, or closes it if it failed.
+    void release_connection(std::unique_ptr<httplib::Client> conn, bool reusable);
 
     std::string base_url_;
-    std::string session_id_;
+    std::string hostport_;
+    Options opts_;
+    std::string accept_encoding_;  // sent on every request; empty: none
+    // What the server last said it accepts request bodies in
+    std::atomic<ContentCoding> request_coding_{ContentCoding::Identity};
+    std::mutex session_mutex_;
+    std::string session_id_;  // guarded by session_mutex_
     std::atomic<bool> connected_{false};
     std::atomic<bool> running_{false};
-    std::unique_ptr<httplib::Client> client_;
+
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    std::vector<std::unique_ptr<httplib::Client>> idle_;
+    size_t open_connections_ = 0;  // idle or in use; guarded by pool_mutex_
+
+    std::unique_ptr<httplib::Client> sse_client_;  // the GET stream blocks its connection
     std::thread sse_thread_;
     MessageCallback message_callback_;
     ErrorCallback error_callback_;
@@ -0,0 +1,152 @@
+#pragma once
+#include "transport.hpp"
+#include "../binary_codec.hpp"
+#include "../codec.hpp"
+#include "../error.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <tuple>
+
+namespace mcp {
+
+/// Growable read buffer that hands out complete lines in place.
+///
+/// Bytes are read straight into the buffer and each line is parsed where it
+/// sits, with Codec::kParsePadding bytes always allocated past the data so the
+/// parser needs no copy. Unconsumed bytes are only moved when a read would not
+/// fit, and the buffer doubles for lines longer than a chunk, so a multi-MB
+/// message costs one pass of copying rather than one per chunk.
+class LineBuffer {
+public:
+    explicit LineBuffer(size_t chunk)
+        : chunk_(std::max<size_t>(chunk, 512)) {
+        grow(chunk_);
+    }
+
+    /// Writable region of at least chunk_ bytes for the next read().
+    char* write_ptr() {
+        if (capacity_ - tail_ < chunk_) make_room();
+        return data_.get() + tail_;
+    }
+    size_t write_size() const { return capacity_ - tail_; }
+    void commit(size_t n) { tail_ += n; }
+
+    /// Next complete line without its terminator, or nullopt if none yet.
+    std::optional<std::string_view> next_line() {
+        const char* base = data_.get();
+        auto* nl = static_cast<const char*>(std::memchr(base + scan_, '\n', tail_ - scan_));
+        if (!nl) {
+            scan_ = tail_;  // never rescan bytes already searched
+            return std::nullopt;
+        }
+        std::string_view line(base + head_, static_cast<size_t>(nl - (base + head_)));
+        head_ = scan_ = static_cast<size_t>(nl - base) + 1;
+        if (head_ == tail_) head_ = scan_ = tail_ = 0;
+        return line;
+    }
+
+    /// Parses every complete line and hands the messages to `on_message`.
+    /// A line opening with '[' is a batch. Blank lines are skipped, a
+    /// trailing '\r' is dropped, and a line that fails to parse is
+    /// reported to `on_error` as McpParseError. Binary frames (see
+    /// BinaryCodec) may come between lines and are decoded the same way.
+    void deliver(const MessageCallback& on_message, const ErrorCallback& on_error) {
+        while (true) {
+            if (head_ < tail_ && data_[head_] == BinaryCodec::kFrameMarker) {
+                if (!deliver_frame(on_message, on_error)) return;
+                continue;
+            }
+            auto next = next_line();
+            if (!next) return;
+            std::string_view line = *next;
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (line.empty()) continue;
+
+            try {
+                if (line.front() == '[') {
+                    for (auto& msg : Codec::parse_batch(line)) on_message(std::move(msg));
+                } else {
+                    on_message(Codec::parse_padded(line));
+                }
+            } catch (const std::exception& e) {
+                report(on_error, e.what());
+            }
+        }
+    }
+
+private:
+    static void report(const ErrorCallback& on_error, const char* what) {
+        if (!on_error) return;
+        try {
+            throw McpParseError(what);
+        } catch (...) {
+            on_error(std::current_exception());
+        }
+    }
+
+    // Decodes the binary frame at head_; false if it isn't all here yet
+    bool deliver_frame(const MessageCallback& on_message, const ErrorCallback& on_error) {
+        size_t pending = tail_ - head_;
+        if (pending < BinaryCodec::kFrameHeaderSize) return false;
+        WireFormat format;
+        size_t length;
+        try {
+            std::tie(format, length) = BinaryCodec::read_header(data_.get() + head_);
+        } catch (const std::exception& e) {
+            // No way to find the next frame: drop what is buffered
+            head_ = scan_ = tail_ = 0;
+            report(on_error, e.what());
+            return false;
+        }
+        if (pending - BinaryCodec::kFrameHeaderSize < length) return false;
+        std::string_view payload(data_.get() + head_ + BinaryCodec::kFrameHeaderSize, length);
+        head_ = scan_ = head_ + BinaryCodec::kFrameHeaderSize + length;
+        try {
+            auto msgs = BinaryCodec::decode(payload, format);
+            if (head_ == tail_) head_ = scan_ = tail_ = 0;
+            for (auto& msg : msgs) on_message(std::move(msg));
+        } catch (const std::exception& e) {
+            if (head_ == tail_) head_ = scan_ = tail_ = 0;
+            report(on_error, e.what());
+        }
+        return true;
+    }
+
+    void make_room() {
+        size_t pending = tail_ - head_;
+        if (head_ > 0 && capacity_ - pending >= chunk_) {
+            std::memmove(data_.get(), data_.get() + head_, pending);
+        } else {
+            grow(std::max(capacity_ * 2, pending + chunk_));
+            return;
+        }
+        scan_ -= head_;
+        tail_ = pending;
+        head_ = 0;
+    }
+
+    void grow(size_t capacity) {
+        // The padding lives beyond capacity_ and is never handed to read()
+        auto fresh = std::make_unique<char[]>(capacity + Codec::kParsePadding);
+        size_t pending = tail_ - head_;
+        if (pending > 0) std::memcpy(fresh.get(), data_.get() + head_, pending);
+        data_ = std::move(fresh);
+        capacity_ = capacity;
+        scan_ -= head_;
+        tail_ = pending;
+        head_ = 0;
+    }
+
+    size_t chunk_;
+    std::unique_ptr<char[]> data_;
+    size_t capacity_ = 0;
+    size_t head_ = 0;  // start of the first unconsumed line
+    size_t scan_ = 0;  // bytes before this hold no newline past head_
+    size_t tail_ = 0;  // end of data
+};
+
+} // namespace mcp
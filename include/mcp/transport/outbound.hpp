@@ -0,0 +1,58 @@
+#pragma once
+#include "../json_rpc.hpp"
+#include <cstddef>
+#include <deque>
+#include <string>
+
+namespace mcp {
+
+/// What a transport does once its outbound queue reaches its limits.
+enum class OverflowPolicy {
+    Block,             ///< send() waits until the peer has read enough
+    DropOldest,        ///< discard the oldest queued notifications
+    CoalesceProgress,  ///< discard superseded progress for the same token, then as DropOldest
+};
+
+/// Bounds on what may be queued for a slow peer; zero means unlimited.
+/// Only notifications are ever discarded: requests and responses are kept
+/// even past the limits.
+struct OutboundLimits {
+    size_t max_messages = 0;
+    size_t max_bytes = 0;
+    OverflowPolicy policy = OverflowPolicy::Block;
+};
+
+/// A serialized message waiting to be written.
+struct OutboundFrame {
+    std::string data;
+    std::string coalesce_key;  // same key = later frame supersedes; empty if never
+    bool droppable = false;
+    // Streamed result: `data` is the message up to its result, which the
+    // writer drains from here before closing the message
+    JsonStream stream;
+
+    OutboundFrame() = default;
+    /// Takes `data` as the serialized form of `msg`.
+    OutboundFrame(std::string data, const JsonRpcMessage& msg, OverflowPolicy policy);
+};
+
+struct ShedResult {
+    size_t dropped = 0;
+    size_t coalesced = 0;
+    size_t bytes = 0;  // freed by both
+};
+
+/// Applies `limits` after a frame was appended to `queue`. `messages` and
+/// `bytes` are the transport's totals including that frame (which may count
+/// frames no longer in `queue`, e.g. ones being written). Removes frames
+/// until the totals fit or nothing droppable is left, oldest first.
+ShedResult shed(std::deque<OutboundFrame>& queue, const OutboundLimits& limits,
+                size_t messages, size_t bytes);
+
+/// True if the totals are past `limits`.
+[[nodiscard]] inline bool exceeds(const OutboundLimits& limits, size_t messages, size_t bytes) {
+    return (limits.max_messages && messages > limits.max_messages)
+        || (limits.max_bytes && bytes > limits.max_bytes);
+}
+
+} // namespace mcp
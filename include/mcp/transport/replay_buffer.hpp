@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mcp {
+
+/// The most recent SSE events sent on a stream, kept in a fixed ring so a
+/// client that reconnects with Last-Event-ID can be sent what it missed
+/// instead of re-listing everything.
+///
+/// Event ids must increase with every push(). The ring holds at most
+/// `max_events` events and `max_bytes` of their text (zero: no byte bound);
+/// the oldest are evicted first. Slots are allocated on the first push.
+/// Not synchronized: the owner's lock guards it.
+class ReplayBuffer {
+public:
+    ReplayBuffer() = default;
+    ReplayBuffer(size_t max_events, size_t max_bytes)
+        : max_events_(max_events), max_bytes_(max_bytes) {}
+
+    /// False if constructed with no room, in which case push() keeps nothing.
+    bool enabled() const { return max_events_ > 0; }
+
+    void push(uint64_t id, std::string event) {
+        if (!enabled()) return;
+        if (slots_.empty()) slots_.resize(max_events_);
+        if (count_ == max_events_) pop_oldest();
+        bytes_ += event.size();
+        slots_[(head_ + count_) % max_events_] = {id, std::move(event)};
+        ++count_;
+        while (max_bytes_ && bytes_ > max_bytes_) pop_oldest();
+    }
+
+    /// Appends every retained event with an id after `last_id` to `out`,
+    /// oldest first. Returns false if some of those were already evicted.
+    bool replay_after(uint64_t last_id, std::string& out) const {
+        // Ids are increasing, so the events to send are a suffix of the ring
+        size_t lo = 0, hi = count_;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (at(mid).id <= last_id) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (size_t i = lo; i < count_; ++i) out += at(i).event;
+        return last_id >= evicted_through_;
+    }
+
+    size_t size() const { return count_; }
+    size_t bytes() const { return bytes_; }
+    /// Bytes allocated, slots included.
+    size_t memory() const { return slots_.capacity() * sizeof(Entry) + bytes_; }
+
+private:
+    struct Entry {
+        uint64_t id = 0;
+        std::string event;
+    };
+
+    const Entry& at(size_t i) const { return slots_[(head_ + i) % max_events_]; }
+
+    void pop_oldest() {
+        Entry& oldest = slots_[head_];
+        evicted_through_ = oldest.id;
+        bytes_ -= oldest.event.size();
+        oldest.event = std::string();  // release its memory now
+        head_ = (head_ + 1) % max_events_;
+        --count_;
+    }
+
+    size_t max_events_ = 0;
+    size_t max_bytes_ = 0;
+    std::vector<Entry> slots_;
+    size_t head_ = 0;   // oldest
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+    uint64_t evicted_through_ = 0;  // newest id no longer retained
+};
+
+} // namespace mcp
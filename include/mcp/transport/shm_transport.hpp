@@ -0,0 +1,118 @@
+#pragma once
+#include "transport.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace mcp {
+
+/// Newline-delimited JSON between two processes on one host through a pair
+/// of single-producer/single-consumer byte rings in shared memory (memfd),
+/// one per direction. Same framing as StdioTransport, without the kernel
+/// copying every byte through a pipe twice.
+///
+/// The two ends are joined by a connected AF_UNIX stream socket, over which
+/// the creating end passes the memfd. After that the socket only carries
+/// doorbells: a reader that has found its ring empty for `spin` sleeps in
+/// poll() on it, and the writer sends one byte only if the reader is
+/// asleep, so a busy exchange makes no system calls at all. Closing the
+/// socket (shutdown() or the process exiting) is how each end learns that
+/// the other is gone.
+///
+/// send() copies straight into the ring, blocking while the ring is full;
+/// messages larger than the ring stream through it. Linux only.
+class ShmTransport : public ITransport {
+public:
+    /// Environment variable through which McpClient::connect_shm() tells a
+    /// child process the number of its end of the socket.
+    static constexpr const char* kFdEnv = "MCPXX_SHM_FD";
+
+    enum class Role {
+        Create,  ///< sets up the rings and sends them to the peer
+        Attach,  ///< waits for the peer's rings
+    };
+
+    struct Options {
+        /// Bytes in each direction's ring, rounded up to a power of two of
+        /// at least 4 KiB. Only the creating end's value is used.
+        size_t ring_bytes = 1 << 20;
+        /// How long a reader keeps polling an empty ring before sleeping.
+        /// Zero sleeps at once, trading latency for idle CPU; a machine with
+        /// a single CPU never spins.
+        std::chrono::microseconds spin{50};
+        /// Initial size of the buffer messages are assembled in.
+        size_t read_chunk_size = 64 * 1024;
+    };
+
+    struct Stats {
+        uint64_t messages_written = 0;
+        uint64_t bytes_written = 0;
+        uint64_t doorbells = 0;   // wake-ups sent to a sleeping reader
+        uint64_t full_waits = 0;  // times send() found the ring full
+    };
+
+    /// Takes ownership of `socket_fd`. Throws McpTransportError if the
+    /// shared memory can't be set up or, for Role::Attach, if what the peer
+    /// sent isn't a ring pair; attaching blocks until the peer has sent it.
+    ShmTransport(int socket_fd, Role role);
+    ShmTransport(int socket_fd, Role role, Options opts);
+    ~ShmTransport() override;
+
+    ShmTransport(const ShmTransport&) = delete;
+    ShmTransport& operator=(const ShmTransport&) = delete;
+
+    void start(MessageCallback on_message, ErrorCallback on_error = nullptr) override;
+    void send(const JsonRpcMessage& msg) override;
+    /// Writes the batch as one line, or one binary frame.
+    void send_batch(const std::vector<JsonRpcMessage>& msgs) override;
+    /// Binary formats included; a streamed result is still sent as JSON.
+    bool supports_wire_format(WireFormat format) const override;
+    bool set_wire_format(WireFormat format) override;
+    void shutdown() override;
+    bool is_connected() const override;
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct Ring;
+    struct Header;
+
+    void create_region();
+    void attach_region();
+    void read_loop(const MessageCallback& on_message, const ErrorCallback& on_error);
+    // Copies `bytes` into the outgoing ring; false once the peer is gone.
+    bool write_bytes(std::string_view bytes);
+    // Writes frame_ and wakes the peer; the send mutex is held.
+    void write_frame();
+    void ring_doorbell();
+    bool peer_alive() const;
+
+    int socket_fd_;
+    Options opts_;
+    void* region_ = nullptr;
+    size_t region_bytes_ = 0;
+    uint64_t ring_bytes_ = 0;
+    Ring* tx_ = nullptr;
+    Ring* rx_ = nullptr;
+    char* tx_data_ = nullptr;
+    const char* rx_data_ = nullptr;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> connected_{true};
+    std::atomic<bool> shutdown_requested_{false};
+    std::atomic<WireFormat> wire_format_{WireFormat::Json};
+
+    std::mutex send_mutex_;  // the ring has one producer
+    std::string frame_;      // reused serialization buffer, under send_mutex_
+
+    std::atomic<uint64_t> messages_written_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+    std::atomic<uint64_t> doorbells_{0};
+    std::atomic<uint64_t> full_waits_{0};
+};
+
+} // namespace mcp
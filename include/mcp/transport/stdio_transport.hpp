@@ -1,51 +1,154 @@
 #pragma once
 #include "transport.hpp"
 #include "../codec.hpp"
+#include "../metrics.hpp"
+#include "../mpsc_queue.hpp"
+#include "outbound.hpp"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <thread>
 #include <mutex>
-#include <queue>
-#include <condition_variable>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace mcp {
 
 /// StdioTransport reads newline-delimited JSON from stdin and writes to stdout.
-/// Uses a background reader thread and a write queue.
+/// Uses a background reader thread and a batching writer thread: send()
+/// enqueues without locking, and the writer flushes everything queued so far
+/// with writev(). A streamed result (JsonRpcResponse::result_stream) is
+/// written as it is produced, so it is never held whole.
 class StdioTransport : public ITransport {
 public:
+    struct Options {
+        /// Bytes requested per read(). Lines longer than this grow the
+        /// read buffer instead of being re-copied chunk by chunk.
+        size_t read_chunk_size = 64 * 1024;
+        /// Most frames handed to a single writev() call (capped at IOV_MAX).
+        size_t max_batch_messages = 64;
+        /// How long the writer may wait for more frames before flushing a
+        /// partial batch. Zero flushes as soon as anything is queued.
+        std::chrono::microseconds flush_latency{0};
+        /// Bounds on frames sent but not yet written. Unlimited by default.
+        OutboundLimits outbound_limits;
+        /// After shutdown(), how long frames still queued may take to be
+        /// written to a peer that has stopped reading; the rest are dropped.
+        std::chrono::milliseconds drain_timeout{1000};
+    };
+
+    /// Counters for the writer thread, for benchmarks and diagnostics.
+    struct Stats {
+        uint64_t messages_written = 0;
+        uint64_t write_calls = 0;   // writev() system calls issued
+        uint64_t bytes_written = 0;
+        size_t queued_messages = 0;  // sent, not yet written
+        size_t queued_bytes = 0;
+        uint64_t dropped_messages = 0;    // discarded by the overflow policy
+        uint64_t coalesced_messages = 0;  // superseded progress discarded
+    };
+
     /// Create transport using system stdin/stdout.
     StdioTransport();
+    explicit StdioTransport(Options opts);
 
     /// Create transport using specified file descriptors (for testing).
     StdioTransport(int read_fd, int write_fd);
+    StdioTransport(int read_fd, int write_fd, Options opts);
 
     ~StdioTransport() override;
 
     void start(MessageCallback on_message, ErrorCallback on_error = nullptr) override;
     void send(const JsonRpcMessage& msg) override;
+    /// Writes the batch as one line, or one binary frame.
+    void send_batch(const std::vector<JsonRpcMessage>& msgs) override;
+    /// Binary formats included; a streamed result is still sent as JSON.
+    bool supports_wire_format(WireFormat format) const override;
+    bool set_wire_format(WireFormat format) override;
     void shutdown() override;
     bool is_connected() const override;
 
+    [[nodiscard]] Stats stats() const;
+
 private:
     void read_loop(MessageCallback on_message, ErrorCallback on_error);
     void write_loop();
+    // Writes frames with as few writev() calls as possible; false on error.
+    bool flush(std::vector<OutboundFrame>& frames);
+    bool write_all(std::string_view bytes);
+    // Waits until write_fd_ has room; false once the drain deadline passed.
+    bool wait_writable();
+    [[nodiscard]] bool drain_expired() const;
+    // Drops every frame not yet written, after the drain deadline
+    void discard_queued();
+    // Writes a streamed result frame piece by piece.
+    bool write_stream(OutboundFrame& frame);
+    void enqueue(OutboundFrame frame);
+    // enqueue() past the limits: applies the overflow policy to `frame`.
+    void enqueue_over_limit(OutboundFrame frame);
+    void wake_writer();
+    std::string acquire_buffer();
+    void release_buffer(std::string buf);
 
     int read_fd_;
     int write_fd_;
     bool owns_fds_;
+    Options opts_;
 
     std::atomic<bool> running_{false};
     std::atomic<bool> connected_{false};
     std::atomic<bool> shutdown_requested_{false};
+    std::atomic<WireFormat> wire_format_{WireFormat::Json};
 
     std::thread reader_thread_;
     std::thread writer_thread_;
 
-    std::mutex write_mutex_;
-    std::queue<std::string> write_queue_;
-    std::condition_variable write_cv_;
+    MpscQueue<OutboundFrame> write_queue_;
+    // Bumped whenever the writer must re-check the queue or running_;
+    // the writer sleeps on it with atomic wait().
+    std::atomic<uint32_t> write_signal_{0};
+
+    // Frames taken off write_queue_ but not yet written. Whoever holds
+    // staged_mutex_ is the queue's consumer: normally the writer, which
+    // takes a batch at a time, or a sender that is over the limits and
+    // needs the backlog in reach to drop from it.
+    std::mutex staged_mutex_;
+    std::condition_variable space_cv_;  // Block policy: the writer made room
+    std::deque<OutboundFrame> staged_;
+    std::atomic<size_t> queued_messages_{0};
+    std::atomic<size_t> queued_bytes_{0};
+    std::atomic<uint64_t> dropped_messages_{0};
+    std::atomic<uint64_t> coalesced_messages_{0};
+
+    // Written frames are returned here and reused, so steady-state sends
+    // serialize into already-sized storage. Only ever try-locked: a
+    // contended sender allocates instead of waiting.
+    std::mutex pool_mutex_;
+    std::vector<std::string> free_buffers_;
+
+    std::atomic<uint64_t> messages_written_{0};
+    std::atomic<uint64_t> write_calls_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+
+    int wakeup_pipe_[2]{-1, -1};  // pipe for waking up the reader
+    // A pipe or socket write_fd_ is made non-blocking, so a peer that stops
+    // reading can't hold the writer (and shutdown) forever; its original
+    // flags are restored on destruction.
+    int write_fd_flags_ = -1;
+    // Set by the first shutdown(): steady-clock ns by which the writer
+    // gives up on what is still queued
+    std::atomic<int64_t> drain_deadline_ns_{0};
 
-    int wakeup_pipe_[2]{-1, -1};  // pipe for waking up writer
+    // Last, so they are unregistered before anything they read is destroyed
+    metrics::Gauge queued_messages_gauge_{"mcpxx_stdio_queued_messages", [this] {
+        return static_cast<int64_t>(queued_messages_.load(std::memory_order_relaxed));
+    }};
+    metrics::Gauge queued_bytes_gauge_{"mcpxx_stdio_queued_bytes", [this] {
+        return static_cast<int64_t>(queued_bytes_.load(std::memory_order_relaxed));
+    }};
 };
 
 } // namespace mcp
@@ -1,12 +1,19 @@
 #pragma once
 #include "../json_rpc.hpp"
+#include "../binary_codec.hpp"
 #include <functional>
+#include <string>
+#include <vector>
 
 namespace mcp {
 
 /// Callback for incoming messages
 using MessageCallback = std::function<void(JsonRpcMessage)>;
 using ErrorCallback = std::function<void(std::exception_ptr)>;
+/// For transports shared by many clients: a message from the logical
+/// session `session`, and the end of one.
+using SessionMessageCallback = std::function<void(const std::string& session, JsonRpcMessage msg)>;
+using SessionClosedCallback = std::function<void(const std::string& session)>;
 
 /// Abstract transport interface
 class ITransport {
@@ -17,14 +24,69 @@ public:
     virtual void start(MessageCallback on_message,
                        ErrorCallback on_error = nullptr) = 0;
 
+    /// Start without blocking the caller, for transports driven by an event
+    /// loop: messages arrive on the loop's threads and `on_closed` runs once
+    /// input has ended. Returns false, having started nothing, if the
+    /// transport can only run inside start().
+    virtual bool start_detached(MessageCallback on_message, ErrorCallback on_error,
+                                std::function<void()> on_closed) {
+        (void)on_message;
+        (void)on_error;
+        (void)on_closed;
+        return false;
+    }
+
+    /// Like start(), for transports that serve several logical sessions
+    /// (e.g. one per HTTP client): each message comes with the id of its
+    /// session, and `on_session_closed` runs once a session has ended. The
+    /// default runs start() with every message in session "".
+    virtual void start_sessions(SessionMessageCallback on_message, ErrorCallback on_error,
+                                SessionClosedCallback on_session_closed) {
+        (void)on_session_closed;
+        start([on_message = std::move(on_message)](JsonRpcMessage msg) {
+            on_message(std::string(), std::move(msg));
+        }, std::move(on_error));
+    }
+
     /// Send a message to the remote peer.
     virtual void send(const JsonRpcMessage& msg) = 0;
 
+    /// Send a message to one session only. Transports with a single peer
+    /// just send() it.
+    virtual void send_to_session(const std::string& session, const JsonRpcMessage& msg) {
+        (void)session;
+        send(msg);
+    }
+
+    /// Send messages as one JSON-RPC batch where the transport can frame
+    /// them together. The default sends them one at a time.
+    virtual void send_batch(const std::vector<JsonRpcMessage>& msgs) {
+        for (const auto& msg : msgs) send(msg);
+    }
+
+    /// Whether send() can encode messages in `format`. Every transport
+    /// can send JSON.
+    [[nodiscard]] virtual bool supports_wire_format(WireFormat format) const {
+        return format == WireFormat::Json;
+    }
+
+    /// Encode messages sent from now on in `format`. Transports that
+    /// support a binary format read every format at any time, so only the
+    /// sending side switches. Returns false, changing nothing, if the
+    /// format isn't supported.
+    virtual bool set_wire_format(WireFormat format) { return supports_wire_format(format); }
+
     /// Graceful shutdown.
     virtual void shutdown() = 0;
 
     /// Check if transport is connected.
     [[nodiscard]] virtual bool is_connected() const = 0;
+
+    /// Whether responses may be sent from another thread, after the
+    /// message callback has returned and in any order. Transports that
+    /// must answer inside the callback (e.g. a synchronous HTTP POST)
+    /// return false and get inline dispatch.
+    [[nodiscard]] virtual bool supports_async_responses() const { return true; }
 };
 
 } // namespace mcp
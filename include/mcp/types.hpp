@@ -4,6 +4,7 @@
 #include <optional>
 #include <variant>
 #include <map>
+#include <memory>
 #include <nlohmann/json.hpp>
 
 namespace mcp {
@@ -23,6 +24,11 @@ struct Annotations {
 
 // ---------- Content types ----------
 
+/// Raw binary payload, shared between copies. Content holding one is
+/// base64-encoded straight into the output when serialized, so no encoded
+/// copy is ever kept.
+using Bytes = std::shared_ptr<const std::string>;
+
 struct TextContent {
     std::string text;
     std::optional<Annotations> annotations;
@@ -33,22 +39,40 @@ struct TextContent {
 };
 
 struct ImageContent {
-    std::string data;       // base64
+    std::string data;       // base64; unused if `bytes` is set
     std::string mime_type;
     std::optional<Annotations> annotations;
+    Bytes bytes{};          // raw image, in place of `data`
+
+    /// Content from raw bytes, encoded only when serialized.
+    [[nodiscard]] static ImageContent from_bytes(std::string raw, std::string mime_type);
+    /// `data`, or `bytes` encoded.
+    [[nodiscard]] std::string encoded() const;
+    /// The raw bytes. Throws std::invalid_argument if `data` is malformed.
+    [[nodiscard]] std::string decoded() const;
 
     bool operator==(const ImageContent& o) const {
-        return data == o.data && mime_type == o.mime_type && annotations == o.annotations;
+        return (bytes || o.bytes ? encoded() == o.encoded() : data == o.data)
+               && mime_type == o.mime_type && annotations == o.annotations;
     }
 };
 
 struct AudioContent {
-    std::string data;       // base64
+    std::string data;       // base64; unused if `bytes` is set
     std::string mime_type;
     std::optional<Annotations> annotations;
+    Bytes bytes{};          // raw audio, in place of `data`
+
+    /// Content from raw bytes, encoded only when serialized.
+    [[nodiscard]] static AudioContent from_bytes(std::string raw, std::string mime_type);
+    /// `data`, or `bytes` encoded.
+    [[nodiscard]] std::string encoded() const;
+    /// The raw bytes. Throws std::invalid_argument if `data` is malformed.
+    [[nodiscard]] std::string decoded() const;
 
     bool operator==(const AudioContent& o) const {
-        return data == o.data && mime_type == o.mime_type && annotations == o.annotations;
+        return (bytes || o.bytes ? encoded() == o.encoded() : data == o.data)
+               && mime_type == o.mime_type && annotations == o.annotations;
     }
 };
 
@@ -69,12 +93,22 @@ struct EmbeddedResource {
     std::string uri;
     std::optional<std::string> mime_type;
     std::optional<std::string> text;
-    std::optional<std::string> blob;  // base64
+    std::optional<std::string> blob;  // base64; unused if `blob_bytes` is set
     std::optional<Annotations> annotations;
+    Bytes blob_bytes{};               // raw blob, in place of `blob`
+
+    /// Blob resource from raw bytes, encoded only when serialized.
+    [[nodiscard]] static EmbeddedResource from_bytes(std::string uri, std::string raw,
+                                                     std::optional<std::string> mime_type = std::nullopt);
+    /// `blob`, or `blob_bytes` encoded.
+    [[nodiscard]] std::optional<std::string> blob_base64() const;
+    /// The raw blob. Throws std::invalid_argument if `blob` is malformed.
+    [[nodiscard]] std::optional<std::string> decoded_blob() const;
 
     bool operator==(const EmbeddedResource& o) const {
         return uri == o.uri && mime_type == o.mime_type && text == o.text
-               && blob == o.blob && annotations == o.annotations;
+               && (blob_bytes || o.blob_bytes ? blob_base64() == o.blob_base64() : blob == o.blob)
+               && annotations == o.annotations;
     }
 };
 
@@ -131,11 +165,20 @@ struct ResourceContent {
     std::string uri;
     std::optional<std::string> mime_type;
     std::optional<std::string> text;
-    std::optional<std::string> blob;  // base64
+    std::optional<std::string> blob;  // base64; unused if `blob_bytes` is set
+    Bytes blob_bytes{};               // raw blob, in place of `blob`
+
+    /// Blob contents from raw bytes, encoded only when serialized.
+    [[nodiscard]] static ResourceContent from_bytes(std::string uri, std::string raw,
+                                                    std::optional<std::string> mime_type = std::nullopt);
+    /// `blob`, or `blob_bytes` encoded.
+    [[nodiscard]] std::optional<std::string> blob_base64() const;
+    /// The raw blob. Throws std::invalid_argument if `blob` is malformed.
+    [[nodiscard]] std::optional<std::string> decoded_blob() const;
 
     bool operator==(const ResourceContent& o) const {
         return uri == o.uri && mime_type == o.mime_type && text == o.text
-               && blob == o.blob;
+               && (blob_bytes || o.blob_bytes ? blob_base64() == o.blob_base64() : blob == o.blob);
     }
 };
 
@@ -483,4 +526,27 @@ void from_json(const nlohmann::json& j, LogLevel& level);
 void to_json(nlohmann::json& j, const LogMessage& t);
 void from_json(const nlohmann::json& j, LogMessage& t);
 
+// ---------- Streaming serialization ----------
+// Same wire form as to_json, written straight into a JsonWriter so hot
+// results (tool calls, reads, listings) skip the intermediate DOM.
+
+class JsonWriter;
+
+void write_json(JsonWriter& w, const Annotations& a);
+void write_json(JsonWriter& w, const TextContent& t);
+void write_json(JsonWriter& w, const ImageContent& t);
+void write_json(JsonWriter& w, const AudioContent& t);
+void write_json(JsonWriter& w, const ResourceLink& t);
+void write_json(JsonWriter& w, const EmbeddedResource& t);
+void write_json(JsonWriter& w, const Content& c);
+void write_json(JsonWriter& w, const ToolDefinition& t);
+void write_json(JsonWriter& w, const CallToolResult& t);
+void write_json(JsonWriter& w, const ResourceDefinition& t);
+void write_json(JsonWriter& w, const ResourceContent& t);
+void write_json(JsonWriter& w, const ResourceTemplate& t);
+void write_json(JsonWriter& w, const PromptArgument& t);
+void write_json(JsonWriter& w, const PromptDefinition& t);
+void write_json(JsonWriter& w, const PromptMessage& t);
+void write_json(JsonWriter& w, const GetPromptResult& t);
+
 } // namespace mcp
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mcp {
+
+/// Variables extracted from a URI by a template match, percent-decoded.
+using UriTemplateVars = std::unordered_map<std::string, std::string>;
+
+/// Matches URIs against many RFC 6570 templates at once.
+///
+/// Supports level 1 and 2 expressions: `{var}` matches one or more
+/// unreserved characters (so not '/', '?' or '#'), `{+var}` also matches
+/// reserved ones, and `{#var}` matches '#' followed by reserved characters.
+/// All templates share one trie, so a match walks the URI once, however
+/// many templates are registered; a variable only backtracks to find where
+/// the literal text after it begins. Literal text is preferred over a
+/// variable at the same position, so the most specific template wins.
+/// Not thread-safe for writes; matching is const.
+class UriTemplateMatcher {
+public:
+    /// Throws std::invalid_argument if `tmpl` is malformed or uses an
+    /// operator beyond level 2.
+    static void validate(std::string_view tmpl);
+
+    /// Register `tmpl` as `id`, replacing the id of an identical template.
+    /// Throws as validate() does.
+    void add(std::string_view tmpl, size_t id);
+
+    /// Id of the template matching all of `uri`, filling `vars` if given.
+    [[nodiscard]] std::optional<size_t> match(std::string_view uri,
+                                              UriTemplateVars* vars = nullptr) const;
+
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+
+private:
+    enum class VarKind : uint8_t { Simple, Reserved, Fragment };
+
+    struct Edge {
+        VarKind kind;
+        std::string name;
+        uint32_t next;
+    };
+
+    struct Node {
+        std::vector<std::pair<char, uint32_t>> literals;
+        std::vector<Edge> vars;
+        std::optional<size_t> id;  // a template ends here
+    };
+
+    struct Capture {
+        const std::string* name;
+        std::string_view value;
+    };
+
+    uint32_t literal_child(uint32_t node, char c);
+    uint32_t var_child(uint32_t node, VarKind kind, std::string name);
+    bool walk(uint32_t node, std::string_view uri, size_t pos,
+              std::vector<Capture>& captures, size_t& id) const;
+
+    std::vector<Node> nodes_{1};  // nodes_[0] is the root
+    size_t size_ = 0;
+};
+
+} // namespace mcp
@@ -0,0 +1,65 @@
+"""
+tools/call throughput of any stdio MCP server with an "echo" tool taking
+{"text": ...}, e.g. examples/python/echo_server.py against the same
+server written with another SDK.
+
+Usage: python bench_stdio.py [--calls N] [--window W] [--size BYTES] -- COMMAND...
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--calls", type=int, default=20000)
+    parser.add_argument("--window", type=int, default=64, help="requests kept in flight")
+    parser.add_argument("--size", type=int, default=16, help="bytes of text per call")
+    parser.add_argument("command", nargs=argparse.REMAINDER)
+    args = parser.parse_args()
+    command = args.command[1:] if args.command[:1] == ["--"] else args.command
+    if not command:
+        parser.error("no server command")
+
+    proc = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+
+    def send(message):
+        proc.stdin.write(json.dumps(message).encode() + b"\n")
+
+    def receive():
+        while True:
+            message = json.loads(proc.stdout.readline())
+            if "id" in message:
+                return message
+
+    send({"jsonrpc": "2.0", "id": 0, "method": "initialize", "params": {
+        "protocolVersion": "2025-06-18", "capabilities": {},
+        "clientInfo": {"name": "bench_stdio", "version": "1.0"}}})
+    proc.stdin.flush()
+    receive()
+    send({"jsonrpc": "2.0", "method": "notifications/initialized"})
+
+    text = "x" * args.size
+    sent = done = errors = 0
+    start = time.perf_counter()
+    while done < args.calls:
+        while sent < args.calls and sent - done < args.window:
+            sent += 1
+            send({"jsonrpc": "2.0", "id": sent, "method": "tools/call",
+                  "params": {"name": "echo", "arguments": {"text": text}}})
+        proc.stdin.flush()
+        if "error" in receive():
+            errors += 1
+        done += 1
+    elapsed = time.perf_counter() - start
+
+    proc.stdin.close()
+    proc.wait()
+    print(f"{done} calls in {elapsed:.3f} s: {done / elapsed:.0f} calls/s, {errors} errors")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,557 @@
+// Python bindings: McpServer with Python tool and resource handlers, on the
+// CPython C API.
+//
+// The transport, codec, router and schema checks run on the server's own
+// threads with the GIL released; a handler takes it only to run the Python
+// callable. Tools are registered with add_tool_raw, so arguments reach
+// Python as the JSON text from the wire: parsed by the json module for a
+// dict handler, or as a memoryview over the message buffer, uncopied, for
+// a raw=True one. Results go back the same way, without a C++ DOM.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "mcp/server.hpp"
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace mcp;
+
+namespace {
+
+// Holds the GIL for its scope, from any thread
+class Gil {
+public:
+    Gil() : state_(PyGILState_Ensure()) {}
+    ~Gil() { PyGILState_Release(state_); }
+
+    Gil(const Gil&) = delete;
+    Gil& operator=(const Gil&) = delete;
+
+private:
+    PyGILState_STATE state_;
+};
+
+// Lets go of the GIL for its scope
+class NoGil {
+public:
+    NoGil() : state_(PyEval_SaveThread()) {}
+    ~NoGil() { PyEval_RestoreThread(state_); }
+
+    NoGil(const NoGil&) = delete;
+    NoGil& operator=(const NoGil&) = delete;
+
+private:
+    PyThreadState* state_;
+};
+
+// An owned reference
+class Ref {
+public:
+    Ref() = default;
+    explicit Ref(PyObject* p) : p_(p) {}  // steals
+    ~Ref() { Py_XDECREF(p_); }
+
+    Ref(Ref&& o) noexcept : p_(std::exchange(o.p_, nullptr)) {}
+    Ref& operator=(Ref&& o) noexcept {
+        std::swap(p_, o.p_);
+        return *this;
+    }
+    Ref(const Ref&) = delete;
+    Ref& operator=(const Ref&) = delete;
+
+    [[nodiscard]] PyObject* get() const noexcept { return p_; }
+    PyObject* release() noexcept { return std::exchange(p_, nullptr); }
+
+private:
+    PyObject* p_ = nullptr;
+};
+
+// A Python call failed; its exception is still pending
+struct PythonError {};
+
+Ref check(PyObject* p) {
+    if (!p) throw PythonError{};
+    return Ref(p);
+}
+
+// Clears the pending exception and returns its message
+std::string take_error_message() {
+    PyObject *type = nullptr, *value = nullptr, *tb = nullptr;
+    PyErr_Fetch(&type, &value, &tb);
+    PyErr_NormalizeException(&type, &value, &tb);
+    Ref owned_type(type), owned_value(value), owned_tb(tb);
+    std::string message;
+    if (value) {
+        Ref text(PyObject_Str(value));
+        const char* utf8 = text.get() ? PyUnicode_AsUTF8(text.get()) : nullptr;
+        if (utf8) message = utf8;
+    }
+    if (message.empty() && type) message = reinterpret_cast<PyTypeObject*>(type)->tp_name;
+    PyErr_Clear();
+    return message;
+}
+
+std::string utf8(PyObject* str) {
+    Py_ssize_t size = 0;
+    const char* data = PyUnicode_AsUTF8AndSize(str, &size);
+    if (!data) throw PythonError{};
+    return std::string(data, static_cast<size_t>(size));
+}
+
+std::optional<std::string> optional_str(PyObject* obj, const char* what) {
+    if (!obj || obj == Py_None) return std::nullopt;
+    if (!PyUnicode_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "%s must be a str", what);
+        throw PythonError{};
+    }
+    return utf8(obj);
+}
+
+// Copies out any object with the buffer protocol
+std::string buffer_bytes(PyObject* obj) {
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_SIMPLE) != 0) throw PythonError{};
+    std::string out(static_cast<const char*>(view.buf), static_cast<size_t>(view.len));
+    PyBuffer_Release(&view);
+    return out;
+}
+
+// For methods called from Python: C++ exceptions become Python ones
+template<typename F>
+PyObject* guarded(F&& f) {
+    try {
+        return f();
+    } catch (const PythonError&) {
+        return nullptr;
+    } catch (const std::invalid_argument& e) {
+        PyErr_SetString(PyExc_ValueError, e.what());
+    } catch (const std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+    }
+    return nullptr;
+}
+
+// For handlers called by the server: runs `f` under the GIL; a Python
+// exception leaves as std::runtime_error, which the server reports
+template<typename F>
+auto with_gil(F&& f) {
+    Gil gil;
+    try {
+        return f();
+    } catch (const PythonError&) {
+        throw std::runtime_error(take_error_message());
+    }
+}
+
+// A Python callable the server's threads may copy and drop without the GIL
+class PyCallable {
+public:
+    explicit PyCallable(PyObject* fn)
+        : fn_(Py_NewRef(fn), [](PyObject* f) {
+              if (!Py_IsInitialized()) return;  // dropped after exit: leaked
+              Gil gil;
+              Py_DECREF(f);
+          }) {}
+
+    // Call with the GIL held
+    Ref operator()(PyObject* arg) const { return check(PyObject_CallOneArg(fn_.get(), arg)); }
+
+private:
+    std::shared_ptr<PyObject> fn_;
+};
+
+// A read-only memoryview over the arguments, released when the call ends
+// so the handler can't read the buffer afterwards. Releasing fails if the
+// handler still exports it (say, as a numpy array); that reference then
+// outlives the buffer, as documented.
+class ArgumentsView {
+public:
+    explicit ArgumentsView(std::string_view text)
+        : view_(check(PyMemoryView_FromMemory(const_cast<char*>(text.data()),
+                                              static_cast<Py_ssize_t>(text.size()), PyBUF_READ))) {}
+
+    ~ArgumentsView() {
+        // Keep a handler's exception for the caller
+        PyObject *type, *value, *tb;
+        PyErr_Fetch(&type, &value, &tb);
+        Ref done(PyObject_CallMethod(view_.get(), "release", nullptr));
+        if (!done.get()) PyErr_Clear();
+        PyErr_Restore(type, value, tb);
+    }
+
+    ArgumentsView(const ArgumentsView&) = delete;
+    ArgumentsView& operator=(const ArgumentsView&) = delete;
+
+    [[nodiscard]] PyObject* get() const noexcept { return view_.get(); }
+
+private:
+    Ref view_;
+};
+
+struct ServerObject {
+    PyObject_HEAD
+    McpServer* server;
+    PyObject* json_loads;
+    PyObject* json_dumps;
+};
+
+McpServer& server_of(ServerObject* self) {
+    if (!self->server) throw std::runtime_error("McpServer.__init__ was not called");
+    return *self->server;
+}
+
+std::string dumps(ServerObject* self, PyObject* obj) {
+    Ref args(PyTuple_Pack(1, obj));
+    Ref kwargs(Py_BuildValue("{s:(ss),s:O}", "separators", ",", ":", "ensure_ascii", Py_False));
+    if (!args.get() || !kwargs.get()) throw PythonError{};
+    Ref text = check(PyObject_Call(self->json_dumps, args.get(), kwargs.get()));
+    return utf8(text.get());
+}
+
+nlohmann::json to_json(ServerObject* self, PyObject* obj) {
+    return nlohmann::json::parse(dumps(self, obj));
+}
+
+std::optional<std::string> docstring(PyObject* fn) {
+    Ref doc(PyObject_GetAttrString(fn, "__doc__"));
+    if (!doc.get()) {
+        PyErr_Clear();
+        return std::nullopt;
+    }
+    return optional_str(doc.get(), "__doc__");
+}
+
+std::string name_of(PyObject* fn) {
+    Ref name = check(PyObject_GetAttrString(fn, "__name__"));
+    return utf8(name.get());
+}
+
+// str: text; bytes-like: blob; a dict or a list of them: ResourceContent JSON
+std::vector<ResourceContent> to_contents(ServerObject* self, PyObject* result, const std::string& uri,
+                                         const std::optional<std::string>& mime_type) {
+    if (PyUnicode_Check(result)) {
+        return {ResourceContent{uri, mime_type, utf8(result), std::nullopt}};
+    }
+    if (PyObject_CheckBuffer(result)) {
+        return {ResourceContent::from_bytes(uri, buffer_bytes(result), mime_type)};
+    }
+    auto j = to_json(self, result);
+    if (j.is_object()) j = nlohmann::json::array({std::move(j)});
+    return j.get<std::vector<ResourceContent>>();
+}
+
+// ---- Registration, run by the decorators ----
+
+void add_tool(ServerObject* self, PyObject* fn, PyObject* name, PyObject* description,
+              PyObject* input_schema, PyObject* title, PyObject* annotations, bool raw) {
+    ToolDefinition def;
+    auto given_name = optional_str(name, "name");
+    def.name = given_name ? *given_name : name_of(fn);
+    def.title = optional_str(title, "title");
+    def.description = optional_str(description, "description");
+    if (!def.description) def.description = docstring(fn);
+    def.input_schema = input_schema == Py_None ? nlohmann::json{{"type", "object"}}
+                                               : to_json(self, input_schema);
+    if (annotations != Py_None) def.annotations = to_json(self, annotations);
+
+    PyCallable call(fn);
+    auto& server = server_of(self);
+    if (raw) {
+        server.add_tool_raw(std::move(def), [call](std::string_view arguments) {
+            return with_gil([&] {
+                Ref result;
+                {
+                    ArgumentsView view(arguments);
+                    result = call(view.get());
+                }
+                RawJson out;
+                out.text = PyUnicode_Check(result.get()) ? utf8(result.get()) : buffer_bytes(result.get());
+                return out;
+            });
+        });
+        return;
+    }
+    server.add_tool_raw(std::move(def), [self, call](std::string_view arguments) {
+        return with_gil([&] {
+            Ref text = check(PyUnicode_DecodeUTF8(arguments.data(),
+                                                  static_cast<Py_ssize_t>(arguments.size()), "strict"));
+            Ref parsed = check(PyObject_CallOneArg(self->json_loads, text.get()));
+            Ref result = call(parsed.get());
+            RawJson out;
+            if (PyUnicode_Check(result.get())) {
+                CallToolResult text_result;
+                text_result.content.push_back(TextContent{utf8(result.get()), std::nullopt});
+                JsonWriter w(out.text);
+                write_json(w, text_result);
+            } else {
+                out.text = dumps(self, result.get());
+            }
+            return out;
+        });
+    });
+}
+
+void add_resource(ServerObject* self, PyObject* fn, PyObject* uri, PyObject* uri_template, PyObject* name,
+                  PyObject* description, PyObject* mime_type) {
+    auto fixed_uri = optional_str(uri, "uri");
+    auto template_uri = optional_str(uri_template, "uri_template");
+    if (fixed_uri.has_value() == template_uri.has_value()) {
+        throw std::invalid_argument("resource() takes one of uri or uri_template");
+    }
+    auto given_name = optional_str(name, "name");
+    std::string resource_name = given_name ? *given_name : name_of(fn);
+    auto desc = optional_str(description, "description");
+    if (!desc) desc = docstring(fn);
+    auto mime = optional_str(mime_type, "mime_type");
+
+    PyCallable call(fn);
+    ResourceReadHandler read = [self, call, mime](const std::string& read_uri) {
+        return with_gil([&] {
+            Ref arg = check(PyUnicode_FromStringAndSize(read_uri.data(),
+                                                        static_cast<Py_ssize_t>(read_uri.size())));
+            Ref result = call(arg.get());
+            return to_contents(self, result.get(), read_uri, mime);
+        });
+    };
+    auto& server = server_of(self);
+    if (template_uri) {
+        server.add_resource_template(
+            ResourceTemplate{*template_uri, resource_name, std::nullopt, desc, mime, std::nullopt},
+            std::move(read));
+    } else {
+        server.add_resource(
+            ResourceDefinition{*fixed_uri, resource_name, std::nullopt, desc, mime, std::nullopt,
+                               std::nullopt},
+            std::move(read));
+    }
+}
+
+// A decorator is a builtin bound to (server, kind, options...), so it
+// keeps its server alive for as long as it is itself referenced
+enum DecoratorKind { ToolDecorator, ResourceDecorator };
+
+PyObject* decorate(PyObject* bound, PyObject* fn) {
+    return guarded([&]() -> PyObject* {
+        if (!PyCallable_Check(fn)) {
+            PyErr_SetString(PyExc_TypeError, "the decorated object must be callable");
+            return nullptr;
+        }
+        auto* self = reinterpret_cast<ServerObject*>(PyTuple_GET_ITEM(bound, 0));
+        auto item = [bound](Py_ssize_t i) { return PyTuple_GET_ITEM(bound, i); };
+        if (PyLong_AsLong(item(1)) == ToolDecorator) {
+            add_tool(self, fn, item(2), item(3), item(4), item(5), item(6), PyObject_IsTrue(item(7)) == 1);
+        } else {
+            add_resource(self, fn, item(2), item(3), item(4), item(5), item(6));
+        }
+        return Py_NewRef(fn);
+    });
+}
+
+PyMethodDef decorate_def = {"decorator", decorate, METH_O, "Registers the decorated handler."};
+
+PyObject* make_decorator(PyObject* bound) {
+    if (!bound) return nullptr;
+    Ref owned(bound);
+    return PyCFunction_New(&decorate_def, owned.get());
+}
+
+// ---- McpServer methods ----
+
+int server_init(PyObject* obj, PyObject* args, PyObject* kwargs) {
+    auto* self = reinterpret_cast<ServerObject*>(obj);
+    static const char* kwlist[] = {"name", "version", "instructions", "thread_pool_size",
+                                   "validate_tool_schemas", nullptr};
+    const char* name = nullptr;
+    const char* version = "1.0.0";
+    PyObject* instructions = Py_None;
+    int thread_pool_size = -1;
+    int validate_tool_schemas = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|sOip", const_cast<char**>(kwlist), &name, &version,
+                                     &instructions, &thread_pool_size, &validate_tool_schemas)) {
+        return -1;
+    }
+    PyObject* result = guarded([&]() -> PyObject* {
+        Ref json = check(PyImport_ImportModule("json"));
+        Ref loads = check(PyObject_GetAttrString(json.get(), "loads"));
+        Ref dumps_fn = check(PyObject_GetAttrString(json.get(), "dumps"));
+        McpServer::Options opts;
+        opts.server_info = {name, std::nullopt, version};
+        opts.instructions = optional_str(instructions, "instructions");
+        if (thread_pool_size >= 0) opts.thread_pool_size = thread_pool_size;
+        opts.validate_tool_schemas = validate_tool_schemas != 0;
+        auto server = std::make_unique<McpServer>(std::move(opts));
+        if (self->server) {
+            NoGil nogil;
+            delete self->server;
+        }
+        self->server = server.release();
+        Py_XSETREF(self->json_loads, loads.release());
+        Py_XSETREF(self->json_dumps, dumps_fn.release());
+        return Py_NewRef(Py_None);
+    });
+    if (!result) return -1;
+    Py_DECREF(result);
+    return 0;
+}
+
+void server_dealloc(PyObject* obj) {
+    auto* self = reinterpret_cast<ServerObject*>(obj);
+    if (self->server) {
+        // Workers may be waiting for the GIL in a handler
+        NoGil nogil;
+        delete self->server;
+    }
+    Py_XDECREF(self->json_loads);
+    Py_XDECREF(self->json_dumps);
+    PyTypeObject* type = Py_TYPE(obj);
+    type->tp_free(obj);
+    Py_DECREF(type);
+}
+
+PyObject* server_tool(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"name", "description", "input_schema", "title", "annotations", "raw",
+                                   nullptr};
+    PyObject *name = Py_None, *description = Py_None, *input_schema = Py_None, *title = Py_None,
+             *annotations = Py_None;
+    int raw = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|$OOOOOp", const_cast<char**>(kwlist), &name,
+                                     &description, &input_schema, &title, &annotations, &raw)) {
+        return nullptr;
+    }
+    return make_decorator(Py_BuildValue("(OiOOOOOO)", self, ToolDecorator, name, description, input_schema,
+                                        title, annotations, raw ? Py_True : Py_False));
+}
+
+PyObject* server_resource(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"uri", "uri_template", "name", "description", "mime_type", nullptr};
+    PyObject *uri = Py_None, *uri_template = Py_None, *name = Py_None, *description = Py_None,
+             *mime_type = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|$OOOOO", const_cast<char**>(kwlist), &uri,
+                                     &uri_template, &name, &description, &mime_type)) {
+        return nullptr;
+    }
+    return make_decorator(Py_BuildValue("(OiOOOOO)", self, ResourceDecorator, uri, uri_template, name,
+                                        description, mime_type));
+}
+
+PyObject* server_log(PyObject* obj, PyObject* args, PyObject* kwargs) {
+    auto* self = reinterpret_cast<ServerObject*>(obj);
+    static const char* kwlist[] = {"level", "logger", "data", nullptr};
+    const char* level = nullptr;
+    const char* logger = nullptr;
+    PyObject* data = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ssO", const_cast<char**>(kwlist), &level, &logger,
+                                     &data)) {
+        return nullptr;
+    }
+    return guarded([&]() -> PyObject* {
+        server_of(self).log(log_level_from_string(level), logger, [&] { return to_json(self, data); });
+        return Py_NewRef(Py_None);
+    });
+}
+
+PyObject* server_notify_resource_updated(PyObject* obj, PyObject* arg) {
+    auto* self = reinterpret_cast<ServerObject*>(obj);
+    return guarded([&]() -> PyObject* {
+        std::string uri = utf8(arg);
+        auto& server = server_of(self);
+        {
+            NoGil nogil;
+            server.notify_resource_updated(uri);
+        }
+        return Py_NewRef(Py_None);
+    });
+}
+
+// Runs `f` on the server without the GIL
+template<typename F>
+PyObject* serving(PyObject* obj, F f) {
+    auto* self = reinterpret_cast<ServerObject*>(obj);
+    return guarded([&]() -> PyObject* {
+        auto& server = server_of(self);
+        {
+            NoGil nogil;
+            f(server);
+        }
+        return Py_NewRef(Py_None);
+    });
+}
+
+PyObject* server_serve_stdio(PyObject* self, PyObject*) {
+    return serving(self, [](McpServer& server) { server.serve_stdio(); });
+}
+
+PyObject* server_serve_http(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"host", "port", nullptr};
+    const char* host = "127.0.0.1";
+    unsigned short port = 8080;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|sH", const_cast<char**>(kwlist), &host, &port)) {
+        return nullptr;
+    }
+    std::string host_name = host;
+    return serving(self, [&](McpServer& server) { server.serve_http(host_name, port); });
+}
+
+PyObject* server_shutdown(PyObject* self, PyObject*) {
+    return serving(self, [](McpServer& server) { server.shutdown(); });
+}
+
+PyMethodDef server_methods[] = {
+    {"tool", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(server_tool)),
+     METH_VARARGS | METH_KEYWORDS,
+     "tool(*, name=None, description=None, input_schema=None, title=None, annotations=None, raw=False)\n"
+     "Decorator registering a tool. The handler gets the arguments as a dict and\n"
+     "returns a CallToolResult dict, or a str for a text result. With raw=True it\n"
+     "gets a read-only memoryview of the arguments' JSON text, valid during the\n"
+     "call only, and returns the CallToolResult JSON as bytes-like or str."},
+    {"resource", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(server_resource)),
+     METH_VARARGS | METH_KEYWORDS,
+     "resource(*, uri=None, uri_template=None, name=None, description=None, mime_type=None)\n"
+     "Decorator registering a resource (uri) or resource template (uri_template).\n"
+     "The handler gets the URI read and returns a str (text), a bytes-like (blob),\n"
+     "or a content dict or list of them."},
+    {"log", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(server_log)),
+     METH_VARARGS | METH_KEYWORDS, "log(level, logger, data)"},
+    {"notify_resource_updated", server_notify_resource_updated, METH_O, "notify_resource_updated(uri)"},
+    {"serve_stdio", server_serve_stdio, METH_NOARGS, "Serves until stdin closes or shutdown()."},
+    {"serve_http", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(server_serve_http)),
+     METH_VARARGS | METH_KEYWORDS, "serve_http(host='127.0.0.1', port=8080)"},
+    {"shutdown", server_shutdown, METH_NOARGS, "Stops serving."},
+    {nullptr, nullptr, 0, nullptr}};
+
+PyType_Slot server_slots[] = {
+    {Py_tp_init, reinterpret_cast<void*>(server_init)},
+    {Py_tp_dealloc, reinterpret_cast<void*>(server_dealloc)},
+    {Py_tp_methods, server_methods},
+    {Py_tp_doc, const_cast<char*>(
+        "McpServer(name, version='1.0.0', instructions=None, thread_pool_size=-1,\n"
+        "          validate_tool_schemas=False)\n"
+        "thread_pool_size: request worker threads; -1 keeps the C++ default.\n"
+        "validate_tool_schemas: check tools/call arguments against input_schema in C++,\n"
+        "before the handler is called.")},
+    {0, nullptr}};
+
+PyType_Spec server_spec = {"mcpxx.McpServer", sizeof(ServerObject), 0, Py_TPFLAGS_DEFAULT, server_slots};
+
+int module_exec(PyObject* module) {
+    Ref type(PyType_FromSpec(&server_spec));
+    if (!type.get()) return -1;
+    return PyModule_AddObjectRef(module, "McpServer", type.get());
+}
+
+PyModuleDef_Slot module_slots[] = {
+    {Py_mod_exec, reinterpret_cast<void*>(module_exec)},
+    {0, nullptr}};
+
+PyModuleDef module_def = {
+    PyModuleDef_HEAD_INIT, "mcpxx", "MCP servers in Python on the mcpxx C++ runtime", 0,
+    nullptr, module_slots, nullptr, nullptr, nullptr};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_mcpxx() {
+    return PyModuleDef_Init(&module_def);
+}
@@ -0,0 +1,201 @@
+"""
+End-to-end tests for the mcpxx module: this file, run with --serve, is a
+stdio server; the tests talk JSON-RPC to it.
+"""
+
+import base64
+import gc
+import json
+import subprocess
+import sys
+import unittest
+
+
+def serve():
+    import mcpxx
+
+    server = mcpxx.McpServer(name="bindings-test", version="1.0.0", thread_pool_size=4,
+                             validate_tool_schemas=True)
+    runs = {"echo": 0}
+    kept = []
+
+    @server.tool(input_schema={
+        "type": "object",
+        "properties": {"text": {"type": "string"}},
+        "required": ["text"],
+    })
+    def echo(arguments):
+        """Echo the text back"""
+        runs["echo"] += 1
+        return {"content": [{"type": "text", "text": arguments["text"]}]}
+
+    @server.tool(name="upper")
+    def upper_text(arguments):
+        return arguments["text"].upper()
+
+    @server.tool(raw=True)
+    def raw_echo(view):
+        # The arguments JSON text, untouched, as the text of the result
+        text = json.dumps(bytes(view).decode())
+        return b'{"content":[{"type":"text","text":' + text.encode() + b"}]}"
+
+    @server.tool()
+    def echo_runs(arguments):
+        return str(runs["echo"])
+
+    @server.tool()
+    def fail(arguments):
+        raise ValueError("no good")
+
+    @server.tool(raw=True)
+    def keep_view(view):
+        kept.append(view)
+        return '{"content":[]}'
+
+    @server.tool()
+    def read_kept(arguments):
+        return bytes(kept[-1]).decode()
+
+    @server.resource(uri="mem://greeting", mime_type="text/plain")
+    def greeting(uri):
+        return "hello from " + uri
+
+    @server.resource(uri_template="blob://{name}")
+    def blob(uri):
+        return bytes(range(4))
+
+    server.serve_stdio()
+
+
+class Connection:
+    def __init__(self):
+        self.proc = subprocess.Popen([sys.executable, __file__, "--serve"],
+                                     stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        self.next_id = 0
+        self.request("initialize", {
+            "protocolVersion": "2025-06-18",
+            "capabilities": {},
+            "clientInfo": {"name": "test", "version": "1.0"},
+        })
+        self.send({"jsonrpc": "2.0", "method": "notifications/initialized"})
+
+    def send(self, message):
+        self.proc.stdin.write(json.dumps(message).encode() + b"\n")
+        self.proc.stdin.flush()
+
+    def request(self, method, params):
+        self.next_id += 1
+        self.send({"jsonrpc": "2.0", "id": self.next_id, "method": method, "params": params})
+        while True:
+            message = json.loads(self.proc.stdout.readline())
+            if message.get("id") == self.next_id:
+                return message
+
+    def close(self):
+        self.proc.stdin.close()
+        code = self.proc.wait(timeout=10)
+        self.proc.stdout.close()
+        return code
+
+
+class BindingsTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.conn = Connection()
+
+    @classmethod
+    def tearDownClass(cls):
+        # The server is freed on the way out, dropping its handlers
+        assert cls.conn.close() == 0
+
+    def call(self, name, arguments):
+        return self.conn.request("tools/call", {"name": name, "arguments": arguments})["result"]
+
+    def test_lists_tools_with_their_schemas(self):
+        tools = {t["name"]: t for t in self.conn.request("tools/list", {})["result"]["tools"]}
+        self.assertEqual(set(tools), {"echo", "upper", "raw_echo", "echo_runs", "fail",
+                                      "keep_view", "read_kept"})
+        self.assertEqual(tools["echo"]["description"], "Echo the text back")
+        self.assertEqual(tools["echo"]["inputSchema"]["required"], ["text"])
+
+    def test_dict_handler(self):
+        result = self.call("echo", {"text": "héllo"})
+        self.assertEqual(result["content"], [{"type": "text", "text": "héllo"}])
+
+    def test_str_result_is_text_content(self):
+        self.assertEqual(self.call("upper", {"text": "abc"})["content"][0]["text"], "ABC")
+
+    def test_raw_handler_sees_the_wire_text(self):
+        self.conn.send({"jsonrpc": "2.0", "id": "raw", "method": "tools/call",
+                        "params": {"name": "raw_echo", "arguments": {"b": [1, 2], "a": None}}})
+        while True:
+            message = json.loads(self.conn.proc.stdout.readline())
+            if message.get("id") == "raw":
+                break
+        text = message["result"]["content"][0]["text"]
+        self.assertEqual(json.loads(text), {"b": [1, 2], "a": None})
+
+    def test_schema_is_checked_before_python_runs(self):
+        before = self.call("echo_runs", {})["content"][0]["text"]
+        response = self.conn.request("tools/call", {"name": "echo", "arguments": {}})
+        self.assertEqual(response["error"]["code"], -32602)
+        self.assertIn("Invalid arguments", response["error"]["message"])
+        self.assertEqual(self.call("echo_runs", {})["content"][0]["text"], before)
+
+    def test_raw_view_is_released_after_the_call(self):
+        self.assertNotIn("isError", self.call("keep_view", {"x": 1}))
+        result = self.call("read_kept", {})
+        self.assertTrue(result["isError"])
+        self.assertIn("released", result["content"][0]["text"])
+
+    def test_exception_is_an_error_result(self):
+        result = self.call("fail", {})
+        self.assertTrue(result["isError"])
+        self.assertIn("no good", result["content"][0]["text"])
+
+    def test_text_resource(self):
+        contents = self.conn.request("resources/read", {"uri": "mem://greeting"})["result"]["contents"]
+        self.assertEqual(contents[0]["text"], "hello from mem://greeting")
+        self.assertEqual(contents[0]["mimeType"], "text/plain")
+
+    def test_bytes_resource_is_a_blob(self):
+        contents = self.conn.request("resources/read", {"uri": "blob://x"})["result"]["contents"]
+        self.assertEqual(base64.b64decode(contents[0]["blob"]), bytes(range(4)))
+
+
+
+class InProcessTest(unittest.TestCase):
+    def setUp(self):
+        import mcpxx
+        self.mcpxx = mcpxx
+
+    def test_decorator_keeps_its_server_alive(self):
+        def decorator():
+            return self.mcpxx.McpServer(name="transient").tool(name="late")
+        late = decorator()
+        gc.collect()
+        handler = lambda arguments: "ok"
+        self.assertIs(late(handler), handler)
+
+    def test_resource_needs_one_of_uri_and_template(self):
+        server = self.mcpxx.McpServer(name="bad")
+        with self.assertRaises(ValueError):
+            server.resource()(lambda uri: "")
+        with self.assertRaises(ValueError):
+            server.resource(uri="a://b", uri_template="a://{b}")(lambda uri: "")
+
+    def test_bad_arguments_raise(self):
+        server = self.mcpxx.McpServer(name="bad")
+        with self.assertRaises(TypeError):
+            server.tool()(42)
+        with self.assertRaises(TypeError):
+            server.tool(name=1)(lambda arguments: "")
+        with self.assertRaises(ValueError):
+            server.log("loud", "test", "x")
+
+
+if __name__ == "__main__":
+    if "--serve" in sys.argv:
+        serve()
+    else:
+        unittest.main()
@@ -0,0 +1,69 @@
+#include "mcp/arena.hpp"
+#include <algorithm>
+#include <new>
+
+namespace mcp {
+
+ScratchArena::Scope::Scope(ScratchArena& arena) noexcept
+    : arena_(arena), block_(arena.block_), offset_(arena.offset_) {
+    ++arena_.depth_;
+}
+
+ScratchArena::Scope::~Scope() {
+    --arena_.depth_;
+    arena_.rewind(block_, offset_);
+}
+
+ScratchArena::~ScratchArena() {
+    for (auto& b : blocks_) ::operator delete(b.data);
+}
+
+ScratchArena& ScratchArena::local() {
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+size_t ScratchArena::capacity() const noexcept {
+    size_t total = 0;
+    for (const auto& b : blocks_) total += b.size;
+    return total;
+}
+
+void* ScratchArena::do_allocate(size_t bytes, size_t alignment) {
+    // Blocks come from ::operator new, so they start max_align_t-aligned
+    for (; block_ < blocks_.size(); ++block_, offset_ = 0) {
+        size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= blocks_[block_].size) {
+            offset_ = start + bytes;
+            return blocks_[block_].data + start;
+        }
+    }
+
+    // Nothing left fits: append a block big enough for this request
+    size_t size = std::max(kBlockBytes, bytes + alignment);
+    blocks_.push_back({static_cast<char*>(::operator new(size)), size});
+    block_ = blocks_.size() - 1;
+    offset_ = bytes;
+    return blocks_.back().data;
+}
+
+void ScratchArena::rewind(size_t block, size_t offset) noexcept {
+    block_ = block;
+    offset_ = offset;
+    if (depth_ > 0) return;
+
+    // Outermost scope: drop blocks past the retention budget so one huge
+    // message doesn't pin its buffer for the life of the thread.
+    size_t kept = 0;
+    size_t keep = 0;
+    for (; keep < blocks_.size(); ++keep) {
+        if (kept + blocks_[keep].size > kRetainBytes) break;
+        kept += blocks_[keep].size;
+    }
+    for (size_t i = keep; i < blocks_.size(); ++i) ::operator delete(blocks_[i].data);
+    blocks_.resize(keep);
+    block_ = 0;
+    offset_ = 0;
+}
+
+} // namespace mcp
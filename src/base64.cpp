@@ -0,0 +1,317 @@
+#include "mcp/base64.hpp"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#if !defined(MCPXX_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MCPXX_BASE64_AVX2 1
+#include <immintrin.h>
+#elif !defined(MCPXX_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define MCPXX_BASE64_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace mcp::base64 {
+
+static constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Alphabet index by character; -1 for characters outside it
+static constexpr std::array<int8_t, 256> kDecode = [] {
+    std::array<int8_t, 256> t{};
+    t.fill(-1);
+    for (int i = 0; i < 64; ++i) t[static_cast<unsigned char>(kAlphabet[i])] = static_cast<int8_t>(i);
+    return t;
+}();
+
+// Bytes the vector decoder may write past the end of its output
+static constexpr size_t kDecodeSlack = 8;
+
+// ---------- Scalar ----------
+
+// Encodes whole 3-byte groups of `in` into `out`, which has room for them
+static void encode_groups(char* out, const unsigned char* in, size_t groups) {
+    for (size_t g = 0; g < groups; ++g, in += 3, out += 4) {
+        uint32_t v = (uint32_t(in[0]) << 16) | (uint32_t(in[1]) << 8) | in[2];
+        out[0] = kAlphabet[(v >> 18) & 0x3F];
+        out[1] = kAlphabet[(v >> 12) & 0x3F];
+        out[2] = kAlphabet[(v >> 6) & 0x3F];
+        out[3] = kAlphabet[v & 0x3F];
+    }
+}
+
+// Encodes the final 1 or 2 bytes with padding
+static void encode_tail(std::string& out, const unsigned char* in, size_t n) {
+    uint32_t v = uint32_t(in[0]) << 16;
+    if (n > 1) v |= uint32_t(in[1]) << 8;
+    out += kAlphabet[(v >> 18) & 0x3F];
+    out += kAlphabet[(v >> 12) & 0x3F];
+    out += n > 1 ? kAlphabet[(v >> 6) & 0x3F] : '=';
+    out += '=';
+}
+
+// Decodes the first `digits` (2..4) characters of a quad into digits - 1 bytes
+static void decode_quad(char* out, const char* in, size_t digits) {
+    uint32_t v = 0;
+    for (size_t k = 0; k < 4; ++k) {
+        int8_t d = 0;
+        if (k < digits) {
+            d = kDecode[static_cast<unsigned char>(in[k])];
+            if (d < 0) throw std::invalid_argument("base64: invalid character");
+        }
+        v = (v << 6) | static_cast<uint32_t>(d);
+    }
+    out[0] = static_cast<char>((v >> 16) & 0xFF);
+    if (digits > 2) out[1] = static_cast<char>((v >> 8) & 0xFF);
+    if (digits > 3) out[2] = static_cast<char>(v & 0xFF);
+}
+
+// ---------- Vector kernels ----------
+//
+// Each handles a prefix of its input and returns how much it consumed (whole
+// 3-byte groups or 4-character quads); the scalar code finishes the rest.
+// Decoders stop before the first block holding anything outside the
+// alphabet, padding included, and leave reporting it to the scalar code.
+
+#if defined(MCPXX_BASE64_AVX2)
+
+// Spreads 24 bytes (12 per lane, read at offset 4 of the low lane) into 32
+// six-bit indices; W. Muła and D. Lemire, "Faster Base64 Encoding and
+// Decoding using AVX2 Instructions".
+__attribute__((target("avx2"))) static __m256i avx2_enc_reshuffle(__m256i in) {
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(
+        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+        14, 15, 13, 14, 11, 12, 10, 11, 8, 9, 7, 8, 5, 6, 4, 5));
+    __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    return _mm256_or_si256(t1, t3);
+}
+
+// Maps indices 0..63 to the alphabet by adding a per-range offset
+__attribute__((target("avx2"))) static __m256i avx2_enc_translate(__m256i in) {
+    const __m256i lut = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m256i indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+    __m256i mask = _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25));
+    indices = _mm256_sub_epi8(indices, mask);
+    return _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices));
+}
+
+__attribute__((target("avx2")))
+static size_t encode_avx2(char* out, const unsigned char* in, size_t n) {
+    if (n < 32) return 0;
+    // Loads start 4 bytes before the data they encode, so the first two
+    // groups go through the scalar path
+    encode_groups(out, in, 2);
+    size_t i = 6;
+    char* o = out + 8;
+    for (; i + 28 <= n; i += 24, o += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i - 4));
+        v = avx2_enc_translate(avx2_enc_reshuffle(v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), v);
+    }
+    return i;
+}
+
+// Packs 32 six-bit values into 24 bytes at the start of the register
+__attribute__((target("avx2"))) static __m256i avx2_dec_reshuffle(__m256i in) {
+    __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+    __m256i out = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    out = _mm256_shuffle_epi8(out, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    return _mm256_permutevar8x32_epi32(out, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(char* out, const char* in, size_t n) {
+    // Nibble classes: a character is valid iff its two classes don't overlap
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32, out += 24) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+        __m256i lo_nibbles = _mm256_and_si256(v, mask_2f);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) break;
+
+        __m256i eq_2f = _mm256_cmpeq_epi8(v, mask_2f);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        v = avx2_dec_reshuffle(_mm256_add_epi8(v, roll));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);  // 24 bytes + 8 of slack
+    }
+    return i;
+}
+
+#elif defined(MCPXX_BASE64_NEON)
+
+static uint8x16x4_t neon_table(const uint8_t* t) {
+    return {{vld1q_u8(t), vld1q_u8(t + 16), vld1q_u8(t + 32), vld1q_u8(t + 48)}};
+}
+
+static size_t encode_neon(char* out, const unsigned char* in, size_t n) {
+    const uint8x16x4_t table = neon_table(reinterpret_cast<const uint8_t*>(kAlphabet));
+    const uint8x16_t mask = vdupq_n_u8(0x3F);
+    size_t i = 0;
+    for (; i + 48 <= n; i += 48, out += 64) {
+        uint8x16x3_t v = vld3q_u8(in + i);
+        uint8x16x4_t idx;
+        idx.val[0] = vshrq_n_u8(v.val[0], 2);
+        idx.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), mask);
+        idx.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), mask);
+        idx.val[3] = vandq_u8(v.val[2], mask);
+        for (auto& x : idx.val) x = vqtbl4q_u8(table, x);
+        vst4q_u8(reinterpret_cast<uint8_t*>(out), idx);
+    }
+    return i;
+}
+
+static size_t decode_neon(char* out, const char* in, size_t n) {
+    const auto* t = reinterpret_cast<const uint8_t*>(kDecode.data());
+    const uint8x16x4_t lo = neon_table(t);        // characters 0..63
+    const uint8x16x4_t hi = neon_table(t + 64);   // characters 64..127
+    const uint8x16_t k64 = vdupq_n_u8(64);
+    const uint8x16_t k128 = vdupq_n_u8(128);
+
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64, out += 48) {
+        uint8x16x4_t v = vld4q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        uint8x16_t bad = vdupq_n_u8(0);
+        for (auto& c : v.val) {
+            uint8x16_t d = vqtbl4q_u8(lo, c);
+            d = vqtbx4q_u8(d, hi, vsubq_u8(c, k64));
+            d = vorrq_u8(d, vcgeq_u8(c, k128));  // non-ASCII: 0xFF
+            bad = vorrq_u8(bad, d);
+            c = d;
+        }
+        if (vmaxvq_u8(bad) > 63) break;
+
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(v.val[0], 2), vshrq_n_u8(v.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(v.val[1], 4), vshrq_n_u8(v.val[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(v.val[2], 6), v.val[3]);
+        vst3q_u8(reinterpret_cast<uint8_t*>(out), bytes);
+    }
+    return i;
+}
+
+#endif
+
+// ---------- Dispatch ----------
+
+struct Kernels {
+    size_t (*encode)(char* out, const unsigned char* in, size_t n);
+    size_t (*decode)(char* out, const char* in, size_t n);
+    std::string_view name;
+};
+
+static size_t encode_none(char*, const unsigned char*, size_t) { return 0; }
+static size_t decode_none(char*, const char*, size_t) { return 0; }
+
+static Kernels select_kernels() {
+#if defined(MCPXX_BASE64_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {encode_avx2, decode_avx2, "avx2"};
+#elif defined(MCPXX_BASE64_NEON)
+    return {encode_neon, decode_neon, "neon"};
+#endif
+    return {encode_none, decode_none, "scalar"};
+}
+
+static const Kernels& kernels() {
+    static const Kernels k = select_kernels();
+    return k;
+}
+
+// Encodes `groups` whole 3-byte groups, vectorized where possible
+static void encode_bulk(char* out, const unsigned char* in, size_t groups) {
+    size_t done = kernels().encode(out, in, groups * 3);
+    encode_groups(out + done / 3 * 4, in + done, groups - done / 3);
+}
+
+std::string_view implementation() {
+    return kernels().name;
+}
+
+void encode_to(std::string& out, std::string_view bytes) {
+    const auto* in = reinterpret_cast<const unsigned char*>(bytes.data());
+    size_t groups = bytes.size() / 3;
+    size_t start = out.size();
+    out.reserve(start + encoded_size(bytes.size()));
+    out.resize(start + groups * 4);
+    encode_bulk(out.data() + start, in, groups);
+    if (size_t rest = bytes.size() % 3) encode_tail(out, in + groups * 3, rest);
+}
+
+std::string encode(std::string_view bytes) {
+    std::string out;
+    encode_to(out, bytes);
+    return out;
+}
+
+std::string decode(std::string_view text) {
+    if (text.size() % 4 != 0) throw std::invalid_argument("base64: length is not a multiple of 4");
+    if (text.empty()) return {};
+
+    // The last quad may carry padding; everything before it is 4 digits
+    size_t body = text.size() - 4;
+    std::string out;
+    out.resize(text.size() / 4 * 3 + kDecodeSlack);
+    size_t i = kernels().decode(out.data(), text.data(), body);
+    size_t o = i / 4 * 3;
+    for (; i < body; i += 4, o += 3) decode_quad(out.data() + o, text.data() + i, 4);
+
+    size_t padding = text.back() != '=' ? 0 : text[text.size() - 2] == '=' ? 2 : 1;
+    decode_quad(out.data() + o, text.data() + body, 4 - padding);
+    out.resize(o + 3 - padding);
+    return out;
+}
+
+void Encoder::update(std::string& out, std::string_view bytes) {
+    const auto* in = reinterpret_cast<const unsigned char*>(bytes.data());
+    size_t n = bytes.size();
+
+    // Complete a group started by the previous call
+    if (pending_size_ > 0) {
+        while (pending_size_ < 2 && n > 0) {
+            pending_[pending_size_++] = *in++;
+            --n;
+        }
+        if (n == 0) return;
+        unsigned char group[3] = {pending_[0], pending_[1], *in++};
+        --n;
+        size_t start = out.size();
+        out.resize(start + 4);
+        encode_groups(out.data() + start, group, 1);
+        pending_size_ = 0;
+    }
+
+    size_t groups = n / 3;
+    size_t start = out.size();
+    out.resize(start + groups * 4);
+    encode_bulk(out.data() + start, in, groups);
+    in += groups * 3;
+    n -= groups * 3;
+    for (size_t i = 0; i < n; ++i) pending_[pending_size_++] = in[i];
+}
+
+void Encoder::finish(std::string& out) {
+    if (pending_size_ > 0) encode_tail(out, pending_, pending_size_);
+    pending_size_ = 0;
+}
+
+} // namespace mcp::base64
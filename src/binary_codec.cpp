@@ -0,0 +1,103 @@
+#include "mcp/binary_codec.hpp"
+#include "mcp/codec.hpp"
+#include "mcp/error.hpp"
+
+namespace mcp {
+
+namespace {
+
+char format_byte(WireFormat format) {
+    switch (format) {
+    case WireFormat::MessagePack: return 'M';
+    case WireFormat::Cbor: return 'C';
+    case WireFormat::Json: break;
+    }
+    throw std::invalid_argument("JSON has no binary frame");
+}
+
+// Serializes `j` after a header, then fills the header in
+void write_frame(std::string& out, const nlohmann::json& j, WireFormat format) {
+    size_t start = out.size();
+    out.append(BinaryCodec::kFrameHeaderSize, '\0');
+    out[start + 1] = format_byte(format);
+    if (format == WireFormat::MessagePack) {
+        nlohmann::json::to_msgpack(j, out);
+    } else {
+        nlohmann::json::to_cbor(j, out);
+    }
+    size_t length = out.size() - start - BinaryCodec::kFrameHeaderSize;
+    if (length > UINT32_MAX) throw std::length_error("Message too large for a binary frame");
+    for (int i = 0; i < 4; ++i) {
+        out[start + 2 + i] = static_cast<char>((length >> (8 * (3 - i))) & 0xff);
+    }
+}
+
+} // anonymous namespace
+
+std::string_view to_string(WireFormat format) noexcept {
+    switch (format) {
+    case WireFormat::MessagePack: return "msgpack";
+    case WireFormat::Cbor: return "cbor";
+    case WireFormat::Json: break;
+    }
+    return "json";
+}
+
+std::optional<WireFormat> parse_wire_format(std::string_view name) noexcept {
+    if (name == "json") return WireFormat::Json;
+    if (name == "msgpack") return WireFormat::MessagePack;
+    if (name == "cbor") return WireFormat::Cbor;
+    return std::nullopt;
+}
+
+void BinaryCodec::encode_frame(std::string& out, const JsonRpcMessage& msg, WireFormat format) {
+    nlohmann::json j;
+    to_json(j, msg);
+    write_frame(out, j, format);
+}
+
+void BinaryCodec::encode_batch_frame(std::string& out, const std::vector<JsonRpcMessage>& msgs,
+                                     WireFormat format) {
+    nlohmann::json j = nlohmann::json::array();
+    for (const auto& msg : msgs) to_json(j.emplace_back(), msg);
+    write_frame(out, j, format);
+}
+
+std::pair<WireFormat, size_t> BinaryCodec::read_header(const char* header) {
+    WireFormat format;
+    switch (header[1]) {
+    case 'M': format = WireFormat::MessagePack; break;
+    case 'C': format = WireFormat::Cbor; break;
+    default: throw McpParseError("Unknown binary frame format");
+    }
+    size_t length = 0;
+    for (int i = 0; i < 4; ++i) {
+        length = (length << 8) | static_cast<unsigned char>(header[2 + i]);
+    }
+    return {format, length};
+}
+
+std::vector<JsonRpcMessage> BinaryCodec::decode(std::string_view payload, WireFormat format) {
+    nlohmann::json j;
+    try {
+        if (format == WireFormat::MessagePack) {
+            j = nlohmann::json::from_msgpack(payload.begin(), payload.end());
+        } else if (format == WireFormat::Cbor) {
+            j = nlohmann::json::from_cbor(payload.begin(), payload.end());
+        } else {
+            throw McpParseError("JSON has no binary frame");
+        }
+    } catch (const nlohmann::json::exception& e) {
+        throw McpParseError(std::string("Binary frame decode error: ") + e.what());
+    }
+    std::vector<JsonRpcMessage> msgs;
+    if (j.is_array()) {
+        msgs.reserve(j.size());
+        for (auto& item : j) msgs.push_back(Codec::from_dom(std::move(item)));
+    } else {
+        msgs.push_back(Codec::from_dom(std::move(j)));
+    }
+    return msgs;
+}
+
+} // namespace mcp
@@ -1,28 +1,82 @@
 #include "mcp/client.hpp"
 #include "mcp/codec.hpp"
 #include "mcp/session.hpp"
+#include "mcp/request_table.hpp"
+#include "mcp/timer_wheel.hpp"
 #include "mcp/router.hpp"
+#include "mcp/resource_cache.hpp"
 #include "mcp/error.hpp"
 #include "mcp/version.hpp"
 #include "mcp/transport/stdio_transport.hpp"
+#include "mcp/transport/event_loop_transport.hpp"
 #include "mcp/transport/http_transport.hpp"
+#include "mcp/transport/shm_transport.hpp"
 
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <fcntl.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
 #include <condition_variable>
 #include <future>
 #include <mutex>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace mcp {
 
+// Result of a paginated list request; `key` names the item array.
+template<typename T>
+static PaginatedResult<T> parse_page(const nlohmann::json& j, const char* key) {
+    PaginatedResult<T> result;
+    result.items = j.at(key).get<std::vector<T>>();
+    if (j.contains("nextCursor") && !j.at("nextCursor").is_null()) {
+        result.next_cursor = j.at("nextCursor").get<std::string>();
+    }
+    return result;
+}
+
+template<typename T>
+static T parse_result(const nlohmann::json& j) {
+    T result;
+    from_json(j, result);
+    return result;
+}
+
+static nlohmann::json cursor_params(const std::optional<std::string>& cursor) {
+    nlohmann::json params = nlohmann::json::object();
+    if (cursor) params["cursor"] = *cursor;
+    return params;
+}
+
+static nlohmann::json completion_params(const CompletionRef& ref, const std::string& arg_name,
+                                        const std::string& arg_value) {
+    nlohmann::json ref_j;
+    to_json(ref_j, ref);
+    return {
+        {"ref", ref_j},
+        {"argument", {{"name", arg_name}, {"value", arg_value}}}
+    };
+}
+
+// Error of a failed response as an exception.
+[[noreturn]] static void throw_response_error(const JsonRpcError& err) {
+    if (err.code == error::RequestTimeout) throw McpTimeoutError(err.message);
+    throw McpProtocolError(err.code, err.message);
+}
+
 struct McpClient::Impl {
     Options opts;
     Session session;
@@ -31,10 +85,19 @@ struct McpClient::Impl {
     std::unique_ptr<ITransport> transport;
     std::thread transport_thread;
     std::atomic<bool> connected{false};
-
-    // Pending request map: id_string -> promise
+    pid_t child = -1;  // the connect_stdio()/connect_shm() process
+
+    // Pending request map: id -> completion callback and its deadline
+    using ResponseCallback = std::function<void(JsonRpcResponse)>;
+    struct Pending {
+        ResponseCallback callback;
+        TimerWheel::TimerId timer = 0;
+        // Made while handling a request: cancelled along with it
+        CancellationToken upstream = CancellationToken::none();
+        uint64_t upstream_callback = 0;
+    };
     std::mutex pending_mutex;
-    std::unordered_map<std::string, std::promise<JsonRpcResponse>> pending_responses;
+    RequestTable<Pending> pending_responses{64};
     int64_t next_id{1};
 
     // Notification callbacks
@@ -46,36 +109,207 @@ struct McpClient::Impl {
     std::function<void(const LogMessage&)> on_log_message_cb;
     std::function<void(const ProgressInfo&)> on_progress_cb;
 
+    // Requests waiting to go out together (Options::batch_window)
+    std::mutex batch_mutex;
+    std::condition_variable batch_cv;
+    std::vector<JsonRpcMessage> batch_queue;
+    std::chrono::steady_clock::time_point batch_deadline;
+    bool batch_stop{false};
+    std::atomic<bool> batch_running{false};
+    std::thread batch_thread;
+
+    // Response cache (Options::cache_responses). A list's pages are kept
+    // while the server has promised list_changed for it; reads, for URIs
+    // subscribed to. Each invalidation bumps `epoch`, so a response that
+    // was already on its way when it happened isn't cached.
+    template<typename T>
+    struct PageCache {
+        bool live = false;
+        uint64_t epoch = 0;
+        std::unordered_map<std::string, PaginatedResult<T>> pages;  // by cursor
+    };
+    std::mutex cache_mutex;
+    PageCache<ToolDefinition> tool_pages;
+    PageCache<ResourceDefinition> resource_pages;
+    PageCache<PromptDefinition> prompt_pages;
+    bool reads_live = false;
+    std::unordered_set<std::string> subscriptions;  // URIs and "prefix*"
+    ResourceContentCache reads;
+
     // Server->client request handlers
     std::function<SamplingResult(const SamplingRequest&)> sampling_handler;
     std::function<std::vector<Root>()> roots_handler;
     std::function<ElicitationResult(const ElicitationRequest&)> elicitation_handler;
 
-    explicit Impl(Options o) : opts(std::move(o)) {}
+    // Expires requests after request_timeout. Declared last so its thread
+    // stops before the members its callbacks use are destroyed.
+    TimerWheel timers;
+
+    explicit Impl(Options o)
+        : opts(std::move(o)),
+          reads(ResourceContentCache::Options{opts.cache_responses ? opts.cache_max_bytes : 0,
+                                              {}}) {
+        timers.start();
+    }
+
+    static std::string page_key(const std::optional<std::string>& cursor) {
+        return cursor ? "+" + *cursor : std::string();
+    }
+
+    template<typename T>
+    void invalidate(PageCache<T>& cache) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        ++cache.epoch;
+        cache.pages.clear();
+    }
+
+    // Forgets everything; until initialize() nothing is cached
+    void reset_cache() {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto reset = [](auto& cache) {
+            cache.live = false;
+            ++cache.epoch;
+            cache.pages.clear();
+        };
+        reset(tool_pages);
+        reset(resource_pages);
+        reset(prompt_pages);
+        reads_live = false;
+        subscriptions.clear();
+        reads.clear();
+    }
+
+    void enable_cache(const ServerCapabilities& caps) {
+        if (!opts.cache_responses) return;
+        auto promises = [](const std::optional<nlohmann::json>& cap, const char* key) {
+            return cap && cap->is_object() && cap->value(key, false);
+        };
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        tool_pages.live = promises(caps.tools, "listChanged");
+        resource_pages.live = promises(caps.resources, "listChanged");
+        prompt_pages.live = promises(caps.prompts, "listChanged");
+        reads_live = promises(caps.resources, "subscribe");
+    }
+
+    // The cached page, or nullopt with the stamp to store the response under
+    template<typename T>
+    std::optional<PaginatedResult<T>> cached_page(PageCache<T>& cache,
+                                                  const std::optional<std::string>& cursor,
+                                                  uint64_t& stamp) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        stamp = cache.epoch;
+        if (!cache.live) return std::nullopt;
+        auto it = cache.pages.find(page_key(cursor));
+        if (it == cache.pages.end()) return std::nullopt;
+        return it->second;
+    }
+
+    template<typename T>
+    void store_page(PageCache<T>& cache, const std::optional<std::string>& cursor,
+                    uint64_t stamp, const PaginatedResult<T>& page) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (cache.live && cache.epoch == stamp) cache.pages[page_key(cursor)] = page;
+    }
+
+    template<typename T>
+    PaginatedResult<T> list_page(PageCache<T>& cache, const char* method, const char* key,
+                                 const std::optional<std::string>& cursor) {
+        uint64_t stamp = 0;
+        if (auto hit = cached_page(cache, cursor, stamp)) return std::move(*hit);
+        auto page = request<PaginatedResult<T>>(method, cursor_params(cursor),
+            [key](const nlohmann::json& j) { return parse_page<T>(j, key); });
+        store_page(cache, cursor, stamp, page);
+        return page;
+    }
+
+    template<typename T>
+    Async<PaginatedResult<T>> list_page_async(PageCache<T>& cache, const char* method,
+                                              const char* key, std::optional<std::string> cursor) {
+        uint64_t stamp = 0;
+        if (auto hit = cached_page(cache, cursor, stamp)) {
+            AsyncPromise<PaginatedResult<T>> promise(opts.executor);
+            promise.set_value(std::move(*hit));
+            return promise.get_async();
+        }
+        return request_async<PaginatedResult<T>>(method, cursor_params(cursor),
+            [this, &cache, key, cursor, stamp](const nlohmann::json& j) {
+                auto page = parse_page<T>(j, key);
+                store_page(cache, cursor, stamp, page);
+                return page;
+            });
+    }
+
+    // Every page, one after another: each request needs the cursor the
+    // previous response returned. Served from the cache page by page.
+    template<typename T>
+    std::vector<T> list_all(PageCache<T>& cache, const char* method, const char* key) {
+        std::vector<T> items;
+        std::optional<std::string> cursor;
+        do {
+            auto page = list_page(cache, method, key, cursor);
+            items.insert(items.end(), std::make_move_iterator(page.items.begin()),
+                         std::make_move_iterator(page.items.end()));
+            if (page.next_cursor && page.next_cursor == cursor) break;  // no progress
+            cursor = std::move(page.next_cursor);
+        } while (cursor);
+        return items;
+    }
+
+    // Whether resources/updated will tell us when `uri` changes; cache_mutex held
+    bool subscribed_to(const std::string& uri) const {
+        if (subscriptions.count(uri)) return true;
+        for (const auto& s : subscriptions) {
+            if (!s.empty() && s.back() == '*'
+                && uri.compare(0, s.size() - 1, s, 0, s.size() - 1) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The cached contents of `uri`, or null with the stamp to store a read under
+    std::shared_ptr<const std::vector<ResourceContent>> cached_read(const std::string& uri,
+                                                                    uint64_t& stamp) {
+        stamp = reads.stamp();
+        if (!reads.enabled()) return nullptr;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (!reads_live || !subscribed_to(uri)) return nullptr;
+        }
+        return reads.get(uri);
+    }
 
-    std::string id_to_key(const RequestId& id) {
-        if (auto* i = std::get_if<int64_t>(&id)) return std::to_string(*i);
-        if (auto* s = std::get_if<std::string>(&id)) return *s;
-        return "";
+    void store_read(const std::string& uri, uint64_t stamp,
+                    const std::vector<ResourceContent>& contents) {
+        if (!reads.enabled()) return;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (!reads_live || !subscribed_to(uri)) return;
+        }
+        reads.put(uri, std::make_shared<const std::vector<ResourceContent>>(contents), stamp);
     }
 
     void setup_notification_handlers() {
         router.on_notification("notifications/tools/list_changed", [this](const nlohmann::json&) {
+            invalidate(tool_pages);
             std::lock_guard<std::mutex> lock(callback_mutex);
             if (on_tools_changed_cb) on_tools_changed_cb();
         });
         router.on_notification("notifications/resources/list_changed", [this](const nlohmann::json&) {
+            invalidate(resource_pages);
             std::lock_guard<std::mutex> lock(callback_mutex);
             if (on_resources_changed_cb) on_resources_changed_cb();
         });
         router.on_notification("notifications/resources/updated", [this](const nlohmann::json& params) {
+            std::string uri = params.value("uri", "");
+            reads.invalidate(uri);
             std::lock_guard<std::mutex> lock(callback_mutex);
             if (on_resource_updated_cb) {
-                std::string uri = params.value("uri", "");
                 on_resource_updated_cb(uri);
             }
         });
         router.on_notification("notifications/prompts/list_changed", [this](const nlohmann::json&) {
+            invalidate(prompt_pages);
             std::lock_guard<std::mutex> lock(callback_mutex);
             if (on_prompts_changed_cb) on_prompts_changed_cb();
         });
@@ -163,63 +397,296 @@ struct McpClient::Impl {
     void on_message(JsonRpcMessage msg) {
         if (auto* resp = std::get_if<JsonRpcResponse>(&msg)) {
             // Match to pending request
-            std::string key = id_to_key(resp->id);
-            std::lock_guard<std::mutex> lock(pending_mutex);
-            auto it = pending_responses.find(key);
-            if (it != pending_responses.end()) {
-                it->second.set_value(*resp);
-                pending_responses.erase(it);
+            std::optional<Pending> pending;
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex);
+                pending = pending_responses.take(resp->id);
             }
+            if (!pending) return;
+            release(*pending);
+            pending->callback(std::move(*resp));
             return;
         }
 
         // Dispatch notifications and server->client requests
-        auto response = router.dispatch(msg);
+        auto response = router.dispatch(std::move(msg));
         if (response && transport) {
             transport->send(*response);
         }
     }
 
-    JsonRpcResponse send_request(const std::string& method, nlohmann::json params) {
-        if (!connected) {
-            throw McpTransportError("Not connected");
-        }
-
+    // Send a request; `on_response` runs on the transport reader thread.
+    int64_t send_request_async(const std::string& method, nlohmann::json params,
+                               ResponseCallback on_response) {
         int64_t id;
-        std::future<JsonRpcResponse> fut;
         {
+            // Checked under the lock so fail_pending_requests() can't miss us
             std::lock_guard<std::mutex> lock(pending_mutex);
+            if (!connected) {
+                throw McpTransportError("Not connected");
+            }
             id = next_id++;
-            auto& p = pending_responses[std::to_string(id)];
-            fut = p.get_future();
+            auto timer = timers.schedule(opts.request_timeout,
+                                         [this, id, method] { expire(RequestId{id}, method); });
+            pending_responses.insert(RequestId{id}, Pending{std::move(on_response), timer});
         }
 
         JsonRpcRequest req;
         req.id = RequestId{id};
         req.method = method;
         req.params = std::move(params);
-        transport->send(req);
+        if (batch_running.load(std::memory_order_acquire)) {
+            enqueue_batched(std::move(req));
+        } else {
+            try {
+                transport->send(req);
+            } catch (...) {
+                forget(RequestId{id});
+                throw;
+            }
+        }
+        link_upstream(id, method);
+        return id;
+    }
 
-        if (fut.wait_for(opts.request_timeout) == std::future_status::timeout) {
+    // Drops a pending request without completing it.
+    void forget(const RequestId& id) {
+        std::optional<Pending> pending;
+        {
             std::lock_guard<std::mutex> lock(pending_mutex);
-            pending_responses.erase(std::to_string(id));
-            throw McpTimeoutError("Request timed out: " + method);
+            pending = pending_responses.take(id);
         }
+        if (pending) release(*pending);
+    }
 
-        return fut.get();
+    // Stops whatever would still complete a request taken from the table
+    void release(const Pending& p) {
+        timers.cancel(p.timer);
+        p.upstream.remove_on_cancel(p.upstream_callback);
+    }
+
+    // A request made from a server handler is cancelled with the request
+    // the handler serves. Linked once sent, so the cancellation follows it.
+    void link_upstream(int64_t id, const std::string& method) {
+        auto token = CancellationToken::current();
+        if (!token.cancellable()) return;
+        uint64_t callback = token.on_cancel([this, id, method] {
+            abandon(RequestId{id}, "Cancelled upstream",
+                    JsonRpcError{error::RequestCancelled, "Request cancelled: " + method, std::nullopt});
+        });
+        if (callback == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            if (auto* p = pending_responses.find(RequestId{id})) {
+                p->upstream = std::move(token);
+                p->upstream_callback = callback;
+                return;
+            }
+        }
+        token.remove_on_cancel(callback);  // answered already
+    }
+
+    // Timer callback: fails a request that outlived request_timeout and
+    // tells the server to stop working on it.
+    void expire(const RequestId& id, const std::string& method) {
+        abandon(id, "Request timed out",
+                JsonRpcError{error::RequestTimeout, "Request timed out: " + method, std::nullopt});
+    }
+
+    // Fails a pending request with `err` and tells the server to stop it
+    void abandon(const RequestId& id, const std::string& reason, JsonRpcError err) {
+        std::optional<Pending> pending;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending = pending_responses.take(id);
+        }
+        if (!pending) return;  // answered meanwhile
+        release(*pending);
+
+        JsonRpcNotification notif;
+        notif.method = "notifications/cancelled";
+        nlohmann::json params;
+        std::visit([&params](const auto& v) { params["requestId"] = v; }, id);
+        params["reason"] = reason;
+        notif.params = std::move(params);
+        try {
+            if (connected) transport->send(notif);
+        } catch (...) {}
+
+        JsonRpcResponse resp;
+        resp.id = id;
+        resp.error = std::move(err);
+        try { pending->callback(std::move(resp)); } catch (...) {}
+    }
+
+    bool batching() const { return opts.batch_window.count() > 0 && opts.max_batch_size > 1; }
+
+    // Queues `req` for the next batch; a full batch goes out right away.
+    void enqueue_batched(JsonRpcRequest req) {
+        std::vector<JsonRpcMessage> full;
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex);
+            if (batch_queue.empty()) {
+                batch_deadline = std::chrono::steady_clock::now() + opts.batch_window;
+                batch_cv.notify_one();
+            }
+            batch_queue.push_back(std::move(req));
+            if (batch_queue.size() < opts.max_batch_size) return;
+            full.swap(batch_queue);
+        }
+        send_batch(full);
+    }
+
+    // Sends queued batches once their window closes.
+    void batch_loop() {
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        while (true) {
+            batch_cv.wait(lock, [this] { return batch_stop || !batch_queue.empty(); });
+            if (batch_queue.empty()) return;  // stopping
+            if (!batch_stop) {
+                // Whatever arrives before the deadline joins this batch. If a
+                // full batch went out meanwhile, wait for the next one's.
+                auto deadline = batch_deadline;
+                batch_cv.wait_until(lock, deadline, [&] {
+                    return batch_stop || batch_queue.empty() || batch_deadline != deadline;
+                });
+                if (!batch_stop && (batch_queue.empty() || batch_deadline != deadline)) continue;
+            }
+            std::vector<JsonRpcMessage> batch;
+            batch.swap(batch_queue);
+            lock.unlock();
+            if (!batch.empty()) send_batch(batch);
+            lock.lock();
+        }
+    }
+
+    // Sends a batch; if the transport fails, its requests fail with it.
+    void send_batch(const std::vector<JsonRpcMessage>& batch) {
+        try {
+            if (batch.size() == 1) transport->send(batch.front());
+            else transport->send_batch(batch);
+        } catch (const std::exception& e) {
+            for (const auto& msg : batch) {
+                const auto& req = std::get<JsonRpcRequest>(msg);
+                std::optional<Pending> pending;
+                {
+                    std::lock_guard<std::mutex> lock(pending_mutex);
+                    pending = pending_responses.take(req.id);
+                }
+                if (!pending) continue;
+                release(*pending);
+                JsonRpcResponse resp;
+                resp.id = req.id;
+                resp.error = JsonRpcError{error::InternalError, e.what(), std::nullopt};
+                try { pending->callback(std::move(resp)); } catch (...) {}
+            }
+        }
+    }
+
+    // Sends what is still queued and stops the batch thread.
+    void stop_batching() {
+        if (!batch_thread.joinable()) return;
+        batch_running.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(batch_mutex);
+            batch_stop = true;
+        }
+        batch_cv.notify_all();
+        batch_thread.join();
+    }
+
+    // Wake every outstanding request once the connection is gone.
+    void fail_pending_requests(const std::string& reason) {
+        std::vector<Pending> pending;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending = pending_responses.take_all();
+        }
+        for (auto& p : pending) {
+            release(p);
+            JsonRpcResponse resp;
+            resp.error = JsonRpcError{error::InternalError, reason, std::nullopt};
+            try { p.callback(std::move(resp)); } catch (...) {}
+        }
+    }
+
+    // Issue a request whose result is parsed by `parse` into an Async<T>.
+    template<typename T, typename Parse>
+    Async<T> request_async(const std::string& method, nlohmann::json params, Parse parse) {
+        AsyncPromise<T> promise(opts.executor);
+        auto result = promise.get_async();
+        try {
+            int64_t id = send_request_async(method, std::move(params),
+                [promise, parse](JsonRpcResponse resp) {
+                    try {
+                        if (resp.error) throw_response_error(*resp.error);
+                        auto result = resp.result.value_or(nlohmann::json::object());
+                        if constexpr (std::is_void_v<T>) {
+                            parse(result);
+                            promise.set_value();
+                        } else {
+                            promise.set_value(parse(result));
+                        }
+                    } catch (...) {
+                        promise.set_exception(std::current_exception());
+                    }
+                });
+            // Pending requests are all completed before the client goes
+            // away, so the canceller never outlives it
+            promise.on_cancel([this, id, method] {
+                abandon(RequestId{id}, "Cancelled by the client",
+                        JsonRpcError{error::RequestCancelled, "Request cancelled: " + method,
+                                     std::nullopt});
+            });
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+        return result;
+    }
+
+    // Blocking counterpart of request_async(), bounded by request_timeout.
+    template<typename T, typename Parse>
+    T request(const std::string& method, nlohmann::json params, Parse parse) {
+        auto resp = send_request(method, std::move(params));
+        if (resp.error) throw_response_error(*resp.error);
+        return parse(resp.result.value_or(nlohmann::json::object()));
+    }
+
+    JsonRpcResponse send_request(const std::string& method, nlohmann::json params) {
+        auto p = std::make_shared<std::promise<JsonRpcResponse>>();
+        auto fut = p->get_future();
+        send_request_async(method, std::move(params),
+            [p](JsonRpcResponse resp) { p->set_value(std::move(resp)); });
+
+        // The timer wheel completes the request if the server never does
+        auto resp = fut.get();
+        if (resp.error && resp.error->code == error::RequestTimeout) {
+            throw McpTimeoutError(resp.error->message);
+        }
+        return resp;
     }
 
     void do_connect(std::unique_ptr<ITransport> t) {
         transport = std::move(t);
+        reset_cache();
         setup_notification_handlers();
         connected = true;
         session.set_state(SessionState::Uninitialized);
+        if (batching() && !batch_thread.joinable()) {
+            batch_stop = false;
+            batch_thread = std::thread([this] { batch_loop(); });
+            batch_running.store(true, std::memory_order_release);
+        }
 
-        transport_thread = std::thread([this]() {
-            transport->start([this](JsonRpcMessage msg) {
-                on_message(std::move(msg));
-            });
+        auto deliver = [this](JsonRpcMessage msg) { on_message(std::move(msg)); };
+        auto closed = [this] {
             connected = false;
+            fail_pending_requests("Connection closed");
+        };
+        if (transport->start_detached(deliver, nullptr, closed)) return;
+        transport_thread = std::thread([this, deliver, closed]() {
+            transport->start(deliver);
+            closed();
         });
     }
 };
@@ -236,8 +703,10 @@ void McpClient::connect_stdio(const std::string& command,
     // Launch subprocess and create pipe-based transport
     // Use popen-style or fork/exec
     // For simplicity, use a pipe approach via posix_spawn or fork/exec
+    // Close-on-exec, so that other children (a pool's, say) don't inherit
+    // our ends and keep this child's pipes open after it exits
     int in_pipe[2], out_pipe[2];
-    if (pipe(in_pipe) < 0 || pipe(out_pipe) < 0) {
+    if (pipe2(in_pipe, O_CLOEXEC) < 0 || pipe2(out_pipe, O_CLOEXEC) < 0) {
         throw McpTransportError("Failed to create pipes");
     }
 
@@ -269,13 +738,53 @@ void McpClient::connect_stdio(const std::string& command,
     // Parent
     close(in_pipe[0]);
     close(out_pipe[1]);
+    impl_->child = pid;
 
     // write_fd = in_pipe[1] (we write to child's stdin)
     // read_fd  = out_pipe[0] (we read from child's stdout)
-    auto transport = std::make_unique<StdioTransport>(out_pipe[0], in_pipe[1]);
+    std::unique_ptr<ITransport> transport;
+    if (impl_->opts.event_loop) {
+        transport = std::make_unique<EventLoopTransport>(impl_->opts.event_loop, out_pipe[0], in_pipe[1]);
+    } else {
+        transport = std::make_unique<StdioTransport>(out_pipe[0], in_pipe[1]);
+    }
     impl_->do_connect(std::move(transport));
 }
 
+void McpClient::connect_shm(const std::string& command,
+                             const std::vector<std::string>& args) {
+    // The child gets one end of a socket, named in its environment; the
+    // rings themselves are sent over it once the child attaches
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        throw McpTransportError("Failed to create socket pair");
+    }
+    ::fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+    std::string env = std::string(ShmTransport::kFdEnv) + "=" + std::to_string(sv[1]);
+    std::vector<std::string> args_copy = args;
+    std::string cmd = command;
+    std::vector<char*> argv_vec;
+    argv_vec.push_back(cmd.data());
+    for (auto& a : args_copy) argv_vec.push_back(a.data());
+    argv_vec.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        ::close(sv[0]);
+        ::close(sv[1]);
+        throw McpTransportError("Failed to fork process");
+    }
+    if (pid == 0) {
+        ::putenv(env.data());
+        execvp(command.c_str(), argv_vec.data());
+        _exit(1);
+    }
+
+    ::close(sv[1]);
+    impl_->child = pid;
+    impl_->do_connect(std::make_unique<ShmTransport>(sv[0], ShmTransport::Role::Create));
+}
+
 void McpClient::connect_http(const std::string& url) {
     auto transport = std::make_unique<HttpClientTransport>(url);
     impl_->do_connect(std::move(transport));
@@ -285,7 +794,22 @@ void McpClient::connect(std::unique_ptr<ITransport> transport) {
     impl_->do_connect(std::move(transport));
 }
 
+// Waits up to `timeout` for `pid` to exit and reaps it; false if it is
+// still running.
+static bool reap_child(pid_t pid, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto pause = std::chrono::milliseconds(1);
+    while (true) {
+        pid_t r = ::waitpid(pid, nullptr, WNOHANG);
+        if (r == pid || (r < 0 && errno != EINTR)) return true;
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(pause);
+        pause = std::min(pause * 2, std::chrono::milliseconds(20));
+    }
+}
+
 void McpClient::disconnect() {
+    impl_->stop_batching();
     if (impl_->transport) {
         impl_->transport->shutdown();
     }
@@ -293,7 +817,22 @@ void McpClient::disconnect() {
         impl_->transport_thread.join();
     }
     impl_->connected = false;
+    impl_->fail_pending_requests("Disconnected");
     impl_->session.set_state(SessionState::Closed);
+    if (impl_->child > 0) {
+        // Closing its pipes is the child's cue to exit; one that doesn't is
+        // sent SIGTERM, then SIGKILL
+        impl_->transport.reset();
+        pid_t pid = std::exchange(impl_->child, -1);
+        auto grace = impl_->opts.child_exit_timeout;
+        if (!reap_child(pid, grace)) {
+            ::kill(pid, SIGTERM);
+            if (!reap_child(pid, grace)) {
+                ::kill(pid, SIGKILL);
+                while (::waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+            }
+        }
+    }
 }
 
 InitializeResult McpClient::initialize() {
@@ -302,6 +841,14 @@ InitializeResult McpClient::initialize() {
         {"clientInfo", impl_->opts.client_info},
         {"capabilities", impl_->opts.capabilities}
     };
+    // mcpxx extension: offer a binary encoding the transport can send
+    const WireFormat format = impl_->opts.wire_format;
+    const bool offer = format != WireFormat::Json && impl_->transport
+                       && impl_->transport->supports_wire_format(format);
+    if (offer) {
+        params["capabilities"]["experimental"][kWireFormatCapability] =
+            nlohmann::json{{"formats", {to_string(format)}}};
+    }
 
     impl_->session.set_state(SessionState::Initializing);
     auto resp = impl_->send_request("initialize", params);
@@ -317,6 +864,14 @@ InitializeResult McpClient::initialize() {
     impl_->session.protocol_version() = result.protocol_version;
     impl_->router.set_capabilities(result.capabilities, impl_->opts.capabilities);
     impl_->session.set_state(SessionState::Ready);
+    impl_->enable_cache(result.capabilities);
+    if (offer && result.capabilities.experimental && result.capabilities.experimental->is_object()) {
+        auto accepted = result.capabilities.experimental->find(kWireFormatCapability);
+        if (accepted != result.capabilities.experimental->end() && accepted->is_object()
+            && accepted->value("format", std::string()) == to_string(format)) {
+            impl_->transport->set_wire_format(format);
+        }
+    }
 
     // Send initialized notification
     JsonRpcNotification notif;
@@ -327,118 +882,143 @@ InitializeResult McpClient::initialize() {
 }
 
 PaginatedResult<ToolDefinition> McpClient::list_tools(std::optional<std::string> cursor) {
-    nlohmann::json params = nlohmann::json::object();
-    if (cursor) params["cursor"] = *cursor;
+    return impl_->list_page(impl_->tool_pages, "tools/list", "tools", cursor);
+}
 
-    auto resp = impl_->send_request("tools/list", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+Async<PaginatedResult<ToolDefinition>> McpClient::list_tools_async(
+    std::optional<std::string> cursor) {
+    return impl_->list_page_async(impl_->tool_pages, "tools/list", "tools", std::move(cursor));
+}
 
-    PaginatedResult<ToolDefinition> result;
-    result.items = resp.result->at("tools").get<std::vector<ToolDefinition>>();
-    if (resp.result->contains("nextCursor") && !resp.result->at("nextCursor").is_null()) {
-        result.next_cursor = resp.result->at("nextCursor").get<std::string>();
-    }
-    return result;
+std::vector<ToolDefinition> McpClient::list_all_tools() {
+    return impl_->list_all(impl_->tool_pages, "tools/list", "tools");
 }
 
 CallToolResult McpClient::call_tool(const std::string& name, const nlohmann::json& arguments) {
     nlohmann::json params = {{"name", name}, {"arguments", arguments}};
-    auto resp = impl_->send_request("tools/call", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+    return impl_->request<CallToolResult>("tools/call", std::move(params),
+                                          parse_result<CallToolResult>);
+}
 
-    CallToolResult result;
-    from_json(*resp.result, result);
-    return result;
+Async<CallToolResult> McpClient::call_tool_async(const std::string& name,
+                                                 const nlohmann::json& arguments) {
+    nlohmann::json params = {{"name", name}, {"arguments", arguments}};
+    return impl_->request_async<CallToolResult>("tools/call", std::move(params),
+                                                parse_result<CallToolResult>);
 }
 
 PaginatedResult<ResourceDefinition> McpClient::list_resources(std::optional<std::string> cursor) {
-    nlohmann::json params = nlohmann::json::object();
-    if (cursor) params["cursor"] = *cursor;
+    return impl_->list_page(impl_->resource_pages, "resources/list", "resources", cursor);
+}
 
-    auto resp = impl_->send_request("resources/list", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+Async<PaginatedResult<ResourceDefinition>> McpClient::list_resources_async(
+    std::optional<std::string> cursor) {
+    return impl_->list_page_async(impl_->resource_pages, "resources/list", "resources",
+                                  std::move(cursor));
+}
 
-    PaginatedResult<ResourceDefinition> result;
-    result.items = resp.result->at("resources").get<std::vector<ResourceDefinition>>();
-    if (resp.result->contains("nextCursor") && !resp.result->at("nextCursor").is_null()) {
-        result.next_cursor = resp.result->at("nextCursor").get<std::string>();
-    }
-    return result;
+std::vector<ResourceDefinition> McpClient::list_all_resources() {
+    return impl_->list_all(impl_->resource_pages, "resources/list", "resources");
+}
+
+static std::vector<ResourceContent> parse_contents(const nlohmann::json& j) {
+    return j.at("contents").get<std::vector<ResourceContent>>();
 }
 
 std::vector<ResourceContent> McpClient::read_resource(const std::string& uri) {
-    nlohmann::json params = {{"uri", uri}};
-    auto resp = impl_->send_request("resources/read", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+    uint64_t stamp = 0;
+    if (auto hit = impl_->cached_read(uri, stamp)) return *hit;
+    auto contents = impl_->request<std::vector<ResourceContent>>("resources/read", {{"uri", uri}},
+                                                                 parse_contents);
+    impl_->store_read(uri, stamp, contents);
+    return contents;
+}
 
-    return resp.result->at("contents").get<std::vector<ResourceContent>>();
+Async<std::vector<ResourceContent>> McpClient::read_resource_async(const std::string& uri) {
+    uint64_t stamp = 0;
+    if (auto hit = impl_->cached_read(uri, stamp)) {
+        AsyncPromise<std::vector<ResourceContent>> promise(impl_->opts.executor);
+        promise.set_value(*hit);
+        return promise.get_async();
+    }
+    return impl_->request_async<std::vector<ResourceContent>>("resources/read", {{"uri", uri}},
+        [impl = impl_.get(), uri, stamp](const nlohmann::json& j) {
+            auto contents = parse_contents(j);
+            impl->store_read(uri, stamp, contents);
+            return contents;
+        });
 }
 
 PaginatedResult<ResourceTemplate> McpClient::list_resource_templates(
     std::optional<std::string> cursor) {
-    nlohmann::json params = nlohmann::json::object();
-    if (cursor) params["cursor"] = *cursor;
-
-    auto resp = impl_->send_request("resources/templates/list", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+    return impl_->request<PaginatedResult<ResourceTemplate>>(
+        "resources/templates/list", cursor_params(cursor),
+        [](const nlohmann::json& j) { return parse_page<ResourceTemplate>(j, "resourceTemplates"); });
+}
 
-    PaginatedResult<ResourceTemplate> result;
-    result.items = resp.result->at("resourceTemplates").get<std::vector<ResourceTemplate>>();
-    if (resp.result->contains("nextCursor") && !resp.result->at("nextCursor").is_null()) {
-        result.next_cursor = resp.result->at("nextCursor").get<std::string>();
-    }
-    return result;
+Async<PaginatedResult<ResourceTemplate>> McpClient::list_resource_templates_async(
+    std::optional<std::string> cursor) {
+    return impl_->request_async<PaginatedResult<ResourceTemplate>>(
+        "resources/templates/list", cursor_params(cursor),
+        [](const nlohmann::json& j) { return parse_page<ResourceTemplate>(j, "resourceTemplates"); });
 }
 
 void McpClient::subscribe_resource(const std::string& uri) {
     auto resp = impl_->send_request("resources/subscribe", {{"uri", uri}});
     if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+    std::lock_guard<std::mutex> lock(impl_->cache_mutex);
+    impl_->subscriptions.insert(uri);
 }
 
 void McpClient::unsubscribe_resource(const std::string& uri) {
+    {
+        // Reads cached under this subscription would no longer be refreshed
+        std::lock_guard<std::mutex> lock(impl_->cache_mutex);
+        if (impl_->subscriptions.erase(uri)) impl_->reads.clear();
+    }
     auto resp = impl_->send_request("resources/unsubscribe", {{"uri", uri}});
     if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
 }
 
 PaginatedResult<PromptDefinition> McpClient::list_prompts(std::optional<std::string> cursor) {
-    nlohmann::json params = nlohmann::json::object();
-    if (cursor) params["cursor"] = *cursor;
+    return impl_->list_page(impl_->prompt_pages, "prompts/list", "prompts", cursor);
+}
 
-    auto resp = impl_->send_request("prompts/list", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+Async<PaginatedResult<PromptDefinition>> McpClient::list_prompts_async(
+    std::optional<std::string> cursor) {
+    return impl_->list_page_async(impl_->prompt_pages, "prompts/list", "prompts", std::move(cursor));
+}
 
-    PaginatedResult<PromptDefinition> result;
-    result.items = resp.result->at("prompts").get<std::vector<PromptDefinition>>();
-    if (resp.result->contains("nextCursor") && !resp.result->at("nextCursor").is_null()) {
-        result.next_cursor = resp.result->at("nextCursor").get<std::string>();
-    }
-    return result;
+std::vector<PromptDefinition> McpClient::list_all_prompts() {
+    return impl_->list_all(impl_->prompt_pages, "prompts/list", "prompts");
 }
 
 GetPromptResult McpClient::get_prompt(const std::string& name, const nlohmann::json& arguments) {
     nlohmann::json params = {{"name", name}, {"arguments", arguments}};
-    auto resp = impl_->send_request("prompts/get", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+    return impl_->request<GetPromptResult>("prompts/get", std::move(params),
+                                           parse_result<GetPromptResult>);
+}
 
-    GetPromptResult result;
-    from_json(*resp.result, result);
-    return result;
+Async<GetPromptResult> McpClient::get_prompt_async(const std::string& name,
+                                                   const nlohmann::json& arguments) {
+    nlohmann::json params = {{"name", name}, {"arguments", arguments}};
+    return impl_->request_async<GetPromptResult>("prompts/get", std::move(params),
+                                                 parse_result<GetPromptResult>);
 }
 
 CompletionResult McpClient::complete(const CompletionRef& ref, const std::string& arg_name,
                                       const std::string& arg_value) {
-    nlohmann::json ref_j;
-    to_json(ref_j, ref);
-    nlohmann::json params = {
-        {"ref", ref_j},
-        {"argument", {{"name", arg_name}, {"value", arg_value}}}
-    };
-    auto resp = impl_->send_request("completion/complete", params);
-    if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
+    return impl_->request<CompletionResult>("completion/complete",
+                                            completion_params(ref, arg_name, arg_value),
+                                            parse_result<CompletionResult>);
+}
 
-    CompletionResult result;
-    from_json(*resp.result, result);
-    return result;
+Async<CompletionResult> McpClient::complete_async(const CompletionRef& ref,
+                                                  const std::string& arg_name,
+                                                  const std::string& arg_value) {
+    return impl_->request_async<CompletionResult>("completion/complete",
+                                                  completion_params(ref, arg_name, arg_value),
+                                                  parse_result<CompletionResult>);
 }
 
 void McpClient::set_log_level(LogLevel level) {
@@ -485,6 +1065,7 @@ void McpClient::cancel_request(const RequestId& id, const std::string& reason) {
     JsonRpcNotification notif;
     notif.method = "notifications/cancelled";
     notif.params = params;
+    if (!impl_->transport) throw McpTransportError("Not connected");
     impl_->transport->send(notif);
 }
 
@@ -493,6 +1074,11 @@ void McpClient::ping() {
     if (resp.error) throw McpProtocolError(resp.error->code, resp.error->message);
 }
 
+Async<void> McpClient::ping_async() {
+    return impl_->request_async<void>("ping", nlohmann::json::object(),
+                                      [](const nlohmann::json&) {});
+}
+
 void McpClient::on_sampling_request(std::function<SamplingResult(const SamplingRequest&)> handler) {
     std::lock_guard<std::mutex> lock(impl_->callback_mutex);
     impl_->sampling_handler = std::move(handler);
@@ -0,0 +1,646 @@
+#include "mcp/client_pool.hpp"
+#include "mcp/error.hpp"
+#include "mcp/metrics.hpp"
+#include "mcp/timer_wheel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+namespace mcp {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t elapsed_ns(Clock::time_point since) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+}
+
+bool allows_hedging(const ToolDefinition& tool) {
+    const auto& a = tool.annotations;
+    return a && a->is_object()
+           && (a->value("idempotentHint", false) || a->value("readOnlyHint", false));
+}
+
+// Requests one process may have in flight, moved by AIMD on its latency:
+// an answer close to the fastest lately adds 1/limit, so the limit grows
+// by about one per limit's worth of answers; a slow one or a timeout cuts
+// it by a constant ratio.
+class Limiter {
+public:
+    explicit Limiter(const McpClientPool::Options& opts)
+        : enabled_(opts.adaptive_limit),
+          max_(static_cast<double>(std::max<size_t>(opts.max_limit, 1))),
+          tolerance_(opts.latency_tolerance),
+          backoff_(opts.backoff_ratio),
+          limit_(std::clamp(static_cast<double>(opts.initial_limit), 1.0, max_)),
+          admitted_(enabled_ ? static_cast<size_t>(limit_) : std::numeric_limits<size_t>::max()) {}
+
+    [[nodiscard]] size_t limit() const noexcept { return admitted_.load(std::memory_order_relaxed); }
+
+    void record(uint64_t ns, bool timed_out) {
+        if (!enabled_) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The fastest answer over the last window or two stands in for the
+        // latency without queueing; windows let it rise again if the
+        // process itself slows down
+        window_min_ = std::min(window_min_, ns);
+        if (++samples_ == kWindow) {
+            min_ns_ = window_min_;
+            window_min_ = UINT64_MAX;
+            samples_ = 0;
+        }
+        const double base = static_cast<double>(std::min(min_ns_, window_min_));
+        if (!timed_out && static_cast<double>(ns) <= base * tolerance_) {
+            limit_ = std::min(limit_ + 1.0 / limit_, max_);
+        } else {
+            limit_ = std::max(limit_ * backoff_, 1.0);
+        }
+        admitted_.store(static_cast<size_t>(limit_), std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned kWindow = 100;
+
+    const bool enabled_;
+    const double max_;
+    const double tolerance_;
+    const double backoff_;
+    std::mutex mutex_;
+    double limit_;
+    uint64_t min_ns_ = UINT64_MAX;
+    uint64_t window_min_ = UINT64_MAX;
+    unsigned samples_ = 0;
+    std::atomic<size_t> admitted_;
+};
+
+struct Member {
+    explicit Member(const McpClientPool::Options& opts) : limiter(opts) {}
+
+    std::unique_ptr<McpClient> client;
+    std::atomic<size_t> outstanding{0};
+    Limiter limiter;
+};
+using MemberPtr = std::shared_ptr<Member>;
+
+// What requests in flight touch when they finish. They may finish after
+// the pool is gone (on client.executor, say), so they share it.
+struct Shared {
+    std::mutex mutex;                  // the pool's
+    std::condition_variable ready_cv;  // a process can take a request
+    std::atomic<bool> tools_stale{true};
+    std::atomic<uint64_t> hedges{0};
+    std::atomic<uint64_t> hedge_wins{0};
+
+    // call_tool latencies of the current window and the last full one
+    std::mutex latency_mutex;
+    LatencyHistogram recent;
+    LatencyHistogram previous;
+
+    static constexpr uint64_t kLatencyWindow = 1024;
+
+    void record_call(uint64_t ns) {
+        std::lock_guard<std::mutex> lock(latency_mutex);
+        recent.record(ns);
+        if (recent.count() >= kLatencyWindow) {
+            previous = recent;
+            recent = LatencyHistogram{};
+        }
+    }
+
+    std::optional<std::chrono::milliseconds> hedge_delay(const McpClientPool::Options& opts) {
+        std::lock_guard<std::mutex> lock(latency_mutex);
+        const auto& h = previous.count() >= opts.hedge_min_samples ? previous : recent;
+        if (h.count() < opts.hedge_min_samples) return std::nullopt;
+        auto delay = std::chrono::ceil<std::chrono::milliseconds>(
+            std::chrono::nanoseconds(h.percentile(opts.hedge_percentile)));
+        return std::max(delay, opts.min_hedge_delay);
+    }
+};
+
+// Counts one request against a member for as long as it is held. Members
+// are disconnected by the supervisor before the pool lets go of them, so
+// whichever thread drops the last reference never joins its own reader.
+class Lease {
+public:
+    // `notify` wakes callers waiting for room once the lease ends
+    Lease(MemberPtr member, std::shared_ptr<Shared> notify)
+        : member_(std::move(member)), notify_(std::move(notify)), start_(Clock::now()) {
+        member_->outstanding.fetch_add(1, std::memory_order_relaxed);
+    }
+    Lease(Lease&&) noexcept = default;
+    Lease& operator=(Lease&&) = delete;
+    ~Lease() {
+        if (!member_) return;
+        member_->outstanding.fetch_sub(1, std::memory_order_relaxed);
+        if (notify_) {
+            std::lock_guard<std::mutex> lock(notify_->mutex);
+            notify_->ready_cv.notify_all();
+        }
+    }
+
+    [[nodiscard]] McpClient& client() const { return *member_->client; }
+    [[nodiscard]] const Member* member() const { return member_.get(); }
+
+    // Feeds the request's latency to the member's limit
+    void record(bool timed_out) const { member_->limiter.record(elapsed_ns(start_), timed_out); }
+
+private:
+    MemberPtr member_;
+    std::shared_ptr<Shared> notify_;
+    Clock::time_point start_;
+};
+
+// Completes with `inner`, keeping the member leased until then
+template<typename T>
+CoTask<T> hold(Async<T> inner, Lease lease) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await inner;
+            lease.record(false);
+        } else {
+            auto value = co_await inner;
+            lease.record(false);
+            co_return value;
+        }
+    } catch (const McpTimeoutError&) {
+        lease.record(true);
+        throw;
+    }
+}
+
+// One call_tool, sent to a second process too if it's slow
+struct Hedge {
+    AsyncPromise<CallToolResult> promise;
+    std::mutex mutex;
+    bool done = false;
+    int running = 0;                                // attempts not yet finished
+    std::exception_ptr error;                       // the first failure
+    std::vector<Async<CallToolResult>> attempts;    // cancelled once one wins
+};
+
+} // namespace
+
+struct McpClientPool::Impl {
+    std::string command;
+    std::vector<std::string> args;
+    Options opts;
+
+    std::shared_ptr<Shared> shared = std::make_shared<Shared>();
+    std::condition_variable wake_cv;  // the supervisor's
+    std::vector<MemberPtr> active;
+    std::vector<MemberPtr> spares;
+    std::unordered_set<std::string> hedgeable_tools;
+    bool running = false;
+    bool stopping = false;
+    bool wake = false;
+    uint64_t launched = 0;
+    uint64_t respawned = 0;
+    uint64_t failed_launches = 0;
+    std::thread supervisor;
+
+    // Fires hedges. Declared last so its thread stops first.
+    TimerWheel timers{std::chrono::milliseconds(1)};
+
+    Impl(std::string cmd, std::vector<std::string> a, Options o)
+        : command(std::move(cmd)), args(std::move(a)), opts(std::move(o)) {
+        if (opts.hedge_idempotent) timers.start();
+    }
+
+    [[nodiscard]] size_t target() const { return opts.size + opts.warm_spares; }
+
+    std::pair<MemberPtr, InitializeResult> launch() const {
+        auto m = std::make_shared<Member>(opts);
+        m->client = std::make_unique<McpClient>(opts.client);
+        m->client->on_tools_changed([s = shared] { s->tools_stale = true; });
+        m->client->connect_stdio(command, args);
+        auto result = m->client->initialize();
+        return {std::move(m), std::move(result)};
+    }
+
+    // Puts a ready process to work, or keeps it as a spare; mutex held
+    void place(MemberPtr m) {
+        if (active.size() < opts.size) {
+            active.push_back(std::move(m));
+            shared->ready_cv.notify_all();
+        } else {
+            spares.push_back(std::move(m));
+        }
+    }
+
+    void wake_supervisor() {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        wake = true;
+        wake_cv.notify_one();
+    }
+
+    void supervise() {
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        auto backoff = opts.respawn_backoff;
+        bool failing = false;
+        bool refill = false;
+        while (!stopping) {
+            if (!refill) {
+                wake_cv.wait_for(lock, failing ? backoff : opts.health_check_interval,
+                                 [this] { return stopping || wake; });
+                wake = false;
+                if (stopping) break;
+            }
+
+            std::vector<MemberPtr> exited;
+            auto reap = [&exited](std::vector<MemberPtr>& members) {
+                auto alive = std::partition(members.begin(), members.end(),
+                    [](const MemberPtr& m) { return m->client->is_connected(); });
+                std::move(alive, members.end(), std::back_inserter(exited));
+                members.erase(alive, members.end());
+            };
+            reap(active);
+            reap(spares);
+            while (active.size() < opts.size && !spares.empty()) {
+                active.push_back(std::move(spares.back()));
+                spares.pop_back();
+                shared->ready_cv.notify_all();
+            }
+            refill = active.size() + spares.size() < target();
+            lock.unlock();
+
+            for (auto& m : exited) m->client->disconnect();
+            exited.clear();
+            if (opts.hedge_idempotent && shared->tools_stale.load()) refresh_tools();
+
+            if (!refill) {
+                lock.lock();
+                continue;
+            }
+            try {
+                auto launched_member = launch().first;
+                lock.lock();
+                ++launched;
+                ++respawned;
+                if (stopping) {
+                    lock.unlock();
+                    launched_member->client->disconnect();
+                    lock.lock();
+                    break;
+                }
+                place(std::move(launched_member));
+                failing = false;
+                backoff = opts.respawn_backoff;
+            } catch (...) {
+                lock.lock();
+                ++failed_launches;
+                if (failing) backoff = std::min(backoff * 2, opts.max_respawn_backoff);
+                failing = true;
+                refill = false;  // wait out the backoff first
+            }
+        }
+    }
+
+    // Which tools may be sent twice, from their annotations
+    void refresh_tools() {
+        shared->tools_stale = false;
+        auto lease = try_acquire(nullptr);
+        if (!lease) {
+            shared->tools_stale = true;
+            return;
+        }
+        try {
+            std::unordered_set<std::string> names;
+            for (const auto& tool : lease->client().list_all_tools()) {
+                if (allows_hedging(tool)) names.insert(tool.name);
+            }
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            hedgeable_tools = std::move(names);
+        } catch (...) {
+            shared->tools_stale = true;
+        }
+    }
+
+    [[nodiscard]] bool hedgeable(const std::string& tool) const {
+        if (!opts.hedge_idempotent) return false;
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        return hedgeable_tools.count(tool) > 0;
+    }
+
+    // The least busy serving process with room under its limit; mutex held
+    MemberPtr pick(const Member* exclude) const {
+        MemberPtr best;
+        size_t best_load = 0;
+        for (const auto& m : active) {
+            if (m.get() == exclude || !m->client->is_connected()) continue;
+            size_t load = m->outstanding.load(std::memory_order_relaxed);
+            if (load >= m->limiter.limit()) continue;
+            if (!best || load < best_load) {
+                best = m;
+                best_load = load;
+            }
+        }
+        return best;
+    }
+
+    Lease make_lease(MemberPtr m) const {
+        return Lease(std::move(m), opts.adaptive_limit ? shared : nullptr);
+    }
+
+    // Waits for a process if none is serving or all are at their limit
+    Lease acquire() {
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        if (!running) throw McpTransportError("Client pool is not running");
+        MemberPtr best = pick(nullptr);
+        if (!best) {
+            wake = true;
+            wake_cv.notify_one();
+            shared->ready_cv.wait_for(lock, opts.client.request_timeout, [&] {
+                best = pick(nullptr);
+                return best != nullptr || stopping;
+            });
+        }
+        if (!best) throw McpTransportError("No server process available in the pool");
+        return make_lease(std::move(best));
+    }
+
+    std::optional<Lease> try_acquire(const Member* exclude) {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (!running || stopping) return std::nullopt;
+        MemberPtr best = pick(exclude);
+        if (!best) return std::nullopt;
+        return make_lease(std::move(best));
+    }
+
+    template<typename F>
+    auto call(F f) -> decltype(f(std::declval<McpClient&>())) {
+        auto lease = acquire();
+        try {
+            if constexpr (std::is_void_v<decltype(f(lease.client()))>) {
+                f(lease.client());
+                lease.record(false);
+            } else {
+                auto result = f(lease.client());
+                lease.record(false);
+                return result;
+            }
+        } catch (const McpTimeoutError&) {
+            lease.record(true);
+            throw;
+        } catch (...) {
+            if (!lease.client().is_connected()) wake_supervisor();
+            throw;
+        }
+    }
+
+    // The result resumes an awaiting coroutine where the member's own
+    // result resumed this one, i.e. on client.executor if there is one
+    template<typename T, typename F>
+    Async<T> call_async(F f) {
+        auto lease = acquire();
+        Async<T> inner = f(lease.client());
+        AsyncPromise<T> promise;
+        auto result = promise.get_async();
+        promise.on_cancel([inner] { inner.cancel(); });
+        spawn(hold(std::move(inner), std::move(lease)),
+              [promise](auto&&... value) { promise.set_value(std::move(value)...); },
+              [promise](std::exception_ptr e) { promise.set_exception(std::move(e)); });
+        return result;
+    }
+
+    // Sends one attempt of a hedged call
+    void attempt(const std::shared_ptr<Hedge>& h, Lease lease, const std::string& name,
+                 const nlohmann::json& arguments, bool is_hedge) {
+        auto inner = lease.client().call_tool_async(name, arguments);
+        {
+            std::lock_guard<std::mutex> lock(h->mutex);
+            ++h->running;
+            h->attempts.push_back(inner);
+        }
+        auto start = Clock::now();
+        spawn(hold(std::move(inner), std::move(lease)),
+            [h, s = shared, is_hedge, start](CallToolResult result) {
+                s->record_call(elapsed_ns(start));
+                std::vector<Async<CallToolResult>> losers;
+                {
+                    std::lock_guard<std::mutex> lock(h->mutex);
+                    --h->running;
+                    if (h->done) return;
+                    h->done = true;
+                    losers = std::move(h->attempts);
+                }
+                if (is_hedge) s->hedge_wins.fetch_add(1, std::memory_order_relaxed);
+                h->promise.set_value(std::move(result));
+                for (auto& loser : losers) loser.cancel();  // no-op for the winner
+            },
+            [h](std::exception_ptr e) {
+                // A failure only counts once no attempt is left to succeed
+                {
+                    std::lock_guard<std::mutex> lock(h->mutex);
+                    --h->running;
+                    if (h->done) return;
+                    if (!h->error) h->error = e;
+                    if (h->running > 0) return;
+                    h->done = true;
+                }
+                h->promise.set_exception(h->error);
+            });
+    }
+
+    Async<CallToolResult> call_tool(const std::string& name, const nlohmann::json& arguments) {
+        auto h = std::make_shared<Hedge>();
+        auto result = h->promise.get_async();
+        auto first = acquire();
+        const Member* first_member = first.member();
+        attempt(h, std::move(first), name, arguments, false);
+        h->promise.on_cancel([weak = std::weak_ptr<Hedge>(h)] {
+            auto h = weak.lock();
+            if (!h) return;
+            std::vector<Async<CallToolResult>> attempts;
+            {
+                std::lock_guard<std::mutex> lock(h->mutex);
+                attempts = h->attempts;
+            }
+            for (auto& a : attempts) a.cancel();
+        });
+
+        auto delay = hedgeable(name) ? shared->hedge_delay(opts) : std::nullopt;
+        if (!delay) return result;
+        // first_member is only compared, never dereferenced, once the lease is gone
+        timers.schedule(*delay, [this, h, name, arguments, first_member] {
+            {
+                std::lock_guard<std::mutex> lock(h->mutex);
+                if (h->done) return;
+            }
+            auto second = try_acquire(first_member);
+            if (!second) return;
+            shared->hedges.fetch_add(1, std::memory_order_relaxed);
+            try {
+                attempt(h, std::move(*second), name, arguments, true);
+            } catch (...) {
+                // The first attempt is still running
+            }
+        });
+        return result;
+    }
+};
+
+McpClientPool::McpClientPool(std::string command, std::vector<std::string> args, Options opts) {
+    if (opts.size == 0) throw std::invalid_argument("McpClientPool needs at least one process");
+    impl_ = std::make_unique<Impl>(std::move(command), std::move(args), std::move(opts));
+}
+
+McpClientPool::~McpClientPool() {
+    stop();
+}
+
+InitializeResult McpClientPool::start() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->shared->mutex);
+        if (impl_->running) throw McpTransportError("Client pool is already running");
+    }
+
+    // Launched side by side: startup costs one process's, not N of them
+    const size_t n = impl_->target();
+    std::vector<std::optional<std::pair<MemberPtr, InitializeResult>>> launched(n);
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<std::thread> launchers;
+    launchers.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        launchers.emplace_back([this, &launched, &errors, i] {
+            try {
+                launched[i] = impl_->launch();
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& t : launchers) t.join();
+
+    std::optional<InitializeResult> result;
+    std::exception_ptr first_error;
+    {
+        std::lock_guard<std::mutex> lock(impl_->shared->mutex);
+        for (size_t i = 0; i < n; ++i) {
+            if (!launched[i]) {
+                ++impl_->failed_launches;
+                if (!first_error) first_error = errors[i];
+                continue;
+            }
+            ++impl_->launched;
+            if (!result) result = launched[i]->second;
+            impl_->place(std::move(launched[i]->first));
+        }
+        if (result) {
+            impl_->running = true;
+            impl_->stopping = false;
+            impl_->wake = false;
+        }
+    }
+    if (!result) std::rethrow_exception(first_error);
+    if (impl_->opts.hedge_idempotent) impl_->refresh_tools();
+    impl_->supervisor = std::thread([this] { impl_->supervise(); });
+    return *result;
+}
+
+void McpClientPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->shared->mutex);
+        if (!impl_->running) return;
+        impl_->stopping = true;
+        impl_->wake_cv.notify_all();
+        impl_->shared->ready_cv.notify_all();
+    }
+    if (impl_->supervisor.joinable()) impl_->supervisor.join();
+
+    std::vector<MemberPtr> all;
+    {
+        std::lock_guard<std::mutex> lock(impl_->shared->mutex);
+        all = std::move(impl_->active);
+        all.insert(all.end(), std::make_move_iterator(impl_->spares.begin()),
+                   std::make_move_iterator(impl_->spares.end()));
+        impl_->active.clear();
+        impl_->spares.clear();
+        impl_->running = false;
+    }
+    for (auto& m : all) m->client->disconnect();
+}
+
+PaginatedResult<ToolDefinition> McpClientPool::list_tools(std::optional<std::string> cursor) {
+    return impl_->call([&](McpClient& c) { return c.list_tools(cursor); });
+}
+
+CallToolResult McpClientPool::call_tool(const std::string& name, const nlohmann::json& arguments) {
+    return impl_->call_tool(name, arguments).get();
+}
+
+Async<CallToolResult> McpClientPool::call_tool_async(const std::string& name,
+                                                     const nlohmann::json& arguments) {
+    return impl_->call_tool(name, arguments);
+}
+
+PaginatedResult<ResourceDefinition> McpClientPool::list_resources(std::optional<std::string> cursor) {
+    return impl_->call([&](McpClient& c) { return c.list_resources(cursor); });
+}
+
+std::vector<ResourceContent> McpClientPool::read_resource(const std::string& uri) {
+    return impl_->call([&](McpClient& c) { return c.read_resource(uri); });
+}
+
+Async<std::vector<ResourceContent>> McpClientPool::read_resource_async(const std::string& uri) {
+    return impl_->call_async<std::vector<ResourceContent>>(
+        [&](McpClient& c) { return c.read_resource_async(uri); });
+}
+
+PaginatedResult<ResourceTemplate> McpClientPool::list_resource_templates(std::optional<std::string> cursor) {
+    return impl_->call([&](McpClient& c) { return c.list_resource_templates(cursor); });
+}
+
+PaginatedResult<PromptDefinition> McpClientPool::list_prompts(std::optional<std::string> cursor) {
+    return impl_->call([&](McpClient& c) { return c.list_prompts(cursor); });
+}
+
+GetPromptResult McpClientPool::get_prompt(const std::string& name, const nlohmann::json& arguments) {
+    return impl_->call([&](McpClient& c) { return c.get_prompt(name, arguments); });
+}
+
+Async<GetPromptResult> McpClientPool::get_prompt_async(const std::string& name,
+                                                       const nlohmann::json& arguments) {
+    return impl_->call_async<GetPromptResult>(
+        [&](McpClient& c) { return c.get_prompt_async(name, arguments); });
+}
+
+CompletionResult McpClientPool::complete(const CompletionRef& ref, const std::string& arg_name,
+                                         const std::string& arg_value) {
+    return impl_->call([&](McpClient& c) { return c.complete(ref, arg_name, arg_value); });
+}
+
+void McpClientPool::ping() {
+    impl_->call([](McpClient& c) { c.ping(); });
+}
+
+McpClientPool::Stats McpClientPool::stats() const {
+    std::lock_guard<std::mutex> lock(impl_->shared->mutex);
+    Stats s;
+    s.active = impl_->active.size();
+    s.spares = impl_->spares.size();
+    for (const auto& m : impl_->active) {
+        s.in_flight += m->outstanding.load(std::memory_order_relaxed);
+        if (impl_->opts.adaptive_limit) s.concurrency_limit += m->limiter.limit();
+    }
+    s.launched = impl_->launched;
+    s.respawned = impl_->respawned;
+    s.failed_launches = impl_->failed_launches;
+    s.hedges = impl_->shared->hedges.load(std::memory_order_relaxed);
+    s.hedge_wins = impl_->shared->hedge_wins.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace mcp
@@ -1,8 +1,12 @@
 #include "mcp/codec.hpp"
+#include "mcp/arena.hpp"
 #include "mcp/error.hpp"
+#include "mcp/json_writer.hpp"
+#include "mcp/metrics.hpp"
 #include "mcp/version.hpp"
 #include <nlohmann/json.hpp>
 #include <simdjson.h>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
@@ -62,9 +66,234 @@ nlohmann::json simdjson_doc_to_nlohmann(simdjson::ondemand::document& doc) {
     return simdjson_to_nlohmann(val.value());
 }
 
+// Padded copy of `raw` in the thread's scratch arena; valid until the
+// caller's ScratchArena::Scope ends.
+simdjson::padded_string_view padded_copy(const ScratchArena::Scope& scope, std::string_view raw) {
+    char* buf = scope.arena().allocate_bytes(raw.size() + simdjson::SIMDJSON_PADDING);
+    std::memcpy(buf, raw.data(), raw.size());
+    std::memset(buf + raw.size(), 0, simdjson::SIMDJSON_PADDING);
+    return simdjson::padded_string_view(buf, raw.size(), raw.size() + simdjson::SIMDJSON_PADDING);
+}
+
+// Parsers keep their internal buffers between documents; reusing one per
+// thread avoids reallocating them for every message.
+simdjson::ondemand::parser& thread_parser() {
+    thread_local simdjson::ondemand::parser parser;
+    return parser;
+}
+
+RequestId read_id(simdjson::ondemand::value val) {
+    switch (val.type()) {
+        case simdjson::ondemand::json_type::number: {
+            int64_t i;
+            if (val.get_int64().get(i)) throw McpParseError("Request ID must be an integer or string");
+            return RequestId{i};
+        }
+        case simdjson::ondemand::json_type::string:
+            return RequestId{std::string(std::string_view(val.get_string()))};
+        default:
+            throw McpParseError("Request ID must be an integer or string");
+    }
+}
+
+// Builds a message from one top-level object without converting the
+// payload: params/result are sliced out verbatim.
+JsonRpcMessage parse_envelope(simdjson::ondemand::object obj) {
+    bool has_jsonrpc = false;
+    bool has_id = false;
+    bool id_null = false;
+    RequestId id;
+    std::optional<std::string> method;
+    std::optional<std::string> params;
+    std::optional<std::string> result;
+    std::optional<nlohmann::json> meta;
+    std::optional<nlohmann::json> error;
+
+    for (auto field : obj) {
+        std::string_view key = field.unescaped_key();
+        simdjson::ondemand::value val = field.value();
+        if (key == "jsonrpc") {
+            std::string_view version;
+            if (val.get_string().get(version) || version != JSONRPC_VERSION) {
+                throw McpParseError("Invalid jsonrpc version, expected '2.0'");
+            }
+            has_jsonrpc = true;
+        } else if (key == "id") {
+            has_id = true;
+            id_null = val.is_null();
+            if (!id_null) id = read_id(val);
+        } else if (key == "method") {
+            std::string_view m;
+            if (val.get_string().get(m)) throw McpParseError("'method' must be a string");
+            method = std::string(m);
+        } else if (key == "params") {
+            params = std::string(std::string_view(val.raw_json()));
+        } else if (key == "result") {
+            result = std::string(std::string_view(val.raw_json()));
+        } else if (key == "error") {
+            error = simdjson_to_nlohmann(val);
+        } else if (key == "_meta") {
+            meta = simdjson_to_nlohmann(val);
+        }
+    }
+
+    if (!has_jsonrpc) {
+        throw McpParseError("Missing 'jsonrpc' field");
+    }
+
+    if (method && has_id) {
+        if (id_null) throw McpParseError("Request ID must not be null");
+        JsonRpcRequest req;
+        req.id = std::move(id);
+        req.method = std::move(*method);
+        req.method_id = intern_method(req.method);
+        if (params) req.params = LazyJson::from_raw(std::move(*params));
+        req.meta = std::move(meta);
+        return req;
+    } else if (method) {
+        JsonRpcNotification notif;
+        notif.method = std::move(*method);
+        notif.method_id = intern_method(notif.method);
+        if (params) notif.params = LazyJson::from_raw(std::move(*params));
+        return notif;
+    } else if (has_id) {
+        if (id_null) throw McpParseError("Response ID must not be null");
+        JsonRpcResponse resp;
+        resp.id = std::move(id);
+        if (result) resp.result = LazyJson::from_raw(std::move(*result));
+        if (error) resp.error = error->get<JsonRpcError>();
+        return resp;
+    }
+    throw McpParseError("Cannot determine message type: missing both 'id' and 'method'");
+}
+
+void write_payload(JsonWriter& w, const LazyJson& value) {
+    if (auto raw = value.raw()) {
+        w.raw(*raw);
+    } else {
+        w.value(value.value());
+    }
+}
+
+void write_id(JsonWriter& w, const RequestId& id) {
+    if (auto* i = std::get_if<int64_t>(&id)) {
+        w.value(*i);
+    } else {
+        w.value(std::get<std::string>(id));
+    }
+}
+
+// Writes the envelope directly so raw payloads can be spliced in unchanged.
+void write_message(JsonWriter& w, const JsonRpcMessage& msg) {
+    w.begin_object();
+    w.field("jsonrpc", JSONRPC_VERSION);
+    if (const auto* req = std::get_if<JsonRpcRequest>(&msg)) {
+        w.key("id");
+        write_id(w, req->id);
+        w.field("method", req->method);
+        if (req->params) {
+            w.key("params");
+            write_payload(w, req->params);
+        }
+        if (req->meta) w.field("_meta", *req->meta);
+    } else if (const auto* resp = std::get_if<JsonRpcResponse>(&msg)) {
+        w.key("id");
+        write_id(w, resp->id);
+        if (resp->result_stream) {
+            // Pieces go straight into the buffer; raw("") then closes the value
+            w.key("result");
+            while (resp->result_stream(w.buffer())) {}
+            w.raw({});
+        } else if (resp->result) {
+            w.key("result");
+            write_payload(w, resp->result);
+        }
+        if (resp->error) {
+            w.key("error").begin_object();
+            w.field("code", resp->error->code);
+            w.field("message", resp->error->message);
+            if (resp->error->data) w.field("data", *resp->error->data);
+            w.end_object();
+        }
+    } else if (const auto* notif = std::get_if<JsonRpcNotification>(&msg)) {
+        w.field("method", notif->method);
+        if (notif->params) {
+            w.key("params");
+            write_payload(w, notif->params);
+        }
+    }
+    w.end_object();
+}
+
+// Counts `parse()`'s outcome toward the codec metrics.
+template<typename Parse>
+auto counted_parse(size_t bytes, Parse&& parse) {
+    try {
+        auto parsed = parse();
+        if constexpr (std::is_same_v<decltype(parsed), JsonRpcMessage>) {
+            detail::count_parsed(bytes, 1);
+        } else {
+            detail::count_parsed(bytes, parsed.size());
+        }
+        return parsed;
+    } catch (...) {
+        detail::count_parse_error();
+        throw;
+    }
+}
+
+JsonRpcMessage parse_message(simdjson::padded_string_view input) {
+    try {
+        simdjson::ondemand::document doc = thread_parser().iterate(input);
+        simdjson::ondemand::object obj;
+        if (doc.get_object().get(obj)) {
+            throw McpParseError("Message must be a JSON object");
+        }
+        auto msg = parse_envelope(obj);
+        if (!doc.at_end()) {
+            throw McpParseError("Trailing content after JSON message");
+        }
+        return msg;
+    } catch (const simdjson::simdjson_error& e) {
+        throw McpParseError(std::string("JSON parse error: ") + e.what());
+    } catch (const nlohmann::json::exception& e) {
+        throw McpParseError(std::string("Invalid message: ") + e.what());
+    }
+}
+
+std::vector<JsonRpcMessage> parse_batch_items(simdjson::padded_string_view padded) {
+    try {
+        simdjson::ondemand::document doc = thread_parser().iterate(padded);
+        simdjson::ondemand::array arr;
+        if (doc.get_array().get(arr)) {
+            throw McpParseError("Batch must be a JSON array");
+        }
+
+        std::vector<JsonRpcMessage> messages;
+        for (auto item : arr) {
+            simdjson::ondemand::object obj;
+            if (item.get_object().get(obj)) {
+                throw McpParseError("Each batch item must be a JSON object");
+            }
+            messages.push_back(parse_envelope(obj));
+        }
+        if (!doc.at_end()) {
+            throw McpParseError("Trailing content after JSON batch");
+        }
+        return messages;
+    } catch (const simdjson::simdjson_error& e) {
+        throw McpParseError(std::string("JSON parse error: ") + e.what());
+    } catch (const nlohmann::json::exception& e) {
+        throw McpParseError(std::string("Invalid message: ") + e.what());
+    }
+}
+
 } // anonymous namespace
 
-JsonRpcMessage Codec::parse_object(const nlohmann::json& j) {
+static_assert(Codec::kParsePadding >= simdjson::SIMDJSON_PADDING,
+              "Codec::kParsePadding must cover simdjson's read-ahead");
+
+JsonRpcMessage Codec::parse_object(nlohmann::json j) {
     // Validate jsonrpc version
     if (!j.contains("jsonrpc")) {
         throw McpParseError("Missing 'jsonrpc' field");
@@ -85,14 +314,16 @@ JsonRpcMessage Codec::parse_object(const nlohmann::json& j) {
         JsonRpcRequest req;
         from_json(j.at("id"), req.id);
         req.method = j.at("method").get<std::string>();
-        if (j.contains("params")) req.params = j.at("params");
-        if (j.contains("_meta")) req.meta = j.at("_meta");
+        req.method_id = intern_method(req.method);
+        if (j.contains("params")) req.params = std::move(j["params"]);
+        if (j.contains("_meta")) req.meta = std::move(j["_meta"]);
         return req;
     } else if (has_method && !has_id) {
         // It's a notification
         JsonRpcNotification notif;
         notif.method = j.at("method").get<std::string>();
-        if (j.contains("params")) notif.params = j.at("params");
+        notif.method_id = intern_method(notif.method);
+        if (j.contains("params")) notif.params = std::move(j["params"]);
         return notif;
     } else if (has_id && !has_method) {
         // It's a response
@@ -101,7 +332,7 @@ JsonRpcMessage Codec::parse_object(const nlohmann::json& j) {
         }
         JsonRpcResponse resp;
         from_json(j.at("id"), resp.id);
-        if (j.contains("result")) resp.result = j.at("result");
+        if (j.contains("result")) resp.result = std::move(j["result"]);
         if (j.contains("error")) resp.error = j.at("error").get<JsonRpcError>();
         return resp;
     } else {
@@ -109,43 +340,111 @@ JsonRpcMessage Codec::parse_object(const nlohmann::json& j) {
     }
 }
 
+
 JsonRpcMessage Codec::parse(std::string_view raw) {
     if (raw.empty()) {
         throw McpParseError("Empty input");
     }
+    ScratchArena::Scope scope;
+    return counted_parse(raw.size(), [&] { return parse_message(padded_copy(scope, raw)); });
+}
 
-    // Use simdjson for fast parsing
-    simdjson::ondemand::parser parser;
-    // simdjson requires padded input
-    simdjson::padded_string padded(raw.data(), raw.size());
-
-    simdjson::ondemand::document doc;
-    auto error = parser.iterate(padded).get(doc);
-    if (error) {
-        throw McpParseError(std::string("JSON parse error: ") + simdjson::error_message(error));
+JsonRpcMessage Codec::parse_padded(std::string_view raw) {
+    if (raw.empty()) {
+        throw McpParseError("Empty input");
     }
+    return counted_parse(raw.size(), [&] {
+        return parse_message(simdjson::padded_string_view(raw.data(), raw.size(),
+                                                          raw.size() + kParsePadding));
+    });
+}
 
-    // Convert to nlohmann for further processing
-    nlohmann::json j;
+nlohmann::json Codec::parse_value(std::string_view raw) {
+    ScratchArena::Scope scope;
+    auto padded = padded_copy(scope, raw);
     try {
-        j = simdjson_doc_to_nlohmann(doc);
-    } catch (const std::exception& e) {
-        throw McpParseError(std::string("JSON conversion error: ") + e.what());
+        simdjson::ondemand::document doc = thread_parser().iterate(padded);
+        nlohmann::json j;
+        // On-demand documents expose scalars only through typed getters
+        switch (doc.type()) {
+            case simdjson::ondemand::json_type::object:
+            case simdjson::ondemand::json_type::array:
+                j = simdjson_doc_to_nlohmann(doc);
+                break;
+            case simdjson::ondemand::json_type::string:
+                j = std::string(std::string_view(doc.get_string()));
+                break;
+            case simdjson::ondemand::json_type::number: {
+                int64_t i;
+                uint64_t u;
+                if (!doc.get_int64().get(i)) j = i;
+                else if (!doc.get_uint64().get(u)) j = u;
+                else j = double(doc.get_double());
+                break;
+            }
+            case simdjson::ondemand::json_type::boolean:
+                j = bool(doc.get_bool());
+                break;
+            default:
+                if (!doc.is_null()) throw McpParseError("Invalid JSON value");
+                break;
+        }
+        if (!doc.at_end()) {
+            throw McpParseError("Trailing content after JSON value");
+        }
+        return j;
+    } catch (const simdjson::simdjson_error& e) {
+        throw McpParseError(std::string("JSON parse error: ") + e.what());
     }
+}
 
-    if (!j.is_object()) {
-        throw McpParseError("Message must be a JSON object");
-    }
+std::optional<std::string_view> Codec::find_raw_member(std::string_view object,
+                                                       std::string_view key) {
+    return find_raw_members(object, {key}).front();
+}
+
+std::vector<std::optional<std::string_view>> Codec::find_raw_members(
+    std::string_view object, std::initializer_list<std::string_view> keys) {
+    std::vector<std::optional<std::string_view>> found(keys.size());
+    ScratchArena::Scope scope;
+    auto padded = padded_copy(scope, object);
+    try {
+        simdjson::ondemand::document doc = thread_parser().iterate(padded);
+        simdjson::ondemand::object obj;
+        if (doc.get_object().get(obj)) {
+            throw McpParseError("Expected a JSON object");
+        }
+        size_t remaining = keys.size();
+        for (auto field : obj) {
+            std::string_view k = field.unescaped_key();
+            simdjson::ondemand::value val = field.value();
+            size_t index = 0;
+            for (auto want : keys) {
+                if (k == want && !found[index]) break;
+                ++index;
+            }
+            if (index == keys.size()) continue;
 
-    return parse_object(j);
+            std::string_view view = val.raw_json();
+            // Map the view from the padded copy back onto the caller's buffer
+            size_t offset = static_cast<size_t>(view.data() - padded.data());
+            found[index] = object.substr(offset, view.size());
+            if (--remaining == 0) break;
+        }
+        return found;
+    } catch (const simdjson::simdjson_error& e) {
+        throw McpParseError(std::string("JSON parse error: ") + e.what());
+    }
 }
 
-std::vector<JsonRpcMessage> Codec::parse_batch(std::string_view raw) {
+JsonRpcMessage Codec::parse_dom(std::string_view raw) {
     if (raw.empty()) {
         throw McpParseError("Empty input");
     }
 
+    // Use simdjson for fast parsing
     simdjson::ondemand::parser parser;
+    // simdjson requires padded input
     simdjson::padded_string padded(raw.data(), raw.size());
 
     simdjson::ondemand::document doc;
@@ -154,6 +453,7 @@ std::vector<JsonRpcMessage> Codec::parse_batch(std::string_view raw) {
         throw McpParseError(std::string("JSON parse error: ") + simdjson::error_message(error));
     }
 
+    // Convert to nlohmann for further processing
     nlohmann::json j;
     try {
         j = simdjson_doc_to_nlohmann(doc);
@@ -161,35 +461,59 @@ std::vector<JsonRpcMessage> Codec::parse_batch(std::string_view raw) {
         throw McpParseError(std::string("JSON conversion error: ") + e.what());
     }
 
-    if (!j.is_array()) {
-        throw McpParseError("Batch must be a JSON array");
+    return from_dom(std::move(j));
+}
+
+JsonRpcMessage Codec::from_dom(nlohmann::json j) {
+    if (!j.is_object()) {
+        throw McpParseError("Message must be a JSON object");
     }
+    return parse_object(std::move(j));
+}
 
-    std::vector<JsonRpcMessage> messages;
-    messages.reserve(j.size());
-    for (const auto& item : j) {
-        if (!item.is_object()) {
-            throw McpParseError("Each batch item must be a JSON object");
-        }
-        messages.push_back(parse_object(item));
+std::vector<JsonRpcMessage> Codec::parse_batch(std::string_view raw) {
+    if (raw.empty()) {
+        throw McpParseError("Empty input");
     }
-    return messages;
+
+    ScratchArena::Scope scope;
+    auto padded = padded_copy(scope, raw);
+    return counted_parse(raw.size(), [&] { return parse_batch_items(padded); });
+}
+
+void Codec::serialize_to(std::string& out, const JsonRpcMessage& msg) {
+    size_t start = out.size();
+    JsonWriter w(out);
+    write_message(w, msg);
+    detail::count_serialized(out.size() - start, 1);
+}
+
+void Codec::serialize_result_head(std::string& out, const RequestId& id) {
+    JsonWriter w(out);
+    w.begin_object().field("jsonrpc", JSONRPC_VERSION).key("id");
+    write_id(w, id);
+    w.key("result");
 }
 
 std::string Codec::serialize(const JsonRpcMessage& msg) {
-    nlohmann::json j;
-    to_json(j, msg);
-    return j.dump();
+    std::string out;
+    serialize_to(out, msg);
+    return out;
 }
 
 std::string Codec::serialize_batch(const std::vector<JsonRpcMessage>& msgs) {
-    nlohmann::json arr = nlohmann::json::array();
-    for (const auto& msg : msgs) {
-        nlohmann::json j;
-        to_json(j, msg);
-        arr.push_back(std::move(j));
-    }
-    return arr.dump();
+    std::string out;
+    serialize_batch_to(out, msgs);
+    return out;
+}
+
+void Codec::serialize_batch_to(std::string& out, const std::vector<JsonRpcMessage>& msgs) {
+    size_t start = out.size();
+    JsonWriter w(out);
+    w.begin_array();
+    for (const auto& msg : msgs) write_message(w, msg);
+    w.end_array();
+    detail::count_serialized(out.size() - start, msgs.size());
 }
 
 } // namespace mcp
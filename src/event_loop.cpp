@@ -0,0 +1,218 @@
+#include "mcp/event_loop.hpp"
+#include "mcp/error.hpp"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <csignal>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace mcp {
+
+namespace {
+constexpr int kMaxEvents = 64;
+
+[[noreturn]] void throw_errno(const char* what) {
+    throw McpTransportError(std::string(what) + ": " + std::strerror(errno));
+}
+} // anonymous namespace
+
+struct EventLoop::Poller::Impl {
+    struct Watch {
+        uint32_t generation;
+        std::shared_ptr<const Handler> handler;
+    };
+
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::thread thread;
+    std::thread::id thread_id;
+
+    std::mutex mutex;
+    std::condition_variable barrier_cv;
+    std::unordered_map<int, Watch> watches;
+    uint32_t next_generation = 0;
+    std::vector<Task> tasks;
+    bool running = true;   // false once the thread stopped taking tasks
+    bool stopping = false;
+    uint64_t batches = 0;  // event batches fully handled
+
+    ~Impl() {
+        if (epoll_fd >= 0) ::close(epoll_fd);
+        if (wake_fd >= 0) ::close(wake_fd);
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        (void)::write(wake_fd, &one, sizeof(one));
+    }
+
+    void run() {
+        epoll_event events[kMaxEvents];
+        std::vector<Task> ready;
+        while (true) {
+            int n = ::epoll_wait(epoll_fd, events, kMaxEvents, -1);
+            if (n < 0 && errno != EINTR) break;
+
+            for (int i = 0; i < n; ++i) {
+                // The generation tells a dead watch from a new one that
+                // reused the fd within the same batch
+                int fd = static_cast<int>(events[i].data.u64 & 0xffffffffu);
+                auto generation = static_cast<uint32_t>(events[i].data.u64 >> 32);
+                if (fd == wake_fd) {
+                    uint64_t count;
+                    (void)::read(wake_fd, &count, sizeof(count));
+                    continue;
+                }
+                std::shared_ptr<const Handler> handler;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto it = watches.find(fd);
+                    if (it == watches.end() || it->second.generation != generation) continue;
+                    handler = it->second.handler;
+                }
+                try {
+                    (*handler)(events[i].events);
+                } catch (...) {
+                    // A handler's failure is its connection's business
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++batches;
+                ready.swap(tasks);
+                if (stopping) running = false;
+            }
+            barrier_cv.notify_all();
+            for (auto& task : ready) {
+                try {
+                    task();
+                } catch (...) {
+                }
+            }
+            ready.clear();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) break;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        watches.clear();
+        tasks.clear();
+        barrier_cv.notify_all();
+    }
+};
+
+EventLoop::Poller::Poller()
+    : impl_(std::make_shared<Impl>()) {
+    impl_->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (impl_->epoll_fd < 0) throw_errno("epoll_create1");
+    impl_->wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (impl_->wake_fd < 0) throw_errno("eventfd");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = static_cast<uint32_t>(impl_->wake_fd);
+    if (::epoll_ctl(impl_->epoll_fd, EPOLL_CTL_ADD, impl_->wake_fd, &ev) < 0) {
+        throw_errno("epoll_ctl");
+    }
+    impl_->thread = std::thread([impl = impl_] {
+        // Transports write to pipes here; see StdioTransport::write_loop()
+        sigset_t sigpipe;
+        sigemptyset(&sigpipe);
+        sigaddset(&sigpipe, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+        impl->run();
+    });
+    impl_->thread_id = impl_->thread.get_id();
+}
+
+EventLoop::Poller::~Poller() {
+    stop();
+}
+
+void EventLoop::Poller::stop() {
+    if (!impl_->thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->wake();
+    if (on_thread()) {
+        // Destroyed from a handler: the thread finishes its batch and exits
+        impl_->thread.detach();
+    } else {
+        impl_->thread.join();
+    }
+}
+
+void EventLoop::Poller::watch(int fd, uint32_t events, Handler handler) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    uint32_t generation = ++impl_->next_generation;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = (uint64_t{generation} << 32) | static_cast<uint32_t>(fd);
+    if (::epoll_ctl(impl_->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) throw_errno("epoll_ctl");
+    impl_->watches[fd] = {generation, std::make_shared<const Handler>(std::move(handler))};
+}
+
+void EventLoop::Poller::modify(int fd, uint32_t events) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto it = impl_->watches.find(fd);
+    if (it == impl_->watches.end()) return;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = (uint64_t{it->second.generation} << 32) | static_cast<uint32_t>(fd);
+    if (::epoll_ctl(impl_->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) throw_errno("epoll_ctl");
+}
+
+void EventLoop::Poller::unwatch(int fd) {
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    if (impl_->watches.erase(fd) == 0) return;
+    ::epoll_ctl(impl_->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    if (on_thread() || !impl_->running) return;
+
+    // The handler may be running right now; wait out the current batch
+    uint64_t seen = impl_->batches;
+    impl_->wake();
+    impl_->barrier_cv.wait(lock, [&] { return impl_->batches != seen || !impl_->running; });
+}
+
+void EventLoop::Poller::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (!impl_->running) return;
+        impl_->tasks.push_back(std::move(task));
+    }
+    impl_->wake();
+}
+
+bool EventLoop::Poller::on_thread() const noexcept {
+    return std::this_thread::get_id() == impl_->thread_id;
+}
+
+EventLoop::EventLoop()
+    : EventLoop(Options{}) {
+}
+
+EventLoop::EventLoop(Options opts) {
+    size_t n = std::max<size_t>(opts.num_threads, 1);
+    pollers_.reserve(n);
+    for (size_t i = 0; i < n; ++i) pollers_.push_back(std::unique_ptr<Poller>(new Poller()));
+}
+
+EventLoop::~EventLoop() = default;
+
+EventLoop::Poller& EventLoop::next() {
+    return *pollers_[next_.fetch_add(1, std::memory_order_relaxed) % pollers_.size()];
+}
+
+} // namespace mcp
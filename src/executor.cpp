@@ -0,0 +1,148 @@
+#include "mcp/executor.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mcp {
+
+namespace {
+
+// Identifies the executor (and worker slot) the current thread belongs to,
+// so tasks posted from inside a task stay on the local deque.
+thread_local const WorkStealingExecutor* tls_executor = nullptr;
+thread_local size_t tls_worker_index = 0;
+
+void pin_current_thread(size_t index) {
+#ifdef __linux__
+    unsigned ncpu = std::thread::hardware_concurrency();
+    if (ncpu == 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(index % ncpu), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)index;
+#endif
+}
+
+} // anonymous namespace
+
+WorkStealingExecutor::WorkStealingExecutor() : WorkStealingExecutor(Options{}) {}
+
+WorkStealingExecutor::WorkStealingExecutor(Options opts) : opts_(opts) {
+    size_t n = opts_.num_threads;
+    if (n == 0) n = std::max(1u, std::thread::hardware_concurrency());
+
+    workers_.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    threads_.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    shutdown();
+}
+
+void WorkStealingExecutor::post(Task task) {
+    if (stopped_.load(std::memory_order_acquire)) {
+        task();
+        return;
+    }
+
+    size_t index = (tls_executor == this)
+        ? tls_worker_index
+        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    queued_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+
+    // Only touch the sleep lock when someone may be waiting on it.
+    if (sleepers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_one();
+    }
+}
+
+bool WorkStealingExecutor::try_pop(size_t index, Task& out) {
+    auto& w = *workers_[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) return false;
+    out = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingExecutor::try_steal(size_t index, Task& out) {
+    const size_t n = workers_.size();
+    for (size_t k = 1; k < n; ++k) {
+        auto& victim = *workers_[(index + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        out = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingExecutor::run(size_t index) {
+    tls_executor = this;
+    tls_worker_index = index;
+    if (opts_.pin_threads) pin_current_thread(index);
+
+    while (true) {
+        Task task;
+        if (try_pop(index, task) || try_steal(index, task)) {
+            queued_.fetch_sub(1);
+            try {
+                task();
+            } catch (...) {
+                // A throwing task must not take the worker down with it
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        if (stopping_ && queued_.load() == 0) return;
+        sleepers_.fetch_add(1);
+        sleep_cv_.wait(lock, [this] { return queued_.load() > 0 || stopping_.load(); });
+        sleepers_.fetch_sub(1);
+    }
+}
+
+void WorkStealingExecutor::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        if (stopping_.exchange(true)) return;
+        sleep_cv_.notify_all();
+    }
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+    stopped_.store(true, std::memory_order_release);
+
+    // Tasks posted concurrently with shutdown may have raced past the
+    // workers' final check; run them here so nothing is silently dropped.
+    for (auto& w : workers_) {
+        std::deque<Task> rest;
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            rest.swap(w->tasks);
+        }
+        for (auto& task : rest) {
+            try { task(); } catch (...) {}
+        }
+    }
+}
+
+} // namespace mcp
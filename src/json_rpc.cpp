@@ -1,8 +1,52 @@
 #include "mcp/json_rpc.hpp"
+#include "mcp/codec.hpp"
 #include "mcp/version.hpp"
+#include <utility>
 
 namespace mcp {
 
+// ---------- LazyJson ----------
+
+LazyJson LazyJson::from_raw(std::string raw) {
+    LazyJson j;
+    j.raw_ = std::move(raw);
+    return j;
+}
+
+LazyJson LazyJson::from_raw(std::shared_ptr<const std::string> raw) {
+    LazyJson j;
+    j.shared_raw_ = std::move(raw);
+    return j;
+}
+
+const nlohmann::json& LazyJson::value() const {
+    if (!value_) {
+        auto* text = raw_text();
+        if (!text) throw std::bad_optional_access();
+        value_ = Codec::parse_value(*text);
+    }
+    return *value_;
+}
+
+nlohmann::json& LazyJson::value() {
+    std::as_const(*this).value();
+    raw_.reset();
+    shared_raw_.reset();
+    return *value_;
+}
+
+nlohmann::json LazyJson::value_or(nlohmann::json fallback) const {
+    if (!has_value()) return fallback;
+    return value();
+}
+
+bool LazyJson::operator==(const LazyJson& o) const {
+    if (has_value() != o.has_value()) return false;
+    if (!has_value()) return true;
+    if (is_raw() && o.is_raw() && *raw_text() == *o.raw_text()) return true;
+    return value() == o.value();
+}
+
 void to_json(nlohmann::json& j, const JsonRpcRequest& r) {
     nlohmann::json id_j;
     to_json(id_j, r.id);
@@ -17,6 +61,7 @@ void to_json(nlohmann::json& j, const JsonRpcRequest& r) {
 void from_json(const nlohmann::json& j, JsonRpcRequest& r) {
     from_json(j.at("id"), r.id);
     r.method = j.at("method").get<std::string>();
+    r.method_id = intern_method(r.method);
     if (j.contains("params")) r.params = j.at("params");
     if (j.contains("_meta")) r.meta = j.at("_meta");
 }
@@ -27,7 +72,13 @@ void to_json(nlohmann::json& j, const JsonRpcResponse& r) {
     j = nlohmann::json::object();
     j["jsonrpc"] = std::string(JSONRPC_VERSION);
     j["id"] = id_j;
-    if (r.result) j["result"] = *r.result;
+    if (r.result_stream) {
+        std::string text;
+        while (r.result_stream(text)) {}
+        j["result"] = nlohmann::json::parse(text);
+    } else if (r.result) {
+        j["result"] = *r.result;
+    }
     if (r.error) j["error"] = *r.error;
 }
 
@@ -46,6 +97,7 @@ void to_json(nlohmann::json& j, const JsonRpcNotification& n) {
 
 void from_json(const nlohmann::json& j, JsonRpcNotification& n) {
     n.method = j.at("method").get<std::string>();
+    n.method_id = intern_method(n.method);
     if (j.contains("params")) n.params = j.at("params");
 }
 
@@ -0,0 +1,101 @@
+#include "mcp/json_writer.hpp"
+#include <charconv>
+#include <cmath>
+
+namespace mcp {
+
+void JsonWriter::escape(std::string& out, std::string_view s) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    // Copy runs of plain characters in one append; escape the rest
+    size_t run = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        auto c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(esc, sizeof(esc));
+            }
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+}
+
+void JsonWriter::write_string(std::string_view s) {
+    out_ += '"';
+    escape(out_, s);
+    out_ += '"';
+}
+
+JsonWriter& JsonWriter::write_int(int64_t i) {
+    prefix();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), i);
+    out_.append(buf, static_cast<size_t>(res.ptr - buf));
+    comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::write_uint(uint64_t u) {
+    prefix();
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), u);
+    out_.append(buf, static_cast<size_t>(res.ptr - buf));
+    comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double d) {
+    // JSON has no NaN/Infinity; emit null like nlohmann::json does
+    if (!std::isfinite(d)) return null();
+    prefix();
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), d);
+    std::string_view text(buf, static_cast<size_t>(res.ptr - buf));
+    out_ += text;
+    // Keep integral doubles distinguishable from integers on re-parse
+    if (text.find_first_of(".eE") == std::string_view::npos) out_ += ".0";
+    comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const nlohmann::json& j) {
+    using value_t = nlohmann::json::value_t;
+    switch (j.type()) {
+        case value_t::object:
+            begin_object();
+            for (auto it = j.begin(); it != j.end(); ++it) {
+                key(it.key());
+                value(it.value());
+            }
+            return end_object();
+        case value_t::array:
+            begin_array();
+            for (const auto& elem : j) value(elem);
+            return end_array();
+        case value_t::string:
+            return value(std::string_view(j.get_ref<const std::string&>()));
+        case value_t::number_integer:
+            return write_int(j.get<int64_t>());
+        case value_t::number_unsigned:
+            return write_uint(j.get<uint64_t>());
+        case value_t::number_float:
+            return value(j.get<double>());
+        case value_t::boolean:
+            return value(j.get<bool>());
+        default:
+            return null();
+    }
+}
+
+} // namespace mcp
@@ -0,0 +1,382 @@
+#include "mcp/metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace mcp {
+
+// ---------- LatencyHistogram ----------
+
+void LatencyHistogram::add(size_t bucket, uint64_t n, uint64_t sum_ns) noexcept {
+    counts_[bucket] += n;
+    count_ += n;
+    sum_ns_ += sum_ns;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (size_t i = 0; i < kBuckets; ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ns_ += other.sum_ns_;
+}
+
+uint64_t LatencyHistogram::count_below(uint64_t ns) const noexcept {
+    uint64_t below = 0;
+    for (size_t i = 0; i < kBuckets && bucket_limit(i) <= ns; ++i) below += counts_[i];
+    return below;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const noexcept {
+    if (count_ == 0) return 0;
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count_)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank) return bucket_limit(i) - 1;
+    }
+    return bucket_limit(kBuckets - 1) - 1;
+}
+
+// ---------- MetricsSnapshot ----------
+
+const MethodStats* MetricsSnapshot::find(std::string_view method) const {
+    for (const auto& m : methods) {
+        if (m.method == method) return &m;
+    }
+    return nullptr;
+}
+
+namespace {
+
+void append_sample(std::string& out, std::string_view name, std::string_view labels, double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    out.append(name);
+    if (!labels.empty()) out.append("{").append(labels).append("}");
+    out.append(" ").append(buf).append("\n");
+}
+
+void append_type(std::string& out, std::string_view name, std::string_view type) {
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+std::string method_label(const std::string& method) {
+    return "method=\"" + method + "\"";
+}
+
+} // anonymous namespace
+
+std::string MetricsSnapshot::to_prometheus() const {
+    std::string out;
+
+    append_type(out, "mcpxx_dispatch_total", "counter");
+    for (const auto& m : methods) {
+        append_sample(out, "mcpxx_dispatch_total", method_label(m.method), static_cast<double>(m.calls));
+    }
+    append_type(out, "mcpxx_dispatch_errors_total", "counter");
+    for (const auto& m : methods) {
+        append_sample(out, "mcpxx_dispatch_errors_total", method_label(m.method), static_cast<double>(m.errors));
+    }
+
+    // Powers of four from ~1 us to ~69 s: exact against the fine buckets
+    append_type(out, "mcpxx_dispatch_duration_seconds", "histogram");
+    for (const auto& m : methods) {
+        std::string label = method_label(m.method);
+        for (unsigned bits = 10; bits <= LatencyHistogram::kMaxBits; bits += 2) {
+            uint64_t limit = uint64_t{1} << bits;
+            char le[48];
+            std::snprintf(le, sizeof(le), ",le=\"%.9g\"", static_cast<double>(limit) / 1e9);
+            append_sample(out, "mcpxx_dispatch_duration_seconds_bucket", label + le,
+                          static_cast<double>(m.latency.count_below(limit)));
+        }
+        append_sample(out, "mcpxx_dispatch_duration_seconds_bucket", label + ",le=\"+Inf\"",
+                      static_cast<double>(m.latency.count()));
+        append_sample(out, "mcpxx_dispatch_duration_seconds_sum", label,
+                      static_cast<double>(m.latency.sum_ns()) / 1e9);
+        append_sample(out, "mcpxx_dispatch_duration_seconds_count", label,
+                      static_cast<double>(m.latency.count()));
+    }
+
+    const std::pair<const char*, uint64_t> counters[] = {
+        {"mcpxx_messages_parsed_total", messages_parsed},
+        {"mcpxx_bytes_parsed_total", bytes_parsed},
+        {"mcpxx_parse_errors_total", parse_errors},
+        {"mcpxx_messages_serialized_total", messages_serialized},
+        {"mcpxx_bytes_serialized_total", bytes_serialized},
+    };
+    for (const auto& [name, value] : counters) {
+        append_type(out, name, "counter");
+        append_sample(out, name, "", static_cast<double>(value));
+    }
+
+    for (const auto& [name, value] : gauges) {
+        append_type(out, name, "gauge");
+        append_sample(out, name, "", static_cast<double>(value));
+    }
+    return out;
+}
+
+// ---------- Counters ----------
+
+namespace {
+
+// Written only by the owning thread, so a relaxed load and store is enough
+// and cheaper than a locked add; snapshots read a value at most one
+// update stale.
+struct Counter {
+    std::atomic<uint64_t> value{0};
+
+    void add(uint64_t n) noexcept {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    [[nodiscard]] uint64_t get() const noexcept { return value.load(std::memory_order_relaxed); }
+};
+
+struct MethodCounters {
+    Counter calls;
+    Counter errors;
+    Counter latency_sum_ns;
+    std::array<Counter, LatencyHistogram::kBuckets> latency;
+};
+
+struct Shard {
+    std::array<MethodCounters, kMethodCount> methods;
+    Counter messages_parsed;
+    Counter bytes_parsed;
+    Counter parse_errors;
+    Counter messages_serialized;
+    Counter bytes_serialized;
+
+    void add_to(MetricsSnapshot& s, std::array<LatencyHistogram, kMethodCount>& latency,
+                std::array<uint64_t, kMethodCount>& calls, std::array<uint64_t, kMethodCount>& errors) const {
+        for (size_t m = 0; m < kMethodCount; ++m) {
+            const auto& c = methods[m];
+            if (c.calls.get() == 0) continue;
+            calls[m] += c.calls.get();
+            errors[m] += c.errors.get();
+            for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b) {
+                if (uint64_t n = c.latency[b].get()) latency[m].add(b, n, 0);
+            }
+            latency[m].add(0, 0, c.latency_sum_ns.get());
+        }
+        s.messages_parsed += messages_parsed.get();
+        s.bytes_parsed += bytes_parsed.get();
+        s.parse_errors += parse_errors.get();
+        s.messages_serialized += messages_serialized.get();
+        s.bytes_serialized += bytes_serialized.get();
+    }
+
+    // Folds `other` in; the caller owns this shard's writes.
+    void absorb(const Shard& other) noexcept {
+        for (size_t m = 0; m < kMethodCount; ++m) {
+            auto& c = methods[m];
+            const auto& o = other.methods[m];
+            c.calls.add(o.calls.get());
+            c.errors.add(o.errors.get());
+            c.latency_sum_ns.add(o.latency_sum_ns.get());
+            for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b) c.latency[b].add(o.latency[b].get());
+        }
+        messages_parsed.add(other.messages_parsed.get());
+        bytes_parsed.add(other.bytes_parsed.get());
+        parse_errors.add(other.parse_errors.get());
+        messages_serialized.add(other.messages_serialized.get());
+        bytes_serialized.add(other.bytes_serialized.get());
+    }
+};
+
+struct GaugeEntry {
+    std::string name;
+    std::function<int64_t()> sample;
+};
+
+// Shards and gauges have separate locks: samplers take their owners'
+// locks, and a thread holding one of those may be registering its shard.
+struct Registry {
+    std::mutex shards_mutex;
+    std::vector<Shard*> live;
+    Shard retired;  // counts from threads that have exited
+
+    std::mutex gauges_mutex;
+    std::map<uint64_t, GaugeEntry> gauges;
+    uint64_t next_gauge = 1;
+
+    std::atomic<ISpanHooks*> hooks{nullptr};
+    std::atomic<uint32_t> sample_every{8};
+};
+
+// Never destroyed: threads may record or exit during static destruction
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// The calling thread's shard, registered on first use. A thread's counts
+// move to the retired shard when it exits.
+class LocalShard {
+public:
+    LocalShard() : shard_(std::make_unique<Shard>()) {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.shards_mutex);
+        r.live.push_back(shard_.get());
+    }
+
+    ~LocalShard() {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lock(r.shards_mutex);
+        r.retired.absorb(*shard_);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), shard_.get()));
+    }
+
+    Shard& get() noexcept { return *shard_; }
+
+private:
+    std::unique_ptr<Shard> shard_;
+};
+
+[[maybe_unused]] Shard& local_shard() {
+    thread_local LocalShard shard;
+    return shard.get();
+}
+
+// Start time for a dispatch to be timed, else 0
+[[maybe_unused]] uint64_t sampled_now_ns() noexcept {
+    thread_local uint32_t tick = 0;
+    if (++tick < registry().sample_every.load(std::memory_order_relaxed)) return 0;
+    tick = 0;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return std::max<uint64_t>(static_cast<uint64_t>(ns), 1);
+}
+
+} // anonymous namespace
+
+namespace metrics {
+
+MetricsSnapshot snapshot() {
+    MetricsSnapshot s;
+    std::array<LatencyHistogram, kMethodCount> latency;
+    std::array<uint64_t, kMethodCount> calls{};
+    std::array<uint64_t, kMethodCount> errors{};
+
+    auto& r = registry();
+    std::map<std::string, int64_t> gauges;
+    {
+        std::lock_guard<std::mutex> lock(r.shards_mutex);
+        r.retired.add_to(s, latency, calls, errors);
+        for (const Shard* shard : r.live) shard->add_to(s, latency, calls, errors);
+    }
+    {
+        std::lock_guard<std::mutex> lock(r.gauges_mutex);
+        for (const auto& [id, gauge] : r.gauges) gauges[gauge.name] += gauge.sample();
+    }
+
+    // Standard methods in declaration order, then custom ones
+    for (size_t m = 1; m <= kMethodCount; ++m) {
+        size_t slot = m % kMethodCount;
+        if (calls[slot] == 0) continue;
+        MethodStats stats;
+        stats.method = slot == 0 ? "other" : std::string(detail::kMethodNames[slot]);
+        stats.calls = calls[slot];
+        stats.errors = errors[slot];
+        stats.latency = latency[slot];
+        s.methods.push_back(std::move(stats));
+    }
+    s.gauges.assign(gauges.begin(), gauges.end());
+    return s;
+}
+
+void set_latency_sampling(uint32_t every) noexcept {
+    registry().sample_every.store(std::max<uint32_t>(every, 1), std::memory_order_relaxed);
+}
+
+void set_span_hooks(ISpanHooks* hooks) noexcept {
+    registry().hooks.store(hooks, std::memory_order_release);
+}
+
+Gauge::Gauge(std::string name, std::function<int64_t()> sample) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.gauges_mutex);
+    id_ = r.next_gauge++;
+    r.gauges.emplace(id_, GaugeEntry{std::move(name), std::move(sample)});
+}
+
+// Unregistering takes the lock snapshot() samples under, so a sampler
+// never runs against a destroyed owner.
+Gauge::~Gauge() {
+    if (id_ == 0) return;
+    auto& r = registry();
+    std::lock_guard<std::mutex> lock(r.gauges_mutex);
+    r.gauges.erase(id_);
+}
+
+Gauge::Gauge(Gauge&& other) noexcept : id_(std::exchange(other.id_, 0)) {}
+
+Gauge& Gauge::operator=(Gauge&& other) noexcept {
+    if (this != &other) {
+        Gauge old(std::move(*this));
+        id_ = std::exchange(other.id_, 0);
+    }
+    return *this;
+}
+
+} // namespace metrics
+
+// ---------- Recording ----------
+
+#ifndef MCPXX_NO_METRICS
+
+namespace detail {
+
+DispatchMark begin_dispatch(Method id, std::string_view method, const RequestId* request) noexcept {
+    DispatchMark mark{sampled_now_ns(), id, registry().hooks.load(std::memory_order_acquire), nullptr};
+    if (mark.hooks) {
+        try {
+            mark.span = mark.hooks->start_span(method, request);
+        } catch (...) {
+            mark.hooks = nullptr;
+        }
+    }
+    return mark;
+}
+
+void end_dispatch(const DispatchMark& mark, int error_code) noexcept {
+    auto& c = local_shard().methods[static_cast<size_t>(mark.method)];
+    c.calls.add(1);
+    if (error_code != 0) c.errors.add(1);
+    if (mark.start_ns != 0) {
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        uint64_t elapsed = static_cast<uint64_t>(now) - mark.start_ns;
+        c.latency_sum_ns.add(elapsed);
+        c.latency[LatencyHistogram::bucket_of(elapsed)].add(1);
+    }
+    if (mark.hooks) mark.hooks->end_span(mark.span, error_code);
+}
+
+void count_parsed(size_t bytes, size_t messages) noexcept {
+    auto& s = local_shard();
+    s.messages_parsed.add(messages);
+    s.bytes_parsed.add(bytes);
+}
+
+void count_parse_error() noexcept {
+    local_shard().parse_errors.add(1);
+}
+
+void count_serialized(size_t bytes, size_t messages) noexcept {
+    auto& s = local_shard();
+    s.messages_serialized.add(messages);
+    s.bytes_serialized.add(bytes);
+}
+
+} // namespace detail
+
+#endif // MCPXX_NO_METRICS
+
+} // namespace mcp
@@ -0,0 +1,96 @@
+#include "mcp/resource_cache.hpp"
+#include <iterator>
+
+namespace mcp {
+
+size_t cache_cost(const std::string& text) {
+    return text.size();
+}
+
+size_t cache_cost(const std::vector<ResourceContent>& contents) {
+    auto len = [](const std::optional<std::string>& s) { return s ? s->size() : 0; };
+    size_t cost = 0;
+    for (const auto& c : contents) {
+        cost += c.uri.size() + len(c.mime_type) + len(c.text) + len(c.blob)
+                + (c.blob_bytes ? c.blob_bytes->size() : 0);
+    }
+    return cost;
+}
+
+template<typename T>
+std::shared_ptr<const T> BasicResourceCache<T>::get(const std::string& uri,
+                                                    Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(uri);
+    if (it == index_.end()) return nullptr;
+    if (it->second->expires <= now) {
+        erase(it->second);
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->value;
+}
+
+template<typename T>
+uint64_t BasicResourceCache<T>::stamp() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return epoch_;
+}
+
+template<typename T>
+void BasicResourceCache<T>::put(const std::string& uri, std::shared_ptr<const T> value,
+                                uint64_t stamp, Clock::time_point now) {
+    if (!enabled()) return;
+    size_t cost = uri.size() + cache_cost(*value);
+    if (cost > opts_.max_bytes) return;
+    Entry entry{uri, std::move(value), cost, Clock::time_point::max()};
+    if (opts_.ttl.count() > 0) entry.expires = now + opts_.ttl;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stamp != epoch_) return;
+    if (auto it = index_.find(uri); it != index_.end()) erase(it->second);
+    while (bytes_ + cost > opts_.max_bytes) erase(std::prev(lru_.end()));
+    lru_.push_front(std::move(entry));
+    index_.emplace(uri, lru_.begin());
+    bytes_ += cost;
+}
+
+template<typename T>
+void BasicResourceCache<T>::invalidate(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++epoch_;
+    if (auto it = index_.find(uri); it != index_.end()) erase(it->second);
+}
+
+template<typename T>
+void BasicResourceCache<T>::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++epoch_;
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+template<typename T>
+void BasicResourceCache<T>::erase(typename List::iterator it) {
+    bytes_ -= it->cost;
+    index_.erase(it->uri);
+    lru_.erase(it);
+}
+
+template<typename T>
+size_t BasicResourceCache<T>::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+template<typename T>
+size_t BasicResourceCache<T>::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+template class BasicResourceCache<std::string>;
+template class BasicResourceCache<std::vector<ResourceContent>>;
+
+} // namespace mcp
@@ -1,141 +1,446 @@
 #include "mcp/router.hpp"
 #include "mcp/error.hpp"
+#include "mcp/metrics.hpp"
 #include "mcp/version.hpp"
+#include <atomic>
+#include <condition_variable>
 #include <stdexcept>
+#include <type_traits>
 
 namespace mcp {
 
+// ---------- Responder ----------
+
+struct Responder::State {
+    Callback cb;
+    std::atomic<bool> done{false};
+
+    explicit State(Callback c) : cb(std::move(c)) {}
+
+    void complete(HandlerResult result) {
+        if (done.exchange(true)) return;
+        cb(std::move(result));
+    }
+
+    ~State() {
+        if (!done.load()) {
+            try {
+                complete(JsonRpcError{error::InternalError,
+                                      "Handler finished without responding", std::nullopt});
+            } catch (...) {}
+        }
+    }
+};
+
+Responder::Responder(Callback cb) : state_(std::make_shared<State>(std::move(cb))) {}
+
+void Responder::operator()(HandlerResult result) const {
+    state_->complete(std::move(result));
+}
+
+bool Responder::done() const noexcept {
+    return state_->done.load();
+}
+
+namespace {
+
+// Session of the dispatch running on this thread (Router::current_session)
+thread_local Session* tls_session = nullptr;
+
+// Sets the current session for a dispatch, restoring the outer one after
+class SessionScope {
+public:
+    explicit SessionScope(Session* session) : saved_(tls_session) { tls_session = session; }
+    ~SessionScope() { tls_session = saved_; }
+    SessionScope(const SessionScope&) = delete;
+    SessionScope& operator=(const SessionScope&) = delete;
+
+private:
+    Session* saved_;
+};
+
+JsonRpcResponse make_response(const RequestId& id, HandlerResult result) {
+    JsonRpcResponse resp;
+    resp.id = id;
+    if (auto* ok = std::get_if<nlohmann::json>(&result)) {
+        resp.result = std::move(*ok);
+    } else if (auto* err = std::get_if<JsonRpcError>(&result)) {
+        resp.error = std::move(*err);
+    } else if (auto* raw = std::get_if<RawJson>(&result)) {
+        resp.result = LazyJson::from_raw(std::move(raw->text));
+    } else if (auto* shared = std::get_if<SharedJson>(&result)) {
+        resp.result = LazyJson::from_raw(std::move(shared->text));
+    } else if (auto* streamed = std::get_if<StreamedJson>(&result)) {
+        resp.result_stream = std::move(streamed->next);
+    }
+    return resp;
+}
+
+JsonRpcResponse make_error(const RequestId& id, int code, std::string message) {
+    JsonRpcResponse resp;
+    resp.id = id;
+    resp.error = JsonRpcError{code, std::move(message), std::nullopt};
+    return resp;
+}
+
+int error_code(const JsonRpcResponse& resp) {
+    return resp.error ? resp.error->code : 0;
+}
+
+// Closes the dispatch's metrics span with the response it produced.
+JsonRpcResponse finished(const detail::DispatchMark& mark, JsonRpcResponse resp) {
+    detail::end_dispatch(mark, error_code(resp));
+    return resp;
+}
+
+// Handlers read params by reference; absent params read as an empty object.
+const nlohmann::json& params_or_empty(const LazyJson& params) {
+    static const nlohmann::json kEmpty = nlohmann::json::object();
+    return params ? *params : kEmpty;
+}
+
+// Params for handlers that own them: moved out of an rvalue request, copied
+// from a const one.
+nlohmann::json owned_params(LazyJson&& params) {
+    if (!params) return nlohmann::json::object();
+    return std::move(*params);
+}
+
+nlohmann::json owned_params(const LazyJson& params) {
+    return nlohmann::json(params_or_empty(params));
+}
+
+// A member of `Message`'s payload with the message's value category, so it
+// is moved from only when the whole message was passed as an rvalue.
+template<typename Message, typename T>
+decltype(auto) forward_member(T& member) {
+    if constexpr (std::is_lvalue_reference_v<Message>) return static_cast<const T&>(member);
+    else return static_cast<T&&>(member);
+}
+
+// Wire text of params for passthrough handlers. Only messages built in
+// process (no raw text) pay for a dump into `scratch`.
+std::string_view raw_params(const LazyJson& params, std::string& scratch) {
+    if (!params) return "{}";
+    if (auto raw = params.raw()) return *raw;
+    scratch = params->dump();
+    return scratch;
+}
+
+// Interned id of a message's method, whether or not the codec set it.
+template<typename Message>
+Method method_of(const Message& msg) {
+    return msg.method_id != Method::Unknown ? msg.method_id : intern_method(msg.method);
+}
+
+// Capabilities as bits, so gating is a mask test
+enum CapabilityBit : uint32_t {
+    kCapTools       = 1u << 0,
+    kCapResources   = 1u << 1,
+    kCapPrompts     = 1u << 2,
+    kCapLogging     = 1u << 3,
+    kCapCompletions = 1u << 4,
+    kCapSampling    = 1u << 5,
+    kCapRoots       = 1u << 6,
+    kCapElicitation = 1u << 7,
+    kCapUnknown     = 1u << 31,  // never granted
+};
+
+uint32_t capability_bit(std::string_view cap) {
+    if (cap == "tools") return kCapTools;
+    if (cap == "resources") return kCapResources;
+    if (cap == "prompts") return kCapPrompts;
+    if (cap == "logging") return kCapLogging;
+    if (cap == "completions") return kCapCompletions;
+    if (cap == "sampling") return kCapSampling;
+    if (cap == "roots") return kCapRoots;
+    if (cap == "elicitation") return kCapElicitation;
+    return kCapUnknown;
+}
+
+} // anonymous namespace
+
+// ---------- Router ----------
+
+Router::RequestEntry& Router::Tables::request_slot(const std::string& method) {
+    Method id = intern_method(method);
+    if (id != Method::Unknown) return standard_requests[static_cast<size_t>(id)];
+    return request_handlers[method];
+}
+
+void Router::set_request(const std::string& method, RequestEntry entry) {
+    tables_.update([&](Tables& t) { t.request_slot(method) = std::move(entry); });
+}
+
 void Router::on_request(const std::string& method, RequestHandler handler) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    request_handlers_[method] = std::move(handler);
+    RequestEntry entry;
+    entry.sync = std::move(handler);
+    set_request(method, std::move(entry));
+}
+
+void Router::on_request_async(const std::string& method, AsyncRequestHandler handler) {
+    RequestEntry entry;
+    entry.async = std::move(handler);
+    set_request(method, std::move(entry));
+}
+
+void Router::on_request_raw(const std::string& method, RawRequestHandler handler) {
+    RequestEntry entry;
+    entry.raw = std::move(handler);
+    set_request(method, std::move(entry));
+}
+
+void Router::on_request_raw(const std::string& method, RawAsyncRequestHandler handler) {
+    RequestEntry entry;
+    entry.raw_async = std::move(handler);
+    set_request(method, std::move(entry));
+}
+
+void Router::on_request_co(const std::string& method, CoRequestHandler handler) {
+    RequestEntry entry;
+    entry.co = std::make_shared<const CoRequestHandler>(std::move(handler));
+    set_request(method, std::move(entry));
 }
 
 void Router::on_notification(const std::string& method, NotificationHandler handler) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    notification_handlers_[method] = std::move(handler);
+    Method id = intern_method(method);
+    tables_.update([&](Tables& t) {
+        if (id != Method::Unknown) t.standard_notifications[static_cast<size_t>(id)] = std::move(handler);
+        else t.notification_handlers[method] = std::move(handler);
+    });
 }
 
 void Router::require_capability(const std::string& method, const std::string& capability) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    capability_requirements_[method] = capability;
+    Method id = intern_method(method);
+    uint32_t bit = capability_bit(capability);
+    tables_.update([&](Tables& t) {
+        if (id != Method::Unknown) t.standard_requirements[static_cast<size_t>(id)] = bit;
+        else t.capability_requirements[method] = bit;
+    });
 }
 
 void Router::set_capabilities(const ServerCapabilities& server_caps,
                               const ClientCapabilities& client_caps) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    server_caps_ = server_caps;
-    client_caps_ = client_caps;
+    uint32_t granted = 0;
+    if (server_caps.tools) granted |= kCapTools;
+    if (server_caps.resources) granted |= kCapResources;
+    if (server_caps.prompts) granted |= kCapPrompts;
+    if (server_caps.logging) granted |= kCapLogging;
+    if (server_caps.completions) granted |= kCapCompletions;
+    if (client_caps.sampling) granted |= kCapSampling;
+    if (client_caps.roots) granted |= kCapRoots;
+    if (client_caps.elicitation) granted |= kCapElicitation;
+    granted_capabilities_.store(granted, std::memory_order_release);
 }
 
 bool Router::has_handler(const std::string& method) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return request_handlers_.count(method) > 0 || notification_handlers_.count(method) > 0;
+    auto tables = tables_.load();
+    Method id = intern_method(method);
+    if (id != Method::Unknown) {
+        return !tables->standard_requests[static_cast<size_t>(id)].empty()
+            || tables->standard_notifications[static_cast<size_t>(id)];
+    }
+    return tables->request_handlers.count(method) > 0
+        || tables->notification_handlers.count(method) > 0;
 }
 
-bool Router::check_capability(const std::string& method) const {
-    auto req_it = capability_requirements_.find(method);
-    if (req_it == capability_requirements_.end()) return true;
+bool Router::check_capability(const Tables& tables, Method id, const std::string& method) const {
+    uint32_t required;
+    if (id != Method::Unknown) {
+        required = tables.standard_requirements[static_cast<size_t>(id)];
+    } else {
+        auto it = tables.capability_requirements.find(method);
+        if (it == tables.capability_requirements.end()) return true;
+        required = it->second;
+    }
+    return (granted_capabilities_.load(std::memory_order_acquire) & required) == required;
+}
 
-    const std::string& cap = req_it->second;
+std::optional<JsonRpcResponse> Router::resolve(const Tables& tables, const JsonRpcRequest& req,
+                                               const RequestEntry*& out) const {
+    Method id = method_of(req);
+    if (!check_capability(tables, id, req.method)) {
+        return finished(detail::begin_dispatch(id, req.method, &req.id),
+                        make_error(req.id, error::InvalidRequest,
+                                   "Capability not supported: " + req.method));
+    }
 
-    // Check server capabilities
-    if (cap == "tools" && server_caps_.tools) return true;
-    if (cap == "resources" && server_caps_.resources) return true;
-    if (cap == "prompts" && server_caps_.prompts) return true;
-    if (cap == "logging" && server_caps_.logging) return true;
-    if (cap == "completions" && server_caps_.completions) return true;
-    // Check client capabilities
-    if (cap == "sampling" && client_caps_.sampling) return true;
-    if (cap == "roots" && client_caps_.roots) return true;
-    if (cap == "elicitation" && client_caps_.elicitation) return true;
+    const RequestEntry* entry = nullptr;
+    if (id != Method::Unknown) {
+        entry = &tables.standard_requests[static_cast<size_t>(id)];
+    } else if (auto it = tables.request_handlers.find(req.method);
+               it != tables.request_handlers.end()) {
+        entry = &it->second;
+    }
+    if (!entry || entry->empty()) {
+        return finished(detail::begin_dispatch(id, req.method, &req.id),
+                        make_error(req.id, error::MethodNotFound, "Method not found: " + req.method));
+    }
+    out = entry;
+    return std::nullopt;
+}
 
-    return false;
+// Handlers run against a snapshot, so they may register handlers or call
+// set_capabilities without deadlocking; changes apply to later dispatches.
+JsonRpcResponse Router::invoke(const RequestHandler& handler, const RequestId& id,
+                               const nlohmann::json& params) {
+    try {
+        return make_response(id, handler(params));
+    } catch (const McpProtocolError& e) {
+        return make_error(id, e.code, e.what());
+    } catch (const std::exception& e) {
+        return make_error(id, error::InternalError, e.what());
+    }
 }
 
-std::optional<JsonRpcMessage> Router::dispatch(const JsonRpcMessage& msg,
-                                                const Session* /*session*/) {
-    if (const auto* req = std::get_if<JsonRpcRequest>(&msg)) {
-        // Hold lock only to look up handler and check capability
-        RequestHandler handler;
-        RequestId req_id = req->id;
-        std::string method = req->method;
-        nlohmann::json params = req->params ? *req->params : nlohmann::json::object();
-
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!check_capability(method)) {
-                JsonRpcResponse resp;
-                resp.id = req_id;
-                resp.error = JsonRpcError{
-                    error::InvalidRequest,
-                    "Capability not supported: " + method,
-                    std::nullopt
-                };
-                return resp;
-            }
-
-            auto it = request_handlers_.find(method);
-            if (it == request_handlers_.end()) {
-                JsonRpcResponse resp;
-                resp.id = req_id;
-                resp.error = JsonRpcError{
-                    error::MethodNotFound,
-                    "Method not found: " + method,
-                    std::nullopt
-                };
-                return resp;
-            }
-            handler = it->second;
-        }
-        // Call handler WITHOUT holding the lock to prevent deadlock
-        // when handlers call back into router methods (e.g. set_capabilities)
+template<typename Request>
+void Router::invoke(const RequestEntry& entry, Request&& req, ReplyCallback reply) {
+    auto mark = detail::begin_dispatch(method_of(req), req.method, &req.id);
+    if (entry.sync) {
+        reply(finished(mark, invoke(entry.sync, req.id, params_or_empty(req.params))));
+        return;
+    }
+    if (entry.raw) {
+        JsonRpcResponse resp;
         try {
-            auto result = handler(params);
-
-            JsonRpcResponse resp;
-            resp.id = req_id;
-            if (auto* ok = std::get_if<nlohmann::json>(&result)) {
-                resp.result = *ok;
-            } else if (auto* err = std::get_if<JsonRpcError>(&result)) {
-                resp.error = *err;
-            }
-            return resp;
+            std::string scratch;
+            resp = make_response(req.id, entry.raw(raw_params(req.params, scratch)));
         } catch (const McpProtocolError& e) {
-            JsonRpcResponse resp;
-            resp.id = req_id;
-            resp.error = JsonRpcError{e.code, e.what(), std::nullopt};
-            return resp;
+            resp = make_error(req.id, e.code, e.what());
         } catch (const std::exception& e) {
-            JsonRpcResponse resp;
-            resp.id = req_id;
-            resp.error = JsonRpcError{error::InternalError, e.what(), std::nullopt};
-            return resp;
+            resp = make_error(req.id, error::InternalError, e.what());
+        }
+        reply(finished(mark, std::move(resp)));
+        return;
+    }
+
+    Responder respond([id = req.id, reply = std::move(reply), mark](HandlerResult result) {
+        reply(finished(mark, make_response(id, std::move(result))));
+    });
+    try {
+        if (entry.async) {
+            entry.async(params_or_empty(req.params), respond);
+        } else if (entry.raw_async) {
+            entry.raw_async(std::forward<Request>(req).params, respond);
+        } else {
+            // The handler object is kept alive until the coroutine completes,
+            // since a lambda coroutine's captures live in the closure, not the frame.
+            auto co = entry.co;
+            spawn((*co)(owned_params(std::forward<Request>(req).params)),
+                  [co, respond](HandlerResult result) { respond(std::move(result)); },
+                  [co, respond](std::exception_ptr e) {
+                      try {
+                          std::rethrow_exception(e);
+                      } catch (const McpProtocolError& ex) {
+                          respond(JsonRpcError{ex.code, ex.what(), std::nullopt});
+                      } catch (const std::exception& ex) {
+                          respond(JsonRpcError{error::InternalError, ex.what(), std::nullopt});
+                      } catch (...) {
+                          respond(JsonRpcError{error::InternalError, "Unknown error", std::nullopt});
+                      }
+                  });
+        }
+    } catch (const McpProtocolError& e) {
+        respond(JsonRpcError{e.code, e.what(), std::nullopt});
+    } catch (const std::exception& e) {
+        respond(JsonRpcError{error::InternalError, e.what(), std::nullopt});
+    }
+}
+
+Session* Router::current_session() noexcept {
+    return tls_session;
+}
+
+template<typename Message>
+std::optional<JsonRpcMessage> Router::dispatch_and_wait(Message&& msg, Session* session) {
+    auto* req = std::get_if<JsonRpcRequest>(&msg);
+    if (!req) {
+        dispatch_with(std::forward<Message>(msg), nullptr, session);
+        return std::nullopt;
+    }
+    SessionScope scope(session);
+
+    // The snapshot keeps the handler alive for the call
+    auto tables = tables_.load();
+    const RequestEntry* entry = nullptr;
+    if (auto err = resolve(*tables, *req, entry)) return std::move(*err);
+    if (entry->sync) {
+        auto mark = detail::begin_dispatch(method_of(*req), req->method, &req->id);
+        return finished(mark, invoke(entry->sync, req->id, params_or_empty(req->params)));
+    }
+
+    // Other handlers complete through a callback, possibly later; wait for it.
+    // The callback captures one pointer so it fits std::function's inline
+    // storage instead of costing a heap allocation per call.
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::optional<JsonRpcMessage> response;
+    } done;
+
+    invoke(*entry, forward_member<Message>(*req), [w = &done](JsonRpcMessage resp) {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        w->response = std::move(resp);
+        w->cv.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lock(done.mutex);
+    done.cv.wait(lock, [&] { return done.response.has_value(); });
+    return std::move(done.response);
+}
+
+template<typename Message>
+void Router::dispatch_with(Message&& msg, ReplyCallback reply, Session* session) {
+    SessionScope scope(session);
+    if (auto* req = std::get_if<JsonRpcRequest>(&msg)) {
+        auto tables = tables_.load();
+        const RequestEntry* entry = nullptr;
+        if (auto err = resolve(*tables, *req, entry)) {
+            reply(std::move(*err));
+            return;
         }
+
+        invoke(*entry, forward_member<Message>(*req), std::move(reply));
     } else if (const auto* notif = std::get_if<JsonRpcNotification>(&msg)) {
-        // Hold lock only to look up handler
-        NotificationHandler handler;
-        nlohmann::json params = notif->params ? *notif->params : nlohmann::json::object();
-
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            auto it = notification_handlers_.find(notif->method);
-            if (it == notification_handlers_.end()) return std::nullopt;
-            handler = it->second;
+        auto tables = tables_.load();
+        Method id = method_of(*notif);
+        const NotificationHandler* handler = nullptr;
+        if (id != Method::Unknown) {
+            handler = &tables->standard_notifications[static_cast<size_t>(id)];
+        } else if (auto it = tables->notification_handlers.find(notif->method);
+                   it != tables->notification_handlers.end()) {
+            handler = &it->second;
         }
-        // Call handler WITHOUT holding the lock
+        if (!handler || !*handler) return;
+        auto mark = detail::begin_dispatch(id, notif->method, nullptr);
+        int code = 0;
         try {
-            handler(params);
+            (*handler)(params_or_empty(notif->params));
         } catch (...) {
             // Notifications don't return responses
+            code = error::InternalError;
         }
-        return std::nullopt;
-    } else if (const auto* resp = std::get_if<JsonRpcResponse>(&msg)) {
-        // Responses are not dispatched through the router (handled by session)
-        (void)resp;
-        return std::nullopt;
+        detail::end_dispatch(mark, code);
     }
+    // Responses are not dispatched through the router (handled by session)
+}
 
-    return std::nullopt;
+std::optional<JsonRpcMessage> Router::dispatch(const JsonRpcMessage& msg,
+                                                Session* session) {
+    return dispatch_and_wait(msg, session);
+}
+
+std::optional<JsonRpcMessage> Router::dispatch(JsonRpcMessage&& msg, Session* session) {
+    return dispatch_and_wait(std::move(msg), session);
+}
+
+void Router::dispatch(const JsonRpcMessage& msg, ReplyCallback reply,
+                      Session* session) {
+    dispatch_with(msg, std::move(reply), session);
+}
+
+void Router::dispatch(JsonRpcMessage&& msg, ReplyCallback reply, Session* session) {
+    dispatch_with(std::move(msg), std::move(reply), session);
 }
 
 } // namespace mcp
@@ -0,0 +1,678 @@
+#include "mcp/schema.hpp"
+#include "mcp/error.hpp"
+#include "mcp/tool_args.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <regex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mcp {
+
+namespace {
+
+// Instance types as bits; "number" is kInteger | kFraction
+enum TypeBits : uint8_t {
+    kNull = 1,
+    kBool = 2,
+    kInteger = 4,
+    kFraction = 8,
+    kString = 16,
+    kArray = 32,
+    kObject = 64,
+    kAnyType = 127,
+};
+
+// Node indices standing for the `true` and `false` schemas
+constexpr int32_t kAccept = -1;
+constexpr int32_t kReject = -2;
+// Marks a bare $ref being resolved, to catch cycles of them
+constexpr int32_t kResolving = -3;
+
+constexpr size_t kUnbounded = std::numeric_limits<size_t>::max();
+
+struct Range {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    [[nodiscard]] bool empty() const noexcept { return begin == end; }
+    [[nodiscard]] uint32_t size() const noexcept { return end - begin; }
+};
+
+// Keywords that don't constrain anything; a $ref beside only these is an alias.
+const std::unordered_set<std::string>& annotation_keywords() {
+    static const std::unordered_set<std::string> kKeywords = {
+        "$ref", "$schema", "$id", "$comment", "$defs", "definitions", "title", "description",
+        "default", "examples", "deprecated", "readOnly", "writeOnly",
+    };
+    return kKeywords;
+}
+
+uint8_t type_bit(const std::string& name) {
+    if (name == "null") return kNull;
+    if (name == "boolean") return kBool;
+    if (name == "integer") return kInteger;
+    if (name == "number") return kInteger | kFraction;
+    if (name == "string") return kString;
+    if (name == "array") return kArray;
+    if (name == "object") return kObject;
+    throw std::invalid_argument("Unknown schema type: " + name);
+}
+
+std::string type_names(uint8_t types) {
+    std::string out;
+    auto add = [&out](const char* name) {
+        if (!out.empty()) out += " or ";
+        out += name;
+    };
+    if (types & kNull) add("null");
+    if (types & kBool) add("boolean");
+    if ((types & kInteger) && (types & kFraction)) add("number");
+    else if (types & kInteger) add("integer");
+    if (types & kString) add("string");
+    if (types & kArray) add("array");
+    if (types & kObject) add("object");
+    return out.empty() ? "nothing" : out;
+}
+
+uint8_t number_bit(double d) {
+    return std::isfinite(d) && std::floor(d) == d ? kInteger : kFraction;
+}
+
+uint8_t type_of(const nlohmann::json& v) {
+    switch (v.type()) {
+        case nlohmann::json::value_t::null: return kNull;
+        case nlohmann::json::value_t::boolean: return kBool;
+        case nlohmann::json::value_t::number_integer:
+        case nlohmann::json::value_t::number_unsigned: return kInteger;
+        case nlohmann::json::value_t::number_float: return number_bit(v.get<double>());
+        case nlohmann::json::value_t::string: return kString;
+        case nlohmann::json::value_t::array: return kArray;
+        case nlohmann::json::value_t::object: return kObject;
+        default: return 0;
+    }
+}
+
+size_t code_points(std::string_view s) {
+    size_t n = 0;
+    for (unsigned char c : s) n += (c & 0xC0) != 0x80;
+    return n;
+}
+
+// JSON pointer escaping of one reference token
+std::string pointer_token(std::string_view key) {
+    std::string out;
+    for (char c : key) {
+        if (c == '~') out += "~0";
+        else if (c == '/') out += "~1";
+        else out += c;
+    }
+    return out;
+}
+
+// First violation found; path tokens are collected innermost first while unwinding
+struct Violation {
+    std::vector<std::string> path;
+    std::string reason;
+
+    [[nodiscard]] std::string message() const {
+        std::string pointer;
+        for (auto it = path.rbegin(); it != path.rend(); ++it) pointer += "/" + *it;
+        return pointer.empty() ? reason : pointer + ": " + reason;
+    }
+};
+
+} // anonymous namespace
+
+struct SchemaValidator::Program {
+    struct Node {
+        uint8_t types = kAnyType;
+        // Has keywords that look at a value more than once, so one-pass
+        // text validation parses the value for this node
+        bool needs_dom = false;
+
+        std::optional<double> minimum, maximum, exclusive_minimum, exclusive_maximum, multiple_of;
+
+        size_t min_length = 0;
+        size_t max_length = kUnbounded;
+        int32_t pattern = -1;  // into patterns
+
+        Range prefix_items;  // into subschemas
+        int32_t items = kAccept;
+        size_t min_items = 0;
+        size_t max_items = kUnbounded;
+        bool unique_items = false;
+
+        Range properties;  // into properties, sorted by key
+        uint32_t required = 0;
+        int32_t additional = kAccept;
+        size_t min_properties = 0;
+        size_t max_properties = kUnbounded;
+
+        int32_t enum_values = -1;  // into values
+        int32_t const_value = -1;  // into values, one element
+
+        Range all_of, any_of, one_of;  // into subschemas
+        std::optional<int32_t> not_of;
+    };
+
+    struct Property {
+        std::string key;
+        int32_t node;
+        bool required;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Property> properties;
+    std::vector<int32_t> subschemas;
+    std::vector<std::regex> patterns;
+    std::vector<std::vector<nlohmann::json>> values;
+    int32_t root = kAccept;
+
+    [[nodiscard]] const Property* find_property(const Node& n, std::string_view key) const {
+        auto first = properties.begin() + n.properties.begin;
+        auto last = properties.begin() + n.properties.end;
+        auto it = std::lower_bound(first, last, key,
+                                   [](const Property& p, std::string_view k) { return p.key < k; });
+        return it != last && it->key == key ? &*it : nullptr;
+    }
+
+    // Reasons shared by both walkers; empty if the scalar conforms
+    [[nodiscard]] std::string number_violation(const Node& n, double d) const;
+    [[nodiscard]] std::string string_violation(const Node& n, std::string_view s) const;
+
+    // DOM walk; with `v` null only the verdict is wanted (anyOf branches).
+    bool check(int32_t node, const nlohmann::json& value, Violation* v) const;
+    // One-pass walk over text; throws Violation.
+    void check_text(int32_t node, JsonValue value) const;
+
+    class Compiler;
+};
+
+class SchemaValidator::Program::Compiler {
+public:
+    Compiler(const nlohmann::json& root, Program& program) : root_(root), p_(program) {}
+
+    int32_t compile(const nlohmann::json& s) {
+        if (s.is_boolean()) return s.get<bool>() ? kAccept : kReject;
+        if (!s.is_object()) throw std::invalid_argument("Schema must be an object or a boolean");
+        if (auto it = memo_.find(&s); it != memo_.end()) {
+            if (it->second == kResolving) throw std::invalid_argument("Circular $ref");
+            return it->second;
+        }
+
+        if (s.contains("$ref") && is_alias(s)) {
+            memo_[&s] = kResolving;
+            int32_t target = compile(resolve(s.at("$ref")));
+            memo_[&s] = target;
+            return target;
+        }
+
+        // Reserve the slot first so $refs back to this schema resolve to it
+        auto index = static_cast<int32_t>(p_.nodes.size());
+        p_.nodes.emplace_back();
+        memo_[&s] = index;
+        Node n;
+        compile_type(s, n);
+        compile_number(s, n);
+        compile_string(s, n);
+        compile_array(s, n);
+        compile_object(s, n);
+        compile_combinators(s, n);
+        p_.nodes[static_cast<size_t>(index)] = std::move(n);
+        return index;
+    }
+
+private:
+    static bool is_alias(const nlohmann::json& s) {
+        const auto& annotations = annotation_keywords();
+        for (auto it = s.begin(); it != s.end(); ++it) {
+            if (!annotations.count(it.key())) return false;
+        }
+        return true;
+    }
+
+    const nlohmann::json& resolve(const nlohmann::json& ref) {
+        if (!ref.is_string()) throw std::invalid_argument("$ref must be a string");
+        const auto& text = ref.get_ref<const std::string&>();
+        if (text.empty() || text[0] != '#') {
+            throw std::invalid_argument("Only same-document $ref is supported: " + text);
+        }
+        if (text.size() == 1) return root_;
+        try {
+            return root_.at(nlohmann::json::json_pointer(text.substr(1)));
+        } catch (const nlohmann::json::exception&) {
+            throw std::invalid_argument("Unresolvable $ref: " + text);
+        }
+    }
+
+    static size_t count(const nlohmann::json& s, const char* key, size_t fallback) {
+        auto it = s.find(key);
+        if (it == s.end()) return fallback;
+        if (!it->is_number_unsigned() && !(it->is_number_integer() && it->get<int64_t>() >= 0)) {
+            throw std::invalid_argument(std::string(key) + " must be a non-negative integer");
+        }
+        return it->get<size_t>();
+    }
+
+    static std::optional<double> number(const nlohmann::json& s, const char* key) {
+        auto it = s.find(key);
+        if (it == s.end() || it->is_boolean()) return std::nullopt;
+        if (!it->is_number()) throw std::invalid_argument(std::string(key) + " must be a number");
+        return it->get<double>();
+    }
+
+    void compile_type(const nlohmann::json& s, Node& n) {
+        if (auto it = s.find("type"); it != s.end()) {
+            if (it->is_string()) {
+                n.types = type_bit(it->get<std::string>());
+            } else if (it->is_array()) {
+                n.types = 0;
+                for (const auto& t : *it) n.types |= type_bit(t.get<std::string>());
+            } else {
+                throw std::invalid_argument("type must be a string or an array");
+            }
+        }
+        if (auto it = s.find("enum"); it != s.end()) {
+            if (!it->is_array()) throw std::invalid_argument("enum must be an array");
+            n.enum_values = static_cast<int32_t>(p_.values.size());
+            p_.values.emplace_back(it->begin(), it->end());
+            n.needs_dom = true;
+        }
+        if (auto it = s.find("const"); it != s.end()) {
+            n.const_value = static_cast<int32_t>(p_.values.size());
+            p_.values.emplace_back(1, *it);
+            n.needs_dom = true;
+        }
+    }
+
+    static void compile_number(const nlohmann::json& s, Node& n) {
+        n.minimum = number(s, "minimum");
+        n.maximum = number(s, "maximum");
+        n.exclusive_minimum = number(s, "exclusiveMinimum");
+        n.exclusive_maximum = number(s, "exclusiveMaximum");
+        // Draft 4 spelling: a boolean that makes minimum/maximum exclusive
+        if (s.value("exclusiveMinimum", nlohmann::json()).is_boolean() && s["exclusiveMinimum"].get<bool>()) {
+            n.exclusive_minimum = std::exchange(n.minimum, std::nullopt);
+        }
+        if (s.value("exclusiveMaximum", nlohmann::json()).is_boolean() && s["exclusiveMaximum"].get<bool>()) {
+            n.exclusive_maximum = std::exchange(n.maximum, std::nullopt);
+        }
+        n.multiple_of = number(s, "multipleOf");
+        if (n.multiple_of && *n.multiple_of <= 0) {
+            throw std::invalid_argument("multipleOf must be greater than 0");
+        }
+    }
+
+    void compile_string(const nlohmann::json& s, Node& n) {
+        n.min_length = count(s, "minLength", 0);
+        n.max_length = count(s, "maxLength", kUnbounded);
+        if (auto it = s.find("pattern"); it != s.end()) {
+            if (!it->is_string()) throw std::invalid_argument("pattern must be a string");
+            try {
+                p_.patterns.emplace_back(it->get<std::string>(), std::regex::ECMAScript);
+            } catch (const std::regex_error&) {
+                throw std::invalid_argument("Invalid pattern: " + it->get<std::string>());
+            }
+            n.pattern = static_cast<int32_t>(p_.patterns.size() - 1);
+        }
+    }
+
+    void compile_array(const nlohmann::json& s, Node& n) {
+        // Draft 2020-12 prefixItems + items, or the older array form of items
+        // followed by additionalItems
+        const nlohmann::json* prefix = nullptr;
+        const nlohmann::json* rest = nullptr;
+        if (auto it = s.find("prefixItems"); it != s.end()) prefix = &*it;
+        if (auto it = s.find("items"); it != s.end()) {
+            if (it->is_array()) prefix = &*it;
+            else rest = &*it;
+        }
+        if (prefix && !rest) {
+            if (auto it = s.find("additionalItems"); it != s.end()) rest = &*it;
+        }
+        if (prefix) n.prefix_items = compile_list(*prefix, "prefixItems");
+        if (rest) n.items = compile(*rest);
+        n.min_items = count(s, "minItems", 0);
+        n.max_items = count(s, "maxItems", kUnbounded);
+        n.unique_items = s.value("uniqueItems", false);
+        if (n.unique_items) n.needs_dom = true;
+    }
+
+    void compile_object(const nlohmann::json& s, Node& n) {
+        std::vector<Property> props;
+        if (auto it = s.find("properties"); it != s.end()) {
+            if (!it->is_object()) throw std::invalid_argument("properties must be an object");
+            for (const auto& [key, sub] : it->items()) props.push_back({key, compile(sub), false});
+        }
+        std::sort(props.begin(), props.end(),
+                  [](const auto& a, const auto& b) { return a.key < b.key; });
+        if (auto it = s.find("required"); it != s.end()) {
+            if (!it->is_array()) throw std::invalid_argument("required must be an array");
+            for (const auto& name : *it) {
+                const auto& key = name.get_ref<const std::string&>();
+                auto pos = std::lower_bound(props.begin(), props.end(), key,
+                    [](const auto& p, const std::string& k) { return p.key < k; });
+                if (pos == props.end() || pos->key != key) {
+                    pos = props.insert(pos, {key, kAccept, false});
+                }
+                if (!pos->required) ++n.required;
+                pos->required = true;
+            }
+        }
+        if (auto it = s.find("additionalProperties"); it != s.end()) n.additional = compile(*it);
+        n.min_properties = count(s, "minProperties", 0);
+        n.max_properties = count(s, "maxProperties", kUnbounded);
+
+        n.properties.begin = static_cast<uint32_t>(p_.properties.size());
+        for (auto& p : props) p_.properties.push_back(std::move(p));
+        n.properties.end = static_cast<uint32_t>(p_.properties.size());
+    }
+
+    void compile_combinators(const nlohmann::json& s, Node& n) {
+        std::vector<int32_t> all;
+        if (auto it = s.find("allOf"); it != s.end()) {
+            Range r = compile_list(*it, "allOf");
+            all.assign(p_.subschemas.begin() + r.begin, p_.subschemas.begin() + r.end);
+        }
+        // $ref beside constraining keywords applies alongside them
+        if (auto it = s.find("$ref"); it != s.end()) all.push_back(compile(resolve(*it)));
+        n.all_of = append(all);
+        if (auto it = s.find("anyOf"); it != s.end()) n.any_of = compile_list(*it, "anyOf");
+        if (auto it = s.find("oneOf"); it != s.end()) n.one_of = compile_list(*it, "oneOf");
+        if (auto it = s.find("not"); it != s.end()) n.not_of = compile(*it);
+        if (!n.all_of.empty() || !n.any_of.empty() || !n.one_of.empty() || n.not_of) {
+            n.needs_dom = true;
+        }
+    }
+
+    Range compile_list(const nlohmann::json& list, const char* keyword) {
+        if (!list.is_array() || list.empty()) {
+            throw std::invalid_argument(std::string(keyword) + " must be a non-empty array");
+        }
+        // Children compile first, so their own lists land before this one
+        std::vector<int32_t> nodes;
+        for (const auto& sub : list) nodes.push_back(compile(sub));
+        return append(nodes);
+    }
+
+    Range append(const std::vector<int32_t>& nodes) {
+        Range r;
+        r.begin = static_cast<uint32_t>(p_.subschemas.size());
+        p_.subschemas.insert(p_.subschemas.end(), nodes.begin(), nodes.end());
+        r.end = static_cast<uint32_t>(p_.subschemas.size());
+        return r;
+    }
+
+    const nlohmann::json& root_;
+    Program& p_;
+    std::unordered_map<const nlohmann::json*, int32_t> memo_;
+};
+
+namespace {
+
+bool fail(Violation* v, std::string reason) {
+    if (v) v->reason = std::move(reason);
+    return false;
+}
+
+bool fail_at(Violation* v, std::string token) {
+    if (v) v->path.push_back(std::move(token));
+    return false;
+}
+
+std::string format_number(double d) {
+    if (number_bit(d) == kInteger && std::fabs(d) < 9.0e15) return std::to_string(static_cast<int64_t>(d));
+    return nlohmann::json(d).dump();
+}
+
+} // anonymous namespace
+
+std::string SchemaValidator::Program::number_violation(const Node& n, double d) const {
+    if (n.minimum && d < *n.minimum) return "must be >= " + format_number(*n.minimum);
+    if (n.maximum && d > *n.maximum) return "must be <= " + format_number(*n.maximum);
+    if (n.exclusive_minimum && d <= *n.exclusive_minimum) {
+        return "must be > " + format_number(*n.exclusive_minimum);
+    }
+    if (n.exclusive_maximum && d >= *n.exclusive_maximum) {
+        return "must be < " + format_number(*n.exclusive_maximum);
+    }
+    if (n.multiple_of) {
+        double q = d / *n.multiple_of;
+        if (std::fabs(q - std::round(q)) > 1e-9 * std::max(1.0, std::fabs(q))) {
+            return "must be a multiple of " + format_number(*n.multiple_of);
+        }
+    }
+    return {};
+}
+
+std::string SchemaValidator::Program::string_violation(const Node& n, std::string_view s) const {
+    if (n.min_length > 0 || n.max_length != kUnbounded) {
+        size_t len = code_points(s);
+        if (len < n.min_length) return "must be at least " + std::to_string(n.min_length) + " characters";
+        if (len > n.max_length) return "must be at most " + std::to_string(n.max_length) + " characters";
+    }
+    if (n.pattern >= 0
+        && !std::regex_search(s.begin(), s.end(), patterns[static_cast<size_t>(n.pattern)])) {
+        return "does not match the pattern";
+    }
+    return {};
+}
+
+bool SchemaValidator::Program::check(int32_t node, const nlohmann::json& value, Violation* v) const {
+    if (node == kAccept) return true;
+    if (node == kReject) return fail(v, "not allowed");
+    const Node& n = nodes[static_cast<size_t>(node)];
+
+    uint8_t type = type_of(value);
+    if (!(n.types & type)) return fail(v, "expected " + type_names(n.types));
+    if (n.enum_values >= 0) {
+        const auto& allowed = values[static_cast<size_t>(n.enum_values)];
+        if (std::find(allowed.begin(), allowed.end(), value) == allowed.end()) {
+            return fail(v, "not one of the allowed values");
+        }
+    }
+    if (n.const_value >= 0 && values[static_cast<size_t>(n.const_value)][0] != value) {
+        return fail(v, "does not equal the constant");
+    }
+
+    if (type & (kInteger | kFraction)) {
+        if (auto reason = number_violation(n, value.get<double>()); !reason.empty()) {
+            return fail(v, std::move(reason));
+        }
+    } else if (type == kString) {
+        if (auto reason = string_violation(n, value.get_ref<const std::string&>()); !reason.empty()) {
+            return fail(v, std::move(reason));
+        }
+    } else if (type == kArray) {
+        for (size_t i = 0; i < value.size(); ++i) {
+            int32_t sub = i < n.prefix_items.size() ? subschemas[n.prefix_items.begin + i] : n.items;
+            if (!check(sub, value[i], v)) return fail_at(v, std::to_string(i));
+        }
+        if (value.size() < n.min_items) return fail(v, "expected at least " + std::to_string(n.min_items) + " items");
+        if (value.size() > n.max_items) return fail(v, "expected at most " + std::to_string(n.max_items) + " items");
+        if (n.unique_items) {
+            for (size_t i = 0; i < value.size(); ++i) {
+                for (size_t j = i + 1; j < value.size(); ++j) {
+                    if (value[i] == value[j]) return fail(v, "items are not unique");
+                }
+            }
+        }
+    } else if (type == kObject) {
+        for (const auto& [key, member] : value.items()) {
+            const Property* prop = find_property(n, key);
+            if (!check(prop ? prop->node : n.additional, member, v)) return fail_at(v, pointer_token(key));
+        }
+        if (value.size() < n.min_properties) {
+            return fail(v, "expected at least " + std::to_string(n.min_properties) + " properties");
+        }
+        if (value.size() > n.max_properties) {
+            return fail(v, "expected at most " + std::to_string(n.max_properties) + " properties");
+        }
+        if (n.required > 0) {
+            for (uint32_t i = n.properties.begin; i < n.properties.end; ++i) {
+                if (properties[i].required && !value.contains(properties[i].key)) {
+                    return fail(v, "missing property '" + properties[i].key + "'");
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = n.all_of.begin; i < n.all_of.end; ++i) {
+        if (!check(subschemas[i], value, v)) return false;
+    }
+    if (!n.any_of.empty()) {
+        bool any = false;
+        for (uint32_t i = n.any_of.begin; i < n.any_of.end && !any; ++i) {
+            any = check(subschemas[i], value, nullptr);
+        }
+        if (!any) return fail(v, "does not match any schema in anyOf");
+    }
+    if (!n.one_of.empty()) {
+        size_t matches = 0;
+        for (uint32_t i = n.one_of.begin; i < n.one_of.end && matches < 2; ++i) {
+            matches += check(subschemas[i], value, nullptr);
+        }
+        if (matches != 1) {
+            return fail(v, matches ? "matches more than one schema in oneOf"
+                                   : "does not match any schema in oneOf");
+        }
+    }
+    if (n.not_of && check(*n.not_of, value, nullptr)) return fail(v, "matches the schema in not");
+    return true;
+}
+
+void SchemaValidator::Program::check_text(int32_t node, JsonValue value) const {
+    if (node == kAccept) {
+        (void)value.raw_json();
+        return;
+    }
+    if (node == kReject) throw Violation{{}, "not allowed"};
+    const Node& n = nodes[static_cast<size_t>(node)];
+
+    if (n.needs_dom) {
+        Violation v;
+        if (!check(node, nlohmann::json::parse(value.raw_json()), &v)) throw v;
+        return;
+    }
+
+    auto expect = [&n](uint8_t type) {
+        if (!(n.types & type)) throw Violation{{}, "expected " + type_names(n.types)};
+    };
+    auto require = [](std::string reason) {
+        if (!reason.empty()) throw Violation{{}, std::move(reason)};
+    };
+
+    switch (value.type()) {
+        case JsonValue::Type::Null:
+            expect(kNull);
+            (void)value.raw_json();
+            break;
+        case JsonValue::Type::Bool:
+            expect(kBool);
+            (void)value.get_bool();
+            break;
+        case JsonValue::Type::Number: {
+            double d = value.get_double();
+            expect(number_bit(d));
+            require(number_violation(n, d));
+            break;
+        }
+        case JsonValue::Type::String: {
+            expect(kString);
+            require(string_violation(n, value.get_string()));
+            break;
+        }
+        case JsonValue::Type::Array: {
+            expect(kArray);
+            size_t i = 0;
+            value.for_each_element([&](JsonValue element) {
+                int32_t sub = i < n.prefix_items.size() ? subschemas[n.prefix_items.begin + i] : n.items;
+                try {
+                    check_text(sub, element);
+                } catch (Violation& v) {
+                    v.path.push_back(std::to_string(i));
+                    throw;
+                }
+                ++i;
+            });
+            if (i < n.min_items) require("expected at least " + std::to_string(n.min_items) + " items");
+            if (i > n.max_items) require("expected at most " + std::to_string(n.max_items) + " items");
+            break;
+        }
+        case JsonValue::Type::Object: {
+            expect(kObject);
+            // Which required properties turned up, by position in the node's list
+            std::vector<bool> seen(n.required ? n.properties.size() : 0);
+            size_t members = 0;
+            uint32_t found = 0;
+            value.for_each_member([&](std::string_view key, JsonValue member) {
+                ++members;
+                const Property* prop = find_property(n, key);
+                if (prop && prop->required && !seen[static_cast<size_t>(prop - &properties[n.properties.begin])]) {
+                    seen[static_cast<size_t>(prop - &properties[n.properties.begin])] = true;
+                    ++found;
+                }
+                try {
+                    check_text(prop ? prop->node : n.additional, member);
+                } catch (Violation& v) {
+                    v.path.push_back(pointer_token(key));
+                    throw;
+                }
+            });
+            if (members < n.min_properties) {
+                require("expected at least " + std::to_string(n.min_properties) + " properties");
+            }
+            if (members > n.max_properties) {
+                require("expected at most " + std::to_string(n.max_properties) + " properties");
+            }
+            if (found < n.required) {
+                for (uint32_t i = n.properties.begin; i < n.properties.end; ++i) {
+                    if (properties[i].required && !seen[i - n.properties.begin]) {
+                        require("missing property '" + properties[i].key + "'");
+                    }
+                }
+            }
+            break;
+        }
+    }
+}
+
+SchemaValidator::SchemaValidator(const nlohmann::json& schema) {
+    auto program = std::make_shared<Program>();
+    try {
+        program->root = Program::Compiler(schema, *program).compile(schema);
+    } catch (const nlohmann::json::exception& e) {
+        throw std::invalid_argument(std::string("Malformed schema: ") + e.what());
+    }
+    program_ = std::move(program);
+}
+
+std::optional<std::string> SchemaValidator::validate(const nlohmann::json& value) const {
+    Violation v;
+    if (program_->check(program_->root, value, &v)) return std::nullopt;
+    return v.message();
+}
+
+std::optional<std::string> SchemaValidator::validate_text(std::string_view json) const {
+    // The pull reader needs a container at the root
+    auto first = json.find_first_not_of(" \t\r\n");
+    bool container = first != std::string_view::npos && (json[first] == '{' || json[first] == '[');
+    try {
+        if (!container) return validate(nlohmann::json::parse(json));
+        JsonValue::read(json, [this](JsonValue root) { program_->check_text(program_->root, root); });
+        return std::nullopt;
+    } catch (const Violation& v) {
+        return v.message();
+    } catch (const McpError& e) {
+        return std::string("invalid JSON: ") + e.what();
+    } catch (const nlohmann::json::exception& e) {
+        return std::string("invalid JSON: ") + e.what();
+    }
+}
+
+} // namespace mcp
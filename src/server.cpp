@@ -1,13 +1,24 @@
 #include "mcp/server.hpp"
+#include "mcp/base64.hpp"
 #include "mcp/codec.hpp"
 #include "mcp/session.hpp"
+#include "mcp/request_table.hpp"
+#include "mcp/resource_cache.hpp"
+#include "mcp/subscription_index.hpp"
+#include "mcp/timer_wheel.hpp"
 #include "mcp/router.hpp"
+#include "mcp/snapshot.hpp"
 #include "mcp/error.hpp"
+#include "mcp/executor.hpp"
+#include "mcp/indexed_store.hpp"
+#include "mcp/json_writer.hpp"
 #include "mcp/version.hpp"
 #include "mcp/transport/stdio_transport.hpp"
 #include "mcp/transport/http_transport.hpp"
+#include "mcp/transport/shm_transport.hpp"
 
 #include <algorithm>
+#include <cstdlib>
 #include <atomic>
 #include <condition_variable>
 #include <future>
@@ -18,125 +29,540 @@
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
 namespace mcp {
 
-// ----------- Pager helper -----------
+// Name a registry entry is looked up and replaced by.
+static const std::string& registry_key(const ToolDefinition& t) { return t.name; }
+static const std::string& registry_key(const ResourceDefinition& r) { return r.uri; }
+static const std::string& registry_key(const ResourceTemplate& t) { return t.uri_template; }
+static const std::string& registry_key(const PromptDefinition& p) { return p.name; }
+
+// Listed definitions plus their handlers by key. Held in a CowSnapshot, so
+// a published version is never modified; copying one is O(1).
+template<typename T, typename Handler>
+struct Registry {
+    // Serialized list pages of one version, filled as they are first asked
+    // for. A mutation starts a new cache rather than clearing this one, since
+    // older snapshots may still be serving from it.
+    struct PageCache {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<const std::string>> pages;  // by cursor
+    };
+    // Bounds what unknown cursors from a peer can make us keep
+    static constexpr size_t kMaxCachedPages = 1024;
 
-template<typename T>
-struct PagedStore {
-    std::vector<T> items;
+    IndexedStore<T, Handler> items;
     size_t page_size = 50;
+    // Bumped by every mutation; reported in list results' _meta
+    uint64_t generation = 0;
+    std::shared_ptr<PageCache> cache = std::make_shared<PageCache>();
+
+    // Adds `def`, replacing any entry with the same key.
+    void put(T def, Handler handler) {
+        std::string key = registry_key(def);
+        items.put(std::move(key), std::move(def), std::move(handler));
+        changed();
+    }
 
-    // returns items starting from cursor, and next_cursor
-    std::pair<std::vector<T>, std::optional<std::string>>
-    page(const std::optional<std::string>& cursor) const {
-        size_t start = 0;
+    void erase(const std::string& key) {
+        if (items.erase(key)) changed();
+    }
+
+    void changed() {
+        ++generation;
+        cache = std::make_shared<PageCache>();
+    }
+
+    [[nodiscard]] std::shared_ptr<const Handler> find(const std::string& key) const {
+        return items.find(key);
+    }
+
+    // Returns {"<key>":[page...],"nextCursor":...,"_meta":{...}} for the page
+    // after cursor, serialized once per version and then shared from cache.
+    HandlerResult write_page(std::string_view key, const std::optional<std::string>& cursor) const {
+        uint64_t after = 0;  // sequence numbers start at 1
         if (cursor) {
-            try { start = std::stoull(*cursor); } catch (...) { start = 0; }
+            try { after = std::stoull(*cursor); } catch (...) {}
         }
-        if (start >= items.size()) {
-            return {{}, std::nullopt};
+        {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            auto it = cache->pages.find(after);
+            if (it != cache->pages.end()) return SharedJson{it->second};
         }
-        size_t end = std::min(start + page_size, items.size());
-        std::vector<T> page_items(items.begin() + start, items.begin() + end);
-        std::optional<std::string> next;
-        if (end < items.size()) next = std::to_string(end);
-        return {page_items, next};
+
+        RawJson out;
+        JsonWriter w(out.text);
+        w.begin_object().key(key).begin_array();
+        auto next = items.page(after ? std::optional<uint64_t>(after) : std::nullopt, page_size,
+                               [&](const T& item) { write_json(w, item); });
+        w.end_array();
+        if (next) w.field("nextCursor", std::to_string(*next));
+        w.key("_meta").begin_object().field("mcpxx/generation", generation).end_object();
+        w.end_object();
+
+        auto text = std::make_shared<const std::string>(std::move(out.text));
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (cache->pages.size() < kMaxCachedPages) cache->pages.emplace(after, text);
+        return SharedJson{std::move(text)};
     }
 };
 
+// Validators compiled from a tool's schemas, for tools validation is on for.
+struct ToolSchemas {
+    std::optional<SchemaValidator> input;
+    std::shared_ptr<const SchemaValidator> output;
+};
+
+// Exactly one handler is set, by whichever add_tool overload registered it.
+// `schemas` is set when validation is on for the tool.
+struct ToolEntry {
+    ToolHandler sync;
+    CancellableToolHandler cancellable;
+    AsyncToolHandler async;
+    CallbackToolHandler callback;
+    CoroutineToolHandler coroutine;
+    RawToolHandler raw;
+    std::shared_ptr<const ToolSchemas> schemas;
+};
+
+// Throws std::invalid_argument if a schema doesn't compile.
+static std::shared_ptr<const ToolSchemas> compile_schemas(const ToolDefinition& def) {
+    auto schemas = std::make_shared<ToolSchemas>();
+    if (!def.input_schema.is_null()) schemas->input.emplace(def.input_schema);
+    if (def.output_schema) schemas->output = std::make_shared<const SchemaValidator>(*def.output_schema);
+    return schemas;
+}
+
+// Resource handler; one of the two is set.
+struct ResourceEntry {
+    ResourceReadHandler read;
+    ResourceStreamHandler stream;
+};
+
+// Resource template handler; one of the two is set.
+struct TemplateEntry {
+    ResourceReadHandler read;
+    ResourceTemplateHandler read_with_vars;
+};
+
+// All templates of one registry version compiled into a single matcher
+// whose ids index `handlers`.
+struct CompiledTemplates {
+    uint64_t generation = 0;
+    UriTemplateMatcher matcher;
+    std::vector<std::shared_ptr<const TemplateEntry>> handlers;
+};
+
+// Bytes read from a ResourceStream per piece; a multiple of 3, so binary
+// chunks encode without holding bytes back.
+static constexpr size_t kStreamChunkBytes = 48 * 1024;
+
+// resources/read result for `uri` whose content is pulled from `source` a
+// chunk at a time as the stream is drained.
+static JsonStream stream_resource(const std::string& uri, ResourceStream source) {
+    struct State {
+        ResourceStream source;
+        base64::Encoder encoder;
+        std::string chunk;
+        std::string head;  // written by the first call
+    };
+    auto st = std::make_shared<State>();
+    st->source = std::move(source);
+    JsonWriter w(st->head);
+    w.begin_object().key("contents").begin_array().begin_object().field("uri", uri);
+    if (st->source.mime_type) w.field("mimeType", *st->source.mime_type);
+    w.key(st->source.binary ? "blob" : "text");
+    st->head += '"';
+
+    return [st](std::string& out) -> bool {
+        if (!st->head.empty()) {
+            out += st->head;
+            st->head.clear();
+            st->chunk.resize(kStreamChunkBytes);
+            return true;
+        }
+        size_t n = std::min(st->source.read(st->chunk.data(), st->chunk.size()), st->chunk.size());
+        std::string_view bytes(st->chunk.data(), n);
+        if (n > 0) {
+            // Escaping leaves bytes >= 0x80 alone, so a UTF-8 sequence may
+            // straddle two chunks
+            if (st->source.binary) st->encoder.update(out, bytes);
+            else JsonWriter::escape(out, bytes);
+            return true;
+        }
+        if (st->source.binary) st->encoder.finish(out);
+        out += "\"}]}";
+        return false;
+    };
+}
+
+// Serializes a result straight to response text.
+template<typename T>
+static RawJson write_result(const T& value) {
+    RawJson out;
+    JsonWriter w(out.text);
+    write_json(w, value);
+    return out;
+}
+
+// Serialized result, or an error if it breaks the tool's output schema.
+// Error results aren't checked.
+static HandlerResult checked_result(const SchemaValidator* output, const CallToolResult& result) {
+    if (output && !result.is_error) {
+        auto violation = result.structured_content ? output->validate(*result.structured_content)
+                                                   : std::optional<std::string>("missing structuredContent");
+        if (violation) {
+            return JsonRpcError{error::InternalError,
+                                "Tool result does not match its output schema: " + *violation,
+                                std::nullopt};
+        }
+    }
+    return write_result(result);
+}
+
+static JsonRpcError invalid_arguments(const std::string& violation) {
+    return JsonRpcError{error::InvalidParams, "Invalid arguments: " + violation, std::nullopt};
+}
+
+// Serialized is_error result for a tool that threw or failed.
+static RawJson tool_error_result(const std::string& message) {
+    CallToolResult error_result;
+    error_result.is_error = true;
+    error_result.content.push_back(TextContent{message, std::nullopt});
+    return write_result(error_result);
+}
+
 // ----------- McpServer::Impl -----------
 
+// ----------- Progress throttling -----------
+
+// Holds back progress updates that arrive faster than one per `interval`
+// for the same token. The newest held update goes out when the interval
+// ends, or earlier through flush(), so the final value always arrives and
+// nothing older than it does.
+class ProgressThrottle {
+public:
+    using Send = std::function<void(nlohmann::json params)>;
+
+    ProgressThrottle(std::chrono::nanoseconds interval, Send send)
+        : interval_(interval), send_(std::move(send)), thread_([this] { run(); }) {}
+
+    ~ProgressThrottle() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void submit(const std::string& key, nlohmann::json params) {
+        std::optional<Pending> send;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            auto [it, inserted] = entries_.try_emplace(key);
+            if (inserted) it->second = std::make_shared<Entry>();
+            Entry& entry = *it->second;
+            if (inserted || (now >= entry.next_allowed && !entry.held)) {
+                entry.next_allowed = now + interval_;
+                send = take(it->second, std::move(params));
+                if (inserted) cv_.notify_one();  // a new deadline to expire it by
+            } else {
+                entry.held = std::move(params);
+            }
+        }
+        if (send) deliver(std::move(*send));
+    }
+
+    /// Sends the held update for `key`, if any, right away.
+    void flush(const std::string& key) {
+        std::optional<Pending> send;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it == entries_.end() || !it->second->held) return;
+            it->second->next_allowed = std::chrono::steady_clock::now() + interval_;
+            send = take(it->second, std::move(*std::exchange(it->second->held, std::nullopt)));
+        }
+        deliver(std::move(*send));
+    }
+
+private:
+    struct Entry {
+        // Under the throttle's mutex_
+        std::chrono::steady_clock::time_point next_allowed;
+        std::optional<nlohmann::json> held;
+        uint64_t taken = 0;
+        // Held while sending, so one token's updates go out one at a time
+        std::mutex send_mutex;
+        uint64_t sent = 0;
+    };
+
+    // An update on its way out; `seq` orders it among its token's
+    struct Pending {
+        std::shared_ptr<Entry> entry;
+        uint64_t seq;
+        nlohmann::json params;
+    };
+
+    // Under mutex_
+    static Pending take(const std::shared_ptr<Entry>& entry, nlohmann::json params) {
+        return Pending{entry, ++entry->taken, std::move(params)};
+    }
+
+    // Without mutex_: a transport that blocks holds up this token only. An
+    // update overtaken by a newer one on another thread is dropped.
+    void deliver(Pending p) {
+        std::lock_guard<std::mutex> lock(p.entry->send_mutex);
+        if (p.seq < p.entry->sent) return;
+        p.entry->sent = p.seq;
+        send_(std::move(p.params));
+    }
+
+    void run() {
+        std::vector<Pending> due;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            // Release what is due and forget tokens that went quiet. One
+            // with a send still in flight is kept (use_count only drops
+            // outside mutex_), so a replacement can't overtake it.
+            auto now = std::chrono::steady_clock::now();
+            auto wake = std::chrono::steady_clock::time_point::max();
+            for (auto it = entries_.begin(); it != entries_.end();) {
+                Entry& entry = *it->second;
+                if (now >= entry.next_allowed) {
+                    if (!entry.held) {
+                        if (it->second.use_count() == 1) {
+                            it = entries_.erase(it);
+                            continue;
+                        }
+                        entry.next_allowed = now + interval_;
+                    } else {
+                        entry.next_allowed = now + interval_;
+                        auto held = std::move(*std::exchange(entry.held, std::nullopt));
+                        due.push_back(take(it->second, std::move(held)));
+                    }
+                }
+                wake = std::min(wake, entry.next_allowed);
+                ++it;
+            }
+            if (!due.empty()) {
+                lock.unlock();
+                for (auto& p : due) deliver(std::move(p));
+                due.clear();
+                lock.lock();
+                continue;  // more may have come due meanwhile
+            }
+            if (wake == std::chrono::steady_clock::time_point::max()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, wake);
+            }
+        }
+    }
+
+    const std::chrono::nanoseconds interval_;
+    Send send_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+    bool stop_ = false;
+    std::thread thread_;  // last: started once the rest is initialized
+};
+
+// Throttling key for a progress token; ints and strings never collide
+static std::string progress_key(const nlohmann::json& token) {
+    return token.dump();
+}
+
+// Smallest spacing between messages allowed by a per-second rate
+static std::chrono::nanoseconds rate_interval(double per_second) {
+    return std::chrono::nanoseconds(static_cast<int64_t>(1e9 / per_second));
+}
+
 struct McpServer::Impl {
     Options opts;
-    Session session;
     Router router;
 
-    // Storage
-    std::mutex store_mutex;
-    PagedStore<ToolDefinition> tools;
-    std::unordered_map<std::string, ToolHandler> tool_handlers;
-    std::unordered_map<std::string, CancellableToolHandler> cancellable_tool_handlers;
-    std::unordered_map<std::string, AsyncToolHandler> async_tool_handlers;
+    // Protocol state per client, keyed by the transport's session id (""
+    // on single-peer transports): created with a session's first message,
+    // dropped once the transport reports it ended. Handlers reach the
+    // one they serve through Router::current_session().
+    std::mutex sessions_mutex;
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+
+    // Storage. Request handlers read a snapshot without locking; add_* and
+    // remove_* publish a new one, so lookups never wait on registration
+    // and a handler stays alive for calls already holding it.
+    CowSnapshot<Registry<ToolDefinition, ToolEntry>> tools;
+    std::atomic<bool> has_raw_tools{false};  // skips the wire-text scan otherwise
+
+    // Per-tool overrides of opts.validate_tool_schemas
+    std::mutex validation_mutex;
+    std::unordered_map<std::string, bool> validation_overrides;
+
+    bool validation_enabled(const std::string& name) {
+        std::lock_guard<std::mutex> lock(validation_mutex);
+        auto it = validation_overrides.find(name);
+        return it != validation_overrides.end() ? it->second : opts.validate_tool_schemas;
+    }
 
-    // Active tool calls tracked for cancellation (request_id_string -> token)
+    // Requests handed to the executor and not yet answered, by
+    // request_key(), for notifications/cancelled to find
+    struct ActiveRequest {
+        CancellationToken token;
+        uint64_t serial;  // tells a reused id's entry apart
+    };
     std::mutex active_mutex;
-    std::unordered_map<std::string, CancellationToken> active_requests;
+    std::unordered_map<std::string, ActiveRequest> active_requests;
+    uint64_t next_request_serial{0};
+
+    static std::string request_key(const std::string& session_id, const RequestId& id) {
+        std::string key = session_id;
+        key += '\n';
+        if (const auto* n = std::get_if<int64_t>(&id)) key += std::to_string(*n);
+        else key += '"' + std::get<std::string>(id);
+        return key;
+    }
 
-    PagedStore<ResourceDefinition> resources;
-    std::unordered_map<std::string, ResourceReadHandler> resource_handlers;
+    // Returns the serial for end_request()
+    uint64_t begin_request(const std::string& key, CancellationToken token) {
+        std::lock_guard<std::mutex> lock(active_mutex);
+        uint64_t serial = ++next_request_serial;
+        active_requests.insert_or_assign(key, ActiveRequest{std::move(token), serial});
+        return serial;
+    }
 
-    PagedStore<ResourceTemplate> resource_templates;
-    std::unordered_map<std::string, ResourceReadHandler> resource_template_handlers;
+    void end_request(const std::string& key, uint64_t serial) {
+        std::lock_guard<std::mutex> lock(active_mutex);
+        auto it = active_requests.find(key);
+        // A client reusing an id while the first is in flight replaced it
+        if (it != active_requests.end() && it->second.serial == serial) active_requests.erase(it);
+    }
 
-    PagedStore<PromptDefinition> prompts;
-    std::unordered_map<std::string, PromptGetHandler> prompt_handlers;
+    CowSnapshot<Registry<ResourceDefinition, ResourceEntry>> resources;
+    CowSnapshot<Registry<ResourceTemplate, TemplateEntry>> resource_templates;
+    // Compiled on the first read after templates change, not per registration
+    std::atomic<std::shared_ptr<const CompiledTemplates>> compiled_templates;
+    ResourceCache resource_cache;
+    CowSnapshot<Registry<PromptDefinition, PromptGetHandler>> prompts;
 
     std::optional<CompletionHandler> completion_handler;
 
-    // Subscriptions (resource URI -> set of session IDs)
-    std::set<std::string> subscribed_uris;
+    // Subscriptions (URI or prefix pattern -> session IDs)
+    std::mutex subscriptions_mutex;
+    SubscriptionIndex subscribers;
+    // URIs updated since the last fan-out, with Options::resource_update_window
+    std::mutex updates_mutex;
+    std::set<std::string> pending_updates;
+    bool update_flush_scheduled{false};
 
     // Transport reference for sending outbound messages
     ITransport* transport{nullptr};
     std::mutex transport_mutex;
 
     std::atomic<bool> running{false};
+    // Least severe level any session wants, so log() skips the rest
     std::atomic<LogLevel> min_log_level{LogLevel::Info};
 
-    // Thread pool
-    std::vector<std::thread> thread_pool;
-    std::queue<std::function<void()>> task_queue;
-    std::mutex pool_mutex;
-    std::condition_variable pool_cv;
-    std::atomic<bool> pool_running{false};
+    // Rate limits (Options::max_progress_rate / max_log_rate)
+    std::unique_ptr<ProgressThrottle> progress_throttle;
+    std::mutex log_rate_mutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> log_next_allowed;
+    // Expired entries are swept once the map reaches this size
+    size_t log_sweep_at = 1024;
+
+    // Request executor (owned unless supplied through Options::executor)
+    std::shared_ptr<IExecutor> executor;
+    bool owns_executor{false};
+    bool dispatch_async{false};
+
+    // Tasks posted to the executor that have not finished yet
+    std::mutex inflight_mutex;
+    std::condition_variable inflight_cv;
+    size_t inflight{0};
 
     // Pending server->client requests
+    using ResponseCallback = std::function<void(JsonRpcResponse)>;
+    struct Pending {
+        ResponseCallback callback;
+        TimerWheel::TimerId timer = 0;
+        std::string session;  // sent to
+        // Made while handling a request: cancelled along with it
+        CancellationToken upstream = CancellationToken::none();
+        uint64_t upstream_callback = 0;
+    };
     std::mutex pending_mutex;
-    std::unordered_map<std::string, std::promise<JsonRpcResponse>> pending_responses;
+    RequestTable<Pending> pending_responses{64};
     int64_t next_outbound_id{1};
-
-    explicit Impl(Options o) : opts(std::move(o)) {}
+    // Expires server->client requests; stops before the members above go
+    TimerWheel timers;
+
+    explicit Impl(Options o)
+        : opts(std::move(o)),
+          resource_cache({opts.resource_cache_bytes, opts.resource_cache_ttl}) {
+        timers.start();
+        if (opts.max_progress_rate > 0) {
+            progress_throttle = std::make_unique<ProgressThrottle>(
+                rate_interval(opts.max_progress_rate), [this](nlohmann::json params) {
+                    send_notification("notifications/progress", std::move(params));
+                });
+        }
+    }
 
     void start_thread_pool() {
-        pool_running = true;
-        for (int i = 0; i < opts.thread_pool_size; ++i) {
-            thread_pool.emplace_back([this] {
-                while (pool_running) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(pool_mutex);
-                        pool_cv.wait(lock, [this] {
-                            return !task_queue.empty() || !pool_running;
-                        });
-                        if (!pool_running && task_queue.empty()) return;
-                        task = std::move(task_queue.front());
-                        task_queue.pop();
-                    }
-                    task();
-                }
-            });
+        if (opts.executor) {
+            executor = opts.executor;
+            owns_executor = false;
+        } else {
+            WorkStealingExecutor::Options eopts;
+            eopts.num_threads = static_cast<size_t>(opts.thread_pool_size);
+            eopts.pin_threads = opts.pin_worker_threads;
+            executor = std::make_shared<WorkStealingExecutor>(eopts);
+            owns_executor = true;
         }
     }
 
     void stop_thread_pool() {
-        pool_running = false;
-        pool_cv.notify_all();
-        for (auto& t : thread_pool) {
-            if (t.joinable()) t.join();
+        if (!executor) return;
+        // Wait for our own tasks; a shared executor may keep running others.
+        {
+            std::unique_lock<std::mutex> lock(inflight_mutex);
+            inflight_cv.wait(lock, [this] { return inflight == 0; });
         }
-        thread_pool.clear();
+        if (owns_executor) executor->shutdown();
+        executor.reset();
     }
 
-    void dispatch_to_pool(std::function<void()> fn) {
-        {
-            std::lock_guard<std::mutex> lock(pool_mutex);
-            task_queue.push(std::move(fn));
+    // Holds one count of `inflight` for as long as the task that owns it
+    // exists, so it is given back however the task ends (returning,
+    // throwing, or dropped unrun).
+    class InflightHold {
+    public:
+        explicit InflightHold(Impl* impl) : impl_(impl) {
+            std::lock_guard<std::mutex> lock(impl_->inflight_mutex);
+            ++impl_->inflight;
+        }
+        InflightHold(InflightHold&& o) noexcept : impl_(std::exchange(o.impl_, nullptr)) {}
+        InflightHold& operator=(InflightHold&&) = delete;
+        ~InflightHold() {
+            if (!impl_) return;
+            std::lock_guard<std::mutex> lock(impl_->inflight_mutex);
+            if (--impl_->inflight == 0) impl_->inflight_cv.notify_all();
         }
-        pool_cv.notify_one();
+
+    private:
+        Impl* impl_;
+    };
+
+    template<typename F>
+    void dispatch_to_pool(F&& fn) {
+        executor->post([hold = InflightHold(this), fn = std::forward<F>(fn)]() mutable { fn(); });
     }
 
     void send_message(const JsonRpcMessage& msg) {
@@ -154,20 +580,143 @@ struct McpServer::Impl {
         send_message(notif);
     }
 
+    // To one session; "" is the only peer of a single-peer transport
+    void send_to(const std::string& session, const JsonRpcMessage& msg) {
+        std::lock_guard<std::mutex> lock(transport_mutex);
+        if (!transport) return;
+        if (session.empty()) {
+            transport->send(msg);
+        } else {
+            transport->send_to_session(session, msg);
+        }
+    }
+
+    std::shared_ptr<Session> session_for(const std::string& id) {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        auto& session = sessions[id];
+        if (!session) {
+            session = std::make_shared<Session>();
+            session->set_request_timeout(opts.request_timeout);
+            if (!id.empty()) session->session_id() = id;
+        }
+        return session;
+    }
+
+    // Id of the session whose handler is running here; "" if none
+    static std::string current_session_id() {
+        const Session* session = Router::current_session();
+        if (!session) return {};
+        return session->session_id().value_or(std::string());
+    }
+
+    void close_session(const std::string& id) {
+        std::shared_ptr<Session> session;
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            auto it = sessions.find(id);
+            if (it == sessions.end()) return;
+            session = std::move(it->second);
+            sessions.erase(it);
+        }
+        {
+            std::lock_guard<std::mutex> lock(subscriptions_mutex);
+            for (const auto& uri : session->subscriptions()) subscribers.remove(uri, id);
+        }
+        update_log_floor();
+    }
+
+    // Sends notifications/resources/updated for each URI to the sessions
+    // whose patterns match it, each (session, URI) pair once.
+    void fan_out_updates(const std::set<std::string>& uris) {
+        if (uris.empty() || !running) return;
+        std::map<std::string, std::vector<const std::string*>> targets;
+        {
+            std::lock_guard<std::mutex> lock(subscriptions_mutex);
+            if (subscribers.empty()) return;
+            std::vector<const std::string*> matched;
+            for (const auto& uri : uris) {
+                matched.clear();
+                subscribers.collect(uri, matched);
+                for (const auto* session : matched) {
+                    auto& list = targets[*session];
+                    if (list.empty() || list.back() != &uri) list.push_back(&uri);
+                }
+            }
+        }
+        JsonRpcNotification notif;
+        notif.method = "notifications/resources/updated";
+        for (const auto& [session, list] : targets) {
+            for (const auto* uri : list) {
+                notif.params = nlohmann::json{{"uri", *uri}};
+                send_to(session, notif);
+            }
+        }
+    }
+
+    void update_log_floor() {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        LogLevel floor = sessions.empty() ? LogLevel::Info : LogLevel::Emergency;
+        for (const auto& [id, session] : sessions) floor = std::min(floor, session->log_level());
+        min_log_level = floor;
+    }
+
+    // Sends a log notification to the sessions whose level admits it
+    void send_log(LogLevel level, nlohmann::json params) {
+        JsonRpcNotification notif;
+        notif.method = "notifications/message";
+        notif.params = std::move(params);
+        std::vector<std::string> targets;
+        size_t total;
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            total = sessions.size();
+            for (const auto& [id, session] : sessions) {
+                if (level >= session->log_level()) targets.push_back(id);
+            }
+        }
+        if (targets.size() == total) return send_message(notif);  // one send for all
+        for (const auto& id : targets) send_to(id, notif);
+    }
+
+    // Matcher for the current templates, rebuilt if they changed since
+    std::shared_ptr<const CompiledTemplates> templates_matcher() {
+        auto templates = resource_templates.load();
+        auto compiled = compiled_templates.load(std::memory_order_acquire);
+        if (compiled && compiled->generation == templates->generation) return compiled;
+
+        auto fresh = std::make_shared<CompiledTemplates>();
+        fresh->generation = templates->generation;
+        templates->items.for_each_handler([&](const std::string& tmpl, const auto& handler) {
+            fresh->matcher.add(tmpl, fresh->handlers.size());
+            fresh->handlers.push_back(handler);
+            return true;
+        });
+        // Racing readers may each build one; any of them is current
+        compiled_templates.store(fresh, std::memory_order_release);
+        return fresh;
+    }
+
+    void put_tool(ToolDefinition def, ToolEntry entry) {
+        if (validation_enabled(def.name)) entry.schemas = compile_schemas(def);
+        tools.update([&](auto& r) { r.put(std::move(def), std::move(entry)); });
+        if (running) send_notification("notifications/tools/list_changed");
+    }
+
     // Build server capabilities from what's registered
     ServerCapabilities build_capabilities() const {
         ServerCapabilities caps;
         {
-            if (!tools.items.empty()) {
+            if (!tools.load()->items.empty()) {
                 caps.tools = nlohmann::json{{"listChanged", true}};
             }
-            if (!resources.items.empty() || !resource_templates.items.empty()) {
+            if (!resources.load()->items.empty()
+                || !resource_templates.load()->items.empty()) {
                 caps.resources = nlohmann::json{
                     {"subscribe", true},
                     {"listChanged", true}
                 };
             }
-            if (!prompts.items.empty()) {
+            if (!prompts.load()->items.empty()) {
                 caps.prompts = nlohmann::json{{"listChanged", true}};
             }
             caps.logging = nlohmann::json::object();
@@ -178,9 +727,36 @@ struct McpServer::Impl {
         return caps;
     }
 
+    // mcpxx extension: picks the first binary format the client offered
+    // that the transport can send and switches the transport to it, so the
+    // initialize response already goes out in it. The client reads either.
+    std::optional<WireFormat> negotiate_wire_format(const nlohmann::json& params) {
+        if (!opts.accept_wire_formats || !current_session_id().empty()) return std::nullopt;
+        const auto* offer = params.contains("capabilities") ? &params["capabilities"] : nullptr;
+        if (!offer || !offer->is_object() || !offer->contains("experimental")) return std::nullopt;
+        const auto& experimental = (*offer)["experimental"];
+        if (!experimental.is_object() || !experimental.contains(kWireFormatCapability)) {
+            return std::nullopt;
+        }
+        const auto& framing = experimental[kWireFormatCapability];
+        if (!framing.is_object() || !framing.contains("formats") || !framing["formats"].is_array()) {
+            return std::nullopt;
+        }
+        std::lock_guard<std::mutex> lock(transport_mutex);
+        if (!transport) return std::nullopt;
+        for (const auto& name : framing["formats"]) {
+            if (!name.is_string()) continue;
+            auto format = parse_wire_format(name.get_ref<const std::string&>());
+            if (!format || *format == WireFormat::Json) continue;
+            if (transport->set_wire_format(*format)) return format;
+        }
+        return std::nullopt;
+    }
+
     void setup_handlers() {
         // initialize
         router.on_request("initialize", [this](const nlohmann::json& params) -> HandlerResult {
+            Session& session = *Router::current_session();
             // Parse client info
             if (params.contains("clientInfo")) {
                 try {
@@ -196,10 +772,13 @@ struct McpServer::Impl {
 
             session.set_state(SessionState::Initializing);
 
-            ServerCapabilities caps;
-            {
-                std::lock_guard<std::mutex> lock(store_mutex);
-                caps = build_capabilities();
+            ServerCapabilities caps = build_capabilities();
+            if (auto format = negotiate_wire_format(params)) {
+                if (!caps.experimental || !caps.experimental->is_object()) {
+                    caps.experimental = nlohmann::json::object();
+                }
+                (*caps.experimental)[kWireFormatCapability] =
+                    nlohmann::json{{"format", to_string(*format)}};
             }
             session.server_capabilities() = caps;
 
@@ -216,6 +795,7 @@ struct McpServer::Impl {
 
         // notifications/initialized
         router.on_notification("notifications/initialized", [this](const nlohmann::json&) {
+            Session& session = *Router::current_session();
             session.set_state(SessionState::Ready);
             // Update router capabilities
             router.set_capabilities(session.server_capabilities(), session.client_capabilities());
@@ -232,90 +812,116 @@ struct McpServer::Impl {
             if (params.contains("cursor") && !params.at("cursor").is_null()) {
                 cursor = params.at("cursor").get<std::string>();
             }
-            std::lock_guard<std::mutex> lock(store_mutex);
-            auto [items, next] = tools.page(cursor);
-            nlohmann::json result = {{"tools", items}};
-            if (next) result["nextCursor"] = *next;
-            return result;
+            return tools.load()->write_page("tools", cursor);
         });
 
         // tools/call
-        router.on_request("tools/call", [this](const nlohmann::json& params) -> HandlerResult {
+        router.on_request_raw("tools/call", [this](LazyJson lazy_params, Responder respond) {
+            // Passthrough tools are resolved from the wire text, so their
+            // arguments never become a DOM.
+            if (auto raw = lazy_params.raw(); raw && has_raw_tools.load()) {
+                auto fields = Codec::find_raw_members(*raw, {"name", "arguments"});
+                if (fields[0]) {
+                    std::string raw_name = Codec::parse_value(*fields[0]).get<std::string>();
+                    auto entry = tools.load()->find(raw_name);
+                    if (entry && entry->raw) {
+                        std::string_view arguments = fields[1] ? *fields[1] : std::string_view("{}");
+                        if (entry->schemas && entry->schemas->input) {
+                            if (auto bad = entry->schemas->input->validate_text(arguments)) {
+                                respond(invalid_arguments(*bad));
+                                return;
+                            }
+                        }
+                        try {
+                            respond(entry->raw(arguments));
+                        } catch (const std::exception& e) {
+                            respond(tool_error_result(e.what()));
+                        }
+                        return;
+                    }
+                }
+            }
+
+            // The params are ours, so arguments are moved out rather than
+            // copied, however large.
+            nlohmann::json params = lazy_params ? std::move(*lazy_params) : nlohmann::json::object();
             std::string name = params.at("name").get<std::string>();
-            nlohmann::json arguments = params.value("arguments", nlohmann::json::object());
+            nlohmann::json arguments = nlohmann::json::object();
+            if (auto it = params.find("arguments"); it != params.end()) arguments = std::move(*it);
 
-            // Extract _meta.progressToken to use as request tracking key
-            std::string request_key;
             if (params.contains("_meta") && params["_meta"].contains("progressToken")) {
                 auto& pt = params["_meta"]["progressToken"];
-                if (pt.is_number_integer()) request_key = std::to_string(pt.get<int64_t>());
-                else if (pt.is_string()) request_key = pt.get<std::string>();
+                // Progress held back by the throttle goes out ahead of the result
+                if (progress_throttle && (pt.is_number_integer() || pt.is_string())) {
+                    respond = Responder([this, inner = respond, key = progress_key(pt)](HandlerResult r) {
+                        progress_throttle->flush(key);
+                        inner(std::move(r));
+                    });
+                }
             }
 
-            // Copy handlers under lock to avoid dangling pointers if
-            // remove_tool() is called concurrently.
-            ToolHandler handler;
-            CancellableToolHandler cancellable_handler;
-            AsyncToolHandler async_handler;
-            {
-                std::lock_guard<std::mutex> lock(store_mutex);
-                auto it = tool_handlers.find(name);
-                if (it != tool_handlers.end()) {
-                    handler = it->second;
-                } else {
-                    auto cit = cancellable_tool_handlers.find(name);
-                    if (cit != cancellable_tool_handlers.end()) {
-                        cancellable_handler = cit->second;
-                    } else {
-                        auto ait = async_tool_handlers.find(name);
-                        if (ait != async_tool_handlers.end()) {
-                            async_handler = ait->second;
-                        }
+            // Holding the entry keeps its handler alive even if
+            // remove_tool() runs concurrently.
+            auto entry = tools.load()->find(name);
+            if (!entry) {
+                respond(JsonRpcError{error::InvalidParams, "Unknown tool: " + name, std::nullopt});
+                return;
+            }
+            const SchemaValidator* output = nullptr;
+            if (entry->schemas) {
+                if (entry->schemas->input) {
+                    if (auto bad = entry->schemas->input->validate(arguments)) {
+                        respond(invalid_arguments(*bad));
+                        return;
                     }
                 }
-            }
-
-            if (!handler && !cancellable_handler && !async_handler) {
-                return JsonRpcError{error::InvalidParams, "Unknown tool: " + name, std::nullopt};
+                output = entry->schemas->output.get();
             }
 
             try {
+                if (entry->callback) {
+                    // Completes whenever the tool calls the responder; this
+                    // thread goes straight back to the pool.
+                    entry->callback(arguments, ToolResponder(respond,
+                        entry->schemas ? entry->schemas->output : nullptr));
+                    return;
+                }
+                if (entry->raw) {
+                    // Params arrived without wire text (built in process)
+                    respond(entry->raw(arguments.dump()));
+                    return;
+                }
+                if (entry->coroutine) {
+                    // Runs until its first suspension here; the entry stays
+                    // alive until completion because the closure owns the captures.
+                    spawn(entry->coroutine(std::move(arguments)),
+                          [entry, respond, output](CallToolResult result) {
+                              respond(checked_result(output, result));
+                          },
+                          [entry, respond](std::exception_ptr e) {
+                              try {
+                                  std::rethrow_exception(e);
+                              } catch (const std::exception& ex) {
+                                  respond(tool_error_result(ex.what()));
+                              } catch (...) {
+                                  respond(tool_error_result("Unknown error"));
+                              }
+                          });
+                    return;
+                }
+
                 CallToolResult tool_result;
-                if (cancellable_handler) {
-                    CancellationToken token;
-                    if (!request_key.empty()) {
-                        std::lock_guard<std::mutex> lock(active_mutex);
-                        active_requests[request_key] = token;
-                    }
-                    try {
-                        tool_result = cancellable_handler(arguments, token);
-                    } catch (...) {
-                        if (!request_key.empty()) {
-                            std::lock_guard<std::mutex> lock(active_mutex);
-                            active_requests.erase(request_key);
-                        }
-                        throw;
-                    }
-                    if (!request_key.empty()) {
-                        std::lock_guard<std::mutex> lock(active_mutex);
-                        active_requests.erase(request_key);
-                    }
-                } else if (handler) {
-                    tool_result = handler(arguments);
+                if (entry->cancellable) {
+                    tool_result = entry->cancellable(arguments, CancellationToken::current());
+                } else if (entry->sync) {
+                    tool_result = entry->sync(arguments);
                 } else {
-                    auto fut = async_handler(arguments);
+                    auto fut = entry->async(arguments);
                     tool_result = fut.get();
                 }
-                nlohmann::json j;
-                to_json(j, tool_result);
-                return j;
+                respond(checked_result(output, tool_result));
             } catch (const std::exception& e) {
-                CallToolResult error_result;
-                error_result.is_error = true;
-                error_result.content.push_back(TextContent{e.what(), std::nullopt});
-                nlohmann::json j;
-                to_json(j, error_result);
-                return j;
+                respond(tool_error_result(e.what()));
             }
         });
 
@@ -325,45 +931,54 @@ struct McpServer::Impl {
             if (params.contains("cursor") && !params.at("cursor").is_null()) {
                 cursor = params.at("cursor").get<std::string>();
             }
-            std::lock_guard<std::mutex> lock(store_mutex);
-            auto [items, next] = resources.page(cursor);
-            nlohmann::json result = {{"resources", items}};
-            if (next) result["nextCursor"] = *next;
-            return result;
+            return resources.load()->write_page("resources", cursor);
         });
 
         // resources/read
         router.on_request("resources/read", [this](const nlohmann::json& params) -> HandlerResult {
             std::string uri = params.at("uri").get<std::string>();
-
-            // Copy handler under lock to avoid dangling pointer if
-            // remove_resource() is called concurrently.
-            ResourceReadHandler handler;
-            {
-                std::lock_guard<std::mutex> lock(store_mutex);
-                auto it = resource_handlers.find(uri);
-                if (it != resource_handlers.end()) {
-                    handler = it->second;
-                } else {
-                    // Try templates - find a matching template handler
-                    for (auto& [tmpl_key, tmpl_handler] : resource_template_handlers) {
-                        // Simple prefix match
-                        if (uri.find(tmpl_key.substr(0, tmpl_key.find('{'))) == 0) {
-                            handler = tmpl_handler;
-                            break;
-                        }
-                    }
-                }
+            uint64_t cache_stamp = 0;
+            if (resource_cache.enabled()) {
+                if (auto hit = resource_cache.get(uri)) return SharedJson{std::move(hit)};
+                cache_stamp = resource_cache.stamp();
             }
 
+            // Static resources first, then the compiled templates. `compiled`
+            // keeps `entry` alive.
+            auto handler = resources.load()->find(uri);
+            std::shared_ptr<const CompiledTemplates> compiled;
+            const TemplateEntry* entry = nullptr;
+            UriTemplateVars vars;
             if (!handler) {
+                compiled = templates_matcher();
+                if (auto id = compiled->matcher.match(uri, &vars)) entry = compiled->handlers[*id].get();
+            }
+
+            if (!handler && !entry) {
                 return JsonRpcError{error::ResourceNotFound, "Resource not found: " + uri, std::nullopt};
             }
 
             try {
-                auto contents = handler(uri);
-                nlohmann::json result = {{"contents", contents}};
-                return result;
+                if (handler && handler->stream) {
+                    auto source = handler->stream(uri);
+                    if (!source.read) {
+                        return JsonRpcError{error::InternalError, "Resource stream has no reader: " + uri,
+                                            std::nullopt};
+                    }
+                    return StreamedJson{stream_resource(uri, std::move(source))};
+                }
+                auto contents = handler ? handler->read(uri)
+                              : entry->read ? entry->read(uri)
+                              : entry->read_with_vars(uri, vars);
+                RawJson result;
+                JsonWriter w(result.text);
+                w.begin_object().key("contents").begin_array();
+                for (const auto& c : contents) write_json(w, c);
+                w.end_array().end_object();
+                if (!resource_cache.enabled()) return result;
+                auto text = std::make_shared<const std::string>(std::move(result.text));
+                resource_cache.put(uri, text, cache_stamp);
+                return SharedJson{std::move(text)};
             } catch (const std::exception& e) {
                 return JsonRpcError{error::InternalError, e.what(), std::nullopt};
             }
@@ -375,19 +990,15 @@ struct McpServer::Impl {
             if (params.contains("cursor") && !params.at("cursor").is_null()) {
                 cursor = params.at("cursor").get<std::string>();
             }
-            std::lock_guard<std::mutex> lock(store_mutex);
-            auto [items, next] = resource_templates.page(cursor);
-            nlohmann::json result = {{"resourceTemplates", items}};
-            if (next) result["nextCursor"] = *next;
-            return result;
+            return resource_templates.load()->write_page("resourceTemplates", cursor);
         });
 
         // resources/subscribe
         router.on_request("resources/subscribe", [this](const nlohmann::json& params) -> HandlerResult {
             std::string uri = params.at("uri").get<std::string>();
-            {
-                std::lock_guard<std::mutex> lock(store_mutex);
-                subscribed_uris.insert(uri);
+            if (Router::current_session()->subscribe(uri)) {
+                std::lock_guard<std::mutex> lock(subscriptions_mutex);
+                subscribers.add(uri, current_session_id());
             }
             return nlohmann::json::object();
         });
@@ -395,9 +1006,9 @@ struct McpServer::Impl {
         // resources/unsubscribe
         router.on_request("resources/unsubscribe", [this](const nlohmann::json& params) -> HandlerResult {
             std::string uri = params.at("uri").get<std::string>();
-            {
-                std::lock_guard<std::mutex> lock(store_mutex);
-                subscribed_uris.erase(uri);
+            if (Router::current_session()->unsubscribe(uri)) {
+                std::lock_guard<std::mutex> lock(subscriptions_mutex);
+                subscribers.remove(uri, current_session_id());
             }
             return nlohmann::json::object();
         });
@@ -408,38 +1019,23 @@ struct McpServer::Impl {
             if (params.contains("cursor") && !params.at("cursor").is_null()) {
                 cursor = params.at("cursor").get<std::string>();
             }
-            std::lock_guard<std::mutex> lock(store_mutex);
-            auto [items, next] = prompts.page(cursor);
-            nlohmann::json result = {{"prompts", items}};
-            if (next) result["nextCursor"] = *next;
-            return result;
+            return prompts.load()->write_page("prompts", cursor);
         });
 
         // prompts/get
         router.on_request("prompts/get", [this](const nlohmann::json& params) -> HandlerResult {
+            static const nlohmann::json kNoArguments = nlohmann::json::object();
             std::string name = params.at("name").get<std::string>();
-            nlohmann::json arguments = params.value("arguments", nlohmann::json::object());
-
-            // Copy handler under lock to avoid dangling pointer if
-            // remove_prompt() is called concurrently.
-            PromptGetHandler handler;
-            {
-                std::lock_guard<std::mutex> lock(store_mutex);
-                auto it = prompt_handlers.find(name);
-                if (it != prompt_handlers.end()) {
-                    handler = it->second;
-                }
-            }
+            auto it = params.find("arguments");
+            const nlohmann::json& arguments = it != params.end() ? *it : kNoArguments;
 
+            auto handler = prompts.load()->find(name);
             if (!handler) {
                 return JsonRpcError{error::InvalidParams, "Unknown prompt: " + name, std::nullopt};
             }
 
             try {
-                auto result = handler(name, arguments);
-                nlohmann::json j;
-                to_json(j, result);
-                return j;
+                return write_result((*handler)(name, arguments));
             } catch (const std::exception& e) {
                 return JsonRpcError{error::InternalError, e.what(), std::nullopt};
             }
@@ -469,97 +1065,292 @@ struct McpServer::Impl {
         router.on_request("logging/setLevel", [this](const nlohmann::json& params) -> HandlerResult {
             LogLevel level;
             from_json(params.at("level"), level);
-            min_log_level = level;
+            Router::current_session()->set_log_level(level);
+            update_log_floor();
             return nlohmann::json::object();
         });
 
         // notifications/cancelled
         router.on_notification("notifications/cancelled", [this](const nlohmann::json& params) {
-            // Extract the request ID and signal cancellation to the active handler
-            std::string key;
-            if (params.contains("requestId")) {
-                auto& rid = params["requestId"];
-                if (rid.is_number_integer()) key = std::to_string(rid.get<int64_t>());
-                else if (rid.is_string()) key = rid.get<std::string>();
-            }
-            if (!key.empty()) {
+            auto rid = params.find("requestId");
+            if (rid == params.end() || !(rid->is_number_integer() || rid->is_string())) return;
+            RequestId id;
+            from_json(*rid, id);
+            CancellationToken token = CancellationToken::none();
+            {
                 std::lock_guard<std::mutex> lock(active_mutex);
-                auto it = active_requests.find(key);
-                if (it != active_requests.end()) {
-                    it->second.cancel();
-                }
+                auto it = active_requests.find(request_key(current_session_id(), id));
+                if (it == active_requests.end()) return;  // finished, or never pooled
+                token = it->second.token;
             }
+            // Callbacks may send messages; never run them under the lock
+            token.cancel();
         });
 
         // Handle incoming responses (server<-client responses to server->client requests)
         // These come in as JsonRpcResponse objects through the message handler
     }
 
-    void on_message(JsonRpcMessage msg) {
+    void on_message(const std::string& session_id, JsonRpcMessage msg) {
         // Handle responses to our outbound requests
         if (auto* resp = std::get_if<JsonRpcResponse>(&msg)) {
             handle_response(*resp);
             return;
         }
 
-        // Dispatch through router
-        auto response = router.dispatch(msg);
-        if (response) {
-            send_message(*response);
+        auto session = session_for(session_id);
+        if (!dispatch_async || is_fast_path(msg)) {
+            dispatch_and_reply(*session, std::move(msg));
+            return;
         }
+
+        // Hand the request to the pool; the response is sent when the
+        // handler finishes and is matched to the request by id. Until then
+        // notifications/cancelled reaches it through its token.
+        std::string key = request_key(session_id, std::get<JsonRpcRequest>(msg).id);
+        CancellationToken token;
+        uint64_t serial = begin_request(key, token);
+        dispatch_to_pool([this, session = std::move(session), m = std::move(msg),
+                          key = std::move(key), token, serial]() mutable {
+            if (token.is_cancelled()) {
+                // Cancelled while queued: dropped unrun and, as MCP asks of
+                // the receiver of notifications/cancelled, left unanswered
+                end_request(key, serial);
+                return;
+            }
+            // The reply doesn't hold the token: callbacks registered on it
+            // may hold the reply
+            detail::CancellationScope scope(std::move(token));
+            router.dispatch(std::move(m), [this, key = std::move(key), serial](JsonRpcMessage response) {
+                end_request(key, serial);
+                reply(response);
+            }, session.get());
+        });
     }
 
-    void handle_response(const JsonRpcResponse& resp) {
-        std::lock_guard<std::mutex> lock(pending_mutex);
-        // Convert ID to string key
-        std::string key;
-        if (auto* i = std::get_if<int64_t>(&resp.id)) {
-            key = std::to_string(*i);
-        } else if (auto* s = std::get_if<std::string>(&resp.id)) {
-            key = *s;
+    // Messages handled on the reader thread even in concurrent mode:
+    // notifications (cheap, and ordering matters for lifecycle/cancel),
+    // ping, and initialize.
+    static bool is_fast_path(const JsonRpcMessage& msg) {
+        const auto* req = std::get_if<JsonRpcRequest>(&msg);
+        if (!req) return true;
+        return req->method == "ping" || req->method == "initialize";
+    }
+
+    // Takes the message by value so its params move through the router
+    void dispatch_and_reply(Session& session, JsonRpcMessage msg) {
+        if (!dispatch_async) {
+            // The transport needs the reply before the callback returns.
+            auto response = router.dispatch(std::move(msg), &session);
+            if (response) reply(*response);
+            return;
         }
-        auto it = pending_responses.find(key);
-        if (it != pending_responses.end()) {
-            it->second.set_value(resp);
-            pending_responses.erase(it);
+        router.dispatch(std::move(msg), [this](JsonRpcMessage response) { reply(response); },
+                        &session);
+    }
+
+    void reply(const JsonRpcMessage& response) {
+        try {
+            send_message(response);
+        } catch (const std::exception&) {
+            // Transport went away while the handler was running
         }
     }
 
-    JsonRpcResponse send_request_sync(const std::string& method, nlohmann::json params,
-                                       std::chrono::milliseconds timeout) {
+    void handle_response(const JsonRpcResponse& resp) {
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        auto pending = pending_responses.take(resp.id);
+        lock.unlock();
+        if (!pending) return;
+        release(*pending);
+        // Callbacks may resume coroutines inline; never run them under the lock
+        pending->callback(resp);
+    }
+
+    // Send a server->client request; `on_response` runs on the thread that
+    // delivers the response, or with a RequestTimeout error once `timeout`
+    // passes. Returns the id used. Made from a handler, it goes to that
+    // handler's session only.
+    int64_t send_request_async(const std::string& method, nlohmann::json params,
+                               ResponseCallback on_response, std::chrono::milliseconds timeout) {
         int64_t id;
-        std::future<JsonRpcResponse> fut;
+        std::string session = current_session_id();
         {
             std::lock_guard<std::mutex> lock(pending_mutex);
             id = next_outbound_id++;
-            auto& p = pending_responses[std::to_string(id)];
-            fut = p.get_future();
+            auto timer = timers.schedule(timeout,
+                                         [this, id, method] { expire(RequestId{id}, method); });
+            pending_responses.insert(RequestId{id}, Pending{std::move(on_response), timer, session});
         }
 
         JsonRpcRequest req;
         req.id = RequestId{id};
         req.method = method;
         req.params = std::move(params);
-        send_message(req);
+        try {
+            std::lock_guard<std::mutex> lock(transport_mutex);
+            if (!transport) throw McpTransportError("Server is not serving");
+            if (session.empty()) {
+                transport->send(req);
+            } else {
+                transport->send_to_session(session, req);
+            }
+        } catch (...) {
+            std::optional<Pending> pending;
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex);
+                pending = pending_responses.take(RequestId{id});
+            }
+            if (pending) release(*pending);
+            throw;
+        }
+        link_upstream(id, method);
+        return id;
+    }
 
-        if (fut.wait_for(timeout) == std::future_status::timeout) {
+    // Stops whatever would still complete a request taken from the table
+    void release(const Pending& p) {
+        timers.cancel(p.timer);
+        p.upstream.remove_on_cancel(p.upstream_callback);
+    }
+
+    // A request made from a handler is cancelled with the request the
+    // handler serves. Linked once sent, so the cancellation follows it.
+    void link_upstream(int64_t id, const std::string& method) {
+        auto token = CancellationToken::current();
+        if (!token.cancellable()) return;
+        uint64_t callback = token.on_cancel([this, id, method] {
+            abandon(RequestId{id}, "Cancelled upstream",
+                    JsonRpcError{error::RequestCancelled, "Request cancelled: " + method, std::nullopt});
+        });
+        if (callback == 0) return;
+        {
             std::lock_guard<std::mutex> lock(pending_mutex);
-            pending_responses.erase(std::to_string(id));
-            throw McpTimeoutError("Request timed out: " + method);
+            if (auto* p = pending_responses.find(RequestId{id})) {
+                p->upstream = std::move(token);
+                p->upstream_callback = callback;
+                return;
+            }
+        }
+        token.remove_on_cancel(callback);  // answered already
+    }
+
+    // Timer callback: fails a request the client never answered and tells
+    // the client to drop it.
+    void expire(const RequestId& id, const std::string& method) {
+        abandon(id, "Request timed out",
+                JsonRpcError{error::RequestTimeout, "Request timed out: " + method, std::nullopt});
+    }
+
+    // Fails a pending request with `err` and tells the client to stop it
+    void abandon(const RequestId& id, const std::string& reason, JsonRpcError err) {
+        std::optional<Pending> pending;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending = pending_responses.take(id);
+        }
+        if (!pending) return;  // answered meanwhile
+        release(*pending);
+
+        JsonRpcNotification cancel;
+        cancel.method = "notifications/cancelled";
+        cancel.params = nlohmann::json::object();
+        std::visit([&cancel](const auto& v) { (*cancel.params)["requestId"] = v; }, id);
+        (*cancel.params)["reason"] = reason;
+        try {
+            send_to(pending->session, cancel);
+        } catch (...) {}
+
+        JsonRpcResponse resp;
+        resp.id = id;
+        resp.error = std::move(err);
+        try { pending->callback(std::move(resp)); } catch (...) {}
+    }
+
+    // Complete every outstanding server->client request with an error, so
+    // awaiting coroutines and blocked callers wake up when the transport ends.
+    void fail_pending_requests(const std::string& reason) {
+        std::vector<Pending> pending;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending = pending_responses.take_all();
+        }
+        for (auto& p : pending) {
+            release(p);
+            JsonRpcResponse resp;
+            resp.error = JsonRpcError{error::InternalError, reason, std::nullopt};
+            try { p.callback(std::move(resp)); } catch (...) {}
+        }
+    }
+
+    // Issue a request whose result is parsed by `parse` into an Async<T>;
+    // awaiting coroutines resume on the request executor.
+    template<typename T, typename Parse>
+    Async<T> request_async(const std::string& method, nlohmann::json params, Parse parse) {
+        AsyncPromise<T> promise(executor);
+        auto result = promise.get_async();
+        try {
+            int64_t id = send_request_async(method, std::move(params),
+                [promise, parse](JsonRpcResponse resp) {
+                    try {
+                        if (resp.error) {
+                            if (resp.error->code == error::RequestTimeout) {
+                                throw McpTimeoutError(resp.error->message);
+                            }
+                            throw McpProtocolError(resp.error->code, resp.error->message);
+                        }
+                        promise.set_value(parse(resp.result.value_or(nlohmann::json::object())));
+                    } catch (...) {
+                        promise.set_exception(std::current_exception());
+                    }
+                }, opts.request_timeout);
+            // Pending requests are all completed when serving ends
+            promise.on_cancel([this, id, method] {
+                abandon(RequestId{id}, "Cancelled by the server",
+                        JsonRpcError{error::RequestCancelled, "Request cancelled: " + method,
+                                     std::nullopt});
+            });
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+        return result;
+    }
+
+    JsonRpcResponse send_request_sync(const std::string& method, nlohmann::json params,
+                                       std::chrono::milliseconds timeout) {
+        auto p = std::make_shared<std::promise<JsonRpcResponse>>();
+        auto fut = p->get_future();
+        send_request_async(method, std::move(params),
+            [p](JsonRpcResponse resp) { p->set_value(std::move(resp)); }, timeout);
+
+        // The timer wheel completes the request if the client never does
+        auto resp = fut.get();
+        if (resp.error && resp.error->code == error::RequestTimeout) {
+            throw McpTimeoutError(resp.error->message);
         }
-        return fut.get();
+        return resp;
     }
 };
 
+// ----------- ToolResponder -----------
+
+void ToolResponder::operator()(const CallToolResult& result) const {
+    respond_(checked_result(output_schema_.get(), result));
+}
+
+void ToolResponder::fail(const std::string& message) const {
+    respond_(tool_error_result(message));
+}
+
 // ----------- McpServer -----------
 
 McpServer::McpServer(Options opts)
     : impl_(std::make_unique<Impl>(std::move(opts))) {
-    impl_->tools.page_size = impl_->opts.page_size;
-    impl_->resources.page_size = impl_->opts.page_size;
-    impl_->resource_templates.page_size = impl_->opts.page_size;
-    impl_->prompts.page_size = impl_->opts.page_size;
-    impl_->session.set_request_timeout(impl_->opts.request_timeout);
+    size_t page_size = impl_->opts.page_size;
+    impl_->tools.update([&](auto& r) { r.page_size = page_size; });
+    impl_->resources.update([&](auto& r) { r.page_size = page_size; });
+    impl_->resource_templates.update([&](auto& r) { r.page_size = page_size; });
+    impl_->prompts.update([&](auto& r) { r.page_size = page_size; });
     impl_->setup_handlers();
 }
 
@@ -570,54 +1361,58 @@ McpServer::~McpServer() {
 }
 
 void McpServer::add_tool(ToolDefinition def, ToolHandler handler) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    // Remove existing tool with same name
-    auto& items = impl_->tools.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&def](const ToolDefinition& t) { return t.name == def.name; }), items.end());
-    impl_->tool_handlers[def.name] = std::move(handler);
-    items.push_back(std::move(def));
-
-    // Notify if running
-    if (impl_->running) {
-        impl_->send_notification("notifications/tools/list_changed");
-    }
+    ToolEntry entry;
+    entry.sync = std::move(handler);
+    impl_->put_tool(std::move(def), std::move(entry));
 }
 
 void McpServer::add_tool(ToolDefinition def, CancellableToolHandler handler) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->tools.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&def](const ToolDefinition& t) { return t.name == def.name; }), items.end());
-    impl_->cancellable_tool_handlers[def.name] = std::move(handler);
-    items.push_back(std::move(def));
+    ToolEntry entry;
+    entry.cancellable = std::move(handler);
+    impl_->put_tool(std::move(def), std::move(entry));
+}
 
-    if (impl_->running) {
-        impl_->send_notification("notifications/tools/list_changed");
-    }
+void McpServer::add_tool_raw(ToolDefinition def, RawToolHandler handler) {
+    ToolEntry entry;
+    entry.raw = std::move(handler);
+    impl_->has_raw_tools = true;
+    impl_->put_tool(std::move(def), std::move(entry));
 }
 
 void McpServer::add_tool_async(ToolDefinition def, AsyncToolHandler handler) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->tools.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&def](const ToolDefinition& t) { return t.name == def.name; }), items.end());
-    impl_->async_tool_handlers[def.name] = std::move(handler);
-    items.push_back(std::move(def));
+    ToolEntry entry;
+    entry.async = std::move(handler);
+    impl_->put_tool(std::move(def), std::move(entry));
+}
 
-    if (impl_->running) {
-        impl_->send_notification("notifications/tools/list_changed");
-    }
+void McpServer::add_tool_async(ToolDefinition def, CallbackToolHandler handler) {
+    ToolEntry entry;
+    entry.callback = std::move(handler);
+    impl_->put_tool(std::move(def), std::move(entry));
+}
+
+void McpServer::add_tool_async(ToolDefinition def, CoroutineToolHandler handler) {
+    ToolEntry entry;
+    entry.coroutine = std::move(handler);
+    impl_->put_tool(std::move(def), std::move(entry));
+}
+
+void McpServer::set_tool_validation(const std::string& name, bool enabled) {
+    impl_->tools.update([&](auto& r) {
+        auto def = r.items.find_def(name);
+        auto entry = r.items.find(name);
+        if (def && entry) {
+            ToolEntry updated = *entry;
+            updated.schemas = enabled ? compile_schemas(*def) : nullptr;
+            r.items.replace_handler(name, std::move(updated));
+        }
+        std::lock_guard<std::mutex> lock(impl_->validation_mutex);
+        impl_->validation_overrides[name] = enabled;
+    });
 }
 
 void McpServer::remove_tool(const std::string& name) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->tools.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&name](const ToolDefinition& t) { return t.name == name; }), items.end());
-    impl_->tool_handlers.erase(name);
-    impl_->cancellable_tool_handlers.erase(name);
-    impl_->async_tool_handlers.erase(name);
+    impl_->tools.update([&](auto& r) { r.erase(name); });
 
     if (impl_->running) {
         impl_->send_notification("notifications/tools/list_changed");
@@ -625,12 +1420,23 @@ void McpServer::remove_tool(const std::string& name) {
 }
 
 void McpServer::add_resource(ResourceDefinition def, ResourceReadHandler handler) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->resources.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&def](const ResourceDefinition& r) { return r.uri == def.uri; }), items.end());
-    impl_->resource_handlers[def.uri] = std::move(handler);
-    items.push_back(std::move(def));
+    std::string uri = def.uri;
+    ResourceEntry entry;
+    entry.read = std::move(handler);
+    impl_->resources.update([&](auto& r) { r.put(std::move(def), std::move(entry)); });
+    impl_->resource_cache.invalidate(uri);
+
+    if (impl_->running) {
+        impl_->send_notification("notifications/resources/list_changed");
+    }
+}
+
+void McpServer::add_resource_stream(ResourceDefinition def, ResourceStreamHandler handler) {
+    std::string uri = def.uri;
+    ResourceEntry entry;
+    entry.stream = std::move(handler);
+    impl_->resources.update([&](auto& r) { r.put(std::move(def), std::move(entry)); });
+    impl_->resource_cache.invalidate(uri);
 
     if (impl_->running) {
         impl_->send_notification("notifications/resources/list_changed");
@@ -638,32 +1444,51 @@ void McpServer::add_resource(ResourceDefinition def, ResourceReadHandler handler
 }
 
 void McpServer::add_resource_template(ResourceTemplate tmpl, ResourceReadHandler handler) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->resource_templates.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&tmpl](const ResourceTemplate& t) { return t.uri_template == tmpl.uri_template; }), items.end());
-    impl_->resource_template_handlers[tmpl.uri_template] = std::move(handler);
-    items.push_back(std::move(tmpl));
+    UriTemplateMatcher::validate(tmpl.uri_template);
+    TemplateEntry entry;
+    entry.read = std::move(handler);
+    impl_->resource_templates.update([&](auto& r) { r.put(std::move(tmpl), std::move(entry)); });
+    impl_->resource_cache.clear();  // may take over URIs read before
+}
+
+void McpServer::add_resource_template(ResourceTemplate tmpl, ResourceTemplateHandler handler) {
+    UriTemplateMatcher::validate(tmpl.uri_template);
+    TemplateEntry entry;
+    entry.read_with_vars = std::move(handler);
+    impl_->resource_templates.update([&](auto& r) { r.put(std::move(tmpl), std::move(entry)); });
+    impl_->resource_cache.clear();
 }
 
 void McpServer::notify_resource_updated(const std::string& uri) {
-    bool subscribed = false;
-    {
-        std::lock_guard<std::mutex> lock(impl_->store_mutex);
-        subscribed = impl_->subscribed_uris.count(uri) > 0;
-    }
-    if (subscribed && impl_->running) {
-        impl_->send_notification("notifications/resources/updated",
-            nlohmann::json{{"uri", uri}});
+    notify_resources_updated(std::span<const std::string>(&uri, 1));
+}
+
+void McpServer::notify_resources_updated(std::span<const std::string> uris) {
+    for (const auto& uri : uris) impl_->resource_cache.invalidate(uri);
+    if (impl_->opts.resource_update_window.count() <= 0) {
+        std::set<std::string> batch(uris.begin(), uris.end());
+        impl_->fan_out_updates(batch);
+        return;
     }
+    // Hold them until the window ends; repeats within it are sent once
+    std::lock_guard<std::mutex> lock(impl_->updates_mutex);
+    impl_->pending_updates.insert(uris.begin(), uris.end());
+    if (impl_->update_flush_scheduled || impl_->pending_updates.empty()) return;
+    impl_->update_flush_scheduled = true;
+    impl_->timers.schedule(impl_->opts.resource_update_window, [impl = impl_.get()] {
+        std::set<std::string> batch;
+        {
+            std::lock_guard<std::mutex> lock(impl->updates_mutex);
+            batch.swap(impl->pending_updates);
+            impl->update_flush_scheduled = false;
+        }
+        impl->fan_out_updates(batch);
+    });
 }
 
 void McpServer::remove_resource(const std::string& uri) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->resources.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&uri](const ResourceDefinition& r) { return r.uri == uri; }), items.end());
-    impl_->resource_handlers.erase(uri);
+    impl_->resources.update([&](auto& r) { r.erase(uri); });
+    impl_->resource_cache.invalidate(uri);
 
     if (impl_->running) {
         impl_->send_notification("notifications/resources/list_changed");
@@ -671,12 +1496,7 @@ void McpServer::remove_resource(const std::string& uri) {
 }
 
 void McpServer::add_prompt(PromptDefinition def, PromptGetHandler handler) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->prompts.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&def](const PromptDefinition& p) { return p.name == def.name; }), items.end());
-    impl_->prompt_handlers[def.name] = std::move(handler);
-    items.push_back(std::move(def));
+    impl_->prompts.update([&](auto& r) { r.put(std::move(def), std::move(handler)); });
 
     if (impl_->running) {
         impl_->send_notification("notifications/prompts/list_changed");
@@ -684,11 +1504,7 @@ void McpServer::add_prompt(PromptDefinition def, PromptGetHandler handler) {
 }
 
 void McpServer::remove_prompt(const std::string& name) {
-    std::lock_guard<std::mutex> lock(impl_->store_mutex);
-    auto& items = impl_->prompts.items;
-    items.erase(std::remove_if(items.begin(), items.end(),
-        [&name](const PromptDefinition& p) { return p.name == name; }), items.end());
-    impl_->prompt_handlers.erase(name);
+    impl_->prompts.update([&](auto& r) { r.erase(name); });
 
     if (impl_->running) {
         impl_->send_notification("notifications/prompts/list_changed");
@@ -699,16 +1515,39 @@ void McpServer::set_completion_handler(CompletionHandler handler) {
     impl_->completion_handler = std::move(handler);
 }
 
-void McpServer::log(LogLevel level, const std::string& logger, const nlohmann::json& data) {
-    if (level < impl_->min_log_level.load()) return;
-    if (!impl_->running) return;
+bool McpServer::log_enabled(LogLevel level) const noexcept {
+    return level >= impl_->min_log_level.load() && impl_->running;
+}
+
+bool McpServer::admit_log(LogLevel level, const std::string& logger) {
+    if (!log_enabled(level)) return false;
+    if (impl_->opts.max_log_rate <= 0) return true;
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(impl_->log_rate_mutex);
+    auto& limits = impl_->log_next_allowed;
+    if (limits.size() >= impl_->log_sweep_at) {
+        // An expired entry admits like a missing one; sweeping at twice the
+        // live size keeps this amortized O(1) per message
+        std::erase_if(limits, [now](const auto& kv) { return kv.second <= now; });
+        impl_->log_sweep_at = std::max<size_t>(1024, limits.size() * 2);
+    }
+    auto& next = limits[logger];
+    if (now < next) return false;
+    next = now + rate_interval(impl_->opts.max_log_rate);
+    return true;
+}
 
+void McpServer::send_log(LogLevel level, const std::string& logger, const nlohmann::json& data) {
     nlohmann::json params = {
         {"level", level},
         {"logger", logger},
         {"data", data}
     };
-    impl_->send_notification("notifications/message", params);
+    impl_->send_log(level, std::move(params));
+}
+
+void McpServer::log(LogLevel level, const std::string& logger, const nlohmann::json& data) {
+    if (admit_log(level, logger)) send_log(level, logger, data);
 }
 
 void McpServer::send_progress(const std::variant<int64_t, std::string>& token,
@@ -720,9 +1559,33 @@ void McpServer::send_progress(const std::variant<int64_t, std::string>& token,
     params["progress"] = progress;
     if (total) params["total"] = *total;
     if (message) params["message"] = *message;
+    if (impl_->progress_throttle) {
+        impl_->progress_throttle->submit(progress_key(params["progressToken"]), std::move(params));
+        return;
+    }
     impl_->send_notification("notifications/progress", params);
 }
 
+static SamplingResult parse_sampling_result(const nlohmann::json& j) {
+    SamplingResult result;
+    from_json(j, result);
+    return result;
+}
+
+static ElicitationResult parse_elicitation_result(const nlohmann::json& j) {
+    ElicitationResult result;
+    from_json(j, result);
+    return result;
+}
+
+static std::vector<Root> parse_roots(const nlohmann::json& j) {
+    std::vector<Root> roots;
+    if (j.contains("roots")) {
+        roots = j.at("roots").get<std::vector<Root>>();
+    }
+    return roots;
+}
+
 SamplingResult McpServer::request_sampling(const SamplingRequest& req) {
     nlohmann::json params;
     to_json(params, req);
@@ -736,10 +1599,11 @@ SamplingResult McpServer::request_sampling(const SamplingRequest& req) {
     return result;
 }
 
-std::future<SamplingResult> McpServer::request_sampling_async(const SamplingRequest& req) {
-    return std::async(std::launch::async, [this, req]() {
-        return request_sampling(req);
-    });
+Async<SamplingResult> McpServer::request_sampling_async(const SamplingRequest& req) {
+    nlohmann::json params;
+    to_json(params, req);
+    return impl_->request_async<SamplingResult>("sampling/createMessage", std::move(params),
+                                                parse_sampling_result);
 }
 
 ElicitationResult McpServer::request_elicitation(const ElicitationRequest& req) {
@@ -755,6 +1619,13 @@ ElicitationResult McpServer::request_elicitation(const ElicitationRequest& req)
     return result;
 }
 
+Async<ElicitationResult> McpServer::request_elicitation_async(const ElicitationRequest& req) {
+    nlohmann::json params;
+    to_json(params, req);
+    return impl_->request_async<ElicitationResult>("elicitation/create", std::move(params),
+                                                   parse_elicitation_result);
+}
+
 std::vector<Root> McpServer::request_roots() {
     auto resp = impl_->send_request_sync("roots/list", nlohmann::json::object(), impl_->opts.request_timeout);
     if (resp.error) {
@@ -767,19 +1638,51 @@ std::vector<Root> McpServer::request_roots() {
     return roots;
 }
 
+Async<std::vector<Root>> McpServer::request_roots_async() {
+    return impl_->request_async<std::vector<Root>>("roots/list", nlohmann::json::object(),
+                                                   parse_roots);
+}
+
 void McpServer::serve(std::unique_ptr<ITransport> transport) {
     impl_->running = true;
-    impl_->start_thread_pool();
 
     auto* t = transport.get();
-    impl_->transport = t;
+    impl_->dispatch_async = (impl_->opts.executor || impl_->opts.thread_pool_size > 0)
+        && t->supports_async_responses();
+    if (impl_->dispatch_async) impl_->start_thread_pool();
+    {
+        std::lock_guard<std::mutex> lock(impl_->transport_mutex);
+        impl_->transport = t;
+    }
 
-    t->start([this](JsonRpcMessage msg) {
-        impl_->on_message(std::move(msg));
-    });
+    t->start_sessions(
+        [this](const std::string& session, JsonRpcMessage msg) {
+            impl_->on_message(session, std::move(msg));
+        },
+        nullptr,
+        [this](const std::string& session) { impl_->close_session(session); });
 
     impl_->running = false;
-    impl_->transport = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(impl_->transport_mutex);
+        impl_->transport = nullptr;
+    }
+    impl_->fail_pending_requests("Transport closed");
+    // Its sessions end with it
+    {
+        std::lock_guard<std::mutex> lock(impl_->sessions_mutex);
+        impl_->sessions.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(impl_->subscriptions_mutex);
+        impl_->subscribers.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(impl_->updates_mutex);
+        impl_->pending_updates.clear();
+    }
+    impl_->update_log_floor();
+    // Drain queued requests; their responses are dropped with the transport gone.
     impl_->stop_thread_pool();
 }
 
@@ -794,6 +1697,16 @@ void McpServer::serve_http(const std::string& host, uint16_t port) {
     serve(std::make_unique<HttpServerTransport>(opts));
 }
 
+void McpServer::serve_shm() {
+    const char* fd = std::getenv(ShmTransport::kFdEnv);
+    if (!fd || !*fd) {
+        throw McpTransportError(std::string(ShmTransport::kFdEnv) + " is not set");
+    }
+    int socket_fd = std::atoi(fd);
+    ::unsetenv(ShmTransport::kFdEnv);  // not for our own children
+    serve(std::make_unique<ShmTransport>(socket_fd, ShmTransport::Role::Attach));
+}
+
 void McpServer::shutdown() {
     impl_->running = false;
     std::lock_guard<std::mutex> lock(impl_->transport_mutex);
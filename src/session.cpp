@@ -30,41 +30,23 @@ RequestId Session::register_request(const std::string& method,
     req.method = method;
     req.created_at = std::chrono::steady_clock::now();
     req.callback = std::move(cb);
-    pending_requests_int_[id] = std::move(req);
+    pending_requests_.insert(RequestId{id}, std::move(req));
     return RequestId{id};
 }
 
 bool Session::complete_request(const RequestId& id, const JsonRpcResponse& resp) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (auto* int_id = std::get_if<int64_t>(&id)) {
-        auto it = pending_requests_int_.find(*int_id);
-        if (it == pending_requests_int_.end()) return false;
-        if (it->second.callback) it->second.callback(resp);
-        pending_requests_int_.erase(it);
-        return true;
-    } else if (auto* str_id = std::get_if<std::string>(&id)) {
-        auto it = pending_requests_str_.find(*str_id);
-        if (it == pending_requests_str_.end()) return false;
-        if (it->second.callback) it->second.callback(resp);
-        pending_requests_str_.erase(it);
-        return true;
-    }
-    return false;
+    auto req = pending_requests_.take(id);
+    if (!req) return false;
+    if (req->callback) req->callback(resp);
+    return true;
 }
 
 void Session::register_progress_token(const RequestId& request_id,
                                        const std::variant<int64_t, std::string>& token) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (auto* int_id = std::get_if<int64_t>(&request_id)) {
-        auto it = pending_requests_int_.find(*int_id);
-        if (it != pending_requests_int_.end()) {
-            it->second.progress_token = token;
-        }
-    } else if (auto* str_id = std::get_if<std::string>(&request_id)) {
-        auto it = pending_requests_str_.find(*str_id);
-        if (it != pending_requests_str_.end()) {
-            it->second.progress_token = token;
-        }
+    if (auto* req = pending_requests_.find(request_id)) {
+        req->progress_token = token;
     }
 }
 
@@ -78,22 +60,11 @@ std::vector<RequestId> Session::check_timeouts() {
     auto now = std::chrono::steady_clock::now();
     std::vector<RequestId> timed_out;
 
-    for (auto it = pending_requests_int_.begin(); it != pending_requests_int_.end(); ) {
-        if (now - it->second.created_at > request_timeout_) {
-            timed_out.push_back(RequestId{it->first});
-            it = pending_requests_int_.erase(it);
-        } else {
-            ++it;
-        }
-    }
-    for (auto it = pending_requests_str_.begin(); it != pending_requests_str_.end(); ) {
-        if (now - it->second.created_at > request_timeout_) {
-            timed_out.push_back(RequestId{it->first});
-            it = pending_requests_str_.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    pending_requests_.erase_if([&](const RequestId& id, const PendingRequest& req) {
+        if (now - req.created_at <= request_timeout_) return false;
+        timed_out.push_back(id);
+        return true;
+    });
     return timed_out;
 }
 
@@ -139,12 +110,37 @@ const std::optional<std::string>& Session::session_id() const {
 
 bool Session::has_pending_request(const RequestId& id) const {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (auto* int_id = std::get_if<int64_t>(&id)) {
-        return pending_requests_int_.count(*int_id) > 0;
-    } else if (auto* str_id = std::get_if<std::string>(&id)) {
-        return pending_requests_str_.count(*str_id) > 0;
-    }
-    return false;
+    return pending_requests_.contains(id);
+}
+
+bool Session::subscribe(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriptions_.insert(uri).second;
+}
+
+bool Session::unsubscribe(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriptions_.erase(uri) > 0;
+}
+
+bool Session::is_subscribed(const std::string& uri) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriptions_.count(uri) > 0;
+}
+
+std::vector<std::string> Session::subscriptions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {subscriptions_.begin(), subscriptions_.end()};
+}
+
+LogLevel Session::log_level() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return log_level_;
+}
+
+void Session::set_log_level(LogLevel level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_level_ = level;
 }
 
 } // namespace mcp
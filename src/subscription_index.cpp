@@ -0,0 +1,91 @@
+#include "mcp/subscription_index.hpp"
+#include <algorithm>
+
+namespace mcp {
+
+SubscriptionIndex::SubscriptionIndex() : root_(std::make_unique<Node>()) {}
+SubscriptionIndex::~SubscriptionIndex() = default;
+SubscriptionIndex::SubscriptionIndex(SubscriptionIndex&&) noexcept = default;
+SubscriptionIndex& SubscriptionIndex::operator=(SubscriptionIndex&&) noexcept = default;
+
+bool SubscriptionIndex::add(std::string_view pattern, const std::string& subscriber) {
+    if (!is_prefix(pattern)) {
+        return exact_[std::string(pattern)].insert(subscriber).second;
+    }
+    pattern.remove_suffix(1);
+    Node* node = root_.get();
+    for (char c : pattern) {
+        auto& child = node->children[c];
+        if (!child) child = std::make_unique<Node>();
+        node = child.get();
+    }
+    if (!node->subscribers.insert(subscriber).second) return false;
+    ++prefixes_;
+    return true;
+}
+
+bool SubscriptionIndex::remove(std::string_view pattern, const std::string& subscriber) {
+    if (!is_prefix(pattern)) {
+        auto it = exact_.find(std::string(pattern));
+        if (it == exact_.end() || it->second.erase(subscriber) == 0) return false;
+        if (it->second.empty()) exact_.erase(it);
+        return true;
+    }
+    pattern.remove_suffix(1);
+    // Remember the path so nodes left empty can be pruned on the way back
+    std::vector<Node*> path{root_.get()};
+    for (char c : pattern) {
+        auto it = path.back()->children.find(c);
+        if (it == path.back()->children.end()) return false;
+        path.push_back(it->second.get());
+    }
+    if (path.back()->subscribers.erase(subscriber) == 0) return false;
+    --prefixes_;
+    for (size_t depth = pattern.size(); depth > 0; --depth) {
+        const Node* node = path[depth];
+        if (!node->subscribers.empty() || !node->children.empty()) break;
+        path[depth - 1]->children.erase(pattern[depth - 1]);
+    }
+    return true;
+}
+
+void SubscriptionIndex::collect(std::string_view uri, std::vector<const std::string*>& out) const {
+    if (!exact_.empty()) {
+        if (auto it = exact_.find(std::string(uri)); it != exact_.end()) {
+            for (const auto& s : it->second) out.push_back(&s);
+        }
+    }
+    if (prefixes_ == 0) return;
+    // Every node on the URI's path is a prefix of it
+    const Node* node = root_.get();
+    for (size_t i = 0;; ++i) {
+        for (const auto& s : node->subscribers) out.push_back(&s);
+        if (i == uri.size()) break;
+        auto it = node->children.find(uri[i]);
+        if (it == node->children.end()) break;
+        node = it->second.get();
+    }
+}
+
+std::vector<std::string> SubscriptionIndex::match(std::string_view uri) const {
+    std::vector<const std::string*> found;
+    collect(uri, found);
+    std::vector<std::string> out;
+    out.reserve(found.size());
+    for (const auto* s : found) out.push_back(*s);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+bool SubscriptionIndex::empty() const noexcept {
+    return exact_.empty() && prefixes_ == 0;
+}
+
+void SubscriptionIndex::clear() {
+    exact_.clear();
+    root_ = std::make_unique<Node>();
+    prefixes_ = 0;
+}
+
+} // namespace mcp
@@ -0,0 +1,179 @@
+#include "mcp/timer_wheel.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace mcp {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds resolution)
+    : resolution_(resolution.count() > 0 ? resolution : std::chrono::milliseconds(1)),
+      epoch_(Clock::now()) {
+    for (auto& level : wheel_) level.fill(kNil);
+}
+
+TimerWheel::~TimerWheel() {
+    stop();
+}
+
+uint64_t TimerWheel::ticks_since_epoch(Clock::time_point t) const {
+    if (t <= epoch_) return 0;
+    return static_cast<uint64_t>((t - epoch_) / resolution_);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(std::chrono::milliseconds delay, Task fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    // An idle wheel skips ahead; otherwise the driver keeps now_ current
+    uint64_t base = std::max(now_, ticks_since_epoch(Clock::now()));
+    if (pending_ == 0) now_ = base;
+    Node& n = nodes_[index];
+    n.fn = std::move(fn);
+    // Round up, and never fire on the tick already processed
+    auto ticks = (delay + resolution_ - std::chrono::milliseconds(1)) / resolution_;
+    n.expiry = base + static_cast<uint64_t>(ticks > 0 ? ticks : 1);
+    place(index);
+    if (pending_++ == 0) cv_.notify_one();
+    return (static_cast<uint64_t>(n.generation) << 32 | index) + 1;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    if (id == 0) return false;
+    uint64_t raw = id - 1;
+    auto index = static_cast<uint32_t>(raw & 0xFFFFFFFFu);
+    auto generation = static_cast<uint32_t>(raw >> 32);
+    Task fn;  // destroyed outside the lock
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index >= nodes_.size()) return false;
+        Node& n = nodes_[index];
+        if (n.generation != generation || !n.slot) return false;
+        unlink(index);
+        fn = std::move(n.fn);
+        release(index);
+        --pending_;
+    }
+    return true;
+}
+
+void TimerWheel::place(uint32_t index) {
+    Node& n = nodes_[index];
+    uint64_t expiry = n.expiry < now_ ? now_ : n.expiry;
+    uint64_t delta = expiry - now_;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (uint64_t{1} << (kLevelBits * (level + 1)))) ++level;
+    if (level == kLevels - 1) {
+        // Beyond the wheel's span: park in the farthest slot and re-place
+        // when it comes round
+        uint64_t span = uint64_t{1} << (kLevelBits * kLevels);
+        if (delta >= span) expiry = now_ + span - 1;
+    }
+    uint32_t slot = static_cast<uint32_t>(expiry >> (kLevelBits * level)) & (kSlots - 1);
+    uint32_t& head = wheel_[level][slot];
+    n.slot = &head;
+    n.prev = kNil;
+    n.next = head;
+    if (head != kNil) nodes_[head].prev = index;
+    head = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& n = nodes_[index];
+    if (n.prev != kNil) nodes_[n.prev].next = n.next;
+    else *n.slot = n.next;
+    if (n.next != kNil) nodes_[n.next].prev = n.prev;
+    n.slot = nullptr;
+    n.prev = n.next = kNil;
+}
+
+void TimerWheel::release(uint32_t index) {
+    ++nodes_[index].generation;
+    free_.push_back(index);
+}
+
+void TimerWheel::step(std::vector<Task>& due) {
+    ++now_;
+    // Crossing a boundary of a coarser level pulls its next slot down
+    for (unsigned level = 1; level < kLevels; ++level) {
+        if ((now_ & ((uint64_t{1} << (kLevelBits * level)) - 1)) != 0) break;
+        uint32_t slot = static_cast<uint32_t>(now_ >> (kLevelBits * level)) & (kSlots - 1);
+        uint32_t i = std::exchange(wheel_[level][slot], kNil);
+        while (i != kNil) {
+            uint32_t next = nodes_[i].next;
+            place(i);
+            i = next;
+        }
+    }
+    uint32_t& head = wheel_[0][now_ & (kSlots - 1)];
+    uint32_t i = std::exchange(head, kNil);
+    while (i != kNil) {
+        Node& n = nodes_[i];
+        uint32_t next = n.next;
+        n.slot = nullptr;
+        n.prev = n.next = kNil;
+        if (n.expiry <= now_) {
+            due.push_back(std::move(n.fn));
+            release(i);
+            --pending_;
+        } else {
+            place(i);  // parked past the wheel's span
+        }
+        i = next;
+    }
+}
+
+size_t TimerWheel::advance(Clock::time_point now) {
+    std::vector<Task> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t target = ticks_since_epoch(now);
+        if (pending_ == 0 && target > now_) now_ = target;  // nothing to cascade
+        while (now_ < target) step(due);
+    }
+    for (auto& fn : due) fn();
+    return due.size();
+}
+
+void TimerWheel::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) return;
+    stop_ = false;
+    thread_ = std::thread([this] { run(); });
+}
+
+void TimerWheel::stop() {
+    std::thread t;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        t = std::move(thread_);
+    }
+    cv_.notify_all();
+    if (t.joinable()) t.join();
+}
+
+void TimerWheel::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        auto next_tick = epoch_ + resolution_ * static_cast<int64_t>(now_ + 1);
+        // Sleep until the next tick, or indefinitely while nothing is pending
+        if (pending_ == 0) cv_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        else cv_.wait_until(lock, next_tick, [this] { return stop_; });
+        if (stop_) break;
+        lock.unlock();
+        advance();
+        lock.lock();
+    }
+}
+
+size_t TimerWheel::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+} // namespace mcp
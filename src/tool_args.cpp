@@ -0,0 +1,105 @@
+#include "mcp/tool_args.hpp"
+#include "mcp/arena.hpp"
+#include <simdjson.h>
+#include <cstring>
+
+namespace mcp {
+
+namespace {
+
+simdjson::ondemand::value& as_value(void* impl) {
+    return *static_cast<simdjson::ondemand::value*>(impl);
+}
+
+// A wrong-typed read is the caller's error; anything else is bad text.
+[[noreturn]] void fail(simdjson::error_code err, const char* expected) {
+    switch (err) {
+        case simdjson::INCORRECT_TYPE:
+        case simdjson::NUMBER_ERROR:
+        case simdjson::NUMBER_OUT_OF_RANGE:
+        case simdjson::BIGINT_ERROR:
+            throw McpProtocolError(error::InvalidParams, std::string("expected ") + expected);
+        default:
+            throw McpParseError(std::string("JSON parse error: ") + simdjson::error_message(err));
+    }
+}
+
+template<typename T>
+T get(void* impl, const char* expected) {
+    T out{};
+    if (auto err = as_value(impl).get(out)) fail(err, expected);
+    return out;
+}
+
+// Separate from the codec's parser, so ArgTraits specializations may use
+// the codec while arguments are being bound.
+simdjson::ondemand::parser& args_parser() {
+    thread_local simdjson::ondemand::parser parser;
+    return parser;
+}
+
+} // anonymous namespace
+
+JsonValue::Type JsonValue::type() const {
+    simdjson::ondemand::json_type t;
+    if (auto err = as_value(impl_).type().get(t)) fail(err, "a value");
+    switch (t) {
+        case simdjson::ondemand::json_type::object: return Type::Object;
+        case simdjson::ondemand::json_type::array: return Type::Array;
+        case simdjson::ondemand::json_type::number: return Type::Number;
+        case simdjson::ondemand::json_type::string: return Type::String;
+        case simdjson::ondemand::json_type::boolean: return Type::Bool;
+        default: return Type::Null;
+    }
+}
+
+bool JsonValue::get_bool() const { return get<bool>(impl_, "boolean"); }
+int64_t JsonValue::get_int64() const { return get<int64_t>(impl_, "integer"); }
+uint64_t JsonValue::get_uint64() const { return get<uint64_t>(impl_, "non-negative integer"); }
+double JsonValue::get_double() const { return get<double>(impl_, "number"); }
+std::string_view JsonValue::get_string() const { return get<std::string_view>(impl_, "string"); }
+
+std::string_view JsonValue::raw_json() const {
+    std::string_view out;
+    if (auto err = as_value(impl_).raw_json().get(out)) fail(err, "a value");
+    return out;
+}
+
+void JsonValue::visit_members(MemberFn fn, void* ctx) const {
+    simdjson::ondemand::object obj;
+    if (auto err = as_value(impl_).get_object().get(obj)) fail(err, "object");
+    for (auto field : obj) {
+        std::string_view key;
+        if (auto err = field.unescaped_key().get(key)) fail(err, "object");
+        simdjson::ondemand::value value;
+        if (auto err = field.value().get(value)) fail(err, "a value");
+        fn(ctx, key, JsonValue(&value));
+    }
+}
+
+void JsonValue::visit_elements(ElementFn fn, void* ctx) const {
+    simdjson::ondemand::array arr;
+    if (auto err = as_value(impl_).get_array().get(arr)) fail(err, "array");
+    for (auto element : arr) {
+        simdjson::ondemand::value value;
+        if (auto err = element.get(value)) fail(err, "a value");
+        fn(ctx, JsonValue(&value));
+    }
+}
+
+void JsonValue::visit_document(std::string_view json, ElementFn fn, void* ctx) {
+    ScratchArena::Scope scope;
+    char* buf = scope.arena().allocate_bytes(json.size() + simdjson::SIMDJSON_PADDING);
+    std::memcpy(buf, json.data(), json.size());
+    std::memset(buf + json.size(), 0, simdjson::SIMDJSON_PADDING);
+    simdjson::padded_string_view padded(buf, json.size(), json.size() + simdjson::SIMDJSON_PADDING);
+
+    simdjson::ondemand::document doc;
+    if (auto err = args_parser().iterate(padded).get(doc)) fail(err, "a document");
+    simdjson::ondemand::value root;
+    if (auto err = doc.get_value().get(root)) fail(err, "object");
+    fn(ctx, JsonValue(&root));
+    if (!doc.at_end()) throw McpParseError("Trailing content after JSON arguments");
+}
+
+} // namespace mcp
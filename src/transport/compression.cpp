@@ -0,0 +1,352 @@
+#include "mcp/transport/compression.hpp"
+#include "mcp/error.hpp"
+
+#ifdef MCPXX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <cctype>
+#include <stdexcept>
+
+namespace mcp {
+
+namespace {
+
+constexpr size_t kOutStep = 16 * 1024;
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i]))
+            != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+// Whether an Accept-Encoding element's parameters leave it acceptable,
+// i.e. it has no q=0
+bool acceptable(std::string_view params) {
+    while (!params.empty()) {
+        auto semi = params.find(';');
+        std::string_view param = trim(params.substr(0, semi));
+        params.remove_prefix(semi == std::string_view::npos ? params.size() : semi + 1);
+        if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=') continue;
+        std::string_view value = param.substr(2);
+        // q is at most three decimals: only "0", "0.0", "0.00"... refuse
+        if (value.empty() || value[0] != '0') return true;
+        return value.substr(1).find_first_not_of(".0") != std::string_view::npos;
+    }
+    return true;
+}
+
+void check_available(ContentCoding coding) {
+    if (coding == ContentCoding::Identity || !coding_available(coding)) {
+        throw std::invalid_argument("Content coding not available: " + std::string(to_string(coding)));
+    }
+}
+
+} // anonymous namespace
+
+std::string_view to_string(ContentCoding coding) noexcept {
+    switch (coding) {
+        case ContentCoding::Gzip: return "gzip";
+        case ContentCoding::Zstd: return "zstd";
+        case ContentCoding::Identity: break;
+    }
+    return "identity";
+}
+
+std::optional<ContentCoding> parse_content_coding(std::string_view token) noexcept {
+    token = trim(token);
+    if (iequals(token, "gzip") || iequals(token, "x-gzip")) return ContentCoding::Gzip;
+    if (iequals(token, "zstd")) return ContentCoding::Zstd;
+    if (iequals(token, "identity")) return ContentCoding::Identity;
+    return std::nullopt;
+}
+
+bool coding_available(ContentCoding coding) noexcept {
+    switch (coding) {
+        case ContentCoding::Identity: return true;
+#ifdef MCPXX_HAVE_ZLIB
+        case ContentCoding::Gzip: return true;
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+        case ContentCoding::Zstd: return true;
+#endif
+        default: return false;
+    }
+}
+
+ContentCoding negotiate_coding(std::string_view accept_encoding,
+                               const std::vector<ContentCoding>& preferred) {
+    bool star = false;
+    std::vector<ContentCoding> accepted, refused;
+    while (!accept_encoding.empty()) {
+        auto comma = accept_encoding.find(',');
+        std::string_view element = accept_encoding.substr(0, comma);
+        accept_encoding.remove_prefix(comma == std::string_view::npos ? accept_encoding.size()
+                                                                       : comma + 1);
+        auto semi = element.find(';');
+        std::string_view name = trim(element.substr(0, semi));
+        bool ok = acceptable(semi == std::string_view::npos ? std::string_view() : element.substr(semi + 1));
+        if (name == "*") {
+            star = ok;
+        } else if (auto coding = parse_content_coding(name)) {
+            (ok ? accepted : refused).push_back(*coding);
+        }
+    }
+    auto listed = [](const std::vector<ContentCoding>& list, ContentCoding coding) {
+        for (auto c : list) {
+            if (c == coding) return true;
+        }
+        return false;
+    };
+    for (auto coding : preferred) {
+        if (coding == ContentCoding::Identity || !coding_available(coding)) continue;
+        if (listed(accepted, coding) || (star && !listed(refused, coding))) return coding;
+    }
+    return ContentCoding::Identity;
+}
+
+std::string accept_encoding_value(const std::vector<ContentCoding>& codings) {
+    std::string value;
+    for (auto coding : codings) {
+        if (coding == ContentCoding::Identity || !coding_available(coding)) continue;
+        if (!value.empty()) value += ", ";
+        value += to_string(coding);
+    }
+    return value;
+}
+
+std::string compress(std::string_view data, ContentCoding coding) {
+    if (coding == ContentCoding::Identity) return std::string(data);
+    StreamCompressor compressor(coding);
+    std::string out;
+    out.reserve(data.size() / 4 + 64);
+    compressor.write(data, out);
+    compressor.finish(out);
+    return out;
+}
+
+std::optional<std::string> decompress(std::string_view data, ContentCoding coding, size_t max_bytes) {
+    if (coding == ContentCoding::Identity) {
+        if (data.size() > max_bytes) return std::nullopt;
+        return std::string(data);
+    }
+    StreamDecompressor decompressor(coding);
+    std::string out;
+    if (!decompressor.write(data, out, max_bytes)) return std::nullopt;
+    return out;
+}
+
+// ---------- StreamCompressor ----------
+
+struct StreamCompressor::Impl {
+#ifdef MCPXX_HAVE_ZLIB
+    z_stream z{};
+    bool z_open = false;
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    ZSTD_CCtx* zstd = nullptr;
+#endif
+
+    ~Impl() {
+#ifdef MCPXX_HAVE_ZLIB
+        if (z_open) deflateEnd(&z);
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+        ZSTD_freeCCtx(zstd);
+#endif
+    }
+
+#ifdef MCPXX_HAVE_ZLIB
+    void deflate_into(std::string_view data, std::string& out, int flush) {
+        z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        z.avail_in = static_cast<uInt>(data.size());
+        do {
+            size_t old = out.size();
+            out.resize(old + kOutStep);
+            z.next_out = reinterpret_cast<Bytef*>(out.data() + old);
+            z.avail_out = static_cast<uInt>(kOutStep);
+            int rc = deflate(&z, flush);
+            out.resize(old + kOutStep - z.avail_out);
+            if (rc == Z_STREAM_ERROR) throw McpTransportError("gzip compression failed");
+        } while (z.avail_out == 0 || z.avail_in > 0);
+    }
+#endif
+
+#ifdef MCPXX_HAVE_ZSTD
+    void zstd_into(std::string_view data, std::string& out, ZSTD_EndDirective mode) {
+        ZSTD_inBuffer in{data.data(), data.size(), 0};
+        size_t remaining;
+        do {
+            size_t old = out.size();
+            out.resize(old + kOutStep);
+            ZSTD_outBuffer buf{out.data() + old, kOutStep, 0};
+            remaining = ZSTD_compressStream2(zstd, &buf, &in, mode);
+            out.resize(old + buf.pos);
+            if (ZSTD_isError(remaining)) {
+                throw McpTransportError(std::string("zstd compression failed: ")
+                                        + ZSTD_getErrorName(remaining));
+            }
+        } while (remaining > 0 || in.pos < in.size);
+    }
+#endif
+};
+
+StreamCompressor::StreamCompressor(ContentCoding coding)
+    : coding_(coding), impl_(std::make_unique<Impl>()) {
+    check_available(coding);
+#ifdef MCPXX_HAVE_ZLIB
+    if (coding == ContentCoding::Gzip) {
+        // 16 + 15 window bits: a gzip wrapper around deflate
+        if (deflateInit2(&impl_->z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + 15, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw McpTransportError("gzip compressor could not be set up");
+        }
+        impl_->z_open = true;
+    }
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    if (coding == ContentCoding::Zstd) {
+        impl_->zstd = ZSTD_createCCtx();
+        if (!impl_->zstd) throw McpTransportError("zstd compressor could not be set up");
+    }
+#endif
+}
+
+StreamCompressor::~StreamCompressor() = default;
+
+void StreamCompressor::write(std::string_view data, std::string& out) {
+    if (data.empty()) return;
+#ifdef MCPXX_HAVE_ZLIB
+    if (coding_ == ContentCoding::Gzip) return impl_->deflate_into(data, out, Z_SYNC_FLUSH);
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    if (coding_ == ContentCoding::Zstd) return impl_->zstd_into(data, out, ZSTD_e_flush);
+#endif
+    (void)out;
+}
+
+void StreamCompressor::finish(std::string& out) {
+#ifdef MCPXX_HAVE_ZLIB
+    if (coding_ == ContentCoding::Gzip) return impl_->deflate_into({}, out, Z_FINISH);
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    if (coding_ == ContentCoding::Zstd) return impl_->zstd_into({}, out, ZSTD_e_end);
+#endif
+    (void)out;
+}
+
+// ---------- StreamDecompressor ----------
+
+struct StreamDecompressor::Impl {
+#ifdef MCPXX_HAVE_ZLIB
+    z_stream z{};
+    bool z_open = false;
+    bool z_ended = false;
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    ZSTD_DCtx* zstd = nullptr;
+#endif
+
+    ~Impl() {
+#ifdef MCPXX_HAVE_ZLIB
+        if (z_open) inflateEnd(&z);
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+        ZSTD_freeDCtx(zstd);
+#endif
+    }
+};
+
+StreamDecompressor::StreamDecompressor(ContentCoding coding)
+    : coding_(coding), impl_(std::make_unique<Impl>()) {
+    check_available(coding);
+#ifdef MCPXX_HAVE_ZLIB
+    if (coding == ContentCoding::Gzip) {
+        if (inflateInit2(&impl_->z, 16 + 15) != Z_OK) {
+            throw McpTransportError("gzip decompressor could not be set up");
+        }
+        impl_->z_open = true;
+    }
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    if (coding == ContentCoding::Zstd) {
+        impl_->zstd = ZSTD_createDCtx();
+        if (!impl_->zstd) throw McpTransportError("zstd decompressor could not be set up");
+    }
+#endif
+}
+
+StreamDecompressor::~StreamDecompressor() = default;
+
+bool StreamDecompressor::write(std::string_view data, std::string& out, size_t max_bytes) {
+#ifdef MCPXX_HAVE_ZLIB
+    if (coding_ == ContentCoding::Gzip) {
+        auto& z = impl_->z;
+        z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        z.avail_in = static_cast<uInt>(data.size());
+        do {
+            if (impl_->z_ended && z.avail_in > 0) {
+                // Another gzip member follows (concatenated streams are valid)
+                if (inflateReset(&z) != Z_OK) throw McpParseError("Corrupt gzip data");
+                impl_->z_ended = false;
+            }
+            size_t old = out.size();
+            out.resize(old + kOutStep);
+            z.next_out = reinterpret_cast<Bytef*>(out.data() + old);
+            z.avail_out = static_cast<uInt>(kOutStep);
+            int rc = inflate(&z, Z_NO_FLUSH);
+            out.resize(old + kOutStep - z.avail_out);
+            if (rc == Z_STREAM_END) {
+                impl_->z_ended = true;
+            } else if (rc == Z_BUF_ERROR) {
+                break;  // no progress possible until more input
+            } else if (rc != Z_OK) {
+                throw McpParseError("Corrupt gzip data");
+            }
+            if (out.size() > max_bytes) return false;
+            // A full buffer may hide more output for input already taken
+        } while (z.avail_out == 0 || z.avail_in > 0);
+        return true;
+    }
+#endif
+#ifdef MCPXX_HAVE_ZSTD
+    if (coding_ == ContentCoding::Zstd) {
+        ZSTD_inBuffer in{data.data(), data.size(), 0};
+        bool full = false;
+        while (in.pos < in.size || full) {
+            size_t old = out.size();
+            out.resize(old + kOutStep);
+            ZSTD_outBuffer buf{out.data() + old, kOutStep, 0};
+            size_t rc = ZSTD_decompressStream(impl_->zstd, &buf, &in);
+            out.resize(old + buf.pos);
+            if (ZSTD_isError(rc)) {
+                throw McpParseError(std::string("Corrupt zstd data: ") + ZSTD_getErrorName(rc));
+            }
+            if (out.size() > max_bytes) return false;
+            // A full buffer may hide more output for input already taken
+            full = buf.pos == buf.size;
+        }
+        return true;
+    }
+#endif
+    (void)data;
+    (void)out;
+    (void)max_bytes;
+    return true;
+}
+
+} // namespace mcp
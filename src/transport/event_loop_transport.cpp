@@ -0,0 +1,462 @@
+#include "mcp/transport/event_loop_transport.hpp"
+#include "mcp/transport/line_buffer.hpp"
+#include "mcp/codec.hpp"
+#include "mcp/error.hpp"
+#include "mcp/metrics.hpp"
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace mcp {
+
+namespace {
+// Reads per readiness event, so one chatty connection can't starve the
+// others on its poller; level triggering brings it back for the rest.
+constexpr int kMaxReadsPerEvent = 16;
+constexpr size_t kMaxIov = std::min<size_t>(64, IOV_MAX);
+
+void set_nonblocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+} // anonymous namespace
+
+struct EventLoopTransport::State : std::enable_shared_from_this<State> {
+    State(std::shared_ptr<EventLoop> l, int rfd, int wfd, Options o)
+        : loop(std::move(l)), read_fd(rfd), write_fd(wfd), opts(o), buffer(o.read_chunk_size) {
+        set_nonblocking(read_fd);
+        if (write_fd != read_fd) set_nonblocking(write_fd);
+    }
+
+    ~State() {
+        if (read_fd >= 0) ::close(read_fd);
+        if (write_fd >= 0 && write_fd != read_fd) ::close(write_fd);
+    }
+
+    bool shared_fd() const { return read_fd == write_fd; }
+
+    bool write_failed_flag() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return write_failed;
+    }
+
+    // ---- Poller thread ----
+
+    void on_ready(int fd, uint32_t events) {
+        if (fd == read_fd && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) read_ready();
+        if (fd != write_fd) return;
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            // Until input ends on a socket, the read side reports the hangup
+            if (!shared_fd() || input_done_flag.load(std::memory_order_acquire)) {
+                fail_writes();
+                return;
+            }
+        }
+        if (events & EPOLLOUT) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (closed || write_failed) return;
+            if (!flush_locked()) {
+                lock.unlock();
+                fail_writes();
+                return;
+            }
+            update_events_locked();
+        }
+    }
+
+    void read_ready() {
+        for (int i = 0; i < kMaxReadsPerEvent; ++i) {
+            if (input_done_flag.load(std::memory_order_acquire)) return;
+            char* dst = buffer.write_ptr();
+            ssize_t n = ::read(read_fd, dst, buffer.write_size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                report(McpTransportError(std::string("read: ") + std::strerror(errno)));
+                finish_input();
+                return;
+            }
+            if (n == 0) {
+                finish_input();
+                return;
+            }
+            buffer.commit(static_cast<size_t>(n));
+            buffer.deliver(on_message, on_error);
+        }
+    }
+
+    void report(const McpTransportError& e) {
+        if (!on_error) return;
+        try {
+            throw e;
+        } catch (...) {
+            on_error(std::current_exception());
+        }
+    }
+
+    // ---- Writing (under mutex) ----
+
+    // Writes queued frames until the fd would block; false on an error
+    bool flush_locked() {
+        iovec iov[kMaxIov];
+        while (!queue.empty()) {
+            size_t count = std::min(queue.size(), kMaxIov);
+            for (size_t i = 0; i < count; ++i) {
+                const auto& data = queue[i].data;
+                size_t skip = i == 0 ? front_offset : 0;
+                iov[i] = {const_cast<char*>(data.data()) + skip, data.size() - skip};
+            }
+            ssize_t written = ::writev(write_fd, iov, static_cast<int>(count));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            ++write_calls;
+            bytes_written += static_cast<uint64_t>(written);
+
+            auto left = static_cast<size_t>(written);
+            while (!queue.empty() && left >= queue.front().data.size() - front_offset) {
+                left -= queue.front().data.size() - front_offset;
+                queued_bytes -= queue.front().data.size();
+                --queued_messages;
+                ++messages_written;
+                front_offset = 0;
+                queue.pop_front();
+            }
+            front_offset += left;
+        }
+        space_cv.notify_all();
+        return true;
+    }
+
+    // Writes `data` directly while the fd takes it; bytes written, or
+    // npos on an error
+    size_t write_direct(const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t written = ::write(write_fd, data.data() + done, data.size() - done);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return std::string::npos;
+            }
+            ++write_calls;
+            bytes_written += static_cast<uint64_t>(written);
+            done += static_cast<size_t>(written);
+        }
+        return done;
+    }
+
+    // Watches for EPOLLOUT exactly while something is queued
+    void update_events_locked() {
+        if (!poller || closed) return;
+        bool want_out = !queue.empty() && !write_failed;
+        uint32_t events = want_out ? uint32_t{EPOLLOUT} : 0;
+        if (shared_fd() && !input_done) events |= EPOLLIN;
+        if (events == armed_events) return;
+        armed_events = events;
+        poller->modify(write_fd, events);
+    }
+
+    void drop_queue_locked() {
+        queue.clear();
+        front_offset = 0;
+        queued_messages = 0;
+        queued_bytes = 0;
+        space_cv.notify_all();
+    }
+
+    // The peer stopped reading: drop what's queued, as a failed write
+    // does on StdioTransport, and stop watching the write side
+    void fail_writes() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (write_failed || closed) return;
+            write_failed = true;
+            drop_queue_locked();
+            update_events_locked();
+        }
+        // A socket stays watched for reading until its input ends
+        if (poller && (!shared_fd() || input_done_flag.load(std::memory_order_acquire))) {
+            poller->unwatch(write_fd);
+        }
+    }
+
+    void enqueue(OutboundFrame frame) {
+        const auto& limits = opts.outbound_limits;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (closed) throw McpTransportError("Transport shut down");
+        if (write_failed) return;
+
+        if (started && queue.empty()) {
+            size_t done = write_direct(frame.data);
+            if (done == std::string::npos) {
+                lock.unlock();
+                fail_writes();
+                return;
+            }
+            if (done == frame.data.size()) {
+                ++messages_written;
+                return;
+            }
+            front_offset = done;
+        } else if (limits.policy == OverflowPolicy::Block && !(poller && poller->on_thread())) {
+            // A frame bigger than the limit waits for an empty queue
+            size_t size = frame.data.size();
+            space_cv.wait(lock, [&] {
+                return queue.empty() || closed || write_failed
+                    || !exceeds(limits, queued_messages + 1, queued_bytes + size);
+            });
+            if (closed) throw McpTransportError("Transport shut down");
+            if (write_failed) return;
+        }
+
+        queued_messages += 1;
+        queued_bytes += frame.data.size();
+        queue.push_back(std::move(frame));
+        if (limits.policy != OverflowPolicy::Block && exceeds(limits, queued_messages, queued_bytes)) {
+            // The frame being written can't be dropped halfway through
+            std::optional<OutboundFrame> partial;
+            if (front_offset > 0) {
+                partial = std::move(queue.front());
+                queue.pop_front();
+            }
+            auto shed_result = shed(queue, limits, queued_messages, queued_bytes);
+            if (partial) queue.push_front(std::move(*partial));
+            queued_messages -= shed_result.dropped + shed_result.coalesced;
+            queued_bytes -= shed_result.bytes;
+            dropped_messages += shed_result.dropped;
+            coalesced_messages += shed_result.coalesced;
+        }
+        update_events_locked();
+    }
+
+    // ---- Lifecycle ----
+
+    // Stops reading and runs on_closed, once; a second caller waits for
+    // the first unless it is the one running on_closed
+    void finish_input() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (input_done) {
+                if (closing_thread != std::this_thread::get_id()) {
+                    closed_cv.wait(lock, [&] { return on_closed_done; });
+                }
+                return;
+            }
+            input_done = true;
+            input_done_flag.store(true, std::memory_order_release);
+            connected.store(false, std::memory_order_release);
+            closing_thread = std::this_thread::get_id();
+            if (shared_fd() && !write_failed) update_events_locked();
+        }
+        // Outside the mutex: unwatching waits for a running handler
+        if (poller && (!shared_fd() || write_failed_flag())) poller->unwatch(read_fd);
+        if (on_closed) on_closed();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        on_closed_done = true;
+        closed_cv.notify_all();
+    }
+
+    void shutdown() {
+        finish_input();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) return;
+            if (started && !write_failed) (void)flush_locked();
+            closed = true;
+            drop_queue_locked();
+        }
+        if (poller) poller->unwatch(write_fd);
+        // No handler can run any more; the fds close with the state
+    }
+
+    std::shared_ptr<EventLoop> loop;
+    EventLoop::Poller* poller = nullptr;
+    int read_fd;
+    int write_fd;
+    Options opts;
+    LineBuffer buffer;  // poller thread only
+
+    MessageCallback on_message;
+    ErrorCallback on_error;
+    std::function<void()> on_closed;
+
+    std::mutex mutex;  // guards everything below, and writes to write_fd
+    std::condition_variable space_cv;   // Block policy: the queue shrank
+    std::condition_variable closed_cv;  // on_closed returned
+    std::deque<OutboundFrame> queue;
+    size_t front_offset = 0;  // bytes of queue.front() already written
+    uint32_t armed_events = 0;
+    bool started = false;
+    bool input_done = false;
+    bool on_closed_done = false;
+    bool write_failed = false;
+    bool closed = false;
+    std::thread::id closing_thread;
+    std::atomic<bool> input_done_flag{false};  // input_done, for the read loop
+    std::atomic<bool> connected{false};
+    std::atomic<WireFormat> wire_format{WireFormat::Json};
+
+    size_t queued_messages = 0;
+    size_t queued_bytes = 0;
+    uint64_t messages_written = 0;
+    uint64_t write_calls = 0;
+    uint64_t bytes_written = 0;
+    uint64_t dropped_messages = 0;
+    uint64_t coalesced_messages = 0;
+
+    // Last, so they are unregistered before anything they read is destroyed
+    metrics::Gauge queued_messages_gauge{"mcpxx_event_loop_queued_messages", [this] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<int64_t>(queued_messages);
+    }};
+    metrics::Gauge queued_bytes_gauge{"mcpxx_event_loop_queued_bytes", [this] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<int64_t>(queued_bytes);
+    }};
+};
+
+EventLoopTransport::EventLoopTransport(std::shared_ptr<EventLoop> loop, int read_fd, int write_fd)
+    : EventLoopTransport(std::move(loop), read_fd, write_fd, Options{}) {
+}
+
+EventLoopTransport::EventLoopTransport(std::shared_ptr<EventLoop> loop, int read_fd, int write_fd,
+                                       Options opts) {
+    if (!loop) throw std::invalid_argument("EventLoopTransport needs an event loop");
+    state_ = std::make_shared<State>(std::move(loop), read_fd, write_fd, opts);
+}
+
+EventLoopTransport::~EventLoopTransport() {
+    state_->shutdown();
+}
+
+void EventLoopTransport::start(MessageCallback on_message, ErrorCallback on_error) {
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+    start_detached(std::move(on_message), std::move(on_error), [&] {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        done = true;
+        done_cv.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&] { return done; });
+}
+
+bool EventLoopTransport::start_detached(MessageCallback on_message, ErrorCallback on_error,
+                                        std::function<void()> on_closed) {
+    auto& s = *state_;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.started) return true;
+        if (!s.input_done) {
+            s.started = true;
+            s.on_message = std::move(on_message);
+            s.on_error = std::move(on_error);
+            s.on_closed = std::move(on_closed);
+            s.connected.store(true, std::memory_order_release);
+            s.poller = &s.loop->next();
+
+            // A handler racing with destruction keeps the state alive
+            // for the rest of its call
+            std::weak_ptr<State> weak = s.shared_from_this();
+            auto handler = [weak](int fd) {
+                return [weak, fd](uint32_t events) {
+                    if (auto self = weak.lock()) self->on_ready(fd, events);
+                };
+            };
+            s.armed_events = s.queue.empty() ? 0 : uint32_t{EPOLLOUT};
+            if (s.shared_fd()) s.armed_events |= EPOLLIN;
+            s.poller->watch(s.write_fd, s.armed_events, handler(s.write_fd));
+            if (!s.shared_fd()) s.poller->watch(s.read_fd, EPOLLIN, handler(s.read_fd));
+            return true;
+        }
+    }
+    // Shut down before it started
+    if (on_closed) on_closed();
+    return true;
+}
+
+void EventLoopTransport::send(const JsonRpcMessage& msg) {
+    std::string data;
+    if (const auto* resp = std::get_if<JsonRpcResponse>(&msg); resp && resp->result_stream) {
+        // The poller can't wait on a producer, so the result is collected here
+        Codec::serialize_result_head(data, resp->id);
+        std::string piece;
+        for (bool more = true; more;) {
+            piece.clear();
+            more = resp->result_stream(piece);
+            data += piece;
+        }
+        data += "}\n";
+        OutboundFrame frame;
+        frame.data = std::move(data);
+        return state_->enqueue(std::move(frame));
+    }
+    if (auto format = state_->wire_format.load(std::memory_order_relaxed); format != WireFormat::Json) {
+        BinaryCodec::encode_frame(data, msg, format);
+    } else {
+        Codec::serialize_to(data, msg);
+        data += '\n';
+    }
+    state_->enqueue(OutboundFrame(std::move(data), msg, state_->opts.outbound_limits.policy));
+}
+
+void EventLoopTransport::send_batch(const std::vector<JsonRpcMessage>& msgs) {
+    if (msgs.size() == 1) return send(msgs.front());
+    OutboundFrame frame;  // never dropped: it may carry requests
+    if (auto format = state_->wire_format.load(std::memory_order_relaxed); format != WireFormat::Json) {
+        BinaryCodec::encode_batch_frame(frame.data, msgs, format);
+    } else {
+        Codec::serialize_batch_to(frame.data, msgs);
+        frame.data += '\n';
+    }
+    state_->enqueue(std::move(frame));
+}
+
+bool EventLoopTransport::supports_wire_format(WireFormat) const {
+    return true;
+}
+
+bool EventLoopTransport::set_wire_format(WireFormat format) {
+    state_->wire_format.store(format, std::memory_order_relaxed);
+    return true;
+}
+
+void EventLoopTransport::shutdown() {
+    state_->shutdown();
+}
+
+bool EventLoopTransport::is_connected() const {
+    return state_->connected.load(std::memory_order_acquire);
+}
+
+EventLoopTransport::Stats EventLoopTransport::stats() const {
+    auto& s = *state_;
+    std::lock_guard<std::mutex> lock(s.mutex);
+    Stats st;
+    st.messages_written = s.messages_written;
+    st.write_calls = s.write_calls;
+    st.bytes_written = s.bytes_written;
+    st.queued_messages = s.queued_messages;
+    st.queued_bytes = s.queued_bytes;
+    st.dropped_messages = s.dropped_messages;
+    st.coalesced_messages = s.coalesced_messages;
+    return st;
+}
+
+} // namespace mcp
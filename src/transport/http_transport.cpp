@@ -1,15 +1,31 @@
 #include "mcp/transport/http_transport.hpp"
 #include "mcp/error.hpp"
 #include "mcp/version.hpp"
+#include "mcp/event_loop.hpp"
+#include "mcp/executor.hpp"
 
 #define CPPHTTPLIB_OPENSSL_SUPPORT 0
 #include <httplib.h>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <chrono>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <optional>
 
 namespace mcp {
 
@@ -33,13 +49,951 @@ static std::string generate_uuid() {
     return oss.str();
 }
 
+// Tells a session's GET streams that its outbox or state changed.
+// Called with the session's mutex held.
+static void wake_streams(HttpSession& session) {
+    session.cv.notify_all();
+    for (auto& [id, wake] : session.wakers) wake();
+}
+
+// Keeps the session's place in its shard's idle list: unlinked while it
+// has a POST or GET stream or once closed, at the back when it goes idle.
+// Called with the session's mutex held.
+static void relink(HttpSession& session) {
+    bool idle = !session.closed && session.streams == 0 && session.posts == 0;
+    if (!session.lru || (!idle && !session.in_lru)) return;
+    std::lock_guard<std::mutex> lock(session.lru->mutex);
+    if (session.in_lru) session.lru->idle.erase(session.lru_pos);
+    session.in_lru = idle;
+    if (idle) session.lru_pos = session.lru->idle.insert(session.lru->idle.end(), &session);
+}
+
+// Marks the session used now. Called with its mutex held, after any change
+// to its POSTs or streams.
+static void touch(HttpSession& session) {
+    session.last_active_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count(),
+                                 std::memory_order_relaxed);
+    relink(session);
+}
+
+// Ends a GET stream's hold on its session. Called with the session's mutex
+// held; once no stream is left, events are only kept for replay.
+static void detach_stream(HttpSession& session) {
+    if (--session.streams == 0) {
+        session.outbox.clear();
+        session.outbox_bytes = 0;
+        session.cv.notify_all();
+    }
+    touch(session);
+}
+
+// Marks a session in use for as long as a POST is running for it
+class SessionUse {
+public:
+    explicit SessionUse(std::shared_ptr<HttpSession> session) : session_(std::move(session)) {
+        if (!session_) return;
+        std::lock_guard<std::mutex> lock(session_->mutex);
+        ++session_->posts;
+        touch(*session_);
+    }
+    ~SessionUse() {
+        if (!session_) return;
+        std::lock_guard<std::mutex> lock(session_->mutex);
+        --session_->posts;
+        touch(*session_);
+    }
+    SessionUse(const SessionUse&) = delete;
+    SessionUse& operator=(const SessionUse&) = delete;
+
+private:
+    std::shared_ptr<HttpSession> session_;
+};
+
+// Frames a message as one SSE data event, serialized in place.
+static std::string sse_event(const JsonRpcMessage& msg) {
+    std::string event = "data: ";
+    Codec::serialize_to(event, msg);
+    event += "\n\n";
+    return event;
+}
+
+// ---------- Native HTTP backend ----------
+
+namespace {
+
+constexpr size_t kMaxHeaderBytes = 64 * 1024;
+constexpr size_t kReadChunk = 16 * 1024;
+constexpr int kMaxReadsPerEvent = 16;
+// A GET stream leaves events in its session's outbox while this much is
+// waiting for the socket, so the outbox limits and policy still apply
+constexpr size_t kStreamHighWater = 256 * 1024;
+// Keep-alive connections with no request in flight are closed after this
+constexpr auto kIdleTimeout = std::chrono::seconds(60);
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string lowercase(std::string_view text) {
+    std::string out(text);
+    for (auto& ch : out) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return out;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+struct HttpRequest {
+    std::string method;
+    std::string path;  // target without the query
+    int minor_version = 1;
+    std::vector<std::pair<std::string, std::string>> headers;  // names lower-cased
+    std::string body;
+
+    std::string header(std::string_view name) const {
+        for (const auto& [n, v] : headers) {
+            if (n == name) return v;
+        }
+        return {};
+    }
+
+    bool keep_alive() const {
+        std::string connection = lowercase(header("connection"));
+        if (minor_version == 0) return connection.find("keep-alive") != std::string::npos;
+        return connection.find("close") == std::string::npos;
+    }
+};
+
+enum class HeadResult { Ok, Bad, Unsupported };
+
+// Parses the request line and headers, `head` ending before the blank line.
+HeadResult parse_head(std::string_view head, HttpRequest& req, size_t& content_length) {
+    auto line_end = head.find("\r\n");
+    std::string_view line = head.substr(0, line_end);
+    head.remove_prefix(line_end == std::string_view::npos ? head.size() : line_end + 2);
+
+    auto sp1 = line.find(' ');
+    auto sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 == sp1) return HeadResult::Bad;
+    req.method = std::string(line.substr(0, sp1));
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view version = line.substr(sp2 + 1);
+    if (version == "HTTP/1.1") {
+        req.minor_version = 1;
+    } else if (version == "HTTP/1.0") {
+        req.minor_version = 0;
+    } else {
+        return HeadResult::Bad;
+    }
+    req.path = std::string(target.substr(0, target.find('?')));
+
+    content_length = 0;
+    while (!head.empty()) {
+        line_end = head.find("\r\n");
+        line = head.substr(0, line_end);
+        head.remove_prefix(line_end == std::string_view::npos ? head.size() : line_end + 2);
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0) return HeadResult::Bad;
+        std::string name = lowercase(line.substr(0, colon));
+        std::string value(trim(line.substr(colon + 1)));
+        if (name == "content-length") {
+            auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), content_length);
+            if (ec != std::errc{} || ptr != value.data() + value.size()) return HeadResult::Bad;
+        } else if (name == "transfer-encoding") {
+            return HeadResult::Unsupported;  // request bodies need a Content-Length
+        }
+        req.headers.emplace_back(std::move(name), std::move(value));
+    }
+    return HeadResult::Ok;
+}
+
+const char* status_text(int status) {
+    switch (status) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+// Status line and headers; a body of unknown length is sent chunked.
+// `extra_headers` are whole "Name: value\r\n" lines.
+std::string response_head(int status, std::string_view content_type, const std::string& session_id,
+                          bool keep_alive, std::optional<size_t> content_length,
+                          std::string_view extra_headers = {}) {
+    std::string head = "HTTP/1.1 " + std::to_string(status) + " " + status_text(status) + "\r\n";
+    if (!content_type.empty()) {
+        head += "Content-Type: ";
+        head += content_type;
+        head += "\r\n";
+    }
+    if (!session_id.empty()) head += "Mcp-Session-Id: " + session_id + "\r\n";
+    head += extra_headers;
+    if (content_length) {
+        head += "Content-Length: " + std::to_string(*content_length) + "\r\n";
+    } else {
+        head += "Cache-Control: no-cache\r\nTransfer-Encoding: chunked\r\n";
+    }
+    if (!keep_alive) head += "Connection: close\r\n";
+    head += "\r\n";
+    return head;
+}
+
+void append_chunk(std::string& out, std::string_view data) {
+    if (data.empty()) return;  // an empty chunk would end the body
+    char size[20];
+    int n = std::snprintf(size, sizeof(size), "%zx\r\n", data.size());
+    out.append(size, static_cast<size_t>(n));
+    out += data;
+    out += "\r\n";
+}
+
+const std::string kLastChunk = "0\r\n\r\n";
+
+// Header lines for a POST response: the request codings accepted and,
+// if the body or stream is compressed, its coding
+std::string coding_headers(const std::string& request_codings, ContentCoding coding) {
+    std::string lines;
+    if (!request_codings.empty()) lines += "Accept-Encoding: " + request_codings + "\r\n";
+    if (coding != ContentCoding::Identity) {
+        lines += "Content-Encoding: ";
+        lines += to_string(coding);
+        lines += "\r\nVary: Accept-Encoding\r\n";
+    }
+    return lines;
+}
+
+// The JSON body sent with a status from decode_body()
+std::string encoding_error_body(int status) {
+    if (status == 415) return "{\"error\":\"Unsupported Content-Encoding\"}";
+    if (status == 413) return "{\"error\":\"Request body too large\"}";
+    return "{\"error\":\"Corrupt request body\"}";
+}
+
+} // anonymous namespace
+
+// Accepts and parses on the event loop; each POST moves to a worker for as
+// long as it waits for its responses, then the connection returns to the
+// loop. A GET stream stays on the loop: events queued for its session are
+// pulled into the connection's write buffer whenever the session wakes it.
+class HttpServerTransport::NativeServer {
+public:
+    explicit NativeServer(HttpServerTransport& owner) : owner_(owner) {}
+
+    ~NativeServer() {
+        stop();
+        if (workers_) workers_->shutdown();
+        loop_.reset();
+    }
+
+    NativeServer(const NativeServer&) = delete;
+    NativeServer& operator=(const NativeServer&) = delete;
+
+    // Listens, then blocks until stop(). Throws McpTransportError if the
+    // address can't be bound.
+    void run();
+    void stop();
+
+private:
+    struct Connection {
+        enum class Mode { Reading, Busy, Streaming };
+
+        uint64_t id = 0;
+        int fd = -1;
+        EventLoop::Poller* poller = nullptr;
+
+        // Poller thread only
+        std::string in;
+        std::optional<HttpRequest> head;  // parsed, waiting for its body
+        size_t body_length = 0;
+        bool continue_sent = false;
+        std::atomic<bool> drain_posted{false};
+
+        std::mutex mutex;  // guards the rest, and writes to fd
+        std::condition_variable writable;  // workers wait here for room
+        Mode mode = Mode::Reading;
+        std::string out;
+        size_t out_offset = 0;
+        bool armed = false;  // watching for EPOLLOUT
+        bool closed = false;
+        bool close_when_flushed = false;
+        std::shared_ptr<HttpSession> stream;  // the session a GET stream serves
+        int64_t last_write_ns = 0;
+        int64_t last_active_ns = 0;
+
+        // Orders chunked body writes, which may come from the poller, a
+        // worker and the keep-alive tick, and guards the compressor
+        std::mutex body_mutex;
+        std::unique_ptr<StreamCompressor> compressor;  // set if the body is compressed
+
+        size_t pending() const { return out.size() - out_offset; }
+    };
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    void on_accept();
+    void on_tick();
+    void on_ready(const ConnectionPtr& c, uint32_t events);
+    void on_readable(const ConnectionPtr& c);
+    void on_writable(const ConnectionPtr& c);
+    // Handles buffered requests until one goes to a worker or stays open
+    void process(const ConnectionPtr& c);
+    void handle(const ConnectionPtr& c, HttpRequest req);
+    void handle_post(const ConnectionPtr& c, const HttpRequest& req, const std::string& session_id,
+                     bool created);
+    void open_stream(const ConnectionPtr& c, std::shared_ptr<HttpSession> session, bool created,
+                     const std::string& last_event_id, ContentCoding coding);
+    void schedule_drain(const ConnectionPtr& c);
+    void drain(const ConnectionPtr& c);
+    void respond(const ConnectionPtr& c, int status, std::string_view content_type, std::string body,
+                 bool keep_alive, const std::string& session_id = {},
+                 std::string_view extra_headers = {});
+    // Writes or buffers `data`; false once the connection is gone
+    bool write(const ConnectionPtr& c, std::string_view data);
+    // Writes `data` as one chunk of a chunked body, through the body's
+    // compressor if it has one; `last` ends the body
+    bool write_chunk(const ConnectionPtr& c, std::string_view data, bool last = false);
+    // Workers only: waits until the write buffer is below the high water mark
+    bool wait_writable(const ConnectionPtr& c);
+    void set_armed_locked(Connection& c, bool armed);
+    // The response is written: read the next request, or close
+    void finish_request(const ConnectionPtr& c, bool keep_alive);
+    void close_after_write(const ConnectionPtr& c);
+    void close(const ConnectionPtr& c);
+
+    HttpServerTransport& owner_;
+    std::shared_ptr<EventLoop> loop_;
+    std::unique_ptr<WorkStealingExecutor> workers_;  // runs POSTs
+    EventLoop::Poller* accept_poller_ = nullptr;
+    int listen_fd_ = -1;
+    int timer_fd_ = -1;
+
+    std::mutex mutex_;  // guards the fields below
+    std::condition_variable stopped_cv_;
+    bool stopped_ = false;
+    std::unordered_map<uint64_t, ConnectionPtr> connections_;
+    uint64_t next_id_ = 0;
+
+    metrics::Gauge connections_gauge_{"mcpxx_http_connections", [this] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return static_cast<int64_t>(connections_.size());
+    }};
+};
+
+void HttpServerTransport::NativeServer::run() {
+    const auto& opts = owner_.opts_;
+    auto fail = [&](const std::string& why) {
+        if (listen_fd_ >= 0) ::close(listen_fd_);
+        listen_fd_ = -1;
+        throw McpTransportError("Failed to start HTTP server on " + opts.host + ":"
+                                + std::to_string(opts.port) + ": " + why);
+    };
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opts.port);
+    std::string host = opts.host == "localhost" ? "127.0.0.1" : opts.host;
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) fail("not an IPv4 address");
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) fail(std::strerror(errno));
+    int one = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::listen(listen_fd_, SOMAXCONN) < 0) {
+        fail(std::strerror(errno));
+    }
+    socklen_t len = sizeof(addr);
+    if (::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        owner_.bound_port_.store(ntohs(addr.sin_port), std::memory_order_release);
+    }
+
+    loop_ = std::make_shared<EventLoop>(EventLoop::Options{opts.io_threads});
+    WorkStealingExecutor::Options wopts;
+    wopts.num_threads = static_cast<size_t>(std::max(1, opts.max_connections));
+    workers_ = std::make_unique<WorkStealingExecutor>(wopts);
+
+    // Keep-alives and idle timeouts are checked once a second
+    timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) fail(std::strerror(errno));
+    itimerspec tick{};
+    tick.it_interval.tv_sec = 1;
+    tick.it_value.tv_sec = 1;
+    ::timerfd_settime(timer_fd_, 0, &tick, nullptr);
+
+    accept_poller_ = &loop_->next();
+    accept_poller_->watch(listen_fd_, EPOLLIN, [this](uint32_t) { on_accept(); });
+    accept_poller_->watch(timer_fd_, EPOLLIN, [this](uint32_t) { on_tick(); });
+
+    stopped_cv_.wait(lock, [&] { return stopped_; });
+}
+
+void HttpServerTransport::NativeServer::stop() {
+    std::vector<ConnectionPtr> open;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) return;
+        stopped_ = true;
+        for (auto& [id, c] : connections_) open.push_back(c);
+    }
+    stopped_cv_.notify_all();
+    if (accept_poller_) {
+        accept_poller_->unwatch(listen_fd_);
+        accept_poller_->unwatch(timer_fd_);
+    }
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    if (timer_fd_ >= 0) ::close(timer_fd_);
+    listen_fd_ = timer_fd_ = -1;
+    for (auto& c : open) close(c);
+}
+
+void HttpServerTransport::NativeServer::on_accept() {
+    while (true) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN, or out of fds until a connection closes
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto c = std::make_shared<Connection>();
+        c->fd = fd;
+        c->last_active_ns = c->last_write_ns = now_ns();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) {
+                ::close(fd);
+                return;
+            }
+            c->id = ++next_id_;
+            c->poller = &loop_->next();
+            connections_[c->id] = c;
+        }
+        std::weak_ptr<Connection> weak = c;
+        c->poller->watch(fd, EPOLLIN | EPOLLRDHUP, [this, weak](uint32_t events) {
+            if (auto conn = weak.lock()) on_ready(conn, events);
+        });
+    }
+}
+
+void HttpServerTransport::NativeServer::on_tick() {
+    uint64_t expirations;
+    (void)::read(timer_fd_, &expirations, sizeof(expirations));
+
+    const int64_t now = now_ns();
+    const int64_t keepalive = std::chrono::nanoseconds(
+        std::max(owner_.opts_.sse_keepalive, std::chrono::seconds(1))).count();
+    const int64_t idle = std::chrono::nanoseconds(kIdleTimeout).count();
+    std::vector<ConnectionPtr> ping, expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [id, c] : connections_) {
+            std::lock_guard<std::mutex> clock(c->mutex);
+            if (c->mode == Connection::Mode::Streaming) {
+                if (now - c->last_write_ns >= keepalive) ping.push_back(c);
+            } else if (c->mode == Connection::Mode::Reading && c->pending() == 0
+                       && now - c->last_active_ns >= idle) {
+                expired.push_back(c);
+            }
+        }
+    }
+    // Keep-alive comment; also how a vanished client is noticed
+    for (auto& c : ping) write_chunk(c, ": ping\n\n");
+    for (auto& c : expired) close(c);
+}
+
+void HttpServerTransport::NativeServer::on_ready(const ConnectionPtr& c, uint32_t events) {
+    if (events & EPOLLERR) {
+        close(c);
+        return;
+    }
+    if (events & EPOLLOUT) on_writable(c);
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP)) on_readable(c);
+}
+
+void HttpServerTransport::NativeServer::on_readable(const ConnectionPtr& c) {
+    const size_t max_buffered = kMaxHeaderBytes + owner_.opts_.max_body_bytes;
+    for (int i = 0; i < kMaxReadsPerEvent; ++i) {
+        size_t old = c->in.size();
+        c->in.resize(old + kReadChunk);
+        ssize_t n = ::read(c->fd, c->in.data() + old, kReadChunk);
+        c->in.resize(old + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            close(c);
+            return;
+        }
+        if (n == 0) {
+            close(c);  // the client is gone; a POST in flight is abandoned
+            return;
+        }
+        if (c->in.size() > max_buffered) {
+            close(c);
+            return;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        c->last_active_ns = now_ns();
+        // A GET stream's client has nothing more to say
+        if (c->mode == Connection::Mode::Streaming) c->in.clear();
+    }
+    process(c);
+}
+
+void HttpServerTransport::NativeServer::on_writable(const ConnectionPtr& c) {
+    bool drain_stream = false;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) return;
+        while (c->pending() > 0) {
+            ssize_t n = ::send(c->fd, c->out.data() + c->out_offset, c->pending(), MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                c->close_when_flushed = true;
+                c->out.clear();
+                c->out_offset = 0;
+                break;
+            }
+            c->out_offset += static_cast<size_t>(n);
+            c->last_write_ns = now_ns();
+        }
+        if (c->pending() == 0) {
+            c->out.clear();
+            c->out_offset = 0;
+            set_armed_locked(*c, false);
+            finished = c->close_when_flushed;
+        } else if (c->out_offset >= kStreamHighWater) {
+            c->out.erase(0, c->out_offset);
+            c->out_offset = 0;
+        }
+        c->writable.notify_all();
+        drain_stream = c->mode == Connection::Mode::Streaming && c->pending() < kStreamHighWater;
+    }
+    if (finished) {
+        close(c);
+    } else if (drain_stream) {
+        drain(c);
+    }
+}
+
+void HttpServerTransport::NativeServer::set_armed_locked(Connection& c, bool armed) {
+    if (c.armed == armed) return;
+    c.armed = armed;
+    c.poller->modify(c.fd, EPOLLIN | EPOLLRDHUP | (armed ? uint32_t{EPOLLOUT} : 0));
+}
+
+bool HttpServerTransport::NativeServer::write(const ConnectionPtr& c, std::string_view data) {
+    bool failed = false;
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) return false;
+        c->last_write_ns = now_ns();
+        if (c->pending() == 0) {
+            // Straight to the socket while it takes data
+            while (!data.empty()) {
+                ssize_t n = ::send(c->fd, data.data(), data.size(), MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) failed = true;
+                    break;
+                }
+                data.remove_prefix(static_cast<size_t>(n));
+            }
+        }
+        if (!failed && !data.empty()) {
+            c->out += data;
+            set_armed_locked(*c, true);
+        }
+    }
+    if (failed) close(c);
+    return !failed;
+}
+
+bool HttpServerTransport::NativeServer::write_chunk(const ConnectionPtr& c, std::string_view data,
+                                                   bool last) {
+    std::lock_guard<std::mutex> lock(c->body_mutex);
+    std::string chunk;
+    if (c->compressor) {
+        std::string packed;
+        c->compressor->write(data, packed);
+        if (last) {
+            c->compressor->finish(packed);
+            c->compressor.reset();
+        }
+        append_chunk(chunk, packed);
+    } else {
+        append_chunk(chunk, data);
+    }
+    if (last) chunk += kLastChunk;
+    return chunk.empty() || write(c, chunk);
+}
+
+bool HttpServerTransport::NativeServer::wait_writable(const ConnectionPtr& c) {
+    std::unique_lock<std::mutex> lock(c->mutex);
+    c->writable.wait(lock, [&] { return c->closed || c->pending() < kStreamHighWater; });
+    return !c->closed;
+}
+
+void HttpServerTransport::NativeServer::respond(const ConnectionPtr& c, int status,
+                                                std::string_view content_type, std::string body,
+                                                bool keep_alive, const std::string& session_id,
+                                                std::string_view extra_headers) {
+    std::string data = response_head(status, content_type, session_id, keep_alive, body.size(),
+                                     extra_headers);
+    data += body;
+    write(c, data);
+    finish_request(c, keep_alive);
+}
+
+void HttpServerTransport::NativeServer::finish_request(const ConnectionPtr& c, bool keep_alive) {
+    if (!keep_alive) {
+        close_after_write(c);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) return;
+        c->mode = Connection::Mode::Reading;
+        c->last_active_ns = now_ns();
+    }
+    // Pick up requests the client pipelined meanwhile
+    if (!c->poller->on_thread()) c->poller->post([this, c] { process(c); });
+}
+
+void HttpServerTransport::NativeServer::close_after_write(const ConnectionPtr& c) {
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) return;
+        c->mode = Connection::Mode::Busy;  // read nothing more
+        if (c->pending() > 0) {
+            c->close_when_flushed = true;
+            return;
+        }
+    }
+    close(c);
+}
+
+void HttpServerTransport::NativeServer::close(const ConnectionPtr& c) {
+    std::shared_ptr<HttpSession> session;
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed) return;
+        c->closed = true;
+        session = std::move(c->stream);
+        c->writable.notify_all();
+    }
+    // Unwatching waits for a handler running elsewhere, so no one touches
+    // the fd once it is closed
+    c->poller->unwatch(c->fd);
+    ::close(c->fd);
+    if (session) {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->wakers.erase(c->id);
+        detach_stream(*session);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.erase(c->id);
+}
+
+void HttpServerTransport::NativeServer::process(const ConnectionPtr& c) {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(c->mutex);
+            if (c->closed || c->mode != Connection::Mode::Reading) return;
+        }
+        if (!c->head) {
+            auto end = c->in.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                if (c->in.size() > kMaxHeaderBytes) respond(c, 431, "", "", false);
+                return;
+            }
+            HttpRequest req;
+            size_t length = 0;
+            auto result = parse_head(std::string_view(c->in).substr(0, end), req, length);
+            c->in.erase(0, end + 4);
+            if (result == HeadResult::Bad) return respond(c, 400, "", "", false);
+            if (result == HeadResult::Unsupported) return respond(c, 501, "", "", false);
+            if (length > owner_.opts_.max_body_bytes) return respond(c, 413, "", "", false);
+            c->head = std::move(req);
+            c->body_length = length;
+            c->continue_sent = false;
+        }
+        if (c->in.size() < c->body_length) {
+            if (!c->continue_sent && lowercase(c->head->header("expect")) == "100-continue") {
+                c->continue_sent = true;
+                write(c, "HTTP/1.1 100 Continue\r\n\r\n");
+            }
+            return;
+        }
+        HttpRequest req = std::move(*c->head);
+        c->head.reset();
+        req.body = c->in.substr(0, c->body_length);
+        c->in.erase(0, c->body_length);
+        handle(c, std::move(req));
+    }
+}
+
+void HttpServerTransport::NativeServer::handle(const ConnectionPtr& c, HttpRequest req) {
+    const auto& opts = owner_.opts_;
+    bool keep_alive = req.keep_alive();
+    if (!owner_.running_) return respond(c, 503, "", "", false);
+
+    if (!opts.metrics_path.empty() && req.path == opts.metrics_path && req.method == "GET") {
+        return respond(c, 200, "text/plain; version=0.0.4", metrics::snapshot().to_prometheus(),
+                       keep_alive);
+    }
+    if (req.path != opts.mcp_path) return respond(c, 404, "", "", keep_alive);
+
+    // Validate Origin header for DNS rebinding protection
+    auto origin = req.header("origin");
+    bool origin_ok = origin.empty() || owner_.validate_origin(origin);
+    std::string session_id = req.header("mcp-session-id");
+
+    if (req.method == "POST") {
+        if (!origin_ok) {
+            return respond(c, 403, "application/json", "{\"error\":\"Invalid origin\"}", keep_alive);
+        }
+        auto proto_ver = req.header("mcp-protocol-version");
+        if (!proto_ver.empty() && proto_ver != std::string(PROTOCOL_VERSION)) {
+            return respond(c, 400, "application/json", "{\"error\":\"Unsupported protocol version\"}",
+                           keep_alive);
+        }
+        bool created = session_id.empty();
+        if (created) {
+            auto session = owner_.create_session();
+            if (!session) {
+                return respond(c, 503, "application/json", "{\"error\":\"Too many sessions\"}",
+                               keep_alive);
+            }
+            session_id = session->id;
+        } else if (!owner_.find_session(session_id)) {
+            return respond(c, 404, "application/json", "{\"error\":\"Session not found\"}", keep_alive);
+        }
+        {
+            std::lock_guard<std::mutex> lock(c->mutex);
+            c->mode = Connection::Mode::Busy;
+        }
+        workers_->post([this, c, req = std::move(req), session_id, created] {
+            handle_post(c, req, session_id, created);
+        });
+        return;
+    }
+
+    if (req.method == "GET") {
+        if (!origin_ok) return respond(c, 403, "", "", keep_alive);
+        std::shared_ptr<HttpSession> session;
+        bool created = session_id.empty();
+        session = created ? owner_.create_session() : owner_.find_session(session_id);
+        if (!session) return respond(c, created ? 503 : 404, "", "", keep_alive);
+        return open_stream(c, std::move(session), created, req.header("last-event-id"),
+                           owner_.response_coding(req.header("accept-encoding")));
+    }
+
+    if (req.method == "DELETE") {
+        if (session_id.empty()) return respond(c, 400, "", "", keep_alive);
+        return respond(c, owner_.remove_session(session_id) ? 200 : 404, "", "", keep_alive);
+    }
+    respond(c, 405, "", "", keep_alive);
+}
+
+void HttpServerTransport::NativeServer::handle_post(const ConnectionPtr& c, const HttpRequest& req,
+                                                    const std::string& session_id, bool created) {
+    bool keep_alive = req.keep_alive();
+    const std::string& header_id = created ? session_id : std::string();
+    const std::string plain_headers = coding_headers(owner_.request_codings_value_,
+                                                     ContentCoding::Identity);
+    try {
+        std::optional<std::string> decoded;
+        if (int status = owner_.decode_body(req.header("content-encoding"), req.body, decoded)) {
+            return respond(c, status, "application/json", encoding_error_body(status), keep_alive,
+                           header_id, plain_headers);
+        }
+        bool is_batch = false;
+        auto msgs = owner_.parse_post_body(decoded ? *decoded : req.body, is_batch);
+        bool has_requests = std::any_of(msgs.begin(), msgs.end(), [](const JsonRpcMessage& m) {
+            return std::holds_alternative<JsonRpcRequest>(m);
+        });
+
+        if (!has_requests) {
+            owner_.run_post(session_id, std::move(msgs), false, [](std::string, const JsonStream&) {});
+            return respond(c, 202, "application/json", "", keep_alive, header_id, plain_headers);
+        }
+        const std::string accept_encoding = req.header("accept-encoding");
+        if (req.header("accept").find("text/event-stream") == std::string::npos) {
+            std::string body = owner_.collect_post(session_id, std::move(msgs), is_batch);
+            ContentCoding coding = owner_.encode_body(body, accept_encoding);
+            return respond(c, 200, "application/json", std::move(body), keep_alive, header_id,
+                           coding_headers(owner_.request_codings_value_, coding));
+        }
+
+        // Stream each response as its own event as soon as it is ready
+        ContentCoding coding = owner_.response_coding(accept_encoding);
+        if (coding != ContentCoding::Identity) {
+            std::lock_guard<std::mutex> lock(c->body_mutex);
+            c->compressor = std::make_unique<StreamCompressor>(coding);
+        }
+        bool open = write(c, response_head(200, "text/event-stream", header_id, keep_alive,
+                                           std::nullopt,
+                                           coding_headers(owner_.request_codings_value_, coding)));
+        open = open && owner_.stream_post(session_id, std::move(msgs), [&](std::string_view data) {
+            return write_chunk(c, data) && wait_writable(c);
+        });
+        if (open) open = write_chunk(c, {}, true);
+        if (!open) return close(c);
+        finish_request(c, keep_alive);
+    } catch (const McpParseError& e) {
+        respond(c, 400, "application/json", parse_error_body(e.what()), keep_alive, header_id,
+                plain_headers);
+    } catch (const std::exception&) {
+        respond(c, 500, "application/json", "{\"error\":\"Internal server error\"}", keep_alive,
+                header_id, plain_headers);
+    }
+}
+
+void HttpServerTransport::NativeServer::open_stream(const ConnectionPtr& c,
+                                                    std::shared_ptr<HttpSession> session,
+                                                    bool created,
+                                                    const std::string& last_event_id,
+                                                    ContentCoding coding) {
+    if (coding != ContentCoding::Identity) {
+        std::lock_guard<std::mutex> lock(c->body_mutex);
+        c->compressor = std::make_unique<StreamCompressor>(coding);
+    }
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        c->mode = Connection::Mode::Streaming;
+        c->stream = session;
+    }
+    std::string replay;
+    {
+        // Attached before the client sees the headers, so nothing sent
+        // after that is missed. A wake-up runs after us on this thread.
+        std::lock_guard<std::mutex> lock(session->mutex);
+        replay = owner_.attach_stream(*session, last_event_id);
+        std::weak_ptr<Connection> weak = c;
+        session->wakers[c->id] = [this, weak] {
+            if (auto conn = weak.lock()) schedule_drain(conn);
+        };
+    }
+    write(c, response_head(200, "text/event-stream", created ? session->id : std::string(), true,
+                           std::nullopt, coding_headers({}, coding)));
+    if (!replay.empty()) write_chunk(c, replay);
+    drain(c);
+}
+
+void HttpServerTransport::NativeServer::schedule_drain(const ConnectionPtr& c) {
+    // One drain in flight covers any number of wake-ups
+    if (c->drain_posted.exchange(true, std::memory_order_acq_rel)) return;
+    c->poller->post([this, c] {
+        c->drain_posted.store(false, std::memory_order_release);
+        drain(c);
+    });
+}
+
+void HttpServerTransport::NativeServer::drain(const ConnectionPtr& c) {
+    std::shared_ptr<HttpSession> session;
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->closed || c->mode != Connection::Mode::Streaming) return;
+        if (c->pending() >= kStreamHighWater) return;  // on_writable calls again
+        session = c->stream;
+    }
+    std::deque<OutboundFrame> events;
+    bool ended;
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        ended = session->closed;
+        if (!ended) {
+            events.swap(session->outbox);
+            session->outbox_bytes = 0;
+            if (session->blocked > 0) session->cv.notify_all();
+        }
+    }
+    if (ended) {
+        write_chunk(c, {}, true);
+        return close_after_write(c);
+    }
+    if (events.empty()) return;
+
+    size_t size = 0;
+    for (const auto& event : events) size += event.data.size();
+    std::string body;
+    body.reserve(size);
+    for (const auto& event : events) body += event.data;
+    write_chunk(c, body);
+}
+
 HttpServerTransport::HttpServerTransport(Options opts)
-    : opts_(std::move(opts))
-    , server_(std::make_unique<httplib::Server>()) {
+    : opts_(std::move(opts)) {
+    if (opts_.backend == HttpBackend::Native) {
+        native_ = std::make_unique<NativeServer>(*this);
+    } else {
+        server_ = std::make_unique<httplib::Server>();
+    }
+    for (auto coding : opts_.compression) {
+        if (coding == ContentCoding::Identity || !coding_available(coding)) continue;
+        // httplib, built without its own zlib support, refuses gzip request
+        // bodies before a handler sees them
+        if (coding == ContentCoding::Gzip && server_) continue;
+        request_codings_.push_back(coding);
+    }
+    request_codings_value_ = accept_encoding_value(request_codings_);
 }
 
 HttpServerTransport::~HttpServerTransport() {
     shutdown();
+    idle_timers_.stop();  // also after a start() that failed
+}
+
+ContentCoding HttpServerTransport::response_coding(const std::string& accept_encoding) const {
+    if (accept_encoding.empty()) return ContentCoding::Identity;
+    return negotiate_coding(accept_encoding, opts_.compression);
+}
+
+ContentCoding HttpServerTransport::encode_body(std::string& body,
+                                               const std::string& accept_encoding) const {
+    if (body.size() < opts_.compression_min_bytes) return ContentCoding::Identity;
+    ContentCoding coding = response_coding(accept_encoding);
+    if (coding != ContentCoding::Identity) body = compress(body, coding);
+    return coding;
+}
+
+int HttpServerTransport::decode_body(const std::string& content_encoding, const std::string& body,
+                                     std::optional<std::string>& decoded) const {
+    if (content_encoding.empty()) return 0;
+    auto coding = parse_content_coding(content_encoding);
+    if (!coding) return 415;
+    if (*coding == ContentCoding::Identity) return 0;
+    if (std::find(request_codings_.begin(), request_codings_.end(), *coding) == request_codings_.end()) {
+        return 415;
+    }
+    try {
+        decoded = decompress(body, *coding, opts_.max_body_bytes);
+    } catch (const McpParseError&) {
+        return 400;
+    }
+    return decoded ? 0 : 413;
 }
 
 bool HttpServerTransport::validate_origin(const std::string& origin) const {
@@ -50,9 +1004,33 @@ bool HttpServerTransport::validate_origin(const std::string& origin) const {
     return false;
 }
 
+// Writes to an httplib stream, through `compressor` if it is compressed.
+static bool sink_write(httplib::DataSink& sink, StreamCompressor* compressor, std::string_view data) {
+    if (!compressor) return sink.write(data.data(), data.size());
+    std::string packed;
+    compressor->write(data, packed);
+    return packed.empty() || sink.write(packed.data(), packed.size());
+}
+
+// The httplib counterpart of coding_headers()
+static void set_coding_headers(httplib::Response& res, const std::string& request_codings,
+                               ContentCoding coding) {
+    if (!request_codings.empty()) res.set_header("Accept-Encoding", request_codings);
+    if (coding != ContentCoding::Identity) {
+        res.set_header("Content-Encoding", std::string(to_string(coding)));
+        res.set_header("Vary", "Accept-Encoding");
+    }
+}
+
 void HttpServerTransport::setup_routes() {
     const std::string path = opts_.mcp_path;
 
+    if (!opts_.metrics_path.empty()) {
+        server_->Get(opts_.metrics_path, [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(metrics::snapshot().to_prometheus(), "text/plain; version=0.0.4");
+        });
+    }
+
     // POST: handle JSON-RPC requests
     server_->Post(path, [this](const httplib::Request& req, httplib::Response& res) {
         // Validate Origin header for DNS rebinding protection
@@ -76,110 +1054,81 @@ void HttpServerTransport::setup_routes() {
         std::shared_ptr<HttpSession> session;
 
         if (session_id.empty()) {
-            // New session
-            session_id = generate_uuid();
-            session = std::make_shared<HttpSession>();
-            session->id = session_id;
-            {
-                std::lock_guard<std::mutex> lock(sessions_mutex_);
-                sessions_[session_id] = session;
+            session = create_session();
+            if (!session) {
+                res.status = 503;
+                res.set_content("{\"error\":\"Too many sessions\"}", "application/json");
+                return;
             }
+            session_id = session->id;
             res.set_header("Mcp-Session-Id", session_id);
         } else {
-            std::lock_guard<std::mutex> lock(sessions_mutex_);
-            auto it = sessions_.find(session_id);
-            if (it == sessions_.end()) {
+            session = find_session(session_id);
+            if (!session) {
                 res.status = 404;
                 res.set_content("{\"error\":\"Session not found\"}", "application/json");
                 return;
             }
-            session = it->second;
         }
 
         // Check if client accepts SSE
         auto accept = req.get_header_value("Accept");
         bool want_sse = accept.find("text/event-stream") != std::string::npos;
+        auto accept_encoding = req.get_header_value("Accept-Encoding");
 
         try {
-            // Check for batch
-            bool is_batch = !req.body.empty() && req.body[0] == '[';
+            std::optional<std::string> decoded;
+            if (int status = decode_body(req.get_header_value("Content-Encoding"), req.body, decoded)) {
+                res.status = status;
+                set_coding_headers(res, request_codings_value_, ContentCoding::Identity);
+                res.set_content(encoding_error_body(status), "application/json");
+                return;
+            }
+            // Parse up front so malformed bodies get a 400 before any
+            // response headers are committed
+            bool is_batch = false;
+            auto msgs = parse_post_body(decoded ? *decoded : req.body, is_batch);
+            bool has_requests = std::any_of(msgs.begin(), msgs.end(), [](const JsonRpcMessage& m) {
+                return std::holds_alternative<JsonRpcRequest>(m);
+            });
 
-            if (want_sse) {
-                // Return SSE stream for this request
+            if (!has_requests) {
+                // Notifications and responses only - nothing to answer
+                run_post(session_id, std::move(msgs), false, [](std::string, const JsonStream&) {});
+                res.status = 202;
+                set_coding_headers(res, request_codings_value_, ContentCoding::Identity);
+                res.set_content("", "application/json");
+            } else if (want_sse) {
+                // Stream each response as its own event as soon as it is ready
+                auto pending = std::make_shared<std::vector<JsonRpcMessage>>(std::move(msgs));
+                ContentCoding coding = response_coding(accept_encoding);
+                std::shared_ptr<StreamCompressor> compressor;
+                if (coding != ContentCoding::Identity) compressor = std::make_shared<StreamCompressor>(coding);
+                set_coding_headers(res, request_codings_value_, coding);
                 res.set_chunked_content_provider("text/event-stream",
-                    [this, body = req.body, is_batch, session_id](size_t /*offset*/,
-                         httplib::DataSink& sink) -> bool {
-                        try {
-                            auto process_msg = [&](const JsonRpcMessage& msg) {
-                                nlohmann::json j;
-                                to_json(j, msg);
-                                std::string event = "data: " + j.dump() + "\n\n";
-                                if (!sink.write(event.data(), event.size())) return false;
-                                return true;
-                            };
-
-                            if (is_batch) {
-                                auto msgs = Codec::parse_batch(body);
-                                for (auto& m : msgs) {
-                                    if (message_callback_) message_callback_(m);
-                                }
-                            } else {
-                                auto msg = Codec::parse(body);
-                                if (message_callback_) message_callback_(msg);
-                            }
-                            // Send done event
-                            std::string done = "event: done\ndata: {}\n\n";
-                            sink.write(done.data(), done.size());
-                            sink.done();
-                            return true;
-                        } catch (...) {
-                            return false;
+                    [this, pending, session_id, compressor](size_t /*offset*/,
+                                                            httplib::DataSink& sink) -> bool {
+                        bool open = stream_post(session_id, std::move(*pending),
+                                                [&](std::string_view data) {
+                            return sink_write(sink, compressor.get(), data);
+                        });
+                        if (open && compressor) {
+                            std::string tail;
+                            compressor->finish(tail);
+                            open = sink.write(tail.data(), tail.size());
                         }
+                        if (!open) return false;
+                        sink.done();
+                        return true;
                     });
             } else {
-                // Synchronous JSON response: temporarily capture outbound
-                // messages so we can return them in the HTTP response body.
-                std::vector<nlohmann::json> responses;
-                {
-                    std::lock_guard<std::mutex> lock(response_capture_mutex_);
-                    response_capture_ = &responses;
-                }
-
-                if (is_batch) {
-                    auto msgs = Codec::parse_batch(req.body);
-                    for (auto& m : msgs) {
-                        if (message_callback_) message_callback_(m);
-                    }
-                } else {
-                    auto msg = Codec::parse(req.body);
-                    if (message_callback_) message_callback_(msg);
-                }
-
-                {
-                    std::lock_guard<std::mutex> lock(response_capture_mutex_);
-                    response_capture_ = nullptr;
-                }
-
-                if (responses.empty()) {
-                    // Notification - no response expected
-                    res.status = 202;
-                    res.set_content("", "application/json");
-                } else if (responses.size() == 1) {
-                    res.set_content(responses[0].dump(), "application/json");
-                } else {
-                    nlohmann::json batch = nlohmann::json::array();
-                    for (auto& r : responses) batch.push_back(std::move(r));
-                    res.set_content(batch.dump(), "application/json");
-                }
+                std::string body = collect_post(session_id, std::move(msgs), is_batch);
+                set_coding_headers(res, request_codings_value_, encode_body(body, accept_encoding));
+                res.set_content(std::move(body), "application/json");
             }
         } catch (const McpParseError& e) {
             res.status = 400;
-            nlohmann::json err = {
-                {"jsonrpc", "2.0"},
-                {"id", nullptr},
-                {"error", {{"code", error::ParseError}, {"message", e.what()}}}
-            };
-            res.set_content(err.dump(), "application/json");
+            res.set_content(parse_error_body(e.what()), "application/json");
         } catch (const std::exception& e) {
             res.status = 500;
             res.set_content("{\"error\":\"Internal server error\"}", "application/json");
@@ -198,39 +1147,66 @@ void HttpServerTransport::setup_routes() {
         std::shared_ptr<HttpSession> session;
 
         if (session_id.empty()) {
-            session_id = generate_uuid();
-            session = std::make_shared<HttpSession>();
-            session->id = session_id;
-            {
-                std::lock_guard<std::mutex> lock(sessions_mutex_);
-                sessions_[session_id] = session;
+            session = create_session();
+            if (!session) {
+                res.status = 503;
+                return;
             }
-            res.set_header("Mcp-Session-Id", session_id);
+            res.set_header("Mcp-Session-Id", session->id);
         } else {
-            std::lock_guard<std::mutex> lock(sessions_mutex_);
-            auto it = sessions_.find(session_id);
-            if (it == sessions_.end()) {
+            session = find_session(session_id);
+            if (!session) {
                 res.status = 404;
                 return;
             }
-            session = it->second;
         }
 
-        // Keep SSE stream open
+        auto replay = std::make_shared<std::string>();
+        {
+            std::lock_guard<std::mutex> lock(session->mutex);
+            *replay = attach_stream(*session, req.get_header_value("Last-Event-ID"));
+        }
+        ContentCoding coding = response_coding(req.get_header_value("Accept-Encoding"));
+        std::shared_ptr<StreamCompressor> compressor;
+        if (coding != ContentCoding::Identity) compressor = std::make_shared<StreamCompressor>(coding);
+        set_coding_headers(res, {}, coding);
+        // Drain the session's outbox; senders never touch the socket
         res.set_chunked_content_provider("text/event-stream",
-            [session](size_t /*offset*/, httplib::DataSink& sink) -> bool {
-                // Set SSE sender for this session
+            [this, session, replay, compressor](size_t /*offset*/, httplib::DataSink& sink) -> bool {
+                if (!replay->empty()) {
+                    std::string missed = std::move(*replay);
+                    replay->clear();
+                    return sink_write(sink, compressor.get(), missed);
+                }
+                std::deque<OutboundFrame> events;
                 {
-                    std::lock_guard<std::mutex> lock(session->mutex);
-                    session->sse_sender = [&sink](const std::string& data) -> bool {
-                        return sink.write(data.data(), data.size());
-                    };
+                    std::unique_lock<std::mutex> lock(session->mutex);
+                    session->cv.wait_for(lock, opts_.sse_keepalive, [&] {
+                        return !session->outbox.empty() || session->closed;
+                    });
+                    if (session->closed) return false;
+                    events.swap(session->outbox);
+                    session->outbox_bytes = 0;
+                    if (session->blocked > 0) session->cv.notify_all();
+                }
+                if (events.empty()) {
+                    // Keep-alive comment; also how a vanished client is noticed
+                    return sink_write(sink, compressor.get(), ": ping\n\n");
+                }
+                if (compressor) {
+                    // One flush for the lot
+                    std::string body;
+                    for (const auto& event : events) body += event.data;
+                    return sink_write(sink, compressor.get(), body);
+                }
+                for (const auto& event : events) {
+                    if (!sink.write(event.data.data(), event.data.size())) return false;
                 }
-                // Keep alive with comments every 30s
-                std::string ping = ": ping\n\n";
-                if (!sink.write(ping.data(), ping.size())) return false;
-                // This provider returns false when the client disconnects
                 return true;
+            },
+            [session](bool /*success*/) {
+                std::lock_guard<std::mutex> lock(session->mutex);
+                detach_stream(*session);
             });
     });
 
@@ -241,25 +1217,298 @@ void HttpServerTransport::setup_routes() {
             res.status = 400;
             return;
         }
-        std::lock_guard<std::mutex> lock(sessions_mutex_);
-        auto it = sessions_.find(session_id);
-        if (it == sessions_.end()) {
-            res.status = 404;
-            return;
-        }
-        sessions_.erase(it);
-        res.status = 200;
+        res.status = remove_session(session_id) ? 200 : 404;
     });
 }
 
+HttpServerTransport::SessionShard& HttpServerTransport::shard_for(const std::string& session_id) {
+    return shards_[std::hash<std::string>{}(session_id) % kSessionShards];
+}
+
+std::shared_ptr<HttpSession> HttpServerTransport::create_session() {
+    if (opts_.max_sessions > 0 && !evict_for_new_session()) return nullptr;
+    auto session = std::make_shared<HttpSession>();
+    session->id = generate_uuid();
+    session->replay = ReplayBuffer(opts_.replay_events, opts_.replay_bytes);
+    auto& shard = shard_for(session->id);
+    session->lru = &shard.lru;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.sessions[session->id] = session;
+    }
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        touch(*session);
+    }
+    session_count_.fetch_add(1, std::memory_order_relaxed);
+    if (opts_.session_idle_timeout.count() > 0) {
+        schedule_idle_check(session->id, opts_.session_idle_timeout);
+    }
+    return session;
+}
+
+std::shared_ptr<HttpSession> HttpServerTransport::find_session(const std::string& session_id) {
+    auto& shard = shard_for(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(session_id);
+    return it == shard.sessions.end() ? nullptr : it->second;
+}
+
+bool HttpServerTransport::remove_session(const std::string& session_id, bool if_idle) {
+    std::shared_ptr<HttpSession> session;
+    {
+        auto& shard = shard_for(session_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(session_id);
+        if (it == shard.sessions.end()) return false;
+        if (if_idle) {
+            std::lock_guard<std::mutex> slock(it->second->mutex);
+            if (it->second->streams > 0 || it->second->posts > 0) return false;
+        }
+        session = std::move(it->second);
+        shard.sessions.erase(it);
+    }
+    session_count_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        for (const auto& uri : session->subscriptions) {
+            auto it = subscribers_.find(uri);
+            if (it == subscribers_.end()) continue;
+            it->second.erase(session_id);
+            if (it->second.empty()) subscribers_.erase(it);
+        }
+        session->subscriptions.clear();
+    }
+    {
+        // End its GET stream
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->closed = true;
+        session->outbox.clear();
+        session->outbox_bytes = 0;
+        relink(*session);
+        wake_streams(*session);
+    }
+    if (session_closed_callback_) session_closed_callback_(session_id);
+    return true;
+}
+
+void HttpServerTransport::schedule_idle_check(const std::string& session_id,
+                                              std::chrono::milliseconds delay) {
+    // Touching a session is only a timestamp; the check looks at it when
+    // it fires and comes back when the session could next be idle
+    idle_timers_.schedule(delay, [this, session_id] { check_idle(session_id); });
+}
+
+void HttpServerTransport::check_idle(const std::string& session_id) {
+    auto session = find_session(session_id);
+    if (!session) return;
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(opts_.session_idle_timeout);
+    bool in_use;
+    {
+        std::lock_guard<std::mutex> lock(session->mutex);
+        in_use = session->streams > 0 || session->posts > 0;
+    }
+    if (in_use) return schedule_idle_check(session_id, timeout);
+
+    auto idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+        - std::chrono::nanoseconds(session->last_active_ns.load(std::memory_order_relaxed)));
+    if (idle < timeout) return schedule_idle_check(session_id, timeout - idle);
+    if (remove_session(session_id)) evicted_sessions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool HttpServerTransport::evict_for_new_session() {
+    while (session_count_.load(std::memory_order_relaxed) >= opts_.max_sessions) {
+        // The oldest of the idle lists' fronts; a session with a POST or
+        // GET stream is never evicted
+        std::string victim;
+        int64_t oldest = INT64_MAX;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.lru.mutex);
+            if (shard.lru.idle.empty()) continue;
+            HttpSession* session = shard.lru.idle.front();
+            int64_t used = session->last_active_ns.load(std::memory_order_relaxed);
+            if (used >= oldest) continue;
+            victim = session->id;
+            oldest = used;
+        }
+        if (victim.empty()) return false;
+        // It may have been taken up since; then look again
+        if (remove_session(victim, true)) evicted_sessions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+HttpServerTransport::SessionInfo HttpServerTransport::describe(HttpSession& session) {
+    // Rough per-node cost of the maps and deques that hold session state
+    constexpr size_t kNodeBytes = 64;
+    SessionInfo info;
+    info.id = session.id;
+    info.memory_bytes = sizeof(HttpSession) + session.id.capacity();
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        info.subscriptions = session.subscriptions.size();
+        for (const auto& uri : session.subscriptions) {
+            // Its entry in the session and the session's in subscribers_
+            info.memory_bytes += 2 * (kNodeBytes + sizeof(std::string)) + uri.capacity()
+                               + session.id.capacity();
+        }
+    }
+    std::lock_guard<std::mutex> lock(session.mutex);
+    info.queued_events = session.outbox.size();
+    info.replay_events = session.replay.size();
+    info.streams = session.streams;
+    info.memory_bytes += session.outbox.size() * sizeof(OutboundFrame) + session.outbox_bytes
+                       + session.replay.memory() + session.wakers.size() * kNodeBytes;
+    if (session.streams == 0 && session.posts == 0) {
+        info.idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+            - std::chrono::nanoseconds(session.last_active_ns.load(std::memory_order_relaxed)));
+    }
+    return info;
+}
+
+std::optional<HttpServerTransport::SessionInfo>
+HttpServerTransport::session_info(const std::string& session_id) {
+    auto session = find_session(session_id);
+    if (!session) return std::nullopt;
+    return describe(*session);
+}
+
+std::vector<HttpServerTransport::SessionInfo> HttpServerTransport::sessions() {
+    std::vector<SessionInfo> out;
+    std::vector<std::shared_ptr<HttpSession>> shard_sessions;
+    for (auto& shard : shards_) {
+        shard_sessions.clear();
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto& [id, session] : shard.sessions) shard_sessions.push_back(session);
+        }
+        for (auto& session : shard_sessions) out.push_back(describe(*session));
+    }
+    return out;
+}
+
+void HttpServerTransport::enqueue(HttpSession& session, OutboundFrame frame) {
+    const auto& limits = opts_.outbound_limits;
+    std::unique_lock<std::mutex> lock(session.mutex);
+    // Without a stream there is nowhere to deliver it, unless one may
+    // resume and ask for it
+    auto attached = [&] { return session.streams > 0 && !session.closed; };
+    if (!attached() && !(session.resumable && !session.closed)) return;
+
+    if (limits.policy == OverflowPolicy::Block && attached()) {
+        size_t size = frame.data.size();
+        ++session.blocked;
+        session.cv.wait(lock, [&] {
+            return !attached() || session.outbox.empty()
+                || !exceeds(limits, session.outbox.size() + 1, session.outbox_bytes + size);
+        });
+        --session.blocked;
+    }
+    if (session.closed) return;
+
+    if (session.resumable) {
+        uint64_t id = ++session.last_event_id;
+        frame.data.insert(0, "id: " + std::to_string(id) + "\n");
+        session.replay.push(id, frame.data);
+    }
+    if (!attached()) return;
+
+    size_t size = frame.data.size();
+    session.outbox.push_back(std::move(frame));
+    session.outbox_bytes += size;
+    auto shed_result = shed(session.outbox, limits, session.outbox.size(), session.outbox_bytes);
+    session.outbox_bytes -= shed_result.bytes;
+    session.dropped += shed_result.dropped;
+    session.coalesced += shed_result.coalesced;
+    wake_streams(session);
+}
+
+std::string HttpServerTransport::attach_stream(HttpSession& session,
+                                               const std::string& last_event_id) {
+    ++session.streams;
+    touch(session);
+    std::string replay;
+    if (!session.replay.enabled()) return replay;
+    session.resumable = true;
+
+    uint64_t last = 0;
+    const char* end = last_event_id.data() + last_event_id.size();
+    auto [ptr, ec] = std::from_chars(last_event_id.data(), end, last);
+    if (last_event_id.empty() || ec != std::errc() || ptr != end) return replay;
+    // Events still queued for a stream that has gone are replayed from
+    // the buffer instead. A client away longer than the buffer covers
+    // gets what is left and has to re-list anyway.
+    session.outbox.clear();
+    session.outbox_bytes = 0;
+    if (session.blocked > 0) session.cv.notify_all();
+    (void)session.replay.replay_after(last, replay);
+    return replay;
+}
+
+void HttpServerTransport::broadcast(const OutboundFrame& frame) {
+    // Shard locks are held only to collect sessions: enqueue may block
+    std::vector<std::shared_ptr<HttpSession>> targets;
+    for (auto& shard : shards_) {
+        targets.clear();
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto& [id, session] : shard.sessions) targets.push_back(session);
+        }
+        for (auto& session : targets) enqueue(*session, frame);
+    }
+}
+
+HttpServerTransport::Stats HttpServerTransport::stats() {
+    Stats s;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.sessions += shard.sessions.size();
+        for (auto& [id, session] : shard.sessions) {
+            std::lock_guard<std::mutex> slock(session->mutex);
+            s.queued_events += session->outbox.size();
+            s.queued_bytes += session->outbox_bytes;
+            s.dropped_events += session->dropped;
+            s.coalesced_events += session->coalesced;
+        }
+    }
+    for (const auto& info : sessions()) s.memory_bytes += info.memory_bytes;
+    s.evicted_sessions = evicted_sessions_.load(std::memory_order_relaxed);
+    return s;
+}
+
 void HttpServerTransport::start(MessageCallback on_message, ErrorCallback on_error) {
+    start_sessions([on_message = std::move(on_message)](const std::string&, JsonRpcMessage msg) {
+        if (on_message) on_message(std::move(msg));
+    }, std::move(on_error), nullptr);
+}
+
+void HttpServerTransport::start_sessions(SessionMessageCallback on_message, ErrorCallback on_error,
+                                         SessionClosedCallback on_session_closed) {
     if (running_.exchange(true)) return;
 
     message_callback_ = std::move(on_message);
     error_callback_ = std::move(on_error);
+    session_closed_callback_ = std::move(on_session_closed);
+    if (opts_.session_idle_timeout.count() > 0) idle_timers_.start();
+
+    if (native_) {
+        try {
+            native_->run();
+        } catch (...) {
+            running_ = false;
+            throw;
+        }
+        return;
+    }
 
     setup_routes();
 
+    // Each connection holds a worker while its POST waits for responses
+    size_t workers = static_cast<size_t>(std::max(1, opts_.max_connections));
+    server_->new_task_queue = [workers] { return new httplib::ThreadPool(workers); };
+
     // Run server in blocking mode
     if (!server_->listen(opts_.host, opts_.port)) {
         running_ = false;
@@ -267,49 +1516,370 @@ void HttpServerTransport::start(MessageCallback on_message, ErrorCallback on_err
     }
 }
 
-void HttpServerTransport::send(const JsonRpcMessage& msg) {
-    nlohmann::json j;
-    to_json(j, msg);
+struct HttpServerTransport::PendingPost {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<RequestId> original_ids;  // by slot
+    std::vector<int64_t> wire_ids;        // by slot
+    std::vector<bool> answered;           // by slot
+    struct Ready {
+        std::string text;
+        JsonStream rest;  // streamed result to write after `text`, then '}'
+    };
+    std::vector<Ready> ready;             // serialized, in arrival order
+    size_t remaining = 0;
+    bool streaming = false;  // SSE response: related notifications go here too
+};
+
+// The request's _meta.progressToken, or null if it has none
+static nlohmann::json* find_progress_token(JsonRpcRequest& req) {
+    nlohmann::json* meta = req.meta ? &*req.meta : nullptr;
+    if (!meta && req.params) {
+        // Skip building the DOM for the common request without a token
+        auto raw = req.params.raw();
+        if (raw && raw->find("progressToken") == std::string_view::npos) return nullptr;
+        auto& params = *req.params;
+        if (!params.is_object()) return nullptr;
+        auto it = params.find("_meta");
+        if (it != params.end()) meta = &*it;
+    }
+    if (!meta || !meta->is_object()) return nullptr;
+    auto it = meta->find("progressToken");
+    return it == meta->end() ? nullptr : &*it;
+}
+
+std::shared_ptr<HttpServerTransport::PendingPost> HttpServerTransport::admit(
+        const std::string& session_id, std::vector<JsonRpcMessage>& msgs, bool streaming) {
+    auto post = std::make_shared<PendingPost>();
+    post->streaming = streaming;
+
+    // Track subscriptions so resources/updated can be targeted
+    for (const auto& msg : msgs) {
+        const auto* req = std::get_if<JsonRpcRequest>(&msg);
+        if (!req || !req->params) continue;
+        bool subscribe = req->method == "resources/subscribe";
+        if (!subscribe && req->method != "resources/unsubscribe") continue;
+        std::string uri;
+        try {
+            uri = req->params->at("uri").get<std::string>();
+        } catch (const std::exception&) {
+            continue;  // the server rejects it
+        }
+        auto session = find_session(session_id);
+        if (!session) continue;
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        if (subscribe) {
+            subscribers_[uri].insert(session_id);
+            session->subscriptions.insert(uri);
+        } else if (auto it = subscribers_.find(uri); it != subscribers_.end()) {
+            it->second.erase(session_id);
+            if (it->second.empty()) subscribers_.erase(it);
+            session->subscriptions.erase(uri);
+        }
+    }
 
-    // If a synchronous POST handler is capturing responses, deliver there.
+    std::lock_guard<std::mutex> lock(inflight_mutex_);
+    for (auto& msg : msgs) {
+        if (auto* req = std::get_if<JsonRpcRequest>(&msg)) {
+            int64_t wire_id = next_request_id_++;
+            size_t slot = post->original_ids.size();
+            post->original_ids.push_back(req->id);
+            post->wire_ids.push_back(wire_id);
+            post->answered.push_back(false);
+            ++post->remaining;
+            // Progress tokens are only unique per session too; the wire id
+            // stands in for one so progress can be traced to its request
+            std::optional<nlohmann::json> token;
+            if (auto* t = find_progress_token(*req)) token = std::exchange(*t, wire_id);
+            inflight_[wire_id] = InflightRequest{post, slot, std::move(req->id), session_id,
+                                                 std::move(token)};
+            req->id = wire_id;
+        } else if (auto* notif = std::get_if<JsonRpcNotification>(&msg);
+                   notif && notif->method == "notifications/cancelled" && notif->params) {
+            // The peer names the request by its own id; translate it
+            nlohmann::json params = *notif->params;
+            if (!params.contains("requestId")) continue;
+            RequestId target;
+            try {
+                from_json(params.at("requestId"), target);
+            } catch (const std::exception&) {
+                continue;
+            }
+            for (const auto& [wire_id, entry] : inflight_) {
+                if (entry.session_id == session_id && entry.original_id == target) {
+                    params["requestId"] = wire_id;
+                    notif->params = std::move(params);
+                    break;
+                }
+            }
+        }
+    }
+    return post;
+}
+
+bool HttpServerTransport::deliver(const JsonRpcMessage& msg) {
+    const auto* resp = std::get_if<JsonRpcResponse>(&msg);
+    if (!resp) return false;
+    const auto* wire_id = std::get_if<int64_t>(&resp->id);
+    if (!wire_id) return false;
+
+    InflightRequest entry;
     {
-        std::lock_guard<std::mutex> lock(response_capture_mutex_);
-        if (response_capture_) {
-            response_capture_->push_back(std::move(j));
-            return;
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        auto it = inflight_.find(*wire_id);
+        if (it == inflight_.end()) return false;
+        entry = std::move(it->second);
+        inflight_.erase(it);
+    }
+
+    // Restore the id the peer used. A streamed result is only written as it
+    // is produced on an SSE response; a JSON body collects it here.
+    JsonRpcResponse restored = *resp;
+    restored.id = std::move(entry.original_id);
+    PendingPost::Ready ready;
+    if (restored.result_stream && entry.post->streaming) {
+        Codec::serialize_result_head(ready.text, restored.id);
+        ready.rest = std::move(restored.result_stream);
+    } else {
+        ready.text = Codec::serialize(restored);
+    }
+
+    auto& post = *entry.post;
+    std::lock_guard<std::mutex> lock(post.mutex);
+    if (post.answered[entry.slot]) return true;
+    post.answered[entry.slot] = true;
+    post.ready.push_back(std::move(ready));
+    --post.remaining;
+    post.cv.notify_all();
+    return true;
+}
+
+void HttpServerTransport::release(PendingPost& post) {
+    std::lock_guard<std::mutex> lock(inflight_mutex_);
+    for (int64_t wire_id : post.wire_ids) inflight_.erase(wire_id);
+}
+
+void HttpServerTransport::run_post(const std::string& session_id,
+                                   std::vector<JsonRpcMessage> msgs, bool streaming,
+                                   const ResponseCallback& on_response) {
+    SessionUse use(find_session(session_id));
+    auto post = admit(session_id, msgs, streaming);
+    for (auto& m : msgs) {
+        if (message_callback_) message_callback_(session_id, std::move(m));
+    }
+
+    // Hand responses out as they arrive, in whatever order handlers finish
+    auto deadline = std::chrono::steady_clock::now() + opts_.response_timeout;
+    std::unique_lock<std::mutex> lock(post->mutex);
+    while (true) {
+        post->cv.wait_until(lock, deadline, [&] {
+            return !post->ready.empty() || post->remaining == 0 || !running_;
+        });
+        auto ready = std::move(post->ready);
+        post->ready.clear();
+        if (!ready.empty()) {
+            lock.unlock();
+            for (auto& r : ready) on_response(std::move(r.text), r.rest);
+            lock.lock();
+            continue;
+        }
+        if (post->remaining == 0 || !running_
+            || std::chrono::steady_clock::now() >= deadline) {
+            break;
         }
     }
 
-    // Otherwise broadcast to all connected SSE clients
-    std::string event = "data: " + j.dump() + "\n\n";
+    // Anything still unanswered gets an error so the peer is not left hanging
+    std::vector<std::string> failed;
+    for (size_t slot = 0; slot < post->answered.size(); ++slot) {
+        if (post->answered[slot]) continue;
+        post->answered[slot] = true;
+        JsonRpcResponse err;
+        err.id = post->original_ids[slot];
+        err.error = JsonRpcError{error::InternalError,
+                                 running_ ? "Request timed out" : "Server shutting down",
+                                 std::nullopt};
+        failed.push_back(Codec::serialize(err));
+    }
+    lock.unlock();
+    release(*post);
+    for (auto& text : failed) on_response(std::move(text), nullptr);
+}
+
+std::vector<JsonRpcMessage> HttpServerTransport::parse_post_body(const std::string& body, bool& is_batch) {
+    is_batch = !body.empty() && body[0] == '[';
+    std::vector<JsonRpcMessage> msgs;
+    if (is_batch) {
+        msgs = Codec::parse_batch(body);
+    } else {
+        msgs.push_back(Codec::parse(body));
+    }
+    return msgs;
+}
+
+std::string HttpServerTransport::parse_error_body(const std::string& message) {
+    nlohmann::json err = {
+        {"jsonrpc", "2.0"},
+        {"id", nullptr},
+        {"error", {{"code", error::ParseError}, {"message", message}}}
+    };
+    return err.dump();
+}
 
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    for (auto& [id, session] : sessions_) {
-        std::lock_guard<std::mutex> slock(session->mutex);
-        if (session->sse_sender) {
-            session->sse_sender(event);
+bool HttpServerTransport::stream_post(const std::string& session_id, std::vector<JsonRpcMessage> msgs,
+                                      const std::function<bool(std::string_view)>& write) {
+    bool open = true;
+    run_post(session_id, std::move(msgs), true, [&](std::string response, const JsonStream& rest) {
+        if (!open) return;
+        std::string event = "data: " + response;
+        if (rest) {
+            // One event, written piece by piece as the result is produced
+            open = write(event);
+            for (bool more = true; open && more;) {
+                event.clear();
+                try {
+                    more = rest(event);
+                } catch (...) {
+                    open = false;  // drop the connection mid-event
+                    break;
+                }
+                if (!event.empty()) open = write(event);
+            }
+            event = "}";
         }
+        event += "\n\n";
+        if (open) open = write(event);
+    });
+    if (!open) return false;
+    (void)write("event: done\ndata: {}\n\n");
+    return true;
+}
+
+std::string HttpServerTransport::collect_post(const std::string& session_id,
+                                              std::vector<JsonRpcMessage> msgs, bool is_batch) {
+    std::vector<std::string> responses;
+    run_post(session_id, std::move(msgs), false, [&](std::string response, const JsonStream&) {
+        responses.push_back(std::move(response));
+    });
+    if (!is_batch && responses.size() == 1) return std::move(responses[0]);
+    // Already serialized; join into a batch array
+    std::string body = "[";
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (i > 0) body += ',';
+        body += responses[i];
     }
+    body += ']';
+    return body;
 }
 
-void HttpServerTransport::send_to_session(const std::string& session_id, const JsonRpcMessage& msg) {
-    nlohmann::json j;
-    to_json(j, msg);
-    std::string event = "data: " + j.dump() + "\n\n";
+void HttpServerTransport::send(const JsonRpcMessage& msg) {
+    // Responses go back on the POST that carried the request. One whose
+    // POST already gave up is dropped: its id means nothing to any peer.
+    if (std::holds_alternative<JsonRpcResponse>(msg)) {
+        deliver(msg);
+        return;
+    }
+
+    if (const auto* notif = std::get_if<JsonRpcNotification>(&msg);
+        notif && route_notification(*notif)) {
+        return;
+    }
+
+    // Nothing ties it to a session (list changes, logs, server requests)
+    broadcast(OutboundFrame(sse_event(msg), msg, opts_.outbound_limits.policy));
+}
+
+bool HttpServerTransport::route_notification(const JsonRpcNotification& notif) {
+    if (!notif.params) return false;
+    const auto& params = *notif.params;
+    if (!params.is_object()) return false;
 
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    auto it = sessions_.find(session_id);
-    if (it != sessions_.end()) {
-        std::lock_guard<std::mutex> slock(it->second->mutex);
-        if (it->second->sse_sender) {
-            it->second->sse_sender(event);
+    if (notif.method == "notifications/progress") {
+        auto token = params.find("progressToken");
+        if (token == params.end() || !token->is_number_integer()) return false;
+        std::shared_ptr<PendingPost> post;
+        std::string session_id;
+        JsonRpcNotification restored;
+        {
+            std::lock_guard<std::mutex> lock(inflight_mutex_);
+            auto it = inflight_.find(token->get<int64_t>());
+            if (it == inflight_.end() || !it->second.progress_token) return false;
+            post = it->second.post;
+            session_id = it->second.session_id;
+            restored.method = notif.method;
+            restored.params = params;
+            restored.params->at("progressToken") = *it->second.progress_token;
         }
+        std::string text = Codec::serialize(restored);
+        {
+            // Prefer the request's own SSE response, ahead of its result
+            std::lock_guard<std::mutex> lock(post->mutex);
+            if (post->streaming && post->remaining > 0) {
+                post->ready.push_back({std::move(text), nullptr});
+                post->cv.notify_all();
+                return true;
+            }
+        }
+        if (auto session = find_session(session_id)) {
+            enqueue(*session, OutboundFrame("data: " + text + "\n\n", restored,
+                                            opts_.outbound_limits.policy));
+        }
+        return true;
+    }
+
+    if (notif.method == "notifications/resources/updated") {
+        auto uri = params.find("uri");
+        if (uri == params.end() || !uri->is_string()) return false;
+        std::vector<std::string> targets;
+        {
+            std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+            auto it = subscribers_.find(uri->get_ref<const std::string&>());
+            if (it != subscribers_.end()) targets.assign(it->second.begin(), it->second.end());
+        }
+        if (targets.empty()) return true;
+        OutboundFrame event(sse_event(notif), notif, opts_.outbound_limits.policy);
+        for (const auto& id : targets) {
+            if (auto session = find_session(id)) enqueue(*session, event);
+        }
+        return true;
+    }
+    return false;
+}
+
+void HttpServerTransport::send_to_session(const std::string& session_id, const JsonRpcMessage& msg) {
+    if (auto session = find_session(session_id)) {
+        enqueue(*session, OutboundFrame(sse_event(msg), msg, opts_.outbound_limits.policy));
     }
 }
 
 void HttpServerTransport::shutdown() {
     if (!running_.exchange(false)) return;
-    server_->stop();
+    idle_timers_.stop();
+    // Release POSTs still waiting so the workers can finish
+    std::vector<std::shared_ptr<PendingPost>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(inflight_mutex_);
+        for (auto& [id, entry] : inflight_) waiting.push_back(entry.post);
+    }
+    for (auto& post : waiting) {
+        std::lock_guard<std::mutex> lock(post->mutex);
+        post->cv.notify_all();
+    }
+    // And end the GET streams
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto& [id, session] : shard.sessions) {
+            std::lock_guard<std::mutex> slock(session->mutex);
+            session->closed = true;
+            relink(*session);
+            wake_streams(*session);
+        }
+    }
+    if (native_) {
+        native_->stop();
+    } else {
+        server_->stop();
+    }
 }
 
 bool HttpServerTransport::is_connected() const {
@@ -319,7 +1889,11 @@ bool HttpServerTransport::is_connected() const {
 // ---------- HttpClientTransport ----------
 
 HttpClientTransport::HttpClientTransport(const std::string& base_url)
-    : base_url_(base_url) {
+    : HttpClientTransport(base_url, Options{}) {}
+
+HttpClientTransport::HttpClientTransport(const std::string& base_url, Options opts)
+    : base_url_(base_url)
+    , opts_(opts) {
     // Parse host from URL
     // Support http://host:port/path
     std::string url = base_url;
@@ -328,11 +1902,45 @@ HttpClientTransport::HttpClientTransport(const std::string& base_url)
 
     // Extract host:port
     auto slash = url.find('/');
-    std::string hostport = (slash == std::string::npos) ? url : url.substr(0, slash);
+    hostport_ = (slash == std::string::npos) ? url : url.substr(0, slash);
+    accept_encoding_ = accept_encoding_value(opts_.compression);
+}
 
-    client_ = std::make_unique<httplib::Client>(("http://" + hostport).c_str());
-    client_->set_connection_timeout(10);
-    client_->set_read_timeout(60);
+std::unique_ptr<httplib::Client> HttpClientTransport::make_connection() const {
+    auto conn = std::make_unique<httplib::Client>(("http://" + hostport_).c_str());
+    conn->set_connection_timeout(static_cast<time_t>(opts_.connect_timeout.count()));
+    conn->set_read_timeout(static_cast<time_t>(opts_.read_timeout.count()));
+    conn->set_keep_alive(opts_.keep_alive);
+    conn->set_decompress(false);  // content codings are undone here
+    return conn;
+}
+
+std::unique_ptr<httplib::Client> HttpClientTransport::acquire_connection() {
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    const size_t limit = std::max<size_t>(1, opts_.max_connections);
+    pool_cv_.wait(lock, [&] {
+        return !running_ || !idle_.empty() || open_connections_ < limit;
+    });
+    if (!running_) return nullptr;
+    if (!idle_.empty()) {
+        auto conn = std::move(idle_.back());
+        idle_.pop_back();
+        return conn;
+    }
+    ++open_connections_;
+    lock.unlock();
+    // Connecting happens on first use, outside the lock
+    return make_connection();
+}
+
+void HttpClientTransport::release_connection(std::unique_ptr<httplib::Client> conn, bool reusable) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (reusable && running_) {
+        idle_.push_back(std::move(conn));
+    } else {
+        --open_connections_;
+    }
+    pool_cv_.notify_one();
 }
 
 HttpClientTransport::~HttpClientTransport() {
@@ -360,7 +1968,7 @@ void HttpClientTransport::start(MessageCallback on_message, ErrorCallback on_err
     shutdown_cv_.wait(lock, [this] { return !running_.load(); });
 }
 
-void HttpClientTransport::send(const JsonRpcMessage& msg) {
+void HttpClientTransport::wait_connected() {
     // Wait for start() to have initialized message_callback_ and connected_.
     {
         std::unique_lock<std::mutex> lock(ready_mutex_);
@@ -371,9 +1979,20 @@ void HttpClientTransport::send(const JsonRpcMessage& msg) {
     if (!connected_) {
         throw McpTransportError("Not connected");
     }
+}
 
-    std::string body = Codec::serialize(msg);
+void HttpClientTransport::send(const JsonRpcMessage& msg) {
+    wait_connected();
+    post(Codec::serialize(msg));
+}
 
+void HttpClientTransport::send_batch(const std::vector<JsonRpcMessage>& msgs) {
+    if (msgs.size() == 1) return send(msgs.front());
+    wait_connected();
+    post(Codec::serialize_batch(msgs));
+}
+
+void HttpClientTransport::post(const std::string& body) {
     // Extract path from base_url
     std::string path = extract_path();
 
@@ -382,35 +2001,172 @@ void HttpClientTransport::send(const JsonRpcMessage& msg) {
         {"Accept", "application/json"},
         {"MCP-Protocol-Version", std::string(PROTOCOL_VERSION)}
     };
-    if (!session_id_.empty()) {
-        headers.emplace("Mcp-Session-Id", session_id_);
+    {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        if (!session_id_.empty()) headers.emplace("Mcp-Session-Id", session_id_);
+    }
+    if (!accept_encoding_.empty()) headers.emplace("Accept-Encoding", accept_encoding_);
+    const ContentCoding coding = body.size() >= opts_.compression_min_bytes
+                                     ? request_coding_.load(std::memory_order_relaxed)
+                                     : ContentCoding::Identity;
+    std::string packed;
+    if (coding != ContentCoding::Identity) {
+        packed = compress(body, coding);
+        headers.emplace("Content-Encoding", std::string(to_string(coding)));
     }
 
-    auto result = client_->Post(path, headers, body, "application/json");
+    auto conn = acquire_connection();
+    if (!conn) throw McpTransportError("Not connected");
+    auto result = conn->Post(path, headers, coding != ContentCoding::Identity ? packed : body,
+                             "application/json");
+    // A connection that failed mid-request is not trusted again
+    release_connection(std::move(conn), static_cast<bool>(result));
     if (!result) {
         throw McpTransportError("HTTP POST failed: " + httplib::to_string(result.error()));
     }
 
-    // Store session ID if returned
+    // Store session ID if returned, and open its stream for server-initiated messages
     if (result->has_header("Mcp-Session-Id")) {
-        session_id_ = result->get_header_value("Mcp-Session-Id");
+        std::string id = result->get_header_value("Mcp-Session-Id");
+        {
+            std::lock_guard<std::mutex> lock(session_mutex_);
+            session_id_ = id;
+        }
+        std::lock_guard<std::mutex> lock(shutdown_mutex_);
+        if (running_ && !sse_thread_.joinable()) {
+            sse_client_ = make_connection();
+            sse_thread_ = std::thread([this, id] { sse_loop(id); });
+        }
+    }
+
+    if (result->status == 415 && coding != ContentCoding::Identity) {
+        // The server no longer takes the coding it advertised
+        request_coding_.store(ContentCoding::Identity, std::memory_order_relaxed);
+        return post(body);
+    }
+    // Request bodies may be sent in a coding the server lists (RFC 7694)
+    if (!opts_.compression.empty() && result->has_header("Accept-Encoding")) {
+        request_coding_.store(negotiate_coding(result->get_header_value("Accept-Encoding"),
+                                               opts_.compression),
+                              std::memory_order_relaxed);
     }
 
     if (result->status >= 400) {
         throw McpTransportError("HTTP error: " + std::to_string(result->status));
     }
 
-    // Parse response if it's JSON
-    if (!result->body.empty()) {
+    std::optional<std::string> decoded;
+    if (result->has_header("Content-Encoding")) {
+        auto reply_coding = parse_content_coding(result->get_header_value("Content-Encoding"));
+        if (!reply_coding || !coding_available(*reply_coding)) {
+            throw McpTransportError("Unsupported Content-Encoding: "
+                                    + result->get_header_value("Content-Encoding"));
+        }
         try {
-            auto resp_msg = Codec::parse(result->body);
-            if (message_callback_) message_callback_(std::move(resp_msg));
+            decoded = decompress(result->body, *reply_coding, opts_.max_body_bytes);
+        } catch (const McpParseError& e) {
+            throw McpTransportError(std::string("HTTP reply: ") + e.what());
+        }
+        if (!decoded) {
+            throw McpTransportError("HTTP reply: decompressed body exceeds "
+                                    + std::to_string(opts_.max_body_bytes) + " bytes");
+        }
+    }
+    const std::string& reply = decoded ? *decoded : result->body;
+
+    // Parse response if it's JSON; a batch is answered with an array
+    if (!reply.empty()) {
+        try {
+            if (reply.front() == '[') {
+                for (auto& resp_msg : Codec::parse_batch(reply)) {
+                    if (message_callback_) message_callback_(std::move(resp_msg));
+                }
+            } else {
+                auto resp_msg = Codec::parse(reply);
+                if (message_callback_) message_callback_(std::move(resp_msg));
+            }
         } catch (...) {
             // Might be SSE or empty
         }
     }
 }
 
+void HttpClientTransport::sse_loop(std::string session_id) {
+    // Frame events as they arrive; only data lines carry messages
+    std::string pending;
+    std::string last_event_id;
+    auto on_data = [&](const char* data, size_t len) -> bool {
+        pending.append(data, len);
+        size_t start = 0;
+        for (size_t end; (end = pending.find("\n\n", start)) != std::string::npos; start = end + 2) {
+            std::string_view event(pending.data() + start, end - start);
+            std::string_view payload;
+            while (!event.empty()) {
+                auto nl = event.find('\n');
+                std::string_view line = event.substr(0, nl);
+                event.remove_prefix(nl == std::string_view::npos ? event.size() : nl + 1);
+                constexpr std::string_view kId = "id: ";
+                constexpr std::string_view kData = "data: ";
+                if (line.substr(0, kId.size()) == kId) {
+                    last_event_id = line.substr(kId.size());
+                } else if (line.substr(0, kData.size()) == kData) {
+                    payload = line.substr(kData.size());
+                }
+            }
+            if (payload.empty()) continue;
+            try {
+                auto msg = Codec::parse(payload);
+                if (running_ && message_callback_) message_callback_(std::move(msg));
+            } catch (const McpParseError&) {
+                if (error_callback_) error_callback_(std::current_exception());
+            }
+        }
+        pending.erase(0, start);
+        return running_.load();
+    };
+    // A compressed stream is decoded before it is framed
+    std::unique_ptr<StreamDecompressor> decoder;
+    std::string decoded;
+    auto on_response = [&](const httplib::Response& res) -> bool {
+        decoder.reset();
+        if (!res.has_header("Content-Encoding")) return true;
+        auto coding = parse_content_coding(res.get_header_value("Content-Encoding"));
+        if (!coding || !coding_available(*coding)) return false;
+        if (*coding != ContentCoding::Identity) decoder = std::make_unique<StreamDecompressor>(*coding);
+        return true;
+    };
+    auto on_bytes = [&](const char* data, size_t len) -> bool {
+        if (!decoder) return on_data(data, len);
+        decoded.clear();
+        try {
+            decoder->write(std::string_view(data, len), decoded);
+        } catch (const McpParseError&) {
+            if (error_callback_) error_callback_(std::current_exception());
+            return false;
+        }
+        return on_data(decoded.data(), decoded.size());
+    };
+
+    // A dropped stream is reopened, asking with Last-Event-ID for the
+    // events missed meanwhile. The server may not offer a stream, or ends
+    // it with the session; either way the POSTs still work.
+    while (running_) {
+        httplib::Headers headers = {
+            {"Accept", "text/event-stream"},
+            {"MCP-Protocol-Version", std::string(PROTOCOL_VERSION)},
+            {"Mcp-Session-Id", session_id}
+        };
+        if (!last_event_id.empty()) headers.emplace("Last-Event-ID", last_event_id);
+        if (!accept_encoding_.empty()) headers.emplace("Accept-Encoding", accept_encoding_);
+        pending.clear();
+        auto result = sse_client_->Get(extract_path(), headers, on_response, on_bytes);
+        if (result && result->status != 200) return;
+
+        std::unique_lock<std::mutex> lock(shutdown_mutex_);
+        shutdown_cv_.wait_for(lock, opts_.sse_retry, [this] { return !running_.load(); });
+    }
+}
+
 std::string HttpClientTransport::extract_path() const {
     std::string url = base_url_;
     if (url.substr(0, 7) == "http://") url = url.substr(7);
@@ -422,7 +2178,24 @@ std::string HttpClientTransport::extract_path() const {
 void HttpClientTransport::shutdown() {
     if (!running_.exchange(false)) return;
     connected_ = false;
+    {
+        // Fail sends waiting for a connection
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_cv_.notify_all();
+    }
+    std::lock_guard<std::mutex> lock(shutdown_mutex_);
     shutdown_cv_.notify_all();
+    if (sse_thread_.joinable()) {
+        // Ending the session closes its GET stream from the server side
+        std::string session_id;
+        {
+            std::lock_guard<std::mutex> slock(session_mutex_);
+            session_id = session_id_;
+        }
+        httplib::Headers headers = {{"Mcp-Session-Id", session_id}};
+        make_connection()->Delete(extract_path(), headers);
+        if (sse_client_) sse_client_->stop();
+    }
 }
 
 bool HttpClientTransport::is_connected() const {
@@ -0,0 +1,54 @@
+#include "mcp/transport/outbound.hpp"
+#include <algorithm>
+
+namespace mcp {
+
+OutboundFrame::OutboundFrame(std::string text, const JsonRpcMessage& msg, OverflowPolicy policy)
+    : data(std::move(text)) {
+    const auto* notif = std::get_if<JsonRpcNotification>(&msg);
+    if (!notif) return;
+    droppable = true;
+    if (policy != OverflowPolicy::CoalesceProgress
+        || notif->method != "notifications/progress" || !notif->params) {
+        return;
+    }
+    const auto& params = *notif->params;
+    if (!params.is_object()) return;
+    auto token = params.find("progressToken");
+    if (token != params.end()) coalesce_key = token->dump();
+}
+
+ShedResult shed(std::deque<OutboundFrame>& queue, const OutboundLimits& limits,
+                size_t messages, size_t bytes) {
+    ShedResult result;
+    if (queue.empty() || limits.policy == OverflowPolicy::Block) return result;
+    auto over = [&] { return exceeds(limits, messages - result.dropped - result.coalesced,
+                                     bytes - result.bytes); };
+    if (!over()) return result;
+
+    // Earlier updates for the newest frame's token are stale anyway
+    const std::string key = queue.back().coalesce_key;
+    if (!key.empty()) {
+        auto last = std::prev(queue.end());
+        auto keep = std::remove_if(queue.begin(), last, [&](const OutboundFrame& f) {
+            if (f.coalesce_key != key) return false;
+            ++result.coalesced;
+            result.bytes += f.data.size();
+            return true;
+        });
+        queue.erase(keep, last);
+    }
+
+    for (auto it = queue.begin(); it != queue.end() && over();) {
+        if (!it->droppable) {
+            ++it;
+            continue;
+        }
+        ++result.dropped;
+        result.bytes += it->data.size();
+        it = queue.erase(it);
+    }
+    return result;
+}
+
+} // namespace mcp
@@ -0,0 +1,436 @@
+#include "mcp/transport/shm_transport.hpp"
+#include "mcp/transport/line_buffer.hpp"
+#include "mcp/codec.hpp"
+#include "mcp/error.hpp"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace mcp {
+
+// Control words of one direction, each on a cache line of its own so the
+// two processes don't bounce a line between them on every message
+struct ShmTransport::Ring {
+    alignas(64) std::atomic<uint64_t> head{0};  // bytes consumed by the reader
+    alignas(64) std::atomic<uint64_t> tail{0};  // bytes published by the writer
+    alignas(64) std::atomic<uint32_t> reader_sleeping{0};
+};
+
+struct ShmTransport::Header {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t ring_bytes = 0;
+    Ring rings[2];  // [0]: creator to attacher, [1]: attacher to creator
+};
+
+namespace {
+
+constexpr uint32_t kMagic = 0x5350434d;  // "MCPS"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kMinRingBytes = 4096;
+constexpr size_t kPageBytes = 4096;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "ring indices are shared between processes");
+
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// The rings start on the page after the header
+constexpr size_t page_align(size_t n) {
+    return (n + kPageBytes - 1) / kPageBytes * kPageBytes;
+}
+
+[[noreturn]] void fail(const std::string& what) {
+    throw McpTransportError("Shared-memory transport: " + what + ": " + std::strerror(errno));
+}
+
+// Copies between a ring of `size` (a power of two) bytes and flat memory,
+// in two pieces where the range wraps
+void copy_in(char* ring, uint64_t size, uint64_t pos, const char* src, size_t n) {
+    size_t at = static_cast<size_t>(pos & (size - 1));
+    size_t first = std::min<size_t>(n, size - at);
+    std::memcpy(ring + at, src, first);
+    std::memcpy(ring, src + first, n - first);
+}
+
+void copy_out(const char* ring, uint64_t size, uint64_t pos, char* dst, size_t n) {
+    size_t at = static_cast<size_t>(pos & (size - 1));
+    size_t first = std::min<size_t>(n, size - at);
+    std::memcpy(dst, ring + at, first);
+    std::memcpy(dst + first, ring, n - first);
+}
+
+} // anonymous namespace
+
+ShmTransport::ShmTransport(int socket_fd, Role role)
+    : ShmTransport(socket_fd, role, Options{}) {
+}
+
+ShmTransport::ShmTransport(int socket_fd, Role role, Options opts)
+    : socket_fd_(socket_fd), opts_(opts) {
+    ::fcntl(socket_fd_, F_SETFD, FD_CLOEXEC);
+    try {
+        if (role == Role::Create) {
+            create_region();
+        } else {
+            attach_region();
+        }
+    } catch (...) {
+        if (region_) ::munmap(region_, region_bytes_);
+        ::close(socket_fd_);
+        throw;
+    }
+    // From here on the socket is only for doorbells
+    int flags = ::fcntl(socket_fd_, F_GETFL, 0);
+    ::fcntl(socket_fd_, F_SETFL, flags | O_NONBLOCK);
+}
+
+ShmTransport::~ShmTransport() {
+    shutdown();
+    // Whoever ran start() has seen it return by now, so nothing reads the mapping
+    if (region_) ::munmap(region_, region_bytes_);
+    ::close(socket_fd_);
+}
+
+void ShmTransport::create_region() {
+    ring_bytes_ = std::bit_ceil(std::max(opts_.ring_bytes, kMinRingBytes));
+    region_bytes_ = page_align(sizeof(Header)) + 2 * ring_bytes_;
+
+    int memfd = ::memfd_create("mcpxx-shm", MFD_CLOEXEC);
+    if (memfd < 0) fail("memfd_create");
+    if (::ftruncate(memfd, static_cast<off_t>(region_bytes_)) < 0) {
+        ::close(memfd);
+        fail("ftruncate");
+    }
+    region_ = ::mmap(nullptr, region_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        ::close(memfd);
+        fail("mmap");
+    }
+    auto* header = new (region_) Header();
+    header->magic = kMagic;
+    header->version = kVersion;
+    header->ring_bytes = ring_bytes_;
+
+    // Hand the memfd over with a byte of payload to carry it
+    char byte = 'M';
+    iovec iov{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(socket_fd_, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    ::close(memfd);  // the mapping keeps the memory
+    if (sent != 1) fail("sending the ring pair");
+
+    char* data = static_cast<char*>(region_) + page_align(sizeof(Header));
+    tx_ = &header->rings[0];
+    rx_ = &header->rings[1];
+    tx_data_ = data;
+    rx_data_ = data + ring_bytes_;
+}
+
+void ShmTransport::attach_region() {
+    char byte = 0;
+    iovec iov{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t got;
+    do {
+        got = ::recvmsg(socket_fd_, &msg, MSG_CMSG_CLOEXEC);
+    } while (got < 0 && errno == EINTR);
+    if (got < 0) fail("receiving the ring pair");
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (got != 1 || byte != 'M' || !cmsg || cmsg->cmsg_type != SCM_RIGHTS) {
+        errno = EPROTO;
+        fail("peer sent no ring pair");
+    }
+    int memfd;
+    std::memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+
+    struct stat st{};
+    if (::fstat(memfd, &st) < 0) {
+        ::close(memfd);
+        fail("fstat");
+    }
+    region_bytes_ = static_cast<size_t>(st.st_size);
+    if (region_bytes_ < page_align(sizeof(Header))) {
+        ::close(memfd);
+        errno = EPROTO;
+        fail("ring pair too small");
+    }
+    region_ = ::mmap(nullptr, region_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    ::close(memfd);
+    if (region_ == MAP_FAILED) {
+        region_ = nullptr;
+        fail("mmap");
+    }
+    auto* header = static_cast<Header*>(region_);
+    ring_bytes_ = header->ring_bytes;
+    if (header->magic != kMagic || header->version != kVersion
+        || !std::has_single_bit(ring_bytes_)
+        || page_align(sizeof(Header)) + 2 * ring_bytes_ != region_bytes_) {
+        errno = EPROTO;
+        fail("not an mcpxx ring pair");
+    }
+
+    char* data = static_cast<char*>(region_) + page_align(sizeof(Header));
+    tx_ = &header->rings[1];
+    rx_ = &header->rings[0];
+    tx_data_ = data + ring_bytes_;
+    rx_data_ = data;
+}
+
+void ShmTransport::start(MessageCallback on_message, ErrorCallback on_error) {
+    if (shutdown_requested_.load()) return;
+    if (running_.exchange(true)) return;
+    read_loop(on_message, on_error);
+    running_ = false;
+    connected_ = false;
+}
+
+void ShmTransport::read_loop(const MessageCallback& on_message, const ErrorCallback& on_error) {
+    LineBuffer buffer(opts_.read_chunk_size);
+    auto readable = [&] {
+        return rx_->tail.load(std::memory_order_acquire) != rx_->head.load(std::memory_order_relaxed);
+    };
+    // Moves everything in the ring into the buffer, frees the ring, then
+    // delivers the complete lines. False if the ring was empty.
+    auto drain = [&] {
+        uint64_t head = rx_->head.load(std::memory_order_relaxed);
+        uint64_t tail = rx_->tail.load(std::memory_order_acquire);
+        if (head == tail) return false;
+        while (head != tail) {
+            char* dst = buffer.write_ptr();
+            size_t n = static_cast<size_t>(std::min<uint64_t>(tail - head, buffer.write_size()));
+            copy_out(rx_data_, ring_bytes_, head, dst, n);
+            buffer.commit(n);
+            head += n;
+        }
+        rx_->head.store(head, std::memory_order_release);
+        buffer.deliver(on_message, on_error);
+        return true;
+    };
+
+    // On one CPU a spinning reader only keeps the writer from running
+    const auto spin = std::thread::hardware_concurrency() > 1 ? opts_.spin
+                                                              : std::chrono::microseconds(0);
+    bool peer_closed = false;
+    while (running_) {
+        if (drain()) continue;
+
+        // The peer is likely to answer soon; catch it without sleeping
+        auto spin_until = std::chrono::steady_clock::now() + spin;
+        bool ready = false;
+        while (!ready && std::chrono::steady_clock::now() < spin_until) {
+            cpu_relax();
+            ready = readable();
+        }
+        if (ready) continue;
+
+        // Announce the nap, then look once more: a writer that published
+        // before seeing the flag is caught here, one after it rings
+        rx_->reader_sleeping.store(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (readable()) {
+            rx_->reader_sleeping.store(0, std::memory_order_relaxed);
+            continue;
+        }
+        pollfd pfd{socket_fd_, POLLIN, 0};
+        int ret = ::poll(&pfd, 1, -1);
+        rx_->reader_sleeping.store(0, std::memory_order_relaxed);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // Doorbell bytes carry no data; EOF means the peer is gone
+        char bells[64];
+        ssize_t n;
+        while ((n = ::recv(socket_fd_, bells, sizeof(bells), 0)) > 0) {}
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            peer_closed = true;
+            break;
+        }
+    }
+    // Deliver what the peer wrote before it went
+    if (peer_closed && !shutdown_requested_) drain();
+    connected_ = false;
+}
+
+bool ShmTransport::peer_alive() const {
+    pollfd pfd{socket_fd_, POLLRDHUP, 0};
+    if (::poll(&pfd, 1, 0) < 0) return true;
+    return !(pfd.revents & (POLLRDHUP | POLLHUP | POLLERR));
+}
+
+bool ShmTransport::write_bytes(std::string_view bytes) {
+    uint64_t tail = tx_->tail.load(std::memory_order_relaxed);
+    int waits = 0;
+    while (!bytes.empty()) {
+        uint64_t used = tail - tx_->head.load(std::memory_order_acquire);
+        size_t space = static_cast<size_t>(ring_bytes_ - used);
+        if (space == 0) {
+            if (waits == 0) {
+                full_waits_.fetch_add(1, std::memory_order_relaxed);
+                ring_doorbell();  // make sure the reader is draining
+            }
+            if (shutdown_requested_ || !peer_alive()) return false;
+            // Back off from spinning to sleeping while the reader catches up
+            if (waits < 100) {
+                cpu_relax();
+            } else if (waits < 200) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            ++waits;
+            continue;
+        }
+        waits = 0;
+        size_t n = std::min(space, bytes.size());
+        copy_in(tx_data_, ring_bytes_, tail, bytes.data(), n);
+        tail += n;
+        bytes.remove_prefix(n);
+        tx_->tail.store(tail, std::memory_order_release);
+        bytes_written_.fetch_add(n, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void ShmTransport::ring_doorbell() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!tx_->reader_sleeping.load(std::memory_order_relaxed)) return;
+    if (!tx_->reader_sleeping.exchange(0, std::memory_order_acq_rel)) return;
+    // A full socket buffer already holds a wake-up for the reader
+    char bell = 1;
+    (void)::send(socket_fd_, &bell, 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+    doorbells_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ShmTransport::write_frame() {
+    if (write_bytes(frame_)) {
+        messages_written_.fetch_add(1, std::memory_order_relaxed);
+        ring_doorbell();
+    } else {
+        connected_ = false;  // dropped, as a failed pipe write is
+    }
+}
+
+void ShmTransport::send(const JsonRpcMessage& msg) {
+    if (shutdown_requested_.load()) {
+        throw McpTransportError("Transport shut down");
+    }
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    frame_.clear();
+    if (const auto* resp = std::get_if<JsonRpcResponse>(&msg); resp && resp->result_stream) {
+        // Streamed into the ring as it is produced; nothing else may be
+        // written until the line is finished
+        Codec::serialize_result_head(frame_, resp->id);
+        bool ok = write_bytes(frame_);
+        std::string piece;
+        for (bool more = true; ok && more;) {
+            piece.clear();
+            try {
+                more = resp->result_stream(piece);
+            } catch (...) {
+                // End the broken line so the peer only loses this message
+                write_bytes("\n");
+                ring_doorbell();
+                return;
+            }
+            ok = write_bytes(piece);
+            ring_doorbell();
+        }
+        frame_ = "}\n";
+        if (ok) write_frame();
+        return;
+    }
+    if (auto format = wire_format_.load(std::memory_order_relaxed); format != WireFormat::Json) {
+        BinaryCodec::encode_frame(frame_, msg, format);
+    } else {
+        Codec::serialize_to(frame_, msg);
+        frame_ += '\n';
+    }
+    write_frame();
+}
+
+void ShmTransport::send_batch(const std::vector<JsonRpcMessage>& msgs) {
+    if (shutdown_requested_.load()) {
+        throw McpTransportError("Transport shut down");
+    }
+    if (msgs.size() == 1) return send(msgs.front());
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    frame_.clear();
+    if (auto format = wire_format_.load(std::memory_order_relaxed); format != WireFormat::Json) {
+        BinaryCodec::encode_batch_frame(frame_, msgs, format);
+    } else {
+        Codec::serialize_batch_to(frame_, msgs);
+        frame_ += '\n';
+    }
+    write_frame();
+}
+
+bool ShmTransport::supports_wire_format(WireFormat) const {
+    return true;
+}
+
+bool ShmTransport::set_wire_format(WireFormat format) {
+    wire_format_.store(format, std::memory_order_relaxed);
+    return true;
+}
+
+void ShmTransport::shutdown() {
+    if (shutdown_requested_.exchange(true)) return;
+    running_ = false;
+    connected_ = false;
+    // Wakes our reader and tells the peer we are gone
+    ::shutdown(socket_fd_, SHUT_RDWR);
+}
+
+bool ShmTransport::is_connected() const {
+    return connected_;
+}
+
+ShmTransport::Stats ShmTransport::stats() const {
+    Stats s;
+    s.messages_written = messages_written_.load(std::memory_order_relaxed);
+    s.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+    s.doorbells = doorbells_.load(std::memory_order_relaxed);
+    s.full_waits = full_waits_.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace mcp
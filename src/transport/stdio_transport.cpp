@@ -1,21 +1,53 @@
 #include "mcp/transport/stdio_transport.hpp"
+#include "mcp/transport/line_buffer.hpp"
 #include "mcp/error.hpp"
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <pthread.h>
+#include <csignal>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <stdexcept>
 #include <system_error>
 
 namespace mcp {
 
+namespace {
+// Bounds on buffer reuse: frames beyond the cap are freed, and a buffer that
+// grew for one huge message is not kept around for every later small one.
+constexpr size_t kMaxPooledBuffers = 16;
+constexpr size_t kMaxPooledCapacity = 1 << 20;
+// While the peer isn't reading, the writer looks for shutdown this often
+constexpr int kWritablePollMs = 100;
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // anonymous namespace
+
 StdioTransport::StdioTransport()
-    : read_fd_(STDIN_FILENO), write_fd_(STDOUT_FILENO), owns_fds_(false) {
+    : StdioTransport(Options{}) {
+}
+
+StdioTransport::StdioTransport(Options opts)
+    : read_fd_(STDIN_FILENO), write_fd_(STDOUT_FILENO), owns_fds_(false), opts_(opts) {
 }
 
 StdioTransport::StdioTransport(int read_fd, int write_fd)
-    : read_fd_(read_fd), write_fd_(write_fd), owns_fds_(true) {
+    : StdioTransport(read_fd, write_fd, Options{}) {
+}
+
+StdioTransport::StdioTransport(int read_fd, int write_fd, Options opts)
+    : read_fd_(read_fd), write_fd_(write_fd), owns_fds_(true), opts_(opts) {
 }
 
 StdioTransport::~StdioTransport() {
@@ -25,6 +57,8 @@ StdioTransport::~StdioTransport() {
     if (owns_fds_) {
         if (read_fd_ >= 0)  ::close(read_fd_);
         if (write_fd_ >= 0) ::close(write_fd_);
+    } else if (write_fd_flags_ >= 0) {
+        fcntl(write_fd_, F_SETFL, write_fd_flags_);
     }
     if (wakeup_pipe_[0] >= 0) ::close(wakeup_pipe_[0]);
     if (wakeup_pipe_[1] >= 0) ::close(wakeup_pipe_[1]);
@@ -47,15 +81,22 @@ void StdioTransport::start(MessageCallback on_message, ErrorCallback on_error) {
     int flags = fcntl(wakeup_pipe_[1], F_GETFL, 0);
     fcntl(wakeup_pipe_[1], F_SETFL, flags | O_NONBLOCK);
 
+    // Terminals and files are left blocking: they don't stall on a peer
+    struct stat st;
+    if (fstat(write_fd_, &st) == 0 && (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode))) {
+        int wflags = fcntl(write_fd_, F_GETFL, 0);
+        if (wflags >= 0 && !(wflags & O_NONBLOCK)
+            && fcntl(write_fd_, F_SETFL, wflags | O_NONBLOCK) == 0) {
+            write_fd_flags_ = wflags;
+        }
+    }
+
     writer_thread_ = std::thread([this]() { write_loop(); });
     read_loop(std::move(on_message), std::move(on_error));
 }
 
 void StdioTransport::read_loop(MessageCallback on_message, ErrorCallback on_error) {
-    std::string buffer;
-    buffer.reserve(4096);
-
-    char chunk[4096];
+    LineBuffer buffer(opts_.read_chunk_size);
 
     while (running_) {
         // Use poll() so that shutdown() can interrupt the blocking read
@@ -77,9 +118,12 @@ void StdioTransport::read_loop(MessageCallback on_message, ErrorCallback on_erro
         // Wakeup pipe has data → shutdown() was called, exit cleanly
         if (fds[1].revents & POLLIN) break;
 
-        if (!(fds[0].revents & POLLIN)) continue;
+        // A pipe whose writer has gone reports POLLHUP alone; read() then
+        // sees the EOF
+        if (!(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
 
-        ssize_t n = ::read(read_fd_, chunk, sizeof(chunk));
+        char* dst = buffer.write_ptr();  // may compact or grow; call first
+        ssize_t n = ::read(read_fd_, dst, buffer.write_size());
         if (n < 0) {
             if (errno == EINTR) continue;
             if (errno == EAGAIN || errno == EWOULDBLOCK) continue;
@@ -103,76 +147,218 @@ void StdioTransport::read_loop(MessageCallback on_message, ErrorCallback on_erro
             break;
         }
 
-        buffer.append(chunk, static_cast<size_t>(n));
+        buffer.commit(static_cast<size_t>(n));
 
-        // Process complete lines
-        size_t pos = 0;
-        while (true) {
-            size_t nl = buffer.find('\n', pos);
-            if (nl == std::string::npos) break;
+        buffer.deliver(on_message, on_error);
+    }
+}
 
-            std::string line = buffer.substr(pos, nl - pos);
-            pos = nl + 1;
+void StdioTransport::write_loop() {
+    // A peer that has exited makes writes fail with EPIPE instead of
+    // raising SIGPIPE, which would end the whole process
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
 
-            if (line.empty()) continue;
+    std::vector<OutboundFrame> batch;
+    const size_t max_batch = std::clamp<size_t>(opts_.max_batch_messages, 1, IOV_MAX);
+    const auto& limits = opts_.outbound_limits;
+    const bool may_block = limits.policy == OverflowPolicy::Block
+                           && (limits.max_messages || limits.max_bytes);
 
-            // Remove trailing \r if present (CRLF)
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            if (line.empty()) continue;
-
-            try {
-                auto msg = Codec::parse(line);
-                on_message(std::move(msg));
-            } catch (const std::exception& e) {
-                if (on_error) {
-                    try {
-                        throw McpParseError(e.what());
-                    } catch (...) {
-                        on_error(std::current_exception());
-                    }
-                }
-            }
+    // Takes at most one batch; the rest stays staged, where a sender over
+    // the limits can still drop from it
+    auto take = [&] {
+        std::lock_guard<std::mutex> lock(staged_mutex_);
+        write_queue_.drain_into(staged_);
+        size_t n = std::min(max_batch - batch.size(), staged_.size());
+        for (size_t i = 0; i < n; ++i) {
+            batch.push_back(std::move(staged_.front()));
+            staged_.pop_front();
         }
+    };
 
-        if (pos > 0) {
-            buffer = buffer.substr(pos);
+    while (true) {
+        uint32_t seen = write_signal_.load(std::memory_order_acquire);
+        take();
+        if (batch.empty()) {
+            // Keep writing after input EOF: responses may still be in flight
+            if (shutdown_requested_) break;
+            write_signal_.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        // Let a burst catch up so it goes out in one writev()
+        if (opts_.flush_latency.count() > 0 && batch.size() < max_batch) {
+            std::this_thread::sleep_for(opts_.flush_latency);
+            take();
+        }
+
+        // On a write error the batch is dropped, like a failed single write was
+        bool ok = flush(batch);
+        size_t bytes = 0;
+        for (auto& frame : batch) {
+            bytes += frame.data.size();
+            release_buffer(std::move(frame.data));
+        }
+        queued_messages_.fetch_sub(batch.size(), std::memory_order_relaxed);
+        queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        batch.clear();
+        if (may_block) {
+            std::lock_guard<std::mutex> lock(staged_mutex_);
+            space_cv_.notify_all();
+        }
+        if (!ok && drain_expired()) {
+            // The peer stopped reading; what is left would never go out
+            discard_queued();
+            break;
         }
     }
 }
 
-void StdioTransport::write_loop() {
+void StdioTransport::discard_queued() {
+    std::lock_guard<std::mutex> lock(staged_mutex_);
+    write_queue_.drain_into(staged_);
+    size_t bytes = 0;
+    for (auto& frame : staged_) bytes += frame.data.size();
+    dropped_messages_.fetch_add(staged_.size(), std::memory_order_relaxed);
+    queued_messages_.fetch_sub(staged_.size(), std::memory_order_relaxed);
+    queued_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    staged_.clear();
+    space_cv_.notify_all();
+}
+
+bool StdioTransport::drain_expired() const {
+    int64_t deadline = drain_deadline_ns_.load(std::memory_order_acquire);
+    return shutdown_requested_ && deadline != 0 && steady_now_ns() >= deadline;
+}
+
+bool StdioTransport::wait_writable() {
     while (true) {
-        std::string msg_to_write;
-        {
-            std::unique_lock<std::mutex> lock(write_mutex_);
-            write_cv_.wait(lock, [this] {
-                return !write_queue_.empty() || !running_;
-            });
-
-            if (!running_ && write_queue_.empty()) break;
-            if (!write_queue_.empty()) {
-                msg_to_write = std::move(write_queue_.front());
-                write_queue_.pop();
+        int timeout = kWritablePollMs;
+        if (shutdown_requested_) {
+            int64_t deadline = drain_deadline_ns_.load(std::memory_order_acquire);
+            int64_t left = deadline - steady_now_ns();
+            if (deadline != 0 && left <= 0) return false;
+            if (deadline != 0) {
+                timeout = static_cast<int>(std::min<int64_t>(left / 1000000 + 1, kWritablePollMs));
             }
         }
+        struct pollfd fd{write_fd_, POLLOUT, 0};
+        int ret = ::poll(&fd, 1, timeout);
+        if (ret < 0 && errno != EINTR) return false;
+        // A closed reader shows as POLLERR/POLLHUP; the write then fails
+        if (ret > 0) return true;
+    }
+}
+
+bool StdioTransport::flush(std::vector<OutboundFrame>& frames) {
+    const size_t max_batch = std::clamp<size_t>(opts_.max_batch_messages, 1, IOV_MAX);
+    std::vector<iovec> iov;
+    iov.reserve(std::min(max_batch, frames.size()));
+
+    for (size_t next = 0; next < frames.size();) {
+        if (frames[next].stream) {
+            if (!write_stream(frames[next])) return false;
+            ++next;
+            continue;
+        }
+
+        // A run of whole frames, stopping short of the next streamed one
+        size_t count = 0;
+        iov.clear();
+        while (count < max_batch && next + count < frames.size() && !frames[next + count].stream) {
+            auto& data = frames[next + count].data;
+            iov.push_back({data.data(), data.size()});
+            ++count;
+        }
 
-        if (!msg_to_write.empty()) {
-            msg_to_write += '\n';
-            const char* data = msg_to_write.data();
-            size_t remaining = msg_to_write.size();
+        size_t idx = 0;
+        while (idx < iov.size()) {
+            ssize_t written = ::writev(write_fd_, iov.data() + idx,
+                                       static_cast<int>(iov.size() - idx));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_writable()) continue;
+                return false;
+            }
+            write_calls_.fetch_add(1, std::memory_order_relaxed);
+            bytes_written_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
 
-            while (remaining > 0) {
-                ssize_t written = ::write(write_fd_, data, remaining);
-                if (written < 0) {
-                    if (errno == EINTR) continue;
-                    break; // Error - stop writing
-                }
-                data += written;
-                remaining -= static_cast<size_t>(written);
+            // Skip fully written frames and trim a partially written one
+            auto left = static_cast<size_t>(written);
+            while (idx < iov.size() && left >= iov[idx].iov_len) {
+                left -= iov[idx].iov_len;
+                ++idx;
             }
+            if (left > 0) {
+                iov[idx].iov_base = static_cast<char*>(iov[idx].iov_base) + left;
+                iov[idx].iov_len -= left;
+            }
+        }
+        messages_written_.fetch_add(count, std::memory_order_relaxed);
+        next += count;
+    }
+    return true;
+}
+
+bool StdioTransport::write_all(std::string_view bytes) {
+    while (!bytes.empty()) {
+        ssize_t written = ::write(write_fd_, bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && wait_writable()) continue;
+            return false;
         }
+        write_calls_.fetch_add(1, std::memory_order_relaxed);
+        bytes_written_.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+        bytes.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+bool StdioTransport::write_stream(OutboundFrame& frame) {
+    // The line cannot be interleaved with other frames, so the rest of the
+    // queue waits until the result has been drained
+    if (!write_all(frame.data)) return false;
+    std::string piece;
+    bool more = true;
+    while (more) {
+        piece.clear();
+        try {
+            more = frame.stream(piece);
+        } catch (...) {
+            // End the broken line so the peer only loses this message
+            return write_all("\n");
+        }
+        if (!write_all(piece)) return false;
+    }
+    frame.stream = nullptr;
+    if (!write_all("}\n")) return false;
+    messages_written_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void StdioTransport::wake_writer() {
+    write_signal_.fetch_add(1, std::memory_order_release);
+    write_signal_.notify_one();
+}
+
+std::string StdioTransport::acquire_buffer() {
+    std::unique_lock<std::mutex> lock(pool_mutex_, std::try_to_lock);
+    if (!lock.owns_lock() || free_buffers_.empty()) return {};
+    std::string buf = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+    return buf;
+}
+
+void StdioTransport::release_buffer(std::string buf) {
+    if (buf.capacity() > kMaxPooledCapacity) return;
+    buf.clear();
+    std::unique_lock<std::mutex> lock(pool_mutex_, std::try_to_lock);
+    if (lock.owns_lock() && free_buffers_.size() < kMaxPooledBuffers) {
+        free_buffers_.push_back(std::move(buf));
     }
 }
 
@@ -182,24 +368,119 @@ void StdioTransport::send(const JsonRpcMessage& msg) {
     if (shutdown_requested_.load()) {
         throw McpTransportError("Transport shut down");
     }
-    std::string serialized = Codec::serialize(msg);
-    {
-        std::lock_guard<std::mutex> lock(write_mutex_);
-        write_queue_.push(std::move(serialized));
+    std::string data = acquire_buffer();
+    if (const auto* resp = std::get_if<JsonRpcResponse>(&msg); resp && resp->result_stream) {
+        // Written as it is produced, by the writer thread
+        OutboundFrame frame;
+        Codec::serialize_result_head(data, resp->id);
+        frame.data = std::move(data);
+        frame.stream = resp->result_stream;
+        return enqueue(std::move(frame));
     }
-    write_cv_.notify_one();
+    // Serialize straight into a recycled frame, newline included
+    if (auto format = wire_format_.load(std::memory_order_relaxed); format != WireFormat::Json) {
+        BinaryCodec::encode_frame(data, msg, format);
+    } else {
+        Codec::serialize_to(data, msg);
+        data += '\n';
+    }
+    enqueue(OutboundFrame(std::move(data), msg, opts_.outbound_limits.policy));
+}
+
+void StdioTransport::send_batch(const std::vector<JsonRpcMessage>& msgs) {
+    if (shutdown_requested_.load()) {
+        throw McpTransportError("Transport shut down");
+    }
+    if (msgs.size() == 1) return send(msgs.front());
+    OutboundFrame frame;  // never dropped: it may carry requests
+    frame.data = acquire_buffer();
+    if (auto format = wire_format_.load(std::memory_order_relaxed); format != WireFormat::Json) {
+        BinaryCodec::encode_batch_frame(frame.data, msgs, format);
+    } else {
+        Codec::serialize_batch_to(frame.data, msgs);
+        frame.data += '\n';
+    }
+    enqueue(std::move(frame));
+}
+
+bool StdioTransport::supports_wire_format(WireFormat) const {
+    return true;
+}
+
+bool StdioTransport::set_wire_format(WireFormat format) {
+    wire_format_.store(format, std::memory_order_relaxed);
+    return true;
+}
+
+void StdioTransport::enqueue(OutboundFrame frame) {
+    size_t size = frame.data.size();
+    size_t messages = queued_messages_.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t bytes = queued_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    if (exceeds(opts_.outbound_limits, messages, bytes)) {
+        enqueue_over_limit(std::move(frame));
+        return;
+    }
+    // Only the first frame after the writer drained needs to wake it
+    if (write_queue_.push(std::move(frame))) wake_writer();
+}
+
+void StdioTransport::enqueue_over_limit(OutboundFrame frame) {
+    const auto& limits = opts_.outbound_limits;
+    size_t size = frame.data.size();
+    std::unique_lock<std::mutex> lock(staged_mutex_);
+
+    if (limits.policy == OverflowPolicy::Block) {
+        // Uncount ourselves while waiting so blocked senders don't hold
+        // each other up; a frame bigger than the limit waits for an empty queue
+        queued_messages_.fetch_sub(1, std::memory_order_relaxed);
+        queued_bytes_.fetch_sub(size, std::memory_order_relaxed);
+        space_cv_.wait(lock, [&] {
+            size_t messages = queued_messages_.load(std::memory_order_relaxed);
+            return messages == 0 || shutdown_requested_
+                || !exceeds(limits, messages + 1,
+                            queued_bytes_.load(std::memory_order_relaxed) + size);
+        });
+        queued_messages_.fetch_add(1, std::memory_order_relaxed);
+        queued_bytes_.fetch_add(size, std::memory_order_relaxed);
+        lock.unlock();
+        if (write_queue_.push(std::move(frame))) wake_writer();
+        return;
+    }
+
+    // Pull the backlog into reach and make room in it
+    write_queue_.drain_into(staged_);
+    staged_.push_back(std::move(frame));
+    auto shed_result = shed(staged_, limits,
+                            queued_messages_.load(std::memory_order_relaxed),
+                            queued_bytes_.load(std::memory_order_relaxed));
+    queued_messages_.fetch_sub(shed_result.dropped + shed_result.coalesced,
+                               std::memory_order_relaxed);
+    queued_bytes_.fetch_sub(shed_result.bytes, std::memory_order_relaxed);
+    dropped_messages_.fetch_add(shed_result.dropped, std::memory_order_relaxed);
+    coalesced_messages_.fetch_add(shed_result.coalesced, std::memory_order_relaxed);
+    lock.unlock();
+    wake_writer();
 }
 
 void StdioTransport::shutdown() {
+    int64_t unset = 0;
+    drain_deadline_ns_.compare_exchange_strong(
+        unset, steady_now_ns() + std::chrono::nanoseconds(opts_.drain_timeout).count(),
+        std::memory_order_acq_rel);
     shutdown_requested_ = true;
+    {
+        // Release senders blocked on a full queue
+        std::lock_guard<std::mutex> lock(staged_mutex_);
+        space_cv_.notify_all();
+    }
     if (!running_.exchange(false)) {
         // start() hasn't been called yet (or already shut down).
-        // Notify write_cv_ in case write_loop is waiting, so it exits.
-        write_cv_.notify_all();
+        // Wake write_loop in case it is waiting, so it exits.
+        wake_writer();
         return;
     }
     connected_ = false;
-    write_cv_.notify_all();
+    wake_writer();
     // Write to wakeup pipe to interrupt poll() in read_loop().
     if (wakeup_pipe_[1] >= 0) {
         char b = 1;
@@ -211,4 +492,16 @@ bool StdioTransport::is_connected() const {
     return connected_;
 }
 
+StdioTransport::Stats StdioTransport::stats() const {
+    Stats s;
+    s.messages_written = messages_written_.load(std::memory_order_relaxed);
+    s.write_calls = write_calls_.load(std::memory_order_relaxed);
+    s.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+    s.queued_messages = queued_messages_.load(std::memory_order_relaxed);
+    s.queued_bytes = queued_bytes_.load(std::memory_order_relaxed);
+    s.dropped_messages = dropped_messages_.load(std::memory_order_relaxed);
+    s.coalesced_messages = coalesced_messages_.load(std::memory_order_relaxed);
+    return s;
+}
+
 } // namespace mcp
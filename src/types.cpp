@@ -1,4 +1,6 @@
 #include "mcp/types.hpp"
+#include "mcp/json_writer.hpp"
+#include "mcp/base64.hpp"
 #include <stdexcept>
 
 namespace mcp {
@@ -30,10 +32,67 @@ void from_json(const nlohmann::json& j, TextContent& t) {
     if (j.contains("annotations")) t.annotations = j.at("annotations").get<Annotations>();
 }
 
+// ---------- Binary content ----------
+
+static std::optional<std::string> blob_text(const std::optional<std::string>& blob, const Bytes& bytes) {
+    if (bytes) return base64::encode(*bytes);
+    return blob;
+}
+
+static std::optional<std::string> blob_raw(const std::optional<std::string>& blob, const Bytes& bytes) {
+    if (bytes) return *bytes;
+    if (blob) return base64::decode(*blob);
+    return std::nullopt;
+}
+
+ImageContent ImageContent::from_bytes(std::string raw, std::string mime_type) {
+    ImageContent c;
+    c.mime_type = std::move(mime_type);
+    c.bytes = std::make_shared<const std::string>(std::move(raw));
+    return c;
+}
+
+std::string ImageContent::encoded() const { return bytes ? base64::encode(*bytes) : data; }
+std::string ImageContent::decoded() const { return bytes ? *bytes : base64::decode(data); }
+
+AudioContent AudioContent::from_bytes(std::string raw, std::string mime_type) {
+    AudioContent c;
+    c.mime_type = std::move(mime_type);
+    c.bytes = std::make_shared<const std::string>(std::move(raw));
+    return c;
+}
+
+std::string AudioContent::encoded() const { return bytes ? base64::encode(*bytes) : data; }
+std::string AudioContent::decoded() const { return bytes ? *bytes : base64::decode(data); }
+
+EmbeddedResource EmbeddedResource::from_bytes(std::string uri, std::string raw,
+                                              std::optional<std::string> mime_type) {
+    EmbeddedResource r;
+    r.uri = std::move(uri);
+    r.mime_type = std::move(mime_type);
+    r.blob_bytes = std::make_shared<const std::string>(std::move(raw));
+    return r;
+}
+
+std::optional<std::string> EmbeddedResource::blob_base64() const { return blob_text(blob, blob_bytes); }
+std::optional<std::string> EmbeddedResource::decoded_blob() const { return blob_raw(blob, blob_bytes); }
+
+ResourceContent ResourceContent::from_bytes(std::string uri, std::string raw,
+                                            std::optional<std::string> mime_type) {
+    ResourceContent r;
+    r.uri = std::move(uri);
+    r.mime_type = std::move(mime_type);
+    r.blob_bytes = std::make_shared<const std::string>(std::move(raw));
+    return r;
+}
+
+std::optional<std::string> ResourceContent::blob_base64() const { return blob_text(blob, blob_bytes); }
+std::optional<std::string> ResourceContent::decoded_blob() const { return blob_raw(blob, blob_bytes); }
+
 // ---------- ImageContent ----------
 
 void to_json(nlohmann::json& j, const ImageContent& t) {
-    j = {{"type", "image"}, {"data", t.data}, {"mimeType", t.mime_type}};
+    j = {{"type", "image"}, {"data", t.encoded()}, {"mimeType", t.mime_type}};
     if (t.annotations) j["annotations"] = *t.annotations;
 }
 
@@ -46,7 +105,7 @@ void from_json(const nlohmann::json& j, ImageContent& t) {
 // ---------- AudioContent ----------
 
 void to_json(nlohmann::json& j, const AudioContent& t) {
-    j = {{"type", "audio"}, {"data", t.data}, {"mimeType", t.mime_type}};
+    j = {{"type", "audio"}, {"data", t.encoded()}, {"mimeType", t.mime_type}};
     if (t.annotations) j["annotations"] = *t.annotations;
 }
 
@@ -80,7 +139,7 @@ void to_json(nlohmann::json& j, const EmbeddedResource& t) {
     resource["uri"] = t.uri;
     if (t.mime_type) resource["mimeType"] = *t.mime_type;
     if (t.text) resource["text"] = *t.text;
-    if (t.blob) resource["blob"] = *t.blob;
+    if (auto blob = t.blob_base64()) resource["blob"] = std::move(*blob);
     j = {{"type", "resource"}, {"resource", resource}};
     if (t.annotations) j["annotations"] = *t.annotations;
 }
@@ -189,7 +248,7 @@ void to_json(nlohmann::json& j, const ResourceContent& t) {
     j = {{"uri", t.uri}};
     if (t.mime_type) j["mimeType"] = *t.mime_type;
     if (t.text) j["text"] = *t.text;
-    if (t.blob) j["blob"] = *t.blob;
+    if (auto blob = t.blob_base64()) j["blob"] = std::move(*blob);
 }
 
 void from_json(const nlohmann::json& j, ResourceContent& t) {
@@ -499,4 +558,167 @@ void from_json(const nlohmann::json& j, LogMessage& t) {
     if (j.contains("logger")) t.logger = j.at("logger").get<std::string>();
 }
 
+// ---------- Streaming serialization ----------
+
+namespace {
+
+template<typename T>
+void write_optional(JsonWriter& w, std::string_view key, const std::optional<T>& v) {
+    if (!v) return;
+    w.key(key);
+    if constexpr (std::is_same_v<T, Annotations>) write_json(w, *v);
+    else w.value(*v);
+}
+
+// Raw bytes are encoded straight into the output
+void write_base64(JsonWriter& w, std::string_view key, const std::string& text, const Bytes& bytes) {
+    w.key(key);
+    if (bytes) w.string_with([&](std::string& out) { base64::encode_to(out, *bytes); });
+    else w.value(text);
+}
+
+void write_blob(JsonWriter& w, const std::optional<std::string>& blob, const Bytes& bytes) {
+    if (bytes) write_base64(w, "blob", {}, bytes);
+    else write_optional(w, "blob", blob);
+}
+
+} // anonymous namespace
+
+void write_json(JsonWriter& w, const Annotations& a) {
+    w.begin_object();
+    if (a.audience) {
+        w.key("audience").begin_array();
+        for (const auto& role : *a.audience) w.value(role);
+        w.end_array();
+    }
+    write_optional(w, "priority", a.priority);
+    write_optional(w, "lastModified", a.last_modified);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const TextContent& t) {
+    w.begin_object().field("type", "text").field("text", t.text);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const ImageContent& t) {
+    w.begin_object().field("type", "image");
+    write_base64(w, "data", t.data, t.bytes);
+    w.field("mimeType", t.mime_type);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const AudioContent& t) {
+    w.begin_object().field("type", "audio");
+    write_base64(w, "data", t.data, t.bytes);
+    w.field("mimeType", t.mime_type);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const ResourceLink& t) {
+    w.begin_object().field("type", "resource_link").field("uri", t.uri).field("name", t.name);
+    write_optional(w, "description", t.description);
+    write_optional(w, "mimeType", t.mime_type);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const EmbeddedResource& t) {
+    w.begin_object().field("type", "resource");
+    w.key("resource").begin_object().field("uri", t.uri);
+    write_optional(w, "mimeType", t.mime_type);
+    write_optional(w, "text", t.text);
+    write_blob(w, t.blob, t.blob_bytes);
+    w.end_object();
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const Content& c) {
+    std::visit([&w](const auto& v) { write_json(w, v); }, c);
+}
+
+void write_json(JsonWriter& w, const ToolDefinition& t) {
+    w.begin_object().field("name", t.name);
+    write_optional(w, "title", t.title);
+    write_optional(w, "description", t.description);
+    w.field("inputSchema", t.input_schema);
+    write_optional(w, "outputSchema", t.output_schema);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const CallToolResult& t) {
+    w.begin_object();
+    w.key("content").begin_array();
+    for (const auto& c : t.content) write_json(w, c);
+    w.end_array();
+    write_optional(w, "structuredContent", t.structured_content);
+    if (t.is_error) w.field("isError", true);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const ResourceDefinition& t) {
+    w.begin_object().field("uri", t.uri).field("name", t.name);
+    write_optional(w, "title", t.title);
+    write_optional(w, "description", t.description);
+    write_optional(w, "mimeType", t.mime_type);
+    write_optional(w, "size", t.size);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const ResourceContent& t) {
+    w.begin_object().field("uri", t.uri);
+    write_optional(w, "mimeType", t.mime_type);
+    write_optional(w, "text", t.text);
+    write_blob(w, t.blob, t.blob_bytes);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const ResourceTemplate& t) {
+    w.begin_object().field("uriTemplate", t.uri_template).field("name", t.name);
+    write_optional(w, "title", t.title);
+    write_optional(w, "description", t.description);
+    write_optional(w, "mimeType", t.mime_type);
+    write_optional(w, "annotations", t.annotations);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const PromptArgument& t) {
+    w.begin_object().field("name", t.name);
+    write_optional(w, "description", t.description);
+    w.field("required", t.required);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const PromptDefinition& t) {
+    w.begin_object().field("name", t.name);
+    write_optional(w, "title", t.title);
+    write_optional(w, "description", t.description);
+    w.key("arguments").begin_array();
+    for (const auto& arg : t.arguments) write_json(w, arg);
+    w.end_array();
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const PromptMessage& t) {
+    w.begin_object().field("role", t.role);
+    w.key("content");
+    write_json(w, t.content);
+    w.end_object();
+}
+
+void write_json(JsonWriter& w, const GetPromptResult& t) {
+    w.begin_object();
+    write_optional(w, "description", t.description);
+    w.key("messages").begin_array();
+    for (const auto& m : t.messages) write_json(w, m);
+    w.end_array();
+    w.end_object();
+}
+
 } // namespace mcp
@@ -0,0 +1,171 @@
+#include "mcp/uri_template.hpp"
+#include <stdexcept>
+
+namespace mcp {
+
+namespace {
+
+bool is_unreserved(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+        || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+bool is_reserved(char c) {
+    switch (c) {
+        case ':': case '/': case '?': case '#': case '[': case ']': case '@':
+        case '!': case '$': case '&': case '\'': case '(': case ')':
+        case '*': case '+': case ',': case ';': case '=':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool is_varchar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+        || c == '_' || c == '.' || c == '%';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string percent_decode(std::string_view s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '%' && i + 2 < s.size()) {
+            int hi = hex_value(s[i + 1]);
+            int lo = hex_value(s[i + 2]);
+            if (hi >= 0 && lo >= 0) {
+                out += static_cast<char>(hi * 16 + lo);
+                i += 2;
+                continue;
+            }
+        }
+        out += s[i];
+    }
+    return out;
+}
+
+// Calls literal(c) and variable(op, name) for each part of `tmpl` in order.
+template<typename Literal, typename Variable>
+void parse(std::string_view tmpl, Literal&& literal, Variable&& variable) {
+    for (size_t i = 0; i < tmpl.size(); ++i) {
+        char c = tmpl[i];
+        if (c == '}') throw std::invalid_argument("Unmatched '}' in URI template: " + std::string(tmpl));
+        if (c != '{') {
+            literal(c);
+            continue;
+        }
+        size_t close = tmpl.find('}', i + 1);
+        if (close == std::string_view::npos) {
+            throw std::invalid_argument("Unterminated expression in URI template: " + std::string(tmpl));
+        }
+        std::string_view expr = tmpl.substr(i + 1, close - i - 1);
+        char op = 0;
+        if (!expr.empty() && (expr[0] == '+' || expr[0] == '#')) {
+            op = expr[0];
+            expr.remove_prefix(1);
+        }
+        if (expr.empty()) throw std::invalid_argument("Empty expression in URI template: " + std::string(tmpl));
+        for (char v : expr) {
+            if (!is_varchar(v)) {
+                // Operators and modifiers from level 3 and up, or junk
+                throw std::invalid_argument("Unsupported expression in URI template: " + std::string(tmpl));
+            }
+        }
+        variable(op, expr);
+        i = close;
+    }
+}
+
+} // anonymous namespace
+
+void UriTemplateMatcher::validate(std::string_view tmpl) {
+    parse(tmpl, [](char) {}, [](char, std::string_view) {});
+}
+
+uint32_t UriTemplateMatcher::literal_child(uint32_t node, char c) {
+    for (auto& [ch, next] : nodes_[node].literals) {
+        if (ch == c) return next;
+    }
+    auto next = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[node].literals.emplace_back(c, next);
+    return next;
+}
+
+uint32_t UriTemplateMatcher::var_child(uint32_t node, VarKind kind, std::string name) {
+    for (auto& e : nodes_[node].vars) {
+        if (e.kind == kind && e.name == name) return e.next;
+    }
+    auto next = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[node].vars.push_back(Edge{kind, std::move(name), next});
+    return next;
+}
+
+void UriTemplateMatcher::add(std::string_view tmpl, size_t id) {
+    validate(tmpl);  // before touching the trie
+    uint32_t node = 0;
+    parse(tmpl,
+          [&](char c) { node = literal_child(node, c); },
+          [&](char op, std::string_view name) {
+              VarKind kind = op == '+' ? VarKind::Reserved
+                           : op == '#' ? VarKind::Fragment : VarKind::Simple;
+              node = var_child(node, kind, std::string(name));
+          });
+    if (!nodes_[node].id) ++size_;
+    nodes_[node].id = id;
+}
+
+bool UriTemplateMatcher::walk(uint32_t node, std::string_view uri, size_t pos,
+                              std::vector<Capture>& captures, size_t& id) const {
+    const Node& n = nodes_[node];
+    if (pos == uri.size() && n.id) {
+        id = *n.id;
+        return true;
+    }
+    if (pos < uri.size()) {
+        for (auto& [c, next] : n.literals) {
+            if (c == uri[pos] && walk(next, uri, pos + 1, captures, id)) return true;
+        }
+    }
+    for (const auto& e : n.vars) {
+        size_t start = pos;
+        if (e.kind == VarKind::Fragment) {
+            if (pos >= uri.size() || uri[pos] != '#') continue;
+            ++start;
+        }
+        size_t end = start;
+        while (end < uri.size()
+               && (is_unreserved(uri[end]) || uri[end] == '%'
+                   || (e.kind != VarKind::Simple && is_reserved(uri[end])))) {
+            ++end;
+        }
+        // Longest value first; back off until the rest of the URI matches
+        for (size_t stop = end; stop > start; --stop) {
+            captures.push_back(Capture{&e.name, uri.substr(start, stop - start)});
+            if (walk(e.next, uri, stop, captures, id)) return true;
+            captures.pop_back();
+        }
+    }
+    return false;
+}
+
+std::optional<size_t> UriTemplateMatcher::match(std::string_view uri, UriTemplateVars* vars) const {
+    std::vector<Capture> captures;
+    size_t id = 0;
+    if (!walk(0, uri, 0, captures, id)) return std::nullopt;
+    if (vars) {
+        vars->clear();
+        for (const auto& c : captures) (*vars)[*c.name] = percent_decode(c.value);
+    }
+    return id;
+}
+
+} // namespace mcp
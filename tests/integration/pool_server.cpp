@@ -0,0 +1,47 @@
+/// Stdio server launched by test_client_pool: each tool reports which
+/// process ran it.
+#include "mcp/server.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace mcp;
+
+namespace {
+
+CallToolResult pid_result() {
+    CallToolResult result;
+    result.content.push_back(TextContent{std::to_string(::getpid()), std::nullopt});
+    return result;
+}
+
+ToolDefinition tool(const std::string& name, nlohmann::json annotations = nullptr) {
+    ToolDefinition def;
+    def.name = name;
+    def.input_schema = {{"type", "object"}};
+    if (!annotations.is_null()) def.annotations = std::move(annotations);
+    return def;
+}
+
+} // namespace
+
+int main() {
+    McpServer::Options opts;
+    opts.server_info = {"pool-server", std::nullopt, "1.0"};
+    McpServer server{opts};
+
+    server.add_tool(tool("pid", {{"readOnlyHint", true}}),
+                    [](const nlohmann::json&) { return pid_result(); });
+    // With "pid", only that process sleeps
+    server.add_tool(tool("sleep", {{"idempotentHint", true}}), [](const nlohmann::json& args) {
+        if (!args.contains("pid") || args["pid"] == std::to_string(::getpid())) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(args.value("ms", 0)));
+        }
+        return pid_result();
+    });
+    server.add_tool(tool("exit"), [](const nlohmann::json&) -> CallToolResult { ::_exit(0); });
+
+    server.serve_stdio();
+    return 0;
+}
@@ -1,11 +1,13 @@
 #include <gtest/gtest.h>
 #include "mcp/server.hpp"
 #include "mcp/client.hpp"
+#include "mcp/error.hpp"
 #include "mcp/transport/stdio_transport.hpp"
 #include <unistd.h>
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <memory>
 
 using namespace mcp;
 
@@ -41,3 +43,299 @@ TEST(CancellationTest, CancelSentNotification) {
     close(c2s[0]); close(c2s[1]);
     close(s2c[0]); close(s2c[1]);
 }
+
+// Passes traffic through, noting the notifications/cancelled that arrive
+// and, given `cancelled_replies`, the RequestCancelled errors sent back
+class CancelRecordingTransport : public ITransport {
+public:
+    CancelRecordingTransport(std::unique_ptr<ITransport> inner, std::atomic<int>& cancels,
+                             std::atomic<int>* cancelled_replies = nullptr)
+        : inner_(std::move(inner)), cancels_(cancels), cancelled_replies_(cancelled_replies) {}
+    void start(MessageCallback on_message, ErrorCallback on_error) override {
+        inner_->start([this, on_message](JsonRpcMessage msg) {
+            auto* notif = std::get_if<JsonRpcNotification>(&msg);
+            if (notif && notif->method == "notifications/cancelled") ++cancels_;
+            on_message(std::move(msg));
+        }, std::move(on_error));
+    }
+    void send(const JsonRpcMessage& msg) override {
+        auto* resp = std::get_if<JsonRpcResponse>(&msg);
+        if (cancelled_replies_ && resp && resp->error && resp->error->code == error::RequestCancelled) {
+            ++*cancelled_replies_;
+        }
+        inner_->send(msg);
+    }
+    void shutdown() override { inner_->shutdown(); }
+    bool is_connected() const override { return inner_->is_connected(); }
+
+private:
+    std::unique_ptr<ITransport> inner_;
+    std::atomic<int>& cancels_;
+    std::atomic<int>* cancelled_replies_;
+};
+
+namespace {
+
+// `server` serving over a pair of pipes and a client connected to it;
+// `cancels` counts the notifications/cancelled the server receives and
+// `cancelled_replies` the RequestCancelled errors it sends
+class Connection {
+public:
+    explicit Connection(McpServer& server) : server_(server) {
+        EXPECT_EQ(pipe(c2s_), 0);
+        EXPECT_EQ(pipe(s2c_), 0);
+        auto t = std::make_unique<CancelRecordingTransport>(
+            std::make_unique<StdioTransport>(c2s_[0], s2c_[1]), cancels, &cancelled_replies);
+        thread_ = std::thread([this, t = std::move(t)]() mutable { server_.serve(std::move(t)); });
+        client.connect(std::make_unique<StdioTransport>(s2c_[0], c2s_[1]));
+        (void)client.initialize();
+    }
+    ~Connection() {
+        client.disconnect();
+        server_.shutdown();
+        if (thread_.joinable()) thread_.join();
+        close(c2s_[0]); close(c2s_[1]);
+        close(s2c_[0]); close(s2c_[1]);
+    }
+
+    std::atomic<int> cancels{0};
+    std::atomic<int> cancelled_replies{0};
+    McpClient client{client_options()};
+
+private:
+    static McpClient::Options client_options() {
+        McpClient::Options opts;
+        opts.client_info = {"test-client", std::nullopt, "1.0"};
+        opts.request_timeout = std::chrono::milliseconds(5000);
+        return opts;
+    }
+
+    McpServer& server_;
+    int c2s_[2], s2c_[2];
+    std::thread thread_;
+};
+
+ToolDefinition tool(const std::string& name) {
+    ToolDefinition def;
+    def.name = name;
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    return def;
+}
+
+template<typename Pred>
+bool eventually(Pred pred) {
+    for (int i = 0; i < 500 && !pred(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+} // namespace
+
+TEST(CancellationTest, TimedOutRequestsAreCancelled) {
+    int c2s[2], s2c[2];
+    ASSERT_EQ(pipe(c2s), 0);
+    ASSERT_EQ(pipe(s2c), 0);
+
+    McpServer::Options sopts;
+    sopts.server_info = {"cancel-server", std::nullopt, "1.0"};
+    McpServer server{sopts};
+    ToolDefinition def;
+    def.name = "stall";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool(def, [](const nlohmann::json&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        return CallToolResult{};
+    });
+
+    std::atomic<int> cancels{0};
+    auto server_transport = std::make_unique<CancelRecordingTransport>(
+        std::make_unique<StdioTransport>(c2s[0], s2c[1]), cancels);
+    std::thread server_thread([&, t = std::move(server_transport)]() mutable {
+        server.serve(std::move(t));
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"test-client", std::nullopt, "1.0"};
+    copts.request_timeout = std::chrono::milliseconds(200);
+    McpClient client{copts};
+    client.connect(std::make_unique<StdioTransport>(s2c[0], c2s[1]));
+    (void)client.initialize();
+
+    // Async requests time out too, without a thread waiting on them
+    auto start = std::chrono::steady_clock::now();
+    auto call = client.call_tool_async("stall", {});
+    EXPECT_THROW(call.get(), McpTimeoutError);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(450));
+    EXPECT_THROW((void)client.call_tool("stall", {}), McpTimeoutError);
+
+    for (int i = 0; i < 200 && cancels < 2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(cancels.load(), 2);
+    // The late results are dropped and the connection stays usable
+    EXPECT_NO_THROW(client.ping());
+
+    client.disconnect();
+    server.shutdown();
+    if (server_thread.joinable()) server_thread.join();
+    close(c2s[0]); close(c2s[1]);
+    close(s2c[0]); close(s2c[1]);
+}
+
+TEST(CancellationTest, CancellingAnAsyncRequestNotifiesTheServer) {
+    int c2s[2], s2c[2];
+    ASSERT_EQ(pipe(c2s), 0);
+    ASSERT_EQ(pipe(s2c), 0);
+
+    McpServer::Options sopts;
+    sopts.server_info = {"cancel-server", std::nullopt, "1.0"};
+    McpServer server{sopts};
+    ToolDefinition def;
+    def.name = "stall";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool(def, [](const nlohmann::json&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return CallToolResult{};
+    });
+
+    std::atomic<int> cancels{0};
+    auto server_transport = std::make_unique<CancelRecordingTransport>(
+        std::make_unique<StdioTransport>(c2s[0], s2c[1]), cancels);
+    std::thread server_thread([&, t = std::move(server_transport)]() mutable {
+        server.serve(std::move(t));
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"test-client", std::nullopt, "1.0"};
+    copts.request_timeout = std::chrono::milliseconds(5000);
+    McpClient client{copts};
+    client.connect(std::make_unique<StdioTransport>(s2c[0], c2s[1]));
+    (void)client.initialize();
+
+    auto call = client.call_tool_async("stall", {});
+    EXPECT_TRUE(call.cancel());
+    EXPECT_TRUE(call.is_ready());
+    try {
+        (void)call.get();
+        ADD_FAILURE() << "cancelled request succeeded";
+    } catch (const McpProtocolError& e) {
+        EXPECT_EQ(e.code, error::RequestCancelled);
+    }
+    EXPECT_FALSE(call.cancel());
+
+    for (int i = 0; i < 200 && cancels < 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(cancels.load(), 1);
+    EXPECT_NO_THROW(client.ping());
+
+    client.disconnect();
+    server.shutdown();
+    if (server_thread.joinable()) server_thread.join();
+    close(c2s[0]); close(c2s[1]);
+    close(s2c[0]); close(s2c[1]);
+}
+
+TEST(CancellationTest, PlainAndCallbackToolsSeeTheirCallCancelled) {
+    McpServer::Options sopts;
+    sopts.server_info = {"cancel-server", std::nullopt, "1.0"};
+    McpServer server{sopts};
+    auto started = std::make_shared<std::atomic<int>>(0);
+    auto stopped = std::make_shared<std::atomic<int>>(0);
+    server.add_tool(tool("spin"), [started, stopped](const nlohmann::json&) {
+        ++*started;
+        auto token = CancellationToken::current();
+        for (int i = 0; i < 500 && !token.is_cancelled(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (token.is_cancelled()) ++*stopped;
+        return CallToolResult{};
+    });
+    server.add_tool_async(tool("hold"), [started, stopped](const nlohmann::json&, ToolResponder respond) {
+        ++*started;
+        CancellationToken::current().on_cancel([stopped, respond] {
+            ++*stopped;
+            respond.fail("cancelled");
+        });
+    });
+
+    Connection conn(server);
+    auto spin = conn.client.call_tool_async("spin", {});
+    auto hold = conn.client.call_tool_async("hold", {});
+    ASSERT_TRUE(eventually([&] { return started->load() == 2; }));
+    EXPECT_TRUE(spin.cancel());
+    EXPECT_TRUE(hold.cancel());
+    EXPECT_TRUE(eventually([&] { return stopped->load() == 2; }));
+    EXPECT_EQ(conn.cancels.load(), 2);
+    EXPECT_NO_THROW(conn.client.ping());
+}
+
+TEST(CancellationTest, QueuedRequestsAreDroppedUnrun) {
+    McpServer::Options sopts;
+    sopts.server_info = {"cancel-server", std::nullopt, "1.0"};
+    sopts.thread_pool_size = 1;
+    McpServer server{sopts};
+    auto runs = std::make_shared<std::atomic<int>>(0);
+    server.add_tool(tool("busy"), [](const nlohmann::json&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return CallToolResult{};
+    });
+    server.add_tool(tool("count"), [runs](const nlohmann::json&) {
+        ++*runs;
+        return CallToolResult{};
+    });
+
+    Connection conn(server);
+    auto busy = conn.client.call_tool_async("busy", {});
+    auto queued = conn.client.call_tool_async("count", {});
+    EXPECT_TRUE(queued.cancel());
+    ASSERT_TRUE(eventually([&] { return conn.cancels.load() == 1; }));
+
+    (void)busy.get();
+    (void)conn.client.call_tool("count", {});
+    EXPECT_EQ(runs->load(), 1);
+    // Dropped without a response
+    EXPECT_EQ(conn.cancelled_replies.load(), 0);
+}
+
+namespace {
+
+CoTask<CallToolResult> relay(McpClient& downstream, std::shared_ptr<std::atomic<int>> seen) {
+    try {
+        co_return co_await downstream.call_tool_async("stall", {});
+    } catch (const McpProtocolError& e) {
+        // Resumed within the call it serves, cancelled with it
+        if (e.code == error::RequestCancelled && CancellationToken::current().is_cancelled()) ++*seen;
+        throw;
+    }
+}
+
+} // namespace
+
+TEST(CancellationTest, RequestsMadeByACancelledCoroutineAreCancelledToo) {
+    McpServer::Options sopts;
+    sopts.server_info = {"cancel-server", std::nullopt, "1.0"};
+    McpServer backend{sopts};
+    auto backend_calls = std::make_shared<std::atomic<int>>(0);
+    backend.add_tool(tool("stall"), [backend_calls](const nlohmann::json&) {
+        ++*backend_calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return CallToolResult{};
+    });
+    Connection downstream(backend);
+
+    McpServer front{sopts};
+    auto seen = std::make_shared<std::atomic<int>>(0);
+    front.add_tool_async(tool("relay"), [&downstream, seen](nlohmann::json) -> CoTask<CallToolResult> {
+        return relay(downstream.client, seen);
+    });
+    Connection upstream(front);
+
+    auto call = upstream.client.call_tool_async("relay", {});
+    // Cancelled once the relay is waiting downstream
+    ASSERT_TRUE(eventually([&] { return backend_calls->load() == 1; }));
+    EXPECT_TRUE(call.cancel());
+    EXPECT_TRUE(eventually([&] { return downstream.cancels.load() == 1; }));
+    EXPECT_TRUE(eventually([&] { return seen->load() == 1; }));
+}
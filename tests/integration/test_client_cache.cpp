@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include "mcp/server.hpp"
+#include "mcp/client.hpp"
+#include "mcp/transport/stdio_transport.hpp"
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace mcp;
+
+namespace {
+
+// Counts the requests a client sends, by method
+class CountingTransport : public ITransport {
+public:
+    explicit CountingTransport(std::unique_ptr<ITransport> inner) : inner_(std::move(inner)) {}
+
+    void start(MessageCallback on_message, ErrorCallback on_error) override {
+        inner_->start(std::move(on_message), std::move(on_error));
+    }
+    void send(const JsonRpcMessage& msg) override {
+        if (const auto* req = std::get_if<JsonRpcRequest>(&msg)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++sent_[req->method];
+        }
+        inner_->send(msg);
+    }
+    void shutdown() override { inner_->shutdown(); }
+    bool is_connected() const override { return inner_->is_connected(); }
+
+    int sent(const std::string& method) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sent_[method];
+    }
+
+private:
+    std::unique_ptr<ITransport> inner_;
+    std::mutex mutex_;
+    std::map<std::string, int> sent_;
+};
+
+ToolDefinition tool(const std::string& name) {
+    ToolDefinition def;
+    def.name = name;
+    def.input_schema = {{"type", "object"}};
+    return def;
+}
+
+template<typename Pred>
+bool eventually(Pred pred) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return pred();
+}
+
+} // namespace
+
+class ClientCacheTest : public ::testing::TestWithParam<bool> {
+protected:
+    int c2s_[2], s2c_[2];
+    std::unique_ptr<McpServer> server_;
+    std::unique_ptr<McpClient> client_;
+    CountingTransport* transport_ = nullptr;
+    std::thread server_thread_;
+    std::shared_ptr<std::atomic<int>> reads_ = std::make_shared<std::atomic<int>>(0);
+
+    void SetUp() override {
+        ASSERT_EQ(pipe(c2s_), 0);
+        ASSERT_EQ(pipe(s2c_), 0);
+
+        McpServer::Options sopts;
+        sopts.server_info = {"cache-server", std::nullopt, "1.0"};
+        sopts.page_size = 2;
+        server_ = std::make_unique<McpServer>(sopts);
+        for (int i = 0; i < 5; ++i) {
+            server_->add_tool(tool("t" + std::to_string(i)), [](const nlohmann::json&) {
+                return CallToolResult{};
+            });
+        }
+        ResourceDefinition rd;
+        rd.uri = "config://snapshot";
+        rd.name = "snapshot";
+        server_->add_resource(rd, [reads = reads_](const std::string& uri) -> std::vector<ResourceContent> {
+            int n = ++*reads;
+            return {ResourceContent{uri, std::nullopt, "v" + std::to_string(n), std::nullopt}};
+        });
+
+        auto server_transport = std::make_unique<StdioTransport>(c2s_[0], s2c_[1]);
+        server_thread_ = std::thread([this, t = std::move(server_transport)]() mutable {
+            server_->serve(std::move(t));
+        });
+
+        McpClient::Options copts;
+        copts.client_info = {"cache-client", std::nullopt, "1.0"};
+        copts.request_timeout = std::chrono::milliseconds(5000);
+        copts.cache_responses = GetParam();
+        client_ = std::make_unique<McpClient>(copts);
+        auto counting = std::make_unique<CountingTransport>(
+            std::make_unique<StdioTransport>(s2c_[0], c2s_[1]));
+        transport_ = counting.get();
+        client_->connect(std::move(counting));
+        (void)client_->initialize();
+    }
+
+    void TearDown() override {
+        client_->disconnect();
+        server_->shutdown();
+        if (server_thread_.joinable()) server_thread_.join();
+        close(c2s_[0]); close(c2s_[1]);
+        close(s2c_[0]); close(s2c_[1]);
+    }
+
+    bool cached() const { return GetParam(); }
+};
+
+TEST_P(ClientCacheTest, ListAllFollowsEveryCursor) {
+    auto tools = client_->list_all_tools();
+    ASSERT_EQ(tools.size(), 5u);
+    EXPECT_EQ(tools.front().name, "t0");
+    EXPECT_EQ(tools.back().name, "t4");
+    EXPECT_EQ(transport_->sent("tools/list"), 3);
+}
+
+TEST_P(ClientCacheTest, ListsAreServedLocallyUntilListChanged) {
+    (void)client_->list_all_tools();
+    (void)client_->list_all_tools();
+    (void)client_->list_tools();
+    EXPECT_EQ(transport_->sent("tools/list"), cached() ? 3 : 7);
+
+    server_->add_tool(tool("t5"), [](const nlohmann::json&) { return CallToolResult{}; });
+    ASSERT_TRUE(eventually([&] { return client_->list_all_tools().size() == 6; }));
+    int after = transport_->sent("tools/list");
+    (void)client_->list_all_tools();
+    EXPECT_EQ(transport_->sent("tools/list"), cached() ? after : after + 3);
+}
+
+TEST_P(ClientCacheTest, CachedAsyncPageIsReadyAtOnce) {
+    (void)client_->list_prompts();
+    auto page = client_->list_tools_async();
+    (void)page.get();
+    auto again = client_->list_tools_async();
+    if (cached()) {
+        EXPECT_TRUE(again.is_ready());
+    }
+    EXPECT_EQ(again.get().items.size(), 2u);
+    EXPECT_EQ(transport_->sent("tools/list"), cached() ? 1 : 2);
+}
+
+TEST_P(ClientCacheTest, ReadsAreCachedOnlyWhileSubscribed) {
+    // Nothing would announce a change, so the read isn't kept
+    EXPECT_EQ(*client_->read_resource("config://snapshot")[0].text, "v1");
+    EXPECT_EQ(*client_->read_resource("config://snapshot")[0].text, "v2");
+
+    client_->subscribe_resource("config://*");
+    EXPECT_EQ(*client_->read_resource("config://snapshot")[0].text, "v3");
+    EXPECT_EQ(*client_->read_resource_async("config://snapshot").get()[0].text,
+              cached() ? "v3" : "v4");
+
+    server_->notify_resource_updated("config://snapshot");
+    ASSERT_TRUE(eventually([&] {
+        return *client_->read_resource("config://snapshot")[0].text != (cached() ? "v3" : "v4");
+    }));
+
+    client_->unsubscribe_resource("config://*");
+    int before = reads_->load();
+    (void)client_->read_resource("config://snapshot");
+    EXPECT_EQ(reads_->load(), before + 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(CacheOnAndOff, ClientCacheTest, ::testing::Bool());
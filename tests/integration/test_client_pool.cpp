@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "mcp/client_pool.hpp"
+#include "mcp/error.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+
+namespace {
+
+McpClientPool::Options pool_options(size_t size, size_t spares) {
+    McpClientPool::Options opts;
+    opts.client.client_info = {"pool-client", std::nullopt, "1.0"};
+    opts.client.request_timeout = std::chrono::milliseconds(5000);
+    opts.size = size;
+    opts.warm_spares = spares;
+    opts.health_check_interval = std::chrono::milliseconds(20);
+    return opts;
+}
+
+std::string pid_of(const CallToolResult& result) {
+    return std::get<TextContent>(result.content.at(0)).text;
+}
+
+template<typename Pred>
+bool eventually(Pred pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+// This process's children, from /proc; only the defunct ones if `zombies`
+size_t children(bool zombies = false) {
+    size_t n = 0;
+    for (const auto& entry : std::filesystem::directory_iterator("/proc")) {
+        std::ifstream stat(entry.path() / "stat");
+        std::string line;
+        if (!std::getline(stat, line)) continue;
+        // pid (comm) state ppid ...; comm may hold spaces or parentheses
+        auto end = line.rfind(')');
+        if (end == std::string::npos) continue;
+        char state = 0;
+        long ppid = 0;
+        if (std::sscanf(line.c_str() + end + 1, " %c %ld", &state, &ppid) != 2) continue;
+        if (ppid == ::getpid() && (!zombies || state == 'Z')) ++n;
+    }
+    return n;
+}
+
+} // namespace
+
+TEST(ClientPool, StartsEveryProcessAndItsSpares) {
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, pool_options(2, 1));
+    auto init = pool.start();
+    EXPECT_EQ(init.server_info.name, "pool-server");
+
+    auto s = pool.stats();
+    EXPECT_EQ(s.active, 2u);
+    EXPECT_EQ(s.spares, 1u);
+    EXPECT_EQ(s.launched, 3u);
+    EXPECT_EQ(s.failed_launches, 0u);
+    EXPECT_NO_THROW(pool.ping());
+}
+
+TEST(ClientPool, SpreadsConcurrentRequestsOverTheLeastBusyProcesses) {
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, pool_options(2, 0));
+    pool.start();
+
+    std::vector<Async<CallToolResult>> calls;
+    for (int i = 0; i < 4; ++i) calls.push_back(pool.call_tool_async("sleep", {{"ms", 200}}));
+    EXPECT_EQ(pool.stats().in_flight, 4u);
+
+    std::set<std::string> pids;
+    for (auto& c : calls) pids.insert(pid_of(c.get()));
+    EXPECT_EQ(pids.size(), 2u);
+    EXPECT_EQ(pool.stats().in_flight, 0u);
+}
+
+TEST(ClientPool, ReplacesAProcessThatExitsWithASpare) {
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, pool_options(1, 1));
+    pool.start();
+    auto first = pid_of(pool.call_tool("pid"));
+
+    // Dies mid-request: the request fails rather than being repeated
+    EXPECT_THROW((void)pool.call_tool("exit"), McpError);
+
+    std::string second;
+    ASSERT_TRUE(eventually([&] {
+        try {
+            second = pid_of(pool.call_tool("pid"));
+            return true;
+        } catch (const McpError&) {
+            return false;
+        }
+    }));
+    EXPECT_NE(second, first);
+
+    // A new spare is launched in place of the one promoted
+    ASSERT_TRUE(eventually([&] { return pool.stats().spares == 1; }));
+    auto s = pool.stats();
+    EXPECT_EQ(s.active, 1u);
+    EXPECT_EQ(s.respawned, 1u);
+}
+
+TEST(ClientPool, HedgesASlowIdempotentCallOnAnotherProcess) {
+    auto opts = pool_options(2, 0);
+    opts.hedge_idempotent = true;
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, opts);
+    pool.start();
+
+    // Sequential calls all go to the first process, and set a fast baseline
+    std::string first;
+    for (size_t i = 0; i < opts.hedge_min_samples; ++i) first = pid_of(pool.call_tool("pid"));
+    EXPECT_EQ(pool.stats().hedges, 0u);
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = pool.call_tool("sleep", {{"ms", 2000}, {"pid", first}});
+    EXPECT_NE(pid_of(result), first);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1500));
+
+    auto s = pool.stats();
+    EXPECT_EQ(s.hedges, 1u);
+    EXPECT_EQ(s.hedge_wins, 1u);
+}
+
+TEST(ClientPool, AdaptiveLimitHoldsRequestsBackUntilThereIsRoom) {
+    auto opts = pool_options(1, 0);
+    opts.adaptive_limit = true;
+    opts.initial_limit = 1;
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, opts);
+    pool.start();
+    EXPECT_EQ(pool.stats().concurrency_limit, 1u);
+
+    auto slow = pool.call_tool_async("sleep", {{"ms", 300}});
+    auto start = std::chrono::steady_clock::now();
+    (void)pool.call_tool("pid");
+    EXPECT_TRUE(slow.is_ready());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(250));
+}
+
+TEST(ClientPool, AdaptiveLimitGrowsWhileLatencyHolds) {
+    auto opts = pool_options(1, 0);
+    opts.adaptive_limit = true;
+    opts.initial_limit = 1;
+    opts.latency_tolerance = 10.0;
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, opts);
+    pool.start();
+
+    for (int i = 0; i < 20; ++i) (void)pool.call_tool("pid");
+    EXPECT_GT(pool.stats().concurrency_limit, 1u);
+}
+
+TEST(ClientPool, StartThrowsIfNoProcessComesUp) {
+    auto opts = pool_options(2, 0);
+    opts.respawn_backoff = std::chrono::milliseconds(10);
+    McpClientPool pool("/nonexistent/mcpxx-pool-server", {}, opts);
+    EXPECT_THROW(pool.start(), McpError);
+    EXPECT_EQ(pool.stats().failed_launches, 2u);
+    EXPECT_THROW(pool.ping(), McpTransportError);
+}
+
+TEST(ClientPool, RejectsRequestsWhenStopped) {
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, pool_options(1, 0));
+    EXPECT_THROW(pool.ping(), McpTransportError);
+    pool.start();
+    pool.stop();
+    EXPECT_THROW(pool.ping(), McpTransportError);
+    EXPECT_EQ(pool.stats().active, 0u);
+}
+
+TEST(ClientPool, ReapsItsProcessesOnRespawnAndStop) {
+    McpClientPool pool(MCPXX_POOL_SERVER, {}, pool_options(2, 1));
+    pool.start();
+    EXPECT_EQ(children(), 3u);
+
+    EXPECT_THROW((void)pool.call_tool("exit"), McpError);
+    ASSERT_TRUE(eventually([&] { return pool.stats().respawned == 1 && pool.stats().spares == 1; }));
+    EXPECT_TRUE(eventually([] { return children(true) == 0; }));
+
+    // Running ones are ended and reaped before stop() returns
+    pool.stop();
+    EXPECT_EQ(children(), 0u);
+}
+
+TEST(ClientPool, RejectsAnEmptyPool) {
+    EXPECT_THROW(McpClientPool(MCPXX_POOL_SERVER, {}, pool_options(0, 1)), std::invalid_argument);
+}
@@ -3,7 +3,11 @@
 #include "mcp/client.hpp"
 #include "mcp/transport/http_transport.hpp"
 #include <thread>
+#include <atomic>
 #include <chrono>
+#include <vector>
+#include <algorithm>
+#include <mutex>
 
 using namespace mcp;
 
@@ -98,7 +102,193 @@ TEST_F(HttpE2ETest, ReadResource) {
     EXPECT_EQ(contents[0].text.value_or(""), "Hello from HTTP!");
 }
 
+TEST_F(HttpE2ETest, StreamedResourceIsCollectedForJsonResponses) {
+    ResourceDefinition rd;
+    rd.uri = "test://chunks";
+    rd.name = "Chunks";
+    server_->add_resource_stream(rd, [](const std::string&) {
+        ResourceStream s;
+        s.binary = false;
+        s.read = [left = 3](char* buf, size_t) mutable -> size_t {
+            if (left-- == 0) return 0;
+            buf[0] = 'a';
+            buf[1] = 'b';
+            return 2;
+        };
+        return s;
+    });
+
+    auto init = client_->initialize();
+    auto contents = client_->read_resource("test://chunks");
+    ASSERT_EQ(contents.size(), 1u);
+    EXPECT_EQ(contents[0].text.value_or(""), "ababab");
+}
+
 TEST_F(HttpE2ETest, CallUnknownTool) {
     auto init = client_->initialize();
     EXPECT_THROW(client_->call_tool("nonexistent", {}), McpProtocolError);
 }
+
+TEST_F(HttpE2ETest, ConcurrentSessionsGetTheirOwnResponses) {
+    // Every client numbers its requests from the same starting id, so the
+    // transport must keep same-id requests from different sessions apart.
+    constexpr int kClients = 4;
+    constexpr int kCalls = 10;
+    ToolDefinition slow_def;
+    slow_def.name = "slow_echo";
+    slow_def.input_schema = {{"type", "object"}};
+    server_->add_tool(slow_def, [](const nlohmann::json& args) -> CallToolResult {
+        // Long enough that the clients' POSTs overlap
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CallToolResult result;
+        result.content.push_back(TextContent{args.at("text").get<std::string>(), std::nullopt});
+        return result;
+    });
+
+    std::vector<std::unique_ptr<McpClient>> clients;
+    for (int c = 0; c < kClients; ++c) {
+        McpClient::Options copts;
+        copts.client_info = {"http-client-" + std::to_string(c), std::nullopt, "1.0"};
+        copts.request_timeout = std::chrono::milliseconds(5000);
+        auto client = std::make_unique<McpClient>(copts);
+        client->connect_http("http://127.0.0.1:" + std::to_string(port_) + "/mcp");
+        auto init = client->initialize();
+        clients.push_back(std::move(client));
+    }
+
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches{0};
+    for (int c = 0; c < kClients; ++c) {
+        threads.emplace_back([&, c] {
+            for (int i = 0; i < kCalls; ++i) {
+                std::string text = "client " + std::to_string(c) + " call " + std::to_string(i);
+                auto result = clients[c]->call_tool("slow_echo", {{"text", text}});
+                if (result.content.empty()
+                    || std::get<TextContent>(result.content[0]).text != text) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(mismatches.load(), 0);
+
+    for (auto& client : clients) client->disconnect();
+}
+
+TEST_F(HttpE2ETest, ResourceUpdatesReachOnlySubscribedSessions) {
+    ResourceDefinition other_def;
+    other_def.uri = "test://other";
+    other_def.name = "Other";
+    server_->add_resource(other_def, [](const std::string&) -> std::vector<ResourceContent> {
+        return {ResourceContent{"test://other", "text/plain", std::string("other"), std::nullopt}};
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"http-client-b", std::nullopt, "1.0"};
+    copts.request_timeout = std::chrono::milliseconds(5000);
+    McpClient other(copts);
+    other.connect_http("http://127.0.0.1:" + std::to_string(port_) + "/mcp");
+
+    std::mutex mutex;
+    std::vector<std::string> seen_a, seen_b;
+    client_->on_resource_updated([&](const std::string& uri) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen_a.push_back(uri);
+    });
+    other.on_resource_updated([&](const std::string& uri) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen_b.push_back(uri);
+    });
+    auto init_a = client_->initialize();
+    auto init_b = other.initialize();
+    client_->subscribe_resource("test://greeting");
+    other.subscribe_resource("test://other");
+
+    // The GET streams open in the background; update until both have one
+    auto received = [&](const std::vector<std::string>& seen, const std::string& uri) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::find(seen.begin(), seen.end(), uri) != seen.end();
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!(received(seen_a, "test://greeting") && received(seen_b, "test://other"))
+           && std::chrono::steady_clock::now() < deadline) {
+        server_->notify_resource_updated("test://greeting");
+        server_->notify_resource_updated("test://other");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    EXPECT_TRUE(received(seen_a, "test://greeting"));
+    EXPECT_TRUE(received(seen_b, "test://other"));
+    EXPECT_FALSE(received(seen_a, "test://other"));
+    EXPECT_FALSE(received(seen_b, "test://greeting"));
+    other.disconnect();
+}
+
+TEST_F(HttpE2ETest, ConcurrentCallsFromOneClientOverlap) {
+    // The tool completes from its own thread, so the server never limits
+    // how many calls overlap; only the client's connections could
+    constexpr int kCalls = 8;
+    constexpr auto kDelay = std::chrono::milliseconds(100);
+    ToolDefinition def;
+    def.name = "delayed";
+    def.input_schema = {{"type", "object"}};
+    server_->add_tool_async(def, [kDelay](const nlohmann::json&, ToolResponder respond) {
+        std::thread([kDelay, respond] {
+            std::this_thread::sleep_for(kDelay);
+            CallToolResult result;
+            result.content.push_back(TextContent{"done", std::nullopt});
+            respond(result);
+        }).detach();
+    });
+    auto init = client_->initialize();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    std::atomic<int> ok{0};
+    for (int i = 0; i < kCalls; ++i) {
+        threads.emplace_back([&] {
+            auto result = client_->call_tool("delayed", {});
+            if (!result.is_error) ++ok;
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(ok.load(), kCalls);
+    // One connection would take kCalls * kDelay
+    EXPECT_LT(elapsed, kDelay * kCalls / 2);
+}
+
+TEST_F(HttpE2ETest, LargeMessagesTravelCompressedBothWays) {
+    // The client compresses requests once the first reply says how, and
+    // asks for compressed replies; with neither coding built, plain JSON
+    auto init = client_->initialize();
+    const std::string text(50000, 'c');
+    for (int i = 0; i < 3; ++i) {
+        auto result = client_->call_tool("echo", {{"text", text + std::to_string(i)}});
+        ASSERT_EQ(result.content.size(), 1u);
+        EXPECT_EQ(std::get<TextContent>(result.content[0]).text, text + std::to_string(i));
+    }
+}
+
+TEST_F(HttpE2ETest, CompressedReplyOverTheClientLimitFails) {
+    if (!coding_available(ContentCoding::Gzip)) GTEST_SKIP() << "needs gzip";
+    HttpClientTransport::Options topts;
+    topts.compression = {ContentCoding::Gzip};
+    topts.max_body_bytes = 10000;
+    McpClient::Options copts;
+    copts.request_timeout = std::chrono::milliseconds(5000);
+    McpClient client(copts);
+    client.connect(std::make_unique<HttpClientTransport>(
+        "http://127.0.0.1:" + std::to_string(port_) + "/mcp", topts));
+    (void)client.initialize();
+
+    // 50000 repeated characters compress well below the limit but don't
+    // decompress within it
+    EXPECT_THROW((void)client.call_tool("echo", {{"text", std::string(50000, 'c')}}),
+                 McpTransportError);
+    auto small = client.call_tool("echo", {{"text", "ok"}});
+    EXPECT_EQ(std::get<TextContent>(small.content[0]).text, "ok");
+    client.disconnect();
+}
@@ -0,0 +1,704 @@
+#include <gtest/gtest.h>
+#include "mcp/server.hpp"
+#include "mcp/transport/http_transport.hpp"
+#include "mcp/transport/compression.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Blocking HTTP/1.1 client on one keep-alive socket, just enough to talk
+// to the server: Content-Length or chunked responses
+class RawHttp {
+public:
+    explicit RawHttp(uint16_t port) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        connected_ = ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+    ~RawHttp() { ::close(fd_); }
+
+    bool connected() const { return connected_; }
+
+    void send_raw(const std::string& data) {
+        size_t off = 0;
+        while (off < data.size()) {
+            ssize_t n = ::send(fd_, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            off += static_cast<size_t>(n);
+        }
+    }
+
+    void request(const std::string& method, const std::string& body = {},
+                 const std::vector<std::string>& headers = {}, const std::string& path = "/mcp") {
+        std::string req = method + " " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+        for (const auto& h : headers) req += h + "\r\n";
+        if (!body.empty() || method == "POST") {
+            req += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+        }
+        req += "\r\n" + body;
+        send_raw(req);
+    }
+
+    struct Response {
+        int status = 0;
+        std::string head;  // lower-cased
+        std::string body;
+        bool chunked = false;
+        std::string header(const std::string& name) const {
+            auto at = head.find("\r\n" + name + ": ");
+            if (at == std::string::npos) return {};
+            at += name.size() + 4;
+            return head.substr(at, head.find("\r\n", at) - at);
+        }
+    };
+
+    // Reads a status line and headers; a Content-Length body is read whole
+    std::optional<Response> read_response(std::chrono::milliseconds timeout = 5s) {
+        Response r;
+        size_t end;
+        while ((end = buf_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill(timeout)) return std::nullopt;
+        }
+        std::string head = buf_.substr(0, end);
+        buf_.erase(0, end + 4);
+        r.status = std::stoi(head.substr(9, 3));
+        // Lower-cased names, values as sent
+        r.head = "\r\n";
+        size_t pos = head.find("\r\n");
+        while (pos != std::string::npos) {
+            size_t next = head.find("\r\n", pos + 2);
+            std::string line = head.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+            auto colon = line.find(':');
+            std::string name = line.substr(0, colon);
+            for (auto& ch : name) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+            r.head += name + line.substr(colon) + "\r\n";
+            pos = next;
+        }
+        r.chunked = r.header("transfer-encoding") == "chunked";
+        if (!r.chunked) {
+            size_t length = std::stoul("0" + r.header("content-length"));
+            while (buf_.size() < length) {
+                if (!fill(timeout)) return std::nullopt;
+            }
+            r.body = buf_.substr(0, length);
+            buf_.erase(0, length);
+        }
+        return r;
+    }
+
+    // Next chunk of a chunked body; empty at the end, nullopt on timeout
+    std::optional<std::string> read_chunk(std::chrono::milliseconds timeout = 5s) {
+        size_t eol;
+        while ((eol = buf_.find("\r\n")) == std::string::npos) {
+            if (!fill(timeout)) return std::nullopt;
+        }
+        size_t size = std::stoul(buf_.substr(0, eol), nullptr, 16);
+        while (buf_.size() < eol + 2 + size + 2) {
+            if (!fill(timeout)) return std::nullopt;
+        }
+        std::string chunk = buf_.substr(eol + 2, size);
+        buf_.erase(0, eol + 2 + size + 2);
+        return chunk;
+    }
+
+    // Chunks until one contains `needle`
+    bool read_until(const std::string& needle, std::chrono::milliseconds timeout = 5s) {
+        std::string seen;
+        while (seen.find(needle) == std::string::npos) {
+            auto chunk = read_chunk(timeout);
+            if (!chunk || chunk->empty()) return false;
+            seen += *chunk;
+        }
+        return true;
+    }
+
+    // True once the server has closed the connection
+    bool closed_by_peer(std::chrono::milliseconds timeout = 2s) {
+        while (fill(timeout)) {}
+        return eof_;
+    }
+
+private:
+    bool fill(std::chrono::milliseconds timeout) {
+        pollfd pfd{fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) return false;
+        char tmp[16384];
+        ssize_t n = ::recv(fd_, tmp, sizeof(tmp), 0);
+        if (n <= 0) {
+            eof_ = true;
+            return false;
+        }
+        buf_.append(tmp, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd_;
+    bool connected_ = false;
+    bool eof_ = false;
+    std::string buf_;
+};
+
+const std::string kInitialize =
+    R"({"jsonrpc":"2.0","id":1,"method":"initialize","params":{"protocolVersion":"2025-11-25",)"
+    R"("clientInfo":{"name":"raw","version":"1"},"capabilities":{}}})";
+
+} // namespace
+
+class HttpNativeTest : public ::testing::Test {
+protected:
+    std::unique_ptr<McpServer> server_;
+    HttpServerTransport* transport_ = nullptr;
+    std::thread server_thread_;
+
+    void start(HttpServerTransport::Options opts = {}) {
+        McpServer::Options sopts;
+        sopts.server_info = {"native-http-server", std::nullopt, "1.0"};
+        sopts.thread_pool_size = 2;
+        server_ = std::make_unique<McpServer>(sopts);
+
+        ToolDefinition echo_def;
+        echo_def.name = "echo";
+        echo_def.input_schema = {{"type", "object"}, {"properties", {{"text", {{"type", "string"}}}}}};
+        server_->add_tool(echo_def, [](const nlohmann::json& args) -> CallToolResult {
+            CallToolResult result;
+            result.content.push_back(TextContent{args.value("text", ""), std::nullopt});
+            return result;
+        });
+
+        opts.backend = HttpBackend::Native;
+        opts.port = 0;
+        auto transport = std::make_unique<HttpServerTransport>(opts);
+        transport_ = transport.get();
+        server_thread_ = std::thread([this, t = std::move(transport)]() mutable {
+            server_->serve(std::move(t));
+        });
+        for (int i = 0; i < 500 && transport_->port() == 0; ++i) std::this_thread::sleep_for(2ms);
+        ASSERT_NE(transport_->port(), 0);
+    }
+
+    // Initializes a session over `http` and returns its id
+    std::string initialize(RawHttp& http) {
+        http.request("POST", kInitialize);
+        auto resp = http.read_response();
+        EXPECT_TRUE(resp);
+        if (!resp) return {};
+        EXPECT_EQ(resp->status, 200);
+        EXPECT_NE(resp->body.find("native-http-server"), std::string::npos) << resp->body;
+        std::string id = resp->header("mcp-session-id");
+        http.request("POST", R"({"jsonrpc":"2.0","method":"notifications/initialized"})",
+                     {"Mcp-Session-Id: " + id});
+        auto ack = http.read_response();
+        EXPECT_TRUE(ack && ack->status == 202);
+        return id;
+    }
+
+    void TearDown() override {
+        if (server_) server_->shutdown();
+        if (server_thread_.joinable()) server_thread_.join();
+    }
+};
+
+TEST_F(HttpNativeTest, JsonRequestsShareOneKeepAliveConnection) {
+    start();
+    RawHttp http(transport_->port());
+    ASSERT_TRUE(http.connected());
+    std::string session = initialize(http);
+    ASSERT_FALSE(session.empty());
+
+    for (int i = 0; i < 3; ++i) {
+        http.request("POST",
+                     R"({"jsonrpc":"2.0","id":)" + std::to_string(10 + i)
+                         + R"(,"method":"tools/call","params":{"name":"echo","arguments":{"text":"hi"}}})",
+                     {"Mcp-Session-Id: " + session});
+        auto resp = http.read_response();
+        ASSERT_TRUE(resp);
+        EXPECT_EQ(resp->status, 200);
+        auto json = nlohmann::json::parse(resp->body);
+        EXPECT_EQ(json["id"], 10 + i);
+        EXPECT_EQ(json["result"]["content"][0]["text"], "hi");
+    }
+
+    // A batch comes back as an array
+    http.request("POST", R"([{"jsonrpc":"2.0","id":"a","method":"ping"},{"jsonrpc":"2.0","id":"b","method":"ping"}])",
+                 {"Mcp-Session-Id: " + session});
+    auto batch = http.read_response();
+    ASSERT_TRUE(batch);
+    EXPECT_EQ(nlohmann::json::parse(batch->body).size(), 2u);
+}
+
+TEST_F(HttpNativeTest, PostStreamsResponsesAsSseWhenAccepted) {
+    start();
+    RawHttp http(transport_->port());
+    std::string session = initialize(http);
+    http.request("POST", R"({"jsonrpc":"2.0","id":7,"method":"ping"})",
+                 {"Mcp-Session-Id: " + session, "Accept: application/json, text/event-stream"});
+    auto resp = http.read_response();
+    ASSERT_TRUE(resp);
+    EXPECT_TRUE(resp->chunked);
+    EXPECT_EQ(resp->header("content-type"), "text/event-stream");
+    EXPECT_TRUE(http.read_until("\"id\":7"));
+    EXPECT_TRUE(http.read_until("event: done"));
+    auto last = http.read_chunk();
+    ASSERT_TRUE(last);
+    EXPECT_TRUE(last->empty());
+
+    // And the connection is reusable afterwards
+    http.request("POST", R"({"jsonrpc":"2.0","id":8,"method":"ping"})", {"Mcp-Session-Id: " + session});
+    auto next = http.read_response();
+    ASSERT_TRUE(next);
+    EXPECT_EQ(next->status, 200);
+}
+
+TEST_F(HttpNativeTest, ManyIdleStreamsNeedNoWorkers) {
+    HttpServerTransport::Options opts;
+    opts.max_connections = 2;  // POST workers; the streams must not need them
+    start(opts);
+
+    RawHttp control(transport_->port());
+    std::string session = initialize(control);
+
+    // Each GET without a session id opens a session of its own
+    constexpr int kStreams = 300;
+    std::vector<std::unique_ptr<RawHttp>> streams;
+    for (int i = 0; i < kStreams; ++i) {
+        streams.push_back(std::make_unique<RawHttp>(transport_->port()));
+        streams.back()->request("GET", {}, {"Accept: text/event-stream"});
+    }
+    for (auto& s : streams) {
+        auto resp = s->read_response();
+        ASSERT_TRUE(resp);
+        ASSERT_EQ(resp->status, 200);
+    }
+    EXPECT_EQ(transport_->stats().sessions, static_cast<size_t>(kStreams) + 1);
+
+    // POSTs still go through with every stream open
+    control.request("POST", R"({"jsonrpc":"2.0","id":2,"method":"ping"})", {"Mcp-Session-Id: " + session});
+    auto ping = control.read_response();
+    ASSERT_TRUE(ping);
+    EXPECT_EQ(ping->status, 200);
+
+    // A broadcast reaches every stream
+    JsonRpcNotification notif;
+    notif.method = "notifications/tools/list_changed";
+    transport_->send(notif);
+    for (auto& s : streams) EXPECT_TRUE(s->read_until("list_changed"));
+}
+
+TEST_F(HttpNativeTest, EachSessionStreamGetsItsEvents) {
+    start();
+    constexpr int kSessions = 50;
+    std::vector<std::unique_ptr<RawHttp>> controls, streams;
+    for (int i = 0; i < kSessions; ++i) {
+        controls.push_back(std::make_unique<RawHttp>(transport_->port()));
+        std::string session = initialize(*controls.back());
+        streams.push_back(std::make_unique<RawHttp>(transport_->port()));
+        streams.back()->request("GET", {}, {"Mcp-Session-Id: " + session});
+        auto resp = streams.back()->read_response();
+        ASSERT_TRUE(resp && resp->status == 200);
+    }
+    JsonRpcNotification notif;
+    notif.method = "notifications/tools/list_changed";
+    transport_->send(notif);
+    for (auto& s : streams) EXPECT_TRUE(s->read_until("list_changed"));
+}
+
+TEST_F(HttpNativeTest, IdleStreamsGetKeepAliveComments) {
+    HttpServerTransport::Options opts;
+    opts.sse_keepalive = std::chrono::seconds(1);
+    start(opts);
+    RawHttp http(transport_->port());
+    http.request("GET", {}, {"Accept: text/event-stream"});
+    auto resp = http.read_response();
+    ASSERT_TRUE(resp);
+    EXPECT_FALSE(resp->header("mcp-session-id").empty());
+    EXPECT_TRUE(http.read_until(": ping", 4s));
+}
+
+TEST_F(HttpNativeTest, DeletingASessionEndsItsStream) {
+    start();
+    RawHttp control(transport_->port());
+    std::string session = initialize(control);
+    RawHttp stream(transport_->port());
+    stream.request("GET", {}, {"Mcp-Session-Id: " + session});
+    ASSERT_TRUE(stream.read_response());
+
+    control.request("DELETE", {}, {"Mcp-Session-Id: " + session});
+    auto del = control.read_response();
+    ASSERT_TRUE(del);
+    EXPECT_EQ(del->status, 200);
+    auto last = stream.read_chunk();
+    ASSERT_TRUE(last);
+    EXPECT_TRUE(last->empty());
+    EXPECT_TRUE(stream.closed_by_peer());
+
+    control.request("POST", R"({"jsonrpc":"2.0","id":3,"method":"ping"})", {"Mcp-Session-Id: " + session});
+    auto gone = control.read_response();
+    ASSERT_TRUE(gone);
+    EXPECT_EQ(gone->status, 404);
+}
+
+TEST_F(HttpNativeTest, RejectsMalformedRequests) {
+    HttpServerTransport::Options opts;
+    opts.max_body_bytes = 1024;
+    opts.metrics_path = "/metrics";
+    start(opts);
+
+    RawHttp bad_json(transport_->port());
+    bad_json.request("POST", "{not json");
+    auto parse = bad_json.read_response();
+    ASSERT_TRUE(parse);
+    EXPECT_EQ(parse->status, 400);
+    EXPECT_NE(parse->body.find("-32700"), std::string::npos);
+
+    RawHttp other_path(transport_->port());
+    other_path.request("GET", {}, {}, "/elsewhere");
+    auto missing = other_path.read_response();
+    ASSERT_TRUE(missing);
+    EXPECT_EQ(missing->status, 404);
+
+    RawHttp metrics(transport_->port());
+    metrics.request("GET", {}, {}, "/metrics");
+    auto scrape = metrics.read_response();
+    ASSERT_TRUE(scrape);
+    EXPECT_EQ(scrape->status, 200);
+    EXPECT_NE(scrape->body.find("mcpxx_http_connections"), std::string::npos);
+
+    RawHttp too_big(transport_->port());
+    too_big.request("POST", std::string(2048, ' '));
+    auto large = too_big.read_response();
+    ASSERT_TRUE(large);
+    EXPECT_EQ(large->status, 413);
+    EXPECT_TRUE(too_big.closed_by_peer());
+
+    RawHttp garbage(transport_->port());
+    garbage.send_raw("NONSENSE\r\n\r\n");
+    auto bad = garbage.read_response();
+    ASSERT_TRUE(bad);
+    EXPECT_EQ(bad->status, 400);
+}
+
+TEST_F(HttpNativeTest, AnswersExpectContinue) {
+    start();
+    RawHttp http(transport_->port());
+    http.send_raw("POST /mcp HTTP/1.1\r\nHost: x\r\nContent-Type: application/json\r\n"
+                  "Expect: 100-continue\r\nContent-Length: " + std::to_string(kInitialize.size()) + "\r\n\r\n");
+    auto cont = http.read_response();
+    ASSERT_TRUE(cont);
+    EXPECT_EQ(cont->status, 100);
+    http.send_raw(kInitialize);
+    auto resp = http.read_response();
+    ASSERT_TRUE(resp);
+    EXPECT_EQ(resp->status, 200);
+}
+
+TEST_F(HttpNativeTest, ResumedStreamReplaysMissedEvents) {
+    start();
+    RawHttp control(transport_->port());
+    std::string session = initialize(control);
+    auto note = [&](int seq) {
+        JsonRpcNotification n;
+        n.method = "notifications/message";
+        n.params = nlohmann::json{{"level", "info"}, {"data", "event-" + std::to_string(seq)}};
+        transport_->send_to_session(session, n);
+    };
+
+    auto first = std::make_unique<RawHttp>(transport_->port());
+    first->request("GET", {}, {"Mcp-Session-Id: " + session});
+    ASSERT_TRUE(first->read_response());
+    note(1);
+    auto chunk = first->read_chunk();
+    ASSERT_TRUE(chunk);
+    EXPECT_NE(chunk->find("id: 1\ndata: "), std::string::npos) << *chunk;
+    first.reset();  // the link drops
+
+    note(2);
+    note(3);
+    RawHttp resumed(transport_->port());
+    resumed.request("GET", {}, {"Mcp-Session-Id: " + session, "Last-Event-ID: 1"});
+    auto resp = resumed.read_response();
+    ASSERT_TRUE(resp);
+    EXPECT_EQ(resp->status, 200);
+    std::string seen;
+    while (seen.find("event-3") == std::string::npos) {
+        auto next = resumed.read_chunk();
+        ASSERT_TRUE(next && !next->empty()) << seen;
+        seen += *next;
+    }
+    EXPECT_EQ(seen.find("event-1"), std::string::npos);
+    EXPECT_LT(seen.find("id: 2\n"), seen.find("event-2"));
+    EXPECT_LT(seen.find("event-2"), seen.find("event-3"));
+
+    // Then live events carry on from there
+    note(4);
+    EXPECT_TRUE(resumed.read_until("id: 4\ndata: "));
+}
+
+TEST_F(HttpNativeTest, ReplayCanBeTurnedOff) {
+    HttpServerTransport::Options opts;
+    opts.replay_events = 0;
+    start(opts);
+    RawHttp http(transport_->port());
+    http.request("GET", {}, {"Accept: text/event-stream"});
+    ASSERT_TRUE(http.read_response());
+    JsonRpcNotification notif;
+    notif.method = "notifications/tools/list_changed";
+    transport_->send(notif);
+    auto chunk = http.read_chunk();
+    ASSERT_TRUE(chunk);
+    EXPECT_EQ(chunk->rfind("data: ", 0), 0u) << *chunk;
+}
+
+TEST_F(HttpNativeTest, IdleSessionsAreEvicted) {
+    HttpServerTransport::Options opts;
+    opts.session_idle_timeout = std::chrono::seconds(1);
+    start(opts);
+    RawHttp idle(transport_->port());
+    std::string idle_session = initialize(idle);
+    RawHttp streaming(transport_->port());
+    std::string streaming_session = initialize(streaming);
+    RawHttp stream(transport_->port());
+    stream.request("GET", {}, {"Mcp-Session-Id: " + streaming_session});
+    ASSERT_TRUE(stream.read_response());
+
+    for (int i = 0; i < 100 && transport_->session_info(idle_session); ++i) {
+        std::this_thread::sleep_for(50ms);
+    }
+    EXPECT_FALSE(transport_->session_info(idle_session));
+    EXPECT_EQ(transport_->stats().evicted_sessions, 1u);
+
+    // A session with its stream open is in use, however long it is quiet
+    auto kept = transport_->session_info(streaming_session);
+    ASSERT_TRUE(kept);
+    EXPECT_EQ(kept->streams, 1);
+    EXPECT_EQ(kept->idle.count(), 0);
+
+    idle.request("POST", R"({"jsonrpc":"2.0","id":2,"method":"ping"})", {"Mcp-Session-Id: " + idle_session});
+    auto gone = idle.read_response();
+    ASSERT_TRUE(gone);
+    EXPECT_EQ(gone->status, 404);
+}
+
+TEST_F(HttpNativeTest, SessionCapEvictsLeastRecentlyUsed) {
+    HttpServerTransport::Options opts;
+    opts.max_sessions = 2;
+    start(opts);
+    RawHttp a(transport_->port()), b(transport_->port()), c(transport_->port());
+    std::string first = initialize(a);
+    std::string second = initialize(b);
+    a.request("POST", R"({"jsonrpc":"2.0","id":2,"method":"ping"})", {"Mcp-Session-Id: " + first});
+    ASSERT_TRUE(a.read_response());
+
+    std::string third = initialize(c);
+    EXPECT_TRUE(transport_->session_info(first));
+    EXPECT_FALSE(transport_->session_info(second));
+    EXPECT_TRUE(transport_->session_info(third));
+    auto stats = transport_->stats();
+    EXPECT_EQ(stats.sessions, 2u);
+    EXPECT_EQ(stats.evicted_sessions, 1u);
+}
+
+TEST_F(HttpNativeTest, SessionCapRefusesRatherThanEvictInUse) {
+    HttpServerTransport::Options opts;
+    opts.max_sessions = 1;
+    start(opts);
+    RawHttp a(transport_->port()), stream(transport_->port()), b(transport_->port());
+    std::string first = initialize(a);
+    stream.request("GET", {}, {"Mcp-Session-Id: " + first});
+    auto open = stream.read_response();
+    ASSERT_TRUE(open);
+    EXPECT_EQ(open->status, 200);
+
+    b.request("POST", kInitialize);
+    auto refused = b.read_response();
+    ASSERT_TRUE(refused);
+    EXPECT_EQ(refused->status, 503);
+    EXPECT_TRUE(transport_->session_info(first));
+    EXPECT_EQ(transport_->stats().evicted_sessions, 0u);
+}
+
+TEST_F(HttpNativeTest, SessionInfoAccountsForEventsHeld) {
+    start();
+    RawHttp control(transport_->port());
+    std::string session = initialize(control);
+    auto before = transport_->session_info(session);
+    ASSERT_TRUE(before);
+    EXPECT_GT(before->memory_bytes, 0u);
+    EXPECT_EQ(before->replay_events, 0u);
+
+    {
+        RawHttp stream(transport_->port());
+        stream.request("GET", {}, {"Mcp-Session-Id: " + session});
+        ASSERT_TRUE(stream.read_response());
+    }
+    for (int i = 0; i < 100 && transport_->session_info(session)->streams > 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    JsonRpcNotification n;
+    n.method = "notifications/message";
+    n.params = nlohmann::json{{"level", "info"}, {"data", std::string(4096, 'x')}};
+    for (int i = 0; i < 3; ++i) transport_->send_to_session(session, n);
+
+    auto after = transport_->session_info(session);
+    ASSERT_TRUE(after);
+    EXPECT_EQ(after->streams, 0);
+    EXPECT_EQ(after->replay_events, 3u);
+    EXPECT_GE(after->memory_bytes, before->memory_bytes + 3 * 4096);
+    EXPECT_GE(transport_->stats().memory_bytes, after->memory_bytes);
+    auto all = transport_->sessions();
+    ASSERT_EQ(all.size(), 1u);
+    EXPECT_EQ(all[0].id, session);
+}
+
+TEST_F(HttpNativeTest, LogLevelsAndSubscriptionsArePerSession) {
+    start();
+    RawHttp a(transport_->port()), b(transport_->port());
+    std::string first = initialize(a);
+    std::string second = initialize(b);
+    auto call = [](RawHttp& http, const std::string& session, const std::string& method,
+                   const std::string& params) {
+        http.request("POST", R"({"jsonrpc":"2.0","id":5,"method":")" + method + R"(","params":)" + params + "}",
+                     {"Mcp-Session-Id: " + session});
+        auto resp = http.read_response();
+        ASSERT_TRUE(resp);
+        EXPECT_NE(resp->body.find("\"result\""), std::string::npos) << resp->body;
+    };
+    call(a, first, "resources/subscribe", R"({"uri":"file:///watched"})");
+    call(b, second, "logging/setLevel", R"({"level":"debug"})");
+
+    RawHttp stream_a(transport_->port()), stream_b(transport_->port());
+    stream_a.request("GET", {}, {"Mcp-Session-Id: " + first});
+    stream_b.request("GET", {}, {"Mcp-Session-Id: " + second});
+    ASSERT_TRUE(stream_a.read_response());
+    ASSERT_TRUE(stream_b.read_response());
+
+    server_->log(LogLevel::Debug, "test", "only-b");
+    server_->notify_resource_updated("file:///watched");
+    server_->log(LogLevel::Warning, "test", "everyone");
+
+    std::string seen_a, seen_b;
+    while (seen_a.find("everyone") == std::string::npos) {
+        auto chunk = stream_a.read_chunk();
+        ASSERT_TRUE(chunk && !chunk->empty()) << seen_a;
+        seen_a += *chunk;
+    }
+    while (seen_b.find("everyone") == std::string::npos) {
+        auto chunk = stream_b.read_chunk();
+        ASSERT_TRUE(chunk && !chunk->empty()) << seen_b;
+        seen_b += *chunk;
+    }
+    EXPECT_EQ(seen_a.find("only-b"), std::string::npos);
+    EXPECT_NE(seen_a.find("file:///watched"), std::string::npos);
+    EXPECT_NE(seen_b.find("only-b"), std::string::npos);
+    EXPECT_EQ(seen_b.find("file:///watched"), std::string::npos);
+
+    // Ending a session drops what it asked for
+    a.request("DELETE", {}, {"Mcp-Session-Id: " + first});
+    ASSERT_TRUE(a.read_response());
+    b.request("DELETE", {}, {"Mcp-Session-Id: " + second});
+    ASSERT_TRUE(b.read_response());
+    EXPECT_FALSE(server_->log_enabled(LogLevel::Debug));
+}
+
+TEST_F(HttpNativeTest, CompressesBodiesAndStreamsForClientsThatAcceptIt) {
+    if (!coding_available(ContentCoding::Gzip) || !coding_available(ContentCoding::Zstd)) {
+        GTEST_SKIP() << "built without gzip or zstd";
+    }
+    start();
+    RawHttp http(transport_->port());
+    std::string session = initialize(http);
+    const std::string text(5000, 'z');
+    const std::string call = R"({"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"echo",)"
+                             R"("arguments":{"text":")" + text + R"("}}})";
+
+    http.request("POST", call, {"Mcp-Session-Id: " + session, "Accept-Encoding: gzip, br"});
+    auto resp = http.read_response();
+    ASSERT_TRUE(resp);
+    EXPECT_EQ(resp->header("content-encoding"), "gzip");
+    EXPECT_EQ(resp->header("accept-encoding"), "zstd, gzip");
+    EXPECT_LT(resp->body.size(), text.size() / 10);
+    auto body = decompress(resp->body, ContentCoding::Gzip, SIZE_MAX);
+    ASSERT_TRUE(body);
+    EXPECT_EQ(nlohmann::json::parse(*body)["result"]["content"][0]["text"], text);
+
+    // Too small to be worth it
+    http.request("POST", R"({"jsonrpc":"2.0","id":4,"method":"ping"})",
+                 {"Mcp-Session-Id: " + session, "Accept-Encoding: gzip"});
+    auto small = http.read_response();
+    ASSERT_TRUE(small);
+    EXPECT_TRUE(small->header("content-encoding").empty());
+    EXPECT_NE(small->body.find("\"id\":4"), std::string::npos);
+
+    // A stream is compressed throughout, each event decodable as it comes
+    RawHttp stream(transport_->port());
+    stream.request("GET", {}, {"Mcp-Session-Id: " + session, "Accept-Encoding: zstd"});
+    auto head = stream.read_response();
+    ASSERT_TRUE(head);
+    EXPECT_EQ(head->header("content-encoding"), "zstd");
+    StreamDecompressor decoder(ContentCoding::Zstd);
+    for (int i = 0; i < 3; ++i) {
+        JsonRpcNotification notif;
+        notif.method = "test/event" + std::to_string(i);
+        notif.params = nlohmann::json{{"pad", text}};
+        transport_->send(notif);
+        std::string seen;
+        while (seen.find(notif.method) == std::string::npos) {
+            auto chunk = stream.read_chunk();
+            ASSERT_TRUE(chunk && !chunk->empty());
+            decoder.write(*chunk, seen);
+        }
+    }
+}
+
+TEST_F(HttpNativeTest, AcceptsRequestBodiesInAdvertisedCodings) {
+    if (!coding_available(ContentCoding::Gzip)) GTEST_SKIP() << "built without gzip";
+    HttpServerTransport::Options opts;
+    opts.max_body_bytes = 64 * 1024;
+    start(opts);
+    RawHttp http(transport_->port());
+    std::string session = initialize(http);
+    const std::string text(20000, 'q');
+    const std::string call = R"({"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"echo",)"
+                             R"("arguments":{"text":")" + text + R"("}}})";
+
+    http.request("POST", compress(call, ContentCoding::Gzip),
+                 {"Mcp-Session-Id: " + session, "Content-Encoding: gzip"});
+    auto resp = http.read_response();
+    ASSERT_TRUE(resp);
+    EXPECT_EQ(resp->status, 200);
+    EXPECT_EQ(nlohmann::json::parse(resp->body)["result"]["content"][0]["text"], text);
+
+    http.request("POST", call, {"Mcp-Session-Id: " + session, "Content-Encoding: br"});
+    auto unknown = http.read_response();
+    ASSERT_TRUE(unknown);
+    EXPECT_EQ(unknown->status, 415);
+    EXPECT_FALSE(unknown->header("accept-encoding").empty());
+
+    http.request("POST", "not gzip at all", {"Mcp-Session-Id: " + session, "Content-Encoding: gzip"});
+    auto corrupt = http.read_response();
+    ASSERT_TRUE(corrupt);
+    EXPECT_EQ(corrupt->status, 400);
+
+    // Small on the wire, too big once inflated
+    const std::string huge = R"({"jsonrpc":"2.0","method":"x","params":{"pad":")"
+                             + std::string(1 << 20, ' ') + R"("}})";
+    http.request("POST", compress(huge, ContentCoding::Gzip),
+                 {"Mcp-Session-Id: " + session, "Content-Encoding: gzip"});
+    auto bomb = http.read_response();
+    ASSERT_TRUE(bomb);
+    EXPECT_EQ(bomb->status, 413);
+}
@@ -6,6 +6,11 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
 
 using namespace mcp;
 
@@ -57,3 +62,143 @@ TEST(ProgressTest, ProgressNotificationsReceived) {
     close(c2s[0]); close(c2s[1]);
     close(s2c[0]); close(s2c[1]);
 }
+
+namespace {
+
+// Server and client connected over a pair of pipes.
+struct PipeSession {
+    explicit PipeSession(McpServer::Options sopts) : server(std::move(sopts)) {
+        if (pipe(c2s) != 0 || pipe(s2c) != 0) throw std::runtime_error("pipe failed");
+    }
+
+    void start() {
+        server_thread = std::thread([this] {
+            server.serve(std::make_unique<StdioTransport>(c2s[0], s2c[1]));
+        });
+        McpClient::Options copts;
+        copts.client_info = {"test-client", std::nullopt, "1.0"};
+        copts.request_timeout = std::chrono::milliseconds(10000);
+        client = std::make_unique<McpClient>(copts);
+        client->connect(std::make_unique<StdioTransport>(s2c[0], c2s[1]));
+        auto init = client->initialize();
+    }
+
+    ~PipeSession() {
+        if (client) client->disconnect();
+        server.shutdown();
+        if (server_thread.joinable()) server_thread.join();
+        close(c2s[0]); close(c2s[1]);
+        close(s2c[0]); close(s2c[1]);
+    }
+
+    int c2s[2], s2c[2];
+    McpServer server;
+    std::unique_ptr<McpClient> client;
+    std::thread server_thread;
+};
+
+} // namespace
+
+TEST(ProgressTest, RateLimitedProgressDeliversLatestValue) {
+    constexpr int kUpdates = 200;
+    McpServer::Options sopts;
+    sopts.server_info = {"progress-server", std::nullopt, "1.0"};
+    sopts.max_progress_rate = 20;  // one per 50 ms
+    PipeSession s(sopts);
+
+    ToolDefinition td;
+    td.name = "tight_loop";
+    td.input_schema = nlohmann::json{{"type", "object"}};
+    s.server.add_tool(td, [&s](const nlohmann::json&) -> CallToolResult {
+        for (int i = 1; i <= kUpdates; ++i) {
+            s.server.send_progress(std::variant<int64_t, std::string>{"job"},
+                                   static_cast<double>(i), static_cast<double>(kUpdates));
+        }
+        return CallToolResult{};
+    });
+
+    std::mutex mutex;
+    std::vector<double> seen;
+    s.start();
+    s.client->on_progress([&](const ProgressInfo& info) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.push_back(info.progress);
+    });
+    auto result = s.client->call_tool("tight_loop", {});
+
+    // The held update follows within one interval
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (std::chrono::steady_clock::now() < deadline) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!seen.empty() && seen.back() == kUpdates) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_FALSE(seen.empty());
+    EXPECT_EQ(seen.back(), static_cast<double>(kUpdates));
+    EXPECT_LT(seen.size(), 10u);
+    EXPECT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+}
+
+TEST(ProgressTest, LogRateLimitSkipsBuildingDroppedMessages) {
+    McpServer::Options sopts;
+    sopts.server_info = {"log-server", std::nullopt, "1.0"};
+    sopts.max_log_rate = 10;  // one per 100 ms per logger
+    PipeSession s(sopts);
+
+    std::atomic<int> received{0};
+    s.start();
+    s.client->on_log_message([&](const LogMessage&) { ++received; });
+
+    int built = 0;
+    for (int i = 0; i < 100; ++i) {
+        s.server.log(LogLevel::Info, "burst", [&] {
+            ++built;
+            return nlohmann::json{{"i", i}};
+        });
+    }
+    // Below the minimum level nothing is built at all
+    s.server.log(LogLevel::Debug, "burst", [&] {
+        ++built;
+        return nlohmann::json("debug");
+    });
+
+    EXPECT_GE(built, 1);
+    EXPECT_LT(built, 5);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (received.load() < built && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(received.load(), built);
+}
+
+TEST(ProgressTest, LogRateLimitHoldsAcrossManyLoggers) {
+    McpServer::Options sopts;
+    sopts.server_info = {"log-server", std::nullopt, "1.0"};
+    sopts.max_log_rate = 0.2;  // one per 5 s per logger
+    PipeSession s(sopts);
+    std::atomic<int> received{0};
+    s.start();
+    s.client->on_log_message([&](const LogMessage&) { ++received; });
+
+    // Enough loggers that the limiter sweeps its table while all are live
+    constexpr int kLoggers = 3000;
+    int built = 0;
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < kLoggers; ++i) {
+            s.server.log(LogLevel::Info, "logger-" + std::to_string(i), [&] {
+                ++built;
+                return nlohmann::json(round);
+            });
+        }
+    }
+    EXPECT_EQ(built, kLoggers);
+    // Everything admitted arrives before the session is torn down
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received.load() < built && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(received.load(), built);
+}
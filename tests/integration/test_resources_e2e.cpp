@@ -1,11 +1,16 @@
 #include <gtest/gtest.h>
 #include "mcp/server.hpp"
+#include "mcp/base64.hpp"
 #include "mcp/client.hpp"
 #include "mcp/transport/stdio_transport.hpp"
 #include <unistd.h>
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
 
 using namespace mcp;
 
@@ -15,6 +20,7 @@ protected:
     std::unique_ptr<McpServer> server_;
     std::unique_ptr<McpClient> client_;
     std::thread server_thread_;
+    std::chrono::milliseconds update_window_{0};
 
     void SetUp() override {
         ASSERT_EQ(pipe(c2s_), 0);
@@ -22,6 +28,8 @@ protected:
 
         McpServer::Options sopts;
         sopts.server_info = {"test-server", std::nullopt, "1.0"};
+        sopts.resource_cache_bytes = 1 << 20;
+        sopts.resource_update_window = update_window_;
         server_ = std::make_unique<McpServer>(sopts);
 
         ResourceDefinition rd;
@@ -112,3 +120,174 @@ TEST_F(ResourcesE2ETest, SubscribeAndNotify) {
 
     client_->unsubscribe_resource("file:///config.json");
 }
+
+// Collects resources/updated notifications on the client
+struct UpdatedUris {
+    std::mutex mutex;
+    std::vector<std::string> uris;
+
+    void wait_for(size_t n) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (size() < n && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return uris.size();
+    }
+};
+
+TEST_F(ResourcesE2ETest, PrefixSubscriptionsAndBatchedUpdates) {
+    auto seen = std::make_shared<UpdatedUris>();
+    client_->on_resource_updated([seen](const std::string& uri) {
+        std::lock_guard<std::mutex> lock(seen->mutex);
+        seen->uris.push_back(uri);
+    });
+    client_->subscribe_resource("file:///logs/*");
+    client_->subscribe_resource("file:///logs/a");  // also covered by the prefix
+
+    std::vector<std::string> batch{"file:///logs/a", "file:///other", "file:///logs/b",
+                                   "file:///logs/a", "file:///log"};
+    server_->notify_resources_updated(batch);
+    seen->wait_for(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::lock_guard<std::mutex> lock(seen->mutex);
+        EXPECT_EQ(seen->uris, (std::vector<std::string>{"file:///logs/a", "file:///logs/b"}));
+        seen->uris.clear();
+    }
+
+    client_->unsubscribe_resource("file:///logs/*");
+    server_->notify_resources_updated(batch);
+    seen->wait_for(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::lock_guard<std::mutex> lock(seen->mutex);
+    EXPECT_EQ(seen->uris, std::vector<std::string>{"file:///logs/a"});
+}
+
+class CoalescedUpdatesTest : public ResourcesE2ETest {
+protected:
+    void SetUp() override {
+        update_window_ = std::chrono::milliseconds(100);
+        ResourcesE2ETest::SetUp();
+    }
+};
+
+TEST_F(CoalescedUpdatesTest, RepeatsWithinTheWindowAreSentOnce) {
+    auto seen = std::make_shared<UpdatedUris>();
+    client_->on_resource_updated([seen](const std::string& uri) {
+        std::lock_guard<std::mutex> lock(seen->mutex);
+        seen->uris.push_back(uri);
+    });
+    client_->subscribe_resource("*");
+
+    for (int i = 0; i < 50; ++i) {
+        server_->notify_resource_updated("file:///hot");
+        server_->notify_resource_updated("file:///warm/" + std::to_string(i % 2));
+    }
+    EXPECT_EQ(seen->size(), 0u);  // still inside the window
+    seen->wait_for(3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    std::lock_guard<std::mutex> lock(seen->mutex);
+    std::sort(seen->uris.begin(), seen->uris.end());
+    EXPECT_EQ(seen->uris, (std::vector<std::string>{"file:///hot", "file:///warm/0", "file:///warm/1"}));
+}
+
+TEST_F(ResourcesE2ETest, ReadThroughTemplateGetsVariables) {
+    ResourceTemplate tmpl;
+    tmpl.uri_template = "db://{tenant}/tables/{table}";
+    tmpl.name = "Table";
+    server_->add_resource_template(tmpl,
+        [](const std::string& uri, const UriTemplateVars& vars) -> std::vector<ResourceContent> {
+            return {ResourceContent{uri, std::nullopt,
+                    vars.at("tenant") + "." + vars.at("table"), std::nullopt}};
+        });
+
+    auto contents = client_->read_resource("db://acme/tables/users");
+    ASSERT_EQ(contents.size(), 1u);
+    EXPECT_EQ(*contents[0].text, "acme.users");
+
+    // Matched by the older "file:///{path}" template, not by prefix
+    EXPECT_EQ(*client_->read_resource("file:///notes.txt")[0].text, "file content");
+    EXPECT_THROW(client_->read_resource("db://acme/views/users"), McpProtocolError);
+
+    tmpl.uri_template = "db://{tenant";
+    EXPECT_THROW(server_->add_resource_template(tmpl,
+        [](const std::string&) -> std::vector<ResourceContent> { return {}; }), std::invalid_argument);
+}
+
+TEST_F(ResourcesE2ETest, CachedReadsUntilResourceUpdated) {
+    auto reads = std::make_shared<std::atomic<int>>(0);
+    ResourceDefinition rd;
+    rd.uri = "config://snapshot";
+    rd.name = "snapshot";
+    server_->add_resource(rd, [reads](const std::string& uri) -> std::vector<ResourceContent> {
+        int n = ++*reads;
+        return {ResourceContent{uri, std::nullopt, "v" + std::to_string(n), std::nullopt}};
+    });
+
+    EXPECT_EQ(*client_->read_resource("config://snapshot")[0].text, "v1");
+    EXPECT_EQ(*client_->read_resource("config://snapshot")[0].text, "v1");
+    EXPECT_EQ(reads->load(), 1);
+
+    server_->notify_resource_updated("config://snapshot");
+    EXPECT_EQ(*client_->read_resource("config://snapshot")[0].text, "v2");
+    EXPECT_EQ(reads->load(), 2);
+
+    // Errors are not cached
+    EXPECT_THROW(client_->read_resource("custom://nonexistent"), McpProtocolError);
+    rd.uri = "custom://nonexistent";
+    server_->add_resource(rd, [](const std::string& uri) -> std::vector<ResourceContent> {
+            return {ResourceContent{uri, std::nullopt, std::string("found"), std::nullopt}};
+        });
+    EXPECT_EQ(*client_->read_resource("custom://nonexistent")[0].text, "found");
+}
+
+TEST_F(ResourcesE2ETest, StreamedReadArrivesWhole) {
+    // Several chunks' worth, with a length that leaves a base64 remainder
+    std::string data;
+    for (size_t i = 0; i < 300 * 1024 + 1; ++i) data += static_cast<char>(i * 7 % 256);
+
+    ResourceDefinition rd;
+    rd.uri = "blob://big";
+    rd.name = "big";
+    server_->add_resource_stream(rd, [&data](const std::string&) {
+        ResourceStream s;
+        s.mime_type = "application/octet-stream";
+        s.read = [&data, off = size_t{0}](char* buf, size_t size) mutable {
+            size_t n = std::min(size, data.size() - off);
+            std::memcpy(buf, data.data() + off, n);
+            off += n;
+            return n;
+        };
+        return s;
+    });
+
+    auto contents = client_->read_resource("blob://big");
+    ASSERT_EQ(contents.size(), 1u);
+    EXPECT_EQ(contents[0].uri, "blob://big");
+    EXPECT_EQ(contents[0].mime_type, "application/octet-stream");
+    ASSERT_TRUE(contents[0].blob.has_value());
+    EXPECT_EQ(base64::decode(*contents[0].blob), data);
+
+    // Text content is escaped instead, and the connection stays usable
+    rd.uri = "text://quoted";
+    server_->add_resource_stream(rd, [](const std::string&) {
+        ResourceStream s;
+        s.binary = false;
+        s.read = [done = false](char* buf, size_t size) mutable -> size_t {
+            const std::string text = "line \"one\"\nline two";
+            if (done || size < text.size()) return 0;
+            done = true;
+            std::memcpy(buf, text.data(), text.size());
+            return text.size();
+        };
+        return s;
+    });
+    auto text = client_->read_resource("text://quoted");
+    ASSERT_EQ(text.size(), 1u);
+    EXPECT_EQ(text[0].text, "line \"one\"\nline two");
+    EXPECT_FALSE(text[0].blob.has_value());
+    EXPECT_EQ(*client_->read_resource("file:///config.json")[0].text, "{\"key\":\"value\"}");
+}
@@ -3,11 +3,23 @@
 #include "mcp/client.hpp"
 #include "mcp/transport/stdio_transport.hpp"
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <thread>
 #include <chrono>
+#include <optional>
 
 using namespace mcp;
 
+namespace {
+struct RepeatArgs {
+    std::string text;
+    std::optional<int> times;
+};
+MCPXX_ARGS(RepeatArgs, text, times)
+} // namespace
+
 class ToolsE2ETest : public ::testing::Test {
 protected:
     int c2s_[2], s2c_[2];
@@ -126,3 +138,426 @@ TEST_F(ToolsE2ETest, ListToolsPaginated) {
         EXPECT_FALSE(page2.items.empty());
     }
 }
+
+TEST_F(ToolsE2ETest, SlowToolDoesNotBlockOtherRequests) {
+    ToolDefinition slow_def;
+    slow_def.name = "slow";
+    slow_def.input_schema = nlohmann::json{{"type", "object"}};
+    server_->add_tool(slow_def, [](const nlohmann::json&) -> CallToolResult {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        CallToolResult result;
+        result.content.push_back(TextContent{"done", std::nullopt});
+        return result;
+    });
+
+    std::thread slow_caller([this]() {
+        auto result = client_->call_tool("slow", {});
+        EXPECT_FALSE(result.is_error);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // The echo response overtakes the in-flight slow call
+    auto start = std::chrono::steady_clock::now();
+    auto result = client_->call_tool("echo", {{"text", "fast"}});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_FALSE(result.is_error);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(300));
+
+    slow_caller.join();
+}
+
+TEST(ToolsE2EAsync, CallbackToolsDoNotHoldWorkers) {
+    int c2s[2], s2c[2];
+    ASSERT_EQ(pipe(c2s), 0);
+    ASSERT_EQ(pipe(s2c), 0);
+
+    McpServer::Options sopts;
+    sopts.server_info = {"async-server", std::nullopt, "1.0"};
+    sopts.thread_pool_size = 1;
+    McpServer server{sopts};
+
+    // Completes from a timer thread, like a downstream RPC callback would
+    std::mutex timers_mutex;
+    std::vector<std::thread> timers;
+    ToolDefinition def;
+    def.name = "deferred";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool_async(def, [&](const nlohmann::json& args, ToolResponder respond) {
+        std::string text = args.value("text", "");
+        std::lock_guard<std::mutex> lock(timers_mutex);
+        timers.emplace_back([respond, text] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            CallToolResult result;
+            result.content.push_back(TextContent{text, std::nullopt});
+            respond(result);
+        });
+    });
+    ToolDefinition fail_def;
+    fail_def.name = "deferred_fail";
+    fail_def.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool_async(fail_def, [](const nlohmann::json&, ToolResponder respond) {
+        respond.fail("downstream unavailable");
+    });
+
+    auto server_transport = std::make_unique<StdioTransport>(c2s[0], s2c[1]);
+    std::thread server_thread([&, t = std::move(server_transport)]() mutable {
+        server.serve(std::move(t));
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"test-client", std::nullopt, "1.0"};
+    copts.request_timeout = std::chrono::milliseconds(5000);
+    McpClient client{copts};
+    client.connect(std::make_unique<StdioTransport>(s2c[0], c2s[1]));
+    (void)client.initialize();
+
+    // Two in-flight calls on a single worker overlap instead of queuing
+    auto start = std::chrono::steady_clock::now();
+    std::thread second([&client] {
+        auto r = client.call_tool("deferred", {{"text", "b"}});
+        EXPECT_EQ(std::get<TextContent>(r.content[0]).text, "b");
+    });
+    auto r = client.call_tool("deferred", {{"text", "a"}});
+    second.join();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(std::get<TextContent>(r.content[0]).text, "a");
+    EXPECT_LT(elapsed, std::chrono::milliseconds(550));
+
+    auto failed = client.call_tool("deferred_fail", {});
+    EXPECT_TRUE(failed.is_error);
+
+    client.disconnect();
+    server.shutdown();
+    if (server_thread.joinable()) server_thread.join();
+    for (auto& t : timers) t.join();
+    close(c2s[0]); close(c2s[1]);
+    close(s2c[0]); close(s2c[1]);
+}
+
+TEST(ToolsE2EAsync, CoroutineToolAwaitsDownstreamServer) {
+    // downstream server <- client <- proxy server (coroutine tool) <- client
+    int d_c2s[2], d_s2c[2], p_c2s[2], p_s2c[2];
+    ASSERT_EQ(pipe(d_c2s), 0);
+    ASSERT_EQ(pipe(d_s2c), 0);
+    ASSERT_EQ(pipe(p_c2s), 0);
+    ASSERT_EQ(pipe(p_s2c), 0);
+
+    McpServer::Options dopts;
+    dopts.server_info = {"downstream", std::nullopt, "1.0"};
+    McpServer downstream{dopts};
+    ToolDefinition slow_def;
+    slow_def.name = "slow_upper";
+    slow_def.input_schema = nlohmann::json{{"type", "object"}};
+    downstream.add_tool(slow_def, [](const nlohmann::json& args) -> CallToolResult {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::string text = args.at("text").get<std::string>();
+        for (auto& c : text) c = static_cast<char>(std::toupper(c));
+        CallToolResult result;
+        result.content.push_back(TextContent{text, std::nullopt});
+        return result;
+    });
+    std::thread downstream_thread([&, t = std::make_unique<StdioTransport>(d_c2s[0], d_s2c[1])]() mutable {
+        downstream.serve(std::move(t));
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"proxy-client", std::nullopt, "1.0"};
+    copts.request_timeout = std::chrono::milliseconds(5000);
+    McpClient upstream{copts};
+    upstream.connect(std::make_unique<StdioTransport>(d_s2c[0], d_c2s[1]));
+    (void)upstream.initialize();
+
+    McpServer::Options popts;
+    popts.server_info = {"proxy", std::nullopt, "1.0"};
+    popts.thread_pool_size = 1;
+    McpServer proxy{popts};
+    ToolDefinition fwd_def;
+    fwd_def.name = "forward";
+    fwd_def.input_schema = nlohmann::json{{"type", "object"}};
+    proxy.add_tool_async(fwd_def, [&upstream](nlohmann::json args) -> CoTask<CallToolResult> {
+        auto result = co_await upstream.call_tool_async("slow_upper", args);
+        std::get<TextContent>(result.content[0]).text += "!";
+        co_return result;
+    });
+    ToolDefinition missing_def;
+    missing_def.name = "forward_missing";
+    missing_def.input_schema = nlohmann::json{{"type", "object"}};
+    proxy.add_tool_async(missing_def, [&upstream](nlohmann::json args) -> CoTask<CallToolResult> {
+        co_return co_await upstream.call_tool_async("no_such_tool", args);
+    });
+    std::thread proxy_thread([&, t = std::make_unique<StdioTransport>(p_c2s[0], p_s2c[1])]() mutable {
+        proxy.serve(std::move(t));
+    });
+
+    McpClient client{copts};
+    client.connect(std::make_unique<StdioTransport>(p_s2c[0], p_c2s[1]));
+    (void)client.initialize();
+
+    // Single proxy worker, two overlapping forwarded calls
+    auto a = client.call_tool_async("forward", {{"text", "a"}});
+    auto b = client.call_tool_async("forward", {{"text", "b"}});
+    EXPECT_EQ(std::get<TextContent>(a.get().content[0]).text, "A!");
+    EXPECT_EQ(std::get<TextContent>(b.get().content[0]).text, "B!");
+
+    // A downstream protocol error surfaces as an is_error tool result
+    auto missing = client.call_tool("forward_missing", {});
+    EXPECT_TRUE(missing.is_error);
+
+    client.disconnect();
+    proxy.shutdown();
+    if (proxy_thread.joinable()) proxy_thread.join();
+    upstream.disconnect();
+    downstream.shutdown();
+    if (downstream_thread.joinable()) downstream_thread.join();
+    for (int* p : {d_c2s, d_s2c, p_c2s, p_s2c}) { close(p[0]); close(p[1]); }
+}
+
+TEST_F(ToolsE2ETest, RawToolForwardsArgumentsVerbatim) {
+    std::string seen;
+    ToolDefinition def;
+    def.name = "passthrough";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server_->add_tool_raw(def, [&seen](std::string_view arguments) -> RawJson {
+        seen = std::string(arguments);
+        return RawJson{R"({"content":[{"type":"text","text":"forwarded"}],"isError":false})"};
+    });
+
+    nlohmann::json args = {{"payload", std::string(64 * 1024, 'x')}, {"n", 1}};
+    auto result = client_->call_tool("passthrough", args);
+    ASSERT_EQ(result.content.size(), 1u);
+    EXPECT_EQ(std::get<TextContent>(result.content[0]).text, "forwarded");
+    EXPECT_EQ(seen, args.dump());
+
+    // Ordinary tools on the same server still work alongside raw ones
+    auto echo = client_->call_tool("echo", {{"text", "hi"}});
+    EXPECT_EQ(std::get<TextContent>(echo.content[0]).text, "hi");
+}
+
+TEST_F(ToolsE2ETest, PipelinedRequestsFromOneThread) {
+    // Everything goes out before the first result is awaited
+    auto tools = client_->list_tools_async();
+    std::vector<Async<CallToolResult>> calls;
+    for (int i = 0; i < 16; ++i) {
+        calls.push_back(client_->call_tool_async("echo", {{"text", std::to_string(i)}}));
+    }
+    auto ping = client_->ping_async();
+    auto missing = client_->get_prompt_async("missing");
+
+    EXPECT_EQ(tools.get().items.size(), 2u);
+    for (int i = 0; i < 16; ++i) {
+        auto r = calls[static_cast<size_t>(i)].get();
+        EXPECT_EQ(std::get<TextContent>(r.content[0]).text, std::to_string(i));
+    }
+    EXPECT_NO_THROW(ping.get());
+    EXPECT_THROW(missing.get(), McpProtocolError);
+}
+
+TEST_F(ToolsE2ETest, CachedListFollowsRegistrations) {
+    auto before = client_->list_tools();
+    EXPECT_EQ(client_->list_tools(), before);  // served from the cache
+
+    ToolDefinition def;
+    def.name = "added";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server_->add_tool(def, [](const nlohmann::json&) -> CallToolResult { return {}; });
+    auto after = client_->list_tools();
+    ASSERT_EQ(after.items.size(), before.items.size() + 1);
+    EXPECT_EQ(after.items.back().name, "added");
+
+    server_->remove_tool("added");
+    EXPECT_EQ(client_->list_tools(), before);
+}
+
+TEST_F(ToolsE2ETest, CallsRunWhileToolsAreReRegistered) {
+    // A writer keeps replacing and removing tools; calls to "echo" must
+    // never see a missing or half-registered entry.
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (int i = 0; !stop.load(); ++i) {
+            ToolDefinition def;
+            def.name = "churn-" + std::to_string(i % 8);
+            def.input_schema = nlohmann::json{{"type", "object"}};
+            server_->add_tool(def, [](const nlohmann::json&) -> CallToolResult { return {}; });
+            if (i % 2) server_->remove_tool(def.name);
+        }
+    });
+
+    for (int i = 0; i < 200; ++i) {
+        auto r = client_->call_tool("echo", {{"text", std::to_string(i)}});
+        ASSERT_FALSE(r.is_error);
+        EXPECT_EQ(std::get<TextContent>(r.content[0]).text, std::to_string(i));
+    }
+    stop = true;
+    writer.join();
+
+    auto tools = client_->list_tools();
+    EXPECT_GE(tools.items.size(), 2u);
+}
+
+// Counts what the client hands to its transport
+class CountingTransport : public ITransport {
+public:
+    explicit CountingTransport(std::unique_ptr<ITransport> inner) : inner_(std::move(inner)) {}
+    void start(MessageCallback on_message, ErrorCallback on_error) override {
+        inner_->start(std::move(on_message), std::move(on_error));
+    }
+    void send(const JsonRpcMessage& msg) override { ++sends; inner_->send(msg); }
+    void send_batch(const std::vector<JsonRpcMessage>& msgs) override {
+        ++batches;
+        batched += msgs.size();
+        inner_->send_batch(msgs);
+    }
+    void shutdown() override { inner_->shutdown(); }
+    bool is_connected() const override { return inner_->is_connected(); }
+
+    std::atomic<int> sends{0}, batches{0};
+    std::atomic<size_t> batched{0};
+
+private:
+    std::unique_ptr<ITransport> inner_;
+};
+
+TEST(ToolsE2EBatching, ConcurrentCallsShareOneBatch) {
+    int c2s[2], s2c[2];
+    ASSERT_EQ(pipe(c2s), 0);
+    ASSERT_EQ(pipe(s2c), 0);
+
+    McpServer::Options sopts;
+    sopts.server_info = {"batch-server", std::nullopt, "1.0"};
+    McpServer server{sopts};
+    ToolDefinition def;
+    def.name = "echo";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool(def, [](const nlohmann::json& args) -> CallToolResult {
+        CallToolResult result;
+        result.content.push_back(TextContent{args.at("text").get<std::string>(), std::nullopt});
+        return result;
+    });
+    std::thread server_thread([&, t = std::make_unique<StdioTransport>(c2s[0], s2c[1])]() mutable {
+        server.serve(std::move(t));
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"test-client", std::nullopt, "1.0"};
+    copts.request_timeout = std::chrono::milliseconds(5000);
+    copts.batch_window = std::chrono::milliseconds(50);
+    copts.max_batch_size = 4;
+    McpClient client{copts};
+    auto transport = std::make_unique<CountingTransport>(
+        std::make_unique<StdioTransport>(s2c[0], c2s[1]));
+    auto* counting = transport.get();
+    client.connect(std::move(transport));
+    (void)client.initialize();
+
+    // Ten calls: two full batches go out at once, the rest when the window closes
+    std::vector<Async<CallToolResult>> calls;
+    for (int i = 0; i < 10; ++i) {
+        calls.push_back(client.call_tool_async("echo", {{"text", std::to_string(i)}}));
+    }
+    for (int i = 0; i < 10; ++i) {
+        auto r = calls[static_cast<size_t>(i)].get();
+        ASSERT_EQ(r.content.size(), 1u);
+        EXPECT_EQ(std::get<TextContent>(r.content[0]).text, std::to_string(i));
+    }
+    EXPECT_EQ(counting->batches.load(), 3);
+    EXPECT_EQ(counting->batched.load(), 10u);
+
+    client.disconnect();
+    server.shutdown();
+    if (server_thread.joinable()) server_thread.join();
+    close(c2s[0]); close(c2s[1]);
+    close(s2c[0]); close(s2c[1]);
+}
+
+TEST_F(ToolsE2ETest, TypedToolBindsArguments) {
+    ToolDefinition def;
+    def.name = "repeat";
+    server_->add_tool<RepeatArgs>(def, [](RepeatArgs args) {
+        std::string out;
+        for (int i = 0; i < args.times.value_or(1); ++i) out += args.text;
+        return CallToolResult{{TextContent{out, std::nullopt}}, std::nullopt, false};
+    });
+
+    auto tools = client_->list_tools();
+    auto it = std::find_if(tools.items.begin(), tools.items.end(),
+                           [](const ToolDefinition& t) { return t.name == "repeat"; });
+    ASSERT_NE(it, tools.items.end());
+    EXPECT_EQ(it->input_schema["required"], (nlohmann::json{"text"}));
+
+    auto result = client_->call_tool("repeat", {{"text", "ab"}, {"times", 3}});
+    EXPECT_FALSE(result.is_error);
+    EXPECT_EQ(std::get<TextContent>(result.content[0]).text, "ababab");
+
+    auto bad = client_->call_tool("repeat", {{"text", "ab"}, {"times", "3"}});
+    EXPECT_TRUE(bad.is_error);
+    EXPECT_EQ(std::get<TextContent>(bad.content[0]).text,
+              "Invalid argument 'times': expected integer");
+}
+
+TEST_F(ToolsE2ETest, SchemaValidationRejectsBadArgumentsAndResults) {
+    ToolDefinition def;
+    def.name = "square";
+    def.input_schema = {
+        {"type", "object"},
+        {"properties", {{"n", {{"type", "integer"}, {"maximum", 100}}}}},
+        {"required", {"n"}}
+    };
+    def.output_schema = nlohmann::json{
+        {"type", "object"},
+        {"properties", {{"value", {{"type", "integer"}}}}},
+        {"required", {"value"}}
+    };
+    server_->add_tool(def, [](const nlohmann::json& args) -> CallToolResult {
+        int n = args.at("n").get<int>();
+        CallToolResult result;
+        result.structured_content = n == 7 ? nlohmann::json{{"value", "seven"}}
+                                           : nlohmann::json{{"value", n * n}};
+        return result;
+    });
+
+    // Off by default: the handler sees whatever was sent
+    EXPECT_TRUE(client_->call_tool("square", {{"n", "3"}}).is_error);
+
+    server_->set_tool_validation("square", true);
+    auto ok = client_->call_tool("square", {{"n", 3}});
+    EXPECT_EQ(ok.structured_content, (nlohmann::json{{"value", 9}}));
+
+    try {
+        (void)client_->call_tool("square", {{"n", 101}});
+        FAIL() << "expected InvalidParams";
+    } catch (const McpProtocolError& e) {
+        EXPECT_EQ(e.code, error::InvalidParams);
+        EXPECT_NE(std::string(e.what()).find("/n: must be <= 100"), std::string::npos) << e.what();
+    }
+
+    try {
+        (void)client_->call_tool("square", {{"n", 7}});
+        FAIL() << "expected InternalError";
+    } catch (const McpProtocolError& e) {
+        EXPECT_EQ(e.code, error::InternalError);
+        EXPECT_NE(std::string(e.what()).find("output schema"), std::string::npos) << e.what();
+    }
+
+    server_->set_tool_validation("square", false);
+    auto unchecked = client_->call_tool("square", {{"n", 7}});
+    EXPECT_EQ(unchecked.structured_content, (nlohmann::json{{"value", "seven"}}));
+}
+
+TEST_F(ToolsE2ETest, SchemaValidationChecksRawToolArguments) {
+    ToolDefinition def;
+    def.name = "raw_len";
+    def.input_schema = {
+        {"type", "object"},
+        {"properties", {{"s", {{"type", "string"}, {"maxLength", 3}}}}},
+        {"additionalProperties", false}
+    };
+    server_->set_tool_validation("raw_len", true);
+    server_->add_tool_raw(def, [](std::string_view) -> RawJson {
+        return RawJson{R"({"content":[{"type":"text","text":"ok"}],"isError":false})"};
+    });
+
+    auto ok = client_->call_tool("raw_len", {{"s", "abc"}});
+    EXPECT_FALSE(ok.is_error);
+    EXPECT_THROW(client_->call_tool("raw_len", {{"s", "abcd"}}), McpProtocolError);
+    EXPECT_THROW(client_->call_tool("raw_len", {{"s", "a"}, {"t", 1}}), McpProtocolError);
+}
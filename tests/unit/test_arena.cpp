@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "mcp/arena.hpp"
+#include "mcp/codec.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace mcp;
+
+TEST(ScratchArena, ScopeRewindsForReuse) {
+    ScratchArena arena;
+    char* first = nullptr;
+    {
+        ScratchArena::Scope scope(arena);
+        first = arena.allocate_bytes(100);
+        EXPECT_NE(arena.allocate_bytes(100), first);
+    }
+    ScratchArena::Scope scope(arena);
+    EXPECT_EQ(arena.allocate_bytes(100), first);
+    EXPECT_EQ(arena.capacity(), ScratchArena::kBlockBytes);
+}
+
+TEST(ScratchArena, NestedScopesKeepOuterMemory) {
+    ScratchArena arena;
+    ScratchArena::Scope outer(arena);
+    char* kept = arena.allocate_bytes(64);
+    std::memset(kept, 'x', 64);
+    char* inner_first = nullptr;
+    {
+        ScratchArena::Scope inner(arena);
+        inner_first = arena.allocate_bytes(64);
+        EXPECT_NE(inner_first, kept);
+        std::memset(inner_first, 'y', 64);
+    }
+    EXPECT_EQ(arena.allocate_bytes(64), inner_first);
+    EXPECT_EQ(std::string(kept, 64), std::string(64, 'x'));
+}
+
+TEST(ScratchArena, AlignsAndSpillsIntoNewBlocks) {
+    ScratchArena arena;
+    ScratchArena::Scope scope(arena);
+    (void)arena.allocate(1, 1);
+    void* p = arena.allocate(8, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0u);
+
+    // Larger than a block: gets a block of its own
+    char* big = arena.allocate_bytes(ScratchArena::kBlockBytes * 3);
+    big[ScratchArena::kBlockBytes * 3 - 1] = 1;
+    EXPECT_GT(arena.capacity(), ScratchArena::kBlockBytes * 3);
+}
+
+TEST(ScratchArena, DropsBlocksPastRetentionBudget) {
+    ScratchArena arena;
+    {
+        ScratchArena::Scope scope(arena);
+        (void)arena.allocate_bytes(64);
+        (void)arena.allocate_bytes(ScratchArena::kRetainBytes * 2);
+    }
+    EXPECT_EQ(arena.capacity(), ScratchArena::kBlockBytes);
+}
+
+TEST(ScratchArena, BacksPmrContainers) {
+    ScratchArena arena;
+    ScratchArena::Scope scope(arena);
+    std::pmr::vector<std::pmr::string> v(&arena);
+    for (int i = 0; i < 1000; ++i) v.emplace_back("item number " + std::to_string(i));
+    EXPECT_EQ(v[999], "item number 999");
+}
+
+TEST(ScratchArena, CodecParseLeavesThreadArenaSteady) {
+    std::string line = R"({"jsonrpc":"2.0","id":1,"method":"ping","params":{"k":"v"}})";
+    (void)Codec::parse(line);
+    size_t capacity = ScratchArena::local().capacity();
+    for (int i = 0; i < 100; ++i) {
+        auto msg = Codec::parse(line);
+        ASSERT_TRUE(std::holds_alternative<JsonRpcRequest>(msg));
+        EXPECT_EQ(*std::get<JsonRpcRequest>(msg).params->find("k"), "v");
+    }
+    EXPECT_EQ(ScratchArena::local().capacity(), capacity);
+
+    // Results point into the caller's text, not the arena
+    std::string object = R"({"a":[1,2],"b":"x"})";
+    auto found = Codec::find_raw_member(object, "a");
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(found->data(), object.data() + 5);
+}
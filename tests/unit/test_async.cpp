@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "mcp/async.hpp"
+#include "mcp/router.hpp"
+#include "mcp/error.hpp"
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace mcp;
+
+namespace {
+
+CoTask<int> add(Async<int> a, int b) {
+    int v = co_await a;
+    co_return v + b;
+}
+
+CoTask<int> sum_chain(int depth) {
+    if (depth == 0) co_return 0;
+    int rest = co_await sum_chain(depth - 1);
+    co_return rest + 1;
+}
+
+CoTask<void> set_flag(bool& flag) {
+    flag = true;
+    co_return;
+}
+
+CoTask<int> throws() {
+    throw std::runtime_error("boom");
+    co_return 0;
+}
+
+CoTask<bool> cancelled_after(Async<int> a) {
+    (void)co_await a;
+    co_return CancellationToken::current().is_cancelled();
+}
+
+} // anonymous namespace
+
+TEST(Async, GetReturnsValue) {
+    AsyncPromise<int> promise;
+    auto result = promise.get_async();
+    EXPECT_FALSE(result.is_ready());
+    promise.set_value(5);
+    EXPECT_TRUE(result.is_ready());
+    EXPECT_EQ(result.get(), 5);
+}
+
+TEST(Async, GetRethrowsException) {
+    AsyncPromise<std::string> promise;
+    auto result = promise.get_async();
+    promise.set_exception(std::make_exception_ptr(McpTimeoutError("late")));
+    EXPECT_THROW(result.get(), McpTimeoutError);
+}
+
+TEST(Async, WaitForTimesOut) {
+    AsyncPromise<int> promise;
+    auto result = promise.get_async();
+    EXPECT_EQ(result.wait_for(std::chrono::milliseconds(10)), std::future_status::timeout);
+    promise.set_value(1);
+    EXPECT_EQ(result.wait_for(std::chrono::milliseconds(10)), std::future_status::ready);
+}
+
+TEST(Async, FirstCompletionWins) {
+    AsyncPromise<int> promise;
+    auto result = promise.get_async();
+    promise.set_value(1);
+    promise.set_value(2);
+    promise.set_exception(std::make_exception_ptr(std::runtime_error("ignored")));
+    EXPECT_EQ(result.get(), 1);
+}
+
+TEST(Async, CancelRunsTheProducersCancellerOnce) {
+    AsyncPromise<int> promise;
+    auto result = promise.get_async();
+    EXPECT_FALSE(result.cancel());
+
+    int runs = 0;
+    promise.on_cancel([&] {
+        ++runs;
+        promise.set_exception(std::make_exception_ptr(std::runtime_error("cancelled")));
+    });
+    EXPECT_TRUE(result.cancel());
+    EXPECT_FALSE(result.cancel());
+    EXPECT_EQ(runs, 1);
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(Async, CancelAfterCompletionDoesNothing) {
+    AsyncPromise<int> promise;
+    auto result = promise.get_async();
+    bool ran = false;
+    promise.on_cancel([&] { ran = true; });
+    promise.set_value(3);
+    EXPECT_FALSE(result.cancel());
+    EXPECT_FALSE(ran);
+    EXPECT_EQ(result.get(), 3);
+}
+
+TEST(CancellationToken, CallbacksRunOnceAndLateOnesAtOnce) {
+    CancellationToken token;
+    int a = 0, b = 0, late = 0;
+    (void)token.on_cancel([&] { ++a; });
+    uint64_t removed = token.on_cancel([&] { ++b; });
+    token.remove_on_cancel(removed);
+    EXPECT_FALSE(token.is_cancelled());
+
+    token.cancel();
+    token.cancel();
+    EXPECT_TRUE(token.is_cancelled());
+    EXPECT_EQ(a, 1);
+    EXPECT_EQ(b, 0);
+    EXPECT_EQ(token.on_cancel([&] { ++late; }), 0u);
+    EXPECT_EQ(late, 1);
+}
+
+TEST(CancellationToken, CurrentFollowsACoroutineAcrossSuspension) {
+    EXPECT_FALSE(CancellationToken::current().cancellable());
+
+    CancellationToken token;
+    AsyncPromise<int> promise;
+    std::optional<bool> seen;
+    {
+        detail::CancellationScope scope(token);
+        spawn(cancelled_after(promise.get_async()), [&](bool v) { seen = v; },
+              [](std::exception_ptr) {});
+    }
+    token.cancel();
+    // Completed from a thread outside any request
+    std::thread([&] { promise.set_value(1); }).join();
+    ASSERT_TRUE(seen.has_value());
+    EXPECT_TRUE(*seen);
+    EXPECT_FALSE(CancellationToken::current().cancellable());
+}
+
+TEST(CoTask, AwaitsAsyncCompletedOnAnotherThread) {
+    AsyncPromise<int> promise;
+    std::optional<int> value;
+    std::thread::id resumed_on;
+    spawn(add(promise.get_async(), 2),
+          [&](int v) { value = v; resumed_on = std::this_thread::get_id(); },
+          [](std::exception_ptr) { FAIL(); });
+    EXPECT_FALSE(value.has_value());  // suspended, not blocked
+
+    std::thread::id producer;
+    std::thread t([&] { producer = std::this_thread::get_id(); promise.set_value(40); });
+    t.join();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value, 42);
+    EXPECT_EQ(resumed_on, producer);
+}
+
+TEST(CoTask, AlreadyReadyAsyncDoesNotSuspend) {
+    AsyncPromise<int> promise;
+    promise.set_value(1);
+    std::optional<int> value;
+    spawn(add(promise.get_async(), 1), [&](int v) { value = v; }, [](std::exception_ptr) {});
+    EXPECT_EQ(value, 2);
+}
+
+TEST(CoTask, ResumesOnExecutor) {
+    auto executor = std::make_shared<WorkStealingExecutor>(WorkStealingExecutor::Options{1, false});
+    std::thread::id worker;
+    executor->post([&worker] { worker = std::this_thread::get_id(); });
+
+    AsyncPromise<int> promise(executor);
+    AsyncPromise<std::thread::id> done;
+    auto resumed = done.get_async();
+    spawn(add(promise.get_async(), 0),
+          [&, done](int) { done.set_value(std::this_thread::get_id()); },
+          [](std::exception_ptr) {});
+    promise.set_value(0);
+    EXPECT_EQ(resumed.get(), worker);
+    executor->shutdown();
+}
+
+TEST(CoTask, DeepChainUsesSymmetricTransfer) {
+    std::optional<int> value;
+    spawn(sum_chain(10000), [&](int v) { value = v; }, [](std::exception_ptr) {});
+    EXPECT_EQ(value, 10000);
+}
+
+TEST(CoTask, VoidTask) {
+    bool flag = false;
+    bool done = false;
+    spawn(set_flag(flag), [&] { done = true; }, [](std::exception_ptr) {});
+    EXPECT_TRUE(flag);
+    EXPECT_TRUE(done);
+}
+
+TEST(CoTask, ExceptionReachesErrorCallback) {
+    std::string message;
+    spawn(throws(), [](int) {}, [&](std::exception_ptr e) {
+        try { std::rethrow_exception(e); } catch (const std::exception& ex) { message = ex.what(); }
+    });
+    EXPECT_EQ(message, "boom");
+}
+
+TEST(CoTask, RouterCoroutineHandler) {
+    Router router;
+    AsyncPromise<int> downstream;
+    router.on_request_co("proxy", [downstream](nlohmann::json params) -> CoTask<HandlerResult> {
+        int v = co_await downstream.get_async();
+        co_return nlohmann::json{{"sum", v + params.at("x").get<int>()}};
+    });
+    router.on_request_co("broken", [](nlohmann::json) -> CoTask<HandlerResult> {
+        throw McpProtocolError(error::InvalidParams, "nope");
+        co_return nlohmann::json{};
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "proxy";
+    req.params = nlohmann::json{{"x", 1}};
+    std::optional<JsonRpcMessage> reply;
+    router.dispatch(req, [&reply](JsonRpcMessage m) { reply = std::move(m); });
+    EXPECT_FALSE(reply.has_value());
+    downstream.set_value(41);
+    ASSERT_TRUE(reply.has_value());
+    EXPECT_EQ(std::get<JsonRpcResponse>(*reply).result->at("sum"), 42);
+
+    req.method = "broken";
+    auto response = router.dispatch(req);
+    ASSERT_TRUE(response.has_value());
+    EXPECT_EQ(std::get<JsonRpcResponse>(*response).error->code, error::InvalidParams);
+}
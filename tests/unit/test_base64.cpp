@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "mcp/base64.hpp"
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+using namespace mcp;
+
+// Bit-at-a-time reference to check the vector kernels against
+static std::string reference_encode(const std::string& in) {
+    static const char* kAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (unsigned char c : in) {
+        acc = (acc << 8) | c;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out += kAlphabet[(acc >> bits) & 0x3F];
+        }
+    }
+    if (bits > 0) out += kAlphabet[(acc << (6 - bits)) & 0x3F];
+    while (out.size() % 4) out += '=';
+    return out;
+}
+
+static std::string pseudo_random_bytes(size_t n, uint32_t seed) {
+    std::string out(n, '\0');
+    for (auto& c : out) {
+        seed = seed * 1664525u + 1013904223u;
+        c = static_cast<char>(seed >> 24);
+    }
+    return out;
+}
+
+TEST(Base64, Rfc4648Vectors) {
+    EXPECT_EQ(base64::encode(""), "");
+    EXPECT_EQ(base64::encode("f"), "Zg==");
+    EXPECT_EQ(base64::encode("fo"), "Zm8=");
+    EXPECT_EQ(base64::encode("foo"), "Zm9v");
+    EXPECT_EQ(base64::encode("foob"), "Zm9vYg==");
+    EXPECT_EQ(base64::encode("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(base64::encode("foobar"), "Zm9vYmFy");
+    EXPECT_EQ(base64::decode("Zm9vYmE="), "fooba");
+    EXPECT_EQ(base64::encoded_size(4), 8u);
+}
+
+TEST(Base64, RoundTripsEveryByte) {
+    std::string bytes;
+    for (int i = 0; i < 256; ++i) bytes += static_cast<char>(i);
+    for (size_t n = 0; n <= bytes.size(); n += 37) {
+        auto in = bytes.substr(0, n);
+        EXPECT_EQ(base64::decode(base64::encode(in)), in);
+    }
+}
+
+TEST(Base64, RejectsMalformedInput) {
+    EXPECT_THROW(base64::decode("Zm9"), std::invalid_argument);
+    EXPECT_THROW(base64::decode("Zm9*"), std::invalid_argument);
+    EXPECT_THROW(base64::decode("Zg==Zm9v"), std::invalid_argument);
+    EXPECT_THROW(base64::decode("===="), std::invalid_argument);
+}
+
+TEST(Base64, EncoderMatchesOneShotForAnySplit) {
+    const std::string input = "The quick brown fox jumps over the lazy dog\x01\xff";
+    for (size_t step = 1; step <= 7; ++step) {
+        base64::Encoder enc;
+        std::string out;
+        for (size_t off = 0; off < input.size(); off += step) {
+            enc.update(out, std::string_view(input).substr(off, step));
+        }
+        enc.finish(out);
+        EXPECT_EQ(out, base64::encode(input)) << "step " << step;
+    }
+}
+
+TEST(Base64, VectorPathsMatchReference) {
+    EXPECT_FALSE(base64::implementation().empty());
+    // Sizes around every block boundary of the AVX2 and NEON kernels
+    for (size_t n = 0; n < 300; ++n) {
+        auto bytes = pseudo_random_bytes(n, static_cast<uint32_t>(n));
+        auto text = base64::encode(bytes);
+        ASSERT_EQ(text, reference_encode(bytes)) << "size " << n << " via " << base64::implementation();
+        ASSERT_EQ(base64::decode(text), bytes) << "size " << n;
+    }
+    auto big = pseudo_random_bytes(1 << 20, 7);
+    EXPECT_EQ(base64::decode(base64::encode(big)), big);
+}
+
+TEST(Base64, VectorDecodeRejectsEveryBadCharacter) {
+    const std::string good = base64::encode(pseudo_random_bytes(96, 3));  // 128 characters
+    for (int c = 0; c < 256; ++c) {
+        if (std::isalnum(c) || c == '+' || c == '/') continue;
+        for (size_t pos : {size_t{0}, size_t{31}, size_t{64}, size_t{100}}) {
+            std::string bad = good;
+            bad[pos] = static_cast<char>(c);
+            EXPECT_THROW(base64::decode(bad), std::invalid_argument) << "char " << c << " at " << pos;
+        }
+    }
+}
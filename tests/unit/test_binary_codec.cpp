@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "mcp/binary_codec.hpp"
+#include "mcp/codec.hpp"
+#include "mcp/transport/line_buffer.hpp"
+#include "mcp/transport/stdio_transport.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace mcp;
+
+namespace {
+
+JsonRpcRequest make_request() {
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{42}};
+    req.method = "tools/call";
+    req.params = nlohmann::json{{"name", "echo"}, {"arguments", {{"text", "hi"}, {"n", 1.5}}}};
+    return req;
+}
+
+// Feeds `bytes` to a LineBuffer `step` bytes at a time
+std::vector<JsonRpcMessage> feed(const std::string& bytes, size_t step,
+                                 std::vector<std::string>* errors = nullptr) {
+    LineBuffer buffer(512);
+    std::vector<JsonRpcMessage> out;
+    auto on_message = [&](JsonRpcMessage msg) { out.push_back(std::move(msg)); };
+    auto on_error = [&](std::exception_ptr e) {
+        try {
+            std::rethrow_exception(e);
+        } catch (const std::exception& ex) {
+            if (errors) errors->push_back(ex.what());
+        }
+    };
+    for (size_t off = 0; off < bytes.size();) {
+        char* dst = buffer.write_ptr();
+        size_t n = std::min({step, bytes.size() - off, buffer.write_size()});
+        std::memcpy(dst, bytes.data() + off, n);
+        buffer.commit(n);
+        off += n;
+        buffer.deliver(on_message, on_error);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(BinaryCodec, FormatNames) {
+    EXPECT_EQ(to_string(WireFormat::MessagePack), "msgpack");
+    EXPECT_EQ(parse_wire_format("cbor"), WireFormat::Cbor);
+    EXPECT_EQ(parse_wire_format("json"), WireFormat::Json);
+    EXPECT_FALSE(parse_wire_format("bson"));
+}
+
+TEST(BinaryCodec, RoundTripsEveryMessageKind) {
+    JsonRpcResponse resp;
+    resp.id = RequestId{std::string("abc")};
+    resp.result = nlohmann::json{{"blob", std::string(1000, 'z')}, {"ok", true}};
+    JsonRpcResponse failed;
+    failed.id = RequestId{int64_t{3}};
+    failed.error = JsonRpcError{-32601, "Method not found", std::nullopt};
+    JsonRpcNotification note;
+    note.method = "notifications/progress";
+    note.params = nlohmann::json{{"progress", 1}};
+
+    for (auto format : {WireFormat::MessagePack, WireFormat::Cbor}) {
+        for (const JsonRpcMessage& msg : std::vector<JsonRpcMessage>{make_request(), resp, failed, note}) {
+            std::string frame;
+            BinaryCodec::encode_frame(frame, msg, format);
+            ASSERT_EQ(frame[0], BinaryCodec::kFrameMarker);
+            auto [got_format, length] = BinaryCodec::read_header(frame.data());
+            EXPECT_EQ(got_format, format);
+            EXPECT_EQ(length, frame.size() - BinaryCodec::kFrameHeaderSize);
+
+            auto decoded = BinaryCodec::decode(
+                std::string_view(frame).substr(BinaryCodec::kFrameHeaderSize), format);
+            ASSERT_EQ(decoded.size(), 1u);
+            EXPECT_EQ(decoded[0], msg);
+        }
+    }
+
+    // Smaller than the JSON text
+    std::string frame;
+    BinaryCodec::encode_frame(frame, make_request(), WireFormat::MessagePack);
+    EXPECT_LT(frame.size(), Codec::serialize(make_request()).size());
+}
+
+TEST(BinaryCodec, BatchesDecodeToSeveralMessages) {
+    std::vector<JsonRpcMessage> batch{make_request(), make_request()};
+    std::get<JsonRpcRequest>(batch[1]).id = RequestId{int64_t{43}};
+    std::string frame;
+    BinaryCodec::encode_batch_frame(frame, batch, WireFormat::Cbor);
+    auto decoded = BinaryCodec::decode(
+        std::string_view(frame).substr(BinaryCodec::kFrameHeaderSize), WireFormat::Cbor);
+    EXPECT_EQ(decoded, batch);
+}
+
+TEST(BinaryCodec, RejectsGarbage) {
+    EXPECT_THROW((void)BinaryCodec::decode("\xc1", WireFormat::MessagePack), McpParseError);
+    // Decodes, but isn't a message
+    std::string not_a_message;
+    nlohmann::json::to_msgpack(nlohmann::json{{"hello", 1}}, not_a_message);
+    EXPECT_THROW((void)BinaryCodec::decode(not_a_message, WireFormat::MessagePack), McpParseError);
+    const char header[] = {'\0', 'X', 0, 0, 0, 0};
+    EXPECT_THROW((void)BinaryCodec::read_header(header), McpParseError);
+    std::string frame;
+    EXPECT_THROW(BinaryCodec::encode_frame(frame, make_request(), WireFormat::Json),
+                 std::invalid_argument);
+}
+
+TEST(LineBuffer, FramesAndLinesInterleave) {
+    std::string stream = Codec::serialize(make_request()) + "\n";
+    JsonRpcNotification big;
+    big.method = "test/big";
+    big.params = nlohmann::json{{"data", std::string(5000, 'q')}};
+    BinaryCodec::encode_frame(stream, big, WireFormat::MessagePack);
+    BinaryCodec::encode_frame(stream, make_request(), WireFormat::Cbor);
+    stream += "\r\n" + Codec::serialize(big) + "\n";
+
+    for (size_t step : {1ul, 7ul, 100ul, stream.size()}) {
+        auto msgs = feed(stream, step);
+        ASSERT_EQ(msgs.size(), 4u) << "step " << step;
+        EXPECT_EQ(msgs[0], JsonRpcMessage(make_request()));
+        EXPECT_EQ(msgs[1], JsonRpcMessage(big));
+        EXPECT_EQ(msgs[2], JsonRpcMessage(make_request()));
+        EXPECT_EQ(std::get<JsonRpcNotification>(msgs[3]).method, "test/big");
+    }
+}
+
+TEST(LineBuffer, BadFrameIsReported) {
+    std::string stream;
+    BinaryCodec::encode_frame(stream, make_request(), WireFormat::MessagePack);
+    stream[BinaryCodec::kFrameHeaderSize] = '\xc1';  // never valid in MessagePack
+    BinaryCodec::encode_frame(stream, make_request(), WireFormat::MessagePack);
+
+    std::vector<std::string> errors;
+    auto msgs = feed(stream, stream.size(), &errors);
+    EXPECT_EQ(msgs.size(), 1u);  // the frame after it still decodes
+    EXPECT_EQ(errors.size(), 1u);
+}
+
+TEST(StdioTransport, SendsBinaryFramesOnceSwitched) {
+    int a_to_b[2];
+    ASSERT_EQ(pipe(a_to_b), 0);
+    int unused[2];
+    ASSERT_EQ(pipe(unused), 0);
+    StdioTransport a(unused[0], a_to_b[1]);
+    StdioTransport b(a_to_b[0], unused[1]);
+    EXPECT_TRUE(a.supports_wire_format(WireFormat::Cbor));
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<JsonRpcMessage> received;
+    std::thread reader([&] {
+        b.start([&](JsonRpcMessage msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(std::move(msg));
+            cv.notify_all();
+        });
+    });
+    std::thread writer([&] { a.start([](JsonRpcMessage) {}); });
+
+    a.send(make_request());
+    ASSERT_TRUE(a.set_wire_format(WireFormat::Cbor));
+    a.send(make_request());
+    a.send_batch({make_request(), make_request()});
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return received.size() >= 4; }));
+        for (const auto& msg : received) EXPECT_EQ(msg, JsonRpcMessage(make_request()));
+    }
+    EXPECT_LT(a.stats().bytes_written, 4 * Codec::serialize(make_request()).size());
+
+    a.shutdown();
+    b.shutdown();
+    reader.join();
+    writer.join();
+}
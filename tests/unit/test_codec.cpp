@@ -79,6 +79,115 @@ TEST(CodecParse, RequestWithParams) {
     EXPECT_EQ(req.params->at("name"), "echo");
 }
 
+TEST(CodecParse, ParamsStayRawUntilAccessed) {
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"tools/call","params":{"name":"echo","arguments":{"text":"hi"}}})");
+    auto& req = std::get<JsonRpcRequest>(msg);
+    ASSERT_TRUE(req.params.has_value());
+    EXPECT_TRUE(req.params.is_raw());
+    ASSERT_TRUE(req.params.raw().has_value());
+    EXPECT_EQ(*req.params.raw(), R"({"name":"echo","arguments":{"text":"hi"}})");
+
+    const auto& cparams = req.params;
+    EXPECT_EQ(cparams->at("arguments").at("text"), "hi");
+    EXPECT_FALSE(req.params.is_raw());
+    // Read-only access keeps the wire text
+    EXPECT_TRUE(req.params.raw().has_value());
+
+    // Mutable access invalidates it
+    (*req.params)["name"] = "other";
+    EXPECT_FALSE(req.params.raw().has_value());
+}
+
+TEST(CodecParse, ResultStaysRawUntilAccessed) {
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":"r","result":{"tools":[1,2,3]}})");
+    auto& resp = std::get<JsonRpcResponse>(msg);
+    EXPECT_TRUE(resp.result.is_raw());
+    EXPECT_EQ(resp.result->at("tools").size(), 3u);
+}
+
+TEST(CodecParse, ScalarResultMaterializes) {
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":1,"result":"done" })");
+    EXPECT_EQ(*std::get<JsonRpcResponse>(msg).result, "done");
+    EXPECT_EQ(Codec::parse_value("-5"), -5);
+    EXPECT_EQ(Codec::parse_value("null"), nullptr);
+}
+
+TEST(CodecParse, MalformedParamsSurfaceOnAccess) {
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"x","params":{"a":tru}})");
+    auto& req = std::get<JsonRpcRequest>(msg);
+    EXPECT_THROW((void)req.params->at("a"), McpParseError);
+    EXPECT_THROW(Codec::parse_dom(R"({"jsonrpc":"2.0","id":1,"method":"x","params":{"a":tru}})"),
+                 McpParseError);
+}
+
+TEST(CodecParse, MatchesDomPath) {
+    const std::string raw = R"({"jsonrpc":"2.0","id":7,"method":"tools/call","params":{"name":"n","arguments":{"list":[1,2.5,"s",null,true]}},"_meta":{"k":1}})";
+    auto lazy = Codec::parse(raw);
+    auto dom = Codec::parse_dom(raw);
+    EXPECT_EQ(lazy, dom);
+    EXPECT_EQ(std::get<JsonRpcRequest>(lazy).meta->at("k"), 1);
+}
+
+TEST(CodecParse, RejectsTrailingContent) {
+    EXPECT_THROW(Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"ping"} {})"), McpParseError);
+}
+
+TEST(CodecParse, PaddedInputIgnoresBytesPastTheEnd) {
+    // Two frames back to back: parsing the first in place must not see the second
+    std::string buf = R"({"jsonrpc":"2.0","id":7,"method":"ping"})";
+    size_t len = buf.size();
+    buf += "\n{\"jsonrpc\":\"2.0\",\"method\":\"next\"}";
+    buf.append(Codec::kParsePadding, '\0');
+
+    auto msg = Codec::parse_padded(std::string_view(buf.data(), len));
+    EXPECT_EQ(std::get<JsonRpcRequest>(msg).method, "ping");
+    EXPECT_THROW(Codec::parse_padded(std::string_view(buf.data(), len - 1)), McpParseError);
+}
+
+TEST(CodecParse, RejectsNonScalarId) {
+    EXPECT_THROW(Codec::parse(R"({"jsonrpc":"2.0","id":{"a":1},"method":"ping"})"), McpParseError);
+}
+
+TEST(CodecParse, NonStringJsonrpcIsParseError) {
+    EXPECT_THROW(Codec::parse(R"({"jsonrpc":2,"id":1,"method":"ping"})"), McpParseError);
+}
+
+TEST(CodecRawMember, FindsMembersWithoutParsingThem) {
+    const std::string obj = R"({"name":"fwd","arguments":{"x":[1, 2]},"other":1})";
+    auto args = Codec::find_raw_member(obj, "arguments");
+    ASSERT_TRUE(args.has_value());
+    EXPECT_EQ(*args, R"({"x":[1, 2]})");
+    // The view points into the caller's buffer
+    EXPECT_GE(args->data(), obj.data());
+    EXPECT_LT(args->data(), obj.data() + obj.size());
+
+    auto fields = Codec::find_raw_members(obj, {"name", "missing", "other"});
+    ASSERT_EQ(fields.size(), 3u);
+    EXPECT_EQ(Codec::parse_value(*fields[0]), "fwd");
+    EXPECT_FALSE(fields[1].has_value());
+    EXPECT_EQ(Codec::parse_value(*fields[2]), 1);
+
+    EXPECT_THROW((void)Codec::find_raw_member("[1]", "a"), McpParseError);
+}
+
+TEST(CodecSerialize, RawPayloadCopiedVerbatim) {
+    JsonRpcResponse resp;
+    resp.id = RequestId{std::string("a\"b")};
+    resp.result = LazyJson::from_raw(R"({"z":1,"a":[true]})");
+    EXPECT_EQ(Codec::serialize(resp), R"({"jsonrpc":"2.0","id":"a\"b","result":{"z":1,"a":[true]}})");
+}
+
+TEST(CodecSerialize, SharedRawPayloadIsNotCopied) {
+    auto text = std::make_shared<const std::string>(R"({"cached":true})");
+    JsonRpcResponse resp;
+    resp.id = RequestId{int64_t{1}};
+    resp.result = LazyJson::from_raw(text);
+    ASSERT_TRUE(resp.result.raw());
+    EXPECT_EQ(resp.result.raw()->data(), text->data());
+    EXPECT_EQ(Codec::serialize(resp), R"({"jsonrpc":"2.0","id":1,"result":{"cached":true}})");
+    EXPECT_EQ(resp.result->at("cached"), true);
+}
+
 // ---- Batch parse tests ----
 
 TEST(CodecParseBatch, ValidBatch) {
@@ -157,6 +266,22 @@ TEST(CodecSerialize, BatchRoundTrip) {
     ASSERT_EQ(parsed.size(), 2u);
 }
 
+TEST(CodecSerialize, StreamedResultIsDrainedInPlace) {
+    JsonRpcResponse resp;
+    resp.id = RequestId{int64_t{7}};
+    int calls = 0;
+    resp.result_stream = [&calls](std::string& out) {
+        out += ++calls == 1 ? "{\"parts\":[1" : calls == 2 ? ",2" : "]}";
+        return calls < 3;
+    };
+    std::string out = Codec::serialize(resp);
+    EXPECT_EQ(out, R"({"jsonrpc":"2.0","id":7,"result":{"parts":[1,2]}})");
+
+    std::string head;
+    Codec::serialize_result_head(head, resp.id);
+    EXPECT_EQ(head, R"({"jsonrpc":"2.0","id":7,"result":)");
+}
+
 // ---- Large message test ----
 
 TEST(CodecParse, LargeMessage) {
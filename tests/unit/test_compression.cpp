@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "mcp/transport/compression.hpp"
+#include "mcp/error.hpp"
+#include <string>
+#include <vector>
+
+using namespace mcp;
+
+namespace {
+
+// Schema-like JSON, which is what gets compressed in practice
+std::string sample_json(size_t n) {
+    std::string out = "[";
+    for (size_t i = 0; i < n; ++i) {
+        if (i) out += ',';
+        out += R"({"name":"tool_)" + std::to_string(i)
+               + R"(","inputSchema":{"type":"object","properties":{"path":{"type":"string"}}}})";
+    }
+    return out + "]";
+}
+
+std::vector<ContentCoding> available_codings() {
+    std::vector<ContentCoding> out;
+    for (auto coding : {ContentCoding::Gzip, ContentCoding::Zstd}) {
+        if (coding_available(coding)) out.push_back(coding);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(Compression, NamesCodings) {
+    EXPECT_EQ(to_string(ContentCoding::Zstd), "zstd");
+    EXPECT_EQ(parse_content_coding(" GZip"), ContentCoding::Gzip);
+    EXPECT_EQ(parse_content_coding("x-gzip"), ContentCoding::Gzip);
+    EXPECT_EQ(parse_content_coding("identity"), ContentCoding::Identity);
+    EXPECT_FALSE(parse_content_coding("br"));
+    EXPECT_TRUE(coding_available(ContentCoding::Identity));
+}
+
+TEST(Compression, NegotiatesFromAcceptEncoding) {
+    if (!coding_available(ContentCoding::Gzip) || !coding_available(ContentCoding::Zstd)) {
+        GTEST_SKIP() << "needs both gzip and zstd";
+    }
+    const std::vector<ContentCoding> preferred{ContentCoding::Zstd, ContentCoding::Gzip};
+    EXPECT_EQ(negotiate_coding("gzip, deflate, br", preferred), ContentCoding::Gzip);
+    EXPECT_EQ(negotiate_coding("gzip;q=0.5, zstd", preferred), ContentCoding::Zstd);
+    EXPECT_EQ(negotiate_coding("zstd;q=0, gzip;q=0.1", preferred), ContentCoding::Gzip);
+    EXPECT_EQ(negotiate_coding("*", preferred), ContentCoding::Zstd);
+    EXPECT_EQ(negotiate_coding("*, zstd;q=0.000", preferred), ContentCoding::Gzip);
+    EXPECT_EQ(negotiate_coding("br", preferred), ContentCoding::Identity);
+    EXPECT_EQ(negotiate_coding("", preferred), ContentCoding::Identity);
+    EXPECT_EQ(negotiate_coding("gzip", {}), ContentCoding::Identity);
+    EXPECT_EQ(accept_encoding_value(preferred), "zstd, gzip");
+}
+
+TEST(Compression, BodiesRoundTrip) {
+    const std::string body = sample_json(200);
+    for (auto coding : available_codings()) {
+        std::string packed = compress(body, coding);
+        EXPECT_LT(packed.size() * 5, body.size()) << to_string(coding);
+        auto unpacked = decompress(packed, coding, SIZE_MAX);
+        ASSERT_TRUE(unpacked);
+        EXPECT_EQ(*unpacked, body);
+
+        // Past the limit nothing is returned
+        EXPECT_FALSE(decompress(packed, coding, body.size() - 1));
+        EXPECT_THROW((void)decompress(body, coding, SIZE_MAX), McpParseError);
+    }
+    EXPECT_EQ(compress("plain", ContentCoding::Identity), "plain");
+}
+
+TEST(Compression, EveryWriteOfAStreamDecodesOnArrival) {
+    for (auto coding : available_codings()) {
+        StreamCompressor compressor(coding);
+        StreamDecompressor decompressor(coding);
+        for (int i = 0; i < 50; ++i) {
+            std::string event = "data: " + sample_json(static_cast<size_t>(i % 7)) + "\n\n";
+            std::string packed, plain;
+            compressor.write(event, packed);
+            ASSERT_FALSE(packed.empty());
+            // The bytes of one write are enough to decode it, even split up
+            size_t half = packed.size() / 2;
+            decompressor.write(std::string_view(packed).substr(0, half), plain);
+            decompressor.write(std::string_view(packed).substr(half), plain);
+            EXPECT_EQ(plain, event) << to_string(coding) << " event " << i;
+        }
+        std::string tail, plain;
+        compressor.finish(tail);
+        decompressor.write(tail, plain);
+        EXPECT_TRUE(plain.empty());
+    }
+}
+
+TEST(Compression, UnavailableCodingsAreRefused) {
+    EXPECT_THROW(StreamCompressor(ContentCoding::Identity), std::invalid_argument);
+    for (auto coding : {ContentCoding::Gzip, ContentCoding::Zstd}) {
+        if (!coding_available(coding)) {
+            EXPECT_THROW(StreamDecompressor{coding}, std::invalid_argument);
+        }
+    }
+}
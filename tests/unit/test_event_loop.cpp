@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include "mcp/event_loop.hpp"
+#include "mcp/transport/event_loop_transport.hpp"
+#include "mcp/client.hpp"
+#include "mcp/server.hpp"
+#include "mcp/error.hpp"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Both ends of a connection: transport `a` talks to transport `b`
+struct PipePair {
+    int a_read, a_write, b_read, b_write;
+    PipePair() {
+        int ab[2], ba[2];
+        EXPECT_EQ(pipe(ab), 0);
+        EXPECT_EQ(pipe(ba), 0);
+        a_read = ba[0];
+        b_write = ba[1];
+        b_read = ab[0];
+        a_write = ab[1];
+    }
+};
+
+JsonRpcNotification note(const std::string& method, nlohmann::json params = nullptr) {
+    JsonRpcNotification n;
+    n.method = method;
+    if (!params.is_null()) n.params = std::move(params);
+    return n;
+}
+
+// Collects messages and waits for a count of them
+struct Inbox {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<JsonRpcMessage> messages;
+
+    MessageCallback callback() {
+        return [this](JsonRpcMessage msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(std::move(msg));
+            cv.notify_all();
+        };
+    }
+    bool wait_for(size_t n, std::chrono::milliseconds timeout = 5s) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [&] { return messages.size() >= n; });
+    }
+};
+
+} // namespace
+
+TEST(EventLoop, RunsHandlersAndTasksOnItsThread) {
+    EventLoop loop;
+    auto& poller = loop.next();
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::promise<bool> fired;
+    poller.watch(fds[0], EPOLLIN, [&, once = std::make_shared<std::once_flag>()](uint32_t events) {
+        char c;
+        (void)::read(fds[0], &c, 1);
+        std::call_once(*once, [&] { fired.set_value(poller.on_thread() && (events & EPOLLIN)); });
+    });
+    ASSERT_EQ(::write(fds[1], "x", 1), 1);
+    EXPECT_TRUE(fired.get_future().get());
+
+    std::promise<bool> ran;
+    poller.post([&] { ran.set_value(poller.on_thread()); });
+    EXPECT_TRUE(ran.get_future().get());
+    EXPECT_FALSE(poller.on_thread());
+
+    poller.unwatch(fds[0]);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(EventLoop, UnwatchWaitsForARunningHandler) {
+    EventLoop loop;
+    auto& poller = loop.next();
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::atomic<bool> inside{false};
+    std::atomic<bool> finished{false};
+    std::atomic<int> calls{0};
+    poller.watch(fds[0], EPOLLIN, [&](uint32_t) {
+        ++calls;
+        inside = true;
+        std::this_thread::sleep_for(50ms);
+        finished = true;
+    });
+    ASSERT_EQ(::write(fds[1], "x", 1), 1);
+    while (!inside) std::this_thread::yield();
+    poller.unwatch(fds[0]);
+    EXPECT_TRUE(finished);
+
+    // Still readable, but no longer watched
+    int seen = calls;
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(calls, seen);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(EventLoopTransport, ManyConnectionsShareTwoThreads) {
+    auto loop = std::make_shared<EventLoop>(EventLoop::Options{2});
+    constexpr int kConnections = 64;
+    constexpr int kMessages = 20;
+
+    std::vector<std::unique_ptr<EventLoopTransport>> clients, servers;
+    std::vector<std::unique_ptr<Inbox>> inboxes;
+    for (int i = 0; i < kConnections; ++i) {
+        PipePair p;
+        clients.push_back(std::make_unique<EventLoopTransport>(loop, p.a_read, p.a_write));
+        servers.push_back(std::make_unique<EventLoopTransport>(loop, p.b_read, p.b_write));
+        inboxes.push_back(std::make_unique<Inbox>());
+        // The server end echoes every notification back from its handler
+        auto* server = servers.back().get();
+        ASSERT_TRUE(server->start_detached([server](JsonRpcMessage msg) { server->send(msg); },
+                                           nullptr, nullptr));
+        ASSERT_TRUE(clients.back()->start_detached(inboxes.back()->callback(), nullptr, nullptr));
+    }
+
+    for (int m = 0; m < kMessages; ++m) {
+        for (int i = 0; i < kConnections; ++i) {
+            clients[i]->send(note("test/echo", {{"conn", i}, {"seq", m}}));
+        }
+    }
+    for (int i = 0; i < kConnections; ++i) {
+        ASSERT_TRUE(inboxes[i]->wait_for(kMessages)) << "connection " << i;
+        for (int m = 0; m < kMessages; ++m) {
+            const auto& params = *std::get<JsonRpcNotification>(inboxes[i]->messages[m]).params;
+            EXPECT_EQ(params["conn"], i);
+            EXPECT_EQ(params["seq"], m);  // per-connection order is kept
+        }
+    }
+}
+
+TEST(EventLoopTransport, QueuesWhatThePipeWontTakeAndFlushesLater) {
+    auto loop = std::make_shared<EventLoop>();
+    PipePair p;
+    EventLoopTransport sender(loop, p.a_read, p.a_write);
+    EventLoopTransport receiver(loop, p.b_read, p.b_write);
+    ASSERT_TRUE(sender.start_detached([](JsonRpcMessage) {}, nullptr, nullptr));
+
+    // Far past the 64 KiB pipe buffer with nobody reading yet
+    std::string big(256 * 1024, 'x');
+    for (int i = 0; i < 8; ++i) sender.send(note("test/big", {{"data", big}, {"seq", i}}));
+    auto queued = sender.stats();
+    EXPECT_GT(queued.queued_messages, 0u);
+    EXPECT_LT(queued.messages_written, 8u);
+
+    Inbox inbox;
+    ASSERT_TRUE(receiver.start_detached(inbox.callback(), nullptr, nullptr));
+    ASSERT_TRUE(inbox.wait_for(8, 10s));
+    for (int i = 0; i < 8; ++i) {
+        const auto& params = *std::get<JsonRpcNotification>(inbox.messages[i]).params;
+        EXPECT_EQ(params["seq"], i);
+        EXPECT_EQ(params["data"].get_ref<const std::string&>().size(), big.size());
+    }
+    auto drained = sender.stats();
+    EXPECT_EQ(drained.queued_messages, 0u);
+    EXPECT_EQ(drained.queued_bytes, 0u);
+    EXPECT_EQ(drained.messages_written, 8u);
+}
+
+TEST(EventLoopTransport, DropOldestShedsQueuedNotifications) {
+    auto loop = std::make_shared<EventLoop>();
+    PipePair p;
+    EventLoopTransport::Options opts;
+    opts.outbound_limits.max_messages = 4;
+    opts.outbound_limits.policy = OverflowPolicy::DropOldest;
+    EventLoopTransport sender(loop, p.a_read, p.a_write, opts);
+    ASSERT_TRUE(sender.start_detached([](JsonRpcMessage) {}, nullptr, nullptr));
+
+    std::string big(128 * 1024, 'x');
+    for (int i = 0; i < 20; ++i) sender.send(note("test/big", {{"data", big}}));
+    auto stats = sender.stats();
+    EXPECT_LE(stats.queued_messages, 4u);
+    EXPECT_GT(stats.dropped_messages, 0u);
+    ::close(p.b_read);
+    ::close(p.b_write);
+}
+
+TEST(EventLoopTransport, InputEndRunsOnClosedOnce) {
+    auto loop = std::make_shared<EventLoop>();
+    PipePair p;
+    auto transport = std::make_unique<EventLoopTransport>(loop, p.a_read, p.a_write);
+    std::atomic<int> closed{0};
+    ASSERT_TRUE(transport->start_detached([](JsonRpcMessage) {}, nullptr, [&] { ++closed; }));
+    EXPECT_TRUE(transport->is_connected());
+
+    ::close(p.b_write);  // the peer's output ends
+    for (int i = 0; i < 500 && closed == 0; ++i) std::this_thread::sleep_for(2ms);
+    EXPECT_EQ(closed, 1);
+    EXPECT_FALSE(transport->is_connected());
+
+    transport->shutdown();
+    transport.reset();
+    EXPECT_EQ(closed, 1);
+    ::close(p.b_read);
+}
+
+TEST(EventLoopTransport, StartReturnsOnShutdownAndSendThrowsAfter) {
+    auto loop = std::make_shared<EventLoop>();
+    PipePair p;
+    EventLoopTransport transport(loop, p.a_read, p.a_write);
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(20ms);
+        transport.shutdown();
+    });
+    transport.start([](JsonRpcMessage) {});
+    stopper.join();
+    EXPECT_THROW(transport.send(note("x")), McpTransportError);
+    ::close(p.b_read);
+    ::close(p.b_write);
+}
+
+TEST(EventLoopTransport, WorksOverOneSocket) {
+    auto loop = std::make_shared<EventLoop>();
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    EventLoopTransport a(loop, sv[0], sv[0]);
+    EventLoopTransport b(loop, sv[1], sv[1]);
+    Inbox inbox;
+    ASSERT_TRUE(a.start_detached(inbox.callback(), nullptr, nullptr));
+    ASSERT_TRUE(b.start_detached([&](JsonRpcMessage msg) { b.send(msg); }, nullptr, nullptr));
+
+    a.send_batch({note("one"), note("two")});
+    ASSERT_TRUE(inbox.wait_for(2));
+    EXPECT_EQ(std::get<JsonRpcNotification>(inbox.messages[1]).method, "two");
+}
+
+TEST(EventLoopTransport, ClientsOnASharedLoopNeedNoThreads) {
+    auto loop = std::make_shared<EventLoop>();
+    constexpr int kClients = 8;
+
+    std::vector<std::unique_ptr<McpServer>> servers;
+    std::vector<std::thread> server_threads;
+    std::vector<std::unique_ptr<McpClient>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        PipePair p;
+        McpServer::Options sopts;
+        sopts.server_info = {"loop-server", std::nullopt, "1.0"};
+        servers.push_back(std::make_unique<McpServer>(sopts));
+        ToolDefinition def;
+        def.name = "id";
+        def.input_schema = nlohmann::json{{"type", "object"}};
+        servers.back()->add_tool(def, [i](const nlohmann::json&) -> CallToolResult {
+            CallToolResult result;
+            result.content.push_back(TextContent{std::to_string(i), std::nullopt});
+            return result;
+        });
+        auto server_transport = std::make_unique<EventLoopTransport>(loop, p.b_read, p.b_write);
+        server_threads.emplace_back([s = servers.back().get(), t = std::move(server_transport)]() mutable {
+            s->serve(std::move(t));
+        });
+
+        McpClient::Options copts;
+        copts.client_info = {"loop-client", std::nullopt, "1.0"};
+        copts.request_timeout = 5000ms;
+        copts.event_loop = loop;
+        clients.push_back(std::make_unique<McpClient>(copts));
+        clients.back()->connect(std::make_unique<EventLoopTransport>(loop, p.a_read, p.a_write));
+    }
+
+    for (int i = 0; i < kClients; ++i) {
+        (void)clients[i]->initialize();
+        auto result = clients[i]->call_tool("id");
+        ASSERT_EQ(result.content.size(), 1u);
+        EXPECT_EQ(std::get<TextContent>(result.content[0]).text, std::to_string(i));
+    }
+
+    for (auto& client : clients) client->disconnect();
+    for (auto& server : servers) server->shutdown();
+    for (auto& t : server_threads) t.join();
+}
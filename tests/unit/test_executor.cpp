@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "mcp/executor.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <thread>
+
+using namespace mcp;
+
+TEST(Task, SmallCallableStoredInline) {
+    int calls = 0;
+    Task task([&calls] { ++calls; });
+    EXPECT_TRUE(task.is_inline());
+    task();
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Task, LargeCallableFallsBackToHeap) {
+    std::array<char, 256> big{};
+    big[0] = 'x';
+    char seen = 0;
+    Task task([big, &seen] { seen = big[0]; });
+    EXPECT_FALSE(task.is_inline());
+    task();
+    EXPECT_EQ(seen, 'x');
+}
+
+TEST(Task, MoveOnlyCapture) {
+    auto value = std::make_unique<int>(42);
+    int seen = 0;
+    Task task([v = std::move(value), &seen] { seen = *v; });
+    Task moved = std::move(task);
+    EXPECT_FALSE(static_cast<bool>(task));
+    moved();
+    EXPECT_EQ(seen, 42);
+}
+
+TEST(Task, DestroysCapturedState) {
+    auto shared = std::make_shared<int>(1);
+    {
+        Task task([shared] {});
+        EXPECT_EQ(shared.use_count(), 2);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(WorkStealingExecutor, RunsAllTasks) {
+    std::atomic<int> count{0};
+    {
+        WorkStealingExecutor::Options opts;
+        opts.num_threads = 4;
+        WorkStealingExecutor exec(opts);
+        EXPECT_EQ(exec.concurrency(), 4u);
+        for (int i = 0; i < 10000; ++i) {
+            exec.post([&count] { count.fetch_add(1); });
+        }
+        exec.shutdown();
+    }
+    EXPECT_EQ(count.load(), 10000);
+}
+
+TEST(WorkStealingExecutor, NestedPostFromWorker) {
+    std::atomic<int> count{0};
+    WorkStealingExecutor::Options opts;
+    opts.num_threads = 2;
+    WorkStealingExecutor exec(opts);
+    for (int i = 0; i < 100; ++i) {
+        exec.post([&exec, &count] {
+            for (int j = 0; j < 10; ++j) {
+                exec.post([&count] { count.fetch_add(1); });
+            }
+        });
+    }
+    exec.shutdown();
+    EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(WorkStealingExecutor, IdleWorkersStealFromBusyOnes) {
+    WorkStealingExecutor::Options opts;
+    opts.num_threads = 4;
+    WorkStealingExecutor exec(opts);
+
+    // One task fans out onto its own worker's deque; the others must steal.
+    std::mutex ids_mutex;
+    std::set<std::thread::id> ids;
+    std::atomic<int> done{0};
+    exec.post([&] {
+        for (int i = 0; i < 64; ++i) {
+            exec.post([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::lock_guard<std::mutex> lock(ids_mutex);
+                ids.insert(std::this_thread::get_id());
+                done.fetch_add(1);
+            });
+        }
+    });
+    exec.shutdown();
+    EXPECT_EQ(done.load(), 64);
+    EXPECT_GT(ids.size(), 1u);
+}
+
+TEST(WorkStealingExecutor, ThrowingTaskDoesNotKillWorker) {
+    std::atomic<int> count{0};
+    WorkStealingExecutor::Options opts;
+    opts.num_threads = 1;
+    WorkStealingExecutor exec(opts);
+    exec.post([] { throw std::runtime_error("boom"); });
+    exec.post([&count] { count.fetch_add(1); });
+    exec.shutdown();
+    EXPECT_EQ(count.load(), 1);
+}
+
+TEST(WorkStealingExecutor, PostAfterShutdownRunsInline) {
+    WorkStealingExecutor::Options opts;
+    opts.num_threads = 1;
+    WorkStealingExecutor exec(opts);
+    exec.shutdown();
+    bool ran = false;
+    exec.post([&ran] { ran = true; });
+    EXPECT_TRUE(ran);
+}
+
+TEST(WorkStealingExecutor, PinnedThreads) {
+    std::atomic<int> count{0};
+    WorkStealingExecutor::Options opts;
+    opts.num_threads = 2;
+    opts.pin_threads = true;
+    WorkStealingExecutor exec(opts);
+    for (int i = 0; i < 100; ++i) exec.post([&count] { count.fetch_add(1); });
+    exec.shutdown();
+    EXPECT_EQ(count.load(), 100);
+}
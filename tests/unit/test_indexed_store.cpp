@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "mcp/indexed_store.hpp"
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mcp;
+
+using Store = IndexedStore<std::string, int>;
+
+// Every definition in order, following cursors page by page
+static std::vector<std::string> list_all(const Store& s, size_t page_size) {
+    std::vector<std::string> out;
+    std::optional<uint64_t> cursor;
+    do {
+        cursor = s.page(cursor, page_size, [&](const std::string& def) { out.push_back(def); });
+    } while (cursor);
+    return out;
+}
+
+TEST(IndexedStore, PutFindErase) {
+    Store s;
+    s.put("a", "def a", 1);
+    s.put("b", "def b", 2);
+    EXPECT_EQ(s.size(), 2u);
+    ASSERT_NE(s.find("a"), nullptr);
+    EXPECT_EQ(*s.find("a"), 1);
+    EXPECT_EQ(s.find("c"), nullptr);
+
+    EXPECT_TRUE(s.erase("a"));
+    EXPECT_FALSE(s.erase("a"));
+    EXPECT_EQ(s.find("a"), nullptr);
+    EXPECT_EQ(s.size(), 1u);
+}
+
+TEST(IndexedStore, ReplaceKeepsPosition) {
+    Store s;
+    s.put("a", "a1", 1);
+    s.put("b", "b1", 2);
+    s.put("c", "c1", 3);
+    s.put("a", "a2", 10);
+    EXPECT_EQ(s.size(), 3u);
+    EXPECT_EQ(*s.find("a"), 10);
+    EXPECT_EQ(list_all(s, 10), (std::vector<std::string>{"a2", "b1", "c1"}));
+}
+
+TEST(IndexedStore, CursorSurvivesRemovals) {
+    Store s;
+    for (int i = 0; i < 10; ++i) s.put("k" + std::to_string(i), std::to_string(i), i);
+
+    std::vector<std::string> first;
+    auto cursor = s.page(std::nullopt, 4, [&](const std::string& d) { first.push_back(d); });
+    ASSERT_TRUE(cursor.has_value());
+    EXPECT_EQ(first, (std::vector<std::string>{"0", "1", "2", "3"}));
+
+    // Removing entries already listed, and the one the cursor names, must
+    // neither skip nor repeat anything
+    s.erase("k0");
+    s.erase("k3");
+    s.erase("k5");
+    s.put("k10", "10", 10);
+
+    std::vector<std::string> rest;
+    while (cursor) {
+        cursor = s.page(cursor, 4, [&](const std::string& d) { rest.push_back(d); });
+    }
+    EXPECT_EQ(rest, (std::vector<std::string>{"4", "6", "7", "8", "9", "10"}));
+}
+
+TEST(IndexedStore, LastFullPageHasNoCursor) {
+    Store s;
+    for (int i = 0; i < 4; ++i) s.put(std::to_string(i), std::to_string(i), i);
+    EXPECT_FALSE(s.page(std::nullopt, 4, [](const std::string&) {}).has_value());
+    EXPECT_TRUE(s.page(std::nullopt, 3, [](const std::string&) {}).has_value());
+    EXPECT_FALSE(Store{}.page(std::nullopt, 4, [](const std::string&) {}).has_value());
+}
+
+TEST(IndexedStore, CopiesAreIndependent) {
+    Store a;
+    a.put("x", "x", 1);
+    Store b = a;
+    b.put("y", "y", 2);
+    b.erase("x");
+    EXPECT_EQ(a.size(), 1u);
+    EXPECT_NE(a.find("x"), nullptr);
+    EXPECT_EQ(a.find("y"), nullptr);
+    EXPECT_EQ(list_all(b, 10), (std::vector<std::string>{"y"}));
+}
+
+TEST(IndexedStore, MatchesReferenceUnderRandomOps) {
+    Store s;
+    std::map<std::string, int> ref;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; ++i) {
+        std::string key = "r" + std::to_string(rng() % 2000);
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(s.erase(key), ref.erase(key) > 0);
+        } else {
+            s.put(key, key, i);
+            ref[key] = i;
+        }
+    }
+    ASSERT_EQ(s.size(), ref.size());
+    for (auto& [key, value] : ref) {
+        ASSERT_NE(s.find(key), nullptr) << key;
+        EXPECT_EQ(*s.find(key), value);
+    }
+    size_t handlers = 0;
+    s.for_each_handler([&](const std::string& key, const auto& h) {
+        EXPECT_EQ(*h, ref.at(key));
+        ++handlers;
+        return true;
+    });
+    EXPECT_EQ(handlers, ref.size());
+    EXPECT_EQ(list_all(s, 37).size(), ref.size());
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "mcp/json_writer.hpp"
+#include "mcp/types.hpp"
+#include <limits>
+#include <nlohmann/json.hpp>
+
+using namespace mcp;
+
+namespace {
+
+std::string write(const nlohmann::json& j) {
+    std::string out;
+    JsonWriter(out).value(j);
+    return out;
+}
+
+template<typename T>
+nlohmann::json streamed(const T& value) {
+    std::string out;
+    JsonWriter w(out);
+    write_json(w, value);
+    return nlohmann::json::parse(out);
+}
+
+template<typename T>
+nlohmann::json built(const T& value) {
+    nlohmann::json j;
+    to_json(j, value);
+    return j;
+}
+
+} // namespace
+
+TEST(JsonWriter, ObjectsAndArrays) {
+    std::string out;
+    JsonWriter w(out);
+    w.begin_object();
+    w.field("a", 1);
+    w.key("b").begin_array().value(true).null().value("x").end_array();
+    w.key("c").begin_object().end_object();
+    w.key("d").begin_array().end_array();
+    w.end_object();
+    EXPECT_EQ(out, R"({"a":1,"b":[true,null,"x"],"c":{},"d":[]})");
+}
+
+TEST(JsonWriter, AppendsToExistingBuffer) {
+    std::string out = "data: ";
+    JsonWriter(out).begin_object().field("k", "v").end_object();
+    EXPECT_EQ(out, R"(data: {"k":"v"})");
+}
+
+TEST(JsonWriter, EscapesLikeNlohmann) {
+    std::string s = "quote\" back\\ nl\n tab\t cr\r bs\b ff\f ctl\x01\x1f utf8 \xc3\xa9 /";
+    std::string out;
+    JsonWriter(out).value(s);
+    EXPECT_EQ(out, nlohmann::json(s).dump());
+}
+
+TEST(JsonWriter, Integers) {
+    EXPECT_EQ(write(nlohmann::json(std::numeric_limits<int64_t>::min())), "-9223372036854775808");
+    EXPECT_EQ(write(nlohmann::json(std::numeric_limits<uint64_t>::max())), "18446744073709551615");
+
+    std::string out;
+    JsonWriter(out).begin_array().value(size_t{7}).value(-3).end_array();
+    EXPECT_EQ(out, "[7,-3]");
+}
+
+TEST(JsonWriter, DoublesRoundTrip) {
+    for (double d : {0.1, -2.5, 1e300, 5e-324, 3.0, 0.0, 12345678.0}) {
+        std::string out;
+        JsonWriter(out).value(d);
+        auto back = nlohmann::json::parse(out);
+        ASSERT_TRUE(back.is_number_float()) << out;
+        EXPECT_EQ(back.get<double>(), d) << out;
+    }
+}
+
+TEST(JsonWriter, NonFiniteDoublesAreNull) {
+    std::string out;
+    JsonWriter(out).begin_array()
+        .value(std::numeric_limits<double>::quiet_NaN())
+        .value(std::numeric_limits<double>::infinity())
+        .end_array();
+    EXPECT_EQ(out, "[null,null]");
+}
+
+TEST(JsonWriter, DomMatchesDump) {
+    auto j = nlohmann::json::parse(
+        R"({"s":"t\"x","n":-1,"u":3,"f":1.5,"b":false,"z":null,"a":[1,{"k":[]}],"o":{}})");
+    EXPECT_EQ(write(j), j.dump());
+}
+
+TEST(JsonWriter, RawIsSplicedVerbatim) {
+    std::string out;
+    JsonWriter(out).begin_object().key("r").raw(R"({"pre": 1})").field("n", 2).end_object();
+    EXPECT_EQ(out, R"({"r":{"pre": 1},"n":2})");
+}
+
+// ---- write_json matches to_json ----
+
+TEST(JsonWriterTypes, CallToolResult) {
+    CallToolResult r;
+    r.content.push_back(TextContent{"hi", Annotations{std::vector<std::string>{"user"}, 0.5, "2025-01-01"}});
+    r.content.push_back(ImageContent{"aGk=", "image/png", std::nullopt});
+    r.content.push_back(AudioContent{"aGk=", "audio/wav", std::nullopt});
+    ResourceLink link;
+    link.uri = "file:///a";
+    link.name = "a";
+    link.mime_type = "text/plain";
+    r.content.push_back(link);
+    EmbeddedResource er;
+    er.uri = "file:///b";
+    er.text = "body";
+    r.content.push_back(er);
+    r.structured_content = nlohmann::json{{"x", 1}};
+    r.is_error = true;
+    EXPECT_EQ(streamed(r), built(r));
+
+    CallToolResult ok;
+    EXPECT_EQ(streamed(ok), built(ok));
+}
+
+TEST(JsonWriterTypes, RawBytesAreEncodedWhenWritten) {
+    CallToolResult r;
+    r.content.push_back(ImageContent::from_bytes("hi", "image/png"));
+    r.content.push_back(AudioContent::from_bytes(std::string("\0\xff", 2), "audio/wav"));
+    r.content.push_back(EmbeddedResource::from_bytes("file:///b", "bin", "application/octet-stream"));
+    auto j = streamed(r);
+    EXPECT_EQ(j, built(r));
+    EXPECT_EQ(j["content"][0]["data"], "aGk=");
+    EXPECT_EQ(j["content"][1]["data"], "AP8=");
+    EXPECT_EQ(j["content"][2]["resource"]["blob"], "Ymlu");
+
+    // Equal to the same content given as base64, and decodes either way
+    EXPECT_EQ(std::get<ImageContent>(r.content[0]), (ImageContent{"aGk=", "image/png", std::nullopt}));
+    EXPECT_EQ((ImageContent{"aGk=", "image/png", std::nullopt}).decoded(), "hi");
+    auto contents = ResourceContent::from_bytes("file:///c", "bin");
+    EXPECT_EQ(contents.blob_base64(), "Ymlu");
+    EXPECT_EQ(streamed(contents)["blob"], "Ymlu");
+    EXPECT_EQ((ResourceContent{"file:///c", std::nullopt, std::nullopt, "Ymlu"}).decoded_blob(), "bin");
+}
+
+TEST(JsonWriterTypes, Definitions) {
+    ToolDefinition tool;
+    tool.name = "t";
+    tool.description = "d";
+    tool.input_schema = {{"type", "object"}};
+    tool.annotations = nlohmann::json{{"readOnlyHint", true}};
+    EXPECT_EQ(streamed(tool), built(tool));
+
+    ResourceDefinition res;
+    res.uri = "file:///r";
+    res.name = "r";
+    res.size = 42;
+    EXPECT_EQ(streamed(res), built(res));
+
+    ResourceTemplate tmpl;
+    tmpl.uri_template = "file:///{name}";
+    tmpl.name = "files";
+    tmpl.mime_type = "text/plain";
+    EXPECT_EQ(streamed(tmpl), built(tmpl));
+
+    PromptDefinition prompt;
+    prompt.name = "p";
+    prompt.title = "P";
+    prompt.arguments.push_back(PromptArgument{"arg", "desc", true});
+    EXPECT_EQ(streamed(prompt), built(prompt));
+}
+
+TEST(JsonWriterTypes, ReadAndPromptResults) {
+    ResourceContent rc;
+    rc.uri = "file:///r";
+    rc.blob = "AAEC";
+    rc.mime_type = "application/octet-stream";
+    EXPECT_EQ(streamed(rc), built(rc));
+
+    GetPromptResult gp;
+    gp.description = "desc";
+    gp.messages.push_back(PromptMessage{"user", TextContent{"hello", std::nullopt}});
+    EXPECT_EQ(streamed(gp), built(gp));
+}
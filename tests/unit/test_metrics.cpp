@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include "mcp/metrics.hpp"
+#include "mcp/codec.hpp"
+#include "mcp/error.hpp"
+#include "mcp/router.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+using namespace mcp;
+
+namespace {
+
+uint64_t calls_of(const MetricsSnapshot& s, std::string_view method) {
+    auto* m = s.find(method);
+    return m ? m->calls : 0;
+}
+
+uint64_t errors_of(const MetricsSnapshot& s, std::string_view method) {
+    auto* m = s.find(method);
+    return m ? m->errors : 0;
+}
+
+JsonRpcRequest request(int64_t id, std::string method) {
+    JsonRpcRequest req;
+    req.id = RequestId{id};
+    req.method = std::move(method);
+    return req;
+}
+
+} // namespace
+
+TEST(LatencyHistogram, BucketsAreContiguousAndWithinAnEighth) {
+    for (size_t i = 1; i < LatencyHistogram::kBuckets; ++i) {
+        uint64_t first = LatencyHistogram::bucket_limit(i - 1);
+        EXPECT_EQ(LatencyHistogram::bucket_of(first), i);
+        EXPECT_EQ(LatencyHistogram::bucket_of(first - 1), i - 1);
+        if (first >= 8) {
+            EXPECT_LE(LatencyHistogram::bucket_limit(i) - first, first / 8);
+        }
+    }
+    EXPECT_EQ(LatencyHistogram::bucket_of(uint64_t{1} << 50), LatencyHistogram::kBuckets - 1);
+}
+
+TEST(LatencyHistogram, PercentilesAndCounts) {
+    LatencyHistogram h;
+    EXPECT_EQ(h.percentile(0.5), 0u);
+    for (uint64_t v = 1; v <= 1000; ++v) h.record(v * 1000);  // 1 us .. 1 ms
+
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.sum_ns(), 500500u * 1000);
+    auto p50 = h.percentile(0.5);
+    EXPECT_GE(p50, 500'000u);
+    EXPECT_LE(p50, 500'000u + 500'000u / 8);
+    EXPECT_GE(h.percentile(1.0), 1'000'000u);
+    EXPECT_EQ(h.count_below(1u << 10), 1u);  // only 1000 ns is below 1024
+    EXPECT_EQ(h.count_below(1u << 11), 2u);
+
+    LatencyHistogram other;
+    other.record(5);
+    h.merge(other);
+    EXPECT_EQ(h.count(), 1001u);
+    EXPECT_EQ(h.percentile(0.0), 5u);
+}
+
+TEST(Metrics, CountsDispatchesByMethod) {
+    if (!metrics::kEnabled) GTEST_SKIP() << "built with MCPXX_METRICS=OFF";
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult { return nlohmann::json::object(); });
+    router.on_request("tools/call", [](const nlohmann::json&) -> HandlerResult {
+        throw McpProtocolError(error::InvalidParams, "bad");
+    });
+    router.on_request_async("custom/slow", [](const nlohmann::json&, Responder respond) {
+        std::thread([respond] { respond(nlohmann::json::object()); }).detach();
+    });
+    router.on_notification("notifications/initialized", [](const nlohmann::json&) {});
+
+    auto before = metrics::snapshot();
+    for (int i = 0; i < 3; ++i) (void)router.dispatch(request(i, "ping"));
+    (void)router.dispatch(request(10, "tools/call"));
+    (void)router.dispatch(request(11, "custom/slow"));
+    (void)router.dispatch(request(12, "no/such/method"));
+    JsonRpcNotification notif;
+    notif.method = "notifications/initialized";
+    (void)router.dispatch(notif);
+    auto after = metrics::snapshot();
+
+    EXPECT_EQ(calls_of(after, "ping") - calls_of(before, "ping"), 3u);
+    EXPECT_EQ(errors_of(after, "ping") - errors_of(before, "ping"), 0u);
+    EXPECT_EQ(calls_of(after, "tools/call") - calls_of(before, "tools/call"), 1u);
+    EXPECT_EQ(errors_of(after, "tools/call") - errors_of(before, "tools/call"), 1u);
+    // Custom methods share one bucket; the unknown one failed
+    EXPECT_EQ(calls_of(after, "other") - calls_of(before, "other"), 2u);
+    EXPECT_EQ(errors_of(after, "other") - errors_of(before, "other"), 1u);
+    EXPECT_EQ(calls_of(after, "notifications/initialized")
+              - calls_of(before, "notifications/initialized"), 1u);
+
+    auto* ping = after.find("ping");
+    ASSERT_NE(ping, nullptr);
+    EXPECT_LE(ping->latency.count(), ping->calls);
+}
+
+TEST(Metrics, LatencySamplingTimesOneDispatchInN) {
+    if (!metrics::kEnabled) GTEST_SKIP() << "built with MCPXX_METRICS=OFF";
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult { return nlohmann::json::object(); });
+    auto timed = [] {
+        auto* ping = metrics::snapshot().find("ping");
+        return ping ? ping->latency.count() : 0;
+    };
+
+    metrics::set_latency_sampling(1);
+    auto before = timed();
+    for (int i = 0; i < 16; ++i) (void)router.dispatch(request(i, "ping"));
+    EXPECT_EQ(timed() - before, 16u);
+
+    metrics::set_latency_sampling(4);
+    before = timed();
+    for (int i = 0; i < 16; ++i) (void)router.dispatch(request(i, "ping"));
+    EXPECT_EQ(timed() - before, 4u);
+    metrics::set_latency_sampling(8);
+}
+
+TEST(Metrics, CountsFromExitedThreadsAreKept) {
+    if (!metrics::kEnabled) GTEST_SKIP() << "built with MCPXX_METRICS=OFF";
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult { return nlohmann::json::object(); });
+
+    auto before = calls_of(metrics::snapshot(), "ping");
+    std::thread([&] {
+        for (int i = 0; i < 5; ++i) (void)router.dispatch(request(i, "ping"));
+    }).join();
+    EXPECT_EQ(calls_of(metrics::snapshot(), "ping") - before, 5u);
+}
+
+TEST(Metrics, CountsCodecTraffic) {
+    if (!metrics::kEnabled) GTEST_SKIP() << "built with MCPXX_METRICS=OFF";
+    const std::string text = R"({"jsonrpc":"2.0","id":1,"method":"ping"})";
+
+    auto before = metrics::snapshot();
+    auto msg = Codec::parse(text);
+    auto batch = Codec::parse_batch("[" + text + "," + text + "]");
+    EXPECT_THROW(Codec::parse("{not json"), McpParseError);
+    auto out = Codec::serialize(msg);
+    auto after = metrics::snapshot();
+
+    EXPECT_EQ(after.messages_parsed - before.messages_parsed, 3u);
+    EXPECT_EQ(after.bytes_parsed - before.bytes_parsed, text.size() * 3 + 3);
+    EXPECT_EQ(after.parse_errors - before.parse_errors, 1u);
+    EXPECT_EQ(after.messages_serialized - before.messages_serialized, 1u);
+    EXPECT_EQ(after.bytes_serialized - before.bytes_serialized, out.size());
+}
+
+TEST(Metrics, SpanHooksWrapEachDispatch) {
+    if (!metrics::kEnabled) GTEST_SKIP() << "built with MCPXX_METRICS=OFF";
+    struct Hooks : ISpanHooks {
+        std::atomic<int> started{0};
+        std::atomic<int> ended{0};
+        std::atomic<int> last_code{-1};
+        std::string method;
+        void* start_span(std::string_view m, const RequestId* id) override {
+            method = std::string(m);
+            EXPECT_NE(id, nullptr);
+            ++started;
+            return this;
+        }
+        void end_span(void* span, int code) noexcept override {
+            EXPECT_EQ(span, this);
+            last_code = code;
+            ++ended;
+        }
+    } hooks;
+
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult { return nlohmann::json::object(); });
+    metrics::set_span_hooks(&hooks);
+    (void)router.dispatch(request(1, "ping"));
+    EXPECT_EQ(hooks.method, "ping");
+    EXPECT_EQ(hooks.last_code, 0);
+    (void)router.dispatch(request(2, "missing"));
+    EXPECT_EQ(hooks.last_code, error::MethodNotFound);
+    metrics::set_span_hooks(nullptr);
+    (void)router.dispatch(request(3, "ping"));
+
+    EXPECT_EQ(hooks.started, 2);
+    EXPECT_EQ(hooks.ended, 2);
+}
+
+TEST(Metrics, GaugesAreSummedByNameWhileRegistered) {
+    auto value = [](const MetricsSnapshot& s, const std::string& name) -> std::optional<int64_t> {
+        for (const auto& [n, v] : s.gauges) {
+            if (n == name) return v;
+        }
+        return std::nullopt;
+    };
+    {
+        metrics::Gauge a("test_depth", [] { return int64_t{3}; });
+        metrics::Gauge b("test_depth", [] { return int64_t{4}; });
+        EXPECT_EQ(value(metrics::snapshot(), "test_depth"), 7);
+
+        metrics::Gauge moved = std::move(b);
+        EXPECT_EQ(value(metrics::snapshot(), "test_depth"), 7);
+    }
+    EXPECT_FALSE(value(metrics::snapshot(), "test_depth").has_value());
+}
+
+TEST(Metrics, PrometheusExposition) {
+    MetricsSnapshot s;
+    s.bytes_parsed = 42;
+    MethodStats ping;
+    ping.method = "ping";
+    ping.calls = 2;
+    ping.latency.record(500);
+    ping.latency.record(3000);
+    s.methods.push_back(ping);
+    s.gauges.emplace_back("test_queue_depth", 2);
+
+    auto text = s.to_prometheus();
+    EXPECT_NE(text.find("mcpxx_dispatch_total{method=\"ping\"} 2\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("mcpxx_dispatch_duration_seconds_bucket{method=\"ping\",le=\"1.024e-06\"} 1\n"),
+              std::string::npos) << text;
+    EXPECT_NE(text.find("mcpxx_dispatch_duration_seconds_bucket{method=\"ping\",le=\"+Inf\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("mcpxx_dispatch_duration_seconds_sum{method=\"ping\"} 3.5e-06\n"),
+              std::string::npos) << text;
+    EXPECT_NE(text.find("# TYPE mcpxx_bytes_parsed_total counter\nmcpxx_bytes_parsed_total 42\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_queue_depth gauge\ntest_queue_depth 2\n"), std::string::npos);
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "mcp/transport/replay_buffer.hpp"
+#include <string>
+
+using namespace mcp;
+
+TEST(ReplayBuffer, ReplaysEventsAfterAnId) {
+    ReplayBuffer buffer(8, 0);
+    for (uint64_t id = 1; id <= 5; ++id) buffer.push(id, "e" + std::to_string(id) + ";");
+    std::string out;
+    EXPECT_TRUE(buffer.replay_after(2, out));
+    EXPECT_EQ(out, "e3;e4;e5;");
+
+    out.clear();
+    EXPECT_TRUE(buffer.replay_after(5, out));
+    EXPECT_EQ(out, "");
+    EXPECT_TRUE(buffer.replay_after(0, out));
+    EXPECT_EQ(out, "e1;e2;e3;e4;e5;");
+}
+
+TEST(ReplayBuffer, EvictsOldestPastItsEventCount) {
+    ReplayBuffer buffer(3, 0);
+    for (uint64_t id = 1; id <= 10; ++id) buffer.push(id, std::to_string(id) + ";");
+    EXPECT_EQ(buffer.size(), 3u);
+    std::string out;
+    EXPECT_TRUE(buffer.replay_after(7, out));
+    EXPECT_EQ(out, "8;9;10;");
+
+    // Asking from before the oldest retained event reports the gap
+    out.clear();
+    EXPECT_FALSE(buffer.replay_after(3, out));
+    EXPECT_EQ(out, "8;9;10;");
+}
+
+TEST(ReplayBuffer, EvictsOldestPastItsByteBound) {
+    ReplayBuffer buffer(100, 10);
+    buffer.push(1, "aaaa");
+    buffer.push(2, "bbbb");
+    buffer.push(3, "cccc");
+    EXPECT_EQ(buffer.size(), 2u);
+    EXPECT_EQ(buffer.bytes(), 8u);
+
+    // An event bigger than the bound is not kept at all
+    buffer.push(4, std::string(11, 'x'));
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.bytes(), 0u);
+    std::string out;
+    EXPECT_FALSE(buffer.replay_after(3, out));
+    EXPECT_TRUE(buffer.replay_after(4, out));
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(ReplayBuffer, DisabledKeepsNothing) {
+    ReplayBuffer buffer;
+    EXPECT_FALSE(buffer.enabled());
+    buffer.push(1, "x");
+    EXPECT_EQ(buffer.size(), 0u);
+}
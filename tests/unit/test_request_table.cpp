@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "mcp/request_table.hpp"
+#include <map>
+#include <random>
+#include <string>
+
+using namespace mcp;
+
+TEST(RequestTable, InsertFindTake) {
+    RequestTable<std::string> t;
+    t.insert(RequestId{int64_t{1}}, "one");
+    t.insert(RequestId{std::string("1")}, "string one");
+    EXPECT_EQ(t.size(), 2u);
+
+    ASSERT_NE(t.find(RequestId{int64_t{1}}), nullptr);
+    EXPECT_EQ(*t.find(RequestId{int64_t{1}}), "one");
+    EXPECT_EQ(*t.find(RequestId{std::string("1")}), "string one");
+    EXPECT_EQ(t.find(RequestId{int64_t{2}}), nullptr);
+
+    auto taken = t.take(RequestId{int64_t{1}});
+    ASSERT_TRUE(taken.has_value());
+    EXPECT_EQ(*taken, "one");
+    EXPECT_FALSE(t.contains(RequestId{int64_t{1}}));
+    EXPECT_TRUE(t.contains(RequestId{std::string("1")}));
+    EXPECT_FALSE(t.take(RequestId{int64_t{1}}).has_value());
+}
+
+TEST(RequestTable, InsertReplacesExisting) {
+    RequestTable<int> t;
+    t.insert(RequestId{int64_t{7}}, 1);
+    t.insert(RequestId{int64_t{7}}, 2);
+    EXPECT_EQ(t.size(), 1u);
+    EXPECT_EQ(*t.find(RequestId{int64_t{7}}), 2);
+}
+
+TEST(RequestTable, MatchesMapUnderRandomChurn) {
+    // Backward-shift deletion must keep every probe run intact
+    RequestTable<int64_t> t(4);
+    std::map<int64_t, int64_t> model;
+    std::mt19937_64 rng(42);
+    for (int step = 0; step < 20000; ++step) {
+        int64_t key = static_cast<int64_t>(rng() % 512);
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(t.erase(RequestId{key}), model.erase(key) > 0);
+        } else {
+            t.insert(RequestId{key}, key * 10);
+            model[key] = key * 10;
+        }
+    }
+    EXPECT_EQ(t.size(), model.size());
+    for (int64_t key = 0; key < 512; ++key) {
+        auto* v = t.find(RequestId{key});
+        auto it = model.find(key);
+        ASSERT_EQ(v != nullptr, it != model.end()) << key;
+        if (v) {
+            EXPECT_EQ(*v, it->second);
+        }
+    }
+}
+
+TEST(RequestTable, EraseIfAndTakeAll) {
+    RequestTable<int64_t> t;
+    for (int64_t i = 0; i < 100; ++i) t.insert(RequestId{i}, i);
+    t.erase_if([](const RequestId&, int64_t v) { return v % 2 == 0; });
+    EXPECT_EQ(t.size(), 50u);
+    for (int64_t i = 0; i < 100; ++i) EXPECT_EQ(t.contains(RequestId{i}), i % 2 == 1);
+
+    auto all = t.take_all();
+    EXPECT_EQ(all.size(), 50u);
+    EXPECT_TRUE(t.empty());
+    EXPECT_FALSE(t.contains(RequestId{int64_t{1}}));
+}
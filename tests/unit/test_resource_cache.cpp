@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "mcp/resource_cache.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+static std::shared_ptr<const std::string> text(std::string s) {
+    return std::make_shared<const std::string>(std::move(s));
+}
+
+TEST(ResourceCache, DisabledByDefault) {
+    ResourceCache cache({});
+    EXPECT_FALSE(cache.enabled());
+    cache.put("a://x", text("body"), cache.stamp());
+    EXPECT_EQ(cache.get("a://x"), nullptr);
+}
+
+TEST(ResourceCache, HitAndInvalidate) {
+    ResourceCache cache({1024, 0ms});
+    cache.put("a://x", text("body"), cache.stamp());
+    auto hit = cache.get("a://x");
+    ASSERT_NE(hit, nullptr);
+    EXPECT_EQ(*hit, "body");
+    EXPECT_EQ(cache.bytes(), std::string("a://x").size() + 4);
+
+    cache.invalidate("a://x");
+    EXPECT_EQ(cache.get("a://x"), nullptr);
+    EXPECT_EQ(cache.bytes(), 0u);
+}
+
+TEST(ResourceCache, EvictsLeastRecentlyUsedWithinBudget) {
+    // Each entry costs 5 (key) + 6 (text) bytes; three fit
+    ResourceCache cache({33, 0ms});
+    cache.put("a://1", text("111111"), cache.stamp());
+    cache.put("a://2", text("222222"), cache.stamp());
+    cache.put("a://3", text("333333"), cache.stamp());
+    ASSERT_NE(cache.get("a://1"), nullptr);  // now most recent
+    cache.put("a://4", text("444444"), cache.stamp());
+
+    EXPECT_EQ(cache.get("a://2"), nullptr);
+    EXPECT_NE(cache.get("a://1"), nullptr);
+    EXPECT_NE(cache.get("a://3"), nullptr);
+    EXPECT_NE(cache.get("a://4"), nullptr);
+    EXPECT_EQ(cache.bytes(), 33u);
+
+    // Larger than the whole budget: never cached
+    cache.put("a://big", text(std::string(64, 'x')), cache.stamp());
+    EXPECT_EQ(cache.get("a://big"), nullptr);
+    EXPECT_EQ(cache.size(), 3u);
+}
+
+TEST(ResourceCache, EntriesExpire) {
+    ResourceCache cache({1024, 100ms});
+    auto t0 = ResourceCache::Clock::now();
+    cache.put("a://x", text("body"), cache.stamp(), t0);
+    EXPECT_NE(cache.get("a://x", t0 + 50ms), nullptr);
+    EXPECT_EQ(cache.get("a://x", t0 + 150ms), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(ResourceCache, ReadRacingAnInvalidationIsNotCached) {
+    ResourceCache cache({1024, 0ms});
+    uint64_t stamp = cache.stamp();  // read starts
+    cache.invalidate("a://x");       // resource changes while the handler runs
+    cache.put("a://x", text("stale"), stamp);
+    EXPECT_EQ(cache.get("a://x"), nullptr);
+
+    stamp = cache.stamp();
+    cache.clear();
+    cache.put("a://x", text("stale"), stamp);
+    EXPECT_EQ(cache.get("a://x"), nullptr);
+}
+
+TEST(ResourceCache, SharesParsedContentsAndChargesTheirText) {
+    ResourceContentCache cache({1024, 0ms});
+    ResourceContent c;
+    c.uri = "a://x";
+    c.text = "body";
+    auto contents = std::make_shared<const std::vector<ResourceContent>>(1, c);
+    cache.put("a://x", contents, cache.stamp());
+    EXPECT_EQ(cache.get("a://x"), contents);  // the same object, not a copy
+    EXPECT_EQ(cache.bytes(), std::string("a://x").size() * 2 + 4);
+}
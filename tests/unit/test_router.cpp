@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 #include "mcp/router.hpp"
+#include "mcp/codec.hpp"
 #include "mcp/error.hpp"
+#include "mcp/session.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <string>
+#include <thread>
 
 using namespace mcp;
 
@@ -176,3 +182,317 @@ TEST(Router, DispatchResponse) {
     auto result = router.dispatch(resp);
     EXPECT_FALSE(result.has_value());
 }
+
+TEST(Router, AsyncHandlerRespondsInline) {
+    Router router;
+    router.on_request_async("echo", [](const nlohmann::json& params, Responder respond) {
+        respond(nlohmann::json{{"echo", params.value("v", 0)}});
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{7}};
+    req.method = "echo";
+    req.params = nlohmann::json{{"v", 3}};
+
+    std::optional<JsonRpcMessage> reply;
+    router.dispatch(req, [&reply](JsonRpcMessage m) { reply = std::move(m); });
+    ASSERT_TRUE(reply.has_value());
+    auto& resp = std::get<JsonRpcResponse>(*reply);
+    EXPECT_EQ(resp.id, RequestId{int64_t{7}});
+    EXPECT_EQ(resp.result->at("echo"), 3);
+}
+
+TEST(Router, AsyncHandlerRespondsLaterFromOtherThread) {
+    Router router;
+    std::thread worker;
+    router.on_request_async("later", [&worker](const nlohmann::json&, Responder respond) {
+        worker = std::thread([respond] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            respond(nlohmann::json{{"ok", true}});
+        });
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "later";
+
+    std::promise<JsonRpcMessage> got;
+    auto fut = got.get_future();
+    router.dispatch(req, [&got](JsonRpcMessage m) { got.set_value(std::move(m)); });
+    // dispatch() returned before the handler completed
+    EXPECT_EQ(fut.wait_for(std::chrono::milliseconds(0)), std::future_status::timeout);
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_TRUE(std::get<JsonRpcResponse>(fut.get()).result->at("ok").get<bool>());
+    worker.join();
+}
+
+TEST(Router, SyncDispatchWaitsForAsyncHandler) {
+    Router router;
+    std::thread worker;
+    router.on_request_async("later", [&worker](const nlohmann::json&, Responder respond) {
+        worker = std::thread([respond] { respond(nlohmann::json{{"ok", true}}); });
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "later";
+
+    auto response = router.dispatch(req);
+    ASSERT_TRUE(response.has_value());
+    EXPECT_TRUE(std::get<JsonRpcResponse>(*response).result.has_value());
+    worker.join();
+}
+
+TEST(Router, DroppedResponderFailsRequest) {
+    Router router;
+    router.on_request_async("forgetful", [](const nlohmann::json&, Responder) {});
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "forgetful";
+
+    auto response = router.dispatch(req);
+    ASSERT_TRUE(response.has_value());
+    auto& resp = std::get<JsonRpcResponse>(*response);
+    ASSERT_TRUE(resp.error.has_value());
+    EXPECT_EQ(resp.error->code, error::InternalError);
+}
+
+TEST(Router, ResponderFirstCompletionWins) {
+    Router router;
+    router.on_request_async("twice", [](const nlohmann::json&, Responder respond) {
+        respond(nlohmann::json{{"n", 1}});
+        respond(nlohmann::json{{"n", 2}});
+        EXPECT_TRUE(respond.done());
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "twice";
+
+    int replies = 0;
+    router.dispatch(req, [&replies](JsonRpcMessage m) {
+        ++replies;
+        EXPECT_EQ(std::get<JsonRpcResponse>(m).result->at("n"), 1);
+    });
+    EXPECT_EQ(replies, 1);
+}
+
+TEST(Router, AsyncHandlerThrowsBeforeResponding) {
+    Router router;
+    router.on_request_async("fail", [](const nlohmann::json&, Responder) {
+        throw McpProtocolError(error::InvalidParams, "Bad params");
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "fail";
+
+    auto response = router.dispatch(req);
+    ASSERT_TRUE(response.has_value());
+    EXPECT_EQ(std::get<JsonRpcResponse>(*response).error->code, error::InvalidParams);
+}
+
+TEST(Router, RawHandlerSeesWireTextAndReturnsRawResult) {
+    Router router;
+    std::string seen;
+    router.on_request_raw("forward", [&seen](std::string_view params) -> RawJson {
+        seen = std::string(params);
+        return RawJson{R"({"forwarded":true})"};
+    });
+
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"forward","params":{"b": 2, "a": 1}})");
+    auto response = router.dispatch(msg);
+    ASSERT_TRUE(response.has_value());
+    auto& resp = std::get<JsonRpcResponse>(*response);
+    // Key order and spacing preserved: params were never rebuilt
+    EXPECT_EQ(seen, R"({"b": 2, "a": 1})");
+    EXPECT_TRUE(resp.result.is_raw());
+    EXPECT_EQ(Codec::serialize(resp), R"({"jsonrpc":"2.0","id":1,"result":{"forwarded":true}})");
+}
+
+TEST(Router, RawHandlerWithInProcessParams) {
+    Router router;
+    router.on_request_raw("forward", [](std::string_view params) -> RawJson {
+        return RawJson{std::string(params)};
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "forward";
+    req.params = nlohmann::json{{"k", "v"}};
+    auto response = router.dispatch(req);
+    EXPECT_EQ(std::get<JsonRpcResponse>(*response).result->at("k"), "v");
+
+    req.params.reset();
+    response = router.dispatch(req);
+    EXPECT_EQ(*std::get<JsonRpcResponse>(*response).result, nlohmann::json::object());
+}
+
+TEST(Router, RawHandlerThrowsProtocolError) {
+    Router router;
+    router.on_request_raw("forward", [](std::string_view) -> RawJson {
+        throw McpProtocolError(error::InvalidParams, "bad");
+    });
+
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "forward";
+    auto response = router.dispatch(req);
+    EXPECT_EQ(std::get<JsonRpcResponse>(*response).error->code, error::InvalidParams);
+}
+
+TEST(Router, InternsStandardMethods) {
+    EXPECT_EQ(intern_method("ping"), Method::Ping);
+    EXPECT_EQ(intern_method("tools/call"), Method::ToolsCall);
+    EXPECT_EQ(intern_method("notifications/resources/updated"), Method::NotificationsResourcesUpdated);
+    EXPECT_EQ(intern_method("tools/cal"), Method::Unknown);
+    EXPECT_EQ(intern_method(""), Method::Unknown);
+    EXPECT_EQ(intern_method("custom/method"), Method::Unknown);
+    for (size_t i = 1; i < kMethodCount; ++i) {
+        auto m = static_cast<Method>(i);
+        EXPECT_EQ(intern_method(method_name(m)), m) << method_name(m);
+    }
+
+    auto msg = Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"tools/list"})");
+    EXPECT_EQ(std::get<JsonRpcRequest>(msg).method_id, Method::ToolsList);
+    auto notif = Codec::parse(R"({"jsonrpc":"2.0","method":"x/custom"})");
+    EXPECT_EQ(std::get<JsonRpcNotification>(notif).method_id, Method::Unknown);
+}
+
+TEST(Router, StandardAndCustomMethodsDispatchAlike) {
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult {
+        return nlohmann::json{{"who", "ping"}};
+    });
+    router.on_request("x/custom", [](const nlohmann::json&) -> HandlerResult {
+        return nlohmann::json{{"who", "custom"}};
+    });
+    router.require_capability("x/custom", "sampling");
+    EXPECT_TRUE(router.has_handler("ping"));
+    EXPECT_TRUE(router.has_handler("x/custom"));
+    EXPECT_FALSE(router.has_handler("tools/call"));
+
+    // Parsed (interned) and in-process (not interned) requests both resolve
+    auto parsed = router.dispatch(Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"ping"})"));
+    EXPECT_EQ((*std::get<JsonRpcResponse>(*parsed).result)["who"], "ping");
+
+    JsonRpcRequest custom;
+    custom.id = RequestId{int64_t{2}};
+    custom.method = "x/custom";
+    auto blocked = router.dispatch(custom);
+    EXPECT_EQ(std::get<JsonRpcResponse>(*blocked).error->code, error::InvalidRequest);
+
+    ClientCapabilities client_caps;
+    client_caps.sampling = nlohmann::json::object();
+    router.set_capabilities(ServerCapabilities{}, client_caps);
+    auto allowed = router.dispatch(custom);
+    EXPECT_EQ((*std::get<JsonRpcResponse>(*allowed).result)["who"], "custom");
+
+    JsonRpcRequest missing;
+    missing.id = RequestId{int64_t{3}};
+    missing.method = "tools/call";
+    auto not_found = router.dispatch(missing);
+    EXPECT_EQ(std::get<JsonRpcResponse>(*not_found).error->code, error::MethodNotFound);
+}
+
+TEST(Router, RegistrationDoesNotDisturbInFlightDispatch) {
+    Router router;
+    router.on_request("ping", [](const nlohmann::json&) -> HandlerResult {
+        return nlohmann::json::object();
+    });
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 16 || !stop.load(); ++i) {
+            router.on_request("x/" + std::to_string(i % 16), [](const nlohmann::json&) -> HandlerResult {
+                return nlohmann::json::object();
+            });
+        }
+    });
+
+    auto ping = Codec::parse(R"({"jsonrpc":"2.0","id":1,"method":"ping"})");
+    for (int i = 0; i < 2000; ++i) {
+        auto resp = router.dispatch(ping);
+        ASSERT_TRUE(resp.has_value());
+        ASSERT_FALSE(std::get<JsonRpcResponse>(*resp).error.has_value());
+    }
+    stop = true;
+    writer.join();
+    EXPECT_TRUE(router.has_handler("x/15"));
+}
+
+TEST(Router, RvalueDispatchMovesParamsIntoOwningHandlers) {
+    Router router;
+    const char* seen = nullptr;
+    router.on_request_raw("take", [&seen](LazyJson params, Responder respond) {
+        seen = (*params)["blob"].get_ref<const std::string&>().data();
+        respond(nlohmann::json::object());
+    });
+    router.on_request_co("co/take", [&seen](nlohmann::json params) -> CoTask<HandlerResult> {
+        seen = params["blob"].get_ref<const std::string&>().data();
+        co_return nlohmann::json::object();
+    });
+
+    for (const char* method : {"take", "co/take"}) {
+        JsonRpcRequest req;
+        req.id = RequestId{int64_t{1}};
+        req.method = method;
+        req.params = nlohmann::json{{"blob", std::string(1 << 20, 'x')}};
+        const char* original = req.params->at("blob").get_ref<const std::string&>().data();
+
+        // A const message is copied for the handler and left intact
+        JsonRpcMessage msg = req;
+        const JsonRpcMessage& view = msg;
+        ASSERT_TRUE(router.dispatch(view).has_value());
+        EXPECT_NE(seen, original);
+        EXPECT_EQ(std::get<JsonRpcRequest>(msg).params->at("blob").get_ref<const std::string&>().size(),
+                  size_t{1} << 20);
+
+        msg = std::move(req);
+        ASSERT_TRUE(router.dispatch(std::move(msg)).has_value()) << method;
+        EXPECT_EQ(seen, original) << method;
+    }
+}
+
+TEST(Router, HandlersSeeTheDispatchingSession) {
+    Router router;
+    Session* seen = nullptr;
+    std::promise<Session*> later;
+    router.on_request("whoami", [&](const nlohmann::json&) -> HandlerResult {
+        seen = Router::current_session();
+        return nlohmann::json::object();
+    });
+    router.on_notification("note", [&](const nlohmann::json&) { seen = Router::current_session(); });
+    router.on_request_async("nested", [&](const nlohmann::json&, Responder respond) {
+        // An inner dispatch for another session leaves ours in place after
+        Session inner;
+        JsonRpcRequest req;
+        req.id = RequestId{int64_t{9}};
+        req.method = "whoami";
+        (void)router.dispatch(req, &inner);
+        later.set_value(Router::current_session());
+        respond(nlohmann::json::object());
+    });
+
+    Session a, b;
+    JsonRpcRequest req;
+    req.id = RequestId{int64_t{1}};
+    req.method = "whoami";
+    (void)router.dispatch(req, &a);
+    EXPECT_EQ(seen, &a);
+    router.dispatch(req, [](JsonRpcMessage) {}, &b);
+    EXPECT_EQ(seen, &b);
+    (void)router.dispatch(req);
+    EXPECT_EQ(seen, nullptr);
+
+    JsonRpcNotification note;
+    note.method = "note";
+    (void)router.dispatch(note, &a);
+    EXPECT_EQ(seen, &a);
+
+    req.method = "nested";
+    (void)router.dispatch(req, &b);
+    EXPECT_EQ(later.get_future().get(), &b);
+    EXPECT_EQ(Router::current_session(), nullptr);
+}
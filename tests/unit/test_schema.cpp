@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "mcp/schema.hpp"
+#include <stdexcept>
+#include <string>
+
+using namespace mcp;
+
+namespace {
+
+// Both walkers must agree; returns the reported violation ("" if none).
+std::string check(const SchemaValidator& v, const std::string& text) {
+    auto dom = v.validate(nlohmann::json::parse(text));
+    auto pulled = v.validate_text(text);
+    EXPECT_EQ(dom, pulled) << text;
+    return dom.value_or("");
+}
+
+const nlohmann::json kSearchSchema = nlohmann::json::parse(R"({
+    "type": "object",
+    "properties": {
+        "query": {"type": "string", "minLength": 1, "maxLength": 8, "pattern": "^[a-z é]+$"},
+        "limit": {"type": "integer", "minimum": 1, "exclusiveMaximum": 100},
+        "ratio": {"type": "number", "multipleOf": 0.25},
+        "tags": {"type": "array", "items": {"type": "string"}, "maxItems": 2},
+        "point": {"type": "array", "prefixItems": [{"type": "number"}, {"type": "number"}],
+                  "items": false},
+        "near": {"$ref": "#/$defs/place"},
+        "mode": {"enum": ["fast", "exact"]},
+        "extra": {"type": ["object", "null"], "additionalProperties": {"type": "boolean"}}
+    },
+    "required": ["query"],
+    "additionalProperties": false,
+    "$defs": {
+        "place": {"type": "object", "properties": {"lat": {"type": "number"}}, "required": ["lat"]}
+    }
+})");
+
+} // namespace
+
+TEST(SchemaValidator, AcceptsConformingValues) {
+    SchemaValidator v(kSearchSchema);
+    EXPECT_EQ(check(v, R"({"query":"café"})"), "");
+    EXPECT_EQ(check(v, R"({"query":"a b","limit":99,"ratio":1.75,"tags":["x","y"],)"
+                       R"("point":[1,2.5],"near":{"lat":52.2},"mode":"fast","extra":{"k":true}})"),
+              "");
+    EXPECT_EQ(check(v, R"({"query":"q","limit":5.0,"extra":null})"), "");
+}
+
+TEST(SchemaValidator, ReportsFirstViolationWithPointer) {
+    SchemaValidator v(kSearchSchema);
+    EXPECT_EQ(check(v, R"([])"), "expected object");
+    EXPECT_EQ(check(v, R"({})"), "missing property 'query'");
+    EXPECT_EQ(check(v, R"({"query":""})"), "/query: must be at least 1 characters");
+    EXPECT_EQ(check(v, R"({"query":"abcdefghi"})"), "/query: must be at most 8 characters");
+    EXPECT_EQ(check(v, R"({"query":"ABC"})"), "/query: does not match the pattern");
+    EXPECT_EQ(check(v, R"({"query":"q","limit":1.5})"), "/limit: expected integer");
+    EXPECT_EQ(check(v, R"({"query":"q","limit":0})"), "/limit: must be >= 1");
+    EXPECT_EQ(check(v, R"({"query":"q","limit":100})"), "/limit: must be < 100");
+    EXPECT_EQ(check(v, R"({"query":"q","ratio":0.3})"), "/ratio: must be a multiple of 0.25");
+    EXPECT_EQ(check(v, R"({"query":"q","tags":["a",1]})"), "/tags/1: expected string");
+    EXPECT_EQ(check(v, R"({"query":"q","tags":["a","b","c"]})"), "/tags: expected at most 2 items");
+    EXPECT_EQ(check(v, R"({"query":"q","point":[1,2,3]})"), "/point/2: not allowed");
+    EXPECT_EQ(check(v, R"({"query":"q","near":{}})"), "/near: missing property 'lat'");
+    EXPECT_EQ(check(v, R"({"query":"q","mode":"slow"})"), "/mode: not one of the allowed values");
+    EXPECT_EQ(check(v, R"({"query":"q","extra":{"a/b":1}})"), "/extra/a~1b: expected boolean");
+    EXPECT_EQ(check(v, R"({"query":"q","other":1})"), "/other: not allowed");
+}
+
+TEST(SchemaValidator, Combinators) {
+    SchemaValidator v(nlohmann::json::parse(R"({
+        "properties": {
+            "id": {"anyOf": [{"type": "string"}, {"type": "integer", "minimum": 0}]},
+            "shape": {"oneOf": [{"required": ["r"]}, {"required": ["w"]}]},
+            "name": {"allOf": [{"type": "string"}, {"maxLength": 3}], "not": {"const": "bad"}},
+            "set": {"type": "array", "uniqueItems": true}
+        }
+    })"));
+    EXPECT_EQ(check(v, R"({"id":"x","shape":{"r":1},"name":"ok","set":[1,2]})"), "");
+    EXPECT_EQ(check(v, R"({"id":-1})"), "/id: does not match any schema in anyOf");
+    EXPECT_EQ(check(v, R"({"shape":{"r":1,"w":2}})"), "/shape: matches more than one schema in oneOf");
+    EXPECT_EQ(check(v, R"({"shape":{}})"), "/shape: does not match any schema in oneOf");
+    EXPECT_EQ(check(v, R"({"name":"long"})"), "/name: must be at most 3 characters");
+    EXPECT_EQ(check(v, R"({"name":"bad"})"), "/name: matches the schema in not");
+    EXPECT_EQ(check(v, R"({"set":[1,{"a":1},{"a":1}]})"), "/set: items are not unique");
+}
+
+TEST(SchemaValidator, RecursiveRefsAndBooleanSchemas) {
+    SchemaValidator tree(nlohmann::json::parse(R"({
+        "$ref": "#/$defs/node",
+        "$defs": {"node": {"type": "object", "properties": {
+            "value": {"type": "integer"},
+            "children": {"type": "array", "items": {"$ref": "#/$defs/node"}}}}}
+    })"));
+    EXPECT_EQ(check(tree, R"({"value":1,"children":[{"value":2,"children":[{"value":3}]}]})"), "");
+    EXPECT_EQ(check(tree, R"({"children":[{"children":[{"value":"x"}]}]})"),
+              "/children/0/children/0/value: expected integer");
+
+    EXPECT_EQ(SchemaValidator(true).validate(nlohmann::json::array()), std::nullopt);
+    EXPECT_EQ(SchemaValidator(false).validate(1), "not allowed");
+    EXPECT_EQ(SchemaValidator(nlohmann::json::object()).validate_text("3"), std::nullopt);
+    EXPECT_EQ(SchemaValidator(nlohmann::json{{"type", "string"}}).validate_text("3"), "expected string");
+    EXPECT_EQ(SchemaValidator(nlohmann::json::object()).validate_text(R"({"a":)")->rfind("invalid JSON", 0),
+              0u);
+}
+
+TEST(SchemaValidator, RejectsMalformedSchemas) {
+    EXPECT_THROW(SchemaValidator(nlohmann::json(1)), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json{{"type", "decimal"}}), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json{{"minLength", -1}}), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json{{"pattern", "("}}), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json{{"$ref", "#/missing"}}), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json{{"$ref", "other.json"}}), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json{{"required", {1}}}), std::invalid_argument);
+    EXPECT_THROW(SchemaValidator(nlohmann::json::parse(R"({"$ref":"#/$defs/a","$defs":{"a":{"$ref":"#/$defs/a"}}})")),
+                 std::invalid_argument);
+}
@@ -129,3 +129,18 @@ TEST(Session, ThreadSafeNextId) {
     auto it = std::unique(ids.begin(), ids.end());
     EXPECT_EQ(it, ids.end());
 }
+
+TEST(Session, TracksSubscriptionsAndLogLevel) {
+    Session s;
+    EXPECT_TRUE(s.subscribe("file:///a"));
+    EXPECT_FALSE(s.subscribe("file:///a"));
+    EXPECT_TRUE(s.subscribe("file:///b"));
+    EXPECT_TRUE(s.is_subscribed("file:///a"));
+    EXPECT_TRUE(s.unsubscribe("file:///a"));
+    EXPECT_FALSE(s.unsubscribe("file:///a"));
+    EXPECT_EQ(s.subscriptions(), std::vector<std::string>{"file:///b"});
+
+    EXPECT_EQ(s.log_level(), LogLevel::Info);
+    s.set_log_level(LogLevel::Debug);
+    EXPECT_EQ(s.log_level(), LogLevel::Debug);
+}
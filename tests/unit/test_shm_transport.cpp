@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include "mcp/transport/shm_transport.hpp"
+#include "mcp/client.hpp"
+#include "mcp/server.hpp"
+#include "mcp/error.hpp"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+namespace {
+
+JsonRpcNotification note(const std::string& method, nlohmann::json params = nullptr) {
+    JsonRpcNotification n;
+    n.method = method;
+    if (!params.is_null()) n.params = std::move(params);
+    return n;
+}
+
+// Collects messages and waits for a count of them
+struct Inbox {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<JsonRpcMessage> messages;
+
+    MessageCallback callback() {
+        return [this](JsonRpcMessage msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(std::move(msg));
+            cv.notify_all();
+        };
+    }
+    bool wait_for(size_t n, std::chrono::milliseconds timeout = 5s) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [&] { return messages.size() >= n; });
+    }
+};
+
+// Both ends of a ring pair, each with its reader running
+struct ShmPair {
+    std::unique_ptr<ShmTransport> a, b;
+    Inbox a_inbox, b_inbox;
+    std::thread a_thread, b_thread;
+
+    explicit ShmPair(ShmTransport::Options opts = {}) {
+        int sv[2];
+        EXPECT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        a = std::make_unique<ShmTransport>(sv[0], ShmTransport::Role::Create, opts);
+        b = std::make_unique<ShmTransport>(sv[1], ShmTransport::Role::Attach, opts);
+        a_thread = std::thread([this] { a->start(a_inbox.callback()); });
+        b_thread = std::thread([this] { b->start(b_inbox.callback()); });
+    }
+    ~ShmPair() {
+        a->shutdown();
+        b->shutdown();
+        a_thread.join();
+        b_thread.join();
+    }
+};
+
+} // namespace
+
+TEST(ShmTransport, DeliversInOrderBothWays) {
+    ShmPair pair;
+    constexpr int kMessages = 1000;
+    std::thread other([&] {
+        for (int i = 0; i < kMessages; ++i) pair.b->send(note("test/back", {{"seq", i}}));
+    });
+    for (int i = 0; i < kMessages; ++i) pair.a->send(note("test/forth", {{"seq", i}}));
+    other.join();
+
+    ASSERT_TRUE(pair.b_inbox.wait_for(kMessages));
+    ASSERT_TRUE(pair.a_inbox.wait_for(kMessages));
+    for (int i = 0; i < kMessages; ++i) {
+        EXPECT_EQ((*std::get<JsonRpcNotification>(pair.b_inbox.messages[i]).params)["seq"], i);
+        EXPECT_EQ((*std::get<JsonRpcNotification>(pair.a_inbox.messages[i]).params)["seq"], i);
+    }
+    EXPECT_EQ(pair.a->stats().messages_written, static_cast<uint64_t>(kMessages));
+}
+
+TEST(ShmTransport, MessagesLargerThanTheRingStreamThroughIt) {
+    ShmTransport::Options opts;
+    opts.ring_bytes = 4096;
+    opts.spin = 0us;  // every wait is a doorbell
+    ShmPair pair(opts);
+
+    std::string big(200 * 1024, 'x');
+    for (int i = 0; i < 4; ++i) pair.a->send(note("test/big", {{"data", big}, {"seq", i}}));
+    pair.a->send_batch({note("one"), note("two")});
+    ASSERT_TRUE(pair.b_inbox.wait_for(6, 10s));
+    for (int i = 0; i < 4; ++i) {
+        const auto& params = *std::get<JsonRpcNotification>(pair.b_inbox.messages[i]).params;
+        EXPECT_EQ(params["seq"], i);
+        EXPECT_EQ(params["data"].get_ref<const std::string&>().size(), big.size());
+    }
+    EXPECT_EQ(std::get<JsonRpcNotification>(pair.b_inbox.messages[5]).method, "two");
+    auto stats = pair.a->stats();
+    EXPECT_GT(stats.full_waits, 0u);
+    EXPECT_GT(stats.doorbells, 0u);
+}
+
+TEST(ShmTransport, StreamedResultsArriveWhole) {
+    ShmTransport::Options opts;
+    opts.ring_bytes = 4096;
+    ShmPair pair(opts);
+
+    JsonRpcResponse resp;
+    resp.id = RequestId(int64_t{7});
+    resp.result_stream = [n = 0](std::string& out) mutable {
+        if (n == 0) out += R"({"items":[)";
+        if (n > 0) out += ',';
+        out += '"' + std::string(1000, 'a' + n % 26) + '"';
+        if (++n < 50) return true;
+        out += "]}";
+        return false;
+    };
+    pair.a->send(resp);
+    ASSERT_TRUE(pair.b_inbox.wait_for(1));
+    const auto& got = std::get<JsonRpcResponse>(pair.b_inbox.messages[0]);
+    EXPECT_EQ(got.id, RequestId(int64_t{7}));
+    EXPECT_EQ(got.result->at("items").size(), 50u);
+}
+
+TEST(ShmTransport, PeerShutdownEndsStart) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    auto a = std::make_unique<ShmTransport>(sv[0], ShmTransport::Role::Create);
+    auto b = std::make_unique<ShmTransport>(sv[1], ShmTransport::Role::Attach);
+    Inbox inbox;
+    std::thread reader([&] { b->start(inbox.callback()); });
+
+    // Sent just before going away, still delivered
+    a->send(note("test/last"));
+    a->shutdown();
+    reader.join();
+    ASSERT_EQ(inbox.messages.size(), 1u);
+    EXPECT_FALSE(b->is_connected());
+    EXPECT_THROW(a->send(note("x")), McpTransportError);
+}
+
+TEST(ShmTransport, AttachRejectsAPeerWithoutRings) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ASSERT_EQ(::write(sv[0], "M", 1), 1);  // the right byte, but no memfd
+    EXPECT_THROW(ShmTransport(sv[1], ShmTransport::Role::Attach), McpTransportError);
+    ::close(sv[0]);
+}
+
+TEST(ShmTransport, CarriesAClientServerSession) {
+    int sv[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    auto client_transport = std::make_unique<ShmTransport>(sv[0], ShmTransport::Role::Create);
+    auto server_transport = std::make_unique<ShmTransport>(sv[1], ShmTransport::Role::Attach);
+
+    McpServer::Options sopts;
+    sopts.server_info = {"shm-server", std::nullopt, "1.0"};
+    McpServer server(sopts);
+    ToolDefinition def;
+    def.name = "echo";
+    def.input_schema = nlohmann::json{{"type", "object"}};
+    server.add_tool(def, [](const nlohmann::json& args) -> CallToolResult {
+        CallToolResult result;
+        result.content.push_back(TextContent{args.value("text", ""), std::nullopt});
+        return result;
+    });
+    std::thread server_thread([&, t = std::move(server_transport)]() mutable {
+        server.serve(std::move(t));
+    });
+
+    McpClient::Options copts;
+    copts.client_info = {"shm-client", std::nullopt, "1.0"};
+    copts.request_timeout = 5000ms;
+    McpClient client(copts);
+    client.connect(std::move(client_transport));
+    EXPECT_EQ(client.initialize().server_info.name, "shm-server");
+    for (int i = 0; i < 100; ++i) {
+        auto result = client.call_tool("echo", {{"text", std::to_string(i)}});
+        ASSERT_EQ(result.content.size(), 1u);
+        EXPECT_EQ(std::get<TextContent>(result.content[0]).text, std::to_string(i));
+    }
+
+    client.disconnect();
+    server.shutdown();
+    server_thread.join();
+}
+
+TEST(ShmTransport, ServeShmNeedsALaunchingClient) {
+    ::unsetenv(ShmTransport::kFdEnv);
+    McpServer server(McpServer::Options{});
+    EXPECT_THROW(server.serve_shm(), McpTransportError);
+}
+
+TEST(ShmTransport, NegotiatesBinaryFraming) {
+    uint64_t bytes_per_call[2] = {};  // declined, accepted
+    for (bool accept : {true, false}) {
+        int sv[2];
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        auto client_transport = std::make_unique<ShmTransport>(sv[0], ShmTransport::Role::Create);
+        auto server_transport = std::make_unique<ShmTransport>(sv[1], ShmTransport::Role::Attach);
+        auto* raw_client = client_transport.get();
+        auto* raw_server = server_transport.get();
+
+        McpServer::Options sopts;
+        sopts.accept_wire_formats = accept;
+        McpServer server(sopts);
+        ToolDefinition def;
+        def.name = "echo";
+        def.input_schema = nlohmann::json{{"type", "object"}};
+        server.add_tool(def, [](const nlohmann::json& args) -> CallToolResult {
+            CallToolResult result;
+            result.content.push_back(TextContent{args.value("text", ""), std::nullopt});
+            return result;
+        });
+        std::thread server_thread([&, t = std::move(server_transport)]() mutable {
+            server.serve(std::move(t));
+        });
+
+        McpClient::Options copts;
+        copts.request_timeout = 5000ms;
+        copts.wire_format = WireFormat::MessagePack;
+        McpClient client(copts);
+        client.connect(std::move(client_transport));
+        auto init = client.initialize();
+        auto agreed = init.capabilities.experimental
+                          ? init.capabilities.experimental->value(kWireFormatCapability, nlohmann::json())
+                          : nlohmann::json();
+        if (accept) {
+            EXPECT_EQ(agreed.value("format", ""), "msgpack");
+        } else {
+            EXPECT_TRUE(agreed.is_null());
+        }
+
+        auto before = raw_client->stats().bytes_written + raw_server->stats().bytes_written;
+        auto result = client.call_tool("echo", {{"text", "hello"}, {"n", 12345}});
+        ASSERT_EQ(result.content.size(), 1u);
+        EXPECT_EQ(std::get<TextContent>(result.content[0]).text, "hello");
+        bytes_per_call[accept] =
+            raw_client->stats().bytes_written + raw_server->stats().bytes_written - before;
+
+        client.disconnect();
+        server.shutdown();
+        server_thread.join();
+    }
+    EXPECT_LT(bytes_per_call[1], bytes_per_call[0]);
+}
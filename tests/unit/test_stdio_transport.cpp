@@ -2,10 +2,13 @@
 #include "mcp/transport/stdio_transport.hpp"
 #include "mcp/codec.hpp"
 #include <unistd.h>
+#include <atomic>
 #include <thread>
 #include <chrono>
+#include <memory>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 
 using namespace mcp;
 
@@ -92,3 +95,401 @@ TEST(StdioTransport, Shutdown) {
     t.shutdown(); // should not throw
     SUCCEED();
 }
+
+// ---- Batched writer ----
+
+namespace {
+
+// Runs a transport's reader/writer on a background thread.
+struct StartedTransport {
+    StartedTransport(int write_fd, StdioTransport::Options opts) {
+        if (pipe(input_) < 0) throw std::runtime_error("pipe failed");
+        transport = std::make_unique<StdioTransport>(input_[0], write_fd, opts);
+        thread = std::thread([this] { transport->start([](JsonRpcMessage) {}); });
+        while (!transport->is_connected()) std::this_thread::yield();
+    }
+    ~StartedTransport() {
+        transport->shutdown();
+        thread.join();
+        ::close(input_[1]);
+    }
+
+    int input_[2];
+    std::unique_ptr<StdioTransport> transport;
+    std::thread thread;
+};
+
+std::vector<std::string> read_lines(int fd, size_t count) {
+    std::vector<std::string> lines;
+    std::string buf;
+    char chunk[4096];
+    while (lines.size() < count) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0) break;
+        buf.append(chunk, static_cast<size_t>(n));
+        size_t pos, start = 0;
+        while ((pos = buf.find('\n', start)) != std::string::npos) {
+            lines.push_back(buf.substr(start, pos - start));
+            start = pos + 1;
+        }
+        buf.erase(0, start);
+    }
+    return lines;
+}
+
+} // namespace
+
+TEST(MpscQueue, DrainsInPushOrder) {
+    MpscQueue<int> q;
+    EXPECT_TRUE(q.push(1));
+    EXPECT_FALSE(q.push(2));
+    EXPECT_FALSE(q.push(3));
+
+    std::vector<int> out;
+    EXPECT_EQ(q.drain_into(out), 3u);
+    EXPECT_EQ(out, (std::vector<int>{1, 2, 3}));
+    EXPECT_TRUE(q.empty());
+    EXPECT_TRUE(q.push(4));
+}
+
+TEST(StdioTransport, ConcurrentSendersKeepFramesIntact) {
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+    {
+        StartedTransport t(out[1], {});
+
+        std::vector<std::thread> senders;
+        for (int th = 0; th < kThreads; ++th) {
+            senders.emplace_back([&, th] {
+                for (int i = 0; i < kPerThread; ++i) {
+                    JsonRpcNotification n;
+                    n.method = "notifications/progress";
+                    n.params = nlohmann::json{{"t", th}, {"i", i}};
+                    t.transport->send(n);
+                }
+            });
+        }
+
+        auto lines = read_lines(out[0], kThreads * kPerThread);
+        for (auto& s : senders) s.join();
+        ASSERT_EQ(lines.size(), static_cast<size_t>(kThreads * kPerThread));
+
+        // Each sender's frames arrive whole and in its own order
+        std::vector<int> next(kThreads, 0);
+        for (const auto& line : lines) {
+            auto msg = std::get<JsonRpcNotification>(Codec::parse(line));
+            int th = msg.params->at("t").get<int>();
+            EXPECT_EQ(msg.params->at("i").get<int>(), next[th]++);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (t.transport->stats().messages_written < kThreads * kPerThread
+               && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto stats = t.transport->stats();
+        EXPECT_EQ(stats.messages_written, static_cast<uint64_t>(kThreads * kPerThread));
+        EXPECT_LE(stats.write_calls, stats.messages_written);
+    }
+    ::close(out[0]);
+}
+
+TEST(StdioTransport, FlushLatencyCoalescesBursts) {
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    constexpr int kMessages = 100;
+    {
+        StdioTransport::Options opts;
+        opts.max_batch_messages = 64;
+        opts.flush_latency = std::chrono::milliseconds(20);
+        StartedTransport t(out[1], opts);
+
+        for (int i = 0; i < kMessages; ++i) {
+            JsonRpcNotification n;
+            n.method = "notifications/message";
+            n.params = nlohmann::json{{"i", i}};
+            t.transport->send(n);
+        }
+        auto lines = read_lines(out[0], kMessages);
+        ASSERT_EQ(lines.size(), static_cast<size_t>(kMessages));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (t.transport->stats().messages_written < kMessages
+               && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // 100 frames in batches of at most 64: a handful of writev calls
+        auto stats = t.transport->stats();
+        EXPECT_GE(stats.write_calls, 2u);
+        EXPECT_LE(stats.write_calls, 10u);
+    }
+    ::close(out[0]);
+}
+
+// ---- Outbound limits ----
+
+namespace {
+
+// Reads lines until one contains `needle` (inclusive) or EOF.
+std::vector<std::string> read_until(int fd, const std::string& needle) {
+    std::vector<std::string> lines;
+    std::string buf;
+    char chunk[4096];
+    while (true) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0) return lines;
+        buf.append(chunk, static_cast<size_t>(n));
+        size_t pos, start = 0;
+        while ((pos = buf.find('\n', start)) != std::string::npos) {
+            lines.push_back(buf.substr(start, pos - start));
+            start = pos + 1;
+            if (lines.back().find(needle) != std::string::npos) return lines;
+        }
+        buf.erase(0, start);
+    }
+}
+
+JsonRpcResponse marker_response(int64_t id) {
+    JsonRpcResponse r;
+    r.id = id;
+    r.result = nlohmann::json{{"marker", id}};
+    return r;
+}
+
+// Big enough that a few hundred frames fill the pipe and stall the writer
+const std::string kPadding(200, 'x');
+
+} // namespace
+
+TEST(StdioTransport, DropOldestBoundsQueueAndKeepsResponses) {
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    constexpr int kMessages = 5000;
+    {
+        StdioTransport::Options opts;
+        opts.outbound_limits = {100, 0, OverflowPolicy::DropOldest};
+        StartedTransport t(out[1], opts);
+
+        // Nobody reads yet, so the queue hits its limit
+        for (int i = 0; i < kMessages; ++i) {
+            if (i == kMessages / 2) t.transport->send(marker_response(7));
+            JsonRpcNotification n;
+            n.method = "notifications/message";
+            n.params = nlohmann::json{{"i", i}, {"pad", kPadding}};
+            t.transport->send(n);
+        }
+        auto stats = t.transport->stats();
+        EXPECT_LE(stats.queued_messages, 100u);
+        EXPECT_GT(stats.dropped_messages, 0u);
+
+        t.transport->send(marker_response(99));
+        auto lines = read_until(out[0], "\"marker\":99");
+        EXPECT_LT(lines.size(), static_cast<size_t>(kMessages));
+        bool kept_response = false;
+        int last = -1;
+        for (const auto& line : lines) {
+            auto msg = Codec::parse(line);
+            if (auto* r = std::get_if<JsonRpcResponse>(&msg)) {
+                if (r->id == RequestId{int64_t{7}}) kept_response = true;
+                continue;
+            }
+            // Survivors keep their order
+            int i = std::get<JsonRpcNotification>(msg).params->at("i").get<int>();
+            EXPECT_GT(i, last);
+            last = i;
+        }
+        EXPECT_TRUE(kept_response);
+        EXPECT_EQ(last, kMessages - 1);  // the newest are the ones kept
+    }
+    ::close(out[0]);
+}
+
+TEST(StdioTransport, CoalescesSupersededProgress) {
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    constexpr int kUpdates = 2000;
+    {
+        StdioTransport::Options opts;
+        opts.outbound_limits = {10, 0, OverflowPolicy::CoalesceProgress};
+        StartedTransport t(out[1], opts);
+
+        for (int i = 0; i < kUpdates; ++i) {
+            JsonRpcNotification n;
+            n.method = "notifications/progress";
+            n.params = nlohmann::json{{"progressToken", "job"}, {"progress", i}, {"pad", kPadding}};
+            t.transport->send(n);
+        }
+        EXPECT_GT(t.transport->stats().coalesced_messages, 0u);
+
+        t.transport->send(marker_response(1));
+        auto lines = read_until(out[0], "\"marker\"");
+        ASSERT_GE(lines.size(), 2u);
+        // The latest update always survives
+        auto last = std::get<JsonRpcNotification>(Codec::parse(lines[lines.size() - 2]));
+        EXPECT_EQ(last.params->at("progress").get<int>(), kUpdates - 1);
+    }
+    ::close(out[0]);
+}
+
+TEST(StdioTransport, BlockPolicyWaitsForReader) {
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    constexpr int kMessages = 1000;
+    {
+        StdioTransport::Options opts;
+        opts.outbound_limits = {8, 0, OverflowPolicy::Block};
+        StartedTransport t(out[1], opts);
+
+        std::atomic<bool> finished{false};
+        std::thread producer([&] {
+            for (int i = 0; i < kMessages; ++i) {
+                JsonRpcNotification n;
+                n.method = "notifications/message";
+                n.params = nlohmann::json{{"i", i}, {"pad", kPadding}};
+                t.transport->send(n);
+            }
+            finished = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        EXPECT_FALSE(finished.load());
+        EXPECT_LE(t.transport->stats().queued_messages, 8u);
+
+        // Nothing is lost once the reader catches up
+        auto lines = read_lines(out[0], kMessages);
+        producer.join();
+        ASSERT_EQ(lines.size(), static_cast<size_t>(kMessages));
+        for (int i = 0; i < kMessages; ++i) {
+            auto msg = std::get<JsonRpcNotification>(Codec::parse(lines[i]));
+            EXPECT_EQ(msg.params->at("i").get<int>(), i);
+        }
+        EXPECT_EQ(t.transport->stats().dropped_messages, 0u);
+    }
+    ::close(out[0]);
+}
+
+TEST(StdioTransport, ShutdownReturnsWhenPeerStopsReading) {
+    int in[2], out[2];
+    ASSERT_EQ(pipe(in), 0);
+    ASSERT_EQ(pipe(out), 0);
+    StdioTransport::Options opts;
+    opts.drain_timeout = std::chrono::milliseconds(200);
+    auto transport = std::make_unique<StdioTransport>(in[0], out[1], opts);
+    std::thread reader([&] { transport->start([](JsonRpcMessage) {}); });
+    while (!transport->is_connected()) std::this_thread::yield();
+
+    // Far more than the pipe holds; its read end stays open, unread
+    JsonRpcNotification n;
+    n.method = "notifications/message";
+    n.params = nlohmann::json{{"pad", std::string(64 * 1024, 'x')}};
+    for (int i = 0; i < 32; ++i) transport->send(n);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_GT(transport->stats().queued_messages, 0u);
+
+    auto start = std::chrono::steady_clock::now();
+    transport->shutdown();
+    reader.join();
+    transport.reset();  // joins the writer
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    ::close(in[1]);
+    ::close(out[0]);
+}
+
+// ---- Read framing ----
+
+TEST(StdioTransport, ReadsLinesSplitAcrossChunks) {
+    int in[2], out[2];
+    ASSERT_EQ(pipe(in), 0);
+    ASSERT_EQ(pipe(out), 0);
+
+    StdioTransport::Options opts;
+    opts.read_chunk_size = 512;  // much smaller than the payload
+    StdioTransport t(in[0], out[1], opts);
+
+    std::vector<JsonRpcMessage> received;
+    std::mutex m;
+    std::condition_variable cv;
+    std::thread reader([&] {
+        t.start([&](JsonRpcMessage msg) {
+            std::lock_guard<std::mutex> lock(m);
+            received.push_back(std::move(msg));
+            cv.notify_one();
+        });
+    });
+
+    const std::string big(3 * 1024 * 1024, 'x');
+    std::string input;
+    input += R"({"jsonrpc":"2.0","id":1,"method":"a"})" "\r\n\n";
+    input += R"({"jsonrpc":"2.0","id":2,"method":"b","params":{"data":")" + big + "\"}}\n";
+    input += R"({"jsonrpc":"2.0","method":"c"})" "\n";
+
+    // Dribble the input in uneven pieces so lines straddle reads
+    std::thread writer([&] {
+        size_t off = 0, step = 777;
+        while (off < input.size()) {
+            size_t n = std::min(step, input.size() - off);
+            ssize_t w = ::write(in[1], input.data() + off, n);
+            if (w <= 0) break;
+            off += static_cast<size_t>(w);
+            step = step * 3 % 200000 + 1;
+        }
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(m);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(10), [&] { return received.size() == 3; }));
+    }
+    writer.join();
+    t.shutdown();
+    reader.join();
+    ::close(in[1]);
+    ::close(out[0]);
+
+    EXPECT_EQ(std::get<JsonRpcRequest>(received[0]).method, "a");
+    const auto& second = std::get<JsonRpcRequest>(received[1]);
+    EXPECT_EQ(second.method, "b");
+    EXPECT_EQ(second.params->at("data").get_ref<const std::string&>(), big);
+    EXPECT_EQ(std::get<JsonRpcNotification>(received[2]).method, "c");
+}
+
+TEST(StdioTransport, WritesStreamedResultInOrder) {
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    const std::string piece(100 * 1024, 'z');
+    {
+        StartedTransport t(out[1], {});
+
+        JsonRpcNotification before;
+        before.method = "before";
+        t.transport->send(before);
+
+        // Larger than the pipe, so the pieces are produced as it drains
+        JsonRpcResponse resp;
+        resp.id = RequestId{int64_t{3}};
+        auto calls = std::make_shared<int>(0);
+        resp.result_stream = [calls, &piece](std::string& out) {
+            int n = (*calls)++;
+            if (n == 0) out += "\"";
+            if (n > 0 && n < 4) out += piece;
+            if (n < 4) return true;
+            out += "\"";
+            return false;
+        };
+        t.transport->send(resp);
+
+        JsonRpcNotification after;
+        after.method = "after";
+        t.transport->send(after);
+
+        auto lines = read_lines(out[0], 3);
+        ASSERT_EQ(lines.size(), 3u);
+        EXPECT_EQ(std::get<JsonRpcNotification>(Codec::parse(lines[0])).method, "before");
+        auto streamed = std::get<JsonRpcResponse>(Codec::parse(lines[1]));
+        EXPECT_EQ(streamed.id, RequestId{int64_t{3}});
+        EXPECT_EQ(streamed.result->get_ref<const std::string&>(), piece + piece + piece);
+        EXPECT_EQ(std::get<JsonRpcNotification>(Codec::parse(lines[2])).method, "after");
+    }
+    ::close(out[0]);
+}
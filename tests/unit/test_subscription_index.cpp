@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "mcp/subscription_index.hpp"
+
+using namespace mcp;
+
+using Subscribers = std::vector<std::string>;
+
+TEST(SubscriptionIndex, ExactPatternsMatchOnlyTheirUri) {
+    SubscriptionIndex index;
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.add("file:///a", "s1"));
+    EXPECT_FALSE(index.add("file:///a", "s1"));
+    EXPECT_TRUE(index.add("file:///a", "s2"));
+    EXPECT_EQ(index.match("file:///a"), (Subscribers{"s1", "s2"}));
+    EXPECT_TRUE(index.match("file:///ab").empty());
+    EXPECT_TRUE(index.match("file:///").empty());
+
+    EXPECT_TRUE(index.remove("file:///a", "s1"));
+    EXPECT_FALSE(index.remove("file:///a", "s1"));
+    EXPECT_EQ(index.match("file:///a"), Subscribers{"s2"});
+    EXPECT_TRUE(index.remove("file:///a", "s2"));
+    EXPECT_TRUE(index.empty());
+}
+
+TEST(SubscriptionIndex, TrailingStarMatchesByPrefix) {
+    SubscriptionIndex index;
+    index.add("db://acme/*", "tenant");
+    index.add("db://*", "admin");
+    index.add("db://acme/users", "users");
+    index.add("db://acme/users", "admin");  // and by prefix: listed once
+
+    EXPECT_EQ(index.match("db://acme/users"), (Subscribers{"admin", "tenant", "users"}));
+    EXPECT_EQ(index.match("db://acme/"), (Subscribers{"admin", "tenant"}));
+    EXPECT_EQ(index.match("db://other"), Subscribers{"admin"});
+    EXPECT_TRUE(index.match("file:///db://acme/x").empty());
+
+    index.add("*", "all");
+    EXPECT_EQ(index.match(""), Subscribers{"all"});
+    EXPECT_EQ(index.match("x"), Subscribers{"all"});
+
+    // A star elsewhere is literal
+    index.add("db://*/users", "literal");
+    EXPECT_EQ(index.match("db://*/users"), (Subscribers{"admin", "all", "literal"}));
+    EXPECT_EQ(index.match("db://acme/users").size(), 4u);
+}
+
+TEST(SubscriptionIndex, RemovingPrefixesPrunesTheTrie) {
+    SubscriptionIndex index;
+    index.add("a/b/*", "s1");
+    index.add("a/*", "s2");
+    EXPECT_FALSE(index.remove("a/b/c/*", "s1"));
+    EXPECT_FALSE(index.remove("a/b/*", "s2"));
+    EXPECT_FALSE(index.remove("a/b", "s1"));  // exact, not the prefix
+
+    EXPECT_TRUE(index.remove("a/b/*", "s1"));
+    EXPECT_EQ(index.match("a/b/x"), Subscribers{"s2"});
+    EXPECT_TRUE(index.remove("a/*", "s2"));
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.match("a/b/x").empty());
+
+    // The pruned path can be used again
+    index.add("a/b/*", "s3");
+    EXPECT_EQ(index.match("a/b/x"), Subscribers{"s3"});
+    index.clear();
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.match("a/b/x").empty());
+}
+
+TEST(SubscriptionIndex, CollectListsEachPatternsSubscribers) {
+    SubscriptionIndex index;
+    index.add("u://x", "s");
+    index.add("u://*", "s");
+    std::vector<const std::string*> found;
+    index.collect("u://x", found);
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_EQ(*found[0], "s");
+    EXPECT_EQ(*found[1], "s");
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "mcp/timer_wheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+TEST(TimerWheel, FiresInDeadlineOrder) {
+    TimerWheel wheel(1ms);
+    auto t0 = TimerWheel::Clock::now();
+    std::vector<int> fired;
+    wheel.schedule(30ms, [&] { fired.push_back(3); });
+    wheel.schedule(10ms, [&] { fired.push_back(1); });
+    wheel.schedule(20ms, [&] { fired.push_back(2); });
+    EXPECT_EQ(wheel.pending(), 3u);
+
+    wheel.advance(t0 + 5ms);
+    EXPECT_TRUE(fired.empty());
+    wheel.advance(t0 + 1s);
+    EXPECT_EQ(fired, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+TEST(TimerWheel, CancelledTimersDoNotFire) {
+    TimerWheel wheel(1ms);
+    auto t0 = TimerWheel::Clock::now();
+    int fired = 0;
+    auto a = wheel.schedule(10ms, [&] { ++fired; });
+    auto b = wheel.schedule(10ms, [&] { ++fired; });
+    EXPECT_TRUE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(a));
+    wheel.advance(t0 + 1s);
+    EXPECT_EQ(fired, 1);
+    // Ids of fired timers stay dead even after their node is reused
+    EXPECT_FALSE(wheel.cancel(b));
+    auto c = wheel.schedule(10ms, [&] { ++fired; });
+    EXPECT_FALSE(wheel.cancel(b));
+    EXPECT_TRUE(wheel.cancel(c));
+}
+
+TEST(TimerWheel, CascadesLongDelays) {
+    // Spread over every level, including beyond the wheel's span
+    TimerWheel wheel(1ms);
+    auto t0 = TimerWheel::Clock::now();
+    std::vector<std::chrono::milliseconds> delays = {
+        5ms, 60ms, 70ms, 4090ms, 4200ms, 300000ms, 20000000ms};
+    std::vector<int> fired(delays.size(), 0);
+    for (size_t i = 0; i < delays.size(); ++i) {
+        wheel.schedule(delays[i], [&fired, i] { ++fired[i]; });
+    }
+    for (size_t i = 0; i < delays.size(); ++i) {
+        // Scheduling rounds to ticks, so allow for the tick in progress
+        wheel.advance(t0 + delays[i] - 2ms);
+        EXPECT_EQ(fired[i], 0) << i;
+        wheel.advance(t0 + delays[i] + 2ms);
+        EXPECT_EQ(fired[i], 1) << i;
+    }
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+TEST(TimerWheel, DriverThreadFiresAndCallbacksMayReschedule) {
+    TimerWheel wheel(1ms);
+    wheel.start();
+    std::atomic<int> fired{0};
+    std::function<void()> again = [&] {
+        if (++fired < 3) wheel.schedule(5ms, again);
+    };
+    wheel.schedule(5ms, again);
+    for (int i = 0; i < 200 && fired < 3; ++i) std::this_thread::sleep_for(5ms);
+    EXPECT_EQ(fired.load(), 3);
+    wheel.stop();
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "mcp/tool_args.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace mcp;
+
+namespace {
+
+struct Point {
+    int x = 0;
+    int y = 0;
+};
+MCPXX_ARGS(Point, x, y)
+
+struct SearchArgs {
+    std::string query;
+    std::optional<uint32_t> limit;
+    std::vector<std::string> tags;
+    std::optional<Point> near;
+    bool exact = false;
+    double boost = 1.0;
+    nlohmann::json extra;
+};
+MCPXX_ARGS(SearchArgs, query, limit, tags, near, exact, boost, extra)
+
+std::string bind_error(std::string_view json) {
+    try {
+        (void)parse_args<SearchArgs>(json);
+    } catch (const McpProtocolError& e) {
+        EXPECT_EQ(e.code, error::InvalidParams);
+        return e.what();
+    }
+    return "";
+}
+
+} // namespace
+
+TEST(ToolArgs, BindsEveryMemberKind) {
+    auto args = parse_args<SearchArgs>(
+        R"({"query":"café","limit":10,"tags":["a","b"],"near":{"y":2,"x":-1},)"
+        R"("exact":true,"boost":2.5,"extra":{"k":[1,null]},"unknown":{"skipped":1}})");
+    EXPECT_EQ(args.query, "caf\xc3\xa9");
+    EXPECT_EQ(args.limit, 10u);
+    EXPECT_EQ(args.tags, (std::vector<std::string>{"a", "b"}));
+    ASSERT_TRUE(args.near.has_value());
+    EXPECT_EQ(args.near->x, -1);
+    EXPECT_EQ(args.near->y, 2);
+    EXPECT_TRUE(args.exact);
+    EXPECT_DOUBLE_EQ(args.boost, 2.5);
+    EXPECT_EQ(args.extra, (nlohmann::json{{"k", {1, nullptr}}}));
+}
+
+TEST(ToolArgs, OptionalMembersMayBeAbsentOrNull) {
+    auto args = parse_args<SearchArgs>(
+        R"({"query":"q","limit":null,"tags":[],"exact":false,"boost":1,"extra":null})");
+    EXPECT_FALSE(args.limit.has_value());
+    EXPECT_FALSE(args.near.has_value());
+    EXPECT_TRUE(args.extra.is_null());
+}
+
+TEST(ToolArgs, ErrorsNameTheMember) {
+    const std::string base = R"("tags":[],"exact":true,"boost":1,"extra":0)";
+    EXPECT_EQ(bind_error("{" + base + "}"), "Invalid argument 'query': required");
+    EXPECT_EQ(bind_error(R"({"query":1,)" + base + "}"), "Invalid argument 'query': expected string");
+    EXPECT_EQ(bind_error(R"({"query":"q","limit":-1,)" + base + "}"),
+              "Invalid argument 'limit': expected non-negative integer");
+    EXPECT_EQ(bind_error(R"({"query":"q","limit":5000000000,)" + base + "}"),
+              "Invalid argument 'limit': out of range");
+    EXPECT_EQ(bind_error(R"({"query":"q","near":{"x":1.5,"y":0},)" + base + "}"),
+              "Invalid argument 'near.x': expected integer");
+    EXPECT_EQ(bind_error(R"({"query":"q","near":{"x":1},)" + base + "}"),
+              "Invalid argument 'near.y': required");
+    EXPECT_EQ(bind_error(R"({"query":"q","tags":["a",2],"exact":true,"boost":1,"extra":0})"),
+              "Invalid argument 'tags[1]': expected string");
+    EXPECT_EQ(bind_error("[]"), "expected object");
+    EXPECT_THROW((void)parse_args<SearchArgs>(R"({"query":"q",)"), McpParseError);
+}
+
+TEST(ToolArgs, GeneratesInputSchema) {
+    auto schema = args_schema<SearchArgs>();
+    EXPECT_EQ(schema["type"], "object");
+    EXPECT_EQ(schema["properties"]["query"], (nlohmann::json{{"type", "string"}}));
+    EXPECT_EQ(schema["properties"]["limit"], (nlohmann::json{{"type", "integer"}}));
+    EXPECT_EQ(schema["properties"]["tags"],
+              (nlohmann::json{{"type", "array"}, {"items", {{"type", "string"}}}}));
+    EXPECT_EQ(schema["properties"]["near"]["required"], (nlohmann::json{"x", "y"}));
+    EXPECT_EQ(schema["properties"]["exact"], (nlohmann::json{{"type", "boolean"}}));
+    EXPECT_EQ(schema["properties"]["boost"], (nlohmann::json{{"type", "number"}}));
+    EXPECT_EQ(schema["properties"]["extra"], nlohmann::json::object());
+    EXPECT_EQ(schema["required"], (nlohmann::json{"query", "tags", "exact", "boost", "extra"}));
+}
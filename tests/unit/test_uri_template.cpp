@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "mcp/uri_template.hpp"
+#include <stdexcept>
+#include <string>
+
+using namespace mcp;
+
+TEST(UriTemplate, SimpleVariables) {
+    UriTemplateMatcher m;
+    m.add("db://{tenant}/tables/{table}", 7);
+    UriTemplateVars vars;
+    ASSERT_EQ(m.match("db://acme/tables/users", &vars), 7u);
+    EXPECT_EQ(vars.at("tenant"), "acme");
+    EXPECT_EQ(vars.at("table"), "users");
+
+    // {var} stops at '/', and a variable is never empty
+    EXPECT_FALSE(m.match("db://acme/x/tables/users").has_value());
+    EXPECT_FALSE(m.match("db:///tables/users").has_value());
+    EXPECT_FALSE(m.match("db://acme/tables/users/extra").has_value());
+}
+
+TEST(UriTemplate, ReservedAndFragmentExpansion) {
+    UriTemplateMatcher m;
+    m.add("file:///{+path}", 1);
+    m.add("doc://{name}{#section}", 2);
+    UriTemplateVars vars;
+    ASSERT_EQ(m.match("file:///a/b/c.txt", &vars), 1u);
+    EXPECT_EQ(vars.at("path"), "a/b/c.txt");
+
+    ASSERT_EQ(m.match("doc://intro#usage/flags", &vars), 2u);
+    EXPECT_EQ(vars.at("name"), "intro");
+    EXPECT_EQ(vars.at("section"), "usage/flags");
+    EXPECT_FALSE(m.match("doc://intro").has_value());
+}
+
+TEST(UriTemplate, VariablesBackOffForTrailingLiterals) {
+    UriTemplateMatcher m;
+    m.add("file:///{+dir}/{name}.txt", 3);
+    UriTemplateVars vars;
+    ASSERT_EQ(m.match("file:///a/b/notes.v2.txt", &vars), 3u);
+    EXPECT_EQ(vars.at("dir"), "a/b");
+    EXPECT_EQ(vars.at("name"), "notes.v2");
+}
+
+TEST(UriTemplate, LiteralBeatsVariable) {
+    // A prefix match would have picked whichever came first
+    UriTemplateMatcher m;
+    m.add("res://{kind}/{id}", 1);
+    m.add("res://users/{id}", 2);
+    m.add("res://users/me", 3);
+    EXPECT_EQ(m.match("res://users/me"), 3u);
+    EXPECT_EQ(m.match("res://users/42"), 2u);
+    EXPECT_EQ(m.match("res://groups/42"), 1u);
+    EXPECT_EQ(m.size(), 3u);
+
+    m.add("res://users/me", 4);  // same template, new id
+    EXPECT_EQ(m.match("res://users/me"), 4u);
+    EXPECT_EQ(m.size(), 3u);
+}
+
+TEST(UriTemplate, DecodesPercentEncodedValues) {
+    UriTemplateMatcher m;
+    m.add("search://{query}", 0);
+    UriTemplateVars vars;
+    ASSERT_TRUE(m.match("search://hello%20world", &vars).has_value());
+    EXPECT_EQ(vars.at("query"), "hello world");
+}
+
+TEST(UriTemplate, RejectsMalformedTemplates) {
+    EXPECT_THROW(UriTemplateMatcher::validate("file:///{path"), std::invalid_argument);
+    EXPECT_THROW(UriTemplateMatcher::validate("file:///path}"), std::invalid_argument);
+    EXPECT_THROW(UriTemplateMatcher::validate("file:///{}"), std::invalid_argument);
+    EXPECT_THROW(UriTemplateMatcher::validate("file:///{/path}"), std::invalid_argument);  // level 3
+    EXPECT_THROW(UriTemplateMatcher::validate("file:///{path*}"), std::invalid_argument);  // level 4
+    EXPECT_NO_THROW(UriTemplateMatcher::validate("file:///{+path}{#frag}"));
+
+    UriTemplateMatcher m;
+    EXPECT_THROW(m.add("x://{a", 0), std::invalid_argument);
+    EXPECT_EQ(m.size(), 0u);
+}
+
+TEST(UriTemplate, ManyTemplatesShareOneTrie) {
+    UriTemplateMatcher m;
+    for (size_t i = 0; i < 5000; ++i) {
+        m.add("db://tenant-" + std::to_string(i) + "/{table}", i);
+    }
+    UriTemplateVars vars;
+    ASSERT_EQ(m.match("db://tenant-4321/orders", &vars), 4321u);
+    EXPECT_EQ(vars.at("table"), "orders");
+    EXPECT_FALSE(m.match("db://tenant-5000/orders").has_value());
+}